@@ -257,6 +257,8 @@ extern te_errno ta_unix_conf_sys_tree_fini(void);
 extern te_errno ta_unix_conf_if_phy_init(void);
 extern te_errno ta_unix_conf_if_coalesce_init(void);
 extern te_errno ta_unix_conf_if_flow_ctrl_init(void);
+extern te_errno ta_unix_conf_if_sampler_init(void);
+extern void ta_unix_conf_if_sampler_cleanup(void);
 extern te_errno ta_unix_conf_if_rss_init(void);
 extern te_errno ta_unix_conf_if_rx_rules_init(void);
 extern te_errno ta_unix_conf_eth_init(void);
@@ -1228,6 +1230,131 @@ ta_unix_conf_base_init(void)
     return rcf_pch_add_node("/agent", &node_xen);
 }
 
+#ifdef USE_LIBNETCONF
+/** Interfaces changed by netlink events and not recorded yet */
+static char (*netconf_changed_ifs)[IF_NAMESIZE] = NULL;
+/** Number of interfaces in netconf_changed_ifs */
+static unsigned int netconf_n_changed_ifs = 0;
+/** Number of allocated entries in netconf_changed_ifs */
+static unsigned int netconf_max_changed_ifs = 0;
+/** Netlink events are lost, so it is not known what is changed */
+static te_bool netconf_changes_lost = FALSE;
+
+/**
+ * Remember an interface whose links, addresses or neighbours are changed
+ * according to a netlink event, so that Configurator notices changes
+ * made by other processes (e.g. RPC servers) in incremental
+ * synchronization.
+ *
+ * @param node          Decoded event or @c NULL if events are lost
+ * @param del           Whether the entity is removed
+ * @param user_data     Unused
+ */
+static void
+netconf_event_cb(const netconf_node *node, bool del, void *user_data)
+{
+    char            buf[IF_NAMESIZE];
+    const char     *ifname = NULL;
+    int             ifindex;
+    unsigned int    i;
+
+    UNUSED(user_data);
+
+    if (node == NULL)
+    {
+        netconf_changes_lost = TRUE;
+        return;
+    }
+
+    switch (node->type)
+    {
+        case NETCONF_NODE_LINK:
+            ifname = node->data.link.ifname;
+            ifindex = node->data.link.ifindex;
+            break;
+
+        case NETCONF_NODE_NET_ADDR:
+            ifindex = node->data.net_addr.ifindex;
+            break;
+
+        case NETCONF_NODE_NEIGH:
+            ifindex = node->data.neigh.ifindex;
+            break;
+
+        default:
+            return;
+    }
+
+    if (ifname == NULL)
+    {
+        ifname = if_indextoname(ifindex, buf);
+        if (ifname == NULL)
+        {
+            /*
+             * Removal of the interface itself is reported with its
+             * name by RTM_DELLINK.
+             */
+            if (!del)
+                netconf_changes_lost = TRUE;
+            return;
+        }
+    }
+
+    for (i = 0; i < netconf_n_changed_ifs; i++)
+    {
+        if (strcmp(netconf_changed_ifs[i], ifname) == 0)
+            return;
+    }
+
+    if (netconf_n_changed_ifs == netconf_max_changed_ifs)
+    {
+        unsigned int    max = MAX(netconf_max_changed_ifs * 2, 16);
+        void           *ifs;
+
+        ifs = realloc(netconf_changed_ifs,
+                      max * sizeof(*netconf_changed_ifs));
+        if (ifs == NULL)
+        {
+            netconf_changes_lost = TRUE;
+            return;
+        }
+        netconf_changed_ifs = ifs;
+        netconf_max_changed_ifs = max;
+    }
+
+    te_strlcpy(netconf_changed_ifs[netconf_n_changed_ifs++], ifname,
+               IF_NAMESIZE);
+}
+
+/**
+ * Read pending netlink events and record interfaces changed by them
+ * in the journal of configuration changes.
+ */
+static void
+netconf_flush_changes(void)
+{
+    char            oid[RCF_MAX_ID];
+    unsigned int    i;
+
+    if (netconf_cache_update(nh) != 0)
+        netconf_changes_lost = TRUE;
+
+    if (netconf_changes_lost)
+    {
+        rcf_pch_conf_changed(NULL);
+        netconf_changes_lost = FALSE;
+    }
+
+    for (i = 0; i < netconf_n_changed_ifs; i++)
+    {
+        TE_SPRINTF(oid, "/agent:%s/interface:%s", rcf_ch_conf_agent(),
+                   netconf_changed_ifs[i]);
+        rcf_pch_conf_changed(oid);
+    }
+    netconf_n_changed_ifs = 0;
+}
+#endif
+
 /* See the description in lib/rcfpch/rcf_ch_api.h */
 int
 rcf_ch_conf_init(void)
@@ -1242,6 +1369,26 @@ rcf_ch_conf_init(void)
             ERROR("Failed to open netconf session");
             return -1;
         }
+        /*
+         * Interfaces, addresses and neighbours are read on almost every
+         * access to corresponding nodes, so keep them in the cache
+         * updated by netlink events rather than dump them each time.
+         */
+        if (netconf_cache_enable(nh) != 0)
+        {
+            WARN("Failed to enable netconf cache: %r",
+                 TE_OS_RC(TE_TA_UNIX, errno));
+        }
+        else if (netconf_cache_set_event_cb(nh, netconf_event_cb,
+                                            NULL) == 0)
+        {
+            /*
+             * Let Configurator notice interfaces, addresses and
+             * neighbours changed by other processes in incremental
+             * synchronization.
+             */
+            rcf_pch_conf_set_flush_changes(netconf_flush_changes);
+        }
 #endif
 
         if ((cfg_socket = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
@@ -1367,6 +1514,9 @@ rcf_ch_conf_init(void)
         if (ta_unix_conf_if_flow_ctrl_init() != 0)
             goto fail;
 
+        if (ta_unix_conf_if_sampler_init() != 0)
+            goto fail;
+
         if (ta_unix_conf_if_rss_init() != 0)
             goto fail;
 
@@ -1387,6 +1537,9 @@ rcf_ch_conf_init(void)
 
         rcf_pch_rsrc_init();
 
+        if (rcf_pch_log_buffer_init() != 0)
+            goto fail;
+
 #ifdef WITH_AGGREGATION
         if (ta_unix_conf_aggr_init() != 0)
         {
@@ -1585,6 +1738,13 @@ rcf_ch_conf_fini(void)
    (void)ta_unix_conf_sys_tree_fini();
 
     ta_unix_conf_cmd_monitor_cleanup();
+    ta_unix_conf_if_sampler_cleanup();
+#ifdef USE_LIBNETCONF
+    rcf_pch_conf_set_flush_changes(NULL);
+    free(netconf_changed_ifs);
+    netconf_changed_ifs = NULL;
+    netconf_n_changed_ifs = netconf_max_changed_ifs = 0;
+#endif
     if (cfg_socket >= 0)
         (void)close(cfg_socket);
     if (cfg6_socket >= 0)
@@ -0,0 +1,576 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Unix Test Agent
+ *
+ * High-frequency sampler of network interface counters.
+ *
+ * Counters of an interface are read via rtnetlink by a dedicated
+ * thread at a configured rate and stored in a ring buffer, so that
+ * burst behaviour which cannot be seen with Configurator round trips
+ * may be analyzed. When the sampler is disabled, collected samples
+ * are written to a file in TA temporary directory which may be fetched
+ * by a test in bulk.
+ */
+
+#define TE_LGR_USER     "Conf Intf Sampler"
+
+#include "te_config.h"
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <net/if.h>
+
+#include "te_errno.h"
+#include "logger_api.h"
+#include "te_defs.h"
+#include "te_queue.h"
+#include "te_str.h"
+#include "rcf_pch.h"
+#include "unix_internal.h"
+
+#if defined(__linux__) && defined(USE_LIBNETCONF)
+
+#include "netconf.h"
+
+/** Default sampling rate, Hz */
+#define IF_SAMPLER_DEF_RATE     1000
+/** Maximum sampling rate, Hz */
+#define IF_SAMPLER_MAX_RATE     100000
+/** Default capacity of the ring buffer, samples */
+#define IF_SAMPLER_DEF_SIZE     65536
+/** Maximum capacity of the ring buffer, samples */
+#define IF_SAMPLER_MAX_SIZE     (16 * 1024 * 1024)
+
+/** Sample of interface counters */
+typedef struct if_sample {
+    uint64_t            ts_ns;  /**< Monotonic timestamp, nanoseconds */
+    netconf_link_stats  stats;  /**< Counters */
+} if_sample;
+
+/** Sampler of an interface */
+typedef struct if_sampler {
+    LIST_ENTRY(if_sampler)  links;  /**< List links */
+
+    char            ifname[IF_NAMESIZE];    /**< Interface name */
+    unsigned int    rate;       /**< Sampling rate, Hz */
+    unsigned int    size;       /**< Capacity of the ring buffer */
+    te_bool         enable;     /**< Whether the sampler is running */
+    char            dump[RCF_MAX_PATH]; /**< File with samples of the
+                                             last run or empty string */
+
+    pthread_t       thread;     /**< Sampling thread */
+    pthread_mutex_t lock;       /**< Protects fields below */
+    te_bool         stop;       /**< Request to stop the thread */
+    if_sample      *ring;       /**< Ring buffer */
+    unsigned int    head;       /**< Index of the next sample */
+    unsigned int    count;      /**< Number of samples in the ring */
+    uint64_t        missed;     /**< Number of missed sampling slots */
+    te_errno        rc;         /**< Status of the sampling thread */
+} if_sampler;
+
+/** List of interface samplers */
+static LIST_HEAD(, if_sampler) samplers = LIST_HEAD_INITIALIZER(samplers);
+
+/** Get monotonic time in nanoseconds */
+static uint64_t
+if_sampler_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return TE_SEC2NS((uint64_t)ts.tv_sec) + ts.tv_nsec;
+}
+
+/**
+ * Sampling thread. It uses its own netconf handle since the handle
+ * of the agent may not be used concurrently.
+ *
+ * @param arg       Sampler
+ *
+ * @return @c NULL
+ */
+static void *
+if_sampler_thread(void *arg)
+{
+    if_sampler         *sampler = arg;
+    netconf_handle      nh = NULL;
+    int                 ifindex;
+    uint64_t            period = TE_SEC2NS(1) / sampler->rate;
+    uint64_t            next;
+    uint64_t            before;
+    uint64_t            after;
+    netconf_link_stats  stats;
+    te_bool             stop = FALSE;
+    te_errno            rc = 0;
+
+    ifindex = if_nametoindex(sampler->ifname);
+    if (ifindex == 0)
+    {
+        rc = TE_OS_RC(TE_TA_UNIX, errno);
+        goto out;
+    }
+
+    if (netconf_open(&nh, NETLINK_ROUTE) != 0)
+    {
+        rc = TE_OS_RC(TE_TA_UNIX, errno);
+        goto out;
+    }
+
+    next = if_sampler_now();
+    while (!stop)
+    {
+        struct timespec ts;
+
+        ts.tv_sec = TE_NS2SEC(next);
+        ts.tv_nsec = next % TE_SEC2NS(1);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                               &ts, NULL) == EINTR)
+            ;
+
+        before = if_sampler_now();
+        rc = netconf_link_get_stats(nh, ifindex, &stats);
+        after = if_sampler_now();
+
+        pthread_mutex_lock(&sampler->lock);
+        if (rc == 0)
+        {
+            if_sample *sample = &sampler->ring[sampler->head];
+
+            /* The middle of the request is the best estimation */
+            sample->ts_ns = before + (after - before) / 2;
+            sample->stats = stats;
+
+            sampler->head = (sampler->head + 1) % sampler->size;
+            if (sampler->count < sampler->size)
+                sampler->count++;
+        }
+        stop = sampler->stop || rc != 0;
+
+        /* Skip slots which have already passed */
+        next += period;
+        if (next <= after)
+        {
+            uint64_t skip = (after - next) / period + 1;
+
+            sampler->missed += skip;
+            next += skip * period;
+        }
+        pthread_mutex_unlock(&sampler->lock);
+    }
+
+out:
+    if (nh != NULL)
+        netconf_close(nh);
+
+    if (rc != 0)
+    {
+        ERROR("Sampling of '%s' counters failed: %r", sampler->ifname, rc);
+        pthread_mutex_lock(&sampler->lock);
+        sampler->rc = rc;
+        pthread_mutex_unlock(&sampler->lock);
+    }
+
+    return NULL;
+}
+
+/**
+ * Write samples of the ring buffer to the file in the order of
+ * sampling.
+ *
+ * @param sampler   Stopped sampler
+ *
+ * @return Status code.
+ */
+static te_errno
+if_sampler_write(if_sampler *sampler)
+{
+    char            path[RCF_MAX_PATH];
+    FILE           *f;
+    unsigned int    first;
+    unsigned int    i;
+    te_errno        rc = 0;
+
+    TE_SPRINTF(path, "%s/if_sampler_%s", ta_tmp_dir, sampler->ifname);
+
+    f = fopen(path, "w");
+    if (f == NULL)
+    {
+        rc = TE_OS_RC(TE_TA_UNIX, errno);
+        ERROR("Cannot create file '%s': %r", path, rc);
+        return rc;
+    }
+
+    fprintf(f, "# rate %u missed %" PRIu64 "\n",
+            sampler->rate, sampler->missed);
+    fprintf(f, "# ts_ns rx_packets tx_packets rx_bytes tx_bytes "
+            "rx_errors tx_errors rx_dropped tx_dropped\n");
+
+    first = (sampler->head + sampler->size - sampler->count) %
+            sampler->size;
+    for (i = 0; i < sampler->count; i++)
+    {
+        const if_sample *s = &sampler->ring[(first + i) % sampler->size];
+
+        fprintf(f, "%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+                " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+                " %" PRIu64 "\n", s->ts_ns,
+                s->stats.rx_packets, s->stats.tx_packets,
+                s->stats.rx_bytes, s->stats.tx_bytes,
+                s->stats.rx_errors, s->stats.tx_errors,
+                s->stats.rx_dropped, s->stats.tx_dropped);
+    }
+
+    if (fclose(f) != 0)
+    {
+        rc = TE_OS_RC(TE_TA_UNIX, errno);
+        ERROR("Failed to write file '%s': %r", path, rc);
+        return rc;
+    }
+
+    te_strlcpy(sampler->dump, path, sizeof(sampler->dump));
+
+    return 0;
+}
+
+/**
+ * Start sampling thread.
+ *
+ * @param sampler   Sampler
+ *
+ * @return Status code.
+ */
+static te_errno
+if_sampler_start(if_sampler *sampler)
+{
+    int rc;
+
+    if (if_nametoindex(sampler->ifname) == 0)
+    {
+        ERROR("Cannot sample counters of unknown interface '%s'",
+              sampler->ifname);
+        return TE_RC(TE_TA_UNIX, TE_ENODEV);
+    }
+
+    sampler->ring = calloc(sampler->size, sizeof(*sampler->ring));
+    if (sampler->ring == NULL)
+        return TE_RC(TE_TA_UNIX, TE_ENOMEM);
+
+    sampler->head = 0;
+    sampler->count = 0;
+    sampler->missed = 0;
+    sampler->stop = FALSE;
+    sampler->rc = 0;
+    sampler->dump[0] = '\0';
+
+    rc = pthread_create(&sampler->thread, NULL, if_sampler_thread,
+                        sampler);
+    if (rc != 0)
+    {
+        ERROR("Cannot start sampling thread for '%s'", sampler->ifname);
+        free(sampler->ring);
+        sampler->ring = NULL;
+        return TE_RC(TE_TA_UNIX, te_rc_os2te(rc));
+    }
+
+    return 0;
+}
+
+/**
+ * Stop sampling thread and write collected samples to the file.
+ *
+ * @param sampler   Sampler
+ *
+ * @return Status code.
+ */
+static te_errno
+if_sampler_stop(if_sampler *sampler)
+{
+    te_errno rc;
+
+    pthread_mutex_lock(&sampler->lock);
+    sampler->stop = TRUE;
+    pthread_mutex_unlock(&sampler->lock);
+
+    rc = pthread_join(sampler->thread, NULL);
+    if (rc != 0)
+    {
+        ERROR("Cannot join sampling thread for '%s'", sampler->ifname);
+        return TE_RC(TE_TA_UNIX, te_rc_os2te(rc));
+    }
+
+    if (sampler->rc != 0)
+        WARN("Sampling of '%s' was interrupted: %r", sampler->ifname,
+             sampler->rc);
+
+    rc = if_sampler_write(sampler);
+
+    free(sampler->ring);
+    sampler->ring = NULL;
+
+    return rc;
+}
+
+/**
+ * Find sampler of an interface.
+ *
+ * @param ifname    Interface name
+ * @param create    Create the sampler with default parameters
+ *                  if it does not exist
+ *
+ * @return Sampler or @c NULL.
+ */
+static if_sampler *
+if_sampler_find(const char *ifname, te_bool create)
+{
+    if_sampler *sampler;
+
+    LIST_FOREACH(sampler, &samplers, links)
+    {
+        if (strcmp(sampler->ifname, ifname) == 0)
+            return sampler;
+    }
+
+    if (!create)
+        return NULL;
+
+    sampler = calloc(1, sizeof(*sampler));
+    if (sampler == NULL)
+        return NULL;
+
+    te_strlcpy(sampler->ifname, ifname, sizeof(sampler->ifname));
+    sampler->rate = IF_SAMPLER_DEF_RATE;
+    sampler->size = IF_SAMPLER_DEF_SIZE;
+    pthread_mutex_init(&sampler->lock, NULL);
+
+    LIST_INSERT_HEAD(&samplers, sampler, links);
+
+    return sampler;
+}
+
+/* Get sampling rate */
+static te_errno
+rate_get(unsigned int gid, const char *oid, char *value,
+         const char *ifname)
+{
+    if_sampler *sampler = if_sampler_find(ifname, FALSE);
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    snprintf(value, RCF_MAX_VAL, "%u",
+             sampler == NULL ? IF_SAMPLER_DEF_RATE : sampler->rate);
+
+    return 0;
+}
+
+/* Set sampling rate */
+static te_errno
+rate_set(unsigned int gid, const char *oid, const char *value,
+         const char *ifname)
+{
+    if_sampler *sampler;
+    uint32_t    rate;
+    te_errno    rc;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    rc = te_strtoui(value, 0, &rate);
+    if (rc != 0)
+        return TE_RC(TE_TA_UNIX, rc);
+    if (rate == 0 || rate > IF_SAMPLER_MAX_RATE)
+    {
+        ERROR("Sampling rate %u is out of range", rate);
+        return TE_RC(TE_TA_UNIX, TE_EINVAL);
+    }
+
+    sampler = if_sampler_find(ifname, TRUE);
+    if (sampler == NULL)
+        return TE_RC(TE_TA_UNIX, TE_ENOMEM);
+    if (sampler->enable)
+        return TE_RC(TE_TA_UNIX, TE_EBUSY);
+
+    sampler->rate = rate;
+
+    return 0;
+}
+
+/* Get capacity of the ring buffer */
+static te_errno
+size_get(unsigned int gid, const char *oid, char *value,
+         const char *ifname)
+{
+    if_sampler *sampler = if_sampler_find(ifname, FALSE);
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    snprintf(value, RCF_MAX_VAL, "%u",
+             sampler == NULL ? IF_SAMPLER_DEF_SIZE : sampler->size);
+
+    return 0;
+}
+
+/* Set capacity of the ring buffer */
+static te_errno
+size_set(unsigned int gid, const char *oid, const char *value,
+         const char *ifname)
+{
+    if_sampler *sampler;
+    uint32_t    size;
+    te_errno    rc;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    rc = te_strtoui(value, 0, &size);
+    if (rc != 0)
+        return TE_RC(TE_TA_UNIX, rc);
+    if (size == 0 || size > IF_SAMPLER_MAX_SIZE)
+    {
+        ERROR("Sampler ring buffer size %u is out of range", size);
+        return TE_RC(TE_TA_UNIX, TE_EINVAL);
+    }
+
+    sampler = if_sampler_find(ifname, TRUE);
+    if (sampler == NULL)
+        return TE_RC(TE_TA_UNIX, TE_ENOMEM);
+    if (sampler->enable)
+        return TE_RC(TE_TA_UNIX, TE_EBUSY);
+
+    sampler->size = size;
+
+    return 0;
+}
+
+/* Get sampler state */
+static te_errno
+enable_get(unsigned int gid, const char *oid, char *value,
+           const char *ifname)
+{
+    if_sampler *sampler = if_sampler_find(ifname, FALSE);
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    snprintf(value, RCF_MAX_VAL, "%d",
+             sampler == NULL ? 0 : sampler->enable);
+
+    return 0;
+}
+
+/* Start or stop the sampler */
+static te_errno
+enable_set(unsigned int gid, const char *oid, const char *value,
+           const char *ifname)
+{
+    if_sampler *sampler;
+    te_bool     enable;
+    te_errno    rc;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    rc = te_strtol_bool(value, &enable);
+    if (rc != 0)
+        return TE_RC(TE_TA_UNIX, rc);
+
+    sampler = if_sampler_find(ifname, TRUE);
+    if (sampler == NULL)
+        return TE_RC(TE_TA_UNIX, TE_ENOMEM);
+    if (sampler->enable == enable)
+        return 0;
+
+    rc = enable ? if_sampler_start(sampler) : if_sampler_stop(sampler);
+    if (rc == 0 || !enable)
+        sampler->enable = enable;
+
+    return rc;
+}
+
+/* Get path to the file with samples of the last run */
+static te_errno
+dump_get(unsigned int gid, const char *oid, char *value,
+         const char *ifname)
+{
+    if_sampler *sampler = if_sampler_find(ifname, FALSE);
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    te_strlcpy(value, sampler == NULL ? "" : sampler->dump, RCF_MAX_VAL);
+
+    return 0;
+}
+
+RCF_PCH_CFG_NODE_RO(node_dump, "dump", NULL, NULL, dump_get);
+
+RCF_PCH_CFG_NODE_RW(node_enable, "enable", NULL, &node_dump,
+                    enable_get, enable_set);
+
+RCF_PCH_CFG_NODE_RW(node_size, "size", NULL, &node_enable,
+                    size_get, size_set);
+
+RCF_PCH_CFG_NODE_RW(node_rate, "rate", NULL, &node_size,
+                    rate_get, rate_set);
+
+RCF_PCH_CFG_NODE_NA(node_sampler, "sampler", &node_rate, NULL);
+
+/**
+ * Add a child node for the counters sampler to the interface object.
+ *
+ * @return Status code.
+ */
+extern te_errno
+ta_unix_conf_if_sampler_init(void)
+{
+    return rcf_pch_add_node("/agent/interface", &node_sampler);
+}
+
+/**
+ * Stop all running samplers and release them.
+ */
+extern void
+ta_unix_conf_if_sampler_cleanup(void)
+{
+    if_sampler *sampler;
+
+    while ((sampler = LIST_FIRST(&samplers)) != NULL)
+    {
+        LIST_REMOVE(sampler, links);
+
+        if (sampler->enable)
+            (void)if_sampler_stop(sampler);
+
+        pthread_mutex_destroy(&sampler->lock);
+        free(sampler);
+    }
+}
+
+#else
+
+/* See description above */
+extern te_errno
+ta_unix_conf_if_sampler_init(void)
+{
+    WARN("Interface counters sampler is not supported");
+
+    return 0;
+}
+
+/* See description above */
+extern void
+ta_unix_conf_if_sampler_cleanup(void)
+{
+}
+#endif
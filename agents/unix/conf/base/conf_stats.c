@@ -35,6 +35,8 @@
 #include "logger_api.h"
 #include "unix_internal.h"
 #include "te_shell_cmd.h"
+#include "te_str.h"
+#include "te_vector.h"
 
 #ifndef IF_NAMESIZE
 #define IF_NAMESIZE IFNAMSIZ
@@ -134,15 +136,47 @@ typedef struct net_stats {
 } net_stats;
 
 
+/** Statistics of an interface in a snapshot of /proc/net/dev */
+typedef struct dev_stats_entry {
+    char        name[IF_NAMESIZE];  /**< Interface name */
+    if_stats    stats;              /**< Interface statistics */
+} dev_stats_entry;
+
+/**
+ * Snapshot of /proc/net/dev.
+ *
+ * Counters requested with the same group identifier are taken from
+ * the same snapshot: the Configurator reads the whole subtree in one
+ * group on synchronization, so the file is parsed once per
+ * synchronization rather than once per counter and interface, while
+ * separate requests always see fresh counters.
+ */
+static struct {
+    te_bool         valid;      /**< Snapshot is taken */
+    unsigned int    gid;        /**< Group the snapshot is taken in */
+    te_vec          entries;    /**< Vector of dev_stats_entry */
+} dev_stats_snapshot = {
+    .valid = FALSE,
+    .entries = TE_VEC_INIT(dev_stats_entry),
+};
+
+/**
+ * Take a snapshot of /proc/net/dev unless it is already taken
+ * in the group.
+ *
+ * @param gid       Group identifier
+ *
+ * @return Status code.
+ */
 static te_errno
-dev_stats_get(const char *devname, if_stats *stats)
+dev_stats_snapshot_update(unsigned int gid)
 {
-    int   rc = 0;
+    te_errno    rc = 0;
 #if __linux__
-    char *buf = NULL;
-    char *ptr = NULL;
-    FILE *devf = NULL;
-    int   line = 0;
+    char       *buf = NULL;
+    char       *ptr = NULL;
+    FILE       *devf = NULL;
+    int         line = 0;
 
     uint64_t in_overruns;
     uint64_t in_frame_losses;
@@ -152,16 +186,13 @@ dev_stats_get(const char *devname, if_stats *stats)
     uint64_t out_compressed;
 #endif
 
-    memset(stats, 0, sizeof(*stats));
+    if (dev_stats_snapshot.valid && dev_stats_snapshot.gid == gid)
+        return 0;
 
-    VERB("dev_stats_get(devname=\"%s\") started", devname);
+    dev_stats_snapshot.valid = FALSE;
+    te_vec_reset(&dev_stats_snapshot.entries);
 
 #if __linux__
-    if ((devname == NULL) || (stats == NULL))
-    {
-        return TE_OS_RC(TE_TA_UNIX, EINVAL);
-    }
-
 #define STATS_NET_DEV_PROC_LINE_LEN 1024
 
     buf = (char *)malloc(STATS_NET_DEV_PROC_LINE_LEN);
@@ -191,26 +222,7 @@ dev_stats_get(const char *devname, if_stats *stats)
         }
     }
 
-    ptr = NULL;
-
     for (;; line++)
-    {
-        if (fgets(buf, STATS_NET_DEV_PROC_LINE_LEN, devf) == NULL)
-            break;
-
-        VERB("/proc/net/dev: line %d: >%s", line, buf);
-
-        if ((ptr = strstr(buf, devname)) != NULL)
-        {
-            if (*(ptr + strlen(devname)) == ':')
-                break;
-            else
-                ptr = NULL;
-        }
-    }
-
-
-    if (ptr != NULL)
     {
 #define STATS_NET_DEV_PARAM_COUNT   15
 
@@ -219,56 +231,125 @@ dev_stats_get(const char *devname, if_stats *stats)
             U64_FMT U64_FMT U64_FMT U64_FMT U64_FMT
             U64_FMT U64_FMT U64_FMT U64_FMT U64_FMT;
 
-        VERB("Found line %d: >%s", line, buf);
-        ptr += strlen(devname) + 1;
-        if ((rc = sscanf(ptr, stats_net_dev_fmt,
-                         &stats->in_octets,
-                         &stats->in_ucast_pkts,
-                         &stats->in_errors,
-                         &stats->in_discards,
-                         &in_overruns,
-                         &in_frame_losses,
-                         &in_compressed,
-                         &stats->in_nucast_pkts,
-                         &stats->out_octets,
-                         &stats->out_ucast_pkts,
-                         &stats->out_errors,
-                         &stats->out_discards,
-                         &out_overruns,
-                         &out_carrier_losses,
-                         &out_compressed)) != STATS_NET_DEV_PARAM_COUNT)
+        dev_stats_entry     entry;
+        if_stats           *stats = &entry.stats;
+        int                 n;
+
+        if (fgets(buf, STATS_NET_DEV_PROC_LINE_LEN, devf) == NULL)
+            break;
+
+        VERB("/proc/net/dev: line %d: >%s", line, buf);
+
+        /* Counters follow the last colon, the name precedes it */
+        if ((ptr = strrchr(buf, ':')) == NULL)
+            continue;
+        *ptr++ = '\0';
+
+        memset(&entry, 0, sizeof(entry));
+        te_strlcpy(entry.name, buf + strspn(buf, " \t"),
+                   sizeof(entry.name));
+
+        if ((n = sscanf(ptr, stats_net_dev_fmt,
+                        &stats->in_octets,
+                        &stats->in_ucast_pkts,
+                        &stats->in_errors,
+                        &stats->in_discards,
+                        &in_overruns,
+                        &in_frame_losses,
+                        &in_compressed,
+                        &stats->in_nucast_pkts,
+                        &stats->out_octets,
+                        &stats->out_ucast_pkts,
+                        &stats->out_errors,
+                        &stats->out_discards,
+                        &out_overruns,
+                        &out_carrier_losses,
+                        &out_compressed)) != STATS_NET_DEV_PARAM_COUNT)
         {
             ERROR("Invalid /proc/net/dev file format, "
                   "only %d of %d counters are parsed",
-                  rc, STATS_NET_DEV_PARAM_COUNT);
-            return TE_OS_RC(TE_TA_UNIX, EINVAL);
+                  n, STATS_NET_DEV_PARAM_COUNT);
+            rc = TE_OS_RC(TE_TA_UNIX, EINVAL);
+            goto cleanup;
         }
 #undef STATS_NET_DEV_PARAM_COUNT
+
+        rc = TE_VEC_APPEND(&dev_stats_snapshot.entries, entry);
+        if (rc != 0)
+            goto cleanup;
     }
 #endif
 
-    rc = 0;
-
+    dev_stats_snapshot.valid = TRUE;
+    dev_stats_snapshot.gid = gid;
 
 #if __linux__
 cleanup:
+    if (rc != 0)
+        te_vec_reset(&dev_stats_snapshot.entries);
+
     if (devf != NULL)
         fclose(devf);
 
-    if (buf != NULL)
-        free(buf);
+    free(buf);
 #endif
 
     return rc;
 }
 
+/**
+ * Get statistics of an interface. Statistics of an interface which
+ * is not found are zero.
+ *
+ * @param gid       Group identifier (see dev_stats_snapshot)
+ * @param devname   Interface name
+ * @param stats     Where to save statistics
+ *
+ * @return Status code.
+ */
+static te_errno
+dev_stats_get(unsigned int gid, const char *devname, if_stats *stats)
+{
+    const dev_stats_entry  *entry;
+    te_errno                rc;
+
+    if ((devname == NULL) || (stats == NULL))
+    {
+        return TE_OS_RC(TE_TA_UNIX, EINVAL);
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    VERB("dev_stats_get(devname=\"%s\") started", devname);
 
+    rc = dev_stats_snapshot_update(gid);
+    if (rc != 0)
+        return rc;
+
+    TE_VEC_FOREACH(&dev_stats_snapshot.entries, entry)
+    {
+        if (strcmp(entry->name, devname) == 0)
+        {
+            *stats = entry->stats;
+            break;
+        }
+    }
+
+    return 0;
+}
 
 
 #define MAX_PROC_NET_SNMP_SIZE  4096
 
+/**
+ * Read network statistics from /proc/net/snmp.
+ *
+ * @param stats     Where to save statistics
+ *
+ * @return Status code.
+ */
 static te_errno
-net_stats_get(net_stats *stats)
+net_stats_read(net_stats *stats)
 {
 #if __linux__
 
@@ -421,12 +502,57 @@ net_stats_get(net_stats *stats)
         return TE_OS_RC(TE_TA_UNIX, EINVAL);
     }
 
+    rc = 0;
+
 cleanup:
 
     free(buf);
 
+    return rc;
+#else
+    return 0;
 #endif
+}
+
+/**
+ * Snapshot of /proc/net/snmp shared by requests of the same group
+ * (see dev_stats_snapshot).
+ */
+static struct {
+    te_bool         valid;      /**< Snapshot is taken */
+    unsigned int    gid;        /**< Group the snapshot is taken in */
+    net_stats       stats;      /**< Network statistics */
+} net_stats_snapshot;
+
+/**
+ * Get network statistics.
+ *
+ * @param gid       Group identifier
+ * @param stats     Where to save statistics
+ *
+ * @return Status code.
+ */
+static te_errno
+net_stats_get(unsigned int gid, net_stats *stats)
+{
+    te_errno rc;
+
+    if (!net_stats_snapshot.valid || net_stats_snapshot.gid != gid)
+    {
+        net_stats_snapshot.valid = FALSE;
+
+        rc = net_stats_read(&net_stats_snapshot.stats);
+        if (rc != 0)
+        {
+            memset(stats, 0, sizeof(*stats));
+            return rc;
+        }
+
+        net_stats_snapshot.valid = TRUE;
+        net_stats_snapshot.gid = gid;
+    }
 
+    *stats = net_stats_snapshot.stats;
     return 0;
 }
 
@@ -439,12 +565,11 @@ static te_errno net_if_stats_##_counter_##_get(unsigned int gid_,       \
     int        rc = 0;                                                  \
     if_stats   stats;                                                   \
                                                                         \
-    UNUSED(gid_);                                                       \
     UNUSED(oid_);                                                       \
                                                                         \
     memset(&stats, 0, sizeof(if_stats));                                \
                                                                         \
-    if ((rc = dev_stats_get((dev_name_), &stats)) != 0)                 \
+    if ((rc = dev_stats_get(gid_, (dev_name_), &stats)) != 0)           \
     {                                                                   \
         ERROR("Cannot get statistics for interface %s", (dev_name_));   \
     }                                                                   \
@@ -482,12 +607,11 @@ net_snmp_ipv4_stats_##_counter_##_get(unsigned int gid_,        \
     int         rc = 0;                                         \
     net_stats   net_stats;                                      \
                                                                 \
-    UNUSED(gid_);                                               \
     UNUSED(oid_);                                               \
                                                                 \
     memset(&net_stats, 0, sizeof(net_stats));                   \
                                                                 \
-    if ((rc = net_stats_get(&net_stats)) != 0)                  \
+    if ((rc = net_stats_get(gid_, &net_stats)) != 0)            \
     {                                                           \
         ERROR("Cannot get network statistics for system");      \
     }                                                           \
@@ -531,12 +655,11 @@ net_snmp_icmp_stats_ ## _counter_ ## _get(unsigned int gid_,    \
     int         rc = 0;                                         \
     net_stats   net_stats;                                      \
                                                                 \
-    UNUSED(gid_);                                               \
     UNUSED(oid_);                                               \
                                                                 \
     memset(&net_stats, 0, sizeof(net_stats));                   \
                                                                 \
-    if ((rc = net_stats_get(&net_stats)) != 0)                  \
+    if ((rc = net_stats_get(gid_, &net_stats)) != 0)            \
     {                                                           \
         ERROR("Cannot get network statistics for system");      \
     }                                                           \
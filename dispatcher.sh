@@ -93,6 +93,10 @@ Generic options:
 
   --cs-print-trees              Print configurator trees.
   --cs-log-diff                 Log backup diff unconditionally.
+  --cs-delta-sync               Synchronize only subtrees changed on agents
+                                (unsafe if configuration is changed
+                                bypassing configure commands in a way
+                                not reported by agents).
 
   --builder-debug               Be more verbose when build
 
@@ -123,6 +127,9 @@ Generic options:
                                 requirements passed in command line. This
                                 may not work well if your prologues can add
                                 requirements on their own in /local:/reqs:.
+  --tester-zygote               Start test executables marked with 'zygote'
+                                attribute once as test servers forking
+                                a process per iteration.
   --tester-req=<reqs-expr>      Requirements to be tested (logical expression).
   --tester-no-reqs              Ignore requirements, run all possible
                                 iterations.
@@ -189,6 +196,8 @@ Generic options:
   --logger-foreground           Run Logger in the foreground (useful for Logger debugging).
   --logger-no-rcf               Run Logger without interaction with RCF, i.e. without polling any
                                 Test Agents (useful for Logger debugging).
+  --logger-no-ta-stream         Poll Test Agents for log instead of asking them to push log
+                                to Logger over a dedicated connection.
   --logger-check                Check that log messages received from other TE components are
                                 properly formatted before storing them in the raw log file.
   --logger-listener=<confstr>   Enable streaming live results to the specified listener.
@@ -198,6 +207,11 @@ Generic options:
   --logger-max-size=<size>      Maximum size of RAW log (4Gb by default;
                                 negative for unlimited; may be specified in
                                 units of G[igabytes]).
+  --logger-flush-interval=<msec> Maximum time a log message may be kept in memory before it is
+                                stored in the RAW log (100 ms by default; 0 to store messages
+                                as soon as possible).
+  --logger-batch-size=<bytes>   Size of a batch of log messages stored in the RAW log at once
+                                without waiting for the flush interval (256 KiB by default).
 
   --trc-log=<filename>          Generate bzip2-ed TRC log
   --trc-db=<filename>           TRC database to be used
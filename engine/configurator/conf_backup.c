@@ -9,6 +9,7 @@
 
 #include "conf_defs.h"
 #include "te_alloc.h"
+#include "te_stopwatch.h"
 
 /**
  * Parses all object dependencies in the configuration file.
@@ -636,73 +637,6 @@ add_or_set(cfg_instance *inst, te_bool local, te_bool *has_deps,
 }
 
 
-static cfg_instance *
-topo_sort_instances_rec(cfg_instance *list, unsigned length)
-{
-    cfg_instance *first;
-    cfg_instance *second;
-    cfg_instance *result = NULL;
-    cfg_instance *prev   = NULL;
-    cfg_instance *chosen = NULL;
-    unsigned      i;
-
-    if (length <= 1)
-        return list;
-
-    first = list;
-    for (i = 1; i < length / 2; i++)
-        list = list->bkp_next;
-    second = list->bkp_next;
-    list->bkp_next = NULL;
-
-    first = topo_sort_instances_rec(first, length / 2);
-    second = topo_sort_instances_rec(second, length - (length / 2));
-
-    while (first != NULL && second != NULL)
-    {
-        chosen = (first->obj->ordinal_number < second->obj->ordinal_number ?
-                  first : second);
-
-        if (chosen == first)
-            first = first->bkp_next;
-        else
-            second = second->bkp_next;
-
-        if (prev != NULL)
-            prev->bkp_next = chosen;
-        else
-            result        = chosen;
-        prev              = chosen;
-    }
-    chosen = (first != NULL ? first : second);
-    if (prev != NULL)
-        prev->bkp_next = chosen;
-    else
-        result        = chosen;
-    return result;
-}
-
-static cfg_instance *
-topo_sort_instances(cfg_instance *list, unsigned int list_size)
-{
-    cfg_instance *tmp;
-    int           seq    = -1;
-
-    list = topo_sort_instances_rec(list, list_size);
-
-    for (tmp = list; tmp != NULL; tmp = tmp->bkp_next)
-    {
-        if ((int)tmp->obj->ordinal_number < seq)
-        {
-            ERROR("Dependency order is broken for %s (%u <= %d)",
-                  tmp->oid, tmp->obj->ordinal_number, seq);
-        }
-        seq = tmp->obj->ordinal_number;
-    }
-
-    return list;
-}
-
 /**
  * Helper function used in restore_entry().
  *
@@ -744,13 +678,12 @@ restore_entry_aux(cfg_instance *inst, te_bool local,
             return rc;
     }
 
-    if (!local)
+    if (!local || (!inst->obj->unit && !inst->obj->unit_part))
         return 0;
 
     /*
-     * local=TRUE is used for instances of "unit" objects; all their
-     * children should be updated and then all the changes should be
-     * committed at once.
+     * All children of instances of "unit" objects should be updated
+     * and then all the changes should be committed at once.
      */
     for (child = inst->son; child != NULL; child = child->brother)
     {
@@ -982,6 +915,172 @@ finish:
     return rc;
 }
 
+/** Context of restoring entries according to the plan */
+typedef struct restore_entries_ctx {
+    te_bool *need_retry;    /**< Another attempt is needed */
+    te_bool *change_made;   /**< Some change was made */
+    te_bool *has_deps;      /**< Changes in other instances may happen */
+} restore_entries_ctx;
+
+/**
+ * Restore instances of a Test Agent branch of a wave by local changes
+ * and collect changed instances to be committed.
+ *
+ * @param branch        Branch of the wave
+ * @param req           Commit request to fill
+ * @param ctx           Context of restoring
+ *
+ * @return Status code.
+ */
+static te_errno
+restore_branch_local(const cfg_restore_branch *branch,
+                     cfg_ta_commit_req *req, restore_entries_ctx *ctx)
+{
+    unsigned int i;
+    te_errno     rc;
+
+    req->insts = TE_ALLOC(sizeof(*req->insts) * (branch->n_insts + 1));
+    if (req->insts == NULL)
+        return TE_ENOMEM;
+
+    for (i = 0; i < branch->n_insts; i++)
+    {
+        cfg_instance   *inst = branch->insts[i];
+        te_bool         change_made = FALSE;
+        cfg_handle      handle;
+
+        if (inst->added || inst->obj->unit_part)
+            continue;
+
+        VERB("Restoring instance %s", inst->oid);
+
+        rc = restore_entry_aux(inst, TRUE, ctx->need_retry, &change_made,
+                               ctx->has_deps);
+        if (rc != 0)
+            return rc;
+        if (!change_made)
+            continue;
+
+        *ctx->change_made = TRUE;
+
+        rc = cfg_db_find(inst->oid, &handle);
+        if (rc != 0)
+        {
+            ERROR("Failed to find locally restored instance %s: %r",
+                  inst->oid, rc);
+            return rc;
+        }
+        req->insts[req->n_insts++] = CFG_GET_INST(handle);
+    }
+
+    return 0;
+}
+
+/**
+ * Restore instances of a wave (callback for cfg_restore_plan_run()).
+ *
+ * Instances out of Test Agent subtrees are restored one by one.
+ * Instances of each Test Agent are changed locally, then changes of
+ * all Test Agents are committed concurrently, one batch per Test Agent.
+ *
+ * @param branches      Branches of the wave
+ * @param n_branches    Number of branches
+ * @param opaque        Context of restoring
+ *
+ * @return Status code.
+ */
+static te_errno
+restore_wave(cfg_restore_branch *branches, unsigned int n_branches,
+             void *opaque)
+{
+    restore_entries_ctx    *ctx = opaque;
+    cfg_ta_commit_req      *reqs;
+    cfg_restore_branch    **req_branches;
+    unsigned int            n_reqs = 0;
+    unsigned int            i;
+    unsigned int            j;
+    te_errno                rc = 0;
+
+    reqs = TE_ALLOC(sizeof(*reqs) * (n_branches + 1));
+    req_branches = TE_ALLOC(sizeof(*req_branches) * (n_branches + 1));
+    if (reqs == NULL || req_branches == NULL)
+    {
+        free(reqs);
+        free(req_branches);
+        return TE_ENOMEM;
+    }
+
+    /*
+     * Non-local commands are not allowed in a local commands sequence,
+     * so other subtrees are restored before Test Agents.
+     */
+    for (i = 0; i < n_branches && rc == 0; i++)
+    {
+        cfg_restore_branch *branch = &branches[i];
+        te_stopwatch_t      stopwatch = TE_STOPWATCH_INIT;
+        struct timeval      lap = { 0, 0 };
+
+        if (strcmp_start(CFG_TA_PREFIX, branch->insts[0]->oid) == 0)
+            continue;
+
+        (void)te_stopwatch_start(&stopwatch);
+        for (j = 0; j < branch->n_insts && rc == 0; j++)
+        {
+            cfg_instance *inst = branch->insts[j];
+
+            if (inst->added || inst->obj->unit_part)
+                continue;
+
+            VERB("Restoring instance %s", inst->oid);
+
+            rc = restore_entry(inst, ctx->need_retry, ctx->change_made,
+                               ctx->has_deps);
+        }
+        (void)te_stopwatch_stop(&stopwatch, &lap);
+        branch->time_us += TE_SEC2US(lap.tv_sec) + lap.tv_usec;
+    }
+
+    for (i = 0; i < n_branches && rc == 0; i++)
+    {
+        cfg_restore_branch *branch = &branches[i];
+
+        if (strcmp_start(CFG_TA_PREFIX, branch->insts[0]->oid) != 0)
+            continue;
+
+        /* Branch name is the top-level subtree without leading '/' */
+        reqs[n_reqs].ta = branch->name + strlen(CFG_TA_PREFIX) - 1;
+        req_branches[n_reqs] = branch;
+        rc = restore_branch_local(branch, &reqs[n_reqs], ctx);
+        if (rc == 0 && reqs[n_reqs].n_insts == 0)
+        {
+            free(reqs[n_reqs].insts);
+            reqs[n_reqs].insts = NULL;
+            continue;
+        }
+        n_reqs++;
+    }
+
+    if (rc == 0 && n_reqs > 0)
+    {
+        rc = cfg_tas_commit_concurrently(reqs, n_reqs);
+        for (i = 0; i < n_reqs; i++)
+            req_branches[i]->time_us += reqs[i].time_us;
+    }
+
+    /*
+     * The sequence may be started by a local command which failed
+     * or changed nothing.
+     */
+    cfg_ta_local_cmd_seq_end(rc);
+
+    for (i = 0; i < n_reqs; i++)
+        free(reqs[i].insts);
+    free(reqs);
+    free(req_branches);
+
+    return rc;
+}
+
 /**
  * Add/update entries, mentioned in the configuration file.
  *
@@ -996,12 +1095,14 @@ static int
 restore_entries(cfg_instance *list, unsigned int list_size,
                 const te_vec *subtrees)
 {
-    int           rc;
-    te_bool       change_made = FALSE;
-    int           n_iterations    = 0;
-    te_bool       need_retry      = FALSE;
-    cfg_instance *iter;
-    te_bool       deps_might_fire = TRUE;
+    int                  rc;
+    te_bool              change_made = FALSE;
+    int                  n_iterations    = 0;
+    te_bool              need_retry      = FALSE;
+    te_bool              deps_might_fire = TRUE;
+    cfg_restore_plan    *plan = NULL;
+    restore_entries_ctx  ctx = { &need_retry, &change_made,
+                                 &deps_might_fire };
 
     /*
      * Lists of children are not filled for instances read from a backup
@@ -1014,7 +1115,16 @@ restore_entries(cfg_instance *list, unsigned int list_size,
     if (rc != 0)
         return rc;
 
-    list = topo_sort_instances(list, list_size);
+    /*
+     * Order instances so that each one is restored after its father
+     * and instances it depends on.
+     */
+    rc = cfg_restore_plan_build(&list, list_size, &plan);
+    if (rc != 0)
+    {
+        ERROR("Failed to plan restoring of entries: %r", rc);
+        return rc;
+    }
 
     while (deps_might_fire)
     {
@@ -1022,6 +1132,7 @@ restore_entries(cfg_instance *list, unsigned int list_size,
         if ((rc = remove_excessive(list, &deps_might_fire, subtrees)) != 0)
         {
             ERROR("Failed to remove excessive entries");
+            cfg_restore_plan_free(plan);
             free_instances(list);
             return rc;
         }
@@ -1030,26 +1141,18 @@ restore_entries(cfg_instance *list, unsigned int list_size,
         {
             change_made = FALSE;
             need_retry  = FALSE;
-            for (iter = list; iter != NULL; iter = iter->bkp_next)
+            rc = cfg_restore_plan_run(plan, restore_wave, &ctx);
+            if (rc != 0)
             {
-                if (iter->added || iter->obj->unit_part)
-                    continue;
-
-                VERB("Restoring instance %s", iter->oid);
-
-                rc = restore_entry(iter, &need_retry, &change_made,
-                                   &deps_might_fire);
-                if (rc != 0)
-                {
-                    free_instances(list);
-                    return rc;
-                }
+                cfg_restore_plan_free(plan);
+                free_instances(list);
+                return rc;
             }
-
         } while (change_made && need_retry);
 
         if (need_retry)
         {
+            cfg_restore_plan_free(plan);
             free_instances(list);
             return TE_ENOENT;
         }
@@ -1063,6 +1166,8 @@ restore_entries(cfg_instance *list, unsigned int list_size,
         }
     }
 
+    cfg_restore_plan_report(plan);
+    cfg_restore_plan_free(plan);
     free_instances(list);
 
     return 0;
@@ -1112,6 +1217,86 @@ cfg_backup_process_file(xmlNodePtr node, te_bool restore,
     return restore_entries(list, list_size, subtrees);
 }
 
+/** Context of building a list of instances from a snapshot */
+typedef struct snapshot_list_ctx {
+    cfg_instance   *list;   /**< Head of the list */
+    cfg_instance   *last;   /**< Last instance in the list */
+    unsigned int    size;   /**< Number of instances in the list */
+} snapshot_list_ctx;
+
+/**
+ * Append an instance of a snapshot to the list of instances
+ * to be restored (callback for cfg_snapshot_foreach_inst()).
+ */
+static te_errno
+snapshot_list_add(const char *oid, const char *val_str, void *opaque)
+{
+    snapshot_list_ctx  *ctx = opaque;
+    cfg_instance       *tmp;
+    te_errno            rc;
+
+    if ((tmp = (cfg_instance *)calloc(sizeof(*tmp), 1)) == NULL)
+        return TE_ENOMEM;
+
+    if ((tmp->oid = strdup(oid)) == NULL)
+    {
+        free(tmp);
+        return TE_ENOMEM;
+    }
+
+    if ((tmp->obj = cfg_get_object(oid)) == NULL)
+    {
+        ERROR("Cannot find the object for instance %s", oid);
+        free(tmp->oid);
+        free(tmp);
+        return TE_EINVAL;
+    }
+
+    if (cfg_db_find(oid, &(tmp->handle)) != 0)
+        tmp->handle = CFG_HANDLE_INVALID;
+
+    if (tmp->obj->type != CVT_NONE &&
+        (rc = cfg_types[tmp->obj->type].str2val((char *)val_str,
+                                                 &(tmp->val))) != 0)
+    {
+        ERROR("Value conversion error for %s", oid);
+        free(tmp->oid);
+        free(tmp);
+        return rc;
+    }
+
+    if (ctx->last != NULL)
+        ctx->last->bkp_next = tmp;
+    else
+        ctx->list = tmp;
+
+    ctx->last = tmp;
+    ctx->size++;
+
+    return 0;
+}
+
+/* See description in conf_backup.h */
+te_errno
+cfg_backup_restore_snapshot(const cfg_snapshot *snapshot,
+                            const te_vec *subtrees)
+{
+    snapshot_list_ctx   ctx = { NULL, NULL, 0 };
+    te_errno            rc;
+
+    RING("Restoring configuration from backup snapshot");
+
+    rc = cfg_snapshot_foreach_inst(snapshot, subtrees,
+                                   snapshot_list_add, &ctx);
+    if (rc != 0)
+    {
+        free_instances(ctx.list);
+        return rc;
+    }
+
+    return restore_entries(ctx.list, ctx.size, subtrees);
+}
+
 /**
  * Save current version of the TA subtree,
  * synchronize DB with TA and restore TA configuration.
@@ -30,6 +30,19 @@ extern "C" {
 extern int cfg_backup_process_file(xmlNodePtr node, te_bool restore,
                                    const te_vec *subtrees);
 
+/**
+ * Restore configuration from a snapshot taken with a backup
+ * instead of processing the backup file.
+ *
+ * @param snapshot Snapshot of the whole database
+ * @param subtrees Vector of the subtrees to restore. May be @c NULL for
+ *                 the root.
+ *
+ * @return Status code.
+ */
+extern te_errno cfg_backup_restore_snapshot(const cfg_snapshot *snapshot,
+                                            const te_vec *subtrees);
+
 /**
  * Save current version of the TA subtree,
  * synchronize DB with TA and restore TA configuration.
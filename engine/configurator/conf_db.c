@@ -9,13 +9,59 @@
  */
 
 #include "conf_defs.h"
+
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include "te_alloc.h"
 #include "te_string.h"
+#include "te_dbuf.h"
 
 /* These must not be greater than CFG_HANDLE_MAX_INDEX + 1 */
 #define CFG_OBJ_NUM     64      /**< Number of objects */
 #define CFG_INST_NUM    128     /**< Number of object instances */
 
+/** Number of sons starting from which sons of an instance are indexed */
+#define CFG_INST_INDEX_MIN_SONS     16
+
+/** Number of entries in the cache of found instances (power of 2) */
+#define CFG_DB_FIND_CACHE_SIZE      1024
+
+/** Generation of the database in the memory shared with clients */
+static uint64_t *cfg_db_gen = NULL;
+
+/** Name of the file with generation of the database */
+static char *cfg_db_gen_file = NULL;
+
+/** Maximum number of records in the journal of instance versions */
+#define CFG_DB_JOURNAL_MAX          65536
+
+/** Previous version of an instance kept in the journal */
+typedef struct cfg_db_journal_rec {
+    uint64_t        version;    /**< Version of the change */
+    char           *oid;        /**< Instance identifier */
+    te_bool         existed;    /**< Whether the instance existed before
+                                     the change */
+    cfg_val_type    type;       /**< Type of the previous value */
+    cfg_inst_val    val;        /**< Previous value */
+} cfg_db_journal_rec;
+
+/** Version of the database incremented on each journaled change */
+static uint64_t cfg_db_version = 0;
+
+/** Versions of the database which may be verified */
+static te_vec cfg_db_version_marks = TE_VEC_INIT(uint64_t);
+
+/** Journal of instance versions in order of changes */
+static te_vec cfg_db_journal = TE_VEC_INIT(cfg_db_journal_rec);
+
+/** Minimum version which may be verified using the journal */
+static uint64_t cfg_db_journal_base = 0;
+
 /** Internal Configurator object handles */
 enum cfg_obj_reserved_handles {
     CFG_OBJ_HANDLE_ROOT = 0,
@@ -124,6 +170,14 @@ uint32_t cfg_inst_seq_num = 1;
 /** Delay for configuration changes accommodation */
 uint32_t cfg_conf_delay;
 
+/**
+ * Cache of instances found by OID string. An entry is the handle
+ * of the instance found last by OID string with the same hash. Handles
+ * of deleted instances become invalid and OIDs of new instances are
+ * compared on lookup, so that the cache never needs explicit flushing.
+ */
+static cfg_handle cfg_db_find_cache[CFG_DB_FIND_CACHE_SIZE];
+
 /* Locals */
 static int pattern_match(char *pattern, char *str);
 
@@ -459,6 +513,591 @@ cfg_destroy_deps(cfg_dependency *deps)
     }
 }
 
+/**
+ * Update FNV-1a hash with a string.
+ *
+ * @param hash      Hash value
+ * @param str       String
+ *
+ * @return Updated hash value.
+ */
+static uint32_t
+cfg_db_hash_str(uint32_t hash, const char *str)
+{
+    for (; *str != '\0'; str++)
+        hash = (hash ^ (uint8_t)*str) * 16777619u;
+
+    return hash;
+}
+
+/**
+ * Compute hash of the instance subidentifier and name used
+ * in the index of sons.
+ *
+ * @param subid     Object subidentifier
+ * @param name      Instance name
+ *
+ * @return Hash value.
+ */
+static uint32_t
+cfg_inst_index_hash(const char *subid, const char *name)
+{
+    uint32_t hash = cfg_db_hash_str(2166136261u, subid);
+
+    /* Separator, so that "ab" + "c" and "a" + "bc" differ */
+    hash = (hash ^ ':') * 16777619u;
+
+    return cfg_db_hash_str(hash, name);
+}
+
+/**
+ * Insert a son into the index of its father.
+ *
+ * @param father    Father instance with allocated index
+ * @param son       Son instance
+ */
+static void
+cfg_inst_index_insert(cfg_instance *father, cfg_instance *son)
+{
+    uint32_t bucket = cfg_inst_index_hash(son->obj->subid, son->name) &
+                      (father->sons_index_size - 1);
+
+    son->index_next = father->sons_index[bucket];
+    father->sons_index[bucket] = son;
+}
+
+/**
+ * (Re)build the index of sons of the instance. If memory cannot be
+ * allocated, the old index (or the linear list of sons if there is
+ * no index) is kept: it is slower, but still valid.
+ *
+ * @param father    Father instance
+ * @param size      Number of buckets (power of 2)
+ *
+ * @return @c TRUE if the index is rebuilt.
+ */
+static te_bool
+cfg_inst_index_rebuild(cfg_instance *father, unsigned int size)
+{
+    cfg_instance **index;
+    cfg_instance  *son;
+
+    index = TE_ALLOC(size * sizeof(*index));
+    if (index == NULL)
+        return FALSE;
+
+    free(father->sons_index);
+    father->sons_index = index;
+    father->sons_index_size = size;
+
+    for (son = father->son; son != NULL; son = son->brother)
+        cfg_inst_index_insert(father, son);
+
+    return TRUE;
+}
+
+/*
+ * See description in conf_db.h.
+ *
+ * The index of sons is created when the father gets many sons and
+ * is grown to keep buckets short.
+ */
+void
+cfg_inst_link_son(cfg_instance *father, cfg_instance *son)
+{
+    father->n_sons++;
+
+    if (father->sons_index != NULL)
+    {
+        if (father->n_sons <= father->sons_index_size ||
+            !cfg_inst_index_rebuild(father, father->sons_index_size * 2))
+            cfg_inst_index_insert(father, son);
+    }
+    else if (father->n_sons >= CFG_INST_INDEX_MIN_SONS)
+    {
+        cfg_inst_index_rebuild(father, CFG_INST_INDEX_MIN_SONS * 2);
+    }
+}
+
+/**
+ * Account a son just unlinked from the list of sons of the father.
+ *
+ * @param father    Father instance
+ * @param son       Removed son instance
+ */
+static void
+cfg_inst_unlink_son(cfg_instance *father, cfg_instance *son)
+{
+    cfg_instance **p;
+
+    father->n_sons--;
+
+    if (father->sons_index == NULL)
+        return;
+
+    p = &father->sons_index[cfg_inst_index_hash(son->obj->subid,
+                                                son->name) &
+                            (father->sons_index_size - 1)];
+    while (*p != NULL && *p != son)
+        p = &(*p)->index_next;
+
+    assert(*p != NULL);
+    *p = son->index_next;
+}
+
+/**
+ * Check whether the instance matches subidentifier and name.
+ * Instance which is scheduled for removal after commit never matches:
+ * it does not make sense to perform some operations on a deleted
+ * instance.
+ *
+ * @param inst      Instance
+ * @param subid     Object subidentifier
+ * @param name      Instance name
+ *
+ * @return @c TRUE if the instance matches.
+ */
+static te_bool
+cfg_inst_match(const cfg_instance *inst, const char *subid,
+               const char *name)
+{
+    return !inst->remove && strcmp(inst->obj->subid, subid) == 0 &&
+           strcmp(inst->name, name) == 0;
+}
+
+/**
+ * Find a son of the instance by object subidentifier and name.
+ *
+ * @param father    Father instance
+ * @param subid     Object subidentifier
+ * @param name      Instance name
+ *
+ * @return Son instance or @c NULL.
+ */
+static cfg_instance *
+cfg_inst_find_son(const cfg_instance *father, const char *subid,
+                  const char *name)
+{
+    cfg_instance *son;
+
+    if (father->sons_index == NULL)
+    {
+        for (son = father->son; son != NULL; son = son->brother)
+        {
+            if (cfg_inst_match(son, subid, name))
+                return son;
+        }
+        return NULL;
+    }
+
+    for (son = father->sons_index[cfg_inst_index_hash(subid, name) &
+                                  (father->sons_index_size - 1)];
+         son != NULL; son = son->index_next)
+    {
+        if (cfg_inst_match(son, subid, name))
+            return son;
+    }
+
+    return NULL;
+}
+
+/**
+ * Find an instance by the parsed instance identifier.
+ *
+ * @param oid       Parsed instance identifier
+ * @param len       Number of leading subidentifiers to be looked up
+ * @param n_found   Location for the number of leading subidentifiers
+ *                  for which instances are found (may be @c NULL)
+ * @param last      Location for the last found instance (may be
+ *                  @c NULL)
+ *
+ * @return Instance or @c NULL.
+ */
+static cfg_instance *
+cfg_inst_find_by_oid(const cfg_oid *oid, int len, int *n_found,
+                     cfg_instance **last)
+{
+    const cfg_inst_subid   *ids = (const cfg_inst_subid *)(oid->ids);
+    cfg_instance           *inst = &cfg_inst_root;
+    cfg_instance           *father = NULL;
+    int                     i;
+
+    if (!cfg_inst_match(inst, ids[0].subid, ids[0].name))
+        inst = NULL;
+
+    for (i = 1; i < len && inst != NULL; i++)
+    {
+        father = inst;
+        inst = cfg_inst_find_son(father, ids[i].subid, ids[i].name);
+    }
+
+    if (n_found != NULL)
+        *n_found = inst == NULL ? i - 1 : i;
+    if (last != NULL)
+        *last = inst == NULL ? father : inst;
+
+    return inst;
+}
+
+/**
+ * Check whether the instance or any of its ancestors is scheduled
+ * for removal after commit.
+ *
+ * @param inst      Instance
+ *
+ * @return @c TRUE if the instance is removed.
+ */
+static te_bool
+cfg_inst_removed(const cfg_instance *inst)
+{
+    for (; inst != NULL; inst = inst->father)
+    {
+        if (inst->remove)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Look up the instance in the cache of found instances.
+ *
+ * @param oid_s     Instance identifier
+ * @param slot      Location for the cache entry to be updated
+ *                  on cache miss
+ *
+ * @return Instance or @c NULL on cache miss.
+ */
+static cfg_instance *
+cfg_db_find_cache_lookup(const char *oid_s, cfg_handle **slot)
+{
+    cfg_instance *inst;
+
+    *slot = &cfg_db_find_cache[cfg_db_hash_str(2166136261u, oid_s) &
+                               (CFG_DB_FIND_CACHE_SIZE - 1)];
+
+    inst = CFG_GET_INST(**slot);
+    if (inst == NULL || strcmp(inst->oid, oid_s) != 0 ||
+        cfg_inst_removed(inst))
+        return NULL;
+
+    return inst;
+}
+
+/* See description in conf_db.h */
+te_errno
+cfg_db_gen_init(const char *tmp_dir)
+{
+    te_string   path = TE_STRING_INIT;
+    void       *ptr;
+    int         fd;
+    te_errno    rc;
+
+    te_string_append(&path, "%s/%s" CFG_DB_GEN_FILE_SUFFIX, tmp_dir,
+                     CONFIGURATOR_SERVER);
+
+    fd = open(path.ptr, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        rc = TE_OS_RC(TE_CS, errno);
+        ERROR("Failed to create %s: %r", path.ptr, rc);
+        te_string_free(&path);
+        return rc;
+    }
+
+    if (ftruncate(fd, sizeof(*cfg_db_gen)) != 0)
+    {
+        rc = TE_OS_RC(TE_CS, errno);
+        ERROR("Failed to resize %s: %r", path.ptr, rc);
+        close(fd);
+        unlink(path.ptr);
+        te_string_free(&path);
+        return rc;
+    }
+
+    ptr = mmap(NULL, sizeof(*cfg_db_gen), PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        rc = TE_OS_RC(TE_CS, errno);
+        ERROR("Failed to map %s: %r", path.ptr, rc);
+        unlink(path.ptr);
+        te_string_free(&path);
+        return rc;
+    }
+
+    cfg_db_gen = ptr;
+    cfg_db_gen_file = path.ptr;
+
+    /* Zero generation is never valid for clients */
+    __atomic_store_n(cfg_db_gen, 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/* See description in conf_db.h */
+void
+cfg_db_gen_fini(void)
+{
+    if (cfg_db_gen == NULL)
+        return;
+
+    /* Invalidate caches of clients which are still running */
+    __atomic_store_n(cfg_db_gen, 0, __ATOMIC_RELEASE);
+    munmap(cfg_db_gen, sizeof(*cfg_db_gen));
+    cfg_db_gen = NULL;
+
+    unlink(cfg_db_gen_file);
+    free(cfg_db_gen_file);
+    cfg_db_gen_file = NULL;
+}
+
+/* See description in conf_db.h */
+void
+cfg_db_gen_bump(void)
+{
+    if (cfg_db_gen != NULL)
+        __atomic_add_fetch(cfg_db_gen, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Release records of the journal of instance versions.
+ *
+ * @param count         number of the oldest records to release
+ */
+static void
+cfg_db_journal_trim(size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        cfg_db_journal_rec *rec = te_vec_get(&cfg_db_journal, i);
+
+        if (rec->existed)
+            cfg_types[rec->type].free(rec->val);
+        free(rec->oid);
+    }
+    te_vec_remove(&cfg_db_journal, 0, count);
+}
+
+/**
+ * Forget all instance versions, so that versions marked before
+ * cannot be verified using the journal. It is done if objects are
+ * changed, since the journal tracks instances only.
+ */
+static void
+cfg_db_journal_reset(void)
+{
+    cfg_db_journal_trim(te_vec_size(&cfg_db_journal));
+    cfg_db_journal_base = ++cfg_db_version;
+}
+
+/**
+ * Remember the version of an instance before it is changed.
+ *
+ * @param inst          object instance
+ * @param existed       @c FALSE if the instance is just added
+ */
+static void
+cfg_db_journal_add(const cfg_instance *inst, te_bool existed)
+{
+    cfg_db_journal_rec rec = { .existed = existed };
+
+    if (te_vec_size(&cfg_db_version_marks) == 0 ||
+        cfg_inst_agent((cfg_instance *)inst) || inst->obj->vol)
+        return;
+
+    if (te_vec_size(&cfg_db_journal) >= CFG_DB_JOURNAL_MAX)
+    {
+        WARN("Too many changes of the database, forget previous versions "
+             "of instances");
+        cfg_db_journal_reset();
+    }
+
+    rec.oid = strdup(inst->oid);
+    if (rec.oid == NULL)
+        goto fail;
+
+    if (existed)
+    {
+        rec.type = inst->obj->type;
+        if (cfg_types[rec.type].copy(inst->val, &rec.val) != 0)
+        {
+            free(rec.oid);
+            goto fail;
+        }
+    }
+
+    rec.version = ++cfg_db_version;
+    if (TE_VEC_APPEND(&cfg_db_journal, rec) != 0)
+    {
+        if (existed)
+            cfg_types[rec.type].free(rec.val);
+        free(rec.oid);
+        goto fail;
+    }
+
+    return;
+
+fail:
+    ERROR("Failed to remember version of %s", inst->oid);
+    cfg_db_journal_reset();
+}
+
+/* See description in conf_db.h */
+te_errno
+cfg_db_version_mark(uint64_t *version)
+{
+    te_errno rc;
+
+    rc = TE_VEC_APPEND(&cfg_db_version_marks, cfg_db_version);
+    if (rc != 0)
+        return rc;
+
+    *version = cfg_db_version;
+    return 0;
+}
+
+/* See description in conf_db.h */
+void
+cfg_db_version_unmark(uint64_t version)
+{
+    uint64_t   *mark;
+    uint64_t    min_mark = UINT64_MAX;
+    size_t      found = SIZE_MAX;
+    size_t      count = 0;
+
+    TE_VEC_FOREACH(&cfg_db_version_marks, mark)
+    {
+        if (*mark == version && found == SIZE_MAX)
+            found = te_vec_get_index(&cfg_db_version_marks, mark);
+        else
+            min_mark = MIN(min_mark, *mark);
+    }
+
+    if (found == SIZE_MAX)
+        return;
+    te_vec_remove_index(&cfg_db_version_marks, found);
+
+    /* Records which are not newer than all marks are not needed */
+    while (count < te_vec_size(&cfg_db_journal) &&
+           TE_VEC_GET(cfg_db_journal_rec, &cfg_db_journal,
+                      count).version <= min_mark)
+        count++;
+
+    cfg_db_journal_trim(count);
+}
+
+/** Order journal records by OID and then by version. */
+static int
+cfg_db_journal_rec_cmp(const void *a, const void *b)
+{
+    const cfg_db_journal_rec *rec_a = *(const cfg_db_journal_rec **)a;
+    const cfg_db_journal_rec *rec_b = *(const cfg_db_journal_rec **)b;
+    int                       rc = strcmp(rec_a->oid, rec_b->oid);
+
+    if (rc != 0)
+        return rc;
+
+    return rec_a->version < rec_b->version ? -1 :
+           rec_a->version > rec_b->version;
+}
+
+/**
+ * Check whether an instance belongs to the subtrees. As in backup
+ * processing, a subtree contains instances whose OIDs start with
+ * the subtree OID.
+ */
+static te_bool
+cfg_db_oid_in_subtrees(const char *oid, const te_vec *subtrees)
+{
+    char * const *subtree;
+
+    if (subtrees == NULL || te_vec_size(subtrees) == 0)
+        return TRUE;
+
+    TE_VEC_FOREACH(subtrees, subtree)
+    {
+        if (strcmp_start(*subtree, oid) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* See description in conf_db.h */
+te_errno
+cfg_db_version_verify(uint64_t version, const te_vec *subtrees)
+{
+    cfg_db_journal_rec    **changes;
+    cfg_db_journal_rec     *rec;
+    size_t                  n_changes = 0;
+    size_t                  i;
+    te_errno                rc = 0;
+
+    if (version < cfg_db_journal_base)
+        return TE_ENODATA;
+
+    changes = TE_ALLOC((te_vec_size(&cfg_db_journal) + 1) *
+                       sizeof(*changes));
+    if (changes == NULL)
+        return TE_ENOMEM;
+
+    TE_VEC_FOREACH(&cfg_db_journal, rec)
+    {
+        if (rec->version > version &&
+            cfg_db_oid_in_subtrees(rec->oid, subtrees))
+            changes[n_changes++] = rec;
+    }
+
+    qsort(changes, n_changes, sizeof(*changes), cfg_db_journal_rec_cmp);
+
+    /* The first change of an instance keeps its version to compare with */
+    for (i = 0; i < n_changes && rc == 0; i++)
+    {
+        cfg_instance *inst;
+
+        rec = changes[i];
+        if (i > 0 && strcmp(changes[i - 1]->oid, rec->oid) == 0)
+            continue;
+
+        inst = cfg_get_ins_by_ins_id_str(rec->oid);
+        if (inst == NULL || !rec->existed)
+        {
+            if ((inst == NULL) != !rec->existed)
+                rc = TE_EBACKUP;
+        }
+        else if (inst->obj->type != rec->type ||
+                 (rec->type != CVT_NONE &&
+                  !cfg_types[rec->type].is_equal(inst->val, rec->val)))
+        {
+            rc = TE_EBACKUP;
+        }
+
+        if (rc != 0)
+            VERB("Instance %s is changed since version %" PRIu64,
+                 rec->oid, version);
+    }
+
+    free(changes);
+    return rc;
+}
+
+/* See description in conf_db.h */
+te_bool
+cfg_inst_is_volatile(const cfg_instance *inst)
+{
+    for (; inst != NULL; inst = inst->father)
+    {
+        if (inst->obj->vol)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 /**
  * Initialize the database during startup or re-initialization.
  *
@@ -501,6 +1140,7 @@ cfg_db_init(void)
     cfg_all_inst_size = CFG_INST_NUM;
     cfg_all_inst[0] = &cfg_inst_root;
     cfg_inst_root.son = NULL;
+    cfg_inst_root.n_sons = 0;
 
     cfg_create_dep(&cfg_obj_agent_rsrc, &cfg_obj_agent_rsrc_shared, TRUE);
     cfg_create_dep(&cfg_obj_agent_rsrc, &cfg_obj_agent_rsrc_timeout, TRUE);
@@ -529,12 +1169,17 @@ cfg_db_destroy(void)
             cfg_types[cfg_all_inst[i]->obj->type].
                 free(cfg_all_inst[i]->val);
             free(cfg_all_inst[i]->oid);
+            free(cfg_all_inst[i]->sons_index);
             free(cfg_all_inst[i]);
         }
     }
     free(cfg_all_inst);
     cfg_all_inst = NULL;
 
+    free(cfg_inst_root.sons_index);
+    cfg_inst_root.sons_index = NULL;
+    cfg_inst_root.sons_index_size = 0;
+
     INFO("Destroy objects");
     for (i = CFG_OBJ_HANDLE_NUM_RSRVD; i < cfg_all_obj_size; i++)
     {
@@ -549,6 +1194,9 @@ cfg_db_destroy(void)
     }
     free(cfg_all_obj);
     cfg_all_obj = NULL;
+
+    cfg_db_journal_reset();
+    te_vec_free(&cfg_db_version_marks);
 }
 
 static void
@@ -753,6 +1401,7 @@ cfg_process_msg_register(cfg_register_msg *msg)
     }
 
     cfg_free_oid(oid);
+    cfg_db_journal_reset();
     msg->handle = i;
     msg->len = sizeof(*msg);
 }
@@ -767,6 +1416,7 @@ void
 cfg_process_msg_unregister(cfg_unregister_msg *msg)
 {
     msg->rc = cfg_db_unregister_obj_by_id_str(msg->id, TE_LL_WARN);
+    cfg_db_journal_reset();
     return;
 }
 
@@ -1034,12 +1684,15 @@ cfg_process_msg_add_dependency(cfg_add_dependency_msg *msg)
     {
         cfg_create_dep(CFG_GET_OBJ(master_handle), obj, msg->object_wide);
     }
+    cfg_db_journal_reset();
 }
 
 void
 cfg_process_msg_find(cfg_find_msg *msg)
 {
     msg->rc = cfg_db_find(msg->oid, &(msg->handle));
+    if (msg->rc == 0 && CFG_IS_INST(msg->handle))
+        msg->vol = cfg_inst_is_volatile(CFG_GET_INST(msg->handle));
 }
 
 void
@@ -1237,6 +1890,181 @@ cfg_process_msg_pattern(cfg_pattern_msg *msg)
 #undef RETERR
 }   /* cfg_process_msg_pattern() */
 
+/**
+ * Pack an instance into CFG_GET_SUBTREE answer.
+ *
+ * @param dbuf          buffer with the answer
+ * @param inst          object instance
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+cfg_subtree_pack_inst(te_dbuf *dbuf, cfg_instance *inst)
+{
+    static const uint8_t    pad[CFG_SUBTREE_ENTRY_ALIGN] = { 0, };
+
+    cfg_subtree_entry_hdr   hdr;
+    cfg_val_type            type = inst->obj->type;
+    cfg_inst_val            val;
+    const void             *val_ptr;
+    size_t                  len;
+    te_errno                rc;
+
+    /* Expand substitutions in the same way as CFG_GET does */
+    rc = cfg_db_get(inst->handle, &val);
+    if (rc != 0)
+    {
+        ERROR("Failed to get value for %s, rc=%r", inst->oid, rc);
+        return rc;
+    }
+
+    switch (type)
+    {
+        case CVT_NONE:
+            val_ptr = NULL;
+            break;
+
+        case CVT_STRING:
+            val_ptr = val.val_str;
+            break;
+
+        case CVT_ADDRESS:
+            val_ptr = val.val_addr;
+            break;
+
+        default:
+            /* All integer members start at the beginning of the union */
+            val_ptr = &val;
+            break;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.handle = inst->handle;
+    hdr.val_type = type;
+    hdr.val_len = cfg_types[type].value_size(val);
+    hdr.oid_len = strlen(inst->oid) + 1;
+    len = sizeof(hdr) + TE_ALIGN(hdr.val_len, CFG_SUBTREE_ENTRY_ALIGN) +
+          hdr.oid_len;
+
+    rc = te_dbuf_append(dbuf, &hdr, sizeof(hdr));
+    if (rc == 0)
+        rc = te_dbuf_append(dbuf, val_ptr, hdr.val_len);
+    /* The value is aligned to make addresses usable in place */
+    if (rc == 0)
+    {
+        rc = te_dbuf_append(dbuf, pad, TE_ALIGN(hdr.val_len,
+                                                CFG_SUBTREE_ENTRY_ALIGN) -
+                                       hdr.val_len);
+    }
+    if (rc == 0)
+        rc = te_dbuf_append(dbuf, inst->oid, hdr.oid_len);
+    if (rc == 0)
+    {
+        rc = te_dbuf_append(dbuf, pad,
+                            TE_ALIGN(len, CFG_SUBTREE_ENTRY_ALIGN) - len);
+    }
+
+    cfg_types[type].free(val);
+    return rc;
+}
+
+/**
+ * Pack an instance and (if requested) all its descendants into
+ * CFG_GET_SUBTREE answer. Fathers are packed before sons.
+ *
+ * @param dbuf          buffer with the answer
+ * @param inst          object instance
+ * @param subtree       pack descendants as well
+ * @param n_entries     number of packed instances to be updated
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+cfg_subtree_pack(te_dbuf *dbuf, cfg_instance *inst, te_bool subtree,
+                 uint32_t *n_entries)
+{
+    cfg_instance   *son;
+    te_errno        rc;
+
+    if (inst->remove)
+        return 0;
+
+    rc = cfg_subtree_pack_inst(dbuf, inst);
+    if (rc != 0)
+        return rc;
+    (*n_entries)++;
+
+    if (!subtree)
+        return 0;
+
+    for (son = inst->son; son != NULL; son = son->brother)
+    {
+        rc = cfg_subtree_pack(dbuf, son, TRUE, n_entries);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/* See description in conf_db.h */
+cfg_get_subtree_msg *
+cfg_process_msg_get_subtree(cfg_get_subtree_msg *msg)
+{
+    te_dbuf             dbuf = TE_DBUF_INIT(50);
+    cfg_get_subtree_msg reply;
+    cfg_handle         *matches = NULL;
+    unsigned int        n_matches = 0;
+    unsigned int        i;
+    te_errno            rc;
+
+    rc = cfg_db_find_pattern(msg->buf, &n_matches, &matches);
+    if (rc != 0)
+    {
+        msg->rc = rc;
+        return msg;
+    }
+
+    reply = *msg;
+    reply.n_entries = 0;
+    rc = te_dbuf_append(&dbuf, NULL, sizeof(reply));
+
+    for (i = 0; rc == 0 && i < n_matches; i++)
+    {
+        cfg_instance *inst = CFG_GET_INST(matches[i]);
+
+        /* Patterns may match objects which have no values */
+        if (inst == NULL)
+            continue;
+
+        rc = cfg_subtree_pack(&dbuf, inst, msg->subtree,
+                              &reply.n_entries);
+    }
+    free(matches);
+
+    if (rc != 0)
+    {
+        te_dbuf_free(&dbuf);
+        msg->rc = rc;
+        return msg;
+    }
+
+    VERB("Packed %u instances for %s", reply.n_entries, msg->buf);
+
+    reply.len = dbuf.len;
+    memcpy(dbuf.ptr, &reply, sizeof(reply));
+
+    /* Small answers are sent from the buffer of the request */
+    if (dbuf.len <= CFG_BUF_LEN)
+    {
+        memcpy(msg, dbuf.ptr, dbuf.len);
+        te_dbuf_free(&dbuf);
+        return msg;
+    }
+
+    return (cfg_get_subtree_msg *)dbuf.ptr;
+}
+
 /**
  * Find all objects or object instances matching a pattern.
  *
@@ -1499,6 +2327,8 @@ cfg_add_with_obj_and_parent(cfg_instance *par_inst, cfg_object *obj,
     cfg_all_inst[i]->son = NULL;
     cfg_all_inst[i]->brother = par_inst->son;
     par_inst->son =  cfg_all_inst[i];
+    cfg_inst_link_son(par_inst, cfg_all_inst[i]);
+    cfg_db_journal_add(cfg_all_inst[i], FALSE);
     *inst = cfg_all_inst[i];
 
     return 0;
@@ -1620,12 +2450,14 @@ cfg_db_add(const char *oid_s, cfg_handle *handle,
 {
     cfg_oid        *oid = cfg_convert_oid_str(oid_s);
     cfg_object     *obj;
-    cfg_instance   *father = &cfg_inst_root;
+    cfg_instance   *father;
     cfg_instance   *inst;
     cfg_instance   *prev;
     cfg_inst_subid *s;
     uint64_t        i = 0;
 
+    cfg_db_gen_bump();
+
     if (oid == NULL)
     {
         ERROR("%s: OID is expected to be not NULL", __FUNCTION__);
@@ -1641,29 +2473,14 @@ cfg_db_add(const char *oid_s, cfg_handle *handle,
     if (!oid->inst)
         RET(TE_EINVAL);
 
-    s = (cfg_inst_subid *)(oid->ids);
-
     /* Look for the father first */
-    while (TRUE)
-    {
-        for (;
-             father != NULL &&
-                 (strcmp(father->obj->subid, s->subid) != 0 ||
-                  strcmp(father->name, s->name) != 0 ||
-                  father->remove);
-             father = father->brother);
-
-        s++;
-
-        if (++i == oid->len - 1 || father == NULL)
-            break;
-
-        father = father->son;
-    }
+    father = cfg_inst_find_by_oid(oid, oid->len - 1, NULL, NULL);
 
     if (father == NULL)
         RET(TE_ENOENT);
 
+    s = (cfg_inst_subid *)(oid->ids) + oid->len - 1;
+
     /* Find an object for the instance */
     for (obj = father->obj->son;
          obj != NULL && strcmp(obj->subid, s->subid) != 0;
@@ -1780,6 +2597,8 @@ cfg_db_add(const char *oid_s, cfg_handle *handle,
         inst->brother = father->son;
         father->son = inst;
     }
+    cfg_inst_link_son(father, inst);
+    cfg_db_journal_add(inst, FALSE);
 
     *handle = inst->handle;
     if (cfg_all_inst_max < i)
@@ -1869,6 +2688,8 @@ delete_son(cfg_instance *father, cfg_instance *son)
         assert(brother != NULL);
         brother->brother = son->brother;
     }
+    cfg_inst_unlink_son(father, son);
+    cfg_db_journal_add(son, TRUE);
 
     /* Delete from the array of object instances */
     cfg_all_inst[CFG_INST_HANDLE_TO_INDEX(son->handle)] = NULL;
@@ -1878,6 +2699,7 @@ delete_son(cfg_instance *father, cfg_instance *son)
         cfg_types[son->obj->type].free(son->val);
 
     free(son->oid);
+    free(son->sons_index);
     free(son);
 }
 
@@ -1889,6 +2711,7 @@ delete_son(cfg_instance *father, cfg_instance *son)
 void
 cfg_db_del(cfg_handle handle)
 {
+    cfg_db_gen_bump();
     delete_son(CFG_GET_INST(handle)->father, CFG_GET_INST(handle));
 }
 
@@ -1906,6 +2729,7 @@ cfg_db_set(cfg_handle handle, cfg_inst_val val)
     cfg_instance *inst = CFG_GET_INST(handle);
 
     assert(inst);
+    cfg_db_gen_bump();
     if (inst->obj->type != CVT_NONE)
     {
         cfg_inst_val val0;
@@ -1914,6 +2738,7 @@ cfg_db_set(cfg_handle handle, cfg_inst_val val)
         if (err)
             return err;
 
+        cfg_db_journal_add(inst, TRUE);
         cfg_types[inst->obj->type].free(inst->val);
         inst->val = val0;
     }
@@ -1973,8 +2798,17 @@ cfg_db_get(cfg_handle handle, cfg_inst_val *val)
 int
 cfg_db_find(const char *oid_s, cfg_handle *handle)
 {
-    cfg_oid *oid = NULL;
-    int      i = 0;
+    cfg_oid      *oid = NULL;
+    cfg_handle   *cache_slot;
+    cfg_instance *inst;
+    int           i = 0;
+
+    inst = cfg_db_find_cache_lookup(oid_s, &cache_slot);
+    if (inst != NULL)
+    {
+        *handle = inst->handle;
+        return 0;
+    }
 
     if ((oid = cfg_convert_oid_str(oid_s)) == NULL)
        return TE_EINVAL;
@@ -1994,40 +2828,35 @@ cfg_db_find(const char *oid_s, cfg_handle *handle)
 
     if (oid->inst)
     {
-        cfg_instance *tmp = &cfg_inst_root;
+        cfg_instance *tmp;
         cfg_instance *last_subinst = NULL;
         te_bool not_added_ancestor = FALSE;
 
-        while (TRUE)
+        tmp = cfg_inst_find_by_oid(oid, oid->len, &i, &last_subinst);
+        if (tmp == NULL)
         {
+            cfg_instance *ancestor;
+
             /*
-             * Instance which is scheduled for removal after commit
-             * is skipped here. It does not make sense to perform
-             * some operations on a deleted instance.
+             * The instance is not found, but its father is found,
+             * i.e. the last subidentifier is not found.
              */
-            for (;
-                 tmp != NULL &&
-                 (!(strcmp(tmp->obj->subid,
-                           ((cfg_inst_subid *)(oid->ids))[i].subid) == 0 &&
-                    strcmp(tmp->name,
-                           ((cfg_inst_subid *)(oid->ids))[i].name) == 0)
-                  || tmp->remove);
-                 tmp = tmp->brother);
-
-            if (++i == oid->len || tmp == NULL)
+            i++;
+            if (last_subinst != NULL)
             {
-                break;
+                for (ancestor = last_subinst;
+                     ancestor != NULL && ancestor != &cfg_inst_root;
+                     ancestor = ancestor->father)
+                {
+                    if (ancestor->obj->access == CFG_READ_CREATE &&
+                        !ancestor->added)
+                    {
+                        not_added_ancestor = TRUE;
+                        break;
+                    }
+                }
             }
 
-            if (tmp->obj->access == CFG_READ_CREATE && !tmp->added)
-                not_added_ancestor = TRUE;
-
-            last_subinst = tmp;
-
-            tmp = tmp->son;
-        }
-        if (tmp == NULL)
-        {
             /*
              * In case of local add operation we should take care of
              * its children.
@@ -2075,7 +2904,11 @@ cfg_db_find(const char *oid_s, cfg_handle *handle)
             RETERR(TE_ENOENT);
         }
         else
+        {
+            if (strcmp(tmp->oid, oid_s) == 0)
+                *cache_slot = tmp->handle;
             RET(tmp->handle);
+        }
     }
     else
     {
@@ -2198,11 +3031,15 @@ cfg_get_obj_by_obj_id_str(const char *obj_id_str)
 cfg_instance *
 cfg_get_ins_by_ins_id_str(const char *ins_id_str)
 {
-    cfg_oid             *idsplit = cfg_convert_oid_str(ins_id_str);
-    cfg_instance        *ins = &cfg_inst_root;
-    cfg_inst_subid      *ids;
-    int                 i;
+    cfg_oid             *idsplit;
+    cfg_instance        *ins;
+    cfg_handle          *cache_slot;
 
+    ins = cfg_db_find_cache_lookup(ins_id_str, &cache_slot);
+    if (ins != NULL)
+        return ins;
+
+    idsplit = cfg_convert_oid_str(ins_id_str);
     if (idsplit == NULL)
         return NULL;
 
@@ -2212,29 +3049,9 @@ cfg_get_ins_by_ins_id_str(const char *ins_id_str)
         return NULL;
     }
 
-    ids = (cfg_inst_subid *)(idsplit->ids);
-
-    for (i = 0;;)
-    {
-        /*
-         * Instance which is scheduled for removal after commit
-         * is skipped here. It does not make sense to perform
-         * some operations on a deleted instance.
-         */
-        while (ins != NULL &&
-               (strcmp(ins->obj->subid, ids->subid) != 0 ||
-                strcmp(ins->name, ids->name ) != 0 ||
-                ins->remove))
-        {
-            ins = ins->brother;
-        }
-
-        if (++i == idsplit->len || ins == NULL)
-            break;
-
-        ins = ins->son;
-        ids++;
-    }
+    ins = cfg_inst_find_by_oid(idsplit, idsplit->len, NULL, NULL);
+    if (ins != NULL && strcmp(ins->oid, ins_id_str) == 0)
+        *cache_slot = ins->handle;
 
     cfg_free_oid(idsplit);
     return ins;
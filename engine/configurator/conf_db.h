@@ -13,6 +13,7 @@
 #include <stdint.h>
 
 #include "te_defs.h"
+#include "te_vector.h"
 #include "logger_ten.h"
 #include "rcf_common.h"
 #include "conf_api.h"
@@ -130,6 +131,16 @@ typedef struct cfg_instance {
     struct cfg_instance *brother;   /**< Link to the next brother */
     /*@}*/
 
+    /** @name Index of sons by object subidentifier and name */
+    struct cfg_instance **sons_index;   /**< Hash table of sons or @c NULL
+                                             if there are few sons */
+    unsigned int sons_index_size;       /**< Number of hash table buckets
+                                             (power of 2) */
+    unsigned int n_sons;                /**< Number of sons */
+    struct cfg_instance *index_next;    /**< Next son in the same bucket
+                                             of the father index */
+    /*@}*/
+
     struct cfg_instance *bkp_next;  /**< Pointer to the next instance
                                          in a list of instances to
                                          be restored from backup */
@@ -231,8 +242,97 @@ extern void cfg_process_msg_unregister(cfg_unregister_msg *msg);
  */
 extern cfg_pattern_msg *cfg_process_msg_pattern(cfg_pattern_msg *msg);
 
+/**
+ * Process a user request to get handles, OIDs and values of object
+ * instances matching a pattern (and of their descendants if requested).
+ * Synchronization with Test Agents should be done by the caller.
+ *
+ * @param msg   message pointer
+ *
+ * @return message pointer of pointer to newly allocated message if the
+ *         resulting message length > CFG_BUF_LEN
+ */
+extern cfg_get_subtree_msg *cfg_process_msg_get_subtree(
+                                cfg_get_subtree_msg *msg);
+
 /*------------------------ DB operations --------------------------------*/
 
+/**
+ * Create the file with generation of the database and map it to memory
+ * (see @ref CFG_DB_GEN_FILE_SUFFIX).
+ *
+ * @param tmp_dir       directory to create the file in
+ *
+ * @return status code (see te_errno.h)
+ */
+extern te_errno cfg_db_gen_init(const char *tmp_dir);
+
+/**
+ * Invalidate generation of the database and remove its file.
+ */
+extern void cfg_db_gen_fini(void);
+
+/**
+ * Increment generation of the database. It should be called on any
+ * change of the database which may be observed by clients.
+ */
+extern void cfg_db_gen_bump(void);
+
+/**
+ * Mark the current version of the database, so that previous versions
+ * of instances changed after it are kept until the mark is removed.
+ *
+ * @param version       location for the marked version
+ *
+ * @return Status code.
+ */
+extern te_errno cfg_db_version_mark(uint64_t *version);
+
+/**
+ * Remove the mark of the database version and forget previous versions
+ * of instances which are not required anymore.
+ *
+ * @param version       version returned by cfg_db_version_mark()
+ */
+extern void cfg_db_version_unmark(uint64_t version);
+
+/**
+ * Check whether non-volatile instances are the same as at the marked
+ * version of the database. Only instances changed after the version
+ * are checked.
+ *
+ * @param version       version returned by cfg_db_version_mark()
+ * @param subtrees      vector of the subtrees to check or @c NULL
+ *                      for the whole database
+ *
+ * @return Status code.
+ * @retval 0            instances are not changed
+ * @retval TE_EBACKUP   some instances are changed
+ * @retval TE_ENODATA   previous versions are not kept (e.g. objects
+ *                      are changed after the version)
+ */
+extern te_errno cfg_db_version_verify(uint64_t version,
+                                      const te_vec *subtrees);
+
+/**
+ * Check whether an instance or any of its ancestors belongs to
+ * a volatile object, i.e. the instance may be changed by any access.
+ *
+ * @param inst          object instance
+ *
+ * @return @c TRUE if the instance is volatile.
+ */
+extern te_bool cfg_inst_is_volatile(const cfg_instance *inst);
+
+/**
+ * Account a son just linked to the list of sons of the father:
+ * update the number of sons and the index of sons.
+ *
+ * @param father        father instance
+ * @param son           new son instance
+ */
+extern void cfg_inst_link_son(cfg_instance *father, cfg_instance *son);
+
 /**
  * Find object for specified instance object identifier.
  *
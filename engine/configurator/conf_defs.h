@@ -54,6 +54,8 @@
 #include "conf_messages.h"
 #include "conf_types.h"
 #include "conf_db.h"
+#include "conf_snapshot.h"
+#include "conf_restore_plan.h"
 #include "conf_dh.h"
 #include "conf_backup.h"
 #include "conf_ta.h"
@@ -19,6 +19,8 @@ extern int cfg_register_dependency(xmlNodePtr node, const char *dependant);
 typedef struct cfg_backup {
     struct cfg_backup *next; /**< Next backup associated with this point */
     char              *filename; /**< backup filename */
+    cfg_snapshot      *snapshot; /**< Snapshot of the database taken
+                                      with the backup or @c NULL */
 } cfg_backup;
 
 /** Configurator dynamic history entry */
@@ -40,6 +42,15 @@ static cfg_dh_entry *first = NULL;
 static cfg_dh_entry *last = NULL;
 static cfg_backup   *begin_backup = NULL;
 
+/** Release memory allocated for backup descriptor */
+static inline void
+free_backup(cfg_backup *backup)
+{
+    cfg_snapshot_free(backup->snapshot);
+    free(backup->filename);
+    free(backup);
+}
+
 /** Release memory allocated for backup list */
 static inline void
 free_entry_backup(cfg_dh_entry *entry)
@@ -49,8 +60,7 @@ free_entry_backup(cfg_dh_entry *entry)
     for (tmp = entry->backup; tmp != NULL; tmp = entry->backup)
     {
         entry->backup = entry->backup->next;
-        free(tmp->filename);
-        free(tmp);
+        free_backup(tmp);
     }
 }
 
@@ -1124,22 +1134,29 @@ cfg_dh_create_file(char *filename)
  * Attach backup to the last command.
  *
  * @param filename      name of the backup file
+ * @param snapshot      snapshot of the database taken with the backup
+ *                      or @c NULL (it is owned by the history then)
  *
  * @return status code (see te_errno.h)
  */
 int
-cfg_dh_attach_backup(char *filename)
+cfg_dh_attach_backup(char *filename, cfg_snapshot *snapshot)
 {
     cfg_backup *tmp;
 
     if ((tmp = (cfg_backup *)malloc(sizeof(*tmp))) == NULL)
+    {
+        cfg_snapshot_free(snapshot);
         return TE_ENOMEM;
+    }
 
     if ((tmp->filename = strdup(filename)) == NULL)
     {
+        cfg_snapshot_free(snapshot);
         free(tmp);
         return TE_ENOMEM;
     }
+    tmp->snapshot = snapshot;
     if (last == NULL)
     {
         if (begin_backup == NULL)
@@ -1817,8 +1834,7 @@ cfg_dh_release_backup(char *filename)
         else
             tmp->backup = cur->next;
 
-        free(cur->filename);
-        free(cur);
+        free_backup(cur);
 
         return 0;
     }
@@ -1826,6 +1842,31 @@ cfg_dh_release_backup(char *filename)
     return 0;
 }
 
+/* See description in conf_dh.h */
+const cfg_snapshot *
+cfg_dh_find_backup_snapshot(const char *filename)
+{
+    cfg_dh_entry *entry;
+    cfg_backup   *tmp;
+
+    for (tmp = begin_backup; tmp != NULL; tmp = tmp->next)
+    {
+        if (strcmp(tmp->filename, filename) == 0)
+            return tmp->snapshot;
+    }
+
+    for (entry = first; entry != NULL; entry = entry->next)
+    {
+        for (tmp = entry->backup; tmp != NULL; tmp = tmp->next)
+        {
+            if (strcmp(tmp->filename, filename) == 0)
+                return tmp->snapshot;
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * Notify history DB about successful commit operation.
  * The result of calling of this function is that some entries in DH DB
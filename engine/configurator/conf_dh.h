@@ -45,10 +45,23 @@ extern int cfg_dh_create_file(char *filename);
  * Attach backup to the last command.
  *
  * @param filename      name of the backup file
+ * @param snapshot      snapshot of the database taken with the backup
+ *                      or @c NULL (it is owned by the history then)
  *
  * @return status code (see te_errno.h)
  */
-extern int cfg_dh_attach_backup(char *filename);
+extern int cfg_dh_attach_backup(char *filename, cfg_snapshot *snapshot);
+
+/**
+ * Find the snapshot of the database taken with the backup.
+ *
+ * @param filename      name of the backup file
+ *
+ * @return Snapshot or @c NULL if the backup is not attached to
+ *         the history or has no snapshot.
+ */
+extern const cfg_snapshot *cfg_dh_find_backup_snapshot(
+                               const char *filename);
 
 /**
  * Restore backup with specified name using reversed command
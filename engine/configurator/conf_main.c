@@ -64,6 +64,8 @@ static const char *cs_dirs_cfg = NULL;
                                      failed */
 #define CS_FOREGROUND   0x4     /**< Run Configurator in foreground */
 #define CS_SHUTDOWN     0x8     /**< Shutdown after message processing */
+#define CS_DELTA_SYNC   0x10    /**< Synchronize only instances changed
+                                     on Test Agents if possible */
 /*@}*/
 
 /** Configurator global flags */
@@ -1576,6 +1578,7 @@ process_get(cfg_get_msg *msg)
     }
 
     msg->val_type = obj->type;
+    msg->vol = cfg_inst_is_volatile(inst);
     msg->len = sizeof(*msg);
 
     /*
@@ -1593,6 +1596,57 @@ process_get(cfg_get_msg *msg)
     cfg_types[obj->type].free(val);
 }
 
+/**
+ * Synchronize instances requested by CFG_GET_SUBTREE message with
+ * Test Agents. The same rules as for CFG_GET are applied: an instance
+ * is synchronized if it is requested explicitly or its object is
+ * volatile.
+ *
+ * @param msg           CFG_GET_SUBTREE message
+ *
+ * @return Status code (also saved in the message).
+ */
+static te_errno
+process_get_subtree_sync(cfg_get_subtree_msg *msg)
+{
+    cfg_handle     *matches = NULL;
+    unsigned int    n_matches = 0;
+    unsigned int    i;
+
+    /* Synchronize /agent/volatile subtree if necessary */
+    if (cfg_sync_agt_volatile((cfg_msg *)msg, msg->buf) != 0)
+        return msg->rc;
+
+    if (strcmp_start("/agent", msg->buf) != 0)
+        return 0;
+
+    msg->rc = cfg_db_find_pattern(msg->buf, &n_matches, &matches);
+    if (msg->rc != 0)
+        return msg->rc;
+
+    for (i = 0; i < n_matches; i++)
+    {
+        cfg_instance *inst = CFG_GET_INST(matches[i]);
+        char          oid[CFG_OID_MAX];
+
+        /* Instances may be deleted by synchronization of previous ones */
+        if (inst == NULL || !(msg->sync || inst->obj->vol))
+            continue;
+
+        /* Synchronization may free the instance together with its OID */
+        te_strlcpy(oid, inst->oid, sizeof(oid));
+        msg->rc = cfg_ta_sync(oid, msg->subtree);
+        if (msg->rc != 0)
+        {
+            ERROR("Failed to synchronize %s: %r", oid, msg->rc);
+            break;
+        }
+    }
+    free(matches);
+
+    return msg->rc;
+}
+
 /* Returns time since Epoche in milliseconds */
 static unsigned long long
 get_time_ms(void)
@@ -1933,6 +1987,17 @@ log_msg(cfg_msg *msg, te_bool before)
             cfg_db_tree_print_msg_log((cfg_tree_print_msg *)msg, level);
             break;
 
+        case CFG_GET_SUBTREE:
+            if (before || msg->rc != 0)
+            {
+                /* The OID is overwritten by the answer on success */
+                LOG_MSG(level, "Get %s%s%s",
+                        ((cfg_get_subtree_msg *)msg)->subtree ?
+                        "subtree " : "", ((cfg_get_subtree_msg *)msg)->buf,
+                        addon);
+            }
+            break;
+
         default:
             ERROR("Unknown command %x", msg->type);
     }
@@ -2261,6 +2326,27 @@ out:
     return rc;
 }
 
+/**
+ * Synchronize subtrees with Test Agents.
+ *
+ * @param subtrees      Vector of the subtrees (the whole database is
+ *                      synchronized if it is empty)
+ */
+static void
+sync_subtrees(const te_vec *subtrees)
+{
+    char * const *subtree;
+
+    if (te_vec_size(subtrees) == 0)
+    {
+        cfg_ta_sync("/:", TRUE);
+        return;
+    }
+
+    TE_VEC_FOREACH(subtrees, subtree)
+        cfg_ta_sync(*subtree, TRUE);
+}
+
 /**
  * Process backup user request.
  *
@@ -2274,6 +2360,7 @@ process_backup(cfg_backup_msg *msg, te_bool release_dh)
     char *backup_filename;
     char *subtrees = NULL;
     te_vec subtrees_vec = TE_VEC_INIT(char *);
+    const cfg_snapshot *snapshot;
 
     if (msg->subtrees_num != 0)
     {
@@ -2289,10 +2376,19 @@ process_backup(cfg_backup_msg *msg, te_bool release_dh)
 
     backup_filename = (char *)msg + msg->filename_offset;
 
+    /*
+     * Changes made after a backup of subtrees may belong to other
+     * subtrees, so they are kept in DH.
+     */
+    if (te_vec_size(&subtrees_vec) != 0)
+        release_dh = FALSE;
+
     switch (msg->op)
     {
         case CFG_BACKUP_CREATE:
         {
+            cfg_snapshot *new_snapshot = NULL;
+
             sprintf(backup_filename, CONF_BACKUP_NAME,
                     tmp_dir, getpid(), get_time_ms());
 
@@ -2302,7 +2398,22 @@ process_backup(cfg_backup_msg *msg, te_bool release_dh)
                 break;;
             }
 
-            if ((msg->rc = cfg_dh_attach_backup(backup_filename)) != 0)
+            /*
+             * Snapshot of the database (or of the requested subtrees)
+             * allows to verify and restore the backup without processing
+             * of the file.
+             */
+            if (cfg_snapshot_create(te_vec_size(&subtrees_vec) == 0 ?
+                                        NULL : &subtrees_vec,
+                                    &new_snapshot) != 0)
+            {
+                WARN("Failed to take snapshot of the database, backup "
+                     "file will be used");
+                new_snapshot = NULL;
+            }
+
+            if ((msg->rc = cfg_dh_attach_backup(backup_filename,
+                                                new_snapshot)) != 0)
                 unlink(backup_filename);
 
             msg->len += strlen(backup_filename) + 1;
@@ -2335,6 +2446,14 @@ process_backup(cfg_backup_msg *msg, te_bool release_dh)
                     cfg_conf_delay_reset();
                     cfg_ta_sync("/:", TRUE);
 
+                    snapshot = cfg_dh_find_backup_snapshot(backup_filename);
+                    if (snapshot != NULL &&
+                        cfg_snapshot_verify(snapshot, NULL) == 0)
+                    {
+                        rcf_log_cfg_changes(FALSE);
+                        break;
+                    }
+
                     msg->rc = verify_backup(backup_filename, FALSE,
                                             "Restoring backup from history "
                                             "failed:", NULL);
@@ -2352,6 +2471,18 @@ process_backup(cfg_backup_msg *msg, te_bool release_dh)
                 cfg_ta_sync("/:", TRUE);
             }
 
+            snapshot = cfg_dh_find_backup_snapshot(backup_filename);
+            if (snapshot != NULL)
+            {
+                msg->rc = cfg_backup_restore_snapshot(snapshot,
+                                                      &subtrees_vec);
+                rcf_log_cfg_changes(FALSE);
+
+                if (release_dh)
+                    cfg_dh_release_after(backup_filename);
+                break;
+            }
+
             /*
              * If subtrees is NULL @p backup string will contain
              * filename specified by the user
@@ -2380,6 +2511,34 @@ process_backup(cfg_backup_msg *msg, te_bool release_dh)
             te_errno rc;
             te_string backup = TE_STRING_INIT;
 
+            snapshot = cfg_dh_find_backup_snapshot(backup_filename);
+            if (snapshot != NULL)
+            {
+                rc = check_agents();
+                if (rc != 0)
+                {
+                    ERROR("Backup verification failed: %r", rc);
+                    msg->rc = rc;
+                    break;
+                }
+
+                msg->rc = cfg_snapshot_verify(snapshot, &subtrees_vec);
+                if (msg->rc != 0)
+                {
+                    sync_subtrees(&subtrees_vec);
+                    msg->rc = cfg_snapshot_verify(snapshot, &subtrees_vec);
+                }
+
+                if (msg->rc == 0)
+                {
+                    if (release_dh)
+                        cfg_dh_release_after(backup_filename);
+                    break;
+                }
+
+                /* Verify the backup file as well to log the differences */
+            }
+
             /*
              * If subtrees is NULL @p backup string will contain
              * filename specified by the user
@@ -2611,6 +2770,38 @@ process_register(cfg_register_msg *msg, te_bool update_dh)
     }
 }
 
+/**
+ * Check whether a request does not change the database by itself.
+ * Changes done by synchronization with Test Agents are tracked by
+ * the database.
+ *
+ * @param msg           message with user request
+ *
+ * @return @c TRUE if the request only reads the database.
+ */
+static te_bool
+msg_is_read_only(const cfg_msg *msg)
+{
+    switch (msg->type)
+    {
+        case CFG_FIND:
+        case CFG_GET_DESCR:
+        case CFG_GET_OID:
+        case CFG_GET_ID:
+        case CFG_PATTERN:
+        case CFG_FAMILY:
+        case CFG_GET:
+        case CFG_GET_SUBTREE:
+        case CFG_CONFIG:
+        case CFG_CONF_DELAY:
+        case CFG_TREE_PRINT:
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
 /**
  * Process message with user request.
  *
@@ -2623,6 +2814,9 @@ cfg_process_msg(cfg_msg **msg, te_bool update_dh)
 {
     log_msg(*msg, TRUE);
 
+    if (!msg_is_read_only(*msg))
+        cfg_db_gen_bump();
+
     switch ((*msg)->type)
     {
         case CFG_REGISTER:
@@ -2779,6 +2973,14 @@ cfg_process_msg(cfg_msg **msg, te_bool update_dh)
             cfg_process_msg_tree_print((cfg_tree_print_msg *)*msg);
             break;
 
+        case CFG_GET_SUBTREE:
+            CFG_CHECK_NO_LOCAL_SEQ_BREAK("get subtree", *msg);
+            if (process_get_subtree_sync((cfg_get_subtree_msg *)*msg) != 0)
+                break;
+            *msg = (cfg_msg *)cfg_process_msg_get_subtree(
+                                  (cfg_get_subtree_msg *)*msg);
+            break;
+
         default: /* Should not occur */
             ERROR("Unknown message is received");
             break;
@@ -2800,6 +3002,7 @@ free_resources(void)
 
     VERB("Destroy database");
     cfg_db_destroy();
+    cfg_db_gen_fini();
 
     VERB("Free resources");
     free(cfg_get_buf);
@@ -2845,6 +3048,14 @@ process_cmd_line_opts(int argc, char **argv)
           CS_FOREGROUND,
           "Run in foreground (useful for debugging).", NULL },
 
+        { "delta-sync", '\0', POPT_ARG_NONE | POPT_BIT_SET, &cs_flags,
+          CS_DELTA_SYNC, "Synchronize only subtrees changed on Test "
+          "Agents since the previous synchronization. Changes made "
+          "bypassing configure commands (e.g. by RPC servers) are "
+          "noticed only if agents report them (Unix agent reports "
+          "interfaces, addresses and neighbours), so it is unsafe "
+          "if other changes are made out of band.", NULL },
+
         { "sniff-conf", '\0', POPT_ARG_STRING, &cs_sniff_cfg_file, 0,
           "Auxiliary conf file for the sniffer framework.", NULL },
 
@@ -3000,6 +3211,7 @@ main(int argc, char **argv)
         ERROR("Fatal error during command line options processing");
         goto exit;
     }
+    cfg_ta_delta_syncing((cs_flags & CS_DELTA_SYNC) != 0);
 
     VERB("Starting...");
 
@@ -3030,6 +3242,9 @@ main(int argc, char **argv)
     }
     sprintf(filename, "%s/te_cfg_tmp.xml", tmp_dir);
 
+    /* Client-side caches are just disabled if it fails */
+    (void)cfg_db_gen_init(tmp_dir);
+
     if ((rc = cfg_db_init()) != 0)
     {
         ERROR("Fatal error: cannot initialize database");
@@ -0,0 +1,667 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator
+ *
+ * Planner of restoring instances from a backup
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#include "conf_defs.h"
+#include "te_alloc.h"
+#include "te_stopwatch.h"
+#include "conf_restore_plan.h"
+
+/** State of a node during computation of waves */
+typedef enum cfg_restore_node_state {
+    CFG_RESTORE_NODE_NEW = 0,   /**< Wave is not computed */
+    CFG_RESTORE_NODE_VISITING,  /**< Wave is being computed */
+    CFG_RESTORE_NODE_DONE,      /**< Wave is computed */
+} cfg_restore_node_state;
+
+/** Node of the dependency graph */
+typedef struct cfg_restore_node {
+    cfg_instance   *inst;       /**< Instance to restore */
+    unsigned int    exec;       /**< Index of the node restoring the
+                                     instance (differs for unit parts) */
+    const char     *branch;     /**< Top-level subtree of the instance */
+    size_t          branch_len; /**< Length of the branch name */
+    te_vec          preds;      /**< Indexes of nodes the node depends
+                                     on (unsigned int) */
+    unsigned int    wave;       /**< Wave of the node */
+    cfg_restore_node_state state; /**< State of computation of waves */
+} cfg_restore_node;
+
+/** Restore plan */
+struct cfg_restore_plan {
+    cfg_restore_node   *nodes;      /**< Nodes in the order of the list */
+    unsigned int        n_nodes;    /**< Number of nodes */
+    unsigned int       *order;      /**< Indexes of nodes in the order
+                                         of restoring */
+    unsigned int       *by_obj;     /**< Indexes of nodes sorted by
+                                         object */
+    unsigned int       *by_inst;    /**< Indexes of nodes sorted by
+                                         instance pointer */
+    unsigned int        n_waves;    /**< Number of waves */
+    unsigned int       *waves;      /**< Index of the first branch of
+                                         each wave and the number of
+                                         branches at the end */
+    uint64_t           *wave_time;  /**< Time spent on each wave */
+    cfg_restore_branch *branches;   /**< Branches of all waves in the
+                                         order of restoring */
+    unsigned int        n_branches; /**< Number of branches in all waves */
+    cfg_instance      **insts;      /**< Instances in the order of
+                                         restoring */
+};
+
+/** Plan being sorted by qsort() (it has no context argument) */
+static const cfg_restore_plan *sort_plan;
+
+/** Compare nodes by object */
+static int
+plan_obj_cmp(const void *a, const void *b)
+{
+    const cfg_restore_node *node_a = &sort_plan->nodes[*(unsigned int *)a];
+    const cfg_restore_node *node_b = &sort_plan->nodes[*(unsigned int *)b];
+    uintptr_t               obj_a = (uintptr_t)node_a->inst->obj;
+    uintptr_t               obj_b = (uintptr_t)node_b->inst->obj;
+
+    return (obj_a > obj_b) - (obj_a < obj_b);
+}
+
+/** Compare nodes by instance pointer */
+static int
+plan_inst_cmp(const void *a, const void *b)
+{
+    const cfg_restore_node *node_a = &sort_plan->nodes[*(unsigned int *)a];
+    const cfg_restore_node *node_b = &sort_plan->nodes[*(unsigned int *)b];
+    uintptr_t               inst_a = (uintptr_t)node_a->inst;
+    uintptr_t               inst_b = (uintptr_t)node_b->inst;
+
+    return (inst_a > inst_b) - (inst_a < inst_b);
+}
+
+/** Compare branches of nodes */
+static int
+plan_branch_cmp(const cfg_restore_node *a, const cfg_restore_node *b)
+{
+    int rc = memcmp(a->branch, b->branch,
+                    MIN(a->branch_len, b->branch_len));
+
+    if (rc != 0)
+        return rc;
+
+    return (a->branch_len > b->branch_len) -
+           (a->branch_len < b->branch_len);
+}
+
+/** Compare nodes by wave, branch and position in the list */
+static int
+plan_order_cmp(const void *a, const void *b)
+{
+    unsigned int            idx_a = *(unsigned int *)a;
+    unsigned int            idx_b = *(unsigned int *)b;
+    const cfg_restore_node *node_a = &sort_plan->nodes[idx_a];
+    const cfg_restore_node *node_b = &sort_plan->nodes[idx_b];
+    int                     rc;
+
+    if (node_a->wave != node_b->wave)
+        return node_a->wave < node_b->wave ? -1 : 1;
+
+    rc = plan_branch_cmp(node_a, node_b);
+    if (rc != 0)
+        return rc;
+
+    return (idx_a > idx_b) - (idx_a < idx_b);
+}
+
+/**
+ * Get length of OID prefix consisting of the given number of
+ * sub-identifiers.
+ *
+ * @param oid       Object or instance identifier
+ * @param depth     Number of sub-identifiers
+ *
+ * @return Length of the prefix.
+ */
+static size_t
+plan_oid_prefix_len(const char *oid, unsigned int depth)
+{
+    const char *p = oid;
+
+    for (; depth > 0 && *p != '\0'; depth--)
+    {
+        p = strchr(p + 1, '/');
+        if (p == NULL)
+            return strlen(oid);
+    }
+
+    return p - oid;
+}
+
+/**
+ * Get number of common leading sub-identifiers of two object
+ * identifiers.
+ *
+ * @param a         The first object identifier
+ * @param b         The second object identifier
+ *
+ * @return Number of common sub-identifiers.
+ */
+static unsigned int
+plan_common_depth(const char *a, const char *b)
+{
+    unsigned int depth;
+    size_t       prev = 0;
+    size_t       len_a;
+    size_t       len_b;
+
+    for (depth = 0; ; depth++, prev = len_a)
+    {
+        len_a = plan_oid_prefix_len(a, depth + 1);
+        len_b = plan_oid_prefix_len(b, depth + 1);
+        if (len_a == prev || len_a != len_b || memcmp(a, b, len_a) != 0)
+            break;
+    }
+
+    return depth;
+}
+
+/**
+ * Find the node of the instance.
+ *
+ * @param plan      Plan
+ * @param inst      Instance
+ *
+ * @return Index of the node or @c UINT_MAX if the instance is not
+ *         in the plan.
+ */
+static unsigned int
+plan_find_inst(const cfg_restore_plan *plan, const cfg_instance *inst)
+{
+    unsigned int lo = 0;
+    unsigned int hi = plan->n_nodes;
+
+    while (lo < hi)
+    {
+        unsigned int mid = lo + (hi - lo) / 2;
+        const cfg_instance *cur = plan->nodes[plan->by_inst[mid]].inst;
+
+        if (cur == inst)
+            return plan->by_inst[mid];
+        if ((uintptr_t)cur < (uintptr_t)inst)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return UINT_MAX;
+}
+
+/**
+ * Add an edge of the dependency graph between nodes restoring
+ * the instances.
+ *
+ * @param plan      Plan
+ * @param from      Index of the node which should be restored first
+ * @param to        Index of the dependant node
+ *
+ * @return Status code.
+ */
+static te_errno
+plan_add_edge(cfg_restore_plan *plan, unsigned int from, unsigned int to)
+{
+    from = plan->nodes[from].exec;
+    to = plan->nodes[to].exec;
+    if (from == to)
+        return 0;
+
+    return TE_VEC_APPEND(&plan->nodes[to].preds, from);
+}
+
+/**
+ * Add edges from instances of the master object to the node.
+ *
+ * @param plan      Plan
+ * @param idx       Index of the dependant node
+ * @param master    Master object
+ * @param wide      If @c TRUE, the node depends on all instances
+ *                  of @p master, otherwise only on instances in the
+ *                  same subtree as the common root of objects
+ *
+ * @return Status code.
+ */
+static te_errno
+plan_add_master(cfg_restore_plan *plan, unsigned int idx,
+                const cfg_object *master, te_bool wide)
+{
+    const cfg_instance *inst = plan->nodes[idx].inst;
+    size_t              prefix_len = 0;
+    unsigned int        depth = 0;
+    unsigned int        lo = 0;
+    unsigned int        hi = plan->n_nodes;
+    te_errno            rc;
+
+    /* Find the first node of the master object */
+    while (lo < hi)
+    {
+        unsigned int mid = lo + (hi - lo) / 2;
+
+        if ((uintptr_t)plan->nodes[plan->by_obj[mid]].inst->obj <
+            (uintptr_t)master)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (!wide)
+    {
+        depth = plan_common_depth(inst->obj->oid, master->oid);
+        prefix_len = plan_oid_prefix_len(inst->oid, depth);
+    }
+
+    for (; lo < plan->n_nodes; lo++)
+    {
+        unsigned int        from = plan->by_obj[lo];
+        const cfg_instance *master_inst = plan->nodes[from].inst;
+
+        if (master_inst->obj != master)
+            break;
+
+        if (!wide &&
+            (plan_oid_prefix_len(master_inst->oid, depth) != prefix_len ||
+             memcmp(master_inst->oid, inst->oid, prefix_len) != 0))
+            continue;
+
+        rc = plan_add_edge(plan, from, idx);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Add edges from instances of objects the object depends on
+ * (directly or transitively) to the node.
+ *
+ * @param plan          Plan
+ * @param idx           Index of the dependant node
+ * @param obj           Dependant object
+ * @param transitive    Whether @p obj is not the object of the node
+ * @param visited       Master objects which are already processed
+ *
+ * @return Status code.
+ */
+static te_errno
+plan_add_deps(cfg_restore_plan *plan, unsigned int idx,
+              const cfg_object *obj, te_bool transitive, te_vec *visited)
+{
+    cfg_dependency     *dep;
+    const cfg_object  **seen;
+    te_bool             found;
+    te_errno            rc;
+
+    for (dep = obj->depends_on; dep != NULL; dep = dep->next)
+    {
+        const cfg_object *master = dep->depends;
+
+        found = FALSE;
+        TE_VEC_FOREACH(visited, seen)
+        {
+            if (*seen == master)
+            {
+                found = TRUE;
+                break;
+            }
+        }
+        if (found)
+            continue;
+
+        rc = TE_VEC_APPEND(visited, master);
+        if (rc != 0)
+            return rc;
+
+        /*
+         * Instances of a transitive master may be not related to
+         * the instance at all, so dependency on them is object-wide.
+         */
+        rc = plan_add_master(plan, idx, master,
+                             transitive || dep->object_wide);
+        if (rc != 0)
+            return rc;
+
+        rc = plan_add_deps(plan, idx, master, TRUE, visited);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Compute the wave of the node.
+ *
+ * @param plan      Plan
+ * @param idx       Index of the node
+ *
+ * @return Wave of the node.
+ */
+static unsigned int
+plan_wave(cfg_restore_plan *plan, unsigned int idx)
+{
+    cfg_restore_node *node = &plan->nodes[idx];
+    unsigned int     *pred;
+    unsigned int      wave = 0;
+
+    if (node->state == CFG_RESTORE_NODE_DONE)
+        return node->wave;
+
+    if (node->state == CFG_RESTORE_NODE_VISITING)
+    {
+        WARN("Loop dependency suspected for %s", node->inst->oid);
+        return 0;
+    }
+
+    node->state = CFG_RESTORE_NODE_VISITING;
+    TE_VEC_FOREACH(&node->preds, pred)
+        wave = MAX(wave, plan_wave(plan, *pred) + 1);
+
+    node->wave = wave;
+    node->state = CFG_RESTORE_NODE_DONE;
+
+    return wave;
+}
+
+/**
+ * Fill branches of waves of the plan with nodes already ordered.
+ *
+ * @param plan      Plan
+ *
+ * @return Status code.
+ */
+static te_errno
+plan_fill_branches(cfg_restore_plan *plan)
+{
+    cfg_restore_branch *branch = NULL;
+    unsigned int        i;
+
+    plan->insts = TE_ALLOC(sizeof(*plan->insts) * (plan->n_nodes + 1));
+    plan->branches = TE_ALLOC(sizeof(*plan->branches) *
+                              (plan->n_branches + 1));
+    plan->waves = TE_ALLOC(sizeof(*plan->waves) * (plan->n_waves + 1));
+    plan->wave_time = TE_ALLOC(sizeof(*plan->wave_time) *
+                               (plan->n_waves + 1));
+    if (plan->insts == NULL || plan->branches == NULL ||
+        plan->waves == NULL || plan->wave_time == NULL)
+        return TE_ENOMEM;
+
+    for (i = 0; i < plan->n_nodes; i++)
+    {
+        const cfg_restore_node *node = &plan->nodes[plan->order[i]];
+        const cfg_restore_node *prev = (i == 0) ? NULL :
+                                       &plan->nodes[plan->order[i - 1]];
+
+        plan->insts[i] = node->inst;
+
+        if (prev == NULL || prev->wave != node->wave ||
+            plan_branch_cmp(prev, node) != 0)
+        {
+            branch = (branch == NULL) ? plan->branches : branch + 1;
+            branch->name = strndup(node->branch, node->branch_len);
+            if (branch->name == NULL)
+                return TE_ENOMEM;
+            branch->insts = &plan->insts[i];
+
+            if (prev == NULL || prev->wave != node->wave)
+                plan->waves[node->wave] = branch - plan->branches;
+        }
+        branch->n_insts++;
+    }
+    plan->waves[plan->n_waves] = plan->n_branches;
+
+    return 0;
+}
+
+/* See description in conf_restore_plan.h */
+te_errno
+cfg_restore_plan_build(cfg_instance **list, unsigned int list_size,
+                       cfg_restore_plan **plan)
+{
+    cfg_restore_plan   *p;
+    cfg_instance       *inst;
+    te_vec              visited = TE_VEC_INIT(const cfg_object *);
+    unsigned int        i;
+    te_errno            rc = 0;
+
+    p = TE_ALLOC(sizeof(*p));
+    if (p == NULL)
+        return TE_ENOMEM;
+
+    p->n_nodes = list_size;
+    p->nodes = TE_ALLOC(sizeof(*p->nodes) * (list_size + 1));
+    p->order = TE_ALLOC(sizeof(*p->order) * (list_size + 1));
+    p->by_obj = TE_ALLOC(sizeof(*p->by_obj) * (list_size + 1));
+    p->by_inst = TE_ALLOC(sizeof(*p->by_inst) * (list_size + 1));
+    if (p->nodes == NULL || p->order == NULL || p->by_obj == NULL ||
+        p->by_inst == NULL)
+    {
+        cfg_restore_plan_free(p);
+        return TE_ENOMEM;
+    }
+
+    for (i = 0, inst = *list; i < list_size; i++, inst = inst->bkp_next)
+    {
+        cfg_restore_node *node = &p->nodes[i];
+
+        if (inst == NULL)
+        {
+            ERROR("%s(): list is shorter than expected", __FUNCTION__);
+            p->n_nodes = i;
+            cfg_restore_plan_free(p);
+            return TE_EINVAL;
+        }
+
+        node->inst = inst;
+        node->preds = (te_vec)TE_VEC_INIT(unsigned int);
+        node->branch = inst->oid + 1;
+        node->branch_len = plan_oid_prefix_len(inst->oid, 1);
+        if (node->branch_len > 0)
+            node->branch_len--;
+        p->order[i] = p->by_obj[i] = p->by_inst[i] = i;
+    }
+
+    sort_plan = p;
+    qsort(p->by_obj, p->n_nodes, sizeof(*p->by_obj), plan_obj_cmp);
+    qsort(p->by_inst, p->n_nodes, sizeof(*p->by_inst), plan_inst_cmp);
+
+    /* Unit parts are restored together with the unit */
+    for (i = 0; i < p->n_nodes; i++)
+    {
+        cfg_instance *unit = p->nodes[i].inst;
+        unsigned int  exec;
+
+        while (unit->obj->unit_part && unit->father != NULL)
+            unit = unit->father;
+
+        exec = plan_find_inst(p, unit);
+        p->nodes[i].exec = (exec == UINT_MAX) ? i : exec;
+    }
+
+    for (i = 0; i < p->n_nodes && rc == 0; i++)
+    {
+        cfg_instance *father = p->nodes[i].inst->father;
+
+        if (father != NULL)
+        {
+            unsigned int from = plan_find_inst(p, father);
+
+            if (from != UINT_MAX)
+                rc = plan_add_edge(p, from, i);
+        }
+
+        if (rc == 0)
+        {
+            te_vec_reset(&visited);
+            rc = plan_add_deps(p, i, p->nodes[i].inst->obj, FALSE,
+                               &visited);
+        }
+    }
+    te_vec_free(&visited);
+    if (rc != 0)
+    {
+        cfg_restore_plan_free(p);
+        return rc;
+    }
+
+    for (i = 0; i < p->n_nodes; i++)
+    {
+        cfg_restore_node *node = &p->nodes[i];
+
+        node->wave = plan_wave(p, node->exec);
+        p->n_waves = MAX(p->n_waves, node->wave + 1);
+    }
+
+    qsort(p->order, p->n_nodes, sizeof(*p->order), plan_order_cmp);
+    sort_plan = NULL;
+
+    /* Relink the list in the order of restoring */
+    for (i = 0; i < p->n_nodes; i++)
+    {
+        const cfg_restore_node *node = &p->nodes[p->order[i]];
+
+        node->inst->bkp_next = (i + 1 < p->n_nodes) ?
+                               p->nodes[p->order[i + 1]].inst : NULL;
+
+        if (i == 0 || node->wave != p->nodes[p->order[i - 1]].wave ||
+            plan_branch_cmp(node, &p->nodes[p->order[i - 1]]) != 0)
+            p->n_branches++;
+    }
+    if (p->n_nodes > 0)
+        *list = p->nodes[p->order[0]].inst;
+
+    rc = plan_fill_branches(p);
+    if (rc != 0)
+    {
+        cfg_restore_plan_free(p);
+        return rc;
+    }
+
+    VERB("Restore of %u instances is planned in %u waves and %u branches",
+         p->n_nodes, p->n_waves, p->n_branches);
+
+    *plan = p;
+    return 0;
+}
+
+/* See description in conf_restore_plan.h */
+void
+cfg_restore_plan_free(cfg_restore_plan *plan)
+{
+    unsigned int i;
+
+    if (plan == NULL)
+        return;
+
+    if (plan->nodes != NULL)
+    {
+        for (i = 0; i < plan->n_nodes; i++)
+            te_vec_free(&plan->nodes[i].preds);
+    }
+
+    if (plan->branches != NULL)
+    {
+        for (i = 0; i < plan->n_branches; i++)
+            free(plan->branches[i].name);
+    }
+
+    free(plan->nodes);
+    free(plan->order);
+    free(plan->waves);
+    free(plan->wave_time);
+    free(plan->branches);
+    free(plan->insts);
+    free(plan->by_obj);
+    free(plan->by_inst);
+    free(plan);
+}
+
+/* See description in conf_restore_plan.h */
+te_errno
+cfg_restore_plan_run(cfg_restore_plan *plan, cfg_restore_plan_cb *cb,
+                     void *opaque)
+{
+    unsigned int    i;
+    te_errno        rc;
+
+    for (i = 0; i < plan->n_waves; i++)
+    {
+        te_stopwatch_t      stopwatch = TE_STOPWATCH_INIT;
+        struct timeval      lap = { 0, 0 };
+
+        (void)te_stopwatch_start(&stopwatch);
+        rc = cb(&plan->branches[plan->waves[i]],
+                plan->waves[i + 1] - plan->waves[i], opaque);
+        (void)te_stopwatch_stop(&stopwatch, &lap);
+
+        plan->wave_time[i] += TE_SEC2US(lap.tv_sec) + lap.tv_usec;
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/* See description in conf_restore_plan.h */
+void
+cfg_restore_plan_report(const cfg_restore_plan *plan)
+{
+    uint64_t        total = 0;
+    uint64_t        critical = 0;
+    unsigned int    i;
+    unsigned int    j;
+
+    for (i = 0; i < plan->n_waves; i++)
+    {
+        uint64_t slowest = 0;
+
+        for (j = plan->waves[i]; j < plan->waves[i + 1]; j++)
+            slowest = MAX(slowest, plan->branches[j].time_us);
+
+        total += plan->wave_time[i];
+        critical += slowest;
+    }
+
+    INFO("Restore of %u instances in %u waves and %u branches took %u ms; "
+         "critical path is %u ms",
+         plan->n_nodes, plan->n_waves, plan->n_branches,
+         (unsigned int)TE_US2MS(total), (unsigned int)TE_US2MS(critical));
+
+    /* Report each top-level subtree once summing up all its branches */
+    for (i = 0; i < plan->n_branches; i++)
+    {
+        const cfg_restore_branch   *branch = &plan->branches[i];
+        uint64_t                    time_us = 0;
+        unsigned int                n_insts = 0;
+
+        for (j = 0; j < i; j++)
+        {
+            if (strcmp(plan->branches[j].name, branch->name) == 0)
+                break;
+        }
+        if (j < i)
+            continue;
+
+        for (j = i; j < plan->n_branches; j++)
+        {
+            if (strcmp(plan->branches[j].name, branch->name) == 0)
+            {
+                time_us += plan->branches[j].time_us;
+                n_insts += plan->branches[j].n_insts;
+            }
+        }
+
+        INFO("Restore of %u instances of /%s took %u ms", n_insts,
+             branch->name, (unsigned int)TE_US2MS(time_us));
+    }
+}
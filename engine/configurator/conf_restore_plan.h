@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator
+ *
+ * Planner of restoring instances from a backup
+ *
+ * The planner builds a dependency graph of instances to be restored:
+ * an instance depends on its father and on instances of objects its
+ * object depends on (see cfg_dependency). Instances are split into
+ * waves: all instances of a wave depend on instances of previous waves
+ * only, so that they are independent. Inside a wave, instances are
+ * grouped into branches by the top-level subtree (i.e. by Test Agent).
+ * Instances of "unit" objects are restored together with their
+ * unit parts, so unit parts are planned as a part of the unit.
+ *
+ * Branches of a wave may be restored concurrently. Time spent on
+ * restoring of each branch is reported by the caller, so that time of
+ * the critical path (the slowest branch of each wave) and time spent
+ * on each top-level subtree can be logged.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_CONF_RESTORE_PLAN_H__
+#define __TE_CONF_RESTORE_PLAN_H__
+
+#include "te_errno.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Restore plan (opaque) */
+typedef struct cfg_restore_plan cfg_restore_plan;
+
+/** Branch of a wave: instances of one top-level subtree */
+typedef struct cfg_restore_branch {
+    char           *name;       /**< Top-level subtree, e.g.
+                                     "agent:Agt_A" */
+    cfg_instance  **insts;      /**< Instances in the order of the list
+                                     (including unit parts) */
+    unsigned int    n_insts;    /**< Number of instances */
+    uint64_t        time_us;    /**< Time spent on restoring; it should
+                                     be accumulated by the callback */
+} cfg_restore_branch;
+
+/**
+ * Callback restoring a wave of the plan.
+ *
+ * @param branches      Branches of the wave
+ * @param n_branches    Number of branches
+ * @param opaque        Opaque data
+ *
+ * @return Status code; restoring is stopped if it is not zero.
+ */
+typedef te_errno cfg_restore_plan_cb(cfg_restore_branch *branches,
+                                     unsigned int n_branches,
+                                     void *opaque);
+
+/**
+ * Build a plan of restoring instances. The list is reordered in the
+ * order of restoring: by waves and by branches inside each wave.
+ *
+ * @param list          Location of the list of instances linked by
+ *                      @a bkp_next with filled family links
+ * @param list_size     Number of instances in the list
+ * @param plan          Location for the plan
+ *
+ * @return Status code.
+ */
+extern te_errno cfg_restore_plan_build(cfg_instance **list,
+                                       unsigned int list_size,
+                                       cfg_restore_plan **plan);
+
+/**
+ * Release a plan. Instances are not released.
+ *
+ * @param plan          Plan (may be @c NULL)
+ */
+extern void cfg_restore_plan_free(cfg_restore_plan *plan);
+
+/**
+ * Call the callback for all waves of the plan one by one, measuring
+ * time spent on each wave. It may be called several times, then time
+ * is accumulated.
+ *
+ * @param plan          Plan
+ * @param cb            Callback
+ * @param opaque        Opaque data passed to @p cb
+ *
+ * @return Status code.
+ */
+extern te_errno cfg_restore_plan_run(cfg_restore_plan *plan,
+                                     cfg_restore_plan_cb *cb,
+                                     void *opaque);
+
+/**
+ * Log statistics of the plan: time of restoring, time of the critical
+ * path (sum of times of the slowest branch of each wave) and time spent
+ * on each top-level subtree.
+ *
+ * @param plan          Plan
+ */
+extern void cfg_restore_plan_report(const cfg_restore_plan *plan);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* !__TE_CONF_RESTORE_PLAN_H__ */
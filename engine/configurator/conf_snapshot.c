@@ -0,0 +1,379 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator
+ *
+ * In-memory snapshots of the configuration database
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#include "conf_defs.h"
+#include "te_alloc.h"
+#include "te_dbuf.h"
+#include "te_string.h"
+#include "conf_snapshot.h"
+
+/** Header of a serialized instance followed by OID and value strings */
+typedef struct cfg_snapshot_inst_hdr {
+    uint32_t    oid_len;    /**< Length of OID including '\0' */
+    uint32_t    val_len;    /**< Length of value including '\0' */
+} cfg_snapshot_inst_hdr;
+
+/** Snapshot of the configuration database */
+struct cfg_snapshot {
+    te_dbuf     objects;    /**< Serialized objects descriptions */
+    te_dbuf     instances;  /**< Serialized instances in backup order */
+    te_bool     marked;     /**< Whether the database version is marked */
+    uint64_t    version;    /**< Version of the database */
+};
+
+/**
+ * Serialize description of the object and its (grand-...)children
+ * which are saved to a backup file.
+ *
+ * @param buf       Buffer to append to
+ * @param obj       Object
+ *
+ * @return Status code.
+ */
+static te_errno
+snapshot_put_object(te_dbuf *buf, cfg_object *obj)
+{
+    te_errno rc;
+
+    if (obj != &cfg_obj_root && !cfg_object_agent(obj))
+    {
+        te_string       descr = TE_STRING_INIT;
+        cfg_dependency *dep;
+
+        te_string_append(&descr, "%s %d %d %d %s", obj->oid, obj->access,
+                         obj->type, obj->unit,
+                         obj->def_val == NULL ? "" : obj->def_val);
+        for (dep = obj->depends_on; dep != NULL; dep = dep->next)
+        {
+            te_string_append(&descr, " %s:%d", dep->depends->oid,
+                             dep->object_wide);
+        }
+
+        rc = te_dbuf_append(buf, descr.ptr, descr.len + 1);
+        te_string_free(&descr);
+        if (rc != 0)
+            return rc;
+    }
+
+    for (obj = obj->son; obj != NULL; obj = obj->brother)
+    {
+        rc = snapshot_put_object(buf, obj);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Check whether the instance belongs to the subtree. As in other places
+ * of backup processing, the subtree contains all instances whose OIDs
+ * start with the subtree OID.
+ *
+ * @param subtree   Subtree OID or @c NULL for the whole database
+ * @param oid       Instance identifier
+ *
+ * @return @c TRUE if the instance is in the subtree.
+ */
+static te_bool
+snapshot_oid_in_subtree(const char *subtree, const char *oid)
+{
+    return subtree == NULL || strcmp_start(subtree, oid) == 0;
+}
+
+/**
+ * Serialize the object instance and its (grand-...)children which
+ * are saved to a backup file.
+ *
+ * @param buf       Buffer to append to
+ * @param inst      Object instance
+ * @param subtree   Subtree OID to serialize or @c NULL for all
+ *                  instances
+ *
+ * @return Status code.
+ */
+static te_errno
+snapshot_put_instance(te_dbuf *buf, cfg_instance *inst,
+                      const char *subtree)
+{
+    te_errno rc;
+
+    if (inst != &cfg_inst_root && !snapshot_oid_in_subtree(subtree,
+                                                           inst->oid))
+    {
+        /* Descend only to instances which may contain the subtree */
+        if (strcmp_start(inst->oid, subtree) != 0)
+            return 0;
+    }
+    else if (inst != &cfg_inst_root && !cfg_inst_agent(inst) &&
+             !cfg_instance_volatile(inst))
+    {
+        cfg_snapshot_inst_hdr   hdr;
+        char                   *val_str = NULL;
+
+        if (inst->obj->type != CVT_NONE)
+        {
+            rc = cfg_types[inst->obj->type].val2str(inst->val, &val_str);
+            if (rc != 0)
+            {
+                ERROR("Conversion failed for instance %s type %d",
+                      inst->oid, inst->obj->type);
+                return rc;
+            }
+        }
+
+        hdr.oid_len = strlen(inst->oid) + 1;
+        hdr.val_len = (val_str == NULL ? 0 : strlen(val_str)) + 1;
+
+        if ((rc = te_dbuf_append(buf, &hdr, sizeof(hdr))) != 0 ||
+            (rc = te_dbuf_append(buf, inst->oid, hdr.oid_len)) != 0 ||
+            (rc = te_dbuf_append(buf, val_str == NULL ? "" : val_str,
+                                 hdr.val_len)) != 0)
+        {
+            free(val_str);
+            return rc;
+        }
+        free(val_str);
+    }
+
+    for (inst = inst->son; inst != NULL; inst = inst->brother)
+    {
+        rc = snapshot_put_instance(buf, inst, subtree);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Serialize the database without marking its version.
+ *
+ * @param subtrees      Vector of the subtrees to take or @c NULL
+ *                      for the whole database
+ * @param snapshot      Location for the snapshot
+ *
+ * @return Status code.
+ */
+static te_errno
+snapshot_build(const te_vec *subtrees, cfg_snapshot **snapshot)
+{
+    cfg_snapshot *snap;
+    te_errno      rc;
+
+    snap = TE_ALLOC(sizeof(*snap));
+    if (snap == NULL)
+        return TE_ENOMEM;
+
+    snap->objects = (te_dbuf)TE_DBUF_INIT(50);
+    snap->instances = (te_dbuf)TE_DBUF_INIT(50);
+
+    rc = snapshot_put_object(&snap->objects, &cfg_obj_root);
+    if (rc != 0)
+        goto fail;
+
+    if (subtrees != NULL && te_vec_size(subtrees) != 0)
+    {
+        char * const *subtree;
+
+        TE_VEC_FOREACH(subtrees, subtree)
+        {
+            rc = snapshot_put_instance(&snap->instances, &cfg_inst_root,
+                                       *subtree);
+            if (rc != 0)
+                goto fail;
+        }
+    }
+    else
+    {
+        rc = snapshot_put_instance(&snap->instances, &cfg_inst_root, NULL);
+        if (rc != 0)
+            goto fail;
+    }
+
+    *snapshot = snap;
+    return 0;
+
+fail:
+    cfg_snapshot_free(snap);
+    return TE_RC(TE_CS, rc);
+}
+
+/* See description in conf_snapshot.h */
+te_errno
+cfg_snapshot_create(const te_vec *subtrees, cfg_snapshot **snapshot)
+{
+    te_errno rc;
+
+    rc = snapshot_build(subtrees, snapshot);
+    if (rc != 0)
+        return rc;
+
+    /* Keep versions of instances to verify changes only */
+    if (cfg_db_version_mark(&(*snapshot)->version) == 0)
+        (*snapshot)->marked = TRUE;
+
+    return 0;
+}
+
+/* See description in conf_snapshot.h */
+void
+cfg_snapshot_free(cfg_snapshot *snapshot)
+{
+    if (snapshot == NULL)
+        return;
+
+    if (snapshot->marked)
+        cfg_db_version_unmark(snapshot->version);
+
+    te_dbuf_free(&snapshot->objects);
+    te_dbuf_free(&snapshot->instances);
+    free(snapshot);
+}
+
+/**
+ * Get the next instance from serialized instances.
+ *
+ * @param buf       Serialized instances
+ * @param off       Offset of the instance, updated to the offset
+ *                  of the next one
+ * @param oid       Location for the instance identifier
+ * @param val_str   Location for the instance value
+ *
+ * @return @c FALSE if there are no more instances.
+ */
+static te_bool
+snapshot_next_inst(const te_dbuf *buf, size_t *off, const char **oid,
+                   const char **val_str)
+{
+    cfg_snapshot_inst_hdr hdr;
+
+    if (*off + sizeof(hdr) > buf->len)
+        return FALSE;
+
+    memcpy(&hdr, buf->ptr + *off, sizeof(hdr));
+    *oid = (const char *)buf->ptr + *off + sizeof(hdr);
+    *val_str = *oid + hdr.oid_len;
+    *off += sizeof(hdr) + hdr.oid_len + hdr.val_len;
+
+    return TRUE;
+}
+
+/* See description in conf_snapshot.h */
+te_errno
+cfg_snapshot_foreach_inst(const cfg_snapshot *snapshot,
+                          const te_vec *subtrees,
+                          cfg_snapshot_inst_cb *cb, void *opaque)
+{
+    const char   *oid;
+    const char   *val_str;
+    size_t        off;
+    te_errno      rc;
+
+    if (subtrees == NULL || te_vec_size(subtrees) == 0)
+    {
+        for (off = 0;
+             snapshot_next_inst(&snapshot->instances, &off, &oid, &val_str);)
+        {
+            if ((rc = cb(oid, val_str, opaque)) != 0)
+                return rc;
+        }
+    }
+    else
+    {
+        char * const *subtree;
+
+        TE_VEC_FOREACH(subtrees, subtree)
+        {
+            for (off = 0;
+                 snapshot_next_inst(&snapshot->instances, &off,
+                                    &oid, &val_str);)
+            {
+                if (!snapshot_oid_in_subtree(*subtree, oid))
+                    continue;
+                if ((rc = cb(oid, val_str, opaque)) != 0)
+                    return rc;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/** Context of comparison of snapshot instances */
+typedef struct snapshot_cmp_ctx {
+    const te_dbuf  *cur;    /**< Serialized instances to compare with */
+    size_t          off;    /**< Offset of the next instance in @p cur */
+} snapshot_cmp_ctx;
+
+/** Compare the instance with the next one in the context */
+static te_errno
+snapshot_cmp_inst(const char *oid, const char *val_str, void *opaque)
+{
+    snapshot_cmp_ctx   *ctx = opaque;
+    const char         *cur_oid;
+    const char         *cur_val_str;
+
+    if (!snapshot_next_inst(ctx->cur, &ctx->off, &cur_oid, &cur_val_str))
+    {
+        VERB("Instance %s is missing", oid);
+        return TE_EBACKUP;
+    }
+
+    if (strcmp(oid, cur_oid) != 0 || strcmp(val_str, cur_val_str) != 0)
+    {
+        VERB("Instance %s = '%s' differs from %s = '%s'",
+             oid, val_str, cur_oid, cur_val_str);
+        return TE_EBACKUP;
+    }
+
+    return 0;
+}
+
+/* See description in conf_snapshot.h */
+te_errno
+cfg_snapshot_verify(const cfg_snapshot *snapshot, const te_vec *subtrees)
+{
+    cfg_snapshot       *cur = NULL;
+    snapshot_cmp_ctx    ctx;
+    te_errno            rc;
+
+    if (snapshot->marked)
+    {
+        rc = cfg_db_version_verify(snapshot->version, subtrees);
+        if (rc != TE_ENODATA)
+            return rc;
+    }
+
+    rc = snapshot_build(subtrees, &cur);
+    if (rc != 0)
+        return rc;
+
+    if (cur->objects.len != snapshot->objects.len ||
+        memcmp(cur->objects.ptr, snapshot->objects.ptr,
+               cur->objects.len) != 0)
+    {
+        VERB("Objects differ from the snapshot");
+        cfg_snapshot_free(cur);
+        return TE_EBACKUP;
+    }
+
+    ctx.cur = &cur->instances;
+    ctx.off = 0;
+    rc = cfg_snapshot_foreach_inst(snapshot, subtrees,
+                                   snapshot_cmp_inst, &ctx);
+    if (rc == 0 && ctx.off != cur->instances.len)
+    {
+        VERB("There are instances missing in the snapshot");
+        rc = TE_EBACKUP;
+    }
+
+    cfg_snapshot_free(cur);
+    return rc;
+}
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator
+ *
+ * In-memory snapshots of the configuration database
+ *
+ * A snapshot is a compact serialized copy of objects and non-volatile
+ * instances which are saved to backup files. As in backup files
+ * filtering, a subtree consists of instances whose OIDs start with
+ * the subtree OID. Snapshots are kept together
+ * with backups created by Configurator, so that backup verification
+ * and restoring do not require to write, filter and parse XML files.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_CONF_SNAPSHOT_H__
+#define __TE_CONF_SNAPSHOT_H__
+
+#include "te_errno.h"
+#include "te_vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Snapshot of the configuration database (opaque) */
+typedef struct cfg_snapshot cfg_snapshot;
+
+/**
+ * Callback for instances of a snapshot.
+ *
+ * @param oid           Instance identifier
+ * @param val_str       Instance value in string representation
+ *                      (empty string for instances without value)
+ * @param opaque        Opaque data
+ *
+ * @return Status code; iteration is stopped if it is not zero.
+ */
+typedef te_errno cfg_snapshot_inst_cb(const char *oid, const char *val_str,
+                                      void *opaque);
+
+/**
+ * Take a snapshot of the configuration database.
+ *
+ * @param subtrees      Vector of the subtrees to take or @c NULL
+ *                      for the whole database
+ * @param snapshot      Location for the snapshot
+ *
+ * @return Status code.
+ */
+extern te_errno cfg_snapshot_create(const te_vec *subtrees,
+                                    cfg_snapshot **snapshot);
+
+/**
+ * Release a snapshot.
+ *
+ * @param snapshot      Snapshot (may be @c NULL)
+ */
+extern void cfg_snapshot_free(cfg_snapshot *snapshot);
+
+/**
+ * Compare the configuration database with a snapshot of the whole
+ * database, as backup verification does.
+ *
+ * @param snapshot      Snapshot of the whole database
+ * @param subtrees      Vector of the subtrees to compare or @c NULL
+ *                      for the whole database
+ *
+ * @return Status code.
+ * @retval 0            The database matches the snapshot
+ * @retval TE_EBACKUP   The database differs from the snapshot
+ */
+extern te_errno cfg_snapshot_verify(const cfg_snapshot *snapshot,
+                                    const te_vec *subtrees);
+
+/**
+ * Iterate over instances of a snapshot in the order they are
+ * saved to a backup file.
+ *
+ * @param snapshot      Snapshot
+ * @param subtrees      Vector of the subtrees to iterate over or @c NULL
+ *                      for all instances
+ * @param cb            Callback
+ * @param opaque        Opaque data passed to @p cb
+ *
+ * @return Status code.
+ */
+extern te_errno cfg_snapshot_foreach_inst(const cfg_snapshot *snapshot,
+                                          const te_vec *subtrees,
+                                          cfg_snapshot_inst_cb *cb,
+                                          void *opaque);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* !__TE_CONF_SNAPSHOT_H__ */
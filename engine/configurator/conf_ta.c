@@ -6,12 +6,14 @@
  * TA interaction auxiliary routines
  */
 
-#include <search.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include "te_str.h"
 #include "conf_defs.h"
 #include "rcf_api.h"
-#include "te_queue.h"
 #include "te_alloc.h"
+#include "te_stopwatch.h"
+#include "cs_common.h"
 
 #define TA_LIST_SIZE    64
 
@@ -143,6 +145,7 @@ cfg_ta_add_agent_instances()
         else
             cfg_all_inst[i - 1]->brother = cfg_all_inst[i];
         cfg_all_inst[i]->father = &cfg_inst_root;
+        cfg_inst_link_son(&cfg_inst_root, cfg_all_inst[i]);
     }
     free(ta_list.list);
     return 0;
@@ -171,31 +174,143 @@ cfg_ta_reboot_all(void)
 
 static te_bool do_log_syncing = FALSE;
 
+/** Synchronize only instances changed on TAs if it is possible */
+static te_bool do_delta_syncing = FALSE;
+
 void
 cfg_ta_log_syncing(te_bool flag)
 {
     do_log_syncing = flag;
 }
 
+/* See description in conf_ta.h */
+void
+cfg_ta_delta_syncing(te_bool flag)
+{
+    do_delta_syncing = flag;
+}
+
+/** Generation of configuration changes synchronized with a TA */
+typedef struct sync_ta_gen {
+    struct sync_ta_gen *next;   /**< Next TA */
+    char               *ta;     /**< Test Agent name */
+    uint64_t            gen;    /**< Generation or 0 if unknown */
+} sync_ta_gen;
+
+/** Generations synchronized with TAs */
+static sync_ta_gen *sync_ta_gens = NULL;
+
 /**
- * Synchronize one object instance on the TA.
+ * Find generation of configuration changes synchronized with the TA.
  *
- * @param ta      Test Agent name
- * @param oid     object instance identifier
+ * @param ta        Test Agent name
+ *
+ * @return Generation or @c 0 if it is unknown.
+ */
+static uint64_t
+sync_ta_gen_get(const char *ta)
+{
+    sync_ta_gen *p;
+
+    for (p = sync_ta_gens; p != NULL; p = p->next)
+    {
+        if (strcmp(p->ta, ta) == 0)
+            return p->gen;
+    }
+
+    return 0;
+}
+
+/**
+ * Remember generation of configuration changes synchronized with the TA.
+ *
+ * @param ta        Test Agent name
+ * @param gen       Generation or @c 0 to forget it
+ */
+static void
+sync_ta_gen_set(const char *ta, uint64_t gen)
+{
+    sync_ta_gen *p;
+
+    for (p = sync_ta_gens; p != NULL; p = p->next)
+    {
+        if (strcmp(p->ta, ta) == 0)
+        {
+            p->gen = gen;
+            return;
+        }
+    }
+
+    if (gen == 0)
+        return;
+
+    p = TE_ALLOC(sizeof(*p));
+    if (p == NULL)
+        return;
+    p->ta = strdup(ta);
+    if (p->ta == NULL)
+    {
+        free(p);
+        return;
+    }
+    p->gen = gen;
+    p->next = sync_ta_gens;
+    sync_ta_gens = p;
+}
+
+/**
+ * Get value of an object instance from the TA growing the buffer
+ * if necessary.
+ *
+ * @param ta        Test Agent name
+ * @param oid       object instance identifier
+ * @param buf       location of the buffer
+ * @param buf_len   location of the buffer length
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+ta_cfg_get(const char *ta, const char *oid, char **buf, int *buf_len)
+{
+    te_errno  rc;
+    char     *new_buf;
+
+    while (TRUE)
+    {
+        rc = rcf_ta_cfg_get(ta, 0, oid, *buf, *buf_len);
+        if (TE_RC_GET_ERROR(rc) != TE_ESMALLBUF)
+            return rc;
+
+        new_buf = realloc(*buf, *buf_len << 1);
+        if (new_buf == NULL)
+        {
+            ERROR("Memory allocation failure");
+            return TE_ENOMEM;
+        }
+        *buf = new_buf;
+        *buf_len <<= 1;
+    }
+}
+
+/**
+ * Update object instance in the database according to the TA.
+ *
+ * @param ta        Test Agent name
+ * @param oid       object instance identifier
+ * @param obj       object of the instance
+ * @param get_rc    status of getting the instance value from the TA
+ * @param val_str   value got from the TA (unused for @c CVT_NONE objects)
  *
  * @return status code (see te_errno.h)
  */
 static int
-sync_ta_instance(const char *ta, const char *oid)
+sync_ta_instance_apply(const char *ta, const char *oid, cfg_object *obj,
+                       te_errno get_rc, char *val_str)
 {
-    cfg_object   *obj = cfg_get_object(oid);
     cfg_handle    handle = CFG_HANDLE_INVALID;
     cfg_inst_val  val;
     int           rc;
 
-    if (obj == NULL)
-        return 0;
-
     rc = cfg_db_find(oid, &handle);
     if (rc != 0 && TE_RC_GET_ERROR(rc) != TE_ENOENT)
         return rc;
@@ -221,33 +336,7 @@ sync_ta_instance(const char *ta, const char *oid)
         return rc;
     }
 
-    while (TRUE)
-    {
-        rc = rcf_ta_cfg_get(ta, 0, oid, cfg_get_buf, cfg_get_buf_len);
-        if (TE_RC_GET_ERROR(rc) == TE_ESMALLBUF)
-        {
-            cfg_get_buf_len <<= 1;
-
-            cfg_get_buf = (char *)realloc(cfg_get_buf, cfg_get_buf_len);
-            if (cfg_get_buf == NULL)
-            {
-                ERROR("Memory allocation failure");
-                return TE_ENOMEM;
-            }
-        }
-        else if (TE_RC_GET_ERROR(rc) == TE_ENOENT || rc == 0 ||
-                 (TE_RC_GET_ERROR(rc) == TE_ENOENT && obj->vol))
-        {
-            break;
-        }
-        else
-        {
-            ERROR("Failed(%r) to get '%s' from TA '%s'", rc, oid, ta);
-            return rc;
-        }
-    }
-
-    if (rc != 0)
+    if (get_rc != 0)
     {
         if (handle != CFG_HANDLE_INVALID)
             cfg_db_del(handle);
@@ -256,13 +345,13 @@ sync_ta_instance(const char *ta, const char *oid)
 
     if (do_log_syncing)
     {
-        RING("Syncing %s on %s -> %s", ta, oid, cfg_get_buf);
+        RING("Syncing %s on %s -> %s", ta, oid, val_str);
     }
 
-    if ((rc = cfg_types[obj->type].str2val(cfg_get_buf, &val)) != 0)
+    if ((rc = cfg_types[obj->type].str2val(val_str, &val)) != 0)
     {
         ERROR("Conversion of '%s' to value type %s(%d) for OID '%s' "
-                "failed", cfg_get_buf,
+                "failed", val_str,
                 te_enum_map_from_any_value(cfg_cvt_mapping, obj->type,
                                            "unknown type"),
                 obj->type, oid);
@@ -292,257 +381,648 @@ sync_ta_instance(const char *ta, const char *oid)
     return rc;
 }
 
-/* Remove entries, which do not mention in the list, from database */
-static void
-remove_excessive(cfg_instance *inst, char *list)
+/**
+ * Synchronize one object instance on the TA.
+ *
+ * @param ta      Test Agent name
+ * @param oid     object instance identifier
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+sync_ta_instance(const char *ta, const char *oid)
 {
-    cfg_instance *tmp;
-    cfg_instance *next;
-    int len = strlen(inst->oid);
-    char *s;
-
-    for (tmp = inst->son; tmp != NULL; tmp = next)
-    {
-        next = tmp->brother;
-        remove_excessive(tmp, list);
-    }
+    cfg_object *obj = cfg_get_object(oid);
+    te_errno    rc = 0;
 
-    if (cfg_inst_agent(inst))
-        return;
+    if (obj == NULL)
+        return 0;
 
-    for (s = strstr(list, inst->oid);
-         s != NULL;
-         s = strstr(s + 1, inst->oid))
+    if (obj->type != CVT_NONE)
     {
-        if (*(s + len) == ' ' || *(s + len) == 0)
-            break;
+        rc = ta_cfg_get(ta, oid, &cfg_get_buf, &cfg_get_buf_len);
+        if (rc != 0 && TE_RC_GET_ERROR(rc) != TE_ENOENT)
+        {
+            ERROR("Failed(%r) to get '%s' from TA '%s'", rc, oid, ta);
+            return rc;
+        }
     }
-    if (s == NULL)
-        cfg_db_del(inst->handle);
-}
 
-/* Element of OID queue */
-typedef struct oid_queue_entry_t {
-    TAILQ_ENTRY(oid_queue_entry_t) links;
-    char oid[CFG_OID_MAX];
-} oid_queue_entry_t;
+    return sync_ta_instance_apply(ta, oid, obj, rc, cfg_get_buf);
+}
 
-/* Head of OID queue */
-typedef TAILQ_HEAD(oid_queue_head_t, oid_queue_entry_t) oid_queue_head_t;
+/** Object instance got from the TA during subtree synchronization */
+typedef struct sync_ta_inst {
+    char        *oid;   /**< Instance identifier (points to the list) */
+    cfg_object  *obj;   /**< Object of the instance or @c NULL */
+    char        *val;   /**< Value got from the TA or @c NULL */
+    te_errno     rc;    /**< Status of getting the value */
+} sync_ta_inst;
 
-/*
- * TODO: get rid of this global variable once we stop support
- * of glibc earlier than 2.30 (released in 08.2019) for TE.
- * In glibc 2.30 twalk_r() was added which allows to pass user data
- * to action callback.
+/**
+ * Context of TA subtree synchronization.
  *
- * WARNING: here it is assumed that Configurator does not use
- * multithreading.
+ * Synchronization is done in two stages. Instances and their values
+ * are fetched from the TA first; it may be done in a separate thread,
+ * so that agents are queried concurrently. Then the database is
+ * updated in the main thread. The database must not be changed while
+ * fetching is in progress since objects are looked up by fetchers.
  */
-static oid_queue_head_t oid_queue = TAILQ_HEAD_INITIALIZER(oid_queue);
-
-/* Insert OID to queue */
-static void
-insert_entry(const char *oid, oid_queue_head_t *queue)
+typedef struct sync_ta_ctx {
+    const char     *ta;                 /**< Test Agent name */
+    char            oid[CFG_OID_MAX];   /**< Subtree root */
+    char           *list;               /**< Instances list got
+                                             from the TA */
+    sync_ta_inst   *insts;              /**< Instances sorted by OID */
+    unsigned int    n_insts;            /**< Number of instances */
+    te_errno        rc;                 /**< Status of fetching */
+    te_bool         track_gen;          /**< Track generation of
+                                             configuration changes */
+    uint64_t        since;              /**< Generation synchronized
+                                             before or @c 0 */
+    uint64_t        gen;                /**< Generation got from the TA
+                                             or @c 0 */
+    char          **roots;              /**< Roots of changed subtrees
+                                             if only changes are
+                                             fetched */
+    unsigned int    n_roots;            /**< Number of changed
+                                             subtrees */
+    char           *changes;            /**< Answer with changes */
+    struct timeval  fetch_time;         /**< Time spent on fetching */
+    pthread_t       thread;             /**< Fetching thread */
+    te_bool         threaded;           /**< Fetching thread is started */
+} sync_ta_ctx;
+
+/** Log synchronization timing */
+#define SYNC_TA_LOG_TIMING(_fmt...) \
+    do {                            \
+        if (do_log_syncing)         \
+            RING(_fmt);             \
+        else                        \
+            INFO(_fmt);             \
+    } while (0)
+
+/** Convert time interval to milliseconds */
+#define TV2MS(_tv) \
+    ((unsigned int)(TE_SEC2MS((_tv).tv_sec) + TE_US2MS((_tv).tv_usec)))
+
+/** Compare synchronized instances by OID */
+static int
+sync_ta_inst_compare(const void *pa, const void *pb)
 {
-    oid_queue_entry_t *new_elm;
-
-    new_elm = TE_ALLOC(sizeof(*new_elm));
-    if (new_elm == NULL)
-        TE_FATAL_ERROR("cannot allocate OID queue entry");
+    return strcmp(((const sync_ta_inst *)pa)->oid,
+                  ((const sync_ta_inst *)pb)->oid);
+}
 
-    te_strlcpy(new_elm->oid, oid, CFG_OID_MAX);
-    TAILQ_INSERT_TAIL(queue, new_elm, links);
+/** Compare OID with synchronized instance */
+static int
+sync_ta_inst_compare_oid(const void *key, const void *elm)
+{
+    return strcmp((const char *)key, ((const sync_ta_inst *)elm)->oid);
 }
 
-/* Remove and release all entries in OID queue */
-static inline void
-free_oid_queue(oid_queue_head_t *head)
+/**
+ * Split the list of instances got from the TA and sort it.
+ *
+ * @param ctx     synchronization context
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+sync_ta_subtree_parse(sync_ta_ctx *ctx)
 {
-    oid_queue_entry_t *cur;
-    oid_queue_entry_t *aux;
+    unsigned int  max_insts = 2;
+    unsigned int  i;
+    unsigned int  n;
+    char         *s;
+    char         *next;
+
+    for (s = ctx->list; (s = strchr(s, ' ')) != NULL; s++)
+        max_insts++;
+
+    ctx->insts = TE_ALLOC(max_insts * sizeof(*ctx->insts));
+    if (ctx->insts == NULL)
+        return TE_ENOMEM;
+
+    /* Changed subtrees roots are listed only if they exist */
+    if (ctx->roots == NULL)
+        ctx->insts[ctx->n_insts++].oid = ctx->oid;
+    for (s = ctx->list; *s != '\0'; s = next)
+    {
+        next = strchr(s, ' ');
+        if (next != NULL)
+            *next++ = '\0';
+        else
+            next = s + strlen(s);
+
+        if (*s != '\0')
+            ctx->insts[ctx->n_insts++].oid = s;
+    }
+
+    qsort(ctx->insts, ctx->n_insts, sizeof(*ctx->insts),
+          sync_ta_inst_compare);
 
-    TAILQ_FOREACH_SAFE(cur, head, links, aux)
+    /* Remove duplicates */
+    for (i = 1, n = 1; i < ctx->n_insts; i++)
     {
-        TAILQ_REMOVE(head, cur, links);
-        free(cur);
+        if (strcmp(ctx->insts[i].oid, ctx->insts[n - 1].oid) != 0)
+            ctx->insts[n++] = ctx->insts[i];
     }
+    ctx->n_insts = n;
+
+    return 0;
 }
 
-/* Comparison function for creating tree of OIDs */
+/** Compare strings for qsort() */
 static int
-oid_tree_compare(const void *pa, const void *pb)
+sync_ta_str_compare(const void *pa, const void *pb)
 {
-    return strcmp((char *)pa, (char *)pb);
+    return strcmp(*(char * const *)pa, *(char * const *)pb);
 }
 
-/* Callback to use with twalk() to fill sorted queue of OIDs */
+/**
+ * Get generation of the last configuration change from the TA.
+ *
+ * @param ctx       synchronization context
+ * @param buf       location of the buffer
+ * @param buf_len   location of the buffer length
+ */
 static void
-oid_tree_action(const void *elm, VISIT which, int depth)
+sync_ta_fetch_gen(sync_ta_ctx *ctx, char **buf, int *buf_len)
 {
-    UNUSED(depth);
+    char        gen_oid[CFG_OID_MAX];
+    uintmax_t   gen;
+
+    ctx->gen = 0;
 
-    switch (which)
+    TE_SPRINTF(gen_oid, "%s/" CS_CONF_GEN_SUBID ":", ctx->oid);
+    if (ta_cfg_get(ctx->ta, gen_oid, buf, buf_len) != 0)
     {
-        case preorder:
-            return;
-        case endorder:
-            return;
-        default:
-            break;
+        VERB("TA '%s' does not report configuration changes", ctx->ta);
+        return;
     }
 
-    insert_entry(*(char **)elm, &oid_queue);
+    if (te_strtoumax(*buf, 10, &gen) == 0)
+        ctx->gen = gen;
 }
 
-/* Dummy free function for tdestroy() */
-static void
-oid_tree_free(void *unused)
+/**
+ * Fetch list of instances in subtrees changed on the TA since
+ * the generation synchronized before.
+ *
+ * @param ctx       synchronization context
+ * @param buf       location of the buffer
+ * @param buf_len   location of the buffer length
+ *
+ * @return status code (see te_errno.h)
+ * @retval TE_ENODATA   changes are not known to the TA
+ */
+static te_errno
+sync_ta_subtree_fetch_changes(sync_ta_ctx *ctx, char **buf, int *buf_len)
 {
-    UNUSED(unused);
+    te_string       list = TE_STRING_INIT;
+    char            req[CFG_OID_MAX];
+    size_t          root_len = strlen(ctx->oid);
+    int             changes_len = TA_BUF_SIZE;
+    uintmax_t       gen;
+    char           *s;
+    char           *next;
+    unsigned int    max_roots = 1;
+    unsigned int    i;
+    unsigned int    n;
+    te_errno        rc;
+
+    ctx->changes = malloc(changes_len);
+    if (ctx->changes == NULL)
+        return TE_ENOMEM;
+
+    TE_SPRINTF(req, "%s/" CS_CONF_GEN_SUBID ":%" PRIu64 "/...",
+               ctx->oid, ctx->since);
+    rc = ta_cfg_get(ctx->ta, req, &ctx->changes, &changes_len);
+    if (rc != 0)
+        return TE_RC_GET_ERROR(rc) == TE_ENODATA ? TE_ENODATA : rc;
+
+    for (s = ctx->changes; (s = strchr(s, ' ')) != NULL; s++)
+        max_roots++;
+    ctx->roots = TE_ALLOC(max_roots * sizeof(*ctx->roots));
+    if (ctx->roots == NULL)
+        return TE_ENOMEM;
+
+    /* The first item is the current generation */
+    next = strchr(ctx->changes, ' ');
+    if (next != NULL)
+        *next++ = '\0';
+    if (te_strtoumax(ctx->changes, 10, &gen) != 0)
+        return TE_EINVAL;
+    ctx->gen = gen;
+
+    /*
+     * Synchronize whole subtrees of the agent children which contain
+     * changed instances, so that their fathers always exist.
+     */
+    for (s = next; s != NULL && *s != '\0'; s = next)
+    {
+        char *end;
+
+        next = strchr(s, ' ');
+        if (next != NULL)
+            *next++ = '\0';
+
+        if (strncmp(s, ctx->oid, root_len) != 0 || s[root_len] != '/')
+            return TE_EINVAL;
+        end = strchr(s + root_len + 1, '/');
+        if (end != NULL)
+            *end = '\0';
+
+        ctx->roots[ctx->n_roots++] = s;
+    }
+
+    qsort(ctx->roots, ctx->n_roots, sizeof(*ctx->roots),
+          sync_ta_str_compare);
+    for (i = 1, n = MIN(ctx->n_roots, 1); i < ctx->n_roots; i++)
+    {
+        if (strcmp(ctx->roots[i], ctx->roots[n - 1]) != 0)
+            ctx->roots[n++] = ctx->roots[i];
+    }
+    ctx->n_roots = n;
+
+    /* Make sure that the list is allocated even if nothing is changed */
+    te_string_append(&list, "%s", "");
+    for (i = 0; i < ctx->n_roots; i++)
+    {
+        TE_SPRINTF(req, "%s/...", ctx->roots[i]);
+        rc = ta_cfg_get(ctx->ta, req, buf, buf_len);
+        if (rc != 0)
+        {
+            ERROR("rcf_ta_cfg_get() failed: TA=%s, error=%r", ctx->ta, rc);
+            te_string_free(&list);
+            return rc;
+        }
+        te_string_append(&list, "%s ", *buf);
+    }
+
+    free(ctx->list);
+    te_string_move(&ctx->list, &list);
+
+    return 0;
 }
 
 /**
- * Synchronize tree of object instances on the TA.
+ * Fetch tree of object instances and their values from the TA.
+ * It does not modify the database.
  *
- * @param ta      Test Agent name
- * @param oid     root object instance identifier
+ * @param ctx     synchronization context
  *
  * @return status code (see te_errno.h)
  */
-static int
-sync_ta_subtree(const char *ta, const char *oid)
+static te_errno
+sync_ta_subtree_fetch(sync_ta_ctx *ctx)
 {
-    char  *tmp;
-    char  *next;
-    char  *limit;
-    char  *wildcard_oid;
-    int    rc;
-
-    void *oid_tree_root = NULL;
-    oid_queue_entry_t *entry = NULL;
-
-    cfg_handle *handles = NULL;
-    int         h_num;
-    int         i;
+    te_stopwatch_t  stopwatch = TE_STOPWATCH_INIT;
+    char            wildcard_oid[CFG_OID_MAX + sizeof("/...")];
+    int             list_len = TA_BUF_SIZE;
+    char           *val_buf = NULL;
+    int             val_len = TA_BUF_SIZE;
+    unsigned int    i;
+    te_errno        rc;
 
     if (do_log_syncing)
-        RING("Synchronize TA '%s' subtree '%s'", ta, oid);
+        RING("Synchronize TA '%s' subtree '%s'", ctx->ta, ctx->oid);
+
+    (void)te_stopwatch_start(&stopwatch);
 
     /* Take all instances from the TA */
-    if ((wildcard_oid = malloc(strlen(oid) + sizeof("/..."))) == NULL)
+    TE_SPRINTF(wildcard_oid, "%s/...", ctx->oid);
+
+    ctx->list = malloc(list_len);
+    val_buf = malloc(val_len);
+    if (ctx->list == NULL || val_buf == NULL)
     {
         ERROR("Out of memory");
+        free(val_buf);
         return TE_ENOMEM;
     }
-    sprintf(wildcard_oid, "%s/...", oid);
 
-    rc = rcf_ta_cfg_group(ta, 0, TRUE);
+    rc = rcf_ta_cfg_group(ctx->ta, 0, TRUE);
     if (rc != 0)
     {
-        ERROR("rcf_ta_cfg_group() failed");
-        free(wildcard_oid);
-        return TE_ENOMEM;
+        ERROR("rcf_ta_cfg_group() failed: TA=%s, error=%r", ctx->ta, rc);
+        free(val_buf);
+        return rc;
     }
 
-    cfg_get_buf[0] = 0;
-    while (TRUE)
+    if (ctx->track_gen && ctx->since != 0)
     {
-        rc = rcf_ta_cfg_get(ta, 0, wildcard_oid, cfg_get_buf,
-                            cfg_get_buf_len);
-        if (TE_RC_GET_ERROR(rc) == TE_ESMALLBUF)
+        rc = sync_ta_subtree_fetch_changes(ctx, &val_buf, &val_len);
+        if (rc != 0)
         {
-            cfg_get_buf_len <<= 1;
-
-            cfg_get_buf = (char *)realloc(cfg_get_buf, cfg_get_buf_len);
-            if (cfg_get_buf == NULL)
+            if (rc != TE_ENODATA)
             {
-                ERROR("Memory allocation failure");
-                rcf_ta_cfg_group(ta, 0, FALSE);
-                free(wildcard_oid);
-                return TE_ENOMEM;
+                WARN("Failed to get configuration changes from TA '%s', "
+                     "synchronize it completely: %r", ctx->ta, rc);
             }
+            free(ctx->roots);
+            ctx->roots = NULL;
+            ctx->n_roots = 0;
         }
-        else if (rc == 0)
-            break;
-        else
+    }
+
+    if (ctx->roots == NULL)
+    {
+        /*
+         * Generation is got before the list, so changes made meanwhile
+         * are fetched again next time.
+         */
+        if (ctx->track_gen)
+            sync_ta_fetch_gen(ctx, &val_buf, &val_len);
+
+        ctx->list[0] = '\0';
+        rc = ta_cfg_get(ctx->ta, wildcard_oid, &ctx->list, &list_len);
+        if (rc != 0)
         {
-            ERROR("rcf_ta_cfg_get() failed: TA=%s, error=%r", ta, rc);
-            rcf_ta_cfg_group(ta, 0, FALSE);
-            free(wildcard_oid);
-            return rc;
+            ERROR("rcf_ta_cfg_get() failed: TA=%s, error=%r", ctx->ta, rc);
+            goto exit;
         }
     }
-    free(wildcard_oid);
 
-    VERB("%s instances:\n%s", ta, cfg_get_buf);
+    VERB("%s instances:\n%s", ctx->ta, ctx->list);
 
-    rc = cfg_db_find_pattern(oid, (unsigned int *)&h_num, &handles);
+    rc = sync_ta_subtree_parse(ctx);
     if (rc != 0)
+        goto exit;
+
+    for (i = 0; i < ctx->n_insts; i++)
     {
-        rcf_ta_cfg_group(ta, 0, FALSE);
+        sync_ta_inst *inst = &ctx->insts[i];
+
+        inst->obj = cfg_get_object(inst->oid);
+        if (inst->obj == NULL || inst->obj->type == CVT_NONE)
+            continue;
+
+        inst->rc = ta_cfg_get(ctx->ta, inst->oid, &val_buf, &val_len);
+        if (inst->rc == 0)
+        {
+            inst->val = strdup(val_buf);
+            if (inst->val == NULL)
+            {
+                ERROR("Out of memory");
+                inst->rc = TE_ENOMEM;
+            }
+        }
+
+        if (inst->rc != 0 && TE_RC_GET_ERROR(inst->rc) != TE_ENOENT)
+        {
+            /*
+             * Instances preceding the failed one are still
+             * synchronized, the error is reported after that.
+             */
+            ERROR("Failed(%r) to get '%s' from TA '%s'",
+                  inst->rc, inst->oid, ctx->ta);
+            break;
+        }
+    }
+
+exit:
+    rcf_ta_cfg_group(ctx->ta, 0, FALSE);
+    free(val_buf);
+    (void)te_stopwatch_stop(&stopwatch, &ctx->fetch_time);
+
+    return rc;
+}
+
+/** Start routine of thread fetching a TA subtree */
+static void *
+sync_ta_subtree_thread(void *arg)
+{
+    sync_ta_ctx *ctx = arg;
+
+    ctx->rc = sync_ta_subtree_fetch(ctx);
+
+    return NULL;
+}
+
+/* Remove entries, which are not fetched from the TA, from database */
+static void
+remove_excessive(cfg_instance *inst, const sync_ta_ctx *ctx)
+{
+    cfg_instance *tmp;
+    cfg_instance *next;
+
+    for (tmp = inst->son; tmp != NULL; tmp = next)
+    {
+        next = tmp->brother;
+        remove_excessive(tmp, ctx);
+    }
+
+    if (cfg_inst_agent(inst))
+        return;
+
+    if (bsearch(inst->oid, ctx->insts, ctx->n_insts, sizeof(*ctx->insts),
+                sync_ta_inst_compare_oid) == NULL)
+        cfg_db_del(inst->handle);
+}
+
+/**
+ * Remove instances which are not fetched from the TA from
+ * the database subtree.
+ *
+ * @param ctx     synchronization context
+ * @param oid     root object instance identifier
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+remove_excessive_subtree(const sync_ta_ctx *ctx, const char *oid)
+{
+    cfg_handle     *handles = NULL;
+    unsigned int    h_num;
+    unsigned int    i;
+    te_errno        rc;
+
+    rc = cfg_db_find_pattern(oid, &h_num, &handles);
+    if (rc != 0)
         return rc;
+
+    for (i = 0; i < h_num; i++)
+        remove_excessive(CFG_GET_INST(handles[i]), ctx);
+    free(handles);
+
+    return 0;
+}
+
+/**
+ * Update the database according to the fetched TA subtree.
+ *
+ * @param ctx     synchronization context
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+sync_ta_subtree_apply(sync_ta_ctx *ctx)
+{
+    te_stopwatch_t  stopwatch = TE_STOPWATCH_INIT;
+    struct timeval  apply_time;
+    unsigned int    i;
+    te_errno        rc = 0;
+
+    if (ctx->rc != 0)
+    {
+        if (ctx->track_gen)
+            sync_ta_gen_set(ctx->ta, 0);
+        return ctx->rc;
     }
 
-    if (cfg_get_buf_len < (int)strlen(cfg_get_buf) + (int)strlen(oid) + 2)
+    (void)te_stopwatch_start(&stopwatch);
+
+    if (ctx->roots == NULL)
+        rc = remove_excessive_subtree(ctx, ctx->oid);
+    for (i = 0; i < ctx->n_roots && rc == 0; i++)
+        rc = remove_excessive_subtree(ctx, ctx->roots[i]);
+
+    for (i = 0; i < ctx->n_insts && rc == 0; i++)
     {
-        cfg_get_buf_len <<= 1;
+        sync_ta_inst *inst = &ctx->insts[i];
 
-        cfg_get_buf = (char *)realloc(cfg_get_buf, cfg_get_buf_len);
-        if (cfg_get_buf == NULL)
+        if (inst->rc != 0 && TE_RC_GET_ERROR(inst->rc) != TE_ENOENT)
         {
-            ERROR("Memory allocation failure");
-            rcf_ta_cfg_group(ta, 0, FALSE);
-            free(handles);
-            return TE_ENOMEM;
+            rc = inst->rc;
+            break;
         }
-    }
+        if (inst->obj == NULL)
+            continue;
 
-    limit = cfg_get_buf + strlen(cfg_get_buf);
-    sprintf(limit, " %s", oid);
+        rc = sync_ta_instance_apply(ctx->ta, inst->oid, inst->obj,
+                                    inst->rc, inst->val);
+        if (rc != 0)
+            break;
+    }
 
-    for (i = 0; i < h_num; i++)
-        remove_excessive(CFG_GET_INST(handles[i]), cfg_get_buf);
+    if (ctx->track_gen)
+        sync_ta_gen_set(ctx->ta, rc == 0 ? ctx->gen : 0);
 
-    /* Calculate number of OIDs to be synchronized */
-    for (tmp = cfg_get_buf; tmp < limit; tmp = next)
+    (void)te_stopwatch_stop(&stopwatch, &apply_time);
+    if (ctx->roots != NULL)
     {
-        void *tree_entry;
+        SYNC_TA_LOG_TIMING("TA '%s' %u changed subtrees with %u instances "
+                           "are synchronized: fetch %u ms, update %u ms",
+                           ctx->ta, ctx->n_roots, ctx->n_insts,
+                           TV2MS(ctx->fetch_time), TV2MS(apply_time));
+    }
+    else
+    {
+        SYNC_TA_LOG_TIMING("TA '%s' subtree '%s' with %u instances is "
+                           "synchronized: fetch %u ms, update %u ms",
+                           ctx->ta, ctx->oid, ctx->n_insts,
+                           TV2MS(ctx->fetch_time), TV2MS(apply_time));
+    }
 
-        next = strchr(tmp, ' ');
-        if (next != NULL)
-            *next++ = 0;
-        else
-            next = limit;
+    return rc;
+}
+
+/** Release resources of TA subtree synchronization context */
+static void
+sync_ta_subtree_free(sync_ta_ctx *ctx)
+{
+    unsigned int i;
+
+    for (i = 0; i < ctx->n_insts; i++)
+        free(ctx->insts[i].val);
+    free(ctx->insts);
+    free(ctx->list);
+    free(ctx->roots);
+    free(ctx->changes);
+}
 
-        tree_entry = tsearch(tmp, &oid_tree_root, oid_tree_compare);
-        if (tree_entry == NULL)
+/**
+ * Synchronize trees of object instances on several TAs. Subtrees are
+ * fetched from TAs concurrently, one thread per TA, and the database
+ * is updated in order of contexts.
+ *
+ * @param ctxs    synchronization contexts
+ * @param n_ctxs  number of contexts
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+sync_ta_subtrees(sync_ta_ctx *ctxs, unsigned int n_ctxs)
+{
+    te_stopwatch_t  stopwatch = TE_STOPWATCH_INIT;
+    struct timeval  sync_time;
+    unsigned int    i;
+    te_errno        rc = 0;
+    int             ret;
+
+    (void)te_stopwatch_start(&stopwatch);
+
+    /* Only changes may be fetched if the whole agent is synchronized */
+    for (i = 0; do_delta_syncing && i < n_ctxs; i++)
+    {
+        if (strchr(ctxs[i].oid + strlen(CFG_TA_PREFIX), '/') == NULL)
         {
-            ERROR("%s(): failed to add OID to a search tree",
-                  __FUNCTION__);
-            tdestroy(oid_tree_root, oid_tree_free);
-            free(handles);
-            rcf_ta_cfg_group(ta, 0, FALSE);
-            return rc;
+            ctxs[i].track_gen = TRUE;
+            ctxs[i].since = sync_ta_gen_get(ctxs[i].ta);
         }
     }
 
-    twalk(oid_tree_root, oid_tree_action);
-    TAILQ_FOREACH(entry, &oid_queue, links)
+    for (i = 0; n_ctxs > 1 && i < n_ctxs; i++)
     {
-        if ((rc = sync_ta_instance(ta, entry->oid)) != 0)
-            break;
+        ret = pthread_create(&ctxs[i].thread, NULL,
+                             sync_ta_subtree_thread, &ctxs[i]);
+        if (ret != 0)
+        {
+            WARN("Failed to create thread to synchronize TA '%s': %r",
+                 ctxs[i].ta, TE_OS_RC(TE_CS, ret));
+            continue;
+        }
+        ctxs[i].threaded = TRUE;
     }
 
-    rcf_ta_cfg_group(ta, 0, FALSE);
+    for (i = 0; i < n_ctxs; i++)
+    {
+        if (ctxs[i].threaded)
+            pthread_join(ctxs[i].thread, NULL);
+        else
+            ctxs[i].rc = sync_ta_subtree_fetch(&ctxs[i]);
+    }
 
-    tdestroy(oid_tree_root, oid_tree_free);
-    free_oid_queue(&oid_queue);
-    free(handles);
+    for (i = 0; i < n_ctxs; i++)
+    {
+        if (rc == 0)
+            rc = sync_ta_subtree_apply(&ctxs[i]);
+        sync_ta_subtree_free(&ctxs[i]);
+    }
+
+    (void)te_stopwatch_stop(&stopwatch, &sync_time);
+    if (n_ctxs > 1)
+    {
+        SYNC_TA_LOG_TIMING("%u TAs are synchronized in %u ms",
+                           n_ctxs, TV2MS(sync_time));
+    }
 
     return rc;
 }
 
+/**
+ * Synchronize tree of object instances on the TA.
+ *
+ * @param ta      Test Agent name
+ * @param oid     root object instance identifier
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+sync_ta_subtree(const char *ta, const char *oid)
+{
+    sync_ta_ctx ctx;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.ta = ta;
+    if (te_strlcpy(ctx.oid, oid, sizeof(ctx.oid)) >= sizeof(ctx.oid))
+        return TE_ENAMETOOLONG;
+
+    return sync_ta_subtrees(&ctx, 1);
+}
+
 /**
  * Synchronize object instances tree with Test Agents.
  *
@@ -574,18 +1054,36 @@ cfg_ta_sync(char *oid, te_bool subtree)
 
     if (tmp_oid->len == 1 || strcmp_start(CFG_TA_PREFIX"*", oid) == 0)
     {
+        sync_ta_ctx    *ctxs;
+        unsigned int    n_tas = 0;
+
         for (ta = ta_list.list;
              ta < ta_list.list + ta_list.list_size;
              ta += strlen(ta) + 1)
         {
-            char agent_oid[CFG_OID_MAX];
+            n_tas++;
+        }
 
-            TE_SPRINTF(agent_oid, CFG_TA_PREFIX"%s%s", ta,
+        ctxs = TE_ALLOC(MAX(n_tas, 1) * sizeof(*ctxs));
+        if (ctxs == NULL)
+        {
+            cfg_free_oid(tmp_oid);
+            free(ta_list.list);
+            return TE_ENOMEM;
+        }
+
+        for (ta = ta_list.list, n_tas = 0;
+             ta < ta_list.list + ta_list.list_size;
+             ta += strlen(ta) + 1, n_tas++)
+        {
+            ctxs[n_tas].ta = ta;
+            TE_SPRINTF(ctxs[n_tas].oid, CFG_TA_PREFIX"%s%s", ta,
                        tmp_oid->len == 1 ? "" :
                        oid + strlen(CFG_TA_PREFIX"*"));
-            if ((rc = sync_ta_subtree(ta, agent_oid)) != 0)
-                break;
         }
+
+        rc = sync_ta_subtrees(ctxs, n_tas);
+        free(ctxs);
     }
     else /** Here an exact agent is used in 'oid' */
     {
@@ -712,6 +1210,72 @@ cfg_ta_sync_dependants(cfg_instance *inst, te_bool no_children)
     return 0;
 }
 
+/**
+ * Check whether the instance should not be committed to Test Agent.
+ *
+ * @param inst  - object instance
+ *
+ * @return TRUE if the instance is skipped
+ */
+static te_bool
+cfg_ta_commit_skip(const cfg_instance *inst)
+{
+    cfg_object *obj = inst->obj;
+
+    if ((inst->added && obj->type == CVT_NONE && !inst->remove) ||
+        (obj->access != CFG_READ_WRITE && obj->access != CFG_READ_CREATE))
+    {
+        VERB("Skip object with type %d(%d) and access %d(%d,%d)",
+                obj->type, CVT_NONE,
+                obj->access, CFG_READ_WRITE, CFG_READ_CREATE);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Get value of the instance to be committed in string representation.
+ *
+ * @param inst      - object instance
+ * @param val_str   - location for the value (NULL for instances
+ *                    without value)
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+cfg_ta_commit_val_str(const cfg_instance *inst, char **val_str)
+{
+    cfg_object     *obj = inst->obj;
+    cfg_inst_val    val;
+    int             rc;
+
+    *val_str = NULL;
+    if (obj->type == CVT_NONE)
+        return 0;
+
+    /* Get value from Configurator DB */
+    rc = cfg_db_get(inst->handle, &val);
+    if (rc != 0)
+    {
+        ERROR("Failed to get object instance '%s' value", inst->oid);
+        return rc;
+    }
+
+    /* Convert got value to string */
+    rc = cfg_types[obj->type].val2str(val, val_str);
+    /* Free memory allocated for value in any case */
+    cfg_types[obj->type].free(val);
+    /* Check conversion return code */
+    if (rc != 0)
+    {
+        VERB("Failed to convert object instance '%s' value of type %d "
+             "to string", inst->oid, obj->type);
+    }
+
+    return rc;
+}
+
 /**
  * Commit local changes in Configurator database to Test Agent.
  *
@@ -725,44 +1289,21 @@ cfg_ta_commit_instance(const char *ta, cfg_instance *inst)
 {
     int             rc;
     cfg_object     *obj = inst->obj;
-    cfg_inst_val    val;
     char           *val_str = NULL;
 
     ENTRY("ta=%s inst=0x%X", ta, inst);
     VERB("Commit to '%s' instance '%s'", ta, inst->oid);
-    if ((inst->added && obj->type == CVT_NONE && !inst->remove) ||
-        (obj->access != CFG_READ_WRITE && obj->access != CFG_READ_CREATE))
+    if (cfg_ta_commit_skip(inst))
     {
-        VERB("Skip object with type %d(%d) and access %d(%d,%d)",
-                obj->type, CVT_NONE,
-                obj->access, CFG_READ_WRITE, CFG_READ_CREATE);
         EXIT("0");
         return 0;
     }
 
-    if (obj->type != CVT_NONE)
+    rc = cfg_ta_commit_val_str(inst, &val_str);
+    if (rc != 0)
     {
-        /* Get value from Configurator DB */
-        rc = cfg_db_get(inst->handle, &val);
-        if (rc != 0)
-        {
-            ERROR("Failed to get object instance '%s' value", inst->oid);
-            EXIT("%r", rc);
-            return rc;
-        }
-
-        /* Convert got value to string */
-        rc = cfg_types[obj->type].val2str(val, &val_str);
-        /* Free memory allocated for value in any case */
-        cfg_types[obj->type].free(val);
-        /* Check conversion return code */
-        if (rc != 0)
-        {
-            VERB("Failed to convert object instance '%s' value of type %d "
-                 "to string", inst->oid, obj->type);
-            EXIT("%r", rc);
-            return rc;
-        }
+        EXIT("%r", rc);
+        return rc;
     }
 
     if (inst->remove)
@@ -779,77 +1320,218 @@ cfg_ta_commit_instance(const char *ta, cfg_instance *inst)
     }
     else
     {
-        if (!inst->added && obj->access == CFG_READ_CREATE)
-        {
-            /*
-             * We need to add a new instance to the Test Agent -
-             * postponed add operation.
-             */
-            if ((rc = rcf_ta_cfg_add(ta, 0, inst->oid, val_str)) != 0)
-            {
-                ERROR("Cannot add '%s' with value '%s' via RCF, rc = %r",
-                      inst->oid, val_str, rc);
-            }
-        }
-        else
+        if (!inst->added && obj->access == CFG_READ_CREATE)
+        {
+            /*
+             * We need to add a new instance to the Test Agent -
+             * postponed add operation.
+             */
+            if ((rc = rcf_ta_cfg_add(ta, 0, inst->oid, val_str)) != 0)
+            {
+                ERROR("Cannot add '%s' with value '%s' via RCF, rc = %r",
+                      inst->oid, val_str, rc);
+            }
+        }
+        else
+        {
+            assert(obj->type != CVT_NONE);
+
+            if ((rc = rcf_ta_cfg_set(ta, 0, inst->oid, val_str)) != 0)
+            {
+                ERROR("Failed to set '%s' to value '%s' via RCF, rc = %r",
+                      inst->oid, val_str, rc);
+            }
+        }
+        if (rc == 0)
+        {
+            inst->added = TRUE;
+        }
+    }
+
+    free(val_str);
+
+    EXIT("%r", rc);
+    return rc;
+}
+
+/** Local changes to be committed to Test Agent by one RCF command */
+typedef struct cfg_ta_batch {
+    te_vec  items;  /**< Batch items (rcf_cfg_batch_item) */
+    te_vec  insts;  /**< Instances of the items (cfg_instance *) */
+} cfg_ta_batch;
+
+/** Initializer of an empty batch */
+#define CFG_TA_BATCH_INIT \
+    { TE_VEC_INIT(rcf_cfg_batch_item), TE_VEC_INIT(cfg_instance *) }
+
+/**
+ * Release the batch.
+ *
+ * @param batch - batch of changes
+ */
+static void
+cfg_ta_batch_free(cfg_ta_batch *batch)
+{
+    rcf_cfg_batch_item *item;
+
+    TE_VEC_FOREACH(&batch->items, item)
+        free((char *)item->val);
+
+    te_vec_free(&batch->items);
+    te_vec_free(&batch->insts);
+}
+
+/**
+ * Add local change of the instance to the batch.
+ *
+ * @param batch - batch of changes
+ * @param inst  - object instance
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+cfg_ta_batch_add(cfg_ta_batch *batch, cfg_instance *inst)
+{
+    rcf_cfg_batch_item  item;
+    char               *val_str;
+    int                 rc;
+
+    if (cfg_ta_commit_skip(inst))
+        return 0;
+
+    rc = cfg_ta_commit_val_str(inst, &val_str);
+    if (rc != 0)
+        return rc;
+
+    item.oid = inst->oid;
+    item.val = val_str;
+    item.rc = 0;
+    if (inst->remove)
+    {
+        item.op = RCF_CFG_BATCH_DEL;
+    }
+    else if (!inst->added && inst->obj->access == CFG_READ_CREATE)
+    {
+        item.op = RCF_CFG_BATCH_ADD;
+    }
+    else
+    {
+        assert(inst->obj->type != CVT_NONE);
+        item.op = RCF_CFG_BATCH_SET;
+    }
+
+    if ((rc = TE_VEC_APPEND(&batch->items, item)) != 0)
+    {
+        free(val_str);
+        return rc;
+    }
+    if ((rc = TE_VEC_APPEND(&batch->insts, inst)) != 0)
+    {
+        te_vec_remove_index(&batch->items,
+                            te_vec_size(&batch->items) - 1);
+        free(val_str);
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Apply results of successfully committed items of the batch to local
+ * Configurator database.
+ *
+ * @param batch - batch of changes sent to Test Agent
+ */
+static void
+cfg_ta_batch_apply(cfg_ta_batch *batch)
+{
+    unsigned int    n_items = te_vec_size(&batch->items);
+    unsigned int    i;
+
+    for (i = 0; i < n_items; i++)
+    {
+        rcf_cfg_batch_item *item = te_vec_get(&batch->items, i);
+        cfg_instance       *inst = TE_VEC_GET(cfg_instance *,
+                                              &batch->insts, i);
+
+        if (item->rc != 0)
         {
-            assert(obj->type != CVT_NONE);
+            if (TE_RC_GET_ERROR(item->rc) == TE_ECANCELED)
+                break;
 
-            if ((rc = rcf_ta_cfg_set(ta, 0, inst->oid, val_str)) != 0)
-            {
+            if (item->op == RCF_CFG_BATCH_DEL)
+                ERROR("Cannot del '%s' via RCF, rc = %r",
+                      item->oid, item->rc);
+            else if (item->op == RCF_CFG_BATCH_ADD)
+                ERROR("Cannot add '%s' with value '%s' via RCF, rc = %r",
+                      item->oid, item->val, item->rc);
+            else
                 ERROR("Failed to set '%s' to value '%s' via RCF, rc = %r",
-                      inst->oid, val_str, rc);
-            }
+                      item->oid, item->val, item->rc);
+            continue;
         }
-        if (rc == 0)
-        {
+
+        if (item->op == RCF_CFG_BATCH_DEL)
+            cfg_db_del(inst->handle);
+        else
             inst->added = TRUE;
-        }
     }
+}
 
-    free(val_str);
+/**
+ * Commit the batch of changes to Test Agent and apply results of
+ * successfully committed items to local Configurator database.
+ *
+ * @param ta    - Test Agent name
+ * @param batch - batch of changes
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+cfg_ta_batch_commit(const char *ta, cfg_ta_batch *batch)
+{
+    unsigned int    n_items = te_vec_size(&batch->items);
+    int             rc;
+
+    if (n_items == 0)
+        return 0;
+
+    rc = rcf_ta_cfg_batch(ta, 0, te_vec_get(&batch->items, 0), n_items);
+    if (rc == TE_RC(TE_RCF_API, TE_EOPNOTSUPP))
+        return rc;
+
+    cfg_ta_batch_apply(batch);
 
-    EXIT("%r", rc);
     return rc;
 }
 
 /**
- * Commit changes in local Configurator database to the Test Agent.
+ * Walk the commit subtree and commit local changes of each instance
+ * to the Test Agent or add them to the batch.
  *
- * @param ta    - Test Agent name
- * @param inst  - object instance of the commit subtree root
+ * @param ta        - Test Agent name
+ * @param inst      - object instance of the commit subtree root
+ * @param batch     - batch to add changes to or NULL to commit
+ *                    changes immediately
+ * @param need_sync - location for flag whether the subtree should be
+ *                    synchronized after commit
  *
  * @return status code (see te_errno.h)
  */
 static int
-cfg_ta_commit(const char *ta, cfg_instance *inst)
+cfg_ta_commit_walk(const char *ta, cfg_instance *inst, cfg_ta_batch *batch,
+                   te_bool *need_sync)
 {
-    int           rc, ret = 0;
+    int           rc;
     cfg_instance *commit_root;
     cfg_instance *p;
     te_bool       forward;
-    te_bool       need_sync = FALSE;
 
     cfg_instance *father;
     cfg_instance *son;
     cfg_instance *brother;
     te_bool       is_commit_root;
 
-    assert(ta != NULL);
-    assert(inst != NULL);
-
-    ENTRY("ta=%s inst=0x%X", ta, inst);
-    VERB("Commit to TA '%s' start at '%s'", ta, inst->oid);
-
-    rc = rcf_ta_cfg_group(ta, 0, TRUE);
-    if (rc != 0)
-    {
-        ERROR("Failed(%r) to start group on TA '%s'", rc, ta);
-        EXIT("%r", rc);
-        ret = rc;
-        goto handle_result;
-    }
-
     for (commit_root = inst, p = inst, forward = TRUE; p != NULL; )
     {
         father = p->father;
@@ -865,17 +1547,17 @@ cfg_ta_commit(const char *ta, cfg_instance *inst)
              */
             if ((!p->added && p->obj->access == CFG_READ_CREATE) ||
                 p->remove)
-                need_sync = TRUE;
+                *need_sync = TRUE;
 
             if (p->remove)
                 son = NULL;
 
-            rc = cfg_ta_commit_instance(ta, p);
+            rc = (batch != NULL) ? cfg_ta_batch_add(batch, p) :
+                                   cfg_ta_commit_instance(ta, p);
             if (rc != 0)
             {
                 ERROR("Failed(%r) to commit '%s'", rc, p->oid);
-                ret = rc;
-                break;
+                return rc;
             }
         }
 
@@ -902,6 +1584,35 @@ cfg_ta_commit(const char *ta, cfg_instance *inst)
         }
     }
 
+    return 0;
+}
+
+/**
+ * Commit changes in local Configurator database to the Test Agent
+ * one by one in a group of configuration commands.
+ *
+ * @param ta        - Test Agent name
+ * @param inst      - object instance of the commit subtree root
+ * @param need_sync - location for flag whether the subtree should be
+ *                    synchronized after commit
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+cfg_ta_commit_group(const char *ta, cfg_instance *inst, te_bool *need_sync)
+{
+    int rc;
+    int ret;
+
+    rc = rcf_ta_cfg_group(ta, 0, TRUE);
+    if (rc != 0)
+    {
+        ERROR("Failed(%r) to start group on TA '%s'", rc, ta);
+        return rc;
+    }
+
+    ret = cfg_ta_commit_walk(ta, inst, NULL, need_sync);
+
     rc = rcf_ta_cfg_group(ta, 0, FALSE);
     if (rc != 0)
     {
@@ -910,6 +1621,43 @@ cfg_ta_commit(const char *ta, cfg_instance *inst)
             ret = rc;
     }
 
+    return ret;
+}
+
+/**
+ * Commit changes in local Configurator database to the Test Agent.
+ * All changes are sent in one batch if the Test Agent supports it.
+ *
+ * @param ta    - Test Agent name
+ * @param inst  - object instance of the commit subtree root
+ *
+ * @return status code (see te_errno.h)
+ */
+static int
+cfg_ta_commit(const char *ta, cfg_instance *inst)
+{
+    int           rc, ret = 0;
+    te_bool       need_sync = FALSE;
+    cfg_ta_batch  batch = CFG_TA_BATCH_INIT;
+
+    assert(ta != NULL);
+    assert(inst != NULL);
+
+    ENTRY("ta=%s inst=0x%X", ta, inst);
+    VERB("Commit to TA '%s' start at '%s'", ta, inst->oid);
+
+    ret = cfg_ta_commit_walk(ta, inst, &batch, &need_sync);
+    if (ret == 0)
+        ret = cfg_ta_batch_commit(ta, &batch);
+    cfg_ta_batch_free(&batch);
+
+    if (ret == TE_RC(TE_RCF_API, TE_EOPNOTSUPP))
+    {
+        VERB("TA '%s' does not support configuration batches", ta);
+        need_sync = FALSE;
+        ret = cfg_ta_commit_group(ta, inst, &need_sync);
+    }
+
     if (ret == 0 && need_sync)
     {
         if ((rc = sync_ta_subtree(ta, inst->oid)) != 0)
@@ -923,8 +1671,6 @@ cfg_ta_commit(const char *ta, cfg_instance *inst)
     VERB("Commit to TA '%s' end %r - %s", ta, ret,
          (ret == 0) ? "success" : "failed");
 
-handle_result:
-
     if (ret == 0 && local_cmd_seq)
     {
         /* Call DH function to tell that local operations are commit */
@@ -1016,35 +1762,311 @@ cfg_tas_commit(const char *oid)
 
     if (local_cmd_seq)
     {
-        local_cmd_seq = FALSE;
-
         if (rc == 0)
-        {
-            /* Save configuration changes */
-            cfg_dh_release_backup(local_cmd_bkp);
             cfg_conf_delay_update(inst->oid);
+
+        cfg_ta_local_cmd_seq_end(rc);
+    }
+
+    EXIT("%r", rc);
+    return rc;
+}
+
+/* See description in conf_ta.h */
+void
+cfg_ta_local_cmd_seq_end(te_errno rc)
+{
+    if (!local_cmd_seq)
+        return;
+
+    local_cmd_seq = FALSE;
+
+    if (rc == 0)
+    {
+        /* Save configuration changes */
+        cfg_dh_release_backup(local_cmd_bkp);
+    }
+    else
+    {
+        int ret;
+
+        /* Restore configuration before the first local SET/ADD/DEL */
+        ret = cfg_dh_restore_backup(local_cmd_bkp, FALSE);
+        WARN("Restore backup to configuration which was before "
+             "the first local ADD/DEL/SET commands restored with "
+             "code %r", ret);
+
+        /*
+         * Detach backup file from dynamic history as it will never
+         * be used again.
+         */
+        cfg_dh_release_backup(local_cmd_bkp);
+    }
+    free(local_cmd_bkp);
+    local_cmd_bkp = NULL;
+}
+
+/** Context of committing local changes to a Test Agent by one batch */
+typedef struct cfg_ta_commit_ctx {
+    cfg_ta_commit_req  *req;        /**< Commit request */
+    cfg_ta_batch        batch;      /**< Batch of changes */
+    sync_ta_ctx        *syncs;      /**< Subtrees to be synchronized
+                                         after commit */
+    unsigned int        n_syncs;    /**< Number of subtrees */
+    te_errno            rc;         /**< Status of sending the batch */
+    pthread_t           thread;     /**< Sending thread */
+    te_bool             threaded;   /**< Sending thread is started */
+} cfg_ta_commit_ctx;
+
+/**
+ * Collect local changes of the commit request into the batch.
+ * Subtrees of instances of "unit" objects are committed entirely,
+ * other instances are committed alone.
+ *
+ * @param ctx       - commit context
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+cfg_ta_commit_prepare(cfg_ta_commit_ctx *ctx)
+{
+    cfg_ta_commit_req  *req = ctx->req;
+    unsigned int        i;
+    te_errno            rc;
+
+    ctx->syncs = TE_ALLOC(sizeof(*ctx->syncs) * (req->n_insts + 1));
+    if (ctx->syncs == NULL)
+        return TE_ENOMEM;
+
+    for (i = 0; i < req->n_insts; i++)
+    {
+        cfg_instance   *inst = req->insts[i];
+        te_bool         need_sync = FALSE;
+        sync_ta_ctx    *sync;
+
+        if (inst->obj->unit)
+        {
+            rc = cfg_ta_commit_walk(req->ta, inst, &ctx->batch, &need_sync);
         }
         else
         {
-            int ret;
+            need_sync = (!inst->added &&
+                         inst->obj->access == CFG_READ_CREATE) ||
+                        inst->remove;
+            rc = cfg_ta_batch_add(&ctx->batch, inst);
+        }
+        if (rc != 0)
+        {
+            ERROR("Failed(%r) to commit '%s'", rc, inst->oid);
+            return rc;
+        }
+
+        if (!need_sync)
+            continue;
+
+        sync = &ctx->syncs[ctx->n_syncs++];
+        sync->ta = req->ta;
+        if (te_strlcpy(sync->oid, inst->oid,
+                       sizeof(sync->oid)) >= sizeof(sync->oid))
+            return TE_ENAMETOOLONG;
+    }
+
+    return 0;
+}
+
+/**
+ * Send the batch of the commit context to the Test Agent and fetch
+ * subtrees to be synchronized. It does not modify the database, so it
+ * may be done in a separate thread.
+ *
+ * @param ctx       - commit context
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+cfg_ta_commit_send(cfg_ta_commit_ctx *ctx)
+{
+    te_stopwatch_t  stopwatch = TE_STOPWATCH_INIT;
+    struct timeval  send_time;
+    unsigned int    n_items = te_vec_size(&ctx->batch.items);
+    unsigned int    i;
+    te_errno        rc = 0;
+
+    (void)te_stopwatch_start(&stopwatch);
+
+    if (n_items > 0)
+    {
+        rc = rcf_ta_cfg_batch(ctx->req->ta, 0,
+                              te_vec_get(&ctx->batch.items, 0), n_items);
+    }
+
+    for (i = 0; rc == 0 && i < ctx->n_syncs; i++)
+        ctx->syncs[i].rc = sync_ta_subtree_fetch(&ctx->syncs[i]);
+
+    (void)te_stopwatch_stop(&stopwatch, &send_time);
+    ctx->req->time_us = TE_SEC2US(send_time.tv_sec) + send_time.tv_usec;
+
+    return rc;
+}
+
+/** Start routine of thread committing changes to a TA */
+static void *
+cfg_ta_commit_thread(void *arg)
+{
+    cfg_ta_commit_ctx *ctx = arg;
+
+    ctx->rc = cfg_ta_commit_send(ctx);
+
+    return NULL;
+}
+
+/**
+ * Apply results of the commit to the database in the main thread.
+ * Changes are committed one by one in a group of configuration commands
+ * if the Test Agent does not support batches.
+ *
+ * @param ctx       - commit context
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+cfg_ta_commit_finish(cfg_ta_commit_ctx *ctx)
+{
+    cfg_ta_commit_req  *req = ctx->req;
+    unsigned int        i;
+    te_errno            rc = ctx->rc;
+
+    if (rc == TE_RC(TE_RCF_API, TE_EOPNOTSUPP))
+    {
+        VERB("TA '%s' does not support configuration batches", req->ta);
+        for (i = 0, rc = 0; i < req->n_insts && rc == 0; i++)
+        {
+            cfg_instance   *inst = req->insts[i];
+            te_bool         need_sync;
+
+            if (inst->obj->unit)
+            {
+                rc = cfg_ta_commit(req->ta, inst);
+                continue;
+            }
+
+            need_sync = (!inst->added &&
+                         inst->obj->access == CFG_READ_CREATE) ||
+                        inst->remove;
+            rc = cfg_ta_commit_instance(req->ta, inst);
+            if (rc == 0 && need_sync)
+                rc = sync_ta_subtree(req->ta, inst->oid);
+        }
+
+        return rc;
+    }
+
+    cfg_ta_batch_apply(&ctx->batch);
+    if (rc != 0)
+        return rc;
+
+    for (i = 0; i < ctx->n_syncs && rc == 0; i++)
+    {
+        rc = sync_ta_subtree_apply(&ctx->syncs[i]);
+        if (rc != 0)
+        {
+            ERROR("Failed(%r) to synchronize %s instance", rc,
+                  ctx->syncs[i].oid);
+        }
+    }
+
+    return rc;
+}
+
+/* See description in conf_ta.h */
+te_errno
+cfg_tas_commit_concurrently(cfg_ta_commit_req *reqs, unsigned int n_reqs)
+{
+    cfg_ta_commit_ctx  *ctxs;
+    unsigned int        i;
+    unsigned int        j;
+    te_errno            rc = 0;
+    int                 ret;
+
+    ctxs = TE_ALLOC(sizeof(*ctxs) * (n_reqs + 1));
+    if (ctxs == NULL)
+    {
+        cfg_ta_local_cmd_seq_end(TE_ENOMEM);
+        return TE_ENOMEM;
+    }
+
+    for (i = 0; i < n_reqs; i++)
+    {
+        ctxs[i].req = &reqs[i];
+        ctxs[i].batch = (cfg_ta_batch)CFG_TA_BATCH_INIT;
+        reqs[i].time_us = 0;
+        if (rc == 0)
+            rc = cfg_ta_commit_prepare(&ctxs[i]);
+    }
+
+    if (rc == 0)
+    {
+        for (i = 0; n_reqs > 1 && i < n_reqs; i++)
+        {
+            ret = pthread_create(&ctxs[i].thread, NULL,
+                                 cfg_ta_commit_thread, &ctxs[i]);
+            if (ret != 0)
+            {
+                WARN("Failed to create thread to commit to TA '%s': %r",
+                     reqs[i].ta, TE_OS_RC(TE_CS, ret));
+                continue;
+            }
+            ctxs[i].threaded = TRUE;
+        }
+
+        for (i = 0; i < n_reqs; i++)
+        {
+            if (ctxs[i].threaded)
+                pthread_join(ctxs[i].thread, NULL);
+            else
+                ctxs[i].rc = cfg_ta_commit_send(&ctxs[i]);
+
+            SYNC_TA_LOG_TIMING("TA '%s': %u changes are committed in %u ms",
+                               reqs[i].ta,
+                               (unsigned int)te_vec_size(&ctxs[i].batch.items),
+                               (unsigned int)TE_US2MS(reqs[i].time_us));
+        }
+
+        for (i = 0; i < n_reqs; i++)
+        {
+            te_errno req_rc = cfg_ta_commit_finish(&ctxs[i]);
 
-            /* Restore configuration before the first local SET/ADD/DEL */
-            ret = cfg_dh_restore_backup(local_cmd_bkp, FALSE);
-            WARN("Restore backup to configuration which was before "
-                 "the first local ADD/DEL/SET commands restored with "
-                 "code %r", ret);
+            if (req_rc == 0)
+            {
+                for (j = 0; j < reqs[i].n_insts; j++)
+                    cfg_conf_delay_update(reqs[i].insts[j]->oid);
+            }
+            else if (rc == 0)
+            {
+                rc = req_rc;
+            }
 
             /*
-             * Detach backup file from dynamic history as it will never
-             * be used again.
+             * Changes committed to the TA are rolled back together with
+             * other local changes if commit to another TA fails.
              */
-            cfg_dh_release_backup(local_cmd_bkp);
+            for (j = 0; req_rc == 0 && local_cmd_seq &&
+                        j < reqs[i].n_insts; j++)
+                cfg_dh_apply_commit(reqs[i].insts[j]->oid);
         }
-        free(local_cmd_bkp);
-        local_cmd_bkp = NULL;
     }
 
-    EXIT("%r", rc);
+    for (i = 0; i < n_reqs; i++)
+    {
+        for (j = 0; j < ctxs[i].n_syncs; j++)
+            sync_ta_subtree_free(&ctxs[i].syncs[j]);
+        free(ctxs[i].syncs);
+        cfg_ta_batch_free(&ctxs[i].batch);
+    }
+    free(ctxs);
+
+    cfg_ta_local_cmd_seq_end(rc);
+
     return rc;
 }
 
@@ -93,6 +93,41 @@ extern int cfg_ta_add_agent_instances(void);
  */
 extern int cfg_tas_commit(const char *oid);
 
+/** Local changes to be committed to a Test Agent by one batch */
+typedef struct cfg_ta_commit_req {
+    const char     *ta;         /**< Test Agent name */
+    cfg_instance  **insts;      /**< Changed instances in the database;
+                                     subtrees of instances of "unit"
+                                     objects are committed entirely */
+    unsigned int    n_insts;    /**< Number of instances */
+    uint64_t        time_us;    /**< Time spent on sending the batch
+                                     and synchronization (output) */
+} cfg_ta_commit_req;
+
+/**
+ * Commit local changes to several Test Agents concurrently. Changes of
+ * each Test Agent are sent by one batch from a separate thread, then
+ * the database is updated in the main thread. The local commands
+ * sequence is finished: configuration is restored to the state before
+ * the first local command if commit to any Test Agent fails.
+ *
+ * @param reqs      - commit requests, one per Test Agent
+ * @param n_reqs    - number of requests
+ *
+ * @return status code (see te_errno.h)
+ */
+extern te_errno cfg_tas_commit_concurrently(cfg_ta_commit_req *reqs,
+                                            unsigned int n_reqs);
+
+/**
+ * Finish the local commands sequence if it is started.
+ *
+ * @param rc        - status of commit of local changes; if it is not
+ *                    zero, configuration is restored to the state
+ *                    before the first local command
+ */
+extern void cfg_ta_local_cmd_seq_end(te_errno rc);
+
 /**
  * Synchronize dependant nodes.
  *
@@ -114,6 +149,18 @@ extern int cfg_ta_sync_dependants(cfg_instance *inst,
  */
 extern void cfg_ta_log_syncing(te_bool flag);
 
+/**
+ * Toggles incremental synchronization of Test Agents. If it is enabled,
+ * only subtrees containing instances changed since the previous
+ * synchronization are fetched when a whole agent is synchronized and
+ * the agent reports configuration changes. Changes made on the agent
+ * bypassing configure commands (e.g. side effects of RPC calls) are
+ * not noticed in this mode unless the agent reports them.
+ *
+ * @param flag Is incremental synchronization enabled
+ */
+extern void cfg_ta_delta_syncing(te_bool flag);
+
 /**
  * Perform check whether local commands sequence is started or not.
  * If started then set msg @a _cfg_msg rc to TE_EACCES and return from the
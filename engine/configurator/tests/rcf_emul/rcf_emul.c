@@ -112,6 +112,8 @@ get_handler(rcf_op_t opcode)
             return current_handler_conf->conf_grp_start;
         case RCFOP_CONFGRP_END:
             return current_handler_conf->conf_grp_end;
+        case RCFOP_CONFBATCH:
+            return current_handler_conf->conf_batch;
         default:
             return NULL;
     }
@@ -222,6 +224,16 @@ process_user_request(usrreq *req)
 #endif
 
     handler = get_handler(msg->opcode);
+    if (handler == NULL && msg->opcode == RCFOP_CONFBATCH)
+    {
+        /*
+         * Answer as an agent which does not support batches, so that
+         * Configurator commits changes one by one via handlers.
+         */
+        msg->num = -1;
+        msg->error = TE_RC(TE_RCF_PCH, TE_EFMT);
+        goto answer;
+    }
     if (handler == NULL)
     {
         ERROR("No handler is set for %s type of request",
@@ -338,6 +350,24 @@ process_user_request(usrreq *req)
                 msg->error = rc;
             }
             break;
+        case RCFOP_CONFBATCH:
+        {
+            unsigned int done = 0;
+
+            rc = ((rcfrh_conf_batch) handler)(msg->ta,
+                                              msg->file,
+                                              msg->num,
+                                              &done);
+            if (rc != 0)
+            {
+                ERROR("Failed to apply configuration batch, %u of %d "
+                      "items are applied", done, msg->num);
+                msg->error = TE_RC(TE_RCF_PCH, rc);
+            }
+            msg->num = done;
+            msg->data_len = 0;
+            break;
+        }
         default:
             ERROR("ERROR, opcode is not supported");
             msg->error = TE_EINVAL;
@@ -414,6 +444,9 @@ rcfrh_set_default_handler(rcf_op_t opcode, request_handler *conf)
         case RCFOP_CONFGRP_END:
             conf->conf_grp_end = &rcfrh_conf_grp_end_default;
             break;
+        case RCFOP_CONFBATCH:
+            conf->conf_batch = &rcfrh_conf_batch_default;
+            break;
         default:
             VERB("Wrong opcode passed to the "
                  "rcfrh_set_default_handler() function");
@@ -442,6 +475,7 @@ rcfrh_set_default_handlers(int conf_id)
     rcfrh_set_default_handler(RCFOP_CONFDEL, handler_conf[conf_id]);
     rcfrh_set_default_handler(RCFOP_CONFGRP_START, handler_conf[conf_id]);
     rcfrh_set_default_handler(RCFOP_CONFGRP_END, handler_conf[conf_id]);
+    rcfrh_set_default_handler(RCFOP_CONFBATCH, handler_conf[conf_id]);
     return 0;
 }
 
@@ -726,6 +760,89 @@ rcfrh_conf_grp_end_default(char *ta_name, char *grp_name)
         return TE_EINVAL;
 }
 
+/**
+ * Conf batch default request handler.
+ */
+int
+rcfrh_conf_batch_default(char *ta_name, char *file, unsigned int n_items,
+                         unsigned int *done)
+{
+    char    *buf;
+    char    *ptr;
+    char    *end;
+    char    *oid;
+    char    *val;
+    long     len;
+    FILE    *f;
+    int      rc = 0;
+
+    *done = 0;
+
+    if (rcfrh_is_agent(ta_name) <= 0)
+        return TE_EINVAL;
+
+    if ((f = fopen(file, "r")) == NULL)
+        return TE_ENOENT;
+
+    if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < 0 ||
+        fseek(f, 0, SEEK_SET) != 0 ||
+        (buf = malloc(len + 1)) == NULL)
+    {
+        fclose(f);
+        return TE_EFMT;
+    }
+
+    if (fread(buf, 1, len, f) != (size_t)len)
+    {
+        free(buf);
+        fclose(f);
+        return TE_EFMT;
+    }
+    fclose(f);
+    buf[len] = '\0';
+    end = buf + len;
+
+    /* Each item is operation, OID and value, both zero-terminated */
+    for (ptr = buf; *done < n_items; (*done)++)
+    {
+        oid = ptr + 1;
+        if (oid >= end || (val = memchr(oid, '\0', end - oid)) == NULL ||
+            ++val >= end || memchr(val, '\0', end - val) == NULL)
+        {
+            rc = TE_EFMT;
+            break;
+        }
+
+        switch (*ptr)
+        {
+            case TE_PROTO_CONFBATCH_SET:
+                rc = db_set_inst(oid, val);
+                break;
+
+            case TE_PROTO_CONFBATCH_ADD:
+                rc = (strchr(oid, ':') == NULL) ? db_add_object(oid) :
+                                                  db_add_instance(oid, val);
+                rc = (rc < 0) ? -rc : 0;
+                break;
+
+            case TE_PROTO_CONFBATCH_DEL:
+                rc = db_del(oid);
+                break;
+
+            default:
+                rc = TE_EFMT;
+                break;
+        }
+        if (rc != 0)
+            break;
+
+        ptr = val + strlen(val) + 1;
+    }
+
+    free(buf);
+    return rc;
+}
+
 /**
  * Creates the configuration.
  */
@@ -49,6 +49,7 @@
 #include "ipc_server.h"
 #include "rcf_common.h"
 #include "rcf_internal.h"
+#include "te_proto.h"
 #include "rcf_api.h"
 
 #include "../db/db.h"
@@ -203,6 +204,21 @@ typedef int (* rcfrh_conf_grp_start)(char *ta_name, char *grp_name);
  */
 typedef int (* rcfrh_conf_grp_end)(char *ta_name, char *grp_name);
 
+/**
+ * Conf batch request handler.
+ *
+ * @param ta_name       Name of the agent on which this request should
+ *                      be handled.
+ * @param file          Name of the file with batch items in the format
+ *                      of the binary attachment of the command.
+ * @param n_items       Number of items in the batch.
+ * @param done          Number of applied items. (OUT)
+ *
+ * @return              0 - if all items are applied.
+ */
+typedef int (* rcfrh_conf_batch)(char *ta_name, char *file,
+                                 unsigned int n_items, unsigned int *done);
+
 /**
  * Configuration structure. It describes configuration
  * of the request handlers on the RCF emulator.
@@ -218,6 +234,10 @@ typedef struct reqest_handlers
     rcfrh_conf_del        conf_del;        /**< Conf del request handler */
     rcfrh_conf_grp_start  conf_grp_start;  /**< Conf group start         */
     rcfrh_conf_grp_end    conf_grp_end;    /**< Conf group end           */
+    rcfrh_conf_batch      conf_batch;      /**< Conf batch request handler
+                                                or NULL to answer as an
+                                                agent which does not
+                                                support batches */
 } request_handler;
 
 /** Configuration of the RCF emulator request handlers */
@@ -365,6 +385,26 @@ extern int rcfrh_conf_grp_start_default(char *ta_name, char *grp_name);
  */
 extern int rcfrh_conf_grp_end_default(char *ta_name, char *grp_name);
 
+/**
+ * Conf batch default request handler. Items are applied to the
+ * database one by one until the first failure.
+ *
+ * @param ta_name   Name of the agent on which the batch should be
+ *                  applied. By default there is only one agent with
+ *                  name Agt_T.
+ * @param file      Name of the file with batch items.
+ * @param n_items   Number of items in the batch.
+ * @param done      Number of applied items. (OUT)
+ *
+ * @return          0 - if all items are applied
+ * @retval          TE_EINVAL - ta_name is not Agt_T
+ * @retval          TE_EFMT - malformed batch
+ * @retval          other - error of the failed item
+ */
+extern int rcfrh_conf_batch_default(char *ta_name, char *file,
+                                    unsigned int n_items,
+                                    unsigned int *done);
+
 /**
  * Function create request handlers configuration.
  *
@@ -443,6 +483,9 @@ extern int rcfrh_configuration_set_current(int conf_id);
             case RCFOP_CONFGRP_END:                               \
                 conf_->conf_grp_start = &handler_;                \
                 break;                                            \
+            case RCFOP_CONFBATCH:                                 \
+                conf_->conf_batch = &handler_;                    \
+                break;                                            \
             default:                                              \
                 VERB("Wrong opcode passed");                      \
         }                                                         \
@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator Tester
+ *
+ * Commit of local changes in one configuration batch: applied items
+ * are accounted, items not applied due to RCF failure are committed
+ * again later.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define LOG_LEVEL 0xff
+#define TE_LOG_LEVEL 0xff
+
+#include "test.h"
+#include "../paths.c"
+
+#define RC(expr_) \
+    do {                                                \
+        int rc_ = 0;                                    \
+                                                        \
+        rc_ = (expr_);                                  \
+        if (rc_ != 0)                                   \
+        {                                               \
+            printf("%s returned %d\n", # expr_, rc_);   \
+            goto cleanup;                               \
+        }                                               \
+    } while (0)
+
+/** Number of batches processed by the emulator */
+static unsigned int batches = 0;
+
+/**
+ * Conf batch request handler which counts batches and applies them
+ * by default handler.
+ */
+static int
+batch_count(char *ta_name, char *file, unsigned int n_items,
+            unsigned int *done)
+{
+    batches++;
+    return rcfrh_conf_batch_default(ta_name, file, n_items, done);
+}
+
+/**
+ * Conf batch request handler which fails the batch as RCF does when
+ * the agent is dead: the number of requested items is left in
+ * the answer.
+ */
+static int
+batch_ta_dead(char *ta_name, char *file, unsigned int n_items,
+              unsigned int *done)
+{
+    UNUSED(ta_name);
+    UNUSED(file);
+
+    *done = n_items;
+    return TE_RC(TE_RCF, TE_ETADEAD);
+}
+
+int
+main(void)
+{
+    COMMON_TEST_PARAMS;
+    int                     conf;
+    request_handler        *handlers;
+    char                   *val = NULL;
+
+    te_log_init("batch", te_log_message_file);
+
+    EXPORT_ENV;
+
+    START_LOGGER("logger.conf");
+    START_RCF_EMULATOR("config.db");
+    RCFRH_CONFIGURATION_CREATE(conf);
+    RCFRH_SET_DEFAULT_HANDLERS(conf);
+    handlers = rcf_get_cfg_by_id(conf);
+    handlers->conf_batch = batch_count;
+    RCFRH_CONFIGURATION_SET_CURRENT(conf);
+
+    START_CONFIGURATOR("test.conf");
+
+    /* Changes of the subtree are committed in one batch */
+    RC(cfg_add_instance_local_fmt(NULL, CFG_VAL(STRING, "gw1"),
+                                  "/agent:Agt_T/route:r1"));
+    RC(cfg_set_instance_local_fmt(CFG_VAL(INTEGER, 1400),
+                                  "/agent:Agt_T/interface:eth0/mtu:"));
+    RC(cfg_commit_fmt("/agent:Agt_T"));
+    if (batches != 1)
+    {
+        printf("%u batches are committed instead of 1\n", batches);
+        goto cleanup;
+    }
+
+    RC(cfg_get_instance_string_fmt(&val, "/agent:Agt_T/route:r1"));
+    if (strcmp(val, "gw1") != 0)
+    {
+        printf("Unexpected value of committed route: %s\n", val);
+        goto cleanup;
+    }
+
+    /* Nothing is applied if RCF fails the batch */
+    handlers->conf_batch = batch_ta_dead;
+    RC(cfg_add_instance_local_fmt(NULL, CFG_VAL(STRING, "gw2"),
+                                  "/agent:Agt_T/route:r2"));
+    if (cfg_commit_fmt("/agent:Agt_T") == 0)
+    {
+        printf("Commit succeeded with dead agent\n");
+        goto cleanup;
+    }
+
+    /* The instance is still to be added rather than to be set */
+    handlers->conf_batch = batch_count;
+    RC(cfg_commit_fmt("/agent:Agt_T"));
+
+    free(val);
+    val = NULL;
+    RC(cfg_get_instance_string_fmt(&val, "/agent:Agt_T/route:r2"));
+    if (strcmp(val, "gw2") != 0)
+    {
+        printf("Unexpected value of route added again: %s\n", val);
+        goto cleanup;
+    }
+
+    CONFIGURATOR_TEST_SUCCESS;
+cleanup:
+    free(val);
+    STOP_CONFIGURATOR;
+    STOP_RCF_EMULATOR;
+    STOP_LOGGER;
+
+    CONFIGURATOR_TEST_END;
+}
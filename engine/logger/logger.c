@@ -35,6 +35,8 @@
 #include "logger_ten.h"
 #include "logger_listener.h"
 #include "logger_stream.h"
+#include "logger_writer.h"
+#include "logger_ta_stream.h"
 
 #define LGR_TA_MAX_BUF      0x4000 /* FIXME */
 
@@ -46,9 +48,6 @@
 
 #define SET_MSEC(_poll) ((_poll) % 1000000)
 
-/* Raw log file length checking period */
-#define RAW_FILE_CHECK_PERIOD 100
-
 /* Finished TA checking period */
 #define TA_FINISH_CHECK_PERIOD 50
 
@@ -62,10 +61,6 @@ snif_polling_sets_t snifp_sets;
 /* Path to the directory for logs */
 const char *te_log_dir = NULL;
 
-/* Raw log file */
-static FILE    *raw_file = NULL;
-/* Mutex protecting raw log file */
-static pthread_mutex_t raw_file_mutex = PTHREAD_MUTEX_INITIALIZER;
 /* Raw log file location */
 static char    *te_log_raw = NULL;
 
@@ -78,8 +73,10 @@ static int64_t raw_log_max_size = (1LLU << 32);
 /* Is the raw log file length bigger than raw_log_max_size */
 static te_bool  raw_log_too_big = FALSE;
 
-/* raw log file check counter */
-static int      raw_file_check_cnt = 0;
+/* Maximum time (in milliseconds) a message is kept before it is stored */
+static int      raw_log_flush_interval = LGR_WRITER_FLUSH_INTERVAL_DEF;
+/* Size of a batch of messages stored in the raw log at once */
+static int      raw_log_batch_size = LGR_WRITER_BATCH_SIZE_DEF;
 
 /** Logger PID */
 static pid_t    pid;
@@ -95,6 +92,8 @@ static unsigned int         lgr_flags = 0;
                                          with RCF */
 #define LOGGER_CHECK        0x04    /**< Check messages before store in
                                          raw log file */
+#define LOGGER_NO_TA_STREAM 0x08    /**< Poll Test Agents instead of
+                                         receiving pushed log */
 #define LOGGER_SHUTDOWN     0x10    /**< Logger is shuting down */
 /*@}*/
 
@@ -102,6 +101,8 @@ static unsigned int         lgr_flags = 0;
 #define LOGGER_OPT_LISTENER    1    /**< Force a listener to be enabled */
 #define LOGGER_OPT_METAFILE    2    /**< Path to the meta.json file */
 #define LOGGER_OPT_MAXSIZE     3    /**< Maximum length of the RAW log */
+#define LOGGER_OPT_FLUSH_INT   4    /**< Raw log flush interval */
+#define LOGGER_OPT_BATCH_SIZE  5    /**< Raw log batch size */
 /*@}*/
 
 static const char          *cfg_file = NULL;
@@ -182,14 +183,21 @@ append_err_message(const char *fmt, ...)
     }
     else
     {
-        pthread_mutex_lock(&raw_file_mutex);
-
-        if (fwrite(data.buf, data.ptr - data.buf, 1, raw_file) != 1)
-            perror("fwrite() failure");
-        if (fflush(raw_file) != 0)
-            perror("fflush(raw_file) failed");
+        refcnt_buffer msg;
 
-        pthread_mutex_unlock(&raw_file_mutex);
+        /* Ownership over the message data is transferred to the buffer */
+        rc = refcnt_buffer_init(&msg, data.buf, data.ptr - data.buf);
+        if (rc == 0)
+        {
+            data.buf = NULL;
+            rc = lgr_writer_post(&msg, TRUE);
+            refcnt_buffer_free(&msg);
+        }
+        if (rc != 0)
+        {
+            fprintf(stderr, "%s(): failed to store log message: %s\n",
+                    __FUNCTION__, te_rc_err2str(rc));
+        }
     }
 
     free(data.buf);
@@ -205,53 +213,52 @@ append_err_message(const char *fmt, ...)
 void
 lgr_register_message(const void *buf, size_t len)
 {
-    struct stat            raw_file_stat;
+    refcnt_buffer          msg;
     te_errno               rc;
 
     if (((lgr_flags & LOGGER_CHECK) && !lgr_message_valid(buf, len)))
         return;
 
+    if (!listeners_enabled && raw_log_too_big)
+        return;
+
+    /* The same copy of the message is shared by listeners and writer */
+    rc = refcnt_buffer_init_copy(&msg, buf, len);
+    if (rc != 0)
+    {
+        fputs("Failed to copy log message: No memory\n", stderr);
+        return;
+    }
+
     if (listeners_enabled)
     {
-        rc = msg_queue_post(&listener_queue, buf, len);
+        rc = msg_queue_post_buffer(&listener_queue, &msg);
         if (rc == TE_ENOMEM)
             fputs("Failed to post message to the listener queue: No memory",
                   stderr);
     }
 
-    if (raw_log_too_big)
-        return;
-
-    if (raw_log_max_size >= 0 && raw_file_check_cnt-- <= 0)
+    if (!raw_log_too_big)
     {
-        raw_file_check_cnt = RAW_FILE_CHECK_PERIOD;
-        rc = stat(te_log_raw, &raw_file_stat);
-        if (rc < 0)
-        {
-            ERROR("FATAL ERROR: raw log file '%s' stat() failure: "
-                  "errno=%d", te_log_raw, errno);
-            return;
-        }
+        rc = lgr_writer_post(&msg, FALSE);
         /* RAW log is too big now, ignore new messages */
-        if (raw_file_stat.st_size > (off64_t)raw_log_max_size)
+        if (rc == TE_EFBIG &&
+            !__atomic_exchange_n(&raw_log_too_big, TRUE, __ATOMIC_RELAXED))
         {
-            raw_log_too_big = TRUE;
-
             fprintf(stderr, "\nRAW LOG HAS REACHED SIZE LIMIT, ALL THE "
                     "NEXT MESSAGES WILL BE LOST\n");
             append_err_message("Raw log has reached limit of %llu bytes, "
                                "new log messages are ignored and lost now",
                                (long long unsigned)raw_log_max_size);
-            return;
+        }
+        else if (rc != 0 && rc != TE_EFBIG)
+        {
+            fprintf(stderr, "Failed to post message to the raw log "
+                    "writer: %s\n", te_rc_err2str(rc));
         }
     }
 
-    pthread_mutex_lock(&raw_file_mutex);
-    if (fwrite(buf, len, 1, raw_file) != 1)
-        perror("fwrite() failure");
-    if (fflush(raw_file) != 0)
-        perror("fflush(raw_file) failed");
-    pthread_mutex_unlock(&raw_file_mutex);
+    refcnt_buffer_free(&msg);
 }
 
 static pthread_mutex_t add_remove_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -513,6 +520,10 @@ ta_flush_done(struct ipc_server *srv)
         ERROR("FATAL ERROR: Failed to read flush request: %r", rc);
         return rc;
     }
+
+    /* Flushed messages must be in the raw log when requester is replied */
+    lgr_writer_flush();
+
     rc = ipc_send_answer(srv, ipcsc_p, buf, len);
     if (rc != 0)
     {
@@ -525,10 +536,428 @@ ta_flush_done(struct ipc_server *srv)
 }
 
 
+/** State of TA log flush operation */
+typedef struct ta_flush_state {
+    te_bool         do_flush;   /**< Flush is in progress */
+    te_bool         flush_done; /**< Flush is done, requester is not
+                                     replied yet */
+    unsigned int    msg_max;    /**< Number of messages which may be
+                                     obtained before flush is
+                                     interrupted */
+    struct timeval  ts;         /**< Time stamp when flush has been
+                                     started */
+} ta_flush_state;
+
+/**
+ * Check whether RCF error means that TA is temporarily unavailable.
+ *
+ * @param rc        Error returned by RCF API
+ *
+ * @return @c TRUE if TA may become available later.
+ */
+static te_bool
+ta_unavailable(te_errno rc)
+{
+    return /* RCF request to TA is timed out */
+           rc == TE_RC(TE_RCF, TE_ETIMEDOUT) ||
+           /* TA has been rebooted */
+           rc == TE_RC(TE_RCF, TE_ETAREBOOTED) ||
+           /* TA has dies, but may be revivified later by RCF */
+           rc == TE_RC(TE_RCF, TE_ETADEAD) ||
+           /* TA is being rebooted */
+           rc == TE_RC(TE_RCF, TE_ETAREBOOTING);
+}
+
+/**
+ * Convert messages received from TA to the raw log format and register
+ * them.
+ *
+ * @param inst      TA instance
+ * @param ta_file   Stream with messages in the format of GET_LOG reply
+ * @param flush     Flush state to be updated or @c NULL
+ */
+static void
+ta_register_messages(ta_inst *inst, FILE *ta_file, ta_flush_state *flush)
+{
+    size_t              ta_name_len = strlen(inst->agent);
+    uint8_t             buf[LGR_TA_MAX_BUF];
+    te_log_ts_sec       msg_ts_sec;
+    te_log_ts_usec      msg_ts_usec;
+
+    do { /* messages reading loop */
+
+        uint8_t    *p_buf = buf;
+        uint32_t    sequence;
+        int         lost;
+        size_t      len;
+
+        /* Get message sequence number */
+        if (FREAD(ta_file, (uint8_t *)&sequence, sizeof(uint32_t)) !=
+                sizeof(uint32_t))
+        {
+            break;
+        }
+        sequence = ntohl(sequence);
+        lost = sequence - inst->sequence - 1;
+        if (lost > 0)
+            WARN("TA %s: Lost %d messages", inst->agent, lost);
+        inst->sequence = sequence;
+
+        /* Read control fields value */
+        len = TE_LOG_MSG_COMMON_HDR_SZ;
+        if (FREAD(ta_file, p_buf, len) != len)
+        {
+            break;
+        }
+
+        /* Get message timestamp value */
+        if (flush != NULL && flush->do_flush)
+        {
+            /* Message is started */
+            flush->msg_max--;
+
+            memcpy(&msg_ts_sec,
+                   p_buf + sizeof(te_log_version),
+                   sizeof(te_log_ts_sec));
+            msg_ts_sec = ntohl(msg_ts_sec);
+            memcpy(&msg_ts_usec,
+                   p_buf + sizeof(te_log_version) +
+                   sizeof(te_log_ts_sec), sizeof(te_log_ts_usec));
+            msg_ts_usec = ntohl(msg_ts_usec);
+
+            /* Check timestamp value */
+            if ((msg_ts_sec > (te_log_ts_sec)flush->ts.tv_sec) ||
+                ((msg_ts_sec == (te_log_ts_sec)flush->ts.tv_sec) &&
+                 (msg_ts_usec > (te_log_ts_usec)flush->ts.tv_usec)) ||
+                (flush->msg_max == 0))
+            {
+                flush->do_flush = FALSE;
+                flush->flush_done = TRUE;
+                if (flush->msg_max == 0)
+                {
+                    WARN("TA %s: Flush operation was interrupted",
+                         inst->agent);
+                }
+            }
+        }
+        p_buf += TE_LOG_MSG_COMMON_HDR_SZ;
+
+        /*
+         * Add log ID equal to TE_LOG_ID_UNDEFINED,
+         * as we log from Engine application - "Logger" itself.
+         */
+#if SIZEOF_TE_LOG_ID == 4
+        LGR_32_TO_NET(TE_LOG_ID_UNDEFINED, p_buf);
+#else
+#error Unsupported sizeof(te_log_id)
+#endif
+        p_buf += sizeof(te_log_id);
+
+        /* Add TA name with @ prefix and corresponding NFL to the message */
+        LGR_NFL_PUT(ta_name_len + 1, p_buf);
+        p_buf[0] = '@';
+        p_buf++;
+        memcpy(p_buf, inst->agent, ta_name_len);
+        p_buf += ta_name_len;
+
+        /* Read the first NFL after header */
+        if (FREAD(ta_file, p_buf, sizeof(te_log_nfl)) !=
+                sizeof(te_log_nfl))
+        {
+            break;
+        }
+        len = te_log_raw_get_nfl(p_buf);
+        p_buf += sizeof(te_log_nfl);
+
+        while (len != TE_LOG_RAW_EOR_LEN)
+        {
+            /* Read the field in accordance with NFL */
+            if (len > 0 && FREAD(ta_file, p_buf, len) != len)
+            {
+                break;
+            }
+            p_buf += len;
+
+            /* Read the next NFL */
+            if (FREAD(ta_file, p_buf, sizeof(te_log_nfl)) !=
+                    sizeof(te_log_nfl))
+            {
+                break;
+            }
+            len = te_log_raw_get_nfl(p_buf);
+            p_buf += sizeof(te_log_nfl);
+        };
+        if (len != TE_LOG_RAW_EOR_LEN)
+            break;
+
+        lgr_register_message(buf, p_buf - buf);
+
+    } while (TRUE);
+}
+
+/**
+ * Start flush operation.
+ *
+ * @param flush     Flush state
+ */
+static void
+ta_flush_start(ta_flush_state *flush)
+{
+    flush->do_flush = TRUE;
+    flush->msg_max = LGR_FLUSH_TA_MSG_MAX;
+    gettimeofday(&flush->ts, NULL);
+}
+
+/**
+ * Get TA local log using RCF and register obtained messages.
+ *
+ * @param inst      TA instance
+ * @param flush     Flush state
+ *
+ * @return Status code.
+ * @retval 0        Messages are processed or the error is not fatal
+ */
+static te_errno
+ta_get_log(ta_inst *inst, ta_flush_state *flush)
+{
+    char                log_file[RCF_MAX_PATH];
+    struct stat         log_file_stat;
+    FILE               *ta_file;
+    te_errno            rc;
+
+    *log_file = '\0';
+    if ((rc = rcf_ta_get_log(inst->agent, log_file)) != 0)
+    {
+        /* Any error interrupts flush operation */
+        if (flush->do_flush)
+        {
+            flush->do_flush = FALSE;
+            flush->flush_done = TRUE;
+        }
+        if (/* No log messages */
+            (rc == TE_RC(TE_RCF_PCH, TE_ENOENT)) || ta_unavailable(rc))
+        {
+            return 0;
+        }
+
+        /* The rest of errors are considered as fatal */
+        ERROR("rcf_ta_get_log(ta_name='%s') returned fatal error "
+              "%r, stop gathering logs from this TA",
+              inst->agent, rc);
+        return rc;
+    }
+
+    if (stat(log_file, &log_file_stat) < 0)
+    {
+        rc = TE_OS_RC(TE_LOGGER, errno);
+        ERROR("FATAL ERROR: TA %s: log file '%s' stat() failure: "
+              "errno=%d", inst->agent, log_file, errno);
+        return rc;
+    }
+    else if (log_file_stat.st_size == 0)
+    {
+        /* File is empty */
+        ERROR("TA %s: log file '%s' is empty", inst->agent, log_file);
+
+        if (remove(log_file) != 0)
+        {
+            ERROR("Failed to delete log file '%s': errno=%d",
+                  log_file, errno);
+            /* Continue */
+        }
+        if (flush->do_flush)
+        {
+            flush->do_flush = FALSE;
+            flush->flush_done = TRUE;
+        }
+        return 0;
+    }
+
+    ta_file = fopen(log_file, "r");
+    if (ta_file == NULL)
+    {
+        rc = TE_OS_RC(TE_LOGGER, errno);
+        ERROR("FATAL ERROR: TA %s: fopen(%s) failure: errno=%d",
+              inst->agent, log_file, errno);
+        return rc;
+    }
+
+    ta_register_messages(inst, ta_file, flush);
+
+    if (feof(ta_file) == 0)
+    {
+        ERROR("TA %s: Invalid file '%s' with logs",
+              inst->agent, log_file);
+        /* Continue */
+    }
+
+    if (fclose(ta_file) != 0)
+    {
+        ERROR("TA %s: fclose() of '%s' failed: errno=%d",
+              inst->agent, log_file, errno);
+        /* Continue */
+    }
+    if (remove(log_file) != 0)
+    {
+        ERROR("TA %s: Failed to delete file '%s': errno=%d",
+              inst->agent, log_file, errno);
+        /* Continue */
+    }
+
+    return 0;
+}
+
+/**
+ * Register messages pushed by TA (lgr_ta_stream_data_cb).
+ *
+ * @param data      Messages in the format of GET_LOG reply
+ * @param len       Length of @p data
+ * @param opaque    TA instance
+ */
+static void
+ta_stream_data(const uint8_t *data, size_t len, void *opaque)
+{
+    ta_inst    *inst = opaque;
+    FILE       *f;
+
+    f = fmemopen((void *)data, len, "r");
+    if (f == NULL)
+    {
+        ERROR("TA %s: fmemopen() failed: errno=%d", inst->agent, errno);
+        return;
+    }
+
+    ta_register_messages(inst, f, NULL);
+    if (feof(f) == 0)
+        ERROR("TA %s: Invalid log data is pushed", inst->agent);
+
+    fclose(f);
+}
+
+/**
+ * Gather log messages pushed by TA until the stream is broken.
+ *
+ * RCF is still asked for the log once in a while: the agent does not
+ * return anything while it streams, but RCF needs the request to
+ * continue agent reboot.
+ *
+ * @param inst      TA instance
+ * @param stream    Connected TA log stream
+ * @param srv       Logger IPC server for TA
+ * @param flush     Flush state
+ *
+ * @return Status code.
+ * @retval 0        Stream is broken, polling should be used
+ */
+static te_errno
+ta_stream_handler(ta_inst *inst, lgr_ta_stream *stream,
+                  struct ipc_server *srv, ta_flush_state *flush)
+{
+    int             fd_server = ipc_get_server_fd(srv);
+    int             fd_max = MAX(fd_server, stream->sock);
+    fd_set          rfds;
+    struct timeval  poll_ts;
+    struct timeval  now;
+    struct timeval  delay;
+    long            wait_ms;
+    te_bool         flushed;
+    te_errno        rc;
+
+    gettimeofday(&poll_ts, NULL);
+
+    while (TRUE)
+    {
+        if (flush->flush_done)
+        {
+            flush->flush_done = FALSE;
+            rc = ta_flush_done(srv);
+            if (rc != 0)
+                return rc;
+        }
+
+        gettimeofday(&now, NULL);
+        if (flush->do_flush)
+        {
+            wait_ms = LGR_TA_STREAM_FLUSH_TIMEOUT -
+                      TE_US2MS(TE_SEC2US(now.tv_sec - flush->ts.tv_sec) +
+                               now.tv_usec - flush->ts.tv_usec);
+            if (wait_ms < 0)
+            {
+                WARN("TA %s: flush of pushed log timed out", inst->agent);
+                return 0;
+            }
+        }
+        else
+        {
+            wait_ms = LGR_TA_STREAM_POLL -
+                      TE_US2MS(TE_SEC2US(now.tv_sec - poll_ts.tv_sec) +
+                               now.tv_usec - poll_ts.tv_usec);
+            if (wait_ms <= 0)
+            {
+                gettimeofday(&poll_ts, NULL);
+                rc = ta_get_log(inst, flush);
+                if (rc != 0)
+                    return rc;
+                continue;
+            }
+        }
+
+        delay.tv_sec = TE_MS2SEC(wait_ms);
+        delay.tv_usec = TE_MS2US(wait_ms % 1000);
+
+        FD_ZERO(&rfds);
+        FD_SET(stream->sock, &rfds);
+        /* Flush requests are served one by one */
+        if (!flush->do_flush)
+            FD_SET(fd_server, &rfds);
+
+        if (select(fd_max + 1, &rfds, NULL, NULL, &delay) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            rc = TE_OS_RC(TE_LOGGER, errno);
+            ERROR("FATAL ERROR: TA %s: select() failed: %r",
+                  inst->agent, rc);
+            return rc;
+        }
+
+        if (FD_ISSET(stream->sock, &rfds))
+        {
+            flushed = FALSE;
+            rc = lgr_ta_stream_receive(stream, ta_stream_data, inst,
+                                       &flushed);
+            if (rc != 0)
+            {
+                WARN("TA %s: pushed log reception failed: %r",
+                     inst->agent, rc);
+                return 0;
+            }
+            if (flushed && flush->do_flush)
+            {
+                flush->do_flush = FALSE;
+                flush->flush_done = TRUE;
+            }
+        }
+
+        if (FD_ISSET(fd_server, &rfds))
+        {
+            ta_flush_start(flush);
+            rc = lgr_ta_stream_flush(stream);
+            if (rc != 0)
+            {
+                WARN("TA %s: failed to request flush of pushed log: %r",
+                     inst->agent, rc);
+                return 0;
+            }
+        }
+    }
+}
+
 /**
  * This is an entry point of TA log message gatherer.
- * This routine periodically polls appropriate TA to get
- * TA local log. Besides, log is solicited if flush is requested.
+ * This routine asks TA to push its local log and falls back to
+ * periodic polling of TA if it is not possible. Besides, log is
+ * solicited if flush is requested.
  *
  * @param  ta   Location of TA parameters.
  *
@@ -552,21 +981,16 @@ ta_handler(void *ta)
     struct timeval      poll_ts;    /**< The last poll time stamp */
     struct timeval      now;        /**< Current time */
 
-    /* Flush variavles */
-    te_bool             do_flush = FALSE;
-    te_bool             flush_done = FALSE;
-    unsigned int        flush_msg_max = 0;
-    struct timeval      flush_ts;   /**< Time stamp when flush has been
-                                         started */
-    te_log_ts_sec       msg_ts_sec;
-    te_log_ts_usec      msg_ts_usec;
+    /* Log streaming variables */
+    te_bool             stream_enabled;
+    lgr_ta_stream       stream;
+    unsigned int        stream_backoff = 1; /**< Polls between attempts
+                                                 to open the stream */
+    unsigned int        stream_skip = 0;    /**< Polls left before
+                                                 the next attempt */
 
-    /* Log file processing variables */
-    char                log_file[RCF_MAX_PATH];
-    struct stat         log_file_stat;
-    size_t              ta_name_len = strlen(inst->agent);
-    FILE               *ta_file;
-    uint8_t             buf[LGR_TA_MAX_BUF];
+    /* Flush variavles */
+    ta_flush_state      flush = { .do_flush = FALSE, .flush_done = FALSE };
 
 
     /* Register IPC Server for the TA */
@@ -591,6 +1015,8 @@ ta_handler(void *ta)
     /* It not so important to poll at start up */
     gettimeofday(&poll_ts, NULL);
 
+    stream_enabled = !(lgr_flags & LOGGER_NO_TA_STREAM);
+
     /* Create separate thread for sniffers log message processing */
     rc = pthread_create(&sniffer_thread, NULL, (void *)&sniffers_handler,
                         inst->agent);
@@ -603,18 +1029,52 @@ ta_handler(void *ta)
     while (1)
     {
         /* If flush operation is done, reply to requester */
-        if (flush_done)
+        if (flush.flush_done)
         {
-            flush_done = FALSE;
+            flush.flush_done = FALSE;
             if (ta_flush_done(srv) != 0)
                 break;
         }
 
+        /*
+         * Try to switch to pushed log unless a flush started over
+         * broken stream should be completed by polling first.
+         */
+        if (stream_enabled && !flush.do_flush && stream_skip == 0)
+        {
+            rc = lgr_ta_stream_open(inst->agent, &stream);
+            if (rc == 0)
+            {
+                stream_backoff = 1;
+                rc = ta_stream_handler(inst, &stream, srv, &flush);
+                lgr_ta_stream_close(&stream);
+                if (rc != 0)
+                    break;
+
+                /* Reconnect at once, poll if the agent cannot do it */
+                gettimeofday(&poll_ts, NULL);
+                continue;
+            }
+            else if (!ta_unavailable(rc))
+            {
+                /* The failure may be temporary, try again later */
+                WARN("TA %s: log cannot be pushed, polling is used for "
+                     "%u poll(s): %r", inst->agent, stream_backoff, rc);
+                stream_skip = stream_backoff;
+                stream_backoff = MIN(stream_backoff * 2,
+                                     LGR_TA_STREAM_RETRY_MAX);
+            }
+        }
+        else if (stream_skip > 0)
+        {
+            stream_skip--;
+        }
+
         /*
          * If we are not flushing, wait for polling timeout or
          * flush request
          */
-        if (!do_flush)
+        if (!flush.do_flush)
         {
             struct timeval delay = { 0, 0 };
 
@@ -662,9 +1122,7 @@ ta_handler(void *ta)
                 if (FD_ISSET(fd_server, &rfds))
                 {
                     /* Go into the logs flush mode */
-                    do_flush = TRUE;
-                    flush_msg_max = LGR_FLUSH_TA_MSG_MAX;
-                    gettimeofday(&flush_ts, NULL);
+                    ta_flush_start(&flush);
                 }
                 else
                 {
@@ -681,201 +1139,8 @@ ta_handler(void *ta)
         /* Make time stamp when we poll TA */
         gettimeofday(&poll_ts, NULL);
 
-        *log_file = '\0';
-        if ((rc = rcf_ta_get_log(inst->agent, log_file)) != 0)
-        {
-            /* Any error interrupts flush operation */
-            if (do_flush)
-            {
-                do_flush = FALSE;
-                flush_done = TRUE;
-            }
-            if (/* No log messages */
-                (rc == TE_RC(TE_RCF_PCH, TE_ENOENT)) ||
-                /* RCF request to TA is timed out */
-                (rc == TE_RC(TE_RCF, TE_ETIMEDOUT)) ||
-                /* TA has been rebooted */
-                (rc == TE_RC(TE_RCF, TE_ETAREBOOTED)) ||
-                /* TA has dies, but may be revivified later by RCF */
-                (rc == TE_RC(TE_RCF, TE_ETADEAD)) ||
-                /* TA is being rebooted */
-                (rc == TE_RC(TE_RCF, TE_ETAREBOOTING)))
-            {
-                continue;
-            }
-            else
-            {
-                /* The rest of errors are considered as fatal */
-                ERROR("rcf_ta_get_log(ta_name='%s') returned fatal error "
-                      "%r, stop gathering logs from this TA",
-                      inst->agent, rc);
-                break;
-            }
-        }
-
-        rc = stat(log_file, &log_file_stat);
-        if (rc < 0)
-        {
-            ERROR("FATAL ERROR: TA %s: log file '%s' stat() failure: "
-                  "errno=%d", inst->agent, log_file, errno);
-            break;
-        }
-        else if (log_file_stat.st_size == 0)
-        {
-            /* File is empty */
-            ERROR("TA %s: log file '%s' is empty", inst->agent, log_file);
-
-            if (remove(log_file) != 0)
-            {
-                ERROR("Failed to delete log file '%s': errno=%d",
-                      log_file, errno);
-                /* Continue */
-            }
-            if (do_flush)
-            {
-                do_flush = FALSE;
-                flush_done = TRUE;
-            }
-            continue;
-        }
-
-        ta_file = fopen(log_file, "r");
-        if (ta_file == NULL)
-        {
-            ERROR("FATAL ERROR: TA %s: fopen(%s) failure: errno=%d",
-                  inst->agent, log_file, errno);
+        if (ta_get_log(inst, &flush) != 0)
             break;
-        }
-
-        do { /* messages reading loop */
-
-            uint8_t    *p_buf = buf;
-            uint32_t    sequence;
-            int         lost;
-            size_t      len;
-
-            /* Get message sequence number */
-            if (FREAD(ta_file, (uint8_t *)&sequence, sizeof(uint32_t)) !=
-                    sizeof(uint32_t))
-            {
-                break;
-            }
-            sequence = ntohl(sequence);
-            lost = sequence - inst->sequence - 1;
-            if (lost > 0)
-                WARN("TA %s: Lost %d messages", inst->agent, lost);
-            inst->sequence = sequence;
-
-            /* Read control fields value */
-            len = TE_LOG_MSG_COMMON_HDR_SZ;
-            if (FREAD(ta_file, p_buf, len) != len)
-            {
-                break;
-            }
-
-            /* Get message timestamp value */
-            if (do_flush)
-            {
-                /* Message is started */
-                flush_msg_max--;
-
-                memcpy(&msg_ts_sec,
-                       p_buf + sizeof(te_log_version),
-                       sizeof(te_log_ts_sec));
-                msg_ts_sec = ntohl(msg_ts_sec);
-                memcpy(&msg_ts_usec,
-                       p_buf + sizeof(te_log_version) +
-                       sizeof(te_log_ts_sec), sizeof(te_log_ts_usec));
-                msg_ts_usec = ntohl(msg_ts_usec);
-
-                /* Check timestamp value */
-                if ((msg_ts_sec > (te_log_ts_sec)flush_ts.tv_sec) ||
-                    ((msg_ts_sec == (te_log_ts_sec)flush_ts.tv_sec) &&
-                     (msg_ts_usec > (te_log_ts_usec)flush_ts.tv_usec)) ||
-                    (flush_msg_max == 0))
-                {
-                    do_flush = FALSE;
-                    flush_done = TRUE;
-                    if (flush_msg_max == 0)
-                    {
-                        WARN("TA %s: Flush operation was interrupted",
-                             inst->agent);
-                    }
-                }
-            }
-            p_buf += TE_LOG_MSG_COMMON_HDR_SZ;
-
-            /*
-             * Add log ID equal to TE_LOG_ID_UNDEFINED,
-             * as we log from Engine application - "Logger" itself.
-             */
-#if SIZEOF_TE_LOG_ID == 4
-            LGR_32_TO_NET(TE_LOG_ID_UNDEFINED, p_buf);
-#else
-#error Unsupported sizeof(te_log_id)
-#endif
-            p_buf += sizeof(te_log_id);
-
-            /* Add TA name with @ prefix and corresponding NFL to the message */
-            LGR_NFL_PUT(ta_name_len + 1, p_buf);
-            p_buf[0] = '@';
-            p_buf++;
-            memcpy(p_buf, inst->agent, ta_name_len);
-            p_buf += ta_name_len;
-
-            /* Read the first NFL after header */
-            if (FREAD(ta_file, p_buf, sizeof(te_log_nfl)) !=
-                    sizeof(te_log_nfl))
-            {
-                break;
-            }
-            len = te_log_raw_get_nfl(p_buf);
-            p_buf += sizeof(te_log_nfl);
-
-            while (len != TE_LOG_RAW_EOR_LEN)
-            {
-                /* Read the field in accordance with NFL */
-                if (len > 0 && FREAD(ta_file, p_buf, len) != len)
-                {
-                    break;
-                }
-                p_buf += len;
-
-                /* Read the next NFL */
-                if (FREAD(ta_file, p_buf, sizeof(te_log_nfl)) !=
-                        sizeof(te_log_nfl))
-                {
-                    break;
-                }
-                len = te_log_raw_get_nfl(p_buf);
-                p_buf += sizeof(te_log_nfl);
-            };
-            if (len != TE_LOG_RAW_EOR_LEN)
-                break;
-
-            lgr_register_message(buf, p_buf - buf);
-
-        } while (TRUE);
-
-        if (feof(ta_file) == 0)
-        {
-            ERROR("TA %s: Invalid file '%s' with logs",
-                  inst->agent, log_file);
-            /* Continue */
-        }
-
-        if (fclose(ta_file) != 0)
-        {
-            ERROR("TA %s: fclose() of '%s' failed: errno=%d",
-                  inst->agent, log_file, errno);
-            /* Continue */
-        }
-        if (remove(log_file) != 0)
-        {
-            ERROR("TA %s: Failed to delete file '%s': errno=%d",
-                  inst->agent, log_file, errno);
-            /* Continue */
-        }
 
     } /* end of forever loop */
 
@@ -885,7 +1150,7 @@ ta_handler(void *ta)
         ERROR("pthread_join() failed: %s\n", err_buf);
     }
 
-    if (do_flush || flush_done)
+    if (flush.do_flush || flush.flush_done)
     {
         (void)ta_flush_done(srv);
     }
@@ -936,6 +1201,11 @@ process_cmd_line_opts(int argc, const char **argv)
           "i.e. without polling any Test Agents (useful for Logger debugging).",
           NULL },
 
+        { "no-ta-stream", '\0',
+          POPT_ARG_NONE | POPT_BIT_SET, &lgr_flags, LOGGER_NO_TA_STREAM,
+          "Do not ask Test Agents to push their log, poll them instead.",
+          NULL },
+
         { "check", 'c',
           POPT_ARG_NONE | POPT_BIT_SET, &lgr_flags, LOGGER_CHECK,
           "Check that log messages received from other TE components are "
@@ -958,6 +1228,19 @@ process_cmd_line_opts(int argc, const char **argv)
           "unlimited; may be specified in units of G[igabytes])",
           "size" },
 
+        { "flush-interval", '\0',
+          POPT_ARG_INT, &raw_log_flush_interval, LOGGER_OPT_FLUSH_INT,
+          "Maximum time a log message may be kept in memory before it is "
+          "stored in the raw log (100 ms by default; 0 to store messages "
+          "as soon as possible)",
+          "msec" },
+
+        { "batch-size", '\0',
+          POPT_ARG_INT, &raw_log_batch_size, LOGGER_OPT_BATCH_SIZE,
+          "Size of a batch of log messages stored in the raw log at once "
+          "without waiting for the flush interval (256 KiB by default)",
+          "bytes" },
+
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -1021,6 +1304,26 @@ process_cmd_line_opts(int argc, const char **argv)
                 break;
             }
 
+            case LOGGER_OPT_FLUSH_INT:
+                if (raw_log_flush_interval < 0)
+                {
+                    fprintf(stderr, "Invalid --flush-interval=%d\n",
+                            raw_log_flush_interval);
+                    poptFreeContext(optCon);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case LOGGER_OPT_BATCH_SIZE:
+                if (raw_log_batch_size <= 0)
+                {
+                    fprintf(stderr, "Invalid --batch-size=%d\n",
+                            raw_log_batch_size);
+                    poptFreeContext(optCon);
+                    return EXIT_FAILURE;
+                }
+                break;
+
             default:
                 fprintf(stderr, "Unexpected option number %d", rc);
                 poptFreeContext(optCon);
@@ -1182,10 +1485,12 @@ main(int argc, const char *argv[])
         return EXIT_FAILURE;
     }
     /* Open raw log file for addition */
-    raw_file = fopen(te_log_raw, "ab");
-    if (raw_file == NULL)
+    rc = lgr_writer_open(te_log_raw, raw_log_max_size,
+                         raw_log_flush_interval, raw_log_batch_size);
+    if (rc != 0)
     {
-        perror("fopen() failure");
+        fprintf(stderr, "Failed to open raw log '%s': %s\n", te_log_raw,
+                te_rc_err2str(rc));
         return EXIT_FAILURE;
     }
     /* Further we must goto 'exit' in the case of failure */
@@ -1239,6 +1544,14 @@ main(int argc, const char *argv[])
     /* Store my PID in global variable */
     pid = getpid();
 
+    /* Messages logged so far are kept in the writer queue */
+    rc = lgr_writer_start();
+    if (rc != 0)
+    {
+        ERROR("Failed to start raw log writer: %r", rc);
+        goto exit;
+    }
+
     /* Apply default sniffer settings */
     sniffer_polling_sets_start_init();
     /* Parse configuration file */
@@ -1450,14 +1763,10 @@ exit:
 
     RING("Shutdown is completed");
 
-    if (fflush(raw_file) != 0)
-    {
-        perror("fflush() failed");
-        result = EXIT_FAILURE;
-    }
-    if (fclose(raw_file) != 0)
+    rc = lgr_writer_close();
+    if (rc != 0)
     {
-        perror("fclose() failed");
+        fprintf(stderr, "Failed to close raw log: %s\n", te_rc_err2str(rc));
         result = EXIT_FAILURE;
     }
 
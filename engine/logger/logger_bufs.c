@@ -64,7 +64,7 @@ refcnt_buffer_copy(refcnt_buffer *dest, const refcnt_buffer *src)
     dest->len = src->len;
     dest->refcount = src->refcount;
 
-    (*dest->refcount)++;
+    __atomic_add_fetch(dest->refcount, 1, __ATOMIC_RELAXED);
 }
 
 
@@ -72,8 +72,7 @@ refcnt_buffer_copy(refcnt_buffer *dest, const refcnt_buffer *src)
 void
 refcnt_buffer_free(refcnt_buffer *rbuf)
 {
-    *rbuf->refcount -= 1;
-    if (*rbuf->refcount == 0)
+    if (__atomic_sub_fetch(rbuf->refcount, 1, __ATOMIC_ACQ_REL) == 0)
     {
         free(rbuf->buf);
         free(rbuf->refcount);
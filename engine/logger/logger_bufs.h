@@ -17,7 +17,12 @@
 extern "C" {
 #endif
 
-/** A memory buffer that keeps track of references to its contents */
+/**
+ * A memory buffer that keeps track of references to its contents.
+ *
+ * The reference counter is updated atomically, so copies of a buffer
+ * may be released by different threads.
+ */
 typedef struct refcnt_buffer {
     TAILQ_ENTRY(refcnt_buffer) links; /**< Pointers to other buffers */
 
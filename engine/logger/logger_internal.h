@@ -58,6 +58,24 @@ extern "C" {
 /** Default TA polling timeout in milliseconds */
 #define LGR_TA_POLL_DEF         1000     /* 1 second */
 
+/**
+ * Period of TA polling (in milliseconds) while TA pushes its log.
+ * Polling is required by RCF to reboot TA.
+ */
+#define LGR_TA_STREAM_POLL      5000     /* 5 seconds */
+
+/**
+ * Maximum number of TA polls between attempts to switch to pushed log
+ * after a failure. The number is doubled after each failed attempt.
+ */
+#define LGR_TA_STREAM_RETRY_MAX 64
+
+/**
+ * Maximum time (in milliseconds) to wait for TA to push its log
+ * on flush. When it expires, TA is polled to get the rest of log.
+ */
+#define LGR_TA_STREAM_FLUSH_TIMEOUT 10000    /* 10 seconds */
+
 /**
  * Maximum number of messages to be get during flush.
  * It is required to cope with permanent logging on TA
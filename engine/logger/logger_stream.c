@@ -47,17 +47,31 @@ msg_queue_init(msg_queue *queue)
 te_errno
 msg_queue_post(msg_queue *queue, const char *buf, size_t len)
 {
-    uint64_t      inc;
     te_errno      rc;
+    refcnt_buffer msg;
+
+    rc = refcnt_buffer_init_copy(&msg, buf, len);
+    if (rc != 0)
+        return rc;
+
+    rc = msg_queue_post_buffer(queue, &msg);
+    refcnt_buffer_free(&msg);
+
+    return rc;
+}
+
+/* See description in logger_stream.h */
+te_errno
+msg_queue_post_buffer(msg_queue *queue, const refcnt_buffer *msg)
+{
+    uint64_t      inc;
     refcnt_buffer *item;
 
     item = TE_ALLOC(sizeof(*item));
     if (item == NULL)
         return TE_ENOMEM;
 
-    rc = refcnt_buffer_init_copy(item, buf, len);
-    if (rc != 0)
-        return rc;
+    refcnt_buffer_copy(item, msg);
 
     pthread_mutex_lock(&queue->mutex);
     if (queue->shutdown)
@@ -56,6 +56,19 @@ extern te_errno msg_queue_init(msg_queue *queue);
  */
 extern te_errno msg_queue_post(msg_queue *queue, const char *buf, size_t len);
 
+/**
+ * Post a message on the queue without copying its contents.
+ *
+ * The queue takes its own reference to the buffer.
+ *
+ * @param queue         Message queue
+ * @param msg           Message
+ *
+ * @returns Status code
+ */
+extern te_errno msg_queue_post_buffer(msg_queue *queue,
+                                      const refcnt_buffer *msg);
+
 /**
  * Extract messages from the message queue.
  *
@@ -0,0 +1,369 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief TE project. Logger subsystem.
+ *
+ * Reception of log messages pushed by Test Agents.
+ *
+ * Logger listens on an ephemeral port, passes it to the agent via RCF
+ * and accepts a single connection identified by a random cookie.
+ * The agent may have no more than TE_LOG_STREAM_WINDOW bytes in flight:
+ * the window is granted after the handshake and each received data
+ * frame is acknowledged by a credit frame as soon as its messages are
+ * registered.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER "TA Stream"
+
+#include "te_config.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#if HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+
+#include "te_defs.h"
+#include "te_alloc.h"
+#include "logger_api.h"
+#include "rcf_api.h"
+#include "te_log_stream.h"
+#include "logger_ta_stream.h"
+
+/** Size of the buffer for incoming frames */
+#define LGR_TA_STREAM_BUF_SIZE \
+    (sizeof(te_log_stream_hdr) + TE_LOG_STREAM_DATA_MAX)
+
+/**
+ * Send a frame without payload.
+ *
+ * @param sock      Connected socket
+ * @param op        Frame type
+ * @param arg       Frame argument
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_send_ctl(int sock, te_log_stream_op op, uint32_t arg)
+{
+    te_log_stream_hdr hdr = { .op = htonl(op), .len = htonl(arg) };
+    ssize_t           rc;
+
+    do {
+        rc = send(sock, &hdr, sizeof(hdr), MSG_NOSIGNAL);
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc < 0)
+        return TE_OS_RC(TE_LOGGER, errno);
+    /* Control frames are tiny, partial send means broken connection */
+    if (rc != sizeof(hdr))
+        return TE_RC(TE_LOGGER, TE_EIO);
+
+    return 0;
+}
+
+/**
+ * Wait for a descriptor to become readable.
+ *
+ * @param fd        File descriptor
+ * @param timeout   Timeout in milliseconds
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_wait_readable(int fd, int timeout)
+{
+    struct pollfd   pfd = { .fd = fd, .events = POLLIN };
+    int             rc;
+
+    do {
+        rc = poll(&pfd, 1, timeout);
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc < 0)
+        return TE_OS_RC(TE_LOGGER, errno);
+    if (rc == 0)
+        return TE_RC(TE_LOGGER, TE_ETIMEDOUT);
+
+    return 0;
+}
+
+/**
+ * Generate a cookie of the connection. The listening socket is reachable
+ * by anyone, so the cookie must not be predictable.
+ *
+ * @param cookie    Location for the cookie
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_cookie(uint32_t *cookie)
+{
+    ssize_t     len;
+    te_errno    rc = 0;
+    int         fd;
+
+    fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0)
+        return TE_OS_RC(TE_LOGGER, errno);
+
+    do {
+        len = read(fd, cookie, sizeof(*cookie));
+    } while (len < 0 && errno == EINTR);
+
+    if (len < 0)
+        rc = TE_OS_RC(TE_LOGGER, errno);
+    else if (len != sizeof(*cookie))
+        rc = TE_RC(TE_LOGGER, TE_EIO);
+
+    close(fd);
+    return rc;
+}
+
+/**
+ * Create a listening socket bound to an ephemeral port.
+ *
+ * @param listener  Location for the socket
+ * @param port      Location for the port (in host byte order)
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_listen(int *listener, uint16_t *port)
+{
+    struct sockaddr_in  addr;
+    socklen_t           addrlen = sizeof(addr);
+    int                 s;
+
+    s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0)
+        return TE_OS_RC(TE_LOGGER, errno);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(s, SA(&addr), sizeof(addr)) < 0 || listen(s, 1) < 0 ||
+        getsockname(s, SA(&addr), &addrlen) < 0)
+    {
+        te_errno rc = TE_OS_RC(TE_LOGGER, errno);
+
+        close(s);
+        return rc;
+    }
+
+    *listener = s;
+    *port = ntohs(addr.sin_port);
+    return 0;
+}
+
+/**
+ * Accept the agent connection and exchange cookies.
+ *
+ * @param listener  Listening socket
+ * @param cookie    Expected cookie
+ * @param sock      Location for the connected socket
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_accept(int listener, uint32_t cookie, int *sock)
+{
+    te_log_stream_hdr   hello;
+    size_t              got = 0;
+    ssize_t             len;
+    te_errno            rc;
+    int                 s;
+
+    /* The agent may spend the whole timeout in connect() */
+    rc = stream_wait_readable(listener, 2 * TE_LOG_STREAM_CONNECT_TIMEOUT);
+    if (rc != 0)
+        return rc;
+
+    s = accept(listener, NULL, NULL);
+    if (s < 0)
+        return TE_OS_RC(TE_LOGGER, errno);
+
+    while (got < sizeof(hello))
+    {
+        rc = stream_wait_readable(s, TE_LOG_STREAM_CONNECT_TIMEOUT);
+        if (rc != 0)
+            goto fail;
+
+        len = recv(s, (uint8_t *)&hello + got, sizeof(hello) - got, 0);
+        if (len <= 0)
+        {
+            rc = TE_RC(TE_LOGGER, TE_ECONNRESET);
+            goto fail;
+        }
+        got += len;
+    }
+
+    if (ntohl(hello.op) != TE_LOG_STREAM_HELLO ||
+        ntohl(hello.len) != cookie)
+    {
+        rc = TE_RC(TE_LOGGER, TE_EPROTO);
+        goto fail;
+    }
+
+    rc = stream_send_ctl(s, TE_LOG_STREAM_HELLO, cookie);
+    if (rc == 0)
+        rc = stream_send_ctl(s, TE_LOG_STREAM_CREDIT, TE_LOG_STREAM_WINDOW);
+    if (rc != 0)
+        goto fail;
+
+    *sock = s;
+    return 0;
+
+fail:
+    close(s);
+    return rc;
+}
+
+/* See the description in logger_ta_stream.h */
+te_errno
+lgr_ta_stream_open(const char *agent, lgr_ta_stream *stream)
+{
+    uint32_t    cookie;
+    uint16_t    port;
+    int         listener;
+    te_errno    rc;
+
+    stream->sock = -1;
+    stream->buf = NULL;
+    stream->len = 0;
+
+    rc = stream_cookie(&cookie);
+    if (rc != 0)
+    {
+        ERROR("TA %s: failed to generate log stream cookie: %r",
+              agent, rc);
+        return rc;
+    }
+
+    rc = stream_listen(&listener, &port);
+    if (rc != 0)
+    {
+        ERROR("TA %s: failed to create log stream listener: %r",
+              agent, rc);
+        return rc;
+    }
+
+    rc = rcf_ta_log_stream(agent, port, cookie);
+    if (rc == 0)
+        rc = stream_accept(listener, cookie, &stream->sock);
+
+    close(listener);
+    if (rc != 0)
+        return rc;
+
+    stream->buf = TE_ALLOC(LGR_TA_STREAM_BUF_SIZE);
+    if (stream->buf == NULL)
+    {
+        close(stream->sock);
+        stream->sock = -1;
+        return TE_RC(TE_LOGGER, TE_ENOMEM);
+    }
+
+    return 0;
+}
+
+/* See the description in logger_ta_stream.h */
+te_errno
+lgr_ta_stream_flush(lgr_ta_stream *stream)
+{
+    return stream_send_ctl(stream->sock, TE_LOG_STREAM_FLUSH, 0);
+}
+
+/* See the description in logger_ta_stream.h */
+te_errno
+lgr_ta_stream_receive(lgr_ta_stream *stream, lgr_ta_stream_data_cb *cb,
+                      void *opaque, te_bool *flushed)
+{
+    te_log_stream_hdr   hdr;
+    size_t              off;
+    uint32_t            len;
+    ssize_t             got;
+    te_errno            rc;
+
+    while (TRUE)
+    {
+        got = recv(stream->sock, stream->buf + stream->len,
+                   LGR_TA_STREAM_BUF_SIZE - stream->len, MSG_DONTWAIT);
+        if (got == 0)
+            return TE_RC(TE_LOGGER, TE_ECONNRESET);
+        if (got < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            if (errno == EINTR)
+                continue;
+            return TE_OS_RC(TE_LOGGER, errno);
+        }
+        stream->len += got;
+
+        for (off = 0; stream->len - off >= sizeof(hdr); off += len)
+        {
+            memcpy(&hdr, stream->buf + off, sizeof(hdr));
+
+            switch (ntohl(hdr.op))
+            {
+                case TE_LOG_STREAM_DATA:
+                    len = ntohl(hdr.len);
+                    if (len > TE_LOG_STREAM_DATA_MAX)
+                        return TE_RC(TE_LOGGER, TE_EPROTO);
+                    if (stream->len - off - sizeof(hdr) < len)
+                        goto incomplete;
+
+                    cb(stream->buf + off + sizeof(hdr), len, opaque);
+
+                    rc = stream_send_ctl(stream->sock,
+                                         TE_LOG_STREAM_CREDIT, len);
+                    if (rc != 0)
+                        return rc;
+                    break;
+
+                case TE_LOG_STREAM_FLUSHED:
+                    *flushed = TRUE;
+                    len = 0;
+                    break;
+
+                default:
+                    return TE_RC(TE_LOGGER, TE_EPROTO);
+            }
+            off += sizeof(hdr);
+        }
+
+incomplete:
+        stream->len -= off;
+        memmove(stream->buf, stream->buf + off, stream->len);
+    }
+}
+
+/* See the description in logger_ta_stream.h */
+void
+lgr_ta_stream_close(lgr_ta_stream *stream)
+{
+    if (stream->sock >= 0)
+        close(stream->sock);
+    stream->sock = -1;
+
+    free(stream->buf);
+    stream->buf = NULL;
+    stream->len = 0;
+}
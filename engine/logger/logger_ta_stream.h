@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief TE project. Logger subsystem.
+ *
+ * Reception of log messages pushed by Test Agents over a dedicated
+ * connection (see te_log_stream.h for the protocol description).
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_LOGGER_TA_STREAM_H__
+#define __TE_LOGGER_TA_STREAM_H__
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "te_stdint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Connection used by a Test Agent to push its log */
+typedef struct lgr_ta_stream {
+    int         sock;   /**< Connected socket or @c -1 */
+    uint8_t    *buf;    /**< Buffer for incoming frames */
+    size_t      len;    /**< Number of bytes in @a buf */
+} lgr_ta_stream;
+
+/**
+ * Callback to process log messages received from a Test Agent.
+ *
+ * @param data      Messages in the format of GET_LOG reply
+ * @param len       Length of @p data
+ * @param opaque    Opaque data passed to lgr_ta_stream_receive()
+ */
+typedef void (lgr_ta_stream_data_cb)(const uint8_t *data, size_t len,
+                                     void *opaque);
+
+/**
+ * Ask a Test Agent to push its log and wait until it connects.
+ *
+ * @param agent     Test Agent name
+ * @param stream    Stream to be initialized
+ *
+ * @return Status code.
+ */
+extern te_errno lgr_ta_stream_open(const char *agent,
+                                   lgr_ta_stream *stream);
+
+/**
+ * Ask a Test Agent to send all messages registered before the call.
+ * Completion is reported by lgr_ta_stream_receive().
+ *
+ * @param stream    Connected stream
+ *
+ * @return Status code.
+ */
+extern te_errno lgr_ta_stream_flush(lgr_ta_stream *stream);
+
+/**
+ * Receive available data without blocking and grant the agent
+ * permission to send more.
+ *
+ * @param stream    Connected stream
+ * @param cb        Callback to process received messages
+ * @param opaque    Opaque data to be passed to @p cb
+ * @param flushed   Set to @c TRUE if flush is complete,
+ *                  left untouched otherwise
+ *
+ * @return Status code.
+ * @retval TE_ECONNRESET    The agent closed the connection.
+ */
+extern te_errno lgr_ta_stream_receive(lgr_ta_stream *stream,
+                                      lgr_ta_stream_data_cb *cb,
+                                      void *opaque, te_bool *flushed);
+
+/**
+ * Close the connection and release resources.
+ *
+ * @param stream    Stream to be closed
+ */
+extern void lgr_ta_stream_close(lgr_ta_stream *stream);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* __TE_LOGGER_TA_STREAM_H__ */
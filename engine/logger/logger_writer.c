@@ -0,0 +1,598 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief TE project. Logger subsystem.
+ *
+ * Raw log writer implementation.
+ *
+ * Producers push messages to an intrusive MPSC queue (D. Vyukov's
+ * algorithm): a push is a single atomic exchange and never blocks.
+ * The writer thread pops messages, collects them in an I/O vector and
+ * stores the vector with writev() when it is large enough, when the
+ * oldest message in it is older than the flush interval or when
+ * a flush is requested explicitly.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER "Writer"
+
+#include "te_config.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "te_defs.h"
+#include "te_alloc.h"
+#include "logger_bufs.h"
+#include "logger_writer.h"
+
+/** Maximum number of messages written by one writev() call */
+#ifdef IOV_MAX
+#define LGR_WRITER_IOV_MAX  IOV_MAX
+#else
+#define LGR_WRITER_IOV_MAX  1024
+#endif
+
+/** Element of the writer queue */
+typedef struct lgr_writer_item {
+    struct lgr_writer_item *next; /**< Next item in the queue */
+    refcnt_buffer           msg;  /**< Message */
+} lgr_writer_item;
+
+/** Writer thread states visible to producers */
+typedef enum lgr_writer_state {
+    LGR_WRITER_RUNNING,  /**< Writer is processing the queue */
+    LGR_WRITER_DOZING,   /**< Writer has an incomplete batch and sleeps
+                              until the flush interval expires */
+    LGR_WRITER_SLEEPING, /**< Writer has nothing to do and sleeps until
+                              a message is posted */
+} lgr_writer_state;
+
+/** Raw log writer context */
+typedef struct lgr_writer {
+    int             fd;             /**< Raw log file descriptor */
+    int64_t         max_size;       /**< Raw log size limit */
+    unsigned int    flush_interval; /**< Flush interval in milliseconds */
+    size_t          batch_size;     /**< Batch size in bytes */
+
+    /* Producer side */
+    lgr_writer_item *head;          /**< The most recently pushed item */
+    uint64_t        size;           /**< Size of the raw log including
+                                         accepted but not yet written
+                                         messages */
+    size_t          pending;        /**< Number of bytes in the queue and
+                                         in the current batch */
+    int             state;          /**< Writer state, see
+                                         @ref lgr_writer_state */
+    int             wake_fd;        /**< Event file descriptor to wake
+                                         the writer up */
+
+    /* Consumer side */
+    lgr_writer_item *tail;          /**< The oldest item in the queue */
+    lgr_writer_item  stub;          /**< Queue stub item */
+
+    te_bool         running;        /**< Whether the thread is started */
+    te_bool         shutdown;       /**< Whether the thread should exit */
+    pthread_t       thread;         /**< Writer thread */
+
+    pthread_mutex_t flush_lock;     /**< Protects flush counters */
+    pthread_cond_t  flush_cond;     /**< Signalled when a flush is done */
+    unsigned int    flush_req;      /**< Number of requested flushes */
+    unsigned int    flush_done;     /**< Number of completed flushes */
+} lgr_writer;
+
+static lgr_writer writer = {
+    .fd = -1,
+    .wake_fd = -1,
+    .flush_lock = PTHREAD_MUTEX_INITIALIZER,
+    .flush_cond = PTHREAD_COND_INITIALIZER,
+};
+
+/** Messages collected for a single writev() call */
+typedef struct lgr_writer_batch {
+    struct iovec     iov[LGR_WRITER_IOV_MAX];   /**< Message data */
+    lgr_writer_item *items[LGR_WRITER_IOV_MAX]; /**< Message items */
+    unsigned int     count;                     /**< Number of messages */
+    size_t           len;                       /**< Total length */
+    struct timeval   ts;                        /**< When the first
+                                                     message was added */
+} lgr_writer_batch;
+
+/**
+ * Push an item to the writer queue.
+ *
+ * @param item      Queue item
+ */
+static void
+writer_queue_push(lgr_writer_item *item)
+{
+    lgr_writer_item *prev;
+
+    __atomic_store_n(&item->next, NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&writer.head, item, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&prev->next, item, __ATOMIC_RELEASE);
+}
+
+/**
+ * Pop the oldest item from the writer queue.
+ *
+ * @return Queue item or @c NULL if the queue is empty or a producer has
+ *         not completed its push yet.
+ */
+static lgr_writer_item *
+writer_queue_pop(void)
+{
+    lgr_writer_item *tail = writer.tail;
+    lgr_writer_item *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &writer.stub)
+    {
+        if (next == NULL)
+            return NULL;
+        writer.tail = tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next != NULL)
+    {
+        writer.tail = next;
+        return tail;
+    }
+
+    if (tail != __atomic_load_n(&writer.head, __ATOMIC_SEQ_CST))
+        return NULL;
+
+    writer_queue_push(&writer.stub);
+
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next != NULL)
+    {
+        writer.tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+/**
+ * Check whether the writer queue is empty.
+ *
+ * @return @c TRUE if there is nothing to pop and no push is in progress.
+ */
+static te_bool
+writer_queue_empty(void)
+{
+    return writer.tail == &writer.stub &&
+           __atomic_load_n(&writer.head, __ATOMIC_SEQ_CST) == &writer.stub;
+}
+
+/**
+ * Wake the writer thread up.
+ */
+static void
+writer_wake(void)
+{
+    uint64_t inc = 1;
+
+    if (write(writer.wake_fd, &inc, sizeof(inc)) != sizeof(inc))
+        perror("Failed to wake raw log writer up");
+}
+
+/**
+ * Store a batch of messages in the raw log file and release them.
+ *
+ * @param batch     Batch of messages
+ */
+static void
+writer_batch_write(lgr_writer_batch *batch)
+{
+    struct iovec   *iov = batch->iov;
+    unsigned int    iovcnt = batch->count;
+    unsigned int    i;
+    ssize_t         rc;
+
+    while (iovcnt > 0)
+    {
+        rc = writev(writer.fd, iov, iovcnt);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            perror("writev() to raw log failed");
+            break;
+        }
+
+        /* Skip completely written messages */
+        while (iovcnt > 0 && (size_t)rc >= iov->iov_len)
+        {
+            rc -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + rc;
+            iov->iov_len -= rc;
+        }
+    }
+
+    for (i = 0; i < batch->count; i++)
+    {
+        refcnt_buffer_free(&batch->items[i]->msg);
+        free(batch->items[i]);
+    }
+
+    __atomic_sub_fetch(&writer.pending, batch->len, __ATOMIC_RELAXED);
+
+    batch->count = 0;
+    batch->len = 0;
+}
+
+/**
+ * Move messages from the queue to the batch.
+ *
+ * @param batch     Batch of messages
+ *
+ * @return @c TRUE if a producer has not completed its push and
+ *         the queue should be checked again.
+ */
+static te_bool
+writer_batch_fill(lgr_writer_batch *batch)
+{
+    lgr_writer_item *item;
+
+    while (batch->count < LGR_WRITER_IOV_MAX &&
+           batch->len < writer.batch_size)
+    {
+        item = writer_queue_pop();
+        if (item == NULL)
+            return !writer_queue_empty();
+
+        if (batch->count == 0)
+            gettimeofday(&batch->ts, NULL);
+
+        batch->iov[batch->count].iov_base = item->msg.buf;
+        batch->iov[batch->count].iov_len = item->msg.len;
+        batch->items[batch->count] = item;
+        batch->count++;
+        batch->len += item->msg.len;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Get number of milliseconds left until the batch must be written.
+ *
+ * @param batch     Batch of messages
+ *
+ * @return Timeout in milliseconds.
+ */
+static int
+writer_batch_timeout(const lgr_writer_batch *batch)
+{
+    struct timeval  now;
+    long long       age;
+
+    gettimeofday(&now, NULL);
+    age = TE_US2MS(TE_SEC2US(now.tv_sec - batch->ts.tv_sec) +
+                   (now.tv_usec - batch->ts.tv_usec));
+
+    if (age >= writer.flush_interval)
+        return 0;
+
+    return writer.flush_interval - age;
+}
+
+/**
+ * Sleep until a message is posted, a flush is requested or
+ * the timeout expires.
+ *
+ * @param state     State to announce to producers
+ * @param timeout   Timeout in milliseconds (negative for infinite)
+ * @param flush_req Flush request counter value seen by the writer
+ */
+static void
+writer_sleep(lgr_writer_state state, int timeout, unsigned int flush_req)
+{
+    struct pollfd   pfd = { .fd = writer.wake_fd, .events = POLLIN };
+    uint64_t        cnt;
+
+    __atomic_store_n(&writer.state, state, __ATOMIC_SEQ_CST);
+
+    /* Recheck everything producers may have changed before the store */
+    if (writer_queue_empty() &&
+        !__atomic_load_n(&writer.shutdown, __ATOMIC_SEQ_CST) &&
+        __atomic_load_n(&writer.flush_req, __ATOMIC_SEQ_CST) == flush_req)
+    {
+        if (poll(&pfd, 1, timeout) > 0)
+        {
+            if (read(writer.wake_fd, &cnt, sizeof(cnt)) < 0 &&
+                errno != EAGAIN)
+                perror("Failed to read raw log writer event");
+        }
+    }
+
+    __atomic_store_n(&writer.state, LGR_WRITER_RUNNING, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Mark flushes requested before the batch is collected as completed.
+ *
+ * @param flush_req     Flush request counter value
+ */
+static void
+writer_flush_complete(unsigned int flush_req)
+{
+    pthread_mutex_lock(&writer.flush_lock);
+    writer.flush_done = flush_req;
+    pthread_cond_broadcast(&writer.flush_cond);
+    pthread_mutex_unlock(&writer.flush_lock);
+}
+
+/**
+ * Entry point of the writer thread.
+ *
+ * @param arg       Batch allocated by lgr_writer_start(), owned
+ *                  by the thread
+ *
+ * @return @c NULL
+ */
+static void *
+writer_thread(void *arg)
+{
+    lgr_writer_batch   *batch = arg;
+    unsigned int        flush_req;
+    te_bool             shutdown;
+    te_bool             busy;
+
+    while (TRUE)
+    {
+        /*
+         * Read flush and shutdown requests before the queue is drained,
+         * so all messages posted before the requests are written.
+         */
+        flush_req = __atomic_load_n(&writer.flush_req, __ATOMIC_SEQ_CST);
+        shutdown = __atomic_load_n(&writer.shutdown, __ATOMIC_SEQ_CST);
+
+        busy = writer_batch_fill(batch);
+
+        if (batch->count == LGR_WRITER_IOV_MAX ||
+            batch->len >= writer.batch_size)
+        {
+            writer_batch_write(batch);
+            continue;
+        }
+
+        if (busy)
+        {
+            /* A producer is in the middle of a push */
+            sched_yield();
+            continue;
+        }
+
+        /* The queue is empty here */
+        if (batch->count > 0 &&
+            (shutdown || flush_req != writer.flush_done ||
+             writer_batch_timeout(batch) == 0))
+        {
+            writer_batch_write(batch);
+        }
+
+        if (batch->count == 0)
+        {
+            if (flush_req != writer.flush_done)
+                writer_flush_complete(flush_req);
+            if (shutdown)
+                break;
+
+            writer_sleep(LGR_WRITER_SLEEPING, -1, flush_req);
+        }
+        else
+        {
+            writer_sleep(LGR_WRITER_DOZING, writer_batch_timeout(batch),
+                         flush_req);
+        }
+    }
+
+    free(batch);
+    return NULL;
+}
+
+/* See description in logger_writer.h */
+te_errno
+lgr_writer_open(const char *path, int64_t max_size,
+                unsigned int flush_interval, size_t batch_size)
+{
+    struct stat st;
+    te_errno    rc;
+
+    writer.fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (writer.fd < 0)
+        return te_rc_os2te(errno);
+
+    /* The size is tracked in memory since that */
+    if (fstat(writer.fd, &st) != 0)
+    {
+        rc = te_rc_os2te(errno);
+        close(writer.fd);
+        writer.fd = -1;
+        return rc;
+    }
+
+    writer.wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (writer.wake_fd < 0)
+    {
+        rc = te_rc_os2te(errno);
+        close(writer.fd);
+        writer.fd = -1;
+        return rc;
+    }
+
+    writer.size = st.st_size;
+    writer.max_size = max_size;
+    writer.flush_interval = flush_interval;
+    writer.batch_size = MAX(batch_size, 1);
+    writer.pending = 0;
+    writer.state = LGR_WRITER_RUNNING;
+    writer.head = writer.tail = &writer.stub;
+    writer.stub.next = NULL;
+
+    return 0;
+}
+
+/* See description in logger_writer.h */
+te_errno
+lgr_writer_start(void)
+{
+    lgr_writer_batch   *batch;
+    int                 rc;
+
+    /*
+     * The batch is allocated here, so the thread cannot fail after
+     * it is started and leave flushes waiting for it forever.
+     */
+    batch = TE_ALLOC(sizeof(*batch));
+    if (batch == NULL)
+        return TE_ENOMEM;
+
+    rc = pthread_create(&writer.thread, NULL, writer_thread, batch);
+    if (rc != 0)
+    {
+        free(batch);
+        return te_rc_os2te(rc);
+    }
+
+    writer.running = TRUE;
+    return 0;
+}
+
+/* See description in logger_writer.h */
+te_errno
+lgr_writer_post(const refcnt_buffer *msg, te_bool ignore_limit)
+{
+    lgr_writer_item *item;
+    uint64_t         size;
+    size_t           pending;
+    int              state;
+
+    if (writer.fd < 0)
+        return TE_EBADF;
+
+    size = __atomic_add_fetch(&writer.size, msg->len, __ATOMIC_RELAXED);
+    if (!ignore_limit && writer.max_size >= 0 &&
+        size > (uint64_t)writer.max_size)
+    {
+        __atomic_sub_fetch(&writer.size, msg->len, __ATOMIC_RELAXED);
+        return TE_EFBIG;
+    }
+
+    item = TE_ALLOC(sizeof(*item));
+    if (item == NULL)
+    {
+        __atomic_sub_fetch(&writer.size, msg->len, __ATOMIC_RELAXED);
+        return TE_ENOMEM;
+    }
+    refcnt_buffer_copy(&item->msg, msg);
+
+    pending = __atomic_add_fetch(&writer.pending, msg->len,
+                                 __ATOMIC_RELAXED);
+    writer_queue_push(item);
+
+    /*
+     * Wake the writer up if it waits for messages or if it waits
+     * for the flush interval to expire, but a full batch is collected.
+     */
+    state = __atomic_load_n(&writer.state, __ATOMIC_SEQ_CST);
+    if (state == LGR_WRITER_SLEEPING ||
+        (state == LGR_WRITER_DOZING && pending >= writer.batch_size))
+    {
+        if (__atomic_compare_exchange_n(&writer.state, &state,
+                                        LGR_WRITER_RUNNING, FALSE,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST))
+            writer_wake();
+    }
+
+    return 0;
+}
+
+/* See description in logger_writer.h */
+void
+lgr_writer_flush(void)
+{
+    unsigned int req;
+
+    if (!writer.running)
+        return;
+
+    pthread_mutex_lock(&writer.flush_lock);
+    req = __atomic_add_fetch(&writer.flush_req, 1, __ATOMIC_SEQ_CST);
+    writer_wake();
+    while ((int)(writer.flush_done - req) < 0)
+        pthread_cond_wait(&writer.flush_cond, &writer.flush_lock);
+    pthread_mutex_unlock(&writer.flush_lock);
+}
+
+/* See description in logger_writer.h */
+te_errno
+lgr_writer_close(void)
+{
+    te_errno            rc = 0;
+    lgr_writer_batch   *batch;
+    int                 fd = writer.fd;
+
+    if (fd < 0)
+        return 0;
+
+    if (writer.running)
+    {
+        __atomic_store_n(&writer.shutdown, TRUE, __ATOMIC_SEQ_CST);
+        writer_wake();
+        rc = pthread_join(writer.thread, NULL);
+        if (rc != 0)
+            rc = te_rc_os2te(rc);
+        writer.running = FALSE;
+    }
+
+    /* Messages posted when the thread is not running */
+    batch = TE_ALLOC(sizeof(*batch));
+    if (batch != NULL)
+    {
+        do {
+            writer_batch_fill(batch);
+            writer_batch_write(batch);
+        } while (!writer_queue_empty());
+        free(batch);
+    }
+
+    writer.fd = -1;
+    if (close(fd) != 0 && rc == 0)
+        rc = te_rc_os2te(errno);
+
+    close(writer.wake_fd);
+    writer.wake_fd = -1;
+
+    return rc;
+}
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief TE project. Logger subsystem.
+ *
+ * Raw log writer: a dedicated thread which stores log messages
+ * in the raw log file. Logger threads post messages to a lock-free
+ * multiple-producer single-consumer queue, the writer thread coalesces
+ * them into large batches and stores each batch with a single writev().
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_LOGGER_WRITER_H__
+#define __TE_LOGGER_WRITER_H__
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "te_stdint.h"
+#include "logger_bufs.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+/**
+ * Default maximum time (in milliseconds) a message may stay in memory
+ * before it is written to the raw log file.
+ */
+#define LGR_WRITER_FLUSH_INTERVAL_DEF   100
+
+/**
+ * Default size of a batch (in bytes) which is written to the raw log
+ * file as soon as it is collected.
+ */
+#define LGR_WRITER_BATCH_SIZE_DEF       (256 * 1024)
+
+/**
+ * Open the raw log file for appending.
+ *
+ * Messages may be posted right after the file is opened, they are
+ * kept in the queue until the writer thread is started.
+ *
+ * @param path              Raw log file location
+ * @param max_size          Raw log size limit (negative for unlimited)
+ * @param flush_interval    Maximum time (in milliseconds) a message may
+ *                          be kept in memory, @c 0 to write each message
+ *                          as soon as possible
+ * @param batch_size        Size of a batch (in bytes) which is written
+ *                          without waiting for @p flush_interval
+ *
+ * @return Status code.
+ */
+extern te_errno lgr_writer_open(const char *path, int64_t max_size,
+                                unsigned int flush_interval,
+                                size_t batch_size);
+
+/**
+ * Start the writer thread.
+ *
+ * @note It must be called after Logger becomes a daemon.
+ *
+ * @return Status code.
+ */
+extern te_errno lgr_writer_start(void);
+
+/**
+ * Post a message to be written to the raw log file.
+ *
+ * The function does not block and may be called from any thread.
+ *
+ * @param msg           Message buffer, a reference is taken by the writer
+ * @param ignore_limit  Store the message even if the raw log size
+ *                      limit is reached
+ *
+ * @return Status code.
+ * @retval TE_EFBIG     Raw log size limit is reached, the message is
+ *                      dropped.
+ */
+extern te_errno lgr_writer_post(const refcnt_buffer *msg,
+                                te_bool ignore_limit);
+
+/**
+ * Wait until all messages posted before the call are written to
+ * the raw log file.
+ */
+extern void lgr_writer_flush(void);
+
+/**
+ * Write all pending messages, stop the writer thread and close the raw
+ * log file. Messages posted after the call are dropped.
+ *
+ * @return Status code.
+ */
+extern te_errno lgr_writer_close(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* __TE_LOGGER_WRITER_H__ */
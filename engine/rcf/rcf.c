@@ -46,6 +46,9 @@
 #ifdef HAVE_SIGNAL_H
 #include <signal.h>
 #endif
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
 #if HAVE_POPT_H
 #include <popt.h>
 #else
@@ -61,12 +64,15 @@
 #include "te_stdint.h"
 #include "te_printf.h"
 #include "te_str.h"
+#include "te_alloc.h"
+#include "te_dbuf.h"
 #include "rcf.h"
 #include "rcf_tce_parser.h"
 
 #define RCF_NEED_TYPES      1
 #define RCF_NEED_TYPE_LEN   1
 #include "te_proto.h"
+#include "rcf_comm_frame.h"
 
 #include "logger_api.h"
 #include "logger_ten.h"
@@ -112,9 +118,25 @@ static char cmd[RCF_MAX_LEN];   /**< Test Protocol command location */
 static char names[RCF_MAX_LEN - sizeof(rcf_msg)];   /**< TA names */
 static int  names_len = 0;      /**< Length of TA name list */
 
-/* Backup select parameters */
-struct timeval tv0;
-fd_set set0;
+/** Unquoted string arguments of the command (binary framing only) */
+static te_dbuf cmd_args = TE_DBUF_INIT(50);
+/** Number of arguments in cmd_args or -1 if strings are quoted */
+static int     cmd_n_args = -1;
+/** Status of arguments accumulation */
+static te_errno cmd_args_rc = 0;
+/** Command with arguments passed to the communication library */
+static te_dbuf cmd_msg = TE_DBUF_INIT(50);
+
+/** Next unquoted argument of the answer (binary framing only) */
+static char *reply_arg = NULL;
+/** End of unquoted arguments of the answer */
+static char *reply_args_end = NULL;
+
+/** Event loop dispatching TA answers, user requests and timeouts */
+static te_reactor *reactor = NULL;
+
+/** User request is received by IPC server */
+static te_bool user_request_ready = FALSE;
 
 /** Name of directory for temporary files */
 static char *tmp_dir;
@@ -124,6 +146,7 @@ static char *tmp_dir;
 static int write_str(char *s, size_t len);
 static void rcf_ta_check_done(usrreq *req);
 static void send_all_pending_commands(ta *agent);
+static void process_reply(ta *agent);
 
 /*
  * Release memory allocated for Test Agents structures.
@@ -587,6 +610,7 @@ parse_config_ta(xmlNodePtr ta_node)
     agent->waiting.prev = agent->waiting.next = &(agent->waiting);
 
     agent->sid = RCF_SID_UNUSED;
+    agent->conn_fd = -1;
 
     ta_num++;
     return 0;
@@ -703,8 +727,6 @@ parse_config(const char *filename)
 static int
 consume_answer(ta *agent)
 {
-    struct timeval tv;
-    fd_set         set;
     time_t         t0, t;
 
     t = t0 = time(NULL);
@@ -712,10 +734,7 @@ consume_answer(ta *agent)
     {
         char *ba;
 
-        set = set0;
-        tv = tv0;
-        select(FD_SETSIZE, &set, NULL, NULL, &tv);
-        if ((agent->m.is_ready)(agent->handle))
+        if (rcf_ta_wait_ready(agent, TE_SEC2MS(RCF_SELECT_TIMEOUT)))
         {
             size_t len = sizeof(cmd);
 
@@ -842,6 +861,15 @@ rcf_answer_user_request(usrreq *req)
     if (req->message->error != 0)
         req->message->data_len = 0;
 
+    /*
+     * RCF fails the batch itself if the agent is dead, the command
+     * cannot be sent or is timed out: the number of requested items
+     * must not be reported as applied.
+     */
+    if (req->message->opcode == RCFOP_CONFBATCH &&
+        TE_RC_GET_MODULE(req->message->error) == TE_RCF)
+        req->message->num = 0;
+
     if (req->user != NULL)
     {
         int rc;
@@ -875,6 +903,7 @@ rcf_answer_user_request(usrreq *req)
     }
     if (!(req->message->flags & INTERMEDIATE_ANSWER))
     {
+        te_reactor_timer_stop(&req->timer);
         free(req->message);
         if (req->prev != NULL)
             (req->prev)->next = req->next;
@@ -919,6 +948,9 @@ startup_tasks(ta *agent)
     char            *args;
     int rc;
 
+    /* Agent accepts quoted strings with any framing */
+    cmd_n_args = -1;
+
     for (task = agent->initial_tasks; task; task = task->next)
     {
         TE_SPRINTF(cmd, "SID 0 " TE_PROTO_EXECUTE " %s %s",
@@ -964,7 +996,7 @@ rcf_set_ta_dead(ta *agent)
         ERROR("TA '%s' is dead", agent->name);
         rcf_answer_all_requests(&(agent->sent), TE_ETADEAD);
         rcf_answer_all_requests(&(agent->waiting), TE_ETADEAD);
-        rc = (agent->m.close)(agent->handle, &set0);
+        rc = rcf_ta_close_conn(agent);
         if (rc != 0)
             ERROR("Failed to close connection with TA '%s': rc=%r",
                   agent->name, rc);
@@ -989,7 +1021,7 @@ rcf_set_ta_unrecoverable(ta *agent)
 
             if (~agent->flags & TA_DEAD)
             {
-                rc = (agent->m.close)(agent->handle, &set0);
+                rc = rcf_ta_close_conn(agent);
                 if (rc != 0)
                     ERROR("Failed to close connection with TA '%s': "
                           "rc=%r", agent->name, rc);
@@ -1004,6 +1036,60 @@ rcf_set_ta_unrecoverable(ta *agent)
     }
 }
 
+/* See description in rcf.h */
+te_errno
+rcf_ta_close_conn(ta *agent)
+{
+    te_reactor_del_fd(reactor, agent->conn_watch);
+    agent->conn_watch = NULL;
+    agent->conn_fd = -1;
+
+    return (agent->m.close)(agent->handle);
+}
+
+/* See description in rcf.h */
+te_bool
+rcf_ta_wait_ready(ta *agent, int timeout)
+{
+    struct pollfd pfd;
+
+    if ((agent->m.is_ready)(agent->handle))
+        return TRUE;
+
+    /* Agents without connection descriptor are polled */
+    pfd.fd = agent->conn_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    (void)poll(&pfd, agent->conn_fd >= 0 ? 1 : 0, timeout);
+
+    return (agent->m.is_ready)(agent->handle);
+}
+
+/**
+ * Process data pending on the TA connection. It is called by the event
+ * loop when the connection is readable.
+ *
+ * @param fd        Connection descriptor (unused)
+ * @param opaque    Test Agent
+ */
+static void
+rcf_ta_conn_ready(int fd, void *opaque)
+{
+    ta *agent = opaque;
+
+    UNUSED(fd);
+
+    /*
+     * In all reboot states except @c TA_REBOOT_STATE_REBOOTING,
+     * messages may come from the agent
+     */
+    if ((agent->m.is_ready)(agent->handle) &&
+        agent->reboot_ctx.state != TA_REBOOT_STATE_REBOOTING)
+    {
+        process_reply(agent);
+    }
+}
+
 /* See description in rcf.h */
 int
 rcf_init_agent(ta *agent)
@@ -1047,13 +1133,30 @@ rcf_init_agent(ta *agent)
         return rc;
     }
     INFO("TA '%s' started, trying to connect", agent->name);
-    if ((rc = (agent->m.connect)(agent->handle, &set0, &tv0)) != 0)
+    /* Connection may be left open if the TA is marked dead on reboot */
+    te_reactor_del_fd(reactor, agent->conn_watch);
+    agent->conn_watch = NULL;
+    if ((rc = (agent->m.connect)(agent->handle, &agent->conn_fd)) != 0)
     {
         ERROR("Cannot connect to TA '%s' error=%r", agent->name, rc);
+        agent->conn_fd = -1;
         rcf_set_ta_unrecoverable(agent);
         return rc;
     }
     agent->flags &= ~(TA_DEAD | TA_REBOOTING);
+
+    if (agent->conn_fd >= 0)
+    {
+        rc = te_reactor_add_fd(reactor, agent->conn_fd, rcf_ta_conn_ready,
+                               agent, &agent->conn_watch);
+        if (rc != 0)
+        {
+            ERROR("Cannot watch connection with TA '%s' error=%r",
+                  agent->name, rc);
+            rcf_set_ta_unrecoverable(agent);
+            return rc;
+        }
+    }
     INFO("Connected with TA '%s'", agent->name);
 
     if ((rc = rcf_consistency_check(agent)) != 0)
@@ -1225,7 +1328,8 @@ send_all_pending_commands(ta *agent)
 
 /**
  * Read string value from the answer stripping off quotes and escape
- * sequences.
+ * sequences. With binary framing the value is taken from the next
+ * argument element if the answer refers to it.
  *
  * @param ptr           answer pointer
  * @param s             location for string value
@@ -1238,6 +1342,26 @@ read_str(char **ptr, char *s)
     int   quotes = 0,
           cut = 0;
 
+    size_t ref_len = strlen(RCF_COMM_FRAME_ARG_REF);
+
+    if (reply_arg != NULL && reply_arg < reply_args_end &&
+        strncmp(p, RCF_COMM_FRAME_ARG_REF, ref_len) == 0 &&
+        (p[ref_len] == ' ' || p[ref_len] == '\0'))
+    {
+        if (te_strlcpy(s, reply_arg, RCF_MAX_VAL) >= RCF_MAX_VAL)
+        {
+            WARN("Too long string value is received in the answer - "
+                 "cutting\n");
+        }
+        reply_arg += strlen(reply_arg) + 1;
+
+        p += ref_len;
+        while (*p == ' ')
+            p++;
+        *ptr = p;
+        return;
+    }
+
     if (*p == '\"')
     {
         p++;
@@ -1334,6 +1458,16 @@ process_reply(ta *agent)
 
     VERB("Answer \"%s\" is received from TA '%s'", cmd, agent->name);
 
+    if (agent->flags & TA_FRAMED)
+    {
+        reply_arg = cmd + strlen(cmd) + 1;
+        reply_args_end = (ba != NULL) ? ba : cmd + MIN(len, sizeof(cmd));
+    }
+    else
+    {
+        reply_arg = reply_args_end = NULL;
+    }
+
     if (strncmp(ptr, "SID ", strlen("SID ")) != 0)
     {
         if (strstr(ptr, "bad command") != NULL)
@@ -1389,6 +1523,19 @@ process_reply(ta *agent)
     if (error != 0)
         req->message->error = error;
 
+    if (msg->opcode == RCFOP_CONFBATCH)
+    {
+        char *tmp;
+
+        /*
+         * Number of applied items follows status even in the case of
+         * failure. Agents not supporting batches answer "bad command".
+         */
+        msg->num = strtol(ptr, &tmp, 10);
+        if (ptr == tmp || (*tmp != ' ' && *tmp != '\0'))
+            msg->num = -1;
+    }
+
     if (req->cb != NULL)
         error = req->cb(agent, req);
 
@@ -1421,12 +1568,14 @@ process_reply(ta *agent)
             case RCFOP_CONFSET:
             case RCFOP_CONFADD:
             case RCFOP_CONFDEL:
+            case RCFOP_CONFBATCH:
             case RCFOP_VWRITE:
             case RCFOP_FPUT:
             case RCFOP_FDEL:
             case RCFOP_CSAP_DESTROY:
             case RCFOP_KILL:
             case RCFOP_TRPOLL_CANCEL:
+            case RCFOP_LOG_STREAM:
                 break;
 
             case RCFOP_CONFGET:
@@ -1659,8 +1808,28 @@ transmit_cmd(ta *agent, usrreq *req)
     int   file = -1;
     char *data = cmd;
 
-    if (req->message->flags & BINARY_ATTACHMENT &&
-        req->message->opcode != RCFOP_RPC)
+    if (cmd_args_rc != 0)
+    {
+        req->message->error = TE_RC(TE_RCF, cmd_args_rc);
+        ERROR("Failed to prepare arguments of the command to TA '%s'",
+              agent->name);
+        rcf_answer_user_request(req);
+        return -1;
+    }
+
+    if (cmd_n_args > 0)
+    {
+        TE_SNPRINTF(cmd + strlen(cmd), sizeof(cmd) - strlen(cmd),
+                    " args %d", cmd_n_args);
+    }
+
+    if (req->message->opcode == RCFOP_RPC &&
+        req->message->flags & BINARY_ATTACHMENT)
+    {
+        TE_SNPRINTF(cmd + strlen(cmd), sizeof(cmd) - strlen(cmd),
+                    " attach %u", (unsigned int)req->message->intparm);
+    }
+    else if (req->message->flags & BINARY_ATTACHMENT)
     {
         struct stat st;
 
@@ -1687,6 +1856,22 @@ transmit_cmd(ta *agent, usrreq *req)
     VERB("Transmit command \"%s\" to TA '%s'", cmd, agent->name);
 
     len = strlen(cmd) + 1;
+    if (cmd_n_args > 0)
+    {
+        te_dbuf_reset(&cmd_msg);
+        if (te_dbuf_append(&cmd_msg, cmd, len) != 0 ||
+            te_dbuf_append(&cmd_msg, cmd_args.ptr, cmd_args.len) != 0)
+        {
+            req->message->error = TE_RC(TE_RCF, TE_ENOMEM);
+            rcf_answer_user_request(req);
+            if (file != -1)
+                close(file);
+            return -1;
+        }
+        data = (char *)cmd_msg.ptr;
+        len = cmd_msg.len;
+    }
+
     while (TRUE)
     {
         if ((rc = (agent->m.transmit)(agent->handle, data, len)) != 0)
@@ -1728,7 +1913,7 @@ transmit_cmd(ta *agent, usrreq *req)
             rcf_answer_user_request(req);
             return -1;
         }
-
+        data = cmd;
     }
 
     if (file != -1)
@@ -1736,14 +1921,24 @@ transmit_cmd(ta *agent, usrreq *req)
 
     VERB("The command is transmitted to %s", agent->name);
     req->sent = time(NULL);
-    agent->conn_locked = TRUE;
-    agent->lock_sid = req->message->sid;
+    /*
+     * Agent accepting pipelined commands matches answers by SID, so
+     * the connection is locked only by reboot which must be exclusive.
+     */
+    if (!(agent->flags & TA_PIPELINE) ||
+        req->message->opcode == RCFOP_REBOOT)
+    {
+        agent->conn_locked = TRUE;
+        agent->lock_sid = req->message->sid;
+    }
 
     return 0;
 }
 
 /**
  * Write string to the command buffer (inserting '\' before ") and quotes.
+ * With binary framing the string is added to the command arguments
+ * as is and the command refers to it.
  *
  * @param s     string to be filled in
  * @param len   number of symbols to be copied
@@ -1757,6 +1952,21 @@ write_str(char *s, size_t len)
     char   *ptr = ptr0;
     size_t  i = 0;
 
+    if (cmd_n_args >= 0)
+    {
+        te_errno rc;
+
+        rc = te_dbuf_append(&cmd_args, s, strnlen(s, len));
+        if (rc == 0)
+            rc = te_dbuf_append(&cmd_args, "", 1);
+        if (rc != 0 && cmd_args_rc == 0)
+            cmd_args_rc = rc;
+        cmd_n_args++;
+
+        strcpy(ptr0, " " RCF_COMM_FRAME_ARG_REF);
+        return strlen(ptr0);
+    }
+
     *ptr++ = ' ';
     *ptr++ = '\"';
 
@@ -1851,6 +2061,50 @@ print_value(char *cmd, size_t size, unsigned char type, void *value)
     return ret;
 }
 
+/**
+ * Fail the request sent to the TA which is not answered in time
+ * and mark the TA dead.
+ *
+ * @param timer     Expired timer of the request
+ * @param opaque    User request
+ */
+static void
+rcf_req_timeout(te_reactor_timer *timer, void *opaque)
+{
+    usrreq *req = opaque;
+    ta     *agent;
+    size_t  ret;
+    char    time_buf[9];    /* Sufficient for format string used below */
+
+    UNUSED(timer);
+
+    agent = rcf_find_ta_by_name(req->message->ta);
+    if (agent == NULL)
+    {
+        ERROR("Failed to find TA by name '%s'", req->message->ta);
+        return;
+    }
+
+    ret = strftime(time_buf, sizeof(time_buf), "%H:%M:%S",
+                   localtime(&req->sent));
+    if (ret == 0)
+    {
+        ERROR("%s:%d: Buffer is too small", __FILE__, __LINE__);
+        time_buf[0] = '\0';
+    }
+
+    ERROR("Request %u:%d: opcode '%s' id '%s' "
+          "sent to TA '%s' at '%s' is timed out (%u sec)",
+          (unsigned)req->message->seqno, req->message->sid,
+          rcf_op_to_string(req->message->opcode),
+          req->message->id,
+          agent->name, time_buf, (unsigned)req->timeout);
+
+    req->message->error = TE_RC(TE_RCF, TE_ETIMEDOUT);
+    rcf_answer_user_request(req);
+    rcf_set_ta_dead(agent);
+}
+
 /* See description in rcf.h */
 int
 rcf_send_cmd(ta *agent, usrreq *req)
@@ -1894,6 +2148,24 @@ rcf_send_cmd(ta *agent, usrreq *req)
         CHECK_SPACE;                                              \
     } while (0)
 
+/* Put identifier unquoted in text mode or as an argument */
+#define PUT_ID(_id) \
+    do {                                                          \
+        if (cmd_n_args >= 0)                                      \
+        {                                                         \
+            space += write_str((_id), strlen(_id));               \
+            CHECK_SPACE;                                          \
+        }                                                         \
+        else                                                      \
+        {                                                         \
+            PUT(" %s", (_id));                                    \
+        }                                                         \
+    } while (0)
+
+    cmd_n_args = (agent->flags & TA_FRAMED) ? 0 : -1;
+    cmd_args_rc = 0;
+    te_dbuf_reset(&cmd_args);
+
     PUT("SID %d ", msg->sid);
     switch (msg->opcode)
     {
@@ -1905,23 +2177,27 @@ rcf_send_cmd(ta *agent, usrreq *req)
             break;
 
         case RCFOP_CONFGET:
-            PUT(TE_PROTO_CONFGET " %s", msg->id);
+            PUT(TE_PROTO_CONFGET);
+            PUT_ID(msg->id);
             req->timeout = RCF_CMD_TIMEOUT;
             break;
 
         case RCFOP_CONFDEL:
-            PUT(TE_PROTO_CONFDEL " %s", msg->id);
+            PUT(TE_PROTO_CONFDEL);
+            PUT_ID(msg->id);
             req->timeout = RCF_CMD_TIMEOUT;
             break;
 
         case RCFOP_CONFADD:
-            PUT(TE_PROTO_CONFADD " %s", msg->id);
+            PUT(TE_PROTO_CONFADD);
+            PUT_ID(msg->id);
             write_str(msg->value, RCF_MAX_VAL);
             req->timeout = RCF_CMD_TIMEOUT;
             break;
 
         case RCFOP_CONFSET:
-            PUT(TE_PROTO_CONFSET " %s", msg->id);
+            PUT(TE_PROTO_CONFSET);
+            PUT_ID(msg->id);
             write_str(msg->value, RCF_MAX_VAL);
             req->timeout = RCF_CONFSET_TIMEOUT;
             break;
@@ -1936,6 +2212,11 @@ rcf_send_cmd(ta *agent, usrreq *req)
             req->timeout = RCF_CMD_TIMEOUT;
             break;
 
+        case RCFOP_CONFBATCH:
+            PUT(TE_PROTO_CONFBATCH " %d", msg->num);
+            req->timeout = RCF_CONFSET_TIMEOUT;
+            break;
+
         case RCFOP_GET_SNIF_DUMP:
             PUT(TE_PROTO_GET_SNIF_DUMP);
             write_str(msg->id, RCF_MAX_ID);
@@ -1967,15 +2248,30 @@ rcf_send_cmd(ta *agent, usrreq *req)
             req->timeout = RCF_CMD_TIMEOUT_HUGE;
             break;
 
+        case RCFOP_LOG_STREAM:
+            if (msg->sid != RCF_SID_GET_LOG)
+            {
+                msg->error = TE_RC(TE_RCF, TE_EINVAL);
+                rcf_answer_user_request(req);
+                return -1;
+            }
+            PUT(TE_PROTO_LOG_STREAM " %d %u", msg->intparm,
+                (unsigned int)msg->num);
+            req->timeout = RCF_CMD_TIMEOUT;
+            break;
+
         case RCFOP_VREAD:
-            PUT(TE_PROTO_VREAD " %s %s", msg->id, rcf_types[msg->intparm]);
+            PUT(TE_PROTO_VREAD);
+            PUT_ID(msg->id);
+            PUT(" %s", rcf_types[msg->intparm]);
             if (req->timeout == 0)
                 req->timeout = RCF_CMD_TIMEOUT;
             break;
 
         case RCFOP_VWRITE:
-            PUT(TE_PROTO_VWRITE " %s %s ", msg->id,
-                rcf_types[msg->intparm]);
+            PUT(TE_PROTO_VWRITE);
+            PUT_ID(msg->id);
+            PUT(" %s ", rcf_types[msg->intparm]);
             if (msg->intparm == RCF_STRING)
                 write_str(msg->value, RCF_MAX_VAL);
             else
@@ -1986,15 +2282,16 @@ rcf_send_cmd(ta *agent, usrreq *req)
         case RCFOP_FPUT:
         case RCFOP_FGET:
         case RCFOP_FDEL:
-            PUT("%s %s",
+            PUT("%s",
                 msg->opcode == RCFOP_FPUT ? TE_PROTO_FPUT :
-                msg->opcode == RCFOP_FDEL ? TE_PROTO_FDEL : TE_PROTO_FGET,
-                msg->data);
+                msg->opcode == RCFOP_FDEL ? TE_PROTO_FDEL : TE_PROTO_FGET);
+            PUT_ID(msg->data);
             req->timeout = RCF_CMD_TIMEOUT_HUGE;
             break;
 
         case RCFOP_CSAP_CREATE:
-            PUT(TE_PROTO_CSAP_CREATE " %s", msg->id);
+            PUT(TE_PROTO_CSAP_CREATE);
+            PUT_ID(msg->id);
             if (msg->data_len > 0)
                 write_str(msg->data, msg->data_len);
             req->timeout = RCF_CMD_TIMEOUT;
@@ -2006,7 +2303,8 @@ rcf_send_cmd(ta *agent, usrreq *req)
             break;
 
         case RCFOP_CSAP_PARAM:
-            PUT(TE_PROTO_CSAP_PARAM " %u %s", msg->handle, msg->id);
+            PUT(TE_PROTO_CSAP_PARAM " %u", msg->handle);
+            PUT_ID(msg->id);
             req->timeout = RCF_CMD_TIMEOUT;
             break;
 
@@ -2074,7 +2372,7 @@ rcf_send_cmd(ta *agent, usrreq *req)
                     rcf_answer_user_request(req);
                     return -1;
             }
-            PUT(" %s", msg->id);
+            PUT_ID(msg->id);
             if (msg->num >= 0)
                 PUT(" %d", msg->num);
 
@@ -2117,8 +2415,9 @@ rcf_send_cmd(ta *agent, usrreq *req)
 
         case RCFOP_RPC:
         {
-            PUT("%s %s %u ",
-                TE_PROTO_RPC, msg->id, (unsigned)msg->timeout);
+            PUT(TE_PROTO_RPC);
+            PUT_ID(msg->id);
+            PUT(" %u", (unsigned)msg->timeout);
 
             if (msg->intparm < RCF_MAX_VAL &&
                 strcmp_start("<?xml", msg->file) == 0)
@@ -2127,7 +2426,7 @@ rcf_send_cmd(ta *agent, usrreq *req)
             }
             else
             {
-                PUT("attach %u", (unsigned int)msg->intparm);
+                /* Attachment is announced by transmit_cmd() */
                 msg->flags |= BINARY_ATTACHMENT;
             }
             req->timeout = TE_MS2SEC(msg->timeout) + RCF_CMD_TIMEOUT;
@@ -2157,10 +2456,17 @@ rcf_send_cmd(ta *agent, usrreq *req)
             return -1;
     }
 
+#undef PUT_ID
 #undef PUT
 
     if (transmit_cmd(agent, req) == 0)
+    {
         QEL_INSERT(&(agent->sent), req);
+        te_reactor_timer_init(&req->timer, rcf_req_timeout, req);
+        te_reactor_timer_start(reactor, &req->timer,
+                               req->timeout < UINT_MAX / 1000 ?
+                                   TE_SEC2MS(req->timeout) : UINT_MAX);
+    }
 
     return 0;
 }
@@ -2505,6 +2811,7 @@ process_user_request(usrreq *req)
                 agent->waiting.prev = agent->waiting.next = &agent->waiting;
 
                 agent->sid = RCF_SID_UNUSED;
+                agent->conn_fd = -1;
 
                 te_kvpair_init(&agent->conf);
                 if ((agent->name = strdup(msg->ta)) == NULL ||
@@ -2627,12 +2934,8 @@ process_user_request(usrreq *req)
 
                         while (time(NULL) - t < RCF_SHUTDOWN_TIMEOUT)
                         {
-                            struct timeval tv  = tv0;
-                            fd_set         set = set0;
-
-                            select(FD_SETSIZE, &set, NULL, NULL, &tv);
-
-                            if ((agt->m.is_ready)(agt->handle))
+                            if (rcf_ta_wait_ready(agt,
+                                    TE_SEC2MS(RCF_SELECT_TIMEOUT)))
                             {
                                 char    answer[16];
                                 char   *ba;
@@ -2651,7 +2954,7 @@ process_user_request(usrreq *req)
 
                                 INFO("Test Agent '%s' is down", agt->name);
                                 agt->flags |= TA_DOWN;
-                                (agt->m.close)(agt->handle, &set0);
+                                (void)rcf_ta_close_conn(agt);
                                 break; /** Leave current 'while' loop */
                             }
                         }
@@ -2804,8 +3107,8 @@ rcf_shutdown(void)
 {
     ta *agent;
 
-    struct timeval tv;
-    fd_set         set;
+    struct pollfd  *pfds;
+    unsigned int    n_pfds;
 
     time_t t = time(NULL);
 
@@ -2825,11 +3128,23 @@ rcf_shutdown(void)
         rcf_answer_all_requests(&(agent->waiting), TE_EIO);
     }
 
+    pfds = TE_ALLOC(sizeof(*pfds) * (ta_num + 1));
     while (shutdown_num > 0 && time(NULL) - t < RCF_SHUTDOWN_TIMEOUT)
     {
-        tv = tv0;
-        set = set0;
-        select(FD_SETSIZE, &set, NULL, NULL, &tv);
+        n_pfds = 0;
+        for (agent = agents; agent != NULL; agent = agent->next)
+        {
+            if ((agent->flags & (TA_DOWN | TA_DEAD)) == 0 &&
+                agent->conn_fd >= 0)
+            {
+                pfds[n_pfds].fd = agent->conn_fd;
+                pfds[n_pfds].events = POLLIN;
+                pfds[n_pfds].revents = 0;
+                n_pfds++;
+            }
+        }
+        (void)poll(pfds, n_pfds, TE_SEC2MS(RCF_SELECT_TIMEOUT));
+
         for (agent = agents; agent != NULL; agent = agent->next)
         {
             if (agent->flags & (TA_DOWN | TA_DEAD))
@@ -2851,11 +3166,12 @@ rcf_shutdown(void)
 
                 INFO("Test Agent '%s' is down", agent->name);
                 agent->flags |= TA_DOWN;
-                (agent->m.close)(agent->handle, &set0);
+                (void)rcf_ta_close_conn(agent);
                 shutdown_num--;
             }
         }
     }
+    free(pfds);
     for (agent = agents; agent != NULL; agent = agent->next)
     {
         if ((agent->flags & TA_DOWN) == 0)
@@ -2949,6 +3265,22 @@ rcf_daemon(void)
     return 0;
 }
 
+/**
+ * Note that a user request is received by IPC server. It is called
+ * by the event loop.
+ *
+ * @param fd        IPC server descriptor (unused)
+ * @param opaque    Unused
+ */
+static void
+rcf_user_request_ready(int fd, void *opaque)
+{
+    UNUSED(fd);
+    UNUSED(opaque);
+
+    user_request_ready = TRUE;
+}
+
 /**
  * Main routine of the RCF process. Usage: rcf <configuration file name>
  *
@@ -2979,9 +3311,12 @@ main(int argc, const char *argv[])
         goto exit;
     assert(server != NULL);
 
-    FD_ZERO(&set0);
-    tv0.tv_sec = RCF_SELECT_TIMEOUT;
-    tv0.tv_usec = 0;
+    if (te_reactor_create(&reactor) != 0)
+        goto exit;
+
+    if (te_reactor_add_fd(reactor, ipc_get_server_poll_fd(server),
+                          rcf_user_request_ready, NULL, NULL) != 0)
+        goto exit;
 
     INFO("Starting...\n");
 
@@ -3030,29 +3365,20 @@ main(int argc, const char *argv[])
     INFO("Initialization is finished");
     while (1)
     {
-        struct timeval  tv = tv0;
-        fd_set          set = set0;
         size_t          len;
-        time_t          now;
-        int             select_rc;
 
         req = NULL;
-        rc = -1;
 
-        (void)ipc_get_server_fds(server, &set);
-
-        select_rc = select(FD_SETSIZE, &set, NULL, NULL, &tv);
-        if (select_rc < 0)
-        {
-            if (errno != EINTR)
-                ERROR("Unexpected failure of select(): rc=%d, errno=%d",
-                      select_rc, errno);
-            else
-                INFO("select() has been interrupted by signal");
-        }
+        /*
+         * Answers from TAs and expired request timeouts are processed
+         * by callbacks, user requests are processed below.
+         */
+        user_request_ready = FALSE;
+        rc = te_reactor_run(reactor, TE_SEC2MS(RCF_SELECT_TIMEOUT));
+        if (rc != 0)
+            ERROR("Unexpected failure of the event loop: %r", rc);
 
-        if ((select_rc > 0) &&
-            ipc_is_server_ready(server, &set, FD_SETSIZE))
+        if (user_request_ready && ipc_check_server_ready(server))
         {
             len = sizeof(rcf_msg);
 
@@ -3112,62 +3438,12 @@ main(int argc, const char *argv[])
 
         for (agent = agents; agent != NULL; agent = agent->next)
         {
-            usrreq *next;
-
-            /*
-            * In all reboot states except @c TA_REBOOT_STATE_REBOOTING,
-            * messages may come from the agent
-            */
-            if ((agent->m.is_ready)(agent->handle) &&
-                 agent->reboot_ctx.state != TA_REBOOT_STATE_REBOOTING)
-            {
-                process_reply(agent);
-            }
+            /* Agents without connection descriptor are polled */
+            if (agent->conn_watch == NULL && agent->handle != NULL &&
+                !(agent->flags & TA_DEAD))
+                rcf_ta_conn_ready(agent->conn_fd, agent);
 
             rcf_ta_reboot_state_handler(agent);
-
-            now = time(NULL);
-            for (req = agent->sent.next;
-                 req != &(agent->sent);
-                 req = next)
-            {
-                next = req->next;
-
-                if ((uint32_t)(now - req->sent) < req->timeout)
-                    continue;
-
-                if (now < req->sent)
-                {
-                    WARN("Current time is less than request's sent time");
-                    continue;
-                }
-
-                {
-                    size_t  ret;
-                    char    time_buf[9];    /* Sufficient for format
-                                               string used below */
-
-                    ret = strftime(time_buf, sizeof(time_buf), "%H:%M:%S",
-                                   localtime(&req->sent));
-                    if (ret == 0)
-                    {
-                        ERROR("%s:%d: Buffer is too small",
-                              __FILE__, __LINE__);
-                        time_buf[0] = '\0';
-                    }
-
-                    ERROR("Request %u:%d: opcode '%s' id '%s' "
-                          "sent to TA '%s' at '%s' is timed out (%u sec)",
-                          (unsigned)req->message->seqno, req->message->sid,
-                          rcf_op_to_string(req->message->opcode),
-                          req->message->id,
-                          agent->name, time_buf, (unsigned)req->timeout);
-                }
-                req->message->error = TE_RC(TE_RCF, TE_ETIMEDOUT);
-                rcf_answer_user_request(req);
-                rcf_set_ta_dead(agent);
-                break;
-            }
         }
 
         /* If TA check is in progress, may be all checks are done? */
@@ -3183,6 +3459,7 @@ exit:
         rcf_answer_user_request(req);
 
     free_ta_list();
+    te_reactor_destroy(reactor);
     ipc_close_server(server);
 
     rcf_tce_conf_free(tce_conf);
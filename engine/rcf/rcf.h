@@ -20,6 +20,7 @@
 
 #include "te_errno.h"
 #include "te_defs.h"
+#include "te_reactor.h"
 #include "ipc_server.h"
 #include "rcf_methods.h"
 #include "rcf_api.h"
@@ -29,7 +30,7 @@
 extern "C" {
 #endif
 
-/** Default select timeout in seconds */
+/** Maximum time (in seconds) of waiting for events in the main loop */
 #define RCF_SELECT_TIMEOUT      1
 /** Default timeout (in seconds) for command processing on the TA */
 #define RCF_CMD_TIMEOUT         100
@@ -93,6 +94,8 @@ struct usrreq {
     uint32_t                  timeout;  /**< Timeout in seconds */
     time_t                    sent;
     userreq_callback          cb;
+    te_reactor_timer          timer;    /**< Timer of waiting for
+                                             the answer from the TA */
 };
 
 /** A description for a task/thread to be executed at TA startup */
@@ -242,6 +245,11 @@ struct ta {
     struct rcf_talib_methods m; /**< TA-specific Methods */
 
     ta_reboot_context reboot_ctx; /**< Reboot context */
+
+    int                conn_fd;             /**< Connection descriptor
+                                                 or -1 */
+    te_reactor_fd     *conn_watch;          /**< Watch of the connection
+                                                 in the event loop */
 };
 
 /**
@@ -253,8 +261,6 @@ typedef struct ta_check {
 } ta_check;
 
 extern ta_check ta_checker;
-extern fd_set set0;
-extern struct timeval tv0;
 
 /**
  * Obtain TA structure address by Test Agent name.
@@ -302,6 +308,27 @@ extern void rcf_set_ta_dead(ta *agent);
  */
 extern void rcf_set_ta_unrecoverable(ta *agent);
 
+/**
+ * Close connection with the Test Agent and stop watching it
+ * in the event loop.
+ *
+ * @param agent     Test Agent
+ *
+ * @return Status code.
+ */
+extern te_errno rcf_ta_close_conn(ta *agent);
+
+/**
+ * Wait until data from the Test Agent are pending. It is used when
+ * RCF waits for a particular answer outside of the event loop.
+ *
+ * @param agent     Test Agent
+ * @param timeout   Timeout in milliseconds
+ *
+ * @return @c TRUE if data are pending.
+ */
+extern te_bool rcf_ta_wait_ready(ta *agent, int timeout);
+
 /**
  * Initialize Test Agent or recovery it after reboot.
  * Test Agent is marked as "unrecoverable dead" in the case of failure.
@@ -551,12 +551,7 @@ try_soft_shutdown(ta *agent)
     /* TODO: This should be moved to a separate function */
     while (!is_timed_out(t, RCF_SHUTDOWN_TIMEOUT))
     {
-        struct timeval tv  = tv0;
-        fd_set         set = set0;
-
-        select(FD_SETSIZE, &set, NULL, NULL, &tv);
-
-        if ((agent->m.is_ready)(agent->handle))
+        if (rcf_ta_wait_ready(agent, TE_SEC2MS(RCF_SELECT_TIMEOUT)))
         {
             char    answer[16];
             char   *ba;
@@ -575,7 +570,7 @@ try_soft_shutdown(ta *agent)
 
             INFO("Test Agent '%s' is down", agent->name);
             agent->flags |= TA_DOWN;
-            (agent->m.close)(agent->handle, &set0);
+            (void)rcf_ta_close_conn(agent);
             break;
         }
     }
@@ -1005,6 +1005,12 @@ get_script(xmlNodePtr node, tester_cfg *cfg, test_script *script)
     if (rc != 0)
         return rc;
 
+    /* 'zygote' is optional, default value is false */
+    script->zygote = FALSE;
+    rc = get_bool_prop(node, "zygote", &script->zygote);
+    if (rc != 0 && rc != TE_RC(TE_TESTER, TE_ENOENT))
+        return rc;
+
     node = xmlNodeChildren(node);
 
     /* Get optional 'objective' */
@@ -2029,6 +2035,16 @@ alloc_and_get_run_item(xmlNodePtr node, tester_cfg *cfg, unsigned int opts,
         rc = get_uint_prop(node, "iterate", &p->iterate);
         if (rc != 0 && rc != TE_RC(TE_TESTER, TE_ENOENT))
             return rc;
+
+        /* 'parallel' is optional */
+        p->parallel = 1;
+        rc = get_uint_prop(node, "parallel", &p->parallel);
+        if (rc != 0 && rc != TE_RC(TE_TESTER, TE_ENOENT))
+            return rc;
+
+        /* 'resources' is optional */
+        p->resources = XML2CHAR(xmlGetProp(node,
+                                           CONST_CHAR2XML("resources")));
     }
 
     if (opts & TESTER_RUN_ITEM_INHERITABLE)
@@ -2975,6 +2991,7 @@ run_item_free(run_item *run)
     free(run->name);
     free(run->objective);
     free(run->page);
+    free(run->resources);
     switch (run->type)
     {
         case RUN_ITEM_NONE:
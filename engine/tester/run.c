@@ -29,6 +29,7 @@
 #endif
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #if HAVE_PTHREAD_H
 #include <pthread.h>
 #endif
@@ -49,6 +50,8 @@
 #include "tester_term.h"
 #include "tester_run.h"
 #include "tester_result.h"
+#include "tester_sched.h"
+#include "tester_zygote.h"
 #include "tester_interactive.h"
 #include "tester_flags.h"
 #include "tester_serial_thread.h"
@@ -85,6 +88,12 @@
 /** Size of the bulk used to allocate space for a string */
 #define TESTER_STR_BULK 64
 
+/**
+ * Maximum number of subsequent iterations examined to be started
+ * simultaneously with the current one
+ */
+#define TESTER_SCHED_LOOKAHEAD  64
+
 /** Print string which may be NULL. */
 #define PRINT_STRING(_str)  ((_str) ? : "")
 
@@ -151,9 +160,18 @@ typedef struct tester_ctx {
     te_bool             backup_ok;      /**< Optimization to avoid
                                              duplicate (subsequent)
                                              verifications */
+    char               *iter_backup;    /**< Backup of configuration
+                                             subtrees used by the current
+                                             iteration run simultaneously
+                                             with others */
+    te_vec              iter_subtrees;  /**< Subtrees in the iteration
+                                             backup, empty for the whole
+                                             configuration */
 
     test_iter_arg      *args;           /**< Test iteration arguments */
     unsigned int        n_args;         /**< Number of arguments */
+    unsigned int        iter;           /**< Index of the current
+                                             iteration */
 
     struct tester_ctx  *keepalive_ctx;  /**< Keep-alive context */
 
@@ -205,6 +223,14 @@ typedef struct tester_run_data {
     int                         plan_id;    /**< ID of the next run item in
                                                  the plan */
 
+    tester_sched                sched;      /**< Scheduler of iterations
+                                                 run simultaneously */
+    unsigned int                n_scripts;  /**< Number of test scripts
+                                                 executed one by one */
+    uint64_t                    scripts_ns; /**< Total time of test
+                                                 scripts executed one
+                                                 by one */
+
 #if WITH_TRC
     const te_trc_db            *trc_db;     /**< TRC database handle */
     tqh_strings                 trc_tags;   /**< TRC tags */
@@ -219,6 +245,10 @@ static enum interactive_mode_opts tester_run_interactive(
 
 /* Forward declarations */
 static json_t *persons_info_to_json(const persons_info *persons);
+static te_errno run_prepare_args(const test_iter_arg *ctx_args,
+                                 const unsigned int ctx_n_args,
+                                 const run_item *ri, unsigned i_iter,
+                                 test_iter_arg *args);
 
 /* Check whether run item has keepalive handler */
 static te_bool
@@ -753,6 +783,8 @@ tester_run_free_ctx(tester_ctx *ctx)
     }
     logic_expr_free(ctx->dyn_targets);
     test_requirements_free(&ctx->reqs);
+    free(ctx->iter_backup);
+    te_vec_deep_free(&ctx->iter_subtrees);
     tester_run_free_ctx(ctx->keepalive_ctx);
     free(ctx);
 }
@@ -798,6 +830,8 @@ tester_run_new_ctx(tester_flags flags, const logic_expr *targets)
 
     new_ctx->backup = NULL;
     new_ctx->backup_ok = FALSE;
+    new_ctx->iter_backup = NULL;
+    new_ctx->iter_subtrees = TE_VEC_INIT(char *);
     new_ctx->args = NULL;
     /* new_ctx->n_args = 0; */
 
@@ -1581,6 +1615,28 @@ test_params_hash(test_iter_arg *args, unsigned int n_args)
     return hash_str;
 }
 
+/**
+ * Check whether iterations of some test in the session may be run
+ * simultaneously.
+ *
+ * @param session       Test session
+ *
+ * @return @c TRUE if children of the session may be run in parallel.
+ */
+static te_bool
+log_session_parallel(const test_session *session)
+{
+    const run_item *ri;
+
+    TAILQ_FOREACH(ri, &session->run_items, links)
+    {
+        if (ri->type == RUN_ITEM_SCRIPT && ri->parallel > 1)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 /**
  * Log test (script, package, session) start.
  *
@@ -1729,6 +1785,9 @@ log_test_start(unsigned int flags,
             assert(tin == TE_TIN_INVALID);
             SET_JSON_STRING(tmp, "session");
             SET_NEW_JSON(result, "node_type", tmp);
+
+            if (log_session_parallel(&ri->u.session))
+                SET_NEW_JSON(result, "parallel", json_true());
             break;
 
         case RUN_ITEM_PACKAGE:
@@ -1737,6 +1796,9 @@ log_test_start(unsigned int flags,
             SET_JSON_STRING(tmp, "pkg");
             SET_NEW_JSON(result, "node_type", tmp);
 
+            if (log_session_parallel(&ri->u.package->session))
+                SET_NEW_JSON(result, "parallel", json_true());
+
             authors = persons_info_to_json(&ri->u.package->authors);
             if (authors != NULL)
                 SET_NEW_JSON(result, "authors", authors);
@@ -2164,6 +2226,251 @@ run_test_fallback_redir_to_rw(int fdin, te_bool *close_fdin)
     return 0;
 }
 
+/**
+ * Make string with parameters to be passed to the test script.
+ *
+ * @param script        Test script
+ * @param run_name      Run item name or @c NULL
+ * @param exec_id       Test execution ID
+ * @param n_args        Number of arguments
+ * @param args          Arguments to be passed
+ *
+ * @return Allocated string or @c NULL.
+ */
+static char *
+run_test_params_str(const test_script *script, const char *run_name,
+                    test_id exec_id, const unsigned int n_args,
+                    const test_iter_arg *args)
+{
+    char   *params_str = NULL;
+    char   *tmp;
+
+    if (te_asprintf(&params_str,
+                    " te_test_id=%u te_test_name=\"%s\" te_rand_seed=%d",
+                    exec_id, run_name != NULL ? run_name : script->name,
+                    rand()) < 0)
+    {
+        ERROR("%s(): te_asprintf() failed", __FUNCTION__);
+        return NULL;
+    }
+
+    tmp = test_params_to_string(params_str, n_args, args);
+    if (tmp == NULL)
+        free(params_str);
+
+    return tmp;
+}
+
+/**
+ * Get test status by status of the terminated test process.
+ *
+ * @param exec_id       Test execution ID
+ * @param cmd           Command line of the test
+ * @param ret           Status returned by waitpid()
+ * @param status        Location of the test status initialized to
+ *                      TESTER_TEST_INCOMPLETE
+ */
+static void
+run_test_script_exit_status(test_id exec_id, const char *cmd, int ret,
+                            tester_test_status *status)
+{
+#ifdef WCOREDUMP
+    if (WCOREDUMP(ret))
+    {
+        ERROR("Command '%s' executed in shell dumped core", cmd);
+        *status = TESTER_TEST_CORED;
+    }
+#else
+    UNUSED(cmd);
+#endif
+    if (WIFSIGNALED(ret))
+    {
+        if (WTERMSIG(ret) == SIGINT)
+        {
+            *status = TESTER_TEST_STOPPED;
+            ERROR("ID=%d was interrupted by SIGINT, shut down",
+                  exec_id);
+        }
+        else
+        {
+            ERROR("ID=%d was killed by the signal %d : %s", exec_id,
+                  WTERMSIG(ret), strsignal(WTERMSIG(ret)));
+            /* TESTER_TEST_CORED may already be set */
+            if (*status == TESTER_TEST_INCOMPLETE)
+                *status = TESTER_TEST_KILLED;
+        }
+    }
+    else if (!WIFEXITED(ret))
+    {
+        ERROR("ID=%d was abnormally terminated", exec_id);
+        /* TESTER_TEST_CORED may already be set */
+        if (*status == TESTER_TEST_INCOMPLETE)
+            *status = TESTER_TEST_FAILED;
+    }
+    else
+    {
+        if (*status != TESTER_TEST_INCOMPLETE)
+            ERROR("Unexpected return value of system() call");
+
+        switch (WEXITSTATUS(ret))
+        {
+            case EXIT_FAILURE:
+                *status = TESTER_TEST_FAILED;
+                break;
+
+            case EXIT_SUCCESS:
+                *status = TESTER_TEST_PASSED;
+                break;
+
+            case TE_EXIT_SIGUSR2:
+            case TE_EXIT_SIGINT:
+                *status = TESTER_TEST_STOPPED;
+                ERROR("ID=%d was interrupted by %s, shut down",
+                      exec_id,
+                      WEXITSTATUS(ret) == TE_EXIT_SIGINT ? "SIGINT" :
+                                                           "SIGUSR2");
+                break;
+
+            case TE_EXIT_NOT_FOUND:
+                *status = TESTER_TEST_SEARCH;
+                ERROR("ID=%d was not run, executable not found",
+                      exec_id);
+                break;
+            case TE_EXIT_ERROR:
+                *status = TESTER_TEST_STOPPED;
+                ERROR("Serious error occurred during execution of "
+                      "the test, shut down");
+                break;
+
+            case TE_EXIT_SKIP:
+                *status = TESTER_TEST_SKIPPED;
+                break;
+
+            default:
+                *status = TESTER_TEST_FAILED;
+        }
+    }
+}
+
+/**
+ * Get current monotonic time in nanoseconds.
+ */
+static uint64_t
+run_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return TE_SEC2NS((uint64_t)ts.tv_sec) + ts.tv_nsec;
+}
+
+/**
+ * Check whether a test argument is passed to the test in the same way
+ * by the test server and by the shell command line built with
+ * run_test_params_str(). In the command line the value is enclosed in
+ * double quotes with quotation marks and backslashes escaped, so the
+ * shell expands parameters and commands substitutions in it.
+ *
+ * @param value         Argument value
+ *
+ * @return @c TRUE if the value is not changed by the shell.
+ */
+static te_bool
+run_test_zygote_arg_ok(const char *value)
+{
+    return strpbrk(value, "$`") == NULL;
+}
+
+/**
+ * Run test script by the test server of its executable.
+ *
+ * Arguments are passed as is without a shell. Iterations with arguments
+ * which the shell would expand are run as usual to get the same
+ * arguments in both cases.
+ *
+ * @param script        Test script to run
+ * @param run_name      Run item name or @c NULL
+ * @param exec_id       Test execution ID
+ * @param n_args        Number of arguments
+ * @param args          Arguments to be passed
+ * @param status        Location for test status
+ *
+ * @return Status code.
+ * @retval TE_EOPNOTSUPP The test script should be run as usual.
+ */
+static te_errno
+run_test_zygote(const test_script *script, const char *run_name,
+                test_id exec_id, const unsigned int n_args,
+                const test_iter_arg *args, tester_test_status *status)
+{
+    char          **argv;
+    unsigned int    argc = 0;
+    unsigned int    i;
+    int             ret;
+    te_errno        rc = 0;
+
+    if (!script->zygote)
+        return TE_RC(TE_TESTER, TE_EOPNOTSUPP);
+
+    /* Run name is passed in the command line without escaping */
+    if (run_name != NULL &&
+        (!run_test_zygote_arg_ok(run_name) ||
+         strpbrk(run_name, "\\\"") != NULL))
+        return TE_RC(TE_TESTER, TE_EOPNOTSUPP);
+
+    for (i = 0; i < n_args; ++i)
+    {
+        if (!args[i].variable && !run_test_zygote_arg_ok(args[i].value))
+            return TE_RC(TE_TESTER, TE_EOPNOTSUPP);
+    }
+
+    argv = TE_ALLOC((n_args + 3) * sizeof(*argv));
+    if (argv == NULL)
+        return TE_RC(TE_TESTER, TE_ENOMEM);
+
+    if (te_asprintf(&argv[argc++], "te_test_id=%u", exec_id) < 0 ||
+        te_asprintf(&argv[argc++], "te_test_name=%s",
+                    run_name != NULL ? run_name : script->name) < 0 ||
+        te_asprintf(&argv[argc++], "te_rand_seed=%d", rand()) < 0)
+    {
+        argc--;
+        rc = TE_RC(TE_TESTER, TE_ENOMEM);
+    }
+
+    for (i = 0; rc == 0 && i < n_args; ++i)
+    {
+        if (args[i].variable)
+            continue;
+
+        if (te_asprintf(&argv[argc], "%s=%s",
+                        args[i].name, args[i].value) < 0)
+            rc = TE_RC(TE_TESTER, TE_ENOMEM);
+        else
+            argc++;
+    }
+
+    if (rc == 0)
+    {
+        rc = tester_zygote_run(script->execute, argc,
+                               (const char *const *)argv, &ret);
+    }
+
+    if (rc == 0)
+    {
+        *status = TESTER_TEST_INCOMPLETE;
+        run_test_script_exit_status(exec_id, script->execute, ret, status);
+        if (tester_check_serial_stop() == TRUE)
+            *status = TESTER_TEST_STOPPED;
+    }
+
+    for (i = 0; i < argc; ++i)
+        free(argv[i]);
+    free(argv);
+
+    return rc;
+}
+
 /**
  * Run test script in provided context with specified parameters.
  *
@@ -2189,8 +2496,8 @@ run_test_script(test_script *script, const char *run_name, test_id exec_id,
     char        gdb_init[32] = "";
     char        postfix[32] = "";
     char        vg_filename[32] = "";
-    char       *tmp;
     pid_t       pid;
+    te_errno    rc;
 
     assert(status != NULL);
 
@@ -2198,22 +2505,22 @@ run_test_script(test_script *script, const char *run_name, test_id exec_id,
           TE_PRINTF_TESTER_FLAGS "x",
           script->name, exec_id, n_args, args, flags);
 
-    if (te_asprintf(&params_str,
-                    " te_test_id=%u te_test_name=\"%s\" te_rand_seed=%d",
-                    exec_id, run_name != NULL ? run_name : script->name,
-                    rand()) < 0)
+    if ((flags & TESTER_ZYGOTE) &&
+        (flags & (TESTER_FAKE | TESTER_GDB | TESTER_VALGRIND)) == 0)
     {
-        ERROR("%s(): te_asprintf() failed", __FUNCTION__);
-        return TE_RC(TE_TESTER, TE_ENOMEM);
+        rc = run_test_zygote(script, run_name, exec_id, n_args, args,
+                             status);
+        if (TE_RC_GET_ERROR(rc) != TE_EOPNOTSUPP)
+        {
+            EXIT("%u", *status);
+            return rc;
+        }
     }
 
-    tmp = test_params_to_string(params_str, n_args, args);
-    if (tmp == NULL)
-    {
-        free(params_str);
+    params_str = run_test_params_str(script, run_name, exec_id,
+                                     n_args, args);
+    if (params_str == NULL)
         return TE_RC(TE_TESTER, TE_ENOMEM);
-    }
-    params_str = tmp;
 
     if (flags & TESTER_GDB)
     {
@@ -2399,80 +2706,7 @@ run_test_script(test_script *script, const char *run_name, test_id exec_id,
             return TE_OS_RC(TE_TESTER, errno);
         }
 
-#ifdef WCOREDUMP
-        if (WCOREDUMP(ret))
-        {
-            ERROR("Command '%s' executed in shell dumped core", cmd);
-            *status = TESTER_TEST_CORED;
-        }
-#endif
-        if (WIFSIGNALED(ret))
-        {
-            if (WTERMSIG(ret) == SIGINT)
-            {
-                *status = TESTER_TEST_STOPPED;
-                ERROR("ID=%d was interrupted by SIGINT, shut down",
-                      exec_id);
-            }
-            else
-            {
-                ERROR("ID=%d was killed by the signal %d : %s", exec_id,
-                      WTERMSIG(ret), strsignal(WTERMSIG(ret)));
-                /* TESTER_TEST_CORED may already be set */
-                if (*status == TESTER_TEST_INCOMPLETE)
-                    *status = TESTER_TEST_KILLED;
-            }
-        }
-        else if (!WIFEXITED(ret))
-        {
-            ERROR("ID=%d was abnormally terminated", exec_id);
-            /* TESTER_TEST_CORED may already be set */
-            if (*status == TESTER_TEST_INCOMPLETE)
-                *status = TESTER_TEST_FAILED;
-        }
-        else
-        {
-            if (*status != TESTER_TEST_INCOMPLETE)
-                ERROR("Unexpected return value of system() call");
-
-            switch (WEXITSTATUS(ret))
-            {
-                case EXIT_FAILURE:
-                    *status = TESTER_TEST_FAILED;
-                    break;
-
-                case EXIT_SUCCESS:
-                    *status = TESTER_TEST_PASSED;
-                    break;
-
-                case TE_EXIT_SIGUSR2:
-                case TE_EXIT_SIGINT:
-                    *status = TESTER_TEST_STOPPED;
-                    ERROR("ID=%d was interrupted by %s, shut down",
-                          exec_id,
-                          WEXITSTATUS(ret) == TE_EXIT_SIGINT ? "SIGINT" :
-                                                               "SIGUSR2");
-                    break;
-
-                case TE_EXIT_NOT_FOUND:
-                    *status = TESTER_TEST_SEARCH;
-                    ERROR("ID=%d was not run, executable not found",
-                          exec_id);
-                    break;
-                case TE_EXIT_ERROR:
-                    *status = TESTER_TEST_STOPPED;
-                    ERROR("Serious error occurred during execution of "
-                          "the test, shut down");
-                    break;
-
-                case TE_EXIT_SKIP:
-                    *status = TESTER_TEST_SKIPPED;
-                    break;
-
-                default:
-                    *status = TESTER_TEST_FAILED;
-            }
-        }
+        run_test_script_exit_status(exec_id, cmd, ret, status);
         if (flags & TESTER_VALGRIND)
         {
             TE_LOG(TE_LL_INFO, TE_LGR_ENTITY, TE_LGR_USER,
@@ -2570,56 +2804,728 @@ cleanup:
 }
 #endif /* WITH_TRC */
 
-static tester_cfg_walk_ctl
-run_script(run_item *ri, test_script *script,
-           unsigned int cfg_id_off, void *opaque)
+/**
+ * Check whether iterations of the run item may be run simultaneously
+ * in the current state of testing.
+ *
+ * @param gctx          Global Tester context
+ * @param ctx           Current Tester context
+ * @param ri            Run item
+ *
+ * @return @c TRUE if the scheduler should be used.
+ */
+static te_bool
+run_sched_enabled(const tester_run_data *gctx, const tester_ctx *ctx,
+                  const run_item *ri)
 {
-    tester_run_data        *gctx = opaque;
-    tester_ctx             *ctx;
-    tester_cfg_walk_ctl     ctl;
-    tester_flags            def_flags = (gctx->flags & TESTER_FAKE) ?
-                                            TESTER_FAKE : 0;
-
-    assert(gctx != NULL);
-    ctx = SLIST_FIRST(&gctx->ctxs);
-    assert(ctx != NULL);
-    ENTRY("cfg_id_off=%u act=(%d,%d,0x%" TE_PRINTF_TESTER_FLAGS "x) "
-          "act_id=%u script=%s", cfg_id_off,
-          gctx->act != NULL ? (int)gctx->act->first : -1,
-          gctx->act != NULL ? (int)gctx->act->last : -1,
-          gctx->act != NULL ? (gctx->act->flags | def_flags) : def_flags,
-          gctx->act_id, script->name);
+    const tester_flags  no_sched = TESTER_NO_SIMULT | TESTER_FAKE |
+                                   TESTER_GDB | TESTER_VALGRIND |
+                                   TESTER_INTERACTIVE | TESTER_INLOGUE |
+                                   TESTER_PRERUN | TESTER_ASSEMBLE_PLAN |
+                                   TESTER_RUN_WHILE_PASSED |
+                                   TESTER_RUN_WHILE_FAILED |
+                                   TESTER_RUN_WHILE_EXPECTED |
+                                   TESTER_RUN_WHILE_UNEXPECTED;
+
+    if (ri->type != RUN_ITEM_SCRIPT || ri->parallel <= 1 ||
+        ri->weight != 1 || gctx->act == NULL || gctx->act->hash != NULL)
+        return FALSE;
+
+    if ((gctx->flags | gctx->act->flags | ctx->flags) & no_sched)
+        return FALSE;
 
-    if (ctx->flags & (TESTER_PRERUN | TESTER_ASSEMBLE_PLAN))
-    {
-        EXIT("CONT");
-        ctx->current_result.status = TESTER_TEST_PASSED;
-        return TESTER_CFG_WALK_CONT;
-    }
+    /*
+     * Keep-alive validation is done between iterations and exceptions
+     * handlers are called from the middle of the iterations sequence.
+     */
+    if (gctx->force_skip > 0 || gctx->exception > 0 ||
+        (ri->context != NULL && ri->context->keepalive != NULL))
+        return FALSE;
 
-    assert(ri != NULL);
-    assert(ri->n_args == ctx->n_args);
-    if (run_test_script(script, ri->name, ctx->current_result.id,
-                        ctx->n_args, ctx->args,
-                        gctx->act == NULL ? def_flags : /* FIXME */
-                           (gctx->act->flags | def_flags),
-                        &ctx->current_result.status) != 0)
-    {
-        ctx->current_result.status = TESTER_TEST_ERROR;
-    }
+    return TRUE;
+}
 
-    switch (ctx->current_result.status)
-    {
-        case TESTER_TEST_FAKED:
-        case TESTER_TEST_PASSED:
-        case TESTER_TEST_FAILED:
-        case TESTER_TEST_SEARCH:
-        case TESTER_TEST_SKIPPED:
-            ctl = TESTER_CFG_WALK_CONT;
-            break;
+/**
+ * Check whether the iteration is mentioned in the testing plan, i.e.
+ * whether the plan reference ID is incremented for it.
+ *
+ * @param ctx           Current Tester context
+ * @param ri            Run item
+ * @param args          Arguments of the iteration
+ *
+ * @return @c TRUE if the iteration is in the plan.
+ */
+static te_bool
+run_repeat_in_plan(const tester_ctx *ctx, const run_item *ri,
+                   const test_iter_arg *args)
+{
+    return (ctx->flags & TESTER_VERB_SKIP) ||
+           (~ctx->flags & TESTER_QUIET_SKIP) ||
+           tester_is_run_required(ctx->targets, &ctx->reqs,
+                                  ri, args, ctx->flags, TRUE);
+}
 
-        case TESTER_TEST_KILLED:
-        case TESTER_TEST_CORED:
+/**
+ * Add OID of a configuration instance to the vector of subtrees
+ * (callback for cfg_find_pattern_iter_fmt()).
+ *
+ * @param handle        Instance handle
+ * @param opaque        Vector of subtrees
+ *
+ * @return Status code.
+ */
+static te_errno
+run_sched_add_cfg_subtree(cfg_handle handle, void *opaque)
+{
+    te_vec     *subtrees = opaque;
+    char       *oid = NULL;
+    te_errno    rc;
+
+    rc = cfg_get_oid_str(handle, &oid);
+    if (rc != 0)
+        return rc;
+
+    rc = te_vec_append(subtrees, &oid);
+    if (rc != 0)
+        free(oid);
+
+    return rc;
+}
+
+/**
+ * Get configuration subtrees of resources used by the iteration.
+ * A resource starting with '/' is an instance OID, otherwise it is
+ * a name of a Test Agent or of a network interface of Test Agents.
+ *
+ * @param resources     Resources of the iteration
+ * @param subtrees      Vector to add subtrees (@c char *) to
+ *
+ * @return @c TRUE if subtrees of all resources are found.
+ */
+static te_bool
+run_sched_cfg_subtrees(const tqh_strings *resources, te_vec *subtrees)
+{
+    const tqe_string   *res;
+    cfg_handle          handle;
+    size_t              n;
+
+    TAILQ_FOREACH(res, resources, links)
+    {
+        if (res->v[0] == '/')
+        {
+            if (te_vec_append_str_fmt(subtrees, "%s", res->v) != 0)
+                return FALSE;
+            continue;
+        }
+
+        if (cfg_find_fmt(&handle, "/agent:%s", res->v) == 0)
+        {
+            if (te_vec_append_str_fmt(subtrees, "/agent:%s", res->v) != 0)
+                return FALSE;
+            continue;
+        }
+
+        n = te_vec_size(subtrees);
+        if (cfg_find_pattern_iter_fmt(run_sched_add_cfg_subtree, subtrees,
+                                      "/agent:*/interface:%s",
+                                      res->v) != 0 ||
+            te_vec_size(subtrees) == n)
+        {
+            WARN("Configuration subtree of resource '%s' is unknown",
+                 res->v);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Get resources used by the iteration.
+ *
+ * @param ri            Run item
+ * @param args          Arguments of the iteration
+ * @param resources     List to add resources to
+ * @param exclusive     Location for the flag which is set if some
+ *                      resource cannot be determined
+ * @param subtrees      Vector to add configuration subtrees of resources
+ *                      to or @c NULL if configuration is not tracked;
+ *                      it is left empty for an exclusive iteration,
+ *                      i.e. the whole configuration is used
+ *
+ * @return Status code.
+ */
+static te_errno
+run_sched_resources(const run_item *ri, const test_iter_arg *args,
+                    tqh_strings *resources, te_bool *exclusive,
+                    te_vec *subtrees)
+{
+    static const char   sep[] = ", \t\n";
+    const char         *name = ri->resources;
+    size_t              len;
+    unsigned int        i;
+    te_errno            rc;
+
+    /* Configuration used by iterations is unknown if tracked */
+    *exclusive = (name == NULL && subtrees != NULL);
+    if (name == NULL)
+        return 0;
+
+    for (name += strspn(name, sep); *name != '\0';
+         name += len, name += strspn(name, sep))
+    {
+        len = strcspn(name, sep);
+
+        for (i = 0; i < ri->n_args; ++i)
+        {
+            if (strncmp(args[i].name, name, len) == 0 &&
+                args[i].name[len] == '\0')
+                break;
+        }
+
+        if (i == ri->n_args)
+        {
+            WARN("Run item '%s' has no argument '%.*s' listed in "
+                 "resources, its iterations are run exclusively",
+                 run_item_name(ri), (int)len, name);
+            *exclusive = TRUE;
+            continue;
+        }
+
+        rc = tq_strings_add_uniq_dup(resources, args[i].value);
+        if (rc != 0 && rc != 1)
+            return rc;
+    }
+
+    /*
+     * Configuration which cannot be attributed to the iteration
+     * resources may be verified only if nothing else is running.
+     */
+    if (subtrees != NULL &&
+        (*exclusive || !run_sched_cfg_subtrees(resources, subtrees) ||
+         te_vec_size(subtrees) == 0))
+    {
+        *exclusive = TRUE;
+        te_vec_deep_free(subtrees);
+    }
+
+    return 0;
+}
+
+/**
+ * Start the test process of the iteration using the scheduler.
+ *
+ * @param gctx          Global Tester context
+ * @param ri            Run item
+ * @param script        Test script
+ * @param cfg_id_off    Configuration ID of the iteration
+ * @param exec_id       Test execution ID
+ * @param args          Arguments of the iteration
+ * @param resources     Resources used by the iteration
+ * @param exclusive     Whether the iteration conflicts with any other
+ * @param subtrees      Configuration subtrees to backup before the start
+ *                      (moved to the job) or @c NULL if configuration
+ *                      is not tracked
+ * @param p_job         Location for the job
+ *
+ * @return Status code.
+ */
+static te_errno
+run_sched_launch(tester_run_data *gctx, const run_item *ri,
+                 const test_script *script, unsigned int cfg_id_off,
+                 test_id exec_id, const test_iter_arg *args,
+                 tqh_strings *resources, te_bool exclusive,
+                 te_vec *subtrees, tester_sched_job **p_job)
+{
+    char       *params_str;
+    char       *cmd = NULL;
+    char       *backup = NULL;
+    te_errno    rc;
+
+    params_str = run_test_params_str(script, ri->name, exec_id,
+                                     ri->n_args, args);
+    if (params_str == NULL)
+        return TE_RC(TE_TESTER, TE_ENOMEM);
+
+    rc = te_asprintf(&cmd, "%s%s", script->execute, params_str) < 0 ?
+         TE_RC(TE_TESTER, TE_ENOMEM) : 0;
+    free(params_str);
+    if (rc != 0)
+    {
+        ERROR("%s(): te_asprintf() failed", __FUNCTION__);
+        return rc;
+    }
+
+    if (subtrees != NULL)
+    {
+        rc = cfg_create_backup_subtrees(&backup, subtrees);
+        if (rc != 0)
+        {
+            ERROR("Cannot create configuration backup: %r", rc);
+            free(cmd);
+            return rc;
+        }
+    }
+
+    rc = tester_sched_start(&gctx->sched, ri, cfg_id_off, exec_id, cmd,
+                            resources, exclusive, p_job);
+    if (rc != 0)
+    {
+        free(cmd);
+        if (backup != NULL && cfg_release_backup(&backup) != 0)
+            free(backup);
+        return rc;
+    }
+
+    if (subtrees != NULL)
+    {
+        (*p_job)->cfg_backup = backup;
+        (*p_job)->cfg_subtrees = *subtrees;
+        *subtrees = TE_VEC_INIT(char *);
+    }
+
+    return 0;
+}
+
+/**
+ * Start subsequent iterations of the run item which do not conflict
+ * with running ones.
+ *
+ * A started iteration gets the state run_repeat_start() would create
+ * for it: test ID, plan reference ID, registration of the result and
+ * the test start log record (test messages must follow it). When
+ * the walker reaches the iteration, run_repeat_start() takes this state
+ * from the job instead of creating it, and TRC processing and result
+ * logging are done in walker order.
+ *
+ * @param gctx          Global Tester context
+ * @param ctx           Current Tester context
+ * @param ri            Run item
+ * @param script        Test script
+ * @param cfg_id_off    Configuration ID of the current iteration
+ */
+static void
+run_sched_prefetch(tester_run_data *gctx, tester_ctx *ctx, run_item *ri,
+                   const test_script *script, unsigned int cfg_id_off)
+{
+    const tester_ctx   *parent_ctx = SLIST_NEXT(ctx, links);
+    const int           saved_plan_id = ri->plan_id;
+    test_iter_arg      *args;
+    tester_ctx          iter_ctx;
+    tester_sched_job   *job;
+    tqh_strings         resources;
+    te_vec              subtrees = TE_VEC_INIT(char *);
+    te_vec             *p_subtrees = ctx->backup != NULL ? &subtrees : NULL;
+    te_bool             exclusive;
+    te_bool             run;
+    int                 plan_id = gctx->plan_id;
+    unsigned int        iter;
+    unsigned int        id_off;
+    unsigned int        i;
+    te_errno            rc = 0;
+
+    args = TE_ALLOC(MAX(ri->n_args, 1) * sizeof(*args));
+    if (args == NULL)
+        return;
+
+    TAILQ_INIT(&resources);
+    tester_sched_poll(&gctx->sched);
+
+    for (iter = ctx->iter + 1, id_off = cfg_id_off + 1;
+         rc == 0 && !tester_sigint_received && iter < ri->n_iters &&
+         iter <= ctx->iter + TESTER_SCHED_LOOKAHEAD &&
+         id_off <= gctx->act->last &&
+         gctx->sched.n_running < ri->parallel;
+         ++iter, ++id_off)
+    {
+        for (i = 0; i < ri->n_args; ++i)
+            TAILQ_INIT(&args[i].reqs);
+
+        if (ri->n_args > 0)
+        {
+            rc = run_prepare_args(
+                     parent_ctx != NULL ? parent_ctx->args : NULL,
+                     parent_ctx != NULL ? parent_ctx->n_args : 0,
+                     ri, iter, args);
+        }
+        if (rc != 0)
+        {
+            /* Let the walker handle the failure in usual way */
+            goto next;
+        }
+
+        /* Keep plan ID in sync with run_repeat_start() */
+        if (run_repeat_in_plan(ctx, ri, args))
+            plan_id++;
+
+        run = tester_is_run_required(ctx->targets, &ctx->reqs,
+                                     ri, args, ctx->flags, TRUE) &&
+              tester_is_run_required(ctx->targets, &ctx->reqs,
+                                     ri, args, ctx->flags, FALSE) &&
+              tester_sched_find(&gctx->sched, ri, id_off) == NULL;
+        if (!run)
+            goto next;
+
+        rc = run_sched_resources(ri, args, &resources, &exclusive,
+                                 p_subtrees);
+        if (rc != 0 ||
+            tester_sched_conflicts(&gctx->sched, &resources, exclusive))
+        {
+            tq_strings_free(&resources, free);
+            goto next;
+        }
+
+        rc = run_sched_launch(gctx, ri, script, id_off, tester_get_id(),
+                              args, &resources, exclusive, p_subtrees,
+                              &job);
+        if (rc != 0)
+        {
+            ERROR("Failed to start iteration %u of '%s' in advance: %r",
+                  iter, run_item_name(ri), rc);
+            goto next;
+        }
+        tester_test_result_add(&gctx->results, &job->result);
+
+        iter_ctx = *ctx;
+        iter_ctx.args = args;
+        iter_ctx.current_result.id = job->result.id;
+        ri->plan_id = plan_id - 1;
+        log_test_start((gctx->flags & TESTER_OUT_TEST_PARAMS) ?
+                           TESTER_CFG_WALK_OUTPUT_PARAMS : 0,
+                       &iter_ctx, ri, id_off);
+        ri->plan_id = saved_plan_id;
+
+next:
+        te_vec_deep_free(&subtrees);
+        for (i = 0; i < ri->n_args; ++i)
+            test_requirements_free(&args[i].reqs);
+    }
+
+    free(args);
+}
+
+/**
+ * Verify configuration backup of an iteration run using the scheduler
+ * and release it. Only subtrees of the iteration resources are verified
+ * and restored (without rolling back history, since it contains changes
+ * made by other iterations) unless the backup is of the whole
+ * configuration.
+ *
+ * @param backup        Location of the backup name (set to @c NULL)
+ * @param subtrees      Subtrees in the backup, empty for the whole
+ *                      configuration (emptied)
+ * @param track_conf    'track_conf' attribute of the run item
+ * @param status        Status of the iteration to update
+ */
+static void
+run_verify_iter_cfg_backup(char **backup, te_vec *subtrees,
+                           unsigned int track_conf,
+                           tester_test_status *status)
+{
+    const te_vec   *vec = te_vec_size(subtrees) == 0 ? NULL : subtrees;
+    char * const   *subtree;
+    te_errno        rc;
+
+    if (track_conf & TESTER_TRACK_CONF_SYNC)
+    {
+        if (vec == NULL)
+        {
+            cfg_synchronize("/:", TRUE);
+        }
+        else
+        {
+            TE_VEC_FOREACH(subtrees, subtree)
+                cfg_synchronize(*subtree, TRUE);
+        }
+    }
+
+    rc = vec == NULL ? cfg_verify_backup(*backup) :
+                       cfg_verify_backup_subtrees(*backup, vec);
+    if (TE_RC_GET_ERROR(rc) == TE_EBACKUP ||
+        TE_RC_GET_ERROR(rc) == TE_ETADEAD)
+    {
+        if (track_conf & TESTER_TRACK_CONF_MARK_DIRTY)
+        {
+            WARN("Configuration used by the iteration differs from "
+                 "backup - restore");
+        }
+
+        if (vec != NULL)
+            rc = cfg_restore_backup_subtrees(*backup, vec);
+        else if (track_conf & TESTER_TRACK_CONF_ROLLBACK_HISTORY)
+            rc = cfg_restore_backup(*backup);
+        else
+            rc = cfg_restore_backup_nohistory(*backup);
+
+        if (rc != 0)
+        {
+            ERROR("Cannot restore configuration backup: %r", rc);
+            *status = TESTER_TEST_ERROR;
+        }
+        else if (track_conf & TESTER_TRACK_CONF_MARK_DIRTY)
+        {
+            RING("Configuration successfully restored using backup");
+            if (*status < TESTER_TEST_DIRTY)
+                *status = TESTER_TEST_DIRTY;
+        }
+    }
+    else if (rc != 0)
+    {
+        ERROR("Cannot verify configuration backup: %r", rc);
+        *status = TESTER_TEST_ERROR;
+    }
+
+    rc = cfg_release_backup(backup);
+    if (rc != 0)
+    {
+        ERROR("cfg_release_backup() failed: %r", rc);
+        free(*backup);
+        *backup = NULL;
+    }
+    te_vec_deep_free(subtrees);
+}
+
+/**
+ * Run the current iteration of the test script using the scheduler.
+ * The test may have been started in advance, otherwise it is started
+ * as soon as it does not conflict with running tests. Configuration
+ * backup of the iteration is handed over to the context to be verified
+ * by run_repeat_end().
+ *
+ * @param gctx          Global Tester context
+ * @param ctx           Current Tester context
+ * @param ri            Run item
+ * @param script        Test script
+ * @param cfg_id_off    Configuration ID of the iteration
+ *
+ * @return Status code.
+ */
+static te_errno
+run_sched_script(tester_run_data *gctx, tester_ctx *ctx, run_item *ri,
+                 const test_script *script, unsigned int cfg_id_off)
+{
+    tester_sched_job   *job;
+    tqh_strings         resources;
+    te_vec              subtrees = TE_VEC_INIT(char *);
+    te_vec             *p_subtrees = ctx->backup != NULL ? &subtrees : NULL;
+    te_bool             exclusive;
+    te_errno            rc;
+
+    job = tester_sched_find(&gctx->sched, ri, cfg_id_off);
+    if (job == NULL)
+    {
+        TAILQ_INIT(&resources);
+        rc = run_sched_resources(ri, ctx->args, &resources, &exclusive,
+                                 p_subtrees);
+        if (rc == 0)
+        {
+            rc = tester_sched_wait_conflicts(&gctx->sched, &resources,
+                                             exclusive);
+        }
+        if (rc == 0)
+        {
+            rc = run_sched_launch(gctx, ri, script, cfg_id_off,
+                                  ctx->current_result.id, ctx->args,
+                                  &resources, exclusive, p_subtrees,
+                                  &job);
+        }
+        tq_strings_free(&resources, free);
+        te_vec_deep_free(&subtrees);
+        if (rc != 0)
+            return rc;
+
+        /* Result of the test is registered in the context already */
+        job->taken = TRUE;
+    }
+    else if (!job->taken)
+    {
+        tester_test_result_replace(&gctx->results, &job->result,
+                                   &ctx->current_result);
+        job->taken = TRUE;
+    }
+
+    run_sched_prefetch(gctx, ctx, ri, script, cfg_id_off);
+
+    rc = tester_sched_wait(&gctx->sched, job);
+    if (rc != 0)
+        return rc;
+
+    ctx->current_result.status = TESTER_TEST_INCOMPLETE;
+    run_test_script_exit_status(job->result.id, job->cmd, job->wstatus,
+                                &ctx->current_result.status);
+
+    ctx->iter_backup = job->cfg_backup;
+    job->cfg_backup = NULL;
+    te_vec_deep_free(&ctx->iter_subtrees);
+    ctx->iter_subtrees = job->cfg_subtrees;
+    job->cfg_subtrees = TE_VEC_INIT(char *);
+    tester_sched_release(&gctx->sched, job);
+
+    if (tester_check_serial_stop() == TRUE)
+        ctx->current_result.status = TESTER_TEST_STOPPED;
+
+    return 0;
+}
+
+/**
+ * Wait for termination of all tests started by the scheduler.
+ *
+ * @param gctx          Global Tester context
+ */
+static void
+run_sched_drain(tester_run_data *gctx)
+{
+    tester_sched_job *job;
+
+    TAILQ_FOREACH(job, &gctx->sched.jobs, links)
+    {
+        if (tester_sched_wait(&gctx->sched, job) != 0)
+            break;
+    }
+}
+
+/**
+ * Finish iterations of the run item started in advance which have
+ * not been reached by the walker (e.g. since testing is stopped).
+ * Their results are logged without TRC processing to close test nodes
+ * in the log.
+ *
+ * Configuration backups are verified in reverse order of the starts:
+ * an iteration started after termination of a conflicting one has
+ * the configuration left by it as the initial state.
+ *
+ * @param gctx          Global Tester context
+ * @param ctx           Current Tester context
+ * @param ri            Run item
+ */
+static void
+run_sched_flush(tester_run_data *gctx, tester_ctx *ctx, run_item *ri)
+{
+    unsigned int        track_conf = test_get_attrs(ri)->track_conf;
+    tester_test_status  status;
+    tester_sched_job   *job;
+    tester_sched_job   *tmp;
+
+    TAILQ_FOREACH_REVERSE(job, &gctx->sched.jobs, tester_sched_jobs, links)
+    {
+        if (job->owner != ri ||
+            tester_sched_wait(&gctx->sched, job) != 0)
+            continue;
+
+        if (!job->taken)
+        {
+            tester_test_result_del(&gctx->results, &job->result);
+            run_test_script_exit_status(job->result.id, job->cmd,
+                                        job->wstatus, &job->result.status);
+        }
+
+        if (job->cfg_backup != NULL)
+        {
+            status = job->result.status;
+            run_verify_iter_cfg_backup(&job->cfg_backup, &job->cfg_subtrees,
+                                       track_conf, &status);
+            if (!job->taken)
+                job->result.status = status;
+        }
+    }
+
+    /* Backup of the iteration the walker has not finished */
+    if (ctx->iter_backup != NULL)
+    {
+        run_verify_iter_cfg_backup(&ctx->iter_backup, &ctx->iter_subtrees,
+                                   track_conf, &ctx->current_result.status);
+    }
+
+    TAILQ_FOREACH_SAFE(job, &gctx->sched.jobs, links, tmp)
+    {
+        if (job->owner != ri || !job->done)
+            continue;
+
+        if (!job->taken)
+        {
+            tester_test_status_to_te_test_result(job->result.status,
+                                                 &job->result.result,
+                                                 &job->result.error,
+                                                 job->result.id);
+            if (job->result.error == NULL)
+                job->result.error = "Testing stopped before the result "
+                                    "is processed";
+            log_test_result(ctx->group_result.id, &job->result, -1);
+        }
+
+        tester_sched_release(&gctx->sched, job);
+    }
+}
+
+static tester_cfg_walk_ctl
+run_script(run_item *ri, test_script *script,
+           unsigned int cfg_id_off, void *opaque)
+{
+    tester_run_data        *gctx = opaque;
+    tester_ctx             *ctx;
+    tester_cfg_walk_ctl     ctl;
+    tester_flags            def_flags = gctx->flags &
+                                            (TESTER_FAKE | TESTER_ZYGOTE);
+
+    assert(gctx != NULL);
+    ctx = SLIST_FIRST(&gctx->ctxs);
+    assert(ctx != NULL);
+    ENTRY("cfg_id_off=%u act=(%d,%d,0x%" TE_PRINTF_TESTER_FLAGS "x) "
+          "act_id=%u script=%s", cfg_id_off,
+          gctx->act != NULL ? (int)gctx->act->first : -1,
+          gctx->act != NULL ? (int)gctx->act->last : -1,
+          gctx->act != NULL ? (gctx->act->flags | def_flags) : def_flags,
+          gctx->act_id, script->name);
+
+    if (ctx->flags & (TESTER_PRERUN | TESTER_ASSEMBLE_PLAN))
+    {
+        EXIT("CONT");
+        ctx->current_result.status = TESTER_TEST_PASSED;
+        return TESTER_CFG_WALK_CONT;
+    }
+
+    assert(ri != NULL);
+    assert(ri->n_args == ctx->n_args);
+    if (run_sched_enabled(gctx, ctx, ri))
+    {
+        if (run_sched_script(gctx, ctx, ri, script, cfg_id_off) != 0)
+            ctx->current_result.status = TESTER_TEST_ERROR;
+    }
+    else
+    {
+        uint64_t        start_ns = run_now_ns();
+        unsigned int    zygote_runs = tester_zygote_n_runs();
+
+        if (run_test_script(script, ri->name, ctx->current_result.id,
+                            ctx->n_args, ctx->args,
+                            gctx->act == NULL ? def_flags : /* FIXME */
+                               (gctx->act->flags | def_flags),
+                            &ctx->current_result.status) != 0)
+        {
+            ctx->current_result.status = TESTER_TEST_ERROR;
+        }
+
+        /* Iterations run by test servers are accounted separately */
+        if (ctx->current_result.status != TESTER_TEST_FAKED &&
+            tester_zygote_n_runs() == zygote_runs)
+        {
+            gctx->n_scripts++;
+            gctx->scripts_ns += run_now_ns() - start_ns;
+        }
+    }
+
+    switch (ctx->current_result.status)
+    {
+        case TESTER_TEST_FAKED:
+        case TESTER_TEST_PASSED:
+        case TESTER_TEST_FAILED:
+        case TESTER_TEST_SEARCH:
+        case TESTER_TEST_SKIPPED:
+            ctl = TESTER_CFG_WALK_CONT;
+            break;
+
+        case TESTER_TEST_KILLED:
+        case TESTER_TEST_CORED:
             ctl = TESTER_CFG_WALK_EXC;
             break;
 
@@ -2632,6 +3538,13 @@ run_script(run_item *ri, test_script *script,
             break;
     }
 
+    /*
+     * Exception handler, stop or fault processing should not be done
+     * while other tests are still running.
+     */
+    if (ctl != TESTER_CFG_WALK_CONT)
+        run_sched_drain(gctx);
+
     EXIT("%u", ctl);
     return ctl;
 }
@@ -2978,6 +3891,8 @@ run_item_end(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
     assert(ctx != NULL);
     LOG_WALK_ENTRY(cfg_id_off, gctx);
 
+    run_sched_flush(gctx, ctx, ri);
+
     if (!(gctx->flags & (TESTER_FAKE | TESTER_PRERUN | TESTER_ASSEMBLE_PLAN)))
         stop_cmd_monitors(&ri->cmd_monitors);
 
@@ -3849,6 +4764,7 @@ run_iter_start(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
 #if WITH_TRC
     ctx->do_trc_walker = FALSE;
 #endif
+    ctx->iter = iter;
 
     if (~flags & TESTER_CFG_WALK_SERVICE)
     {
@@ -3989,6 +4905,7 @@ run_repeat_start(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
     tester_ctx         *ctx;
     unsigned int        tin;
     char               *hash_str;
+    tester_sched_job   *job = NULL;
     te_errno            rc;
 
     UNUSED(flags);
@@ -4103,12 +5020,7 @@ run_repeat_start(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
      * Increment current plan reference ID if not handling any exceptions
      * and current item is mentioned in the plan
      */
-    if (gctx->exception == 0 &&
-        ((ctx->flags & TESTER_VERB_SKIP) ||
-         (~ctx->flags & TESTER_QUIET_SKIP) ||
-         tester_is_run_required(ctx->targets, &ctx->reqs,
-                                ri, ctx->args, ctx->flags,
-                                TRUE)))
+    if (gctx->exception == 0 && run_repeat_in_plan(ctx, ri, ctx->args))
         gctx->plan_id++;
 
     /* Go inside skipped packages and sessions */
@@ -4138,7 +5050,15 @@ run_repeat_start(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
         return TESTER_CFG_WALK_SKIP;
     }
 
-    ctx->current_result.id = tester_get_id();
+    /*
+     * The test may be started in advance by the scheduler, then its
+     * state is created by run_sched_prefetch() already.
+     */
+    if (ri->type == RUN_ITEM_SCRIPT && (~flags & TESTER_CFG_WALK_SERVICE))
+        job = tester_sched_find(&gctx->sched, ri, cfg_id_off);
+
+    ctx->current_result.id = job != NULL ? job->result.id :
+                                           tester_get_id();
 
     ri->plan_id = gctx->exception == 0 ? gctx->plan_id - 1 : -1;
 
@@ -4147,9 +5067,19 @@ run_repeat_start(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
     /* Test is considered here as run, if such event is logged */
     tester_term_out_start(ctx->flags, ri->type, run_item_name(ri), tin,
                           ctx->group_result.id, ctx->current_result.id);
-    log_test_start(flags, ctx, ri, tin);
 
-    tester_test_result_add(&gctx->results, &ctx->current_result);
+    if (job == NULL)
+    {
+        log_test_start(flags, ctx, ri, tin);
+        tester_test_result_add(&gctx->results, &ctx->current_result);
+    }
+    else
+    {
+        /* Test start is logged when the test is started */
+        tester_test_result_replace(&gctx->results, &job->result,
+                                   &ctx->current_result);
+        job->taken = TRUE;
+    }
 
     /* FIXME: Optimize */
     if (((ctx->flags & TESTER_VERB_SKIP) ||
@@ -4254,8 +5184,23 @@ run_repeat_end(run_item *ri, unsigned int cfg_id_off, unsigned int flags,
     {
         unsigned int    tin;
 
-        /* The last step in test executaion - verification of backup */
-        run_verify_cfg_backup(ctx, test_get_attrs(ri)->track_conf);
+        /*
+         * The last step in test executaion - verification of backup.
+         * Iterations run simultaneously have own backups of used
+         * configuration, see run_sched_script(); the backup of the
+         * run item may contain changes made by other iterations.
+         */
+        if (ctx->iter_backup != NULL)
+        {
+            run_verify_iter_cfg_backup(&ctx->iter_backup,
+                                       &ctx->iter_subtrees,
+                                       test_get_attrs(ri)->track_conf,
+                                       &ctx->current_result.status);
+        }
+        else if (!run_sched_enabled(gctx, ctx, ri))
+        {
+            run_verify_cfg_backup(ctx, test_get_attrs(ri)->track_conf);
+        }
 
         /* Test execution has been finished */
         tester_test_result_del(&gctx->results, &ctx->current_result);
@@ -4650,6 +5595,7 @@ tester_run(testing_scenario   *scenario,
     data.act = TAILQ_FIRST(scenario);
     data.act_id = (data.act != NULL) ? data.act->first : 0;
     data.direction = TESTING_FORWARD;
+    tester_sched_init(&data.sched);
 #if WITH_TRC
     data.trc_db = trc_db;
     TAILQ_INIT(&data.trc_tags);
@@ -4788,6 +5734,15 @@ tester_run(testing_scenario   *scenario,
             rc = TE_RC(TE_TESTER, TE_EFAULT);
     }
 
+    tester_sched_report(&data.sched);
+    tester_zygote_shutdown();
+    if (data.n_scripts > 0)
+    {
+        RING("%u test scripts are executed one by one, %.3f ms per "
+             "script on average", data.n_scripts,
+             data.scripts_ns / 1e6 / data.n_scripts);
+    }
+
     tester_run_destroy_ctx(&data);
     scenario_free(&data.fixed_scen);
 #if WITH_TRC
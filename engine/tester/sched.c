@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Tester Subsystem
+ *
+ * Scheduler of test iterations run simultaneously.
+ *
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "Scheduler"
+
+#include "te_config.h"
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "te_defs.h"
+#include "te_alloc.h"
+#include "logger_api.h"
+#include "te_shell_cmd.h"
+
+#include "tester_defs.h"
+#include "tester_sched.h"
+
+/** Get current monotonic time in nanoseconds */
+static uint64_t
+sched_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return TE_SEC2NS((uint64_t)ts.tv_sec) + ts.tv_nsec;
+}
+
+/** Account termination of the job process */
+static void
+sched_job_done(tester_sched *sched, tester_sched_job *job, int wstatus)
+{
+    job->done = TRUE;
+    job->wstatus = wstatus;
+    job->end_ns = sched_now_ns();
+
+    sched->busy_ns += job->end_ns - job->start_ns;
+    assert(sched->n_running > 0);
+    if (--sched->n_running == 0)
+        sched->wall_ns += job->end_ns - sched->wall_start;
+}
+
+/** Forward a signal to process groups of all running jobs */
+static void
+sched_kill_all(tester_sched *sched, int sig)
+{
+    tester_sched_job *job;
+
+    TAILQ_FOREACH(job, &sched->jobs, links)
+    {
+        if (!job->done)
+            kill(-job->pid, sig);
+    }
+}
+
+/** Check whether two sets of resources intersect */
+static te_bool
+sched_resources_intersect(const tqh_strings *r1, const tqh_strings *r2)
+{
+    const tqe_string *s1;
+    const tqe_string *s2;
+
+    TAILQ_FOREACH(s1, r1, links)
+    {
+        TAILQ_FOREACH(s2, r2, links)
+        {
+            if (strcmp(s1->v, s2->v) == 0)
+                return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * Check whether a running job or a terminated job with unverified
+ * configuration backup conflicts with the resources.
+ */
+static te_bool
+sched_job_conflicts(const tester_sched_job *job,
+                    const tqh_strings *resources, te_bool exclusive)
+{
+    if (job->done && job->cfg_backup == NULL)
+        return FALSE;
+
+    return exclusive || job->exclusive ||
+           sched_resources_intersect(&job->resources, resources);
+}
+
+/* See description in tester_sched.h */
+void
+tester_sched_init(tester_sched *sched)
+{
+    memset(sched, 0, sizeof(*sched));
+    TAILQ_INIT(&sched->jobs);
+}
+
+/* See description in tester_sched.h */
+te_errno
+tester_sched_start(tester_sched *sched, const void *owner,
+                   unsigned int cfg_id_off, test_id id,
+                   char *cmd, tqh_strings *resources, te_bool exclusive,
+                   tester_sched_job **p_job)
+{
+    tester_sched_job   *job;
+    int                 fdin;
+    te_errno            rc;
+
+    job = TE_ALLOC(sizeof(*job));
+    if (job == NULL)
+        return TE_RC(TE_TESTER, TE_ENOMEM);
+
+    job->owner = owner;
+    job->cfg_id_off = cfg_id_off;
+    job->exclusive = exclusive;
+    job->cfg_subtrees = TE_VEC_INIT(char *);
+    TAILQ_INIT(&job->resources);
+    rc = tq_strings_move(&job->resources, resources);
+    if (rc != 0)
+    {
+        free(job);
+        return rc;
+    }
+
+    job->result.id = id;
+    job->result.status = TESTER_TEST_INCOMPLETE;
+    te_test_result_init(&job->result.result);
+#if WITH_TRC
+    job->result.exp_result = NULL;
+    job->result.exp_status = TRC_VERDICT_UNKNOWN;
+#endif
+
+    VERB("ID=%d te_shell_cmd(%s)", id, cmd);
+    job->pid = te_shell_cmd(cmd, -1, &fdin, NULL, NULL);
+    if (job->pid < 0)
+    {
+        rc = TE_OS_RC(TE_TESTER, errno);
+        ERROR("te_shell_cmd(%s) failed: %r", cmd, rc);
+        tq_strings_free(&job->resources, free);
+        free(job);
+        return rc;
+    }
+    /* Simultaneously run tests do not share Tester standard input */
+    close(fdin);
+
+    job->cmd = cmd;
+    job->start_ns = sched_now_ns();
+    if (sched->n_running++ == 0)
+        sched->wall_start = job->start_ns;
+    sched->max_running = MAX(sched->max_running, sched->n_running);
+    sched->n_jobs++;
+
+    TAILQ_INSERT_TAIL(&sched->jobs, job, links);
+    *p_job = job;
+
+    return 0;
+}
+
+/* See description in tester_sched.h */
+tester_sched_job *
+tester_sched_find(const tester_sched *sched, const void *owner,
+                  unsigned int cfg_id_off)
+{
+    tester_sched_job *job;
+
+    TAILQ_FOREACH(job, &sched->jobs, links)
+    {
+        if (job->owner == owner && job->cfg_id_off == cfg_id_off)
+            return job;
+    }
+
+    return NULL;
+}
+
+/* See description in tester_sched.h */
+te_bool
+tester_sched_conflicts(const tester_sched *sched,
+                       const tqh_strings *resources, te_bool exclusive)
+{
+    const tester_sched_job *job;
+
+    TAILQ_FOREACH(job, &sched->jobs, links)
+    {
+        if (sched_job_conflicts(job, resources, exclusive))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* See description in tester_sched.h */
+void
+tester_sched_poll(tester_sched *sched)
+{
+    tester_sched_job   *job;
+    int                 wstatus;
+
+    TAILQ_FOREACH(job, &sched->jobs, links)
+    {
+        if (!job->done && waitpid(job->pid, &wstatus, WNOHANG) > 0)
+            sched_job_done(sched, job, wstatus);
+    }
+}
+
+/* See description in tester_sched.h */
+te_errno
+tester_sched_wait(tester_sched *sched, tester_sched_job *job)
+{
+    te_bool     interrupted = FALSE;
+    int         wstatus;
+    te_errno    rc;
+
+    while (!job->done)
+    {
+        if (tester_sigint_received && !interrupted)
+        {
+            sched_kill_all(sched, SIGINT);
+            interrupted = TRUE;
+        }
+
+        if (waitpid(job->pid, &wstatus, 0) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            rc = TE_OS_RC(TE_TESTER, errno);
+            ERROR("waitpid() for ID=%d failed: %r", job->result.id, rc);
+            return rc;
+        }
+
+        sched_job_done(sched, job, wstatus);
+    }
+
+    return 0;
+}
+
+/* See description in tester_sched.h */
+te_errno
+tester_sched_wait_conflicts(tester_sched *sched,
+                            const tqh_strings *resources, te_bool exclusive)
+{
+    tester_sched_job   *job;
+    te_errno            rc;
+
+    TAILQ_FOREACH(job, &sched->jobs, links)
+    {
+        if (sched_job_conflicts(job, resources, exclusive))
+        {
+            rc = tester_sched_wait(sched, job);
+            if (rc != 0)
+                return rc;
+        }
+    }
+
+    return 0;
+}
+
+/* See description in tester_sched.h */
+void
+tester_sched_release(tester_sched *sched, tester_sched_job *job)
+{
+    assert(job->done);
+
+    TAILQ_REMOVE(&sched->jobs, job, links);
+    te_test_result_clean(&job->result.result);
+    tq_strings_free(&job->resources, free);
+    free(job->cfg_backup);
+    te_vec_deep_free(&job->cfg_subtrees);
+    free(job->cmd);
+    free(job);
+}
+
+/* See description in tester_sched.h */
+void
+tester_sched_report(const tester_sched *sched)
+{
+    if (sched->n_jobs == 0)
+        return;
+
+    RING("Simultaneous run of %u test iterations (at most %u at the "
+         "same time): tests time %.3f s, elapsed time %.3f s, "
+         "speed-up %.2f", sched->n_jobs, sched->max_running,
+         sched->busy_ns / 1e9, sched->wall_ns / 1e9,
+         sched->wall_ns == 0 ? 1.0 :
+             (double)sched->busy_ns / sched->wall_ns);
+}
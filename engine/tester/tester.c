@@ -43,6 +43,7 @@
 
 #if WITH_TRC
 #include "te_trc.h"
+#include "trc_db.h"
 #endif
 
 #include "tester_serial_thread.h"
@@ -173,6 +174,7 @@ process_cmd_line_opts(tester_global *global, int argc, char **argv)
         TESTER_OPT_NO_CFG_TRACK,
         TESTER_OPT_NO_LOGUES,
         TESTER_OPT_NO_SIMULT,
+        TESTER_OPT_ZYGOTE,
         TESTER_OPT_ONLY_REQ_LOGUES,
 
         TESTER_OPT_REQ,
@@ -258,12 +260,19 @@ process_cmd_line_opts(tester_global *global, int argc, char **argv)
           "command line. This may not work well if your prologues "
           "can add requirements on their own in /local:/reqs:", NULL },
 
-#if 0
         { "no-simultaneous", '\0', POPT_ARG_NONE, NULL,
           TESTER_OPT_NO_SIMULT,
-          "Force to run all tests in series. Useful for debugging.",
+          "Force to run all tests in series (ignore 'parallel' "
+          "attribute of run items). Useful for debugging.",
+          NULL },
+
+        { "zygote", '\0', POPT_ARG_NONE, NULL,
+          TESTER_OPT_ZYGOTE,
+          "Start test executables marked with 'zygote' attribute in "
+          "package description once as test servers which fork "
+          "a process per iteration instead of executing them for "
+          "every iteration (standard input is not passed to tests).",
           NULL },
-#endif
 
         { "req", 'R', POPT_ARG_STRING, NULL, TESTER_OPT_REQ,
           "Requirements to be tested (logical expression).",
@@ -434,6 +443,10 @@ process_cmd_line_opts(tester_global *global, int argc, char **argv)
                 global->flags |= TESTER_NO_SIMULT;
                 break;
 
+            case TESTER_OPT_ZYGOTE:
+                global->flags |= TESTER_ZYGOTE;
+                break;
+
             case TESTER_OPT_NO_RUN:
                 global->flags |= TESTER_NO_RUN;
                 break;
@@ -632,8 +645,10 @@ process_cmd_line_opts(tester_global *global, int argc, char **argv)
                     /* Initialize TRC instance, if necessary */
                     if (rc == TESTER_OPT_TRC_DB)
                     {
-                        rc = trc_db_open(poptGetOptArg(optCon),
-                                         &global->trc_db);
+                        rc = trc_db_open_ext(poptGetOptArg(optCon),
+                                             &global->trc_db,
+                                             TRC_OPEN_CACHE |
+                                             TRC_OPEN_LAZY);
                         if (rc != 0)
                         {
                             poptFreeContext(optCon);
@@ -164,6 +164,8 @@ typedef struct test_script {
     char               *objective;  /**< Objective */
     char               *page;       /**< HTML page with documentation */
     char               *execute;    /**< Full path to executable */
+    te_bool             zygote;     /**< The executable may be run as
+                                         a test server */
     test_requirements   reqs;       /**< Set of requirements */
     test_attrs          attrs;      /**< Test attributes */
 } test_script;
@@ -294,6 +296,11 @@ struct run_item {
     unsigned int        n_iters;    /**< Number of iterations */
     unsigned int        weight;     /**< Number of children iterations
                                          in single iteration */
+    unsigned int        parallel;   /**< Maximum number of iterations
+                                         run simultaneously */
+    char               *resources;  /**< Comma-separated names of
+                                         arguments which values identify
+                                         resources used by an iteration */
 
     cmd_monitor_descrs  cmd_monitors; /**< Command monitors descriptions */
 };
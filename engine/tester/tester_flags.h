@@ -115,6 +115,9 @@ typedef uint64_t tester_flags;
 /** Gather the execution plan */
 #define TESTER_ASSEMBLE_PLAN          (1LLU << 37)
 
+/** Run test executables as test servers forking a process per iteration */
+#define TESTER_ZYGOTE                 (1LLU << 38)
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
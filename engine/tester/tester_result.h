@@ -156,6 +156,28 @@ tester_test_result_del(tester_test_results *results,
     pthread_mutex_unlock(&results->lock);
 }
 
+/**
+ * Replace a result in the list of tests which are in progress.
+ * Verdicts and artifacts collected in the replaced result are moved
+ * to the new one.
+ *
+ * @param results       List of results
+ * @param old           Result to be extracted
+ * @param result        Result to be added
+ */
+static inline void
+tester_test_result_replace(tester_test_results *results,
+                           tester_test_result *old,
+                           tester_test_result *result)
+{
+    pthread_mutex_lock(&results->lock);
+    SLIST_REMOVE(&results->list, old, tester_test_result, links);
+    TAILQ_CONCAT(&result->result.verdicts, &old->result.verdicts, links);
+    TAILQ_CONCAT(&result->result.artifacts, &old->result.artifacts, links);
+    SLIST_INSERT_HEAD(&results->list, result, links);
+    pthread_mutex_unlock(&results->lock);
+}
+
 /**
  * Start test messages listener.
  *
@@ -0,0 +1,193 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Tester Subsystem
+ *
+ * Scheduler of test iterations run simultaneously.
+ *
+ * Iterations of a run item may declare resources they use (values of
+ * arguments listed in 'resources' attribute of the run item, e.g. names
+ * of Test Agents or interfaces). Iterations which do not share any
+ * resource may be run at the same time. The scheduler keeps track of
+ * running test processes and their resources and accounts time spent
+ * by tests to report the speed-up achieved.
+ *
+ * If configuration is tracked, a job keeps a backup of configuration
+ * subtrees of its resources taken before the test is started. Such job
+ * keeps conflicting with other jobs after termination until the backup
+ * is handed over to the walker to be verified, so that a test started
+ * meanwhile cannot change the subtrees.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_TESTER_SCHED_H__
+#define __TE_TESTER_SCHED_H__
+
+#include <sys/types.h>
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "te_queue.h"
+#include "tq_string.h"
+#include "te_vector.h"
+
+#include "tester_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Test process started by the scheduler */
+typedef struct tester_sched_job {
+    TAILQ_ENTRY(tester_sched_job) links;    /**< List links */
+
+    const void         *owner;      /**< Run item the job belongs to */
+    unsigned int        cfg_id_off; /**< Configuration ID of the iteration */
+    char               *cmd;        /**< Command line */
+    tqh_strings         resources;  /**< Resources used by the job */
+    te_bool             exclusive;  /**< The job conflicts with any other
+                                         job (resources are unknown) */
+    char               *cfg_backup; /**< Configuration backup taken before
+                                         the start which is not verified
+                                         yet or @c NULL */
+    te_vec              cfg_subtrees; /**< Configuration subtrees
+                                           (@c char *) in the backup,
+                                           empty for the whole
+                                           configuration */
+    tester_test_result  result;     /**< Result to collect verdicts until
+                                         the job is taken by the walker */
+    te_bool             taken;      /**< Result has been handed over */
+
+    pid_t               pid;        /**< Process ID */
+    te_bool             done;       /**< The process has terminated */
+    int                 wstatus;    /**< Status returned by waitpid() */
+    uint64_t            start_ns;   /**< Start timestamp */
+    uint64_t            end_ns;     /**< Termination timestamp */
+} tester_sched_job;
+
+/** Scheduler of simultaneously running tests */
+typedef struct tester_sched {
+    TAILQ_HEAD(tester_sched_jobs, tester_sched_job) jobs;
+                                /**< Jobs which are not released yet */
+    unsigned int    n_running;  /**< Number of running processes */
+    unsigned int    max_running;/**< Maximum number of processes run at
+                                     the same time */
+    unsigned int    n_jobs;     /**< Total number of jobs started */
+    uint64_t        busy_ns;    /**< Total time spent by jobs */
+    uint64_t        wall_ns;    /**< Time when at least one job has been
+                                     running */
+    uint64_t        wall_start; /**< Timestamp when the first of currently
+                                     running jobs has been started */
+} tester_sched;
+
+/**
+ * Initialize the scheduler.
+ *
+ * @param sched         Scheduler
+ */
+extern void tester_sched_init(tester_sched *sched);
+
+/**
+ * Start a test process. Standard input of the process is closed.
+ *
+ * @param sched         Scheduler
+ * @param owner         Run item the job belongs to
+ * @param cfg_id_off    Configuration ID of the iteration
+ * @param id            Test ID
+ * @param cmd           Command line (owned by the job on success)
+ * @param resources     Resources used by the job (moved to the job,
+ *                      released on failure)
+ * @param exclusive     Whether the job conflicts with any other job
+ * @param p_job         Location for the job
+ *
+ * @return Status code.
+ */
+extern te_errno tester_sched_start(tester_sched *sched, const void *owner,
+                                   unsigned int cfg_id_off, test_id id,
+                                   char *cmd, tqh_strings *resources,
+                                   te_bool exclusive,
+                                   tester_sched_job **p_job);
+
+/**
+ * Find a job of the iteration.
+ *
+ * @param sched         Scheduler
+ * @param owner         Run item
+ * @param cfg_id_off    Configuration ID of the iteration
+ *
+ * @return Job or @c NULL.
+ */
+extern tester_sched_job *tester_sched_find(const tester_sched *sched,
+                                           const void *owner,
+                                           unsigned int cfg_id_off);
+
+/**
+ * Check whether a job with specified resources would conflict with
+ * any running job or a terminated job with configuration backup which
+ * is not verified yet.
+ *
+ * @param sched         Scheduler
+ * @param resources     Resources
+ * @param exclusive     Whether the job conflicts with any other job
+ *
+ * @return @c TRUE if there is a conflict.
+ */
+extern te_bool tester_sched_conflicts(const tester_sched *sched,
+                                      const tqh_strings *resources,
+                                      te_bool exclusive);
+
+/**
+ * Collect status of terminated processes without blocking.
+ *
+ * @param sched         Scheduler
+ */
+extern void tester_sched_poll(tester_sched *sched);
+
+/**
+ * Wait for termination of the job process. If SIGINT is received by
+ * the Tester, it is forwarded to all running jobs.
+ *
+ * @param sched         Scheduler
+ * @param job           Job
+ *
+ * @return Status code.
+ */
+extern te_errno tester_sched_wait(tester_sched *sched,
+                                  tester_sched_job *job);
+
+/**
+ * Wait for termination of all running jobs conflicting with the given
+ * resources.
+ *
+ * @param sched         Scheduler
+ * @param resources     Resources
+ * @param exclusive     Whether all running jobs are conflicting
+ *
+ * @return Status code.
+ */
+extern te_errno tester_sched_wait_conflicts(tester_sched *sched,
+                                            const tqh_strings *resources,
+                                            te_bool exclusive);
+
+/**
+ * Release the job. The process must be terminated. Configuration backup
+ * of the job, if any, should be released by the caller before.
+ *
+ * @param sched         Scheduler
+ * @param job           Job
+ */
+extern void tester_sched_release(tester_sched *sched,
+                                 tester_sched_job *job);
+
+/**
+ * Log statistics of simultaneous run: total time spent by tests, time
+ * when at least one test has been running and the speed-up.
+ *
+ * @param sched         Scheduler
+ */
+extern void tester_sched_report(const tester_sched *sched);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* !__TE_TESTER_SCHED_H__ */
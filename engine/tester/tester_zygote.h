@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Tester Subsystem
+ *
+ * Test servers (zygotes).
+ *
+ * A test executable may be started once as a test server which stays
+ * resident and forks a process per test iteration requested by Tester
+ * (see te_test_zygote_serve()). It avoids exec of the test executable
+ * and its dynamic linking for every iteration.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_TESTER_ZYGOTE_H__
+#define __TE_TESTER_ZYGOTE_H__
+
+#include "te_defs.h"
+#include "te_errno.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Run the test iteration by the test server of the executable.
+ * The server is started on the first request.
+ *
+ * @param execute       Test executable
+ * @param argc          Number of test arguments
+ * @param argv          Test arguments
+ * @param wstatus       Location for the status returned by waitpid()
+ *                      for the test process
+ *
+ * @return Status code.
+ * @retval TE_EOPNOTSUPP The executable does not support the server
+ *                      mode, the test should be run as usual.
+ */
+extern te_errno tester_zygote_run(const char *execute, unsigned int argc,
+                                  const char *const *argv, int *wstatus);
+
+/**
+ * Get the number of test iterations run by test servers so far.
+ *
+ * @return Number of iterations.
+ */
+extern unsigned int tester_zygote_n_runs(void);
+
+/**
+ * Stop all test servers and log the number of test iterations run
+ * by them.
+ */
+extern void tester_zygote_shutdown(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* !__TE_TESTER_ZYGOTE_H__ */
@@ -0,0 +1,422 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Tester Subsystem
+ *
+ * Test servers (zygotes) which fork a process per test iteration.
+ *
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "Zygote"
+
+#include "te_config.h"
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "te_alloc.h"
+#include "te_queue.h"
+#include "te_printf.h"
+#include "logger_api.h"
+#include "te_shell_cmd.h"
+#include "tester_msg.h"
+
+#include "tester_defs.h"
+#include "tester_serial_thread.h"
+#include "tester_zygote.h"
+
+/** Time to wait for the test server to report readiness, milliseconds */
+#define TESTER_ZYGOTE_START_TIMEOUT     10000
+
+/**
+ * Interval of checking whether the test server is alive while waiting
+ * for its messages, milliseconds. The control socket may be held by
+ * processes the server has started, so its closure cannot be relied on.
+ */
+#define TESTER_ZYGOTE_POLL_INTERVAL     1000
+
+/** Test server of a test executable */
+typedef struct tester_zygote {
+    SLIST_ENTRY(tester_zygote) links;   /**< List links */
+
+    char       *execute;        /**< Test executable */
+    te_bool     unsupported;    /**< The executable cannot be run as
+                                     a test server */
+    pid_t       pid;            /**< Server process ID or @c -1 */
+    int         sock;           /**< Control socket or @c -1 */
+} tester_zygote;
+
+/** Test servers started by Tester */
+static SLIST_HEAD(, tester_zygote) zygotes =
+    SLIST_HEAD_INITIALIZER(zygotes);
+
+/** Number of test iterations run by test servers */
+static unsigned int zygote_runs = 0;
+
+/** Total time of test iterations run by test servers, nanoseconds */
+static uint64_t zygote_runs_ns = 0;
+
+/**
+ * Get current monotonic time in nanoseconds.
+ */
+static uint64_t
+zygote_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return TE_SEC2NS((uint64_t)ts.tv_sec) + ts.tv_nsec;
+}
+
+/**
+ * Stop the test server.
+ *
+ * @param zygote        Test server
+ * @param force         Kill the server and its test process
+ */
+static void
+zygote_stop(tester_zygote *zygote, te_bool force)
+{
+    int status;
+
+    if (zygote->sock >= 0)
+    {
+        close(zygote->sock);
+        zygote->sock = -1;
+    }
+
+    if (zygote->pid > 0)
+    {
+        if (force)
+            kill(-zygote->pid, SIGKILL);
+
+        while (waitpid(zygote->pid, &status, 0) < 0 && errno == EINTR)
+            ;
+        zygote->pid = -1;
+    }
+}
+
+/**
+ * Receive a message from the test server. If SIGINT is received by
+ * the Tester, it is forwarded to the running test process.
+ *
+ * @param zygote        Test server
+ * @param test_pid      Running test process or @c -1
+ * @param type          Expected type of the message
+ * @param timeout       Timeout in milliseconds or @c -1 to wait while
+ *                      the server is alive
+ * @param msg           Location for the message
+ *
+ * @return Status code.
+ * @retval TE_ETIMEDOUT     No message is received in time.
+ * @retval TE_ECONNRESET    The server has terminated.
+ */
+static te_errno
+zygote_recv(tester_zygote *zygote, pid_t test_pid,
+            te_test_zygote_msg_type type, int timeout,
+            tester_zygote_msg *msg)
+{
+    struct pollfd   pfd = { .fd = zygote->sock, .events = POLLIN };
+    te_bool         interrupted = FALSE;
+    uint64_t        deadline = zygote_now_ns() + TE_MS2NS(MAX(timeout, 0));
+    int             status;
+    int             ret;
+    ssize_t         len;
+
+    for (;;)
+    {
+        if (tester_sigint_received && !interrupted && test_pid > 0)
+        {
+            kill(-test_pid, SIGINT);
+            interrupted = TRUE;
+        }
+
+        ret = poll(&pfd, 1, TESTER_ZYGOTE_POLL_INTERVAL);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ERROR("poll() on control socket of test server of '%s' "
+                  "failed: %s", zygote->execute, strerror(errno));
+            return TE_OS_RC(TE_TESTER, errno);
+        }
+        if (ret == 0)
+        {
+            if (waitpid(zygote->pid, &status, WNOHANG) == zygote->pid)
+            {
+                zygote->pid = -1;
+                return TE_RC(TE_TESTER, TE_ECONNRESET);
+            }
+
+            if (timeout >= 0 && zygote_now_ns() >= deadline)
+                return TE_RC(TE_TESTER, TE_ETIMEDOUT);
+            continue;
+        }
+
+        len = recv(zygote->sock, msg, sizeof(*msg), 0);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ERROR("recv() from test server of '%s' failed: %s",
+                  zygote->execute, strerror(errno));
+            return TE_OS_RC(TE_TESTER, errno);
+        }
+        break;
+    }
+
+    if (len == 0)
+        return TE_RC(TE_TESTER, TE_ECONNRESET);
+
+    if (len != sizeof(*msg) || msg->type != (uint32_t)type)
+    {
+        ERROR("Unexpected message from test server of '%s'",
+              zygote->execute);
+        return TE_RC(TE_TESTER, TE_EPROTO);
+    }
+
+    return 0;
+}
+
+/**
+ * Start the test server and wait until it is ready.
+ *
+ * @param zygote        Test server
+ *
+ * @return Status code.
+ */
+static te_errno
+zygote_start(tester_zygote *zygote)
+{
+    tester_zygote_msg   msg;
+    char               *cmd = NULL;
+    int                 sv[2];
+    int                 fdin;
+    te_errno            rc;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0)
+    {
+        rc = TE_OS_RC(TE_TESTER, errno);
+        ERROR("socketpair() failed: %r", rc);
+        return rc;
+    }
+    /* Only the server end is inherited by the test executable */
+    (void)fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+
+    if (te_asprintf(&cmd, "%s=%d exec %s", TESTER_ZYGOTE_FD_ENV, sv[1],
+                    zygote->execute) < 0)
+    {
+        close(sv[0]);
+        close(sv[1]);
+        return TE_RC(TE_TESTER, TE_ENOMEM);
+    }
+
+    VERB("te_shell_cmd(%s)", cmd);
+    zygote->pid = te_shell_cmd(cmd, -1, &fdin, NULL, NULL);
+    close(sv[1]);
+    if (zygote->pid < 0)
+    {
+        rc = TE_OS_RC(TE_TESTER, errno);
+        ERROR("te_shell_cmd(%s) failed: %r", cmd, rc);
+        free(cmd);
+        close(sv[0]);
+        return rc;
+    }
+    free(cmd);
+    /* Test processes do not share Tester standard input */
+    close(fdin);
+    zygote->sock = sv[0];
+
+    rc = zygote_recv(zygote, -1, TE_TEST_ZYGOTE_READY,
+                     TESTER_ZYGOTE_START_TIMEOUT, &msg);
+    if (rc != 0)
+    {
+        ERROR("Test executable '%s' failed to start as a test server: "
+              "%r, its iterations are run as usual", zygote->execute, rc);
+        zygote_stop(zygote, TRUE);
+        zygote->unsupported = TRUE;
+        return TE_RC(TE_TESTER, TE_EOPNOTSUPP);
+    }
+
+    RING("Test server of '%s' is started with PID %d",
+         zygote->execute, (int)zygote->pid);
+
+    return 0;
+}
+
+/**
+ * Find or start the test server of the executable.
+ *
+ * @param execute       Test executable
+ * @param p_zygote      Location for the running test server
+ *
+ * @return Status code.
+ */
+static te_errno
+zygote_get(const char *execute, tester_zygote **p_zygote)
+{
+    tester_zygote  *zygote;
+    te_errno        rc;
+
+    SLIST_FOREACH(zygote, &zygotes, links)
+    {
+        if (strcmp(zygote->execute, execute) == 0)
+            break;
+    }
+
+    if (zygote == NULL)
+    {
+        zygote = TE_ALLOC(sizeof(*zygote));
+        if (zygote == NULL)
+            return TE_RC(TE_TESTER, TE_ENOMEM);
+
+        zygote->execute = strdup(execute);
+        if (zygote->execute == NULL)
+        {
+            free(zygote);
+            return TE_RC(TE_TESTER, TE_ENOMEM);
+        }
+        zygote->pid = -1;
+        zygote->sock = -1;
+        SLIST_INSERT_HEAD(&zygotes, zygote, links);
+    }
+
+    if (zygote->unsupported)
+        return TE_RC(TE_TESTER, TE_EOPNOTSUPP);
+
+    if (zygote->pid < 0)
+    {
+        rc = zygote_start(zygote);
+        if (rc != 0)
+            return rc;
+    }
+
+    *p_zygote = zygote;
+
+    return 0;
+}
+
+/* See description in tester_zygote.h */
+te_errno
+tester_zygote_run(const char *execute, unsigned int argc,
+                  const char *const *argv, int *wstatus)
+{
+    tester_zygote      *zygote;
+    tester_zygote_msg   msg;
+    char               *req;
+    size_t              len = 0;
+    unsigned int        i;
+    pid_t               test_pid;
+    uint64_t            start_ns = zygote_now_ns();
+    te_errno            rc;
+
+    rc = zygote_get(execute, &zygote);
+    if (rc != 0)
+        return rc;
+
+    for (i = 0; i < argc; ++i)
+        len += strlen(argv[i]) + 1;
+
+    req = malloc(len);
+    if (req == NULL)
+        return TE_RC(TE_TESTER, TE_ENOMEM);
+
+    for (i = 0, len = 0; i < argc; ++i)
+    {
+        size_t arg_len = strlen(argv[i]) + 1;
+
+        memcpy(req + len, argv[i], arg_len);
+        len += arg_len;
+    }
+
+    if (send(zygote->sock, req, len, MSG_NOSIGNAL) != (ssize_t)len)
+    {
+        rc = TE_OS_RC(TE_TESTER, errno);
+        free(req);
+        /* Too long request, the iteration may be run as usual */
+        if (TE_RC_GET_ERROR(rc) == TE_EMSGSIZE)
+            return TE_RC(TE_TESTER, TE_EOPNOTSUPP);
+
+        ERROR("send() to test server of '%s' failed: %r", execute, rc);
+        zygote_stop(zygote, TRUE);
+        return rc;
+    }
+    free(req);
+
+    rc = zygote_recv(zygote, -1, TE_TEST_ZYGOTE_STARTED,
+                     TESTER_ZYGOTE_START_TIMEOUT, &msg);
+    if (rc != 0)
+    {
+        ERROR("Test server of '%s' failed to start the test: %r",
+              execute, rc);
+        zygote_stop(zygote, TRUE);
+        return rc;
+    }
+    test_pid = msg.value;
+
+    tester_set_serial_pid(test_pid);
+    rc = zygote_recv(zygote, test_pid, TE_TEST_ZYGOTE_DONE, -1, &msg);
+    tester_release_serial_pid();
+    if (rc != 0)
+    {
+        ERROR("Test server of '%s' failed to wait for the test with "
+              "PID %d: %r", execute, (int)test_pid, rc);
+        zygote_stop(zygote, TRUE);
+        return rc;
+    }
+
+    *wstatus = msg.value;
+    zygote_runs++;
+    zygote_runs_ns += zygote_now_ns() - start_ns;
+
+    return 0;
+}
+
+/* See description in tester_zygote.h */
+unsigned int
+tester_zygote_n_runs(void)
+{
+    return zygote_runs;
+}
+
+/* See description in tester_zygote.h */
+void
+tester_zygote_shutdown(void)
+{
+    tester_zygote  *zygote;
+    unsigned int    n_zygotes = 0;
+
+    while ((zygote = SLIST_FIRST(&zygotes)) != NULL)
+    {
+        SLIST_REMOVE_HEAD(&zygotes, links);
+        if (!zygote->unsupported)
+            n_zygotes++;
+        zygote_stop(zygote, FALSE);
+        free(zygote->execute);
+        free(zygote);
+    }
+
+    if (zygote_runs > 0)
+    {
+        RING("%u test iterations are run by %u test servers, "
+             "%.3f ms per iteration on average (including start of "
+             "test servers)", zygote_runs, n_zygotes,
+             zygote_runs_ns / 1e6 / zygote_runs);
+    }
+}
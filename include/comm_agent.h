@@ -11,6 +11,8 @@
 #ifndef __TE_COMM_AGENT_H__
 #define __TE_COMM_AGENT_H__
 
+#include <sys/socket.h>
+
 #include "te_errno.h"
 
 /** This structure is used to store some context for each connection. */
@@ -88,6 +90,11 @@ extern int rcf_comm_agent_init(const char *config_str,
  *                      to the rcf_comm_engine_receive. The TE_EPENDING will
  *                      be returned until last part of the message will be
  *                      read.
+ * @retval TE_ENOBUFS   Command with arguments received with binary framing
+ *                      does not fit into the buffer. Required size of the
+ *                      buffer is returned in @p pbytes. The function should
+ *                      be called again with a larger buffer containing the
+ *                      data already received (e.g. reallocated one).
  * @retval other value  errno.
  */
 extern int rcf_comm_agent_wait(rcf_comm_connection *rcc,
@@ -120,4 +127,29 @@ extern int rcf_comm_agent_reply(rcf_comm_connection *rcc,
  */
 extern int rcf_comm_agent_close(rcf_comm_connection **p_rcc);
 
+/**
+ * Check whether binary framing is used on the connection, so string
+ * arguments of commands and replies are passed as separate elements
+ * (see rcf_comm_frame.h).
+ *
+ * @param rcc           Handler received from rcf_comm_agent_init
+ *
+ * @return @c TRUE if binary framing is used.
+ */
+extern te_bool rcf_comm_agent_framed(const rcf_comm_connection *rcc);
+
+/**
+ * Get address of the Test Engine side of the connection.
+ *
+ * @param rcc           Handler received from rcf_comm_agent_init
+ * @param addr          Location for the address
+ * @param addrlen       On entry - size of @p addr,
+ *                      on return - length of the address
+ *
+ * @return Status code.
+ */
+extern te_errno rcf_comm_agent_peer_addr(rcf_comm_connection *rcc,
+                                         struct sockaddr *addr,
+                                         socklen_t *addrlen);
+
 #endif /* !__TE_COMM_AGENT_H__ */
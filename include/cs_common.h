@@ -15,6 +15,17 @@
 /** Separator in values in which there are substitutions */
 #define CS_SUBSTITUTION_DELIMITER "$$"
 
+/**
+ * Sub-identifier of the Test Agent object which value is generation
+ * of the last configuration change made on the agent.
+ *
+ * Wildcard get request "/agent:<name>/conf_gen:<N>/..." returns the
+ * current generation followed by identifiers of instances changed
+ * after generation N (space-separated), or fails with @c TE_ENODATA
+ * if changes since generation N are not known to the agent.
+ */
+#define CS_CONF_GEN_SUBID "conf_gen"
+
 /** Neighbour entry states, see /agent/interface/neigh_dynamic/state */
 typedef enum {
     CS_NEIGH_INCOMPLETE = 1, /**< Incomplete entry */
@@ -0,0 +1,185 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief RCF binary framing
+ *
+ * Definitions of the binary framing which may be used on the connection
+ * between RCF and a Test Agent instead of the text one.
+ *
+ * In text mode a message is a string terminated by zero byte (or new
+ * line), so it has to be received byte by byte, and a binary attachment
+ * is announced by "attach <length>" suffix which has to be searched for
+ * in every message.
+ *
+ * In binary mode a message is a sequence of TLV elements: a command
+ * (the same string as in text mode, but without "attach" suffix and
+ * trailing zero byte), string arguments of the command and optionally
+ * an attachment. Each element is received with a single call and
+ * attachment data are passed to and from the socket directly from/to
+ * the caller buffer.
+ *
+ * String arguments are not quoted: every string which is put in quotes
+ * in text mode is replaced in the command by @c RCF_COMM_FRAME_ARG_REF
+ * token and is passed as is in the next argument element. Since length
+ * of each element is known in advance, the receiver allocates enough
+ * memory for a command of any length.
+ *
+ * Users of communication libraries pass a message with arguments as
+ * the command with "args <number>" suffix (followed by "attach" one,
+ * if any), zero byte, zero-terminated arguments and the attachment.
+ * A received message is laid out in the same way except that there
+ * is no "args" suffix: the arguments are taken in order of
+ * @c RCF_COMM_FRAME_ARG_REF tokens.
+ *
+ * The mode is negotiated right after connection establishment: RCF
+ * sends @c TE_PROTO_FRAMING text command with the framing version and
+ * the agent which supports it replies with the same string. Any other
+ * reply (e.g. "bad command" from an agent unaware of binary framing)
+ * means that the text mode should be kept. Both sides switch to binary
+ * mode just after the reply.
+ *
+ * An agent supporting binary framing also executes commands
+ * concurrently, so RCF may send the next command before the answer
+ * to the previous one is received. Answers are matched to requests
+ * by SID; commands with the same SID are never pipelined.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_RCF_COMM_FRAME_H__
+#define __TE_RCF_COMM_FRAME_H__
+
+#include "te_defs.h"
+#include "te_stdint.h"
+#include "te_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Version of the binary framing */
+#define RCF_COMM_FRAME_VERSION      "2"
+
+/** Framing negotiation request (and the positive reply) */
+#define RCF_COMM_FRAME_REQUEST  TE_PROTO_FRAMING " " RCF_COMM_FRAME_VERSION
+
+/** Time (in milliseconds) to wait for the framing negotiation reply */
+#define RCF_COMM_FRAME_TIMEOUT      10000
+
+/** Types of TLV elements */
+typedef enum rcf_comm_frame_type {
+    /** Command or reply string */
+    RCF_COMM_FRAME_CMD = 1,
+    /** Binary attachment */
+    RCF_COMM_FRAME_ATTACH,
+    /** String argument of the command or reply */
+    RCF_COMM_FRAME_ARG,
+} rcf_comm_frame_type;
+
+/** Token which refers to the next argument element in the command */
+#define RCF_COMM_FRAME_ARG_REF      "$"
+
+/** Another element of the same message follows */
+#define RCF_COMM_FRAME_F_MORE       0x0001
+
+/** TLV element header, all fields are in network byte order */
+typedef struct rcf_comm_frame_hdr {
+    uint16_t type;      /**< Element type, see rcf_comm_frame_type */
+    uint16_t flags;     /**< Element flags */
+    uint32_t len;       /**< Length of the value following the header */
+} rcf_comm_frame_hdr;
+
+/**
+ * Find "<name> <number>" suffix in the text command without
+ * modification of the command.
+ *
+ * @param cmd           Command
+ * @param cmd_len       Length of the command (without zero byte)
+ * @param name          Name of the suffix
+ * @param value         Location for the number
+ *                      (@c 0 if there is no such suffix)
+ *
+ * @return Length of the command without the suffix and spaces before it.
+ */
+static inline size_t
+rcf_comm_frame_strip_suffix(const char *cmd, size_t cmd_len,
+                            const char *name, size_t *value)
+{
+    size_t  name_len = strlen(name);
+    size_t  end = cmd_len;
+    size_t  digits;
+    size_t  i;
+    size_t  len = 0;
+
+    *value = 0;
+
+    while (end > 0 && cmd[end - 1] == ' ')
+        end--;
+    for (digits = end; digits > 0 &&
+         cmd[digits - 1] >= '0' && cmd[digits - 1] <= '9'; digits--)
+        ;
+    if (digits == end || digits == 0 || cmd[digits - 1] != ' ')
+        return cmd_len;
+
+    /* The number must fit the frame length field */
+    for (i = digits; i < end; i++)
+    {
+        if (len > (UINT32_MAX - (size_t)(cmd[i] - '0')) / 10)
+            return cmd_len;
+        len = len * 10 + (cmd[i] - '0');
+    }
+
+    while (digits > 0 && cmd[digits - 1] == ' ')
+        digits--;
+    if (digits <= name_len ||
+        memcmp(cmd + digits - name_len, name, name_len) != 0)
+        return cmd_len;
+
+    digits -= name_len;
+    if (cmd[digits - 1] != ' ')
+        return cmd_len;
+
+    while (digits > 0 && cmd[digits - 1] == ' ')
+        digits--;
+
+    *value = len;
+    return digits;
+}
+
+/**
+ * Find "attach <number>" suffix in the text command without
+ * modification of the command.
+ *
+ * @param cmd           Zero-terminated command
+ * @param cmd_len       Length of the command (without zero byte)
+ * @param attach_len    Location for attachment length
+ *                      (@c 0 if there is no attachment)
+ *
+ * @return Length of the command without the suffix and spaces before it.
+ */
+static inline size_t
+rcf_comm_frame_strip_attach(const char *cmd, size_t cmd_len,
+                            size_t *attach_len)
+{
+    return rcf_comm_frame_strip_suffix(cmd, cmd_len, "attach", attach_len);
+}
+
+/**
+ * Find "args <number>" suffix in the text command (which is already
+ * stripped from "attach" suffix) without modification of the command.
+ *
+ * @param cmd           Command
+ * @param cmd_len       Length of the command
+ * @param n_args        Location for number of arguments
+ *
+ * @return Length of the command without the suffix and spaces before it.
+ */
+static inline size_t
+rcf_comm_frame_strip_args(const char *cmd, size_t cmd_len, size_t *n_args)
+{
+    return rcf_comm_frame_strip_suffix(cmd, cmd_len, "args", n_args);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* __TE_RCF_COMM_FRAME_H__ */
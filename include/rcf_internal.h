@@ -97,6 +97,8 @@ typedef enum {
     RCFOP_TADEAD,           /**< Inform RCF that TA is dead */
     RCFOP_GET_SNIFFERS,     /**< Obtain the list of sniffers */
     RCFOP_GET_SNIF_DUMP,    /**< Pull out capture logs of the sniffer */
+    RCFOP_LOG_STREAM,       /**< Start pushing log to Logger */
+    RCFOP_CONFBATCH,        /**< Batch of configuration changes */
 } rcf_op_t;
 
 
@@ -109,8 +111,9 @@ typedef struct rcf_msg {
     te_errno error;              /**< Error code (in the answer) */
     char     ta[RCF_MAX_NAME];   /**< Test Agent name */
     int      handle;             /**< CSAP handle or PID */
-    int      num;                /**< Number of sent/received packets
-                                      or process priority*/
+    int      num;                /**< Number of sent/received packets,
+                                      process priority
+                                      or log stream cookie */
     uint32_t timeout;            /**< Timeout value (RCFOP_TRSEND_RECV,
                                       RCFOP_TRRECV_START, RCFOP_TRPOLL,
                                       RCFOP_RPC) */
@@ -124,7 +127,8 @@ typedef struct rcf_msg {
                                        encode data length (RCFOP_RPC);
                                        answer error (RCFOP_TRSEND_RECV);
                                        poll request ID (RCFOP_TRPOLL,
-                                       RCFOP_TRPOLL_CANCEL) */
+                                       RCFOP_TRPOLL_CANCEL);
+                                       Logger port (RCFOP_LOG_STREAM) */
     size_t   data_len;          /**< Length of additional data */
     char     id[RCF_MAX_ID];    /**< TA type;
                                      variable name;
@@ -195,6 +199,7 @@ rcf_op_to_string(rcf_op_t op)
         case RCFOP_CONFDEL:         return "configure delete";
         case RCFOP_CONFGRP_START:   return "configure group start";
         case RCFOP_CONFGRP_END:     return "configure group end";
+        case RCFOP_CONFBATCH:       return "configure batch";
         case RCFOP_GET_LOG:         return "get log";
         case RCFOP_VREAD:           return "vread";
         case RCFOP_VWRITE:          return "vwrite";
@@ -218,6 +223,7 @@ rcf_op_to_string(rcf_op_t op)
         case RCFOP_KILL:            return "kill";
         case RCFOP_GET_SNIFFERS:    return "get sniffers";
         case RCFOP_GET_SNIF_DUMP:   return "get snif dump";
+        case RCFOP_LOG_STREAM:      return "log stream";
         default:                    return "(unknown)";
     }
 }
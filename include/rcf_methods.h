@@ -35,6 +35,12 @@ typedef void *rcf_talib_handle;
 #define TA_NO_HKEY_CHK  0x10    /**< TA is copied using
                                      StrictHostKeyChecking=no
                                      SSH option */
+#define TA_PIPELINE     0x20    /**< TA accepts new commands before
+                                     answering the previous ones */
+#define TA_FRAMED       0x40    /**< Binary framing is used, string
+                                     arguments of commands and replies
+                                     are passed unquoted in separate
+                                     elements (see rcf_comm_frame.h) */
 /*@}*/
 /** @name Test Agent flags for RCF engine internal use */
 #define TA_DOWN         0x0100  /**< For internal RCF use */
@@ -96,20 +102,16 @@ typedef te_errno (* rcf_talib_finish)(rcf_talib_handle  handle,
  * the NUT, which it serves.
  *
  * @param handle        TA handle
- * @param select_set    FD_SET to be updated with the TA connection file
- *                      descriptor (for Test Agents supporting listening
- *                      mode) (IN/OUT)
- *
- * @param select_tm     timeout value for the select to be updated with
- *                      TA polling interval (for Test Agents supporting
- *                      polling mode only)
- *                      (IN/OUT)
+ * @param fd            Location for the TA connection file descriptor
+ *                      which becomes readable when data from the TA are
+ *                      pending (for Test Agents supporting listening
+ *                      mode) or -1 if the TA should be polled with
+ *                      rcf_talib_is_ready method
  *
  * @return Error code.
  */
 typedef te_errno (* rcf_talib_connect)(rcf_talib_handle  handle,
-                                       fd_set           *select_set,
-                                       struct timeval   *select_tm);
+                                       int              *fd);
 
 /**
  * Transmit data to the Test Agent.
@@ -169,14 +171,10 @@ typedef te_errno (* rcf_talib_receive)(rcf_talib_handle handle,
  * Close interactions with TA.
  *
  * @param handle        TA handle
- * @param select_set    FD_SET to be updated with the TA connection file
- *                      descriptor (for Test Agents supporting listening
- *                      mode) (IN/OUT)
  *
  * @return Error code.
  */
-typedef te_errno (* rcf_talib_close)(rcf_talib_handle  handle,
-                                     fd_set           *select_set);
+typedef te_errno (* rcf_talib_close)(rcf_talib_handle handle);
 
 /**
  * Structure to keep RCF TA methods.
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief TA log streaming protocol
+ *
+ * Definitions of the protocol used by Test Agents to push log messages
+ * to Logger over a dedicated TCP connection instead of answering
+ * GET_LOG polls.
+ *
+ * Logger listens on an ephemeral port and asks the agent to connect to
+ * it using RCF @c log_stream command. The agent connects to the address
+ * of its RCF peer and both sides exchange @c TE_LOG_STREAM_HELLO frames
+ * carrying the cookie passed in the command. After that the agent sends
+ * @c TE_LOG_STREAM_DATA frames with messages in the format used by
+ * GET_LOG (sequence number followed by the message) as soon as they are
+ * registered.
+ *
+ * Flow control is credit based: the agent never has more than granted
+ * number of bytes in flight. When Logger lags behind, the agent stops
+ * taking messages from its log buffer and they are accounted by the
+ * buffer overflow policy as if Logger did not poll the agent.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_LOG_STREAM_H__
+#define __TE_LOG_STREAM_H__
+
+#include "te_stdint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Frame types of the TA log streaming protocol */
+typedef enum te_log_stream_op {
+    /** Cookie exchange, @a len is the cookie, both directions */
+    TE_LOG_STREAM_HELLO = 1,
+    /** Log messages, @a len bytes follow, agent to Logger */
+    TE_LOG_STREAM_DATA,
+    /**
+     * All messages registered before the flush request are sent,
+     * agent to Logger
+     */
+    TE_LOG_STREAM_FLUSHED,
+    /** Allow to send @a len more bytes of data, Logger to agent */
+    TE_LOG_STREAM_CREDIT,
+    /** Flush request, Logger to agent */
+    TE_LOG_STREAM_FLUSH,
+} te_log_stream_op;
+
+/** Frame header, both fields are in network byte order */
+typedef struct te_log_stream_hdr {
+    uint32_t op;    /**< Frame type, see te_log_stream_op */
+    uint32_t len;   /**< Payload length or frame argument */
+} te_log_stream_hdr;
+
+/** Number of bytes Logger allows to be in flight */
+#define TE_LOG_STREAM_WINDOW        (256 * 1024)
+
+/** Maximum payload length of a data frame */
+#define TE_LOG_STREAM_DATA_MAX      (64 * 1024)
+
+/** Time (in milliseconds) to wait for the agent to connect */
+#define TE_LOG_STREAM_CONNECT_TIMEOUT   3000
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* __TE_LOG_STREAM_H__ */
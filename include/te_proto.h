@@ -21,7 +21,9 @@
 #define TE_PROTO_CONFDEL        "configure del"
 #define TE_PROTO_CONFGRP_START  "configure group start"
 #define TE_PROTO_CONFGRP_END    "configure group end"
+#define TE_PROTO_CONFBATCH      "configure batch"
 #define TE_PROTO_GET_LOG        "get_log"
+#define TE_PROTO_LOG_STREAM     "log_stream"
 #define TE_PROTO_VREAD          "vread"
 #define TE_PROTO_VWRITE         "vwrite"
 #define TE_PROTO_FPUT           "fput"
@@ -42,6 +44,7 @@
 #define TE_PROTO_EXECUTE        "execute"
 #define TE_PROTO_RPC            "rpc"
 #define TE_PROTO_KILL           "kill"
+#define TE_PROTO_FRAMING        "framing"
 
 #define TE_PROTO_FUNC           "function"
 #define TE_PROTO_THREAD         "thread"
@@ -50,6 +53,19 @@
 #define TE_PROTO_GET_SNIFFERS   "get_sniffers"
 #define TE_PROTO_GET_SNIF_DUMP  "get_snif_dump"
 
+/**
+ * @name Operations of configuration batch
+ *
+ * Binary attachment of "configure batch <number of items>" command
+ * consists of items: operation character followed by null-terminated
+ * OID and null-terminated value (empty for delete).
+ * The answer is "<status> <number of applied items>".
+ */
+#define TE_PROTO_CONFBATCH_SET  's'
+#define TE_PROTO_CONFBATCH_ADD  'a'
+#define TE_PROTO_CONFBATCH_DEL  'd'
+/*@}*/
+
 #ifdef RCF_NEED_TYPES
 /**
  * Types recoding table.
@@ -50,4 +50,34 @@ typedef struct tester_test_msg_hdr {
         uint32_t    type;   /**< Message type (see tester_test_msg_type). */
 } tester_test_msg_hdr;
 
+/**
+ * Name of the environment variable with the control socket descriptor.
+ * It is set when Tester starts a test executable as a test server
+ * (zygote): the executable does not run the test itself, but waits for
+ * requests with test arguments and forks a process per request.
+ * Requests are packets of NUL-terminated test arguments.
+ */
+#define TESTER_ZYGOTE_FD_ENV    "TE_TESTER_ZYGOTE_FD"
+
+/**
+ * Types of messages which test servers send to Tester.
+ */
+typedef enum te_test_zygote_msg_type {
+    TE_TEST_ZYGOTE_READY,   /**< Server is ready to accept requests */
+    TE_TEST_ZYGOTE_STARTED, /**< Test process is forked */
+    TE_TEST_ZYGOTE_DONE,    /**< Test process is terminated */
+} te_test_zygote_msg_type;
+
+/**
+ * Representation of the message passed from a test server to Tester.
+ */
+typedef struct tester_zygote_msg {
+        uint32_t    type;   /**< Message type (see
+                                 te_test_zygote_msg_type) */
+        int32_t     value;  /**< Test process ID for
+                                 TE_TEST_ZYGOTE_STARTED, status
+                                 returned by waitpid() for
+                                 TE_TEST_ZYGOTE_DONE */
+} tester_zygote_msg;
+
 #endif /* !__TE_TESTER_MSG_H__ */
@@ -39,6 +39,9 @@
 #if HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #if  HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
@@ -52,8 +55,10 @@
 #include <fcntl.h>
 #endif
 
+#include "te_defs.h"
 #include "te_errno.h"
 #include "comm_agent.h"
+#include "rcf_comm_frame.h"
 
 
 /**
@@ -68,17 +73,37 @@
         fflush(stderr);         \
     } while (0)
 
+/** Number of arguments of a reply sent without memory allocation */
+#define FRAME_ARGS_INLINE   8
+
 
 /** This structure is used to store some context for each connection. */
 struct rcf_comm_connection {
     int     socket;          /**< Connection socket */
     size_t  bytes_to_read;   /**< Number of bytes of attachment to read */
+    te_bool framed;          /**< Binary framing is negotiated */
+    size_t  bytes_to_send;   /**< Number of bytes of attachment to send
+                                  (binary framing only) */
+    size_t  frame_off;       /**< Number of bytes of the command and
+                                  arguments already received to the
+                                  caller buffer (binary framing only) */
+    te_bool frame_hdr_valid; /**< @a frame_hdr is received, but its
+                                  value is not read yet */
+    rcf_comm_frame_hdr frame_hdr; /**< Header of the element which did
+                                       not fit into the caller buffer */
 };
 
 
 /* Static function declaration. See implementation for comments */
 static int find_attach(char *buf, size_t len);
 static int read_socket(int socket, void *buffer, size_t len);
+static int read_attach(struct rcf_comm_connection *rcc, char *buffer,
+                       size_t cmd_len, size_t attach_size,
+                       size_t *pbytes, void **pba);
+static int frame_wait(struct rcf_comm_connection *rcc,
+                      char *buffer, size_t *pbytes, void **pba);
+static int frame_reply(struct rcf_comm_connection *rcc,
+                       const uint8_t *buffer, size_t length);
 
 /* See description in comm_agent.h */
 te_errno
@@ -286,6 +311,12 @@ rcf_comm_agent_init(const char *config_str,
  *                      to the rcf_comm_engine_receive. The TE_EPENDING
  *                      will be returned until last part of the message
  *                      will be read.
+ * @retval TE_ENOBUFS   Command with arguments received with binary
+ *                      framing does not fit into the buffer. Required
+ *                      size of the buffer is returned in @p pbytes.
+ *                      The function should be called again with a larger
+ *                      buffer containing the data already received (e.g.
+ *                      the same buffer reallocated).
  * @retval other value  errno.
  */
 int
@@ -321,6 +352,9 @@ rcf_comm_agent_wait(struct rcf_comm_connection *rcc,
         }
     }
 
+    if (rcc->framed)
+        return frame_wait(rcc, buffer, pbytes, pba);
+
     while (1)
     {
         int r;
@@ -367,45 +401,24 @@ rcf_comm_agent_wait(struct rcf_comm_connection *rcc,
 
             attach_size = find_attach(buffer, l);
 
-            if (attach_size == -1)
+            if (attach_size == -1 &&
+                strcmp(buffer, RCF_COMM_FRAME_REQUEST) == 0)
             {
-                /* No attachment */
-                *pbytes = l;
-
-                /* Set pba to NULL because no attachment attached */
-                if (pba != NULL)
-                    *pba = NULL;
-
-                return 0;
+                /*
+                 * Binary framing is requested: confirm it in text mode
+                 * and switch to binary one to receive the next command.
+                 */
+                ret = rcf_comm_agent_reply(rcc, buffer, l);
+                if (ret != 0)
+                    return ret;
+
+                rcc->framed = TRUE;
+                return frame_wait(rcc, buffer, pbytes, pba);
             }
-            else
-            {
-                /* Attachment found. */
-
-                /* Set pba to the first byte of the attachment */
-                if (pba != NULL)
-                    *pba = buffer + l;
 
-                if (*pbytes >= l + attach_size)
-                {
-                    /* Buffer is enough to write attachment */
-                    *pbytes = l + attach_size;
-                    return read_socket(rcc->socket, buffer + l,
-                                       attach_size);
-                }
-                else
-                {
-                    /* Buffer is too small to write attachment */
-                    size_t to_read = *pbytes - l;
-
-                    ret = read_socket(rcc->socket, buffer + l, to_read);
-                    if (ret != 0)
-                        return ret; /* Some error occurred */
-                    rcc->bytes_to_read = attach_size - to_read;
-                    *pbytes = attach_size + l;
-                    return TE_RC(TE_COMM, TE_EPENDING);
-                }
-            }
+            return read_attach(rcc, buffer, l,
+                               attach_size == -1 ? 0 : attach_size,
+                               pbytes, pba);
         }
 
         if (l == (*pbytes - 1))
@@ -435,6 +448,9 @@ rcf_comm_agent_reply(struct rcf_comm_connection *rcc, const void *buffer,
 
     if (length == 0)
         return 0;
+
+    if (rcc->framed)
+        return frame_reply(rcc, buffer, length);
 #ifdef TE_COMM_DEBUG_PROTO
     {
         /* Change \x0 to \n in the user (!!!) buffer before sending */
@@ -497,6 +513,31 @@ rcf_comm_agent_close(struct rcf_comm_connection **p_rcc)
     return 0;
 }
 
+/* See description in comm_agent.h */
+te_bool
+rcf_comm_agent_framed(const struct rcf_comm_connection *rcc)
+{
+    return rcc != NULL && rcc->framed;
+}
+
+/* See description in comm_agent.h */
+te_errno
+rcf_comm_agent_peer_addr(struct rcf_comm_connection *rcc,
+                         struct sockaddr *addr, socklen_t *addrlen)
+{
+    if (rcc == NULL || addr == NULL || addrlen == NULL)
+        return TE_RC(TE_COMM, TE_EINVAL);
+
+    if (getpeername(rcc->socket, addr, addrlen) < 0)
+    {
+        ERROR("%s(): getpeername() failed, errno=%d ('%s')",
+              __FUNCTION__, errno, strerror(errno));
+        return TE_OS_RC(TE_COMM, errno);
+    }
+
+    return 0;
+}
+
 /**
  * Search in the string for the "attach <number>" entry at the end. Inserts
  * ZERO before 'attach' word.
@@ -634,3 +675,347 @@ read_socket(int socket, void *buffer, size_t len)
     return 0;
 }
 
+
+/**
+ * Complete reception of a message: read its attachment (if any) to
+ * the buffer after the command.
+ *
+ * @param rcc           Connection handle
+ * @param buffer        Buffer with the received command
+ * @param cmd_len       Length of the command including zero byte
+ * @param attach_size   Length of the attachment or @c 0
+ * @param pbytes        See rcf_comm_agent_wait()
+ * @param pba           See rcf_comm_agent_wait()
+ *
+ * @return Status code (see rcf_comm_agent_wait()).
+ */
+static int
+read_attach(struct rcf_comm_connection *rcc, char *buffer, size_t cmd_len,
+            size_t attach_size, size_t *pbytes, void **pba)
+{
+    size_t  to_read;
+    int     ret;
+
+    if (attach_size == 0)
+    {
+        /* No attachment */
+        *pbytes = cmd_len;
+
+        /* Set pba to NULL because no attachment attached */
+        if (pba != NULL)
+            *pba = NULL;
+
+        return 0;
+    }
+
+    /* Set pba to the first byte of the attachment */
+    if (pba != NULL)
+        *pba = buffer + cmd_len;
+
+    if (*pbytes >= cmd_len + attach_size)
+    {
+        /* Buffer is enough to write attachment */
+        *pbytes = cmd_len + attach_size;
+        return read_socket(rcc->socket, buffer + cmd_len, attach_size);
+    }
+
+    /* Buffer is too small to write attachment */
+    to_read = *pbytes - cmd_len;
+
+    ret = read_socket(rcc->socket, buffer + cmd_len, to_read);
+    if (ret != 0)
+        return ret; /* Some error occurred */
+    rcc->bytes_to_read = attach_size - to_read;
+    *pbytes = attach_size + cmd_len;
+    return TE_RC(TE_COMM, TE_EPENDING);
+}
+
+/**
+ * Receive a command in binary framing mode.
+ *
+ * The command and its arguments are written to the buffer as
+ * zero-terminated strings one after another and followed by
+ * the attachment.
+ *
+ * @param rcc           Connection handle
+ * @param buffer        Buffer for data
+ * @param pbytes        See rcf_comm_agent_wait()
+ * @param pba           See rcf_comm_agent_wait()
+ *
+ * @return Status code (see rcf_comm_agent_wait()).
+ */
+static int
+frame_wait(struct rcf_comm_connection *rcc, char *buffer, size_t *pbytes,
+           void **pba)
+{
+    rcf_comm_frame_hdr  hdr;
+    size_t              off = rcc->frame_off;
+    size_t              len;
+    unsigned int        type;
+    te_bool             more;
+    int                 ret;
+
+    if (rcc->frame_hdr_valid)
+    {
+        hdr = rcc->frame_hdr;
+        rcc->frame_hdr_valid = FALSE;
+    }
+    else if ((ret = read_socket(rcc->socket, &hdr, sizeof(hdr))) != 0)
+    {
+        return ret;
+    }
+
+    while (TRUE)
+    {
+        type = ntohs(hdr.type);
+        len = ntohl(hdr.len);
+        more = (ntohs(hdr.flags) & RCF_COMM_FRAME_F_MORE) != 0;
+
+        if (type == RCF_COMM_FRAME_ATTACH && off > 0 && !more)
+            break;
+
+        if ((off == 0) != (type == RCF_COMM_FRAME_CMD) ||
+            (type != RCF_COMM_FRAME_CMD && type != RCF_COMM_FRAME_ARG) ||
+            (type == RCF_COMM_FRAME_CMD && len == 0))
+        {
+            ERROR("%s(): unexpected element type %u\n", __FUNCTION__,
+                  type);
+            return TE_RC(TE_COMM, TE_EPROTO);
+        }
+
+        if (off + len + 1 > *pbytes)
+        {
+            rcc->frame_hdr = hdr;
+            rcc->frame_hdr_valid = TRUE;
+            rcc->frame_off = off;
+            *pbytes = off + len + 1;
+            return TE_RC(TE_COMM, TE_ENOBUFS);
+        }
+
+        ret = read_socket(rcc->socket, buffer + off, len);
+        if (ret != 0)
+            return ret;
+        buffer[off + len] = '\0';
+        off += len + 1;
+
+        if (!more)
+        {
+            len = 0;
+            break;
+        }
+
+        ret = read_socket(rcc->socket, &hdr, sizeof(hdr));
+        if (ret != 0)
+            return ret;
+    }
+
+    rcc->frame_off = 0;
+    return read_attach(rcc, buffer, off, len, pbytes, pba);
+}
+
+/**
+ * Send data described by I/O vector (not less).
+ *
+ * @param socket        Connection socket
+ * @param iov           I/O vector (modified by the function)
+ * @param iovcnt        Number of elements in @p iov
+ *
+ * @return Status code.
+ */
+static int
+write_socket_iov(int socket, struct iovec *iov, int iovcnt)
+{
+    struct msghdr   msg;
+    ssize_t         sent;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    while (msg.msg_iovlen > 0)
+    {
+        sent = sendmsg(socket, &msg, 0);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ERROR("%s(): sendmsg(%d) failed: errno=%d\n",
+                  __FUNCTION__, socket, errno);
+            return TE_OS_RC(TE_COMM, errno);
+        }
+
+        while (msg.msg_iovlen > 0 && (size_t)sent >= msg.msg_iov->iov_len)
+        {
+            sent -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0)
+        {
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Add TLV element to the I/O vector.
+ *
+ * @param hdr           Location for the element header
+ * @param iov           I/O vector (two entries are filled in)
+ * @param type          Element type
+ * @param more          Whether more elements follow
+ * @param value         Element value
+ * @param len           Length of the value
+ */
+static void
+frame_add(rcf_comm_frame_hdr *hdr, struct iovec *iov,
+          rcf_comm_frame_type type, te_bool more,
+          const void *value, size_t len)
+{
+    hdr->type = htons(type);
+    hdr->flags = htons(more ? RCF_COMM_FRAME_F_MORE : 0);
+    hdr->len = htonl(len);
+
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = sizeof(*hdr);
+    iov[1].iov_base = (void *)value;
+    iov[1].iov_len = len;
+}
+
+/**
+ * Send reply in binary framing mode.
+ *
+ * The data are interpreted in the same way as in text mode: a string
+ * terminated by zero byte, optionally with "args <number>" and
+ * "attach <length>" suffixes, zero-terminated arguments and attachment
+ * bytes which may be passed in the same or subsequent calls.
+ * The arguments must be passed in the same call as the reply string.
+ * The reply, arguments and attachment are sent from the caller buffer.
+ *
+ * @param rcc           Connection handle
+ * @param buffer        Data to send
+ * @param length        Length of the data
+ *
+ * @return Status code.
+ */
+static int
+frame_reply(struct rcf_comm_connection *rcc, const uint8_t *buffer,
+            size_t length)
+{
+    rcf_comm_frame_hdr  hdr_inline[FRAME_ARGS_INLINE + 2];
+    struct iovec        iov_inline[2 * (FRAME_ARGS_INLINE + 2)];
+    rcf_comm_frame_hdr *hdr = hdr_inline;
+    struct iovec       *iov = iov_inline;
+    size_t              n_alloc = FRAME_ARGS_INLINE;
+    const char         *arg;
+    size_t              cmd_len;
+    size_t              stripped;
+    size_t              attach_len;
+    size_t              n_args;
+    size_t              arg_len;
+    size_t              inline_len;
+    size_t              i;
+    int                 ret = 0;
+
+    while (length > 0)
+    {
+        if (rcc->bytes_to_send > 0)
+        {
+            /* Continuation of the attachment */
+            inline_len = MIN(length, rcc->bytes_to_send);
+
+            iov[0].iov_base = (void *)buffer;
+            iov[0].iov_len = inline_len;
+            ret = write_socket_iov(rcc->socket, iov, 1);
+            if (ret != 0)
+                break;
+
+            rcc->bytes_to_send -= inline_len;
+            buffer += inline_len;
+            length -= inline_len;
+            continue;
+        }
+
+        cmd_len = strnlen((const char *)buffer, length);
+        if (cmd_len == length)
+        {
+            ERROR("%s(): reply is not zero-terminated\n", __FUNCTION__);
+            ret = TE_RC(TE_COMM, TE_EINVAL);
+            break;
+        }
+
+        stripped = rcf_comm_frame_strip_attach((const char *)buffer,
+                                               cmd_len, &attach_len);
+        stripped = rcf_comm_frame_strip_args((const char *)buffer,
+                                             stripped, &n_args);
+        if (n_args > n_alloc)
+        {
+            if (hdr != hdr_inline)
+            {
+                free(hdr);
+                free(iov);
+            }
+            n_alloc = n_args;
+            hdr = calloc(n_alloc + 2, sizeof(*hdr));
+            iov = calloc(2 * (n_alloc + 2), sizeof(*iov));
+            if (hdr == NULL || iov == NULL)
+            {
+                ERROR("%s(): failed to allocate memory\n", __FUNCTION__);
+                ret = TE_RC(TE_COMM, TE_ENOMEM);
+                break;
+            }
+        }
+
+        frame_add(&hdr[0], &iov[0], RCF_COMM_FRAME_CMD,
+                  n_args > 0 || attach_len > 0, buffer, stripped);
+
+        arg = (const char *)buffer + cmd_len + 1;
+        length -= cmd_len + 1;
+        for (i = 0; i < n_args; i++)
+        {
+            arg_len = strnlen(arg, length);
+            if (arg_len == length)
+            {
+                ERROR("%s(): not all arguments are passed\n",
+                      __FUNCTION__);
+                ret = TE_RC(TE_COMM, TE_EINVAL);
+                break;
+            }
+            frame_add(&hdr[1 + i], &iov[2 * (1 + i)], RCF_COMM_FRAME_ARG,
+                      i + 1 < n_args || attach_len > 0, arg, arg_len);
+            arg += arg_len + 1;
+            length -= arg_len + 1;
+        }
+        if (ret != 0)
+            break;
+
+        inline_len = MIN(attach_len, length);
+        if (attach_len > 0)
+        {
+            frame_add(&hdr[1 + n_args], &iov[2 * (1 + n_args)],
+                      RCF_COMM_FRAME_ATTACH, FALSE, NULL, attach_len);
+            iov[2 * (1 + n_args) + 1].iov_base = (void *)arg;
+            iov[2 * (1 + n_args) + 1].iov_len = inline_len;
+        }
+
+        ret = write_socket_iov(rcc->socket, iov,
+                               2 * (1 + n_args + (attach_len > 0)));
+        if (ret != 0)
+            break;
+
+        rcc->bytes_to_send = attach_len - inline_len;
+        buffer = (const uint8_t *)arg + inline_len;
+        length -= inline_len;
+    }
+
+    if (hdr != hdr_inline)
+    {
+        free(hdr);
+        free(iov);
+    }
+
+    return ret;
+}
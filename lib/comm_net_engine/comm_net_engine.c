@@ -25,6 +25,12 @@
 #if HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
 #if HAVE_SYS_ERRNO_H
 #include <sys/errno.h>
 #endif
@@ -41,7 +47,9 @@
 #include <netdb.h>
 #endif
 
+#include "te_defs.h"
 #include "te_errno.h"
+#include "rcf_comm_frame.h"
 #include "comm_net_engine.h"
 
 
@@ -61,6 +69,9 @@
 
 /*@}*/
 
+/** Number of arguments of a command sent without memory allocation */
+#define FRAME_ARGS_INLINE   8
+
 
 /**
  * This structure  stores the information about each connection
@@ -69,12 +80,22 @@
 struct rcf_net_connection{
     int     socket;         /**< Connection socket */
     size_t  bytes_to_read;  /**< Number of bytes of attachment to read */
+    te_bool framed;         /**< Binary framing is negotiated */
+    size_t  bytes_to_send;  /**< Number of bytes of attachment to send
+                                 (binary framing only) */
 };
 
 
 /* Static function declaration. See implementation for comments */
 static int find_attach(char *buf, size_t len);
 static int read_socket(int socket, char *buffer, size_t len);
+static int read_attach(struct rcf_net_connection *rnc, char *buffer,
+                       size_t cmd_len, size_t attach_size,
+                       size_t *pbytes, char **pba);
+static int frame_receive(struct rcf_net_connection *rnc, char *buffer,
+                         size_t *pbytes, char **pba);
+static int frame_transmit(struct rcf_net_connection *rnc,
+                          const char *data, size_t length);
 
 
 /**
@@ -84,7 +105,6 @@ static int read_socket(int socket, char *buffer, size_t len);
  * @param  port         port of the test agent
  * @param  p_rnc        pointer to to pointer to the rcf_net_connection
  *                      structure to be filled, used as handler
- * @param  p_select_set pointer to the fdset for reading to be modified
  *
  * @return Status code.
  * @retval 0            Success.
@@ -92,8 +112,7 @@ static int read_socket(int socket, char *buffer, size_t len);
  */
 int
 rcf_net_engine_connect(const char *addr, const char *port,
-                       struct rcf_net_connection **p_rnc,
-                       fd_set *p_select_set)
+                       struct rcf_net_connection **p_rnc)
 {
     int                 s;
     int                 rc;
@@ -214,8 +233,6 @@ rcf_net_engine_connect(const char *addr, const char *port,
     }
 #endif /* defined(TCP_NODELAY) || defined(SO_KEEPALIVE) */
 
-    FD_SET(s, p_select_set);
-
     /* Connection established. Let's allocate memory for rnc and fill it*/
     *p_rnc = (struct rcf_net_connection *)calloc(1, sizeof(**p_rnc));
     if ((*p_rnc) == 0)
@@ -253,6 +270,9 @@ rcf_net_engine_transmit(struct rcf_net_connection *rnc,
     if (rnc == NULL)
         return TE_RC(TE_COMM, TE_EINVAL);
 
+    if (rnc->framed)
+        return frame_transmit(rnc, data, length);
+
     while (length > 0 && tries > 0)
     {
         if ((len = send(rnc->socket, data, length, MSG_DONTWAIT)) < 0)
@@ -294,8 +314,7 @@ rcf_net_engine_transmit(struct rcf_net_connection *rnc,
 te_bool
 rcf_net_engine_is_ready(struct rcf_net_connection *rnc)
 {
-    fd_set          rfds;
-    struct timeval  tv;
+    struct pollfd pfd;
 
     if (rnc == NULL)
         return FALSE;
@@ -303,14 +322,24 @@ rcf_net_engine_is_ready(struct rcf_net_connection *rnc)
     if (rnc->bytes_to_read > 0)
         return TRUE;
 
-    FD_ZERO(&rfds);
-    FD_SET(rnc->socket, &rfds);
-    tv.tv_sec = 0;
-    tv.tv_usec = 0;
+    pfd.fd = rnc->socket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
 
-    select(rnc->socket + 1, &rfds, NULL, NULL, &tv);
+    return poll(&pfd, 1, 0) > 0 ? TRUE : FALSE;
+}
 
-    return FD_ISSET(rnc->socket, &rfds) ? TRUE : FALSE;
+/**
+ * Get the socket of the connection to be watched for pending data.
+ *
+ * @param rnc   Handler received from rcf_net_engine_connect.
+ *
+ * @return Socket or -1.
+ */
+int
+rcf_net_engine_get_fd(const struct rcf_net_connection *rnc)
+{
+    return rnc == NULL ? -1 : rnc->socket;
 }
 
 /**
@@ -392,6 +421,9 @@ rcf_net_engine_receive(struct rcf_net_connection *rnc, char *buffer,
         }
     }
 
+    if (rnc->framed)
+        return frame_receive(rnc, buffer, pbytes, pba);
+
     while (1)
     {
         int r = recv(rnc->socket, buffer + l, 1, 0);
@@ -427,48 +459,9 @@ rcf_net_engine_receive(struct rcf_net_connection *rnc, char *buffer,
 
             attach_size = find_attach(buffer, l);
 
-            if (attach_size == -1)
-            {
-                /* No attachment */
-                *pbytes = l;
-
-                /* Set pba to NULL because no attachment attached */
-                if (pba != NULL)
-                    *pba = NULL;
-
-                return 0;
-            }
-            else
-            {
-                /* Attachment found. */
-
-                /* Set pba to the first byte of the attachment */
-                if (pba != NULL)
-                    *pba = buffer + l;
-
-                if (*pbytes >= l + attach_size)
-                {
-                    /* Buffer is enough to write attachment */
-                    *pbytes = l + attach_size;
-                    return read_socket(rnc->socket, buffer + l,
-                                       attach_size);
-                }
-                else
-                {
-                    /* Buffer is too small to write attachment */
-                    int to_read = *pbytes - l;
-
-                    ret = read_socket(rnc->socket, buffer + l, to_read);
-                    if (ret != 0)
-                    {
-                        return ret; /* Some error occurred */
-                    }
-
-                    rnc->bytes_to_read = attach_size - to_read;
-                    *pbytes = attach_size + l;
-                    return TE_RC(TE_COMM, TE_EPENDING);
-                }
-            }
+            return read_attach(rnc, buffer, l,
+                               attach_size == -1 ? 0 : attach_size,
+                               pbytes, pba);
         }
 
         if (l == (*pbytes - 1))
@@ -479,21 +472,62 @@ rcf_net_engine_receive(struct rcf_net_connection *rnc, char *buffer,
 }
 
 
+/* See description in comm_net_engine.h */
+te_errno
+rcf_net_engine_set_framing(struct rcf_net_connection *rnc)
+{
+    /* Enough for any reply of an agent on unknown command */
+    char            buf[128];
+    size_t          len = sizeof(buf);
+    char           *ba;
+    struct pollfd   pfd;
+    int             rc;
+
+    if (rnc == NULL)
+        return TE_RC(TE_COMM, TE_EINVAL);
+    if (rnc->framed)
+        return 0;
+
+    rc = rcf_net_engine_transmit(rnc, RCF_COMM_FRAME_REQUEST,
+                                 sizeof(RCF_COMM_FRAME_REQUEST));
+    if (rc != 0)
+        return rc;
+
+    pfd.fd = rnc->socket;
+    pfd.events = POLLIN;
+    do {
+        rc = poll(&pfd, 1, RCF_COMM_FRAME_TIMEOUT);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0)
+        return TE_OS_RC(TE_COMM, errno);
+    if (rc == 0)
+        return TE_RC(TE_COMM, TE_ETIMEDOUT);
+
+    rc = rcf_net_engine_receive(rnc, buf, &len, &ba);
+    if (rc != 0)
+        return rc;
+
+    /* Any other reply means that the agent knows nothing about framing */
+    if (strcmp(buf, RCF_COMM_FRAME_REQUEST) != 0)
+        return TE_RC(TE_COMM, TE_EOPNOTSUPP);
+
+    rnc->framed = TRUE;
+    return 0;
+}
+
 /**
  * Close connection (socket) to the Test Agent and release the memory used
  * by struct rcf_net_connection *rnc.
  *
  * @param p_rnc         Pointer to variable with  handler received from
  *                      rcf_net_engine_connect
- * @param p_select_set  Pointer to the fdset for reading to be modified
  *
  * @return Status code.
  * @retval 0            Success.
  * @retval other value  errno.
  */
 int
-rcf_net_engine_close(struct rcf_net_connection **p_rnc,
-                     fd_set *p_select_set)
+rcf_net_engine_close(struct rcf_net_connection **p_rnc)
 {
     int rc = 0;
 
@@ -503,8 +537,6 @@ rcf_net_engine_close(struct rcf_net_connection **p_rnc,
     if (*p_rnc == NULL)
         return 0;
 
-    FD_CLR((*p_rnc)->socket, p_select_set);
-
     if (close((*p_rnc)->socket) < 0)
     {
         perror("rcf_net_engine_close(): close() error");
@@ -646,3 +678,329 @@ read_socket(int socket, char *buffer, size_t len)
     return 0;
 }
 
+
+/**
+ * Complete reception of a message: read its attachment (if any) to
+ * the buffer after the command.
+ *
+ * @param rnc           Connection handle
+ * @param buffer        Buffer with the received command
+ * @param cmd_len       Length of the command including zero byte
+ * @param attach_size   Length of the attachment or @c 0
+ * @param pbytes        See rcf_net_engine_receive()
+ * @param pba           See rcf_net_engine_receive()
+ *
+ * @return Status code (see rcf_net_engine_receive()).
+ */
+static int
+read_attach(struct rcf_net_connection *rnc, char *buffer, size_t cmd_len,
+            size_t attach_size, size_t *pbytes, char **pba)
+{
+    size_t  to_read;
+    int     ret;
+
+    if (attach_size == 0)
+    {
+        /* No attachment */
+        *pbytes = cmd_len;
+
+        /* Set pba to NULL because no attachment attached */
+        if (pba != NULL)
+            *pba = NULL;
+
+        return 0;
+    }
+
+    /* Set pba to the first byte of the attachment */
+    if (pba != NULL)
+        *pba = buffer + cmd_len;
+
+    if (*pbytes >= cmd_len + attach_size)
+    {
+        /* Buffer is enough to write attachment */
+        *pbytes = cmd_len + attach_size;
+        return read_socket(rnc->socket, buffer + cmd_len, attach_size);
+    }
+
+    /* Buffer is too small to write attachment */
+    to_read = *pbytes - cmd_len;
+
+    ret = read_socket(rnc->socket, buffer + cmd_len, to_read);
+    if (ret != 0)
+        return ret; /* Some error occurred */
+
+    rnc->bytes_to_read = attach_size - to_read;
+    *pbytes = attach_size + cmd_len;
+    return TE_RC(TE_COMM, TE_EPENDING);
+}
+
+/**
+ * Receive a reply in binary framing mode.
+ *
+ * The reply and its arguments are written to the buffer as
+ * zero-terminated strings one after another and followed by
+ * the attachment.
+ *
+ * @param rnc           Connection handle
+ * @param buffer        Buffer for data
+ * @param pbytes        See rcf_net_engine_receive()
+ * @param pba           See rcf_net_engine_receive()
+ *
+ * @return Status code (see rcf_net_engine_receive()). If the reply
+ *         with arguments does not fit into the buffer, TE_ESMALLBUF
+ *         is returned and the connection can't be used anymore.
+ */
+static int
+frame_receive(struct rcf_net_connection *rnc, char *buffer, size_t *pbytes,
+              char **pba)
+{
+    rcf_comm_frame_hdr  hdr;
+    size_t              off = 0;
+    size_t              len;
+    unsigned int        type;
+    te_bool             more;
+    int                 ret;
+
+    do {
+        ret = read_socket(rnc->socket, (char *)&hdr, sizeof(hdr));
+        if (ret != 0)
+            return ret;
+
+        type = ntohs(hdr.type);
+        len = ntohl(hdr.len);
+        more = (ntohs(hdr.flags) & RCF_COMM_FRAME_F_MORE) != 0;
+
+        if (type == RCF_COMM_FRAME_ATTACH && off > 0 && !more)
+            return read_attach(rnc, buffer, off, len, pbytes, pba);
+
+        if ((off == 0) != (type == RCF_COMM_FRAME_CMD) ||
+            (type != RCF_COMM_FRAME_CMD && type != RCF_COMM_FRAME_ARG) ||
+            (type == RCF_COMM_FRAME_CMD && len == 0))
+        {
+            fprintf(stderr, "%s(): unexpected element type %u\n",
+                    __FUNCTION__, type);
+            return TE_RC(TE_COMM, TE_EPROTO);
+        }
+
+        if (off + len + 1 > *pbytes)
+            return TE_RC(TE_COMM, TE_ESMALLBUF);
+
+        ret = read_socket(rnc->socket, buffer + off, len);
+        if (ret != 0)
+            return ret;
+        buffer[off + len] = '\0';
+        off += len + 1;
+    } while (more);
+
+    return read_attach(rnc, buffer, off, 0, pbytes, pba);
+}
+
+/**
+ * Send data described by I/O vector (not less). The same retry policy
+ * as in rcf_net_engine_transmit() is used.
+ *
+ * @param socket        Connection socket
+ * @param iov           I/O vector (modified by the function)
+ * @param iovcnt        Number of elements in @p iov
+ *
+ * @return Status code.
+ */
+static int
+write_socket_iov(int socket, struct iovec *iov, int iovcnt)
+{
+#define MAX_TRIES       1000
+    struct msghdr   msg;
+    ssize_t         sent;
+    int             tries = MAX_TRIES;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    while (msg.msg_iovlen > 0)
+    {
+        sent = sendmsg(socket, &msg, MSG_DONTWAIT);
+        if (sent < 0)
+        {
+            if ((errno == EWOULDBLOCK || errno == EAGAIN) && --tries > 0)
+            {
+                usleep(10000);
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            return TE_OS_RC(TE_COMM, errno);
+        }
+        tries = MAX_TRIES;
+
+        while (msg.msg_iovlen > 0 && (size_t)sent >= msg.msg_iov->iov_len)
+        {
+            sent -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0)
+        {
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
+    }
+
+    return 0;
+#undef MAX_TRIES
+}
+
+/**
+ * Add TLV element to the I/O vector.
+ *
+ * @param hdr           Location for the element header
+ * @param iov           I/O vector (two entries are filled in)
+ * @param type          Element type
+ * @param more          Whether more elements follow
+ * @param value         Element value
+ * @param len           Length of the value
+ */
+static void
+frame_add(rcf_comm_frame_hdr *hdr, struct iovec *iov,
+          rcf_comm_frame_type type, te_bool more,
+          const void *value, size_t len)
+{
+    hdr->type = htons(type);
+    hdr->flags = htons(more ? RCF_COMM_FRAME_F_MORE : 0);
+    hdr->len = htonl(len);
+
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = sizeof(*hdr);
+    iov[1].iov_base = (void *)value;
+    iov[1].iov_len = len;
+}
+
+/**
+ * Transmit data in binary framing mode.
+ *
+ * The data are interpreted in the same way as in text mode: a string
+ * terminated by zero byte, optionally with "args <number>" and
+ * "attach <length>" suffixes, zero-terminated arguments and attachment
+ * bytes which may be passed in the same or subsequent calls.
+ * The arguments must be passed in the same call as the command.
+ * The command, arguments and attachment are sent from the caller buffer.
+ *
+ * @param rnc           Connection handle
+ * @param data          Data to be transmitted
+ * @param length        Length of the data
+ *
+ * @return Status code.
+ */
+static int
+frame_transmit(struct rcf_net_connection *rnc, const char *data,
+               size_t length)
+{
+    rcf_comm_frame_hdr  hdr_inline[FRAME_ARGS_INLINE + 2];
+    struct iovec        iov_inline[2 * (FRAME_ARGS_INLINE + 2)];
+    rcf_comm_frame_hdr *hdr = hdr_inline;
+    struct iovec       *iov = iov_inline;
+    size_t              n_alloc = FRAME_ARGS_INLINE;
+    const char         *arg;
+    size_t              cmd_len;
+    size_t              stripped;
+    size_t              attach_len;
+    size_t              n_args;
+    size_t              arg_len;
+    size_t              inline_len;
+    size_t              i;
+    int                 ret = 0;
+
+    while (length > 0)
+    {
+        if (rnc->bytes_to_send > 0)
+        {
+            /* Continuation of the attachment */
+            inline_len = MIN(length, rnc->bytes_to_send);
+
+            iov[0].iov_base = (void *)data;
+            iov[0].iov_len = inline_len;
+            ret = write_socket_iov(rnc->socket, iov, 1);
+            if (ret != 0)
+                break;
+
+            rnc->bytes_to_send -= inline_len;
+            data += inline_len;
+            length -= inline_len;
+            continue;
+        }
+
+        cmd_len = strnlen(data, length);
+        if (cmd_len == length)
+        {
+            ret = TE_RC(TE_COMM, TE_EINVAL);
+            break;
+        }
+
+        stripped = rcf_comm_frame_strip_attach(data, cmd_len, &attach_len);
+        stripped = rcf_comm_frame_strip_args(data, stripped, &n_args);
+        if (n_args > n_alloc)
+        {
+            if (hdr != hdr_inline)
+            {
+                free(hdr);
+                free(iov);
+            }
+            n_alloc = n_args;
+            hdr = calloc(n_alloc + 2, sizeof(*hdr));
+            iov = calloc(2 * (n_alloc + 2), sizeof(*iov));
+            if (hdr == NULL || iov == NULL)
+            {
+                ret = TE_RC(TE_COMM, TE_ENOMEM);
+                break;
+            }
+        }
+
+        frame_add(&hdr[0], &iov[0], RCF_COMM_FRAME_CMD,
+                  n_args > 0 || attach_len > 0, data, stripped);
+
+        arg = data + cmd_len + 1;
+        length -= cmd_len + 1;
+        for (i = 0; i < n_args; i++)
+        {
+            arg_len = strnlen(arg, length);
+            if (arg_len == length)
+            {
+                /* Not all arguments are passed */
+                ret = TE_RC(TE_COMM, TE_EINVAL);
+                break;
+            }
+            frame_add(&hdr[1 + i], &iov[2 * (1 + i)], RCF_COMM_FRAME_ARG,
+                      i + 1 < n_args || attach_len > 0, arg, arg_len);
+            arg += arg_len + 1;
+            length -= arg_len + 1;
+        }
+        if (ret != 0)
+            break;
+
+        inline_len = MIN(attach_len, length);
+        if (attach_len > 0)
+        {
+            frame_add(&hdr[1 + n_args], &iov[2 * (1 + n_args)],
+                      RCF_COMM_FRAME_ATTACH, FALSE, NULL, attach_len);
+            iov[2 * (1 + n_args) + 1].iov_base = (void *)arg;
+            iov[2 * (1 + n_args) + 1].iov_len = inline_len;
+        }
+
+        ret = write_socket_iov(rnc->socket, iov,
+                               2 * (1 + n_args + (attach_len > 0)));
+        if (ret != 0)
+            break;
+
+        rnc->bytes_to_send = attach_len - inline_len;
+        data = arg + inline_len;
+        length -= inline_len;
+    }
+
+    if (hdr != hdr_inline)
+    {
+        free(hdr);
+        free(iov);
+    }
+
+    return ret;
+}
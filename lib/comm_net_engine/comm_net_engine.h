@@ -13,6 +13,7 @@
 #include <sys/types.h>
 
 #include "te_defs.h"
+#include "te_errno.h"
 
 
 /** TCP interval between successful keep-alive probes */
@@ -34,15 +35,13 @@ struct rcf_net_connection;
  * @param  port         - port of the test agent
  * @param  p_rnc        - pointer to to pointer to the rcf_net_connection
  *                        structure to be filled, used as handler
- * @param  p_select_set - pointer to the fdset for reading to be modified
  *
  * @return Status code.
  * @retval 0            - success
  * @retval other value  - errno
  */
 extern int rcf_net_engine_connect(const char *addr, const char *port,
-                                  struct rcf_net_connection **p_rnc,
-                                  fd_set *p_select_set);
+                                  struct rcf_net_connection **p_rnc);
 
 
 /**
@@ -73,6 +72,17 @@ extern int rcf_net_engine_transmit(struct rcf_net_connection *rnc,
 extern te_bool rcf_net_engine_is_ready(struct rcf_net_connection *rnc);
 
 
+/**
+ * Get the socket of the connection to be watched for pending data
+ * (e.g. with poll() or epoll).
+ *
+ * @param rnc       - Handler received from rcf_net_engine_connect.
+ *
+ * @return Socket or -1.
+ */
+extern int rcf_net_engine_get_fd(const struct rcf_net_connection *rnc);
+
+
 /**
  * Receive data from the Test Agent via Network Communication library.
  *
@@ -122,20 +132,32 @@ extern int rcf_net_engine_receive(struct rcf_net_connection *rnc,
                                   char **pba);
 
 
+/**
+ * Negotiate binary framing (see rcf_comm_frame.h) on the connection.
+ * It should be called just after the connection is established, when
+ * no command is sent to the Test Agent yet.
+ *
+ * @param rnc       Handler received from rcf_net_engine_connect
+ *
+ * @return Status code.
+ * @retval TE_EOPNOTSUPP    The agent does not support binary framing,
+ *                          text protocol should be used.
+ */
+extern te_errno rcf_net_engine_set_framing(struct rcf_net_connection *rnc);
+
+
 /**
  * Close connection (socket) to the Test Agent and release the memory used
  * by struct rcf_net_connection *rnc.
  *
  * @param p_rnc         Pointer to variable with handler received from
  *                      rcf_net_engine_connect
- * @param p_select_set  Pointer to the fdset for reading to be modified
  *
  * @return Status code.
  * @retval 0            - success
  * @retval other value  - errno
  */
-extern int rcf_net_engine_close(struct rcf_net_connection **p_rnc,
-                                fd_set *p_select_set);
+extern int rcf_net_engine_close(struct rcf_net_connection **p_rnc);
 
 
 #endif /* !__TE_COMM_NET_ENGINE_H__ */
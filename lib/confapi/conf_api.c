@@ -47,6 +47,7 @@
 #include "te_log_stack.h"
 #include "conf_api.h"
 #include "conf_ipc.h"
+#include "conf_api_cache.h"
 #include "conf_messages.h"
 #include "conf_types.h"
 #include "rcf_api.h"
@@ -579,6 +580,8 @@ cfg_find_str(const char *oid, cfg_handle *handle)
 
     size_t      len;
     te_errno    ret_val = 0;
+    uint64_t    gen;
+    cfg_handle  cached;
 
     if (oid == NULL)
     {
@@ -588,6 +591,18 @@ cfg_find_str(const char *oid, cfg_handle *handle)
 #ifdef HAVE_PTHREAD_H
     pthread_mutex_lock(&cfgl_lock);
 #endif
+    gen = cfg_api_cache_gen();
+    if (cfg_api_cache_find(oid, gen, &cached))
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_unlock(&cfgl_lock);
+#endif
+        if (handle != NULL)
+            *handle = cached;
+        te_log_stack_push("Operating on oid=%s", oid);
+        return 0;
+    }
+
     INIT_IPC;
     if (cfgl_ipc_client == NULL)
     {
@@ -610,9 +625,14 @@ cfg_find_str(const char *oid, cfg_handle *handle)
     ret_val = ipc_send_message_with_answer(cfgl_ipc_client,
                                            CONFIGURATOR_SERVER,
                                            msg, msg->len, msg, &len);
-    if ((ret_val == 0) && ((ret_val = msg->rc) == 0) && (handle != NULL))
+    if ((ret_val == 0) && ((ret_val = msg->rc) == 0))
     {
-        *handle = msg->handle;
+        if (handle != NULL)
+            *handle = msg->handle;
+
+        /* Cache only if the database was not changed meanwhile */
+        if (!msg->vol && gen == cfg_api_cache_gen())
+            cfg_api_cache_put_handle(oid, msg->handle, gen);
     }
 #ifdef HAVE_PTHREAD_H
     pthread_mutex_unlock(&cfgl_lock);
@@ -1664,6 +1684,7 @@ cfg_get_instance(cfg_handle handle, cfg_val_type *type, ...)
     cfg_inst_val    value;
     size_t          len;
     te_errno        rc = 0;
+    uint64_t        gen;
 
     if (handle == CFG_HANDLE_INVALID)
     {
@@ -1673,6 +1694,13 @@ cfg_get_instance(cfg_handle handle, cfg_val_type *type, ...)
 #ifdef HAVE_PTHREAD_H
     pthread_mutex_lock(&cfgl_lock);
 #endif
+    memset(cfgl_msg_buf, 0, sizeof(cfgl_msg_buf));
+    msg = (cfg_get_msg *)cfgl_msg_buf;
+
+    gen = cfg_api_cache_gen();
+    if (cfg_api_cache_get(handle, gen, &msg->val_type, &value))
+        goto got_value;
+
     INIT_IPC;
     if (cfgl_ipc_client == NULL)
     {
@@ -1682,8 +1710,6 @@ cfg_get_instance(cfg_handle handle, cfg_val_type *type, ...)
         return TE_RC(TE_CONF_API, TE_EIPC);
     }
 
-    memset(cfgl_msg_buf, 0, sizeof(cfgl_msg_buf));
-    msg = (cfg_get_msg *)cfgl_msg_buf;
     rc = cfg_ipc_mk_get(msg, CFG_MSG_MAX, handle, FALSE);
     if (rc != 0)
         return rc;
@@ -1703,8 +1729,14 @@ cfg_get_instance(cfg_handle handle, cfg_val_type *type, ...)
         return TE_RC(TE_CONF_API, rc);
     }
 
+    /* Cache only if the database was not changed meanwhile */
+    if (!msg->vol && gen == cfg_api_cache_gen())
+        cfg_api_cache_put_value(handle, msg->val_type, value, gen);
+
+got_value:
     if (type != NULL && *type != CVT_UNSPECIFIED && *type != msg->val_type)
     {
+        cfg_types[msg->val_type].free(value);
 #ifdef HAVE_PTHREAD_H
         pthread_mutex_unlock(&cfgl_lock);
 #endif
@@ -2040,6 +2072,202 @@ cfg_get_addr_sync(struct sockaddr **val, const char *oid_fmt, ...)
     return cfg_get_instance_sync(handle, &type, val);
 }
 
+/**
+ * Unpack instances from CFG_GET_SUBTREE answer.
+ *
+ * @param msg           Answer
+ * @param p_num         Location for the number of instances
+ * @param p_entries     Location for the array of instances
+ *
+ * @return Status code.
+ */
+static te_errno
+cfg_get_subtree_unpack(const cfg_get_subtree_msg *msg, unsigned int *p_num,
+                       cfg_subtree_entry **p_entries)
+{
+    size_t              data_len;
+    size_t              entries_len;
+    cfg_subtree_entry  *entries;
+    uint8_t            *data;
+    size_t              off = 0;
+    uint32_t            i;
+
+    if (msg->len < sizeof(*msg))
+        return TE_EPROTO;
+
+    data_len = msg->len - sizeof(*msg);
+    if (msg->n_entries > data_len / sizeof(cfg_subtree_entry_hdr))
+        return TE_EPROTO;
+
+    if (msg->n_entries == 0)
+        return 0;
+
+    /* Values and OIDs are kept in the same block after the array */
+    entries_len = TE_ALIGN(msg->n_entries * sizeof(*entries),
+                           (size_t)CFG_SUBTREE_ENTRY_ALIGN);
+    entries = TE_ALLOC(entries_len + data_len);
+    if (entries == NULL)
+        return TE_ENOMEM;
+
+    data = (uint8_t *)entries + entries_len;
+    memcpy(data, msg->buf, data_len);
+
+    for (i = 0; i < msg->n_entries; i++)
+    {
+        cfg_subtree_entry_hdr   hdr;
+        size_t                  val_off;
+        size_t                  oid_off;
+
+        if (data_len - off < sizeof(hdr))
+            break;
+        memcpy(&hdr, data + off, sizeof(hdr));
+
+        val_off = off + sizeof(hdr);
+        oid_off = val_off + TE_ALIGN(hdr.val_len, CFG_SUBTREE_ENTRY_ALIGN);
+        if (hdr.val_type >= CFG_PRIMARY_TYPES_NUM || hdr.oid_len == 0 ||
+            oid_off + hdr.oid_len > data_len ||
+            data[oid_off + hdr.oid_len - 1] != '\0')
+            break;
+
+        entries[i].handle = hdr.handle;
+        entries[i].oid = (const char *)data + oid_off;
+        entries[i].type = hdr.val_type;
+        memset(&entries[i].val, 0, sizeof(entries[i].val));
+        switch (hdr.val_type)
+        {
+            case CVT_NONE:
+                break;
+
+            case CVT_STRING:
+                entries[i].val.val_str = (char *)data + val_off;
+                break;
+
+            case CVT_ADDRESS:
+                entries[i].val.val_addr =
+                    (struct sockaddr *)(data + val_off);
+                break;
+
+            default:
+                if (hdr.val_len > sizeof(entries[i].val))
+                    goto fail;
+                memcpy(&entries[i].val, data + val_off, hdr.val_len);
+                break;
+        }
+
+        off = TE_ALIGN(oid_off + hdr.oid_len,
+                       (size_t)CFG_SUBTREE_ENTRY_ALIGN);
+    }
+
+    if (i == msg->n_entries)
+    {
+        *p_num = msg->n_entries;
+        *p_entries = entries;
+        return 0;
+    }
+
+fail:
+    ERROR("Malformed answer to get subtree request");
+    free(entries);
+    return TE_EPROTO;
+}
+
+/* See description in conf_api.h */
+te_errno
+cfg_get_subtree(const char *pattern, te_bool subtree, te_bool sync,
+                unsigned int *p_num, cfg_subtree_entry **p_entries)
+{
+    cfg_get_subtree_msg *msg;
+    char                *alloc_msg = NULL;
+
+    size_t  len;
+    int     ret_val = 0;
+
+    if (pattern == NULL || p_num == NULL || p_entries == NULL)
+        return TE_RC(TE_CONF_API, TE_EINVAL);
+
+    *p_num = 0;
+    *p_entries = NULL;
+
+    len = strlen(pattern) + 1;
+    if (len > CFG_OID_MAX)
+        return TE_RC(TE_CONF_API, TE_ENAMETOOLONG);
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&cfgl_lock);
+#endif
+    INIT_IPC;
+    if (cfgl_ipc_client == NULL)
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_unlock(&cfgl_lock);
+#endif
+        return TE_RC(TE_CONF_API, TE_EIPC);
+    }
+
+    memset(cfgl_msg_buf, 0, sizeof(cfg_get_subtree_msg));
+    msg = (cfg_get_subtree_msg *)cfgl_msg_buf;
+
+    msg->type = CFG_GET_SUBTREE;
+    msg->sync = sync;
+    msg->subtree = subtree;
+    memcpy(msg->buf, pattern, len);
+    msg->len = sizeof(*msg) + len;
+    len = CFG_MSG_MAX;
+
+    ret_val = ipc_send_message_with_answer(cfgl_ipc_client,
+                                           CONFIGURATOR_SERVER,
+                                           msg, msg->len, msg, &len);
+    if (TE_RC_GET_ERROR(ret_val) == TE_ESMALLBUF)
+    {
+        size_t  rest_len = len - CFG_MSG_MAX;
+
+        /* The rest of a big answer is received directly after its head */
+        assert(len > CFG_MSG_MAX);
+        alloc_msg = malloc(len);
+        if (alloc_msg == NULL)
+        {
+            ret_val = TE_ENOMEM;
+        }
+        else
+        {
+            ret_val = ipc_receive_rest_answer(cfgl_ipc_client,
+                                              CONFIGURATOR_SERVER,
+                                              alloc_msg + CFG_MSG_MAX,
+                                              &rest_len);
+            if (ret_val == 0)
+            {
+                memcpy(alloc_msg, msg, CFG_MSG_MAX);
+                msg = (cfg_get_subtree_msg *)alloc_msg;
+            }
+        }
+    }
+    if (ret_val == 0 && (ret_val = msg->rc) == 0)
+        ret_val = cfg_get_subtree_unpack(msg, p_num, p_entries);
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&cfgl_lock);
+#endif
+    free(alloc_msg);
+    return TE_RC(TE_CONF_API, ret_val);
+}
+
+/* See description in conf_api.h */
+te_errno
+cfg_get_subtree_fmt(te_bool subtree, unsigned int *p_num,
+                    cfg_subtree_entry **p_entries, const char *ptrn_fmt, ...)
+{
+    va_list ap;
+    char    ptrn[CFG_OID_MAX];
+    int     res;
+
+    va_start(ap, ptrn_fmt);
+    res = vsnprintf(ptrn, sizeof(ptrn), ptrn_fmt, ap);
+    va_end(ap);
+    if (res < 0 || res >= (int)sizeof(ptrn))
+        return TE_RC(TE_CONF_API, TE_ENAMETOOLONG);
+
+    return cfg_get_subtree(ptrn, subtree, FALSE, p_num, p_entries);
+}
+
 /* See description in conf_api.h */
 te_errno
 cfg_synchronize(const char *oid, te_bool subtree)
@@ -2248,9 +2476,57 @@ cfg_reboot_ta(const char *ta_name, te_bool restore,
 }
 
 
+/**
+ * Put subtrees to a backup message after its fixed part and set
+ * the offset of the backup file name after them.
+ *
+ * @param msg       backup message
+ * @param subtrees  vector of subtrees (char *) or @c NULL
+ *
+ * @return status code (see te_errno.h)
+ */
+static te_errno
+cfg_backup_msg_put_subtrees(cfg_backup_msg *msg, const te_vec *subtrees)
+{
+    char * const *subtree;
+    size_t        len;
+
+    msg->len = sizeof(cfg_backup_msg);
+    msg->subtrees_num = 0;
+    msg->subtrees_offset = msg->len;
+
+    if (subtrees != NULL)
+    {
+        TE_VEC_FOREACH(subtrees, subtree)
+        {
+            len = strlen(*subtree) + 1;
+            /* Leave room for the backup file name */
+            if (msg->len + len + RCF_MAX_PATH > CFG_OID_MAX)
+            {
+                ERROR("Too many subtrees to backup");
+                return TE_E2BIG;
+            }
+
+            memcpy((char *)msg + msg->len, *subtree, len);
+            msg->len += len;
+            msg->subtrees_num++;
+        }
+    }
+
+    msg->filename_offset = msg->len;
+    return 0;
+}
+
 /* See description in conf_api.h */
 te_errno
 cfg_create_backup(char **name)
+{
+    return cfg_create_backup_subtrees(name, NULL);
+}
+
+/* See description in conf_api.h */
+te_errno
+cfg_create_backup_subtrees(char **name, const te_vec *subtrees)
 {
     cfg_backup_msg *msg;
 
@@ -2275,10 +2551,14 @@ cfg_create_backup(char **name)
     msg = (cfg_backup_msg *)cfgl_msg_buf;
     msg->type = CFG_BACKUP;
     msg->op = CFG_BACKUP_CREATE;
-    msg->len = sizeof(cfg_backup_msg);
-    msg->subtrees_num = 0;
-    msg->subtrees_offset = msg->len;
-    msg->filename_offset = msg->len;
+    ret_val = cfg_backup_msg_put_subtrees(msg, subtrees);
+    if (ret_val != 0)
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_unlock(&cfgl_lock);
+#endif
+        return TE_RC(TE_CONF_API, ret_val);
+    }
     len = CFG_MSG_MAX;
 
     ret_val = ipc_send_message_with_answer(cfgl_ipc_client,
@@ -2308,11 +2588,13 @@ cfg_create_backup(char **name)
  *
  * @param name      name returned by cfg_create_backup
  * @param op        backup operation
+ * @param subtrees  vector of subtrees (char *) to process or @c NULL
+ *                  for the whole backup
  *
  * @return status code (see te_errno.h)
  */
 static te_errno
-cfg_backup(const char *name, uint8_t op)
+cfg_backup(const char *name, uint8_t op, const te_vec *subtrees)
 {
     cfg_backup_msg *msg;
 
@@ -2338,13 +2620,18 @@ cfg_backup(const char *name, uint8_t op)
     msg = (cfg_backup_msg *)cfgl_msg_buf;
     msg->type = CFG_BACKUP;
     msg->op = op;
-    msg->len = sizeof(cfg_backup_msg);
-
-    msg->subtrees_num = 0;
-    msg->subtrees_offset = msg->len;
-    msg->filename_offset = msg->len;
-
+    ret_val = cfg_backup_msg_put_subtrees(msg, subtrees);
     len = strlen(name) + 1;
+    if (ret_val == 0 && msg->len + len > CFG_OID_MAX)
+        ret_val = TE_E2BIG;
+    if (ret_val != 0)
+    {
+#ifdef HAVE_PTHREAD_H
+        pthread_mutex_unlock(&cfgl_lock);
+#endif
+        return TE_RC(TE_CONF_API, ret_val);
+    }
+
     msg->len += len;
 
     memcpy((char *)msg + msg->filename_offset, name, len);
@@ -2368,7 +2655,14 @@ cfg_backup(const char *name, uint8_t op)
 te_errno
 cfg_verify_backup(const char *name)
 {
-    return cfg_backup(name, CFG_BACKUP_VERIFY);
+    return cfg_backup(name, CFG_BACKUP_VERIFY, NULL);
+}
+
+/* See description in conf_api.h */
+te_errno
+cfg_verify_backup_subtrees(const char *name, const te_vec *subtrees)
+{
+    return cfg_backup(name, CFG_BACKUP_VERIFY, subtrees);
 }
 
 /* See description in conf_api.h */
@@ -2380,7 +2674,7 @@ cfg_release_backup(char **name)
     if (name == NULL)
         return TE_RC(TE_CONF_API, TE_EINVAL);
 
-    rc = cfg_backup(*name, CFG_BACKUP_RELEASE);
+    rc = cfg_backup(*name, CFG_BACKUP_RELEASE, NULL);
     if (rc == 0)
     {
         free(*name);
@@ -2394,14 +2688,21 @@ cfg_release_backup(char **name)
 te_errno
 cfg_restore_backup(const char *name)
 {
-    return cfg_backup(name, CFG_BACKUP_RESTORE);
+    return cfg_backup(name, CFG_BACKUP_RESTORE, NULL);
 }
 
 /* See description in conf_api.h */
 te_errno
 cfg_restore_backup_nohistory(const char *name)
 {
-    return cfg_backup(name, CFG_BACKUP_RESTORE_NOHISTORY);
+    return cfg_backup(name, CFG_BACKUP_RESTORE_NOHISTORY, NULL);
+}
+
+/* See description in conf_api.h */
+te_errno
+cfg_restore_backup_subtrees(const char *name, const te_vec *subtrees)
+{
+    return cfg_backup(name, CFG_BACKUP_RESTORE_NOHISTORY, subtrees);
 }
 
 
@@ -2525,12 +2826,42 @@ done:
 }
 
 
+/* See description in conf_api.h */
+void
+cfg_api_cache_enable(te_bool enable)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&cfgl_lock);
+#endif
+    cfg_api_cache_set_enabled(enable);
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&cfgl_lock);
+#endif
+}
+
+/* See description in conf_api.h */
+uint64_t
+cfg_api_cache_hits(void)
+{
+    uint64_t hits;
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&cfgl_lock);
+#endif
+    hits = cfg_api_cache_hit_count();
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&cfgl_lock);
+#endif
+    return hits;
+}
+
 /* See description in conf_api.h */
 void
 cfg_api_cleanup(void)
 {
     int rc = ipc_close_client(cfgl_ipc_client);
 
+    cfgl_ipc_client = NULL;
     if (rc != 0)
     {
         ERROR("%s(): ipc_close_client() failed with rc=%d",
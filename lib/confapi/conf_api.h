@@ -46,6 +46,7 @@
 #include "cs_common.h"
 #include "conf_oid.h"
 #include "te_kvpair.h"
+#include "te_vector.h"
 #include "rcf_api.h"
 
 #ifdef __cplusplus
@@ -826,6 +827,48 @@ extern te_errno cfg_get_addr_sync(struct sockaddr **val,
                                   const char *oid_fmt, ...)
                                   __attribute__((format(printf, 2, 3)));
 
+/** Object instance read by cfg_get_subtree() */
+typedef struct cfg_subtree_entry {
+    cfg_handle      handle;     /**< Instance handle */
+    const char     *oid;        /**< Instance OID */
+    cfg_val_type    type;       /**< Value type */
+    cfg_inst_val    val;        /**< Value; strings and addresses are
+                                     stored in the array memory and must
+                                     not be freed separately */
+} cfg_subtree_entry;
+
+/**
+ * Get handles, OIDs and values of all object instances matching
+ * a pattern (and of their descendants) using a single request to
+ * Configurator. It is much faster than getting each instance
+ * separately when many instances are read.
+ *
+ * @param pattern       OID or pattern of instances to read
+ * @param subtree       Read descendants of matched instances as well
+ *                      (fathers precede their sons in the array)
+ * @param sync          Synchronize instances with Test Agents before
+ *                      reading (instances of volatile objects are
+ *                      synchronized anyway)
+ * @param p_num         Location for the number of read instances
+ * @param p_entries     Location for the array of read instances;
+ *                      the array is allocated as a single memory block
+ *                      and should be released with free()
+ *
+ * @return Status code (see te_errno.h)
+ */
+extern te_errno cfg_get_subtree(const char *pattern, te_bool subtree,
+                                te_bool sync, unsigned int *p_num,
+                                cfg_subtree_entry **p_entries);
+
+/**
+ * The same function as cfg_get_subtree(), but instances are not
+ * synchronized and pattern may be format string.
+ */
+extern te_errno cfg_get_subtree_fmt(te_bool subtree, unsigned int *p_num,
+                                    cfg_subtree_entry **p_entries,
+                                    const char *ptrn_fmt, ...)
+                                    __attribute__((format(printf, 4, 5)));
+
 /**@}*/
 
 /** @defgroup confapi_base_sync Synchronization configuration tree with Test Agent
@@ -907,6 +950,19 @@ extern te_errno cfg_reboot_ta(const char *ta_name, te_bool restore,
  */
 extern te_errno cfg_create_backup(char **name);
 
+/**
+ * Create a backup of configuration subtrees. Such backup should be
+ * verified and restored with the same subtrees, while the rest of
+ * configuration may be changed by someone else meanwhile.
+ *
+ * @param name      OUT: location for backup file name
+ * @param subtrees  Vector of subtrees (@c char *), e.g. "/agent:Agt_A"
+ *
+ * @return Status code (see te_errno.h)
+ */
+extern te_errno cfg_create_backup_subtrees(char **name,
+                                           const te_vec *subtrees);
+
 /**
  * Verify the backup.
  *
@@ -918,6 +974,20 @@ extern te_errno cfg_create_backup(char **name);
  */
 extern te_errno cfg_verify_backup(const char *name);
 
+/**
+ * Verify subtrees of the backup.
+ *
+ * @param name      name returned by cfg_create_backup_subtrees
+ * @param subtrees  Vector of subtrees (@c char *) passed on creation
+ *
+ * @return Status code (see te_errno.h)
+ * @retval 0            current configuration of the subtrees is equal
+ *                      to backup
+ * @retval TE_EBACKUP   current configuration differs from backup
+ */
+extern te_errno cfg_verify_backup_subtrees(const char *name,
+                                           const te_vec *subtrees);
+
 /**
  * Restore the backup.
  *
@@ -936,6 +1006,18 @@ extern te_errno cfg_restore_backup(const char *name);
  */
 extern te_errno cfg_restore_backup_nohistory(const char *name);
 
+/**
+ * Restore subtrees of the backup. History is not processed, since it
+ * contains changes of other subtrees as well.
+ *
+ * @param name      name returned by cfg_create_backup_subtrees
+ * @param subtrees  Vector of subtrees (@c char *) passed on creation
+ *
+ * @return Status code (see te_errno.h)
+ */
+extern te_errno cfg_restore_backup_subtrees(const char *name,
+                                            const te_vec *subtrees);
+
 
 /**
  * Ask Configurator to forget about the backup, if known.
@@ -1024,9 +1106,31 @@ extern te_errno cfg_tree_print(const char *filename,
  *
  * Usually user should not worry about calling of the function, since
  * it is called automatically using atexit() mechanism.
+ * A child created by fork() should call it before using the API to
+ * get its own connection to Configurator.
  */
 extern void cfg_api_cleanup(void);
 
+/**
+ * Enable or disable per-process cache of handles found by OIDs and
+ * instance values. Cached data are used while the Configurator database
+ * is not changed by anyone, so the cache is transparent for users;
+ * instances of volatile objects and synchronized reads are never cached.
+ * By default the cache is enabled if @c TE_CONF_API_CACHE environment
+ * variable is set to a non-zero number.
+ *
+ * @param enable        Whether to enable the cache
+ */
+extern void cfg_api_cache_enable(te_bool enable);
+
+/**
+ * Get the number of cfg_find() and cfg_get_instance() lookups served
+ * from the per-process cache (see cfg_api_cache_enable()).
+ *
+ * @return Number of cache hits since the process start.
+ */
+extern uint64_t cfg_api_cache_hits(void);
+
 /**
  * Copy a subtree pointed to by its OID format string to a
  * destination pointed to by OID of the tree to be created.
@@ -0,0 +1,302 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator
+ *
+ * Client-side cache of Configurator handles and instance values.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "Configurator API"
+
+#include "te_config.h"
+
+#include <stdio.h>
+#include <limits.h>
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "te_defs.h"
+#include "te_str.h"
+#include "logger_api.h"
+#include "conf_messages.h"
+#include "conf_api_cache.h"
+
+/** Number of slots in each cache table (power of 2) */
+#define CFG_API_CACHE_SIZE      1024
+
+/** Environment variable which enables the cache */
+#define CFG_API_CACHE_ENV       "TE_CONF_API_CACHE"
+
+/** Cached handle of an OID */
+typedef struct cfg_api_cache_handle {
+    uint64_t    gen;        /**< Generation of the entry */
+    char       *oid;        /**< OID */
+    cfg_handle  handle;     /**< Handle */
+} cfg_api_cache_handle;
+
+/** Cached value of an instance */
+typedef struct cfg_api_cache_value {
+    uint64_t        gen;    /**< Generation of the entry */
+    cfg_handle      handle; /**< Instance handle */
+    cfg_val_type    type;   /**< Value type */
+    cfg_inst_val    val;    /**< Value */
+} cfg_api_cache_value;
+
+/** State of the cache */
+typedef enum cfg_api_cache_state {
+    CFG_API_CACHE_INIT = 0,     /**< Enabling is not checked yet */
+    CFG_API_CACHE_ENABLED,      /**< Cache is enabled */
+    CFG_API_CACHE_DISABLED,     /**< Cache is disabled or unsupported */
+} cfg_api_cache_state;
+
+/** Current state of the cache */
+static cfg_api_cache_state cache_state = CFG_API_CACHE_INIT;
+
+/** Generation of the database shared by Configurator */
+static const uint64_t *cache_db_gen = NULL;
+
+/** Handles cached by OID hash */
+static cfg_api_cache_handle cache_handles[CFG_API_CACHE_SIZE];
+/** Values cached by instance handle hash */
+static cfg_api_cache_value cache_values[CFG_API_CACHE_SIZE];
+
+/** Number of lookups served from the cache */
+static uint64_t cache_hits = 0;
+
+/**
+ * Map generation of the database shared by Configurator.
+ *
+ * @return @c TRUE if the generation is available.
+ */
+static te_bool
+cache_map_gen(void)
+{
+    const char *tmp_dir = getenv("TE_TMP");
+    char        path[PATH_MAX];
+    void       *ptr;
+    int         fd;
+    int         len;
+
+    if (tmp_dir == NULL)
+        return FALSE;
+
+    len = snprintf(path, sizeof(path), "%s/%s" CFG_DB_GEN_FILE_SUFFIX,
+                   tmp_dir, CONFIGURATOR_SERVER);
+    if (len < 0 || (size_t)len >= sizeof(path))
+        return FALSE;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        WARN("Cache of Configurator data is disabled since %s cannot "
+             "be opened", path);
+        return FALSE;
+    }
+
+    ptr = mmap(NULL, sizeof(*cache_db_gen), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return FALSE;
+
+    cache_db_gen = ptr;
+    return TRUE;
+}
+
+/** Drop all cached data. */
+static void
+cache_flush(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < CFG_API_CACHE_SIZE; i++)
+    {
+        free(cache_handles[i].oid);
+        cache_handles[i].oid = NULL;
+        cache_handles[i].gen = CFG_API_CACHE_GEN_NONE;
+
+        if (cache_values[i].gen != CFG_API_CACHE_GEN_NONE)
+        {
+            cfg_types[cache_values[i].type].free(cache_values[i].val);
+            cache_values[i].gen = CFG_API_CACHE_GEN_NONE;
+        }
+    }
+}
+
+/* See description in conf_api_cache.h */
+void
+cfg_api_cache_set_enabled(te_bool enable)
+{
+    cache_flush();
+    cache_state = enable ? CFG_API_CACHE_ENABLED : CFG_API_CACHE_DISABLED;
+}
+
+/* See description in conf_api_cache.h */
+uint64_t
+cfg_api_cache_hit_count(void)
+{
+    return cache_hits;
+}
+
+/* See description in conf_api_cache.h */
+uint64_t
+cfg_api_cache_gen(void)
+{
+    if (cache_state == CFG_API_CACHE_INIT)
+    {
+        const char *env = getenv(CFG_API_CACHE_ENV);
+        te_bool     enable = FALSE;
+
+        if (env != NULL && te_strtol_bool(env, &enable) != 0)
+            enable = FALSE;
+        cache_state = enable ? CFG_API_CACHE_ENABLED :
+                               CFG_API_CACHE_DISABLED;
+    }
+
+    if (cache_state != CFG_API_CACHE_ENABLED)
+        return CFG_API_CACHE_GEN_NONE;
+
+    if (cache_db_gen == NULL && !cache_map_gen())
+    {
+        cache_state = CFG_API_CACHE_DISABLED;
+        return CFG_API_CACHE_GEN_NONE;
+    }
+
+    return __atomic_load_n(cache_db_gen, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Get the slot of an OID in the table of handles.
+ *
+ * @param oid           OID
+ *
+ * @return Cache slot.
+ */
+static cfg_api_cache_handle *
+cache_handle_slot(const char *oid)
+{
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a */
+    for (; *oid != '\0'; oid++)
+    {
+        hash ^= (uint8_t)*oid;
+        hash *= 16777619u;
+    }
+
+    return &cache_handles[hash & (CFG_API_CACHE_SIZE - 1)];
+}
+
+/**
+ * Get the slot of an instance in the table of values.
+ *
+ * @param handle        Instance handle
+ *
+ * @return Cache slot.
+ */
+static cfg_api_cache_value *
+cache_value_slot(cfg_handle handle)
+{
+    uint64_t hash = handle * 0x9e3779b97f4a7c15ULL;
+
+    return &cache_values[(hash >> 32) & (CFG_API_CACHE_SIZE - 1)];
+}
+
+/* See description in conf_api_cache.h */
+te_bool
+cfg_api_cache_find(const char *oid, uint64_t gen, cfg_handle *handle)
+{
+    cfg_api_cache_handle *slot;
+
+    if (gen == CFG_API_CACHE_GEN_NONE)
+        return FALSE;
+
+    slot = cache_handle_slot(oid);
+    if (slot->gen != gen || strcmp(slot->oid, oid) != 0)
+        return FALSE;
+
+    *handle = slot->handle;
+    cache_hits++;
+    return TRUE;
+}
+
+/* See description in conf_api_cache.h */
+void
+cfg_api_cache_put_handle(const char *oid, cfg_handle handle, uint64_t gen)
+{
+    cfg_api_cache_handle   *slot;
+    char                   *dup;
+
+    if (gen == CFG_API_CACHE_GEN_NONE)
+        return;
+
+    slot = cache_handle_slot(oid);
+    if (slot->oid == NULL || strcmp(slot->oid, oid) != 0)
+    {
+        dup = strdup(oid);
+        if (dup == NULL)
+            return;
+        free(slot->oid);
+        slot->oid = dup;
+    }
+
+    slot->handle = handle;
+    slot->gen = gen;
+}
+
+/* See description in conf_api_cache.h */
+te_bool
+cfg_api_cache_get(cfg_handle handle, uint64_t gen, cfg_val_type *type,
+                  cfg_inst_val *val)
+{
+    cfg_api_cache_value *slot;
+
+    if (gen == CFG_API_CACHE_GEN_NONE)
+        return FALSE;
+
+    slot = cache_value_slot(handle);
+    if (slot->gen != gen || slot->handle != handle)
+        return FALSE;
+
+    if (cfg_types[slot->type].copy(slot->val, val) != 0)
+        return FALSE;
+
+    *type = slot->type;
+    cache_hits++;
+    return TRUE;
+}
+
+/* See description in conf_api_cache.h */
+void
+cfg_api_cache_put_value(cfg_handle handle, cfg_val_type type,
+                        cfg_inst_val val, uint64_t gen)
+{
+    cfg_api_cache_value *slot;
+    cfg_inst_val         copy;
+
+    if (gen == CFG_API_CACHE_GEN_NONE ||
+        cfg_types[type].copy(val, &copy) != 0)
+        return;
+
+    slot = cache_value_slot(handle);
+    if (slot->gen != CFG_API_CACHE_GEN_NONE)
+        cfg_types[slot->type].free(slot->val);
+
+    slot->handle = handle;
+    slot->type = type;
+    slot->val = copy;
+    slot->gen = gen;
+}
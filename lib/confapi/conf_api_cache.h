@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Configurator
+ *
+ * Client-side cache of Configurator handles and instance values.
+ *
+ * Cached data are tagged with generation of the Configurator database
+ * (see @ref CFG_DB_GEN_FILE_SUFFIX) and are valid while the generation
+ * is not changed. The functions are not thread-safe and must be called
+ * under the lock of the Configurator API.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#ifndef __TE_CONF_API_CACHE_H__
+#define __TE_CONF_API_CACHE_H__
+
+#include "te_defs.h"
+#include "te_stdint.h"
+#include "conf_api.h"
+#include "conf_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Generation meaning that the cache must not be used */
+#define CFG_API_CACHE_GEN_NONE  0
+
+/**
+ * Enable or disable the cache. Cached data are dropped.
+ *
+ * @param enable        Whether to enable the cache
+ */
+extern void cfg_api_cache_set_enabled(te_bool enable);
+
+/**
+ * Get the number of lookups served from the cache.
+ *
+ * @return Number of cache hits since the process start.
+ */
+extern uint64_t cfg_api_cache_hit_count(void);
+
+/**
+ * Get the current generation of the Configurator database.
+ * The generation should be obtained before sending a request whose
+ * answer is to be cached and compared after the answer is received.
+ *
+ * @return Generation or @c CFG_API_CACHE_GEN_NONE if the cache is
+ *         disabled or not supported by Configurator.
+ */
+extern uint64_t cfg_api_cache_gen(void);
+
+/**
+ * Look up a handle by OID.
+ *
+ * @param oid           Object or instance identifier
+ * @param gen           Current generation
+ * @param handle        Location for the handle
+ *
+ * @return @c TRUE if the handle is found.
+ */
+extern te_bool cfg_api_cache_find(const char *oid, uint64_t gen,
+                                  cfg_handle *handle);
+
+/**
+ * Remember a handle found by OID.
+ *
+ * @param oid           Object or instance identifier
+ * @param handle        Handle
+ * @param gen           Generation at which the handle was found
+ */
+extern void cfg_api_cache_put_handle(const char *oid, cfg_handle handle,
+                                     uint64_t gen);
+
+/**
+ * Look up an instance value.
+ *
+ * @param handle        Instance handle
+ * @param gen           Current generation
+ * @param type          Location for the value type
+ * @param val           Location for the copy of the value
+ *
+ * @return @c TRUE if the value is found.
+ */
+extern te_bool cfg_api_cache_get(cfg_handle handle, uint64_t gen,
+                                 cfg_val_type *type, cfg_inst_val *val);
+
+/**
+ * Remember an instance value.
+ *
+ * @param handle        Instance handle
+ * @param type          Value type
+ * @param val           Value (it is copied)
+ * @param gen           Generation at which the value was read
+ */
+extern void cfg_api_cache_put_value(cfg_handle handle, cfg_val_type type,
+                                    cfg_inst_val val, uint64_t gen);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* !__TE_CONF_API_CACHE_H__ */
@@ -32,6 +32,15 @@ cs_server_name(void)
 /** Configurator's server name */
 #define CONFIGURATOR_SERVER     cs_server_name()
 
+/**
+ * Suffix of the name of the file in @c TE_TMP directory which contains
+ * generation of the Configurator database: 64-bit counter which is
+ * incremented on each change of the database. Configurator and its
+ * clients map the file to memory, so clients may check whether cached
+ * data are still valid without a request to Configurator.
+ */
+#define CFG_DB_GEN_FILE_SUFFIX  ".gen"
+
 /** Type of IPC used by Configurator */
 #define CONFIGURATOR_IPC        (TRUE) /* Connection-oriented IPC */
 
@@ -71,6 +80,9 @@ enum {
     CFG_TREE_PRINT,/**< Print a tree of obj|ins from a prefix */
     CFG_PROCESS_HISTORY,/**< Process history configuration file
                              IN: file name, key-value pairs to substitute */
+    CFG_GET_SUBTREE,/**< Get handles, OIDs and values of instances:
+                         IN: OID or pattern, subtree and sync flags;
+                         OUT: array of packed instances */
 };
 
 /* Set of generic fields of the Configurator message */
@@ -111,6 +123,8 @@ typedef struct cfg_unregister_msg {
 typedef struct cfg_find_msg {
     CFG_MSG_FIELDS
     cfg_handle    handle;   /**< OUT: handle of found object */
+    te_bool       vol;      /**< OUT: instance belongs to a volatile
+                                 subtree and must not be cached */
     char          oid[0];   /**< In: start of the object identifier */
 } cfg_find_msg;
 
@@ -142,6 +156,34 @@ typedef struct cfg_pattern_msg {
     cfg_handle handles[0];  /**< OUT: start of handles array */
 } cfg_pattern_msg;
 
+/** CFG_GET_SUBTREE message content */
+typedef struct cfg_get_subtree_msg {
+    CFG_MSG_FIELDS
+    te_bool    sync;        /**< IN: synchronize instances with Test
+                                 Agents before reading */
+    te_bool    subtree;     /**< IN: read descendants of matched
+                                 instances as well */
+    uint32_t   n_entries;   /**< OUT: number of packed instances */
+    char       buf[0];      /**< IN: OID or pattern;
+                                 OUT: packed instances, each one is
+                                 cfg_subtree_entry_hdr followed by
+                                 the value and the OID and padded
+                                 to CFG_SUBTREE_ENTRY_ALIGN */
+} cfg_get_subtree_msg;
+
+/** Header of an instance packed into CFG_GET_SUBTREE answer */
+typedef struct cfg_subtree_entry_hdr {
+    cfg_handle  handle;     /**< Instance handle */
+    uint32_t    val_type;   /**< Value type (cfg_val_type) */
+    uint32_t    val_len;    /**< Length of the value: in-memory
+                                 representation of integers and
+                                 addresses, string with trailing zero */
+    uint32_t    oid_len;    /**< Length of the OID with trailing zero */
+} cfg_subtree_entry_hdr;
+
+/** Alignment of instances packed into CFG_GET_SUBTREE answer */
+#define CFG_SUBTREE_ENTRY_ALIGN     8
+
 /** CFG_FAMILY message content  */
 typedef struct cfg_family_msg {
     CFG_MSG_FIELDS
@@ -219,6 +261,8 @@ typedef struct cfg_get_msg {
     te_bool         sync;        /**< Synchronization get */
     cfg_handle      handle;      /**< IN */
     cfg_val_type    val_type;    /**< Object value type */
+    te_bool         vol;         /**< OUT: instance belongs to a volatile
+                                      subtree and must not be cached */
     union {
         struct sockaddr val_addr[0]; /**< start of sockaddr value */
         char            val_str[0];  /**< start of string value */
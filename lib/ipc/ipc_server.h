@@ -97,6 +97,31 @@ extern int ipc_get_server_fds(const struct ipc_server *ipcs,
 extern te_bool ipc_is_server_ready(struct ipc_server *ipcs,
                                    const fd_set *set, int max_fd);
 
+/**
+ * Get a single file descriptor which becomes readable when a new
+ * connection is requested or data arrive via any of client connections.
+ * Unlike ipc_get_server_fds() it does not depend on the number of
+ * clients and may be watched with poll() or epoll.
+ *
+ * @param ipcs          Pointer to the ipc_server structure returned
+ *                      by ipc_register_server()
+ *
+ * @return File descriptor or -1 if it is not supported.
+ */
+extern int ipc_get_server_poll_fd(const struct ipc_server *ipcs);
+
+/**
+ * Check without blocking whether the server is ready, i.e.
+ * ipc_receive_message() would not block. It should be called when
+ * the descriptor returned by ipc_get_server_poll_fd() is readable.
+ *
+ * @param ipcs          Pointer to the ipc_server structure returned
+ *                      by ipc_register_server()
+ *
+ * @return Is server ready or not?
+ */
+extern te_bool ipc_check_server_ready(struct ipc_server *ipcs);
+
 /**
  * Get name of the IPC server client.
  *
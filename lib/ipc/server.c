@@ -38,6 +38,9 @@
 #if HAVE_SYS_POLL_H
 #include <sys/poll.h>
 #endif
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 #ifndef TE_IPC_AF_UNIX
 #if HAVE_NETINET_IN_H
@@ -119,6 +122,11 @@ struct ipc_server {
     char    name[UNIX_PATH_MAX];    /**< Name of the server */
     int     socket;                 /**< Server socket */
     te_bool is_ready;               /**< Is server socket ready? */
+#if HAVE_SYS_EPOLL_H
+    int     epfd;                   /**< epoll descriptor watching
+                                         the server socket and all
+                                         client connections */
+#endif
 
     /** List of "active" IPC clients */
     LIST_HEAD(ipc_server_clients, ipc_server_client) clients;
@@ -342,6 +350,22 @@ ipc_register_server(const char *name, te_bool conn,
         ipcs->send = ipc_dgram_send_answer;
     }
 
+#if HAVE_SYS_EPOLL_H
+    {
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+
+        ipcs->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (ipcs->epfd < 0 ||
+            epoll_ctl(ipcs->epfd, EPOLL_CTL_ADD, ipcs->socket, &ev) != 0)
+        {
+            rc = errno;
+            perror("ipc_register_server(): epoll error");
+            ipc_close_server(ipcs);
+            return TE_OS_RC(TE_IPC, rc);
+        }
+    }
+#endif
+
     *p_ipcs = ipcs;
 
     return 0;
@@ -379,6 +403,9 @@ ipc_get_server_fds(const struct ipc_server *ipcs, fd_set *set)
     return max_fd;
 }
 
+/** Maximum number of events processed by one epoll_wait() call */
+#define IPC_SERVER_POLL_EVENTS  16
+
 /**
  * Close IPC server association with client.
  *
@@ -386,16 +413,54 @@ ipc_get_server_fds(const struct ipc_server *ipcs, fd_set *set)
  * @param conn      Is connection-oriented server client or not?
  */
 static void
-ipc_server_close_client(struct ipc_server_client *ipcsc, te_bool conn)
+ipc_server_close_client(struct ipc_server *ipcs,
+                        struct ipc_server_client *ipcsc)
 {
     LIST_REMOVE(ipcsc, links);
-    if (conn)
+    if (ipcs->conn)
+    {
+#if HAVE_SYS_EPOLL_H
+        (void)epoll_ctl(ipcs->epfd, EPOLL_CTL_DEL, ipcsc->stream.socket,
+                        NULL);
+#endif
         close(ipcsc->stream.socket);
+    }
     else
+    {
         free(ipcsc->dgram.buffer);
+    }
     free(ipcsc);
 }
 
+/**
+ * Check whether the client connection has data to read. The connection
+ * is closed if it is readable, but has no data (client has gone).
+ *
+ * @param ipcs      IPC server
+ * @param client    Client with readable socket
+ *
+ * @return @c TRUE if there are data to read.
+ */
+static te_bool
+ipc_server_client_has_data(struct ipc_server *ipcs,
+                           struct ipc_server_client *client)
+{
+    int available = 0;
+
+    /*
+     * select() and epoll return read event when data are
+     * available and when client closes its socket.
+     */
+    if (ioctl(client->stream.socket, FIONREAD, &available) < 0)
+        perror("FIONREAD ioctl() failed");
+
+    if (available > 0)
+        return TRUE;
+
+    ipc_server_close_client(ipcs, client);
+    return FALSE;
+}
+
 /* See description in ipc_server.h */
 te_bool
 ipc_is_server_ready(struct ipc_server *ipcs, const fd_set *set, int max_fd)
@@ -419,29 +484,99 @@ ipc_is_server_ready(struct ipc_server *ipcs, const fd_set *set, int max_fd)
             {
                 client->stream.is_ready =
                     FD_ISSET(client->stream.socket, set);
-                if (client->stream.is_ready)
-                {
-                    int available = 0;
+                if (client->stream.is_ready &&
+                    ipc_server_client_has_data(ipcs, client))
+                    is_ready = TRUE;
+            }
+        }
+    }
 
-                    /*
-                     * select() returns read event when data are
-                     * available and when client closes its socket.
-                     */
+    return is_ready;
+}
 
-                    if (ioctl(client->stream.socket, FIONREAD,
-                              &available) < 0)
-                        perror("FIONREAD ioctl() failed");
+/**
+ * Wait for a new connection or data in one of client connections
+ * and mark ready ones.
+ *
+ * @param ipcs      IPC server
+ * @param timeout   Timeout in milliseconds (negative to wait infinitely)
+ *
+ * @return Number of ready sockets, @c 0 on timeout or @c -1 on error
+ *         (errno is set).
+ */
+static int
+ipc_server_poll(struct ipc_server *ipcs, int timeout)
+{
+#if HAVE_SYS_EPOLL_H
+    struct epoll_event          events[IPC_SERVER_POLL_EVENTS];
+    struct ipc_server_client   *client;
+    int                         n_ready = 0;
+    int                         n;
+    int                         i;
+
+    n = epoll_wait(ipcs->epfd, events, TE_ARRAY_LEN(events), timeout);
+    if (n < 0)
+        return -1;
 
-                    if (available > 0)
-                        is_ready = TRUE;
-                    else
-                        ipc_server_close_client(client, ipcs->conn);
-                }
-            }
+    for (i = 0; i < n; i++)
+    {
+        client = events[i].data.ptr;
+        if (client == NULL)
+        {
+            ipcs->is_ready = TRUE;
+            n_ready++;
+        }
+        else if (ipc_server_client_has_data(ipcs, client))
+        {
+            client->stream.is_ready = TRUE;
+            n_ready++;
         }
     }
 
-    return is_ready;
+    return n_ready;
+#else
+    fd_set          set;
+    struct timeval  tv;
+    int             max_fd;
+    int             rc;
+
+    FD_ZERO(&set);
+    max_fd = ipc_get_server_fds(ipcs, &set);
+    if (timeout >= 0)
+    {
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+    }
+
+    rc = select(max_fd + 1, &set, NULL, NULL, timeout >= 0 ? &tv : NULL);
+    if (rc <= 0)
+        return rc;
+
+    return ipc_is_server_ready(ipcs, &set, max_fd) ? 1 : 0;
+#endif
+}
+
+/* See description in ipc_server.h */
+int
+ipc_get_server_poll_fd(const struct ipc_server *ipcs)
+{
+    if (ipcs == NULL)
+        return -1;
+#if HAVE_SYS_EPOLL_H
+    return ipcs->epfd;
+#else
+    return ipcs->conn ? -1 : ipcs->socket;
+#endif
+}
+
+/* See description in ipc_server.h */
+te_bool
+ipc_check_server_ready(struct ipc_server *ipcs)
+{
+    if (ipcs == NULL)
+        return FALSE;
+
+    return ipc_server_poll(ipcs, 0) > 0;
 }
 
 /* See description in ipc_server.h */
@@ -464,6 +599,10 @@ ipc_close_server(struct ipc_server *ipcs)
 
     if (close(ipcs->socket) != 0)
         fprintf(stderr, "close() failed\n");
+#if HAVE_SYS_EPOLL_H
+    if (ipcs->epfd >= 0)
+        close(ipcs->epfd);
+#endif
 
     if (ipcs->conn)
     {
@@ -486,7 +625,7 @@ ipc_close_server(struct ipc_server *ipcs)
     /* Free the pool */
     while ((ipcsc = LIST_FIRST(&ipcs->clients)) != NULL)
     {
-        ipc_server_close_client(ipcsc, ipcs->conn);
+        ipc_server_close_client(ipcs, ipcsc);
     }
 
     /* Free instance */
@@ -804,10 +943,8 @@ ipc_stream_receive_message(struct ipc_server *ipcs,
                            void *buf, size_t *p_buf_len,
                            struct ipc_server_client **p_ipcsc)
 {
-    fd_set                    my_set;
     struct ipc_server_client *client;
     struct ipc_server_client *next_client;
-    int                       max_fd;
     int                       rc;
 
     if ((ipcs == NULL) || (buf == NULL) || (p_ipcsc == NULL) ||
@@ -833,7 +970,7 @@ ipc_stream_receive_message(struct ipc_server *ipcs,
                 }
                 else
                 {
-                    ipc_server_close_client(client, ipcs->conn);
+                    ipc_server_close_client(ipcs, client);
                     return rc;
                 }
             }
@@ -879,7 +1016,7 @@ ipc_stream_receive_message(struct ipc_server *ipcs,
                     }
                     else
                     {
-                        ipc_server_close_client(client, ipcs->conn);
+                        ipc_server_close_client(ipcs, client);
                         continue;
                     }
                 }
@@ -918,6 +1055,19 @@ ipc_stream_receive_message(struct ipc_server *ipcs,
             }
             else
             {
+#if HAVE_SYS_EPOLL_H
+                struct epoll_event ev = { .events = EPOLLIN,
+                                          .data.ptr = client };
+
+                if (epoll_ctl(ipcs->epfd, EPOLL_CTL_ADD,
+                              client->stream.socket, &ev) != 0)
+                {
+                    perror("epoll_ctl() failed");
+                    close(client->stream.socket);
+                    free(client);
+                    continue;
+                }
+#endif
                 LIST_INSERT_HEAD(&ipcs->clients, client, links);
             }
 
@@ -932,18 +1082,12 @@ ipc_stream_receive_message(struct ipc_server *ipcs,
          *  - client tries to establish connection
          *  - client sends data via established connection
          */
-        FD_ZERO(&my_set);
-        max_fd = ipc_get_server_fds(ipcs, &my_set);
-
-        /* Waiting forever */
-        rc = select(max_fd + 1, &my_set, NULL, NULL, NULL);
-        if (rc <= 0) /* Error? */
+        rc = ipc_server_poll(ipcs, -1);
+        if (rc < 0)
         {
-            perror("select() error");
+            perror("ipc_server_poll() error");
             return TE_OS_RC(TE_IPC, errno);
         }
-
-        (void)ipc_is_server_ready(ipcs, &my_set, max_fd);
     }
     /* Unreachable */
 }
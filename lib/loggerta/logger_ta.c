@@ -20,8 +20,12 @@
 #if HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
 
 #include "te_printf.h"
+#include "te_str.h"
 #include "logger_defs.h"
 #include "logger_api.h"
 #include "logger_int.h"
@@ -77,6 +81,16 @@ struct lgr_rb log_buffer;
  */
 uint32_t log_sequence = 0;
 
+/* See the description in logger_ta_internal.h */
+#if TA_LOG_THREAD_RB
+uint32_t ta_log_rb_el = LGR_THREAD_RB_EL;
+#else
+uint32_t ta_log_rb_el = LGR_DEFAULT_RB_BYTES / LGR_RB_ELEMENT_LEN;
+#endif
+
+/* See the description in logger_ta_internal.h */
+uint64_t ta_log_dropped = 0;
+
 
 #if HAVE_PTHREAD_H
 pthread_mutex_t ta_log_mutex;
@@ -87,6 +101,289 @@ sem_t           ta_log_sem;
 static const char  *skip_flags = "#-+ 0";
 static const char  *skip_width = "*0123456789";
 
+#if TA_LOG_THREAD_RB
+
+/* See the description in logger_ta_internal.h */
+__thread lgr_thread_rb *ta_log_thread_rb = NULL;
+
+/** List of per-thread rings (protected by the log lock) */
+static lgr_thread_rb   *thread_rbs = NULL;
+/** Key to get notified about thread exit */
+static pthread_key_t    thread_rb_key;
+/** Control of @a thread_rb_key creation */
+static pthread_once_t   thread_rb_key_once = PTHREAD_ONCE_INIT;
+/** Memory allocated for per-thread rings in bytes */
+static size_t           thread_rb_bytes = 0;
+/** Limit of @a thread_rb_bytes for new rings of full threads */
+static size_t           thread_rb_max = LGR_THREAD_RB_MAX_BYTES;
+/** The log is shut down, no new rings are created */
+static te_bool          thread_rb_shutdown = FALSE;
+
+static void thread_rb_free(lgr_thread_rb *ring);
+
+/**
+ * Mark the ring of an exiting thread as orphan: it is released by
+ * the log reader when all messages are taken out or at once if
+ * the log is shut down.
+ *
+ * @param arg       Ring location
+ */
+static void
+thread_rb_orphan(void *arg)
+{
+    lgr_thread_rb *ring = arg;
+    lgr_thread_rb *expected = NULL;
+
+    /* The thread may log again in other destructors */
+    ta_log_thread_rb = NULL;
+    if (!__atomic_compare_exchange_n(&ring->newer, &expected,
+                                     LGR_THREAD_RB_ORPHAN, FALSE,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        /* The log is shut down */
+        thread_rb_free(ring);
+    }
+}
+
+/** Create the key to track thread exit. */
+static void
+thread_rb_key_create(void)
+{
+    if (pthread_key_create(&thread_rb_key, thread_rb_orphan) != 0)
+    {
+        fprintf(stderr, "%s(): pthread_key_create() failed\n",
+                __FUNCTION__);
+    }
+}
+
+/**
+ * Allocate per-thread ring of @a ta_log_rb_el elements.
+ *
+ * @return Ring location or @c NULL.
+ */
+static lgr_thread_rb *
+thread_rb_alloc(void)
+{
+    lgr_thread_rb *ring;
+
+    ring = calloc(1, sizeof(*ring));
+    if (ring == NULL)
+        return NULL;
+
+    ring->size = ta_log_rb_el;
+    ring->rb = calloc(ring->size, LGR_RB_ELEMENT_LEN);
+    if (ring->rb == NULL)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+/**
+ * Release per-thread ring.
+ *
+ * @param ring      Ring location
+ */
+static void
+thread_rb_free(lgr_thread_rb *ring)
+{
+    __atomic_sub_fetch(&thread_rb_bytes,
+                       (size_t)ring->size * LGR_RB_ELEMENT_LEN,
+                       __ATOMIC_RELAXED);
+    free(ring->rb);
+    free(ring);
+}
+
+/**
+ * Make the ring used by the current thread.
+ *
+ * @param ring      Ring location
+ */
+static void
+thread_rb_set_current(lgr_thread_rb *ring)
+{
+    (void)pthread_once(&thread_rb_key_once, thread_rb_key_create);
+    (void)pthread_setspecific(thread_rb_key, ring);
+    ta_log_thread_rb = ring;
+}
+
+/* See the description in logger_ta_internal.h */
+lgr_thread_rb *
+ta_log_thread_rb_create(void)
+{
+    ta_log_lock_key key;
+    lgr_thread_rb  *ring;
+
+    if (__atomic_load_n(&thread_rb_shutdown, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    ring = thread_rb_alloc();
+    if (ring == NULL)
+        return NULL;
+
+    /* The first ring of a thread is not limited */
+    __atomic_add_fetch(&thread_rb_bytes,
+                       (size_t)ring->size * LGR_RB_ELEMENT_LEN,
+                       __ATOMIC_RELAXED);
+
+    if (ta_log_lock(&key) != 0)
+    {
+        thread_rb_free(ring);
+        return NULL;
+    }
+    ring->next = thread_rbs;
+    thread_rbs = ring;
+    (void)ta_log_unlock(&key);
+
+    thread_rb_set_current(ring);
+
+    return ring;
+}
+
+/* See the description in logger_ta_internal.h */
+lgr_thread_rb *
+ta_log_thread_rb_full(lgr_thread_rb *ring, uint32_t nmbr)
+{
+    size_t          bytes = (size_t)ta_log_rb_el * LGR_RB_ELEMENT_LEN;
+    lgr_thread_rb  *newer = NULL;
+    lgr_thread_rb  *expected = NULL;
+
+    if (nmbr <= ta_log_rb_el)
+    {
+        if (__atomic_add_fetch(&thread_rb_bytes, bytes, __ATOMIC_RELAXED) <=
+            __atomic_load_n(&thread_rb_max, __ATOMIC_RELAXED))
+            newer = thread_rb_alloc();
+
+        if (newer == NULL)
+            __atomic_sub_fetch(&thread_rb_bytes, bytes, __ATOMIC_RELAXED);
+    }
+
+    if (newer == NULL)
+    {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1,
+                         __ATOMIC_RELEASE);
+        __atomic_add_fetch(&ta_log_dropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    /* The reader gets to the new ring when the old one is empty */
+    if (!__atomic_compare_exchange_n(&ring->newer, &expected, newer, FALSE,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        /* The log is shut down, the ring is released on thread exit */
+        thread_rb_free(newer);
+        __atomic_store_n(&ring->dropped, ring->dropped + 1,
+                         __ATOMIC_RELEASE);
+        return NULL;
+    }
+    thread_rb_set_current(newer);
+
+    return newer;
+}
+
+/**
+ * Get number of ring elements occupied by a message argument.
+ *
+ * @param length    Argument length
+ *
+ * @return Number of elements.
+ */
+static inline uint32_t
+thread_rb_arg_elements(uint32_t length)
+{
+    if (length > TE_LOG_FIELD_MAX)
+        length = TE_LOG_FIELD_MAX;
+
+    return (length + LGR_RB_ELEMENT_LEN - 1) / LGR_RB_ELEMENT_LEN;
+}
+
+/**
+ * Copy message argument to reserved ring elements.
+ *
+ * @param ring      Ring of the current thread
+ * @param position  Counter of the first element
+ * @param start     Argument location
+ * @param length    Argument length (including terminating zero
+ *                  if @p add_zero is @c TRUE)
+ * @param add_zero  Terminate copied data with zero byte
+ *
+ * @return Address of the copy.
+ */
+static uint8_t *
+thread_rb_copy(lgr_thread_rb *ring, uint32_t position,
+               const void *start, uint32_t length, te_bool add_zero)
+{
+    uint8_t    *rb_end = ring->rb + ring->size * LGR_RB_ELEMENT_LEN;
+    uint8_t    *addr = (uint8_t *)LGR_THREAD_RB_MESSAGE(ring, position);
+    uint32_t    piece;
+
+    if (length > TE_LOG_FIELD_MAX)
+        length = TE_LOG_FIELD_MAX;
+    if (add_zero)
+        length--;
+
+    piece = MIN(length, (uint32_t)(rb_end - addr));
+    memcpy(addr, start, piece);
+    memcpy(ring->rb, (const uint8_t *)start + piece, length - piece);
+
+    if (add_zero)
+    {
+        if (piece < (uint32_t)(rb_end - addr))
+            addr[length] = '\0';
+        else
+            ring->rb[length - piece] = '\0';
+    }
+
+    return addr;
+}
+
+/**
+ * Register message in the ring of the current thread.
+ *
+ * @param header    Message header
+ * @param cp_list   Arguments to be copied
+ */
+static void
+thread_rb_put(const lgr_mess_header *header, const md_list *cp_list)
+{
+    lgr_thread_rb      *ring = lgr_thread_rb_get();
+    const md_list      *item;
+    lgr_mess_header    *hdr_addr;
+    uint32_t            need = 1;
+    uint32_t            position;
+    uint32_t            pos;
+
+    if (ring == NULL)
+        return;
+
+    for (item = cp_list->next; item != cp_list; item = item->next)
+        need += thread_rb_arg_elements(item->length);
+
+    if (!lgr_thread_rb_reserve(&ring, need, &position))
+        return;
+
+    hdr_addr = LGR_THREAD_RB_MESSAGE(ring, position);
+    *hdr_addr = *header;
+    hdr_addr->elements = need;
+    hdr_addr->mark = 0;
+
+    pos = position + 1;
+    for (item = cp_list->next; item != cp_list; item = item->next)
+    {
+        hdr_addr->args[item->narg] =
+            (ta_log_arg)thread_rb_copy(ring, pos, item->addr,
+                                       item->length, item->add_zero);
+        pos += thread_rb_arg_elements(item->length);
+    }
+
+    lgr_thread_rb_commit(ring, need);
+    ta_log_stream_notify();
+}
+
+#else /* !TA_LOG_THREAD_RB */
+
 static te_errno
 ta_log_add_ptr_argument(struct lgr_rb *ring_buffer, uint32_t position,
                         const void *start, uint32_t length,
@@ -112,21 +409,42 @@ ta_log_add_ptr_argument(struct lgr_rb *ring_buffer, uint32_t position,
     return 0;
 }
 
+#endif /* !TA_LOG_THREAD_RB */
+
 extern void
 ta_log_dynamic_user_ts(te_log_ts_sec sec, te_log_ts_usec usec,
                        unsigned int level, const char *user, const char *msg)
 {
     const char *args[] = { user, msg };
+#if TA_LOG_THREAD_RB
+    md_list cp_list = {&cp_list, &cp_list, 0, NULL, 0};
+    md_list items[TE_ARRAY_LEN(args)];
+#else
     struct lgr_rb lgr_rb_old;
     lgr_mess_header *hdr_addr = NULL;
-    lgr_mess_header header;
     ta_log_lock_key key;
     uint32_t position;
-    unsigned int i;
     int res;
+#endif
+    lgr_mess_header header;
+    unsigned int i;
 
     lgr_rb_init_header(&header, level, NULL, "%s", TRUE, sec, usec);
 
+#if TA_LOG_THREAD_RB
+    for (i = 0; i < TE_ARRAY_LEN(args); i++)
+    {
+        items[i].next = (i + 1 < TE_ARRAY_LEN(args)) ? &items[i + 1] :
+                                                       &cp_list;
+        items[i].narg = i;
+        items[i].addr = (void *)args[i];
+        items[i].length = strlen(args[i]) + 1;
+        items[i].add_zero = FALSE;
+    }
+    cp_list.next = &items[0];
+
+    thread_rb_put(&header, &cp_list);
+#else
     if (ta_log_lock(&key) != 0)
         return;
 
@@ -135,6 +453,7 @@ ta_log_dynamic_user_ts(te_log_ts_sec sec, te_log_ts_usec usec,
     res = lgr_rb_allocate_head(&log_buffer, TA_LOG_FORCE_NEW, &position);
     if (res == 0)
     {
+        ta_log_dropped++;
         log_buffer = lgr_rb_old;
         (void)ta_log_unlock(&key);
         goto resume;
@@ -149,16 +468,19 @@ ta_log_dynamic_user_ts(te_log_ts_sec sec, te_log_ts_usec usec,
                                     args[i], strlen(args[i]) + 1,
                                     hdr_addr->args + i, FALSE) != 0)
         {
+            ta_log_dropped++;
             log_buffer = lgr_rb_old;
             (void)ta_log_unlock(&key);
             goto resume;
         }
     }
 
+    ta_log_stream_notify();
     (void)ta_log_unlock(&key);
 
 resume:
     ;
+#endif
 }
 
 /**
@@ -173,18 +495,20 @@ ta_log_message(const char *file, unsigned int line,
                unsigned int level, const char *entity, const char *user,
                const char *fmt, va_list ap)
 {
+#if !TA_LOG_THREAD_RB
     ta_log_lock_key     key;
     uint32_t            position;
     int                 res;
+    md_list            *tmp_list = NULL;
+    struct lgr_rb       lgr_rb_old;
+    lgr_mess_header    *hdr_addr = NULL;
+#endif
     const char         *p_str;
     md_list             cp_list = {&cp_list, &cp_list, 0, NULL, 0};
-    md_list            *tmp_list = NULL;
     uint32_t            narg = 0;
-    struct lgr_rb       lgr_rb_old;
     int                 precision;
 
     lgr_mess_header header;
-    lgr_mess_header *hdr_addr = NULL;
 
     static char *null_str = "(NULL)";
 
@@ -306,6 +630,9 @@ ta_log_message(const char *file, unsigned int line,
 
     UNUSED(precision);
 
+#if TA_LOG_THREAD_RB
+    thread_rb_put(&header, &cp_list);
+#else
     if (ta_log_lock(&key) != 0)
         return;
 
@@ -314,6 +641,7 @@ ta_log_message(const char *file, unsigned int line,
     res = lgr_rb_allocate_head(&log_buffer, TA_LOG_FORCE_NEW, &position);
     if (res == 0)
     {
+        ta_log_dropped++;
         log_buffer = lgr_rb_old;
         (void)ta_log_unlock(&key);
         goto resume;
@@ -330,6 +658,7 @@ ta_log_message(const char *file, unsigned int line,
                                     hdr_addr->args + tmp_list->narg,
                                     tmp_list->add_zero) != 0)
         {
+            ta_log_dropped++;
             log_buffer = lgr_rb_old;
             (void)ta_log_unlock(&key);
             goto resume;
@@ -337,7 +666,9 @@ ta_log_message(const char *file, unsigned int line,
 
         tmp_list = tmp_list->next;
     }
+    ta_log_stream_notify();
     (void)ta_log_unlock(&key);
+#endif
 
 resume:
     LGR_FREE_MD_LIST(cp_list);
@@ -405,62 +736,42 @@ clear_fmt(const char *fmt, uint8_t *clean_fmt)
 }
 
 /**
- * Get message from log buffer.
- * On success the processed message will be removed from log buffer.
+ * Convert message to the format of GET_LOG reply.
  *
- * @return  Length of processed message.
+ * @param header        Message header
+ * @param sequence      Message sequence number
+ * @param rb            Location of the ring buffer keeping message
+ *                      arguments
+ * @param rb_len        Length of the ring buffer in bytes
+ * @param length        Length of the output buffer
+ * @param buffer        Output buffer
+ *
+ * @return Length of the converted message or @c 0 if it does not fit
+ *         in the output buffer.
  */
 static uint32_t
-log_get_message(uint32_t length, uint8_t *buffer)
+log_serialize_message(const lgr_mess_header *header, uint32_t sequence,
+                      const uint8_t *rb, uint32_t rb_len,
+                      uint32_t length, uint8_t *buffer)
 {
     uint32_t            argn = 0;
     const char         *fs;
     uint32_t            mess_length = 0;
     uint32_t            tmp_length;
-    ta_log_lock_key     key;
-    uint8_t            *tmp_buf;
-    lgr_mess_header     header;
-    uint8_t            *ring_last = log_buffer.rb + LGR_TOTAL_RB_BYTES;
-
-    if (length < LGR_RB_ELEMENT_LEN)
-        return 0;
-
-    if (ta_log_lock(&key) != 0)
-        return 0;
-
-    if (LGR_RB_UNUSED(&log_buffer) == LGR_TOTAL_RB_EL)
-    {
-        (void)ta_log_unlock(&key);
-        return 0;
-    }
-
-    LGR_SET_MARK_FIELD(&log_buffer, log_buffer.head, 1);
-    if (ta_log_unlock(&key) != 0)
-    {
-        LGR_SET_MARK_FIELD(&log_buffer, log_buffer.head, 0);
-        return 0;
-    }
-
-    tmp_buf = buffer;
-
-    lgr_rb_get_elements(&log_buffer, LGR_RB_HEAD(&log_buffer),
-                        1, (uint8_t *)&header);
-
+    uint8_t            *tmp_buf = buffer;
+    const uint8_t      *ring_last = rb + rb_len;
 
 #define LGR_CHECK_LENGTH(_field_length) \
     do {                                                            \
         if (mess_length + (_field_length) > length)                 \
-        {                                                           \
-            LGR_SET_MARK_FIELD(&log_buffer, log_buffer.head, 0);    \
             return 0;                                               \
-        }                                                           \
         mess_length += (_field_length);                             \
     } while (0)
 
     LGR_CHECK_LENGTH(sizeof(te_log_seqno) + TE_LOG_MSG_COMMON_HDR_SZ);
 
     /* Write message sequence number FIXME */
-    *((uint32_t *)tmp_buf) = htonl(header.sequence);
+    *((uint32_t *)tmp_buf) = htonl(sequence);
     tmp_buf += sizeof(uint32_t);
 
     /* Write current log version */
@@ -471,29 +782,29 @@ log_get_message(uint32_t length, uint8_t *buffer)
     tmp_buf++;
 
     /* Write timestamp */
-    *((uint32_t *)tmp_buf) = htonl(header.sec);
+    *((uint32_t *)tmp_buf) = htonl(header->sec);
     tmp_buf += sizeof(uint32_t);
-    *((uint32_t *)tmp_buf) = htonl(header.usec);
+    *((uint32_t *)tmp_buf) = htonl(header->usec);
     tmp_buf += sizeof(uint32_t);
 
     /* Write log level */
     *((te_log_level *)tmp_buf) =
 #if (SIZEOF_TE_LOG_LEVEL == 1)
-        header.level;
+        header->level;
 #elif (SIZEOF_TE_LOG_LEVEL == 2)
-        htons(header.level);
+        htons(header->level);
 #elif (SIZEOF_TE_LOG_LEVEL == 4)
-        htonl(header.level);
+        htonl(header->level);
 #else
 #error Such SIZEOF_TE_LOG_LEVEL is not supported
 #endif
     tmp_buf += sizeof(te_log_level);
 
     /* Write user name and corresponding (NFL) next field length */
-    if (header.user_in_first_arg)
-        fs = (char *)LGR_GET_ARG(header, argn++);
+    if (header->user_in_first_arg)
+        fs = (char *)LGR_GET_ARG(*header, argn++);
     else
-        fs = header.user;
+        fs = header->user;
     tmp_length = strlen(fs);
     LGR_CHECK_LENGTH(sizeof(te_log_nfl) + tmp_length);
     *((te_log_nfl *)tmp_buf) = log_nfl_hton(tmp_length);
@@ -502,7 +813,7 @@ log_get_message(uint32_t length, uint8_t *buffer)
     tmp_buf += tmp_length;
 
     /* Write format string and corresponding NFL */
-    fs = header.fmt;
+    fs = header->fmt;
     tmp_length = strlen(fs);
     LGR_CHECK_LENGTH(sizeof(te_log_nfl) + tmp_length);
     tmp_buf += sizeof(te_log_nfl);
@@ -545,7 +856,7 @@ log_get_message(uint32_t length, uint8_t *buffer)
                 LGR_CHECK_LENGTH(sizeof(te_log_nfl) + sizeof(uint32_t));
                 *((te_log_nfl *)tmp_buf) = log_nfl_hton(sizeof(uint32_t));
                 tmp_buf += sizeof(te_log_nfl);
-                val = LGR_GET_ARG(header, argn++);
+                val = LGR_GET_ARG(*header, argn++);
                 LGR_32_TO_NET(val, tmp_buf);
                 tmp_buf += sizeof(uint32_t);
                 break;
@@ -560,7 +871,7 @@ log_get_message(uint32_t length, uint8_t *buffer)
                 LGR_CHECK_LENGTH(sizeof(te_log_nfl) + sizeof(void *));
                 *((te_log_nfl *)tmp_buf) = log_nfl_hton(sizeof(void *));
                 tmp_buf += sizeof(te_log_nfl);
-                val = (void *)LGR_GET_ARG(header, argn++);
+                val = (void *)LGR_GET_ARG(*header, argn++);
 
 #if (SIZEOF_VOID_P == 4)
                 tmp = (uint32_t)val;
@@ -588,14 +899,14 @@ log_get_message(uint32_t length, uint8_t *buffer)
                 LGR_CHECK_LENGTH(sizeof(te_log_nfl) + sizeof(char));
                 *((te_log_nfl *)tmp_buf) = log_nfl_hton(sizeof(char));
                 tmp_buf += sizeof(te_log_nfl);
-                *tmp_buf = (char)LGR_GET_ARG(header, argn++);
+                *tmp_buf = (char)LGR_GET_ARG(*header, argn++);
                 tmp_buf++;
                 break;
 
             case 's':
             {
                 te_log_nfl *arglen_location;
-                char       *arg_str = (char *)LGR_GET_ARG(header, argn++);
+                char       *arg_str = (char *)LGR_GET_ARG(*header, argn++);
 
                 LGR_CHECK_LENGTH(sizeof(te_log_nfl));
                 arglen_location = (te_log_nfl *)tmp_buf;
@@ -611,8 +922,8 @@ log_get_message(uint32_t length, uint8_t *buffer)
                     *tmp_buf = *arg_str;
                     tmp_buf++; arg_str++; tmp_length++;
 
-                    if ((uint8_t *)arg_str == ring_last)
-                        arg_str = (char *)log_buffer.rb;
+                    if ((const uint8_t *)arg_str == ring_last)
+                        arg_str = (char *)rb;
                 } while (*arg_str != '\0');
 
                 *arglen_location = log_nfl_hton(tmp_length);
@@ -624,8 +935,8 @@ log_get_message(uint32_t length, uint8_t *buffer)
                 {
                     uint8_t *mem_addr;
 
-                    mem_addr = (uint8_t *)LGR_GET_ARG(header, argn++);
-                    tmp_length = LGR_GET_ARG(header, argn++);
+                    mem_addr = (uint8_t *)LGR_GET_ARG(*header, argn++);
+                    tmp_length = LGR_GET_ARG(*header, argn++);
 
                     LGR_CHECK_LENGTH(sizeof(te_log_nfl) + tmp_length);
 
@@ -643,7 +954,7 @@ log_get_message(uint32_t length, uint8_t *buffer)
                         piece2 = tmp_length - piece1;
                         memcpy(tmp_buf, mem_addr, piece1);
                         tmp_buf += piece1;
-                        memcpy(tmp_buf, log_buffer.rb, piece2);
+                        memcpy(tmp_buf, rb, piece2);
                         tmp_buf += piece2;
                     }
                     else
@@ -664,6 +975,224 @@ log_get_message(uint32_t length, uint8_t *buffer)
 
 #undef LGR_CHECK_LENGTH
 
+    return mess_length;
+}
+
+#if TA_LOG_THREAD_RB
+
+/**
+ * Account messages dropped by the owner of the ring in sequence
+ * numbers. It must be called with the log lock held.
+ *
+ * @param ring      Per-thread ring
+ */
+static void
+thread_rb_account_dropped(lgr_thread_rb *ring)
+{
+    uint32_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_ACQUIRE);
+
+    log_sequence += dropped - ring->dropped_seen;
+    ring->dropped_seen = dropped;
+}
+
+/**
+ * Get the ring used by the owner thread after the given one.
+ *
+ * @param ring      Per-thread ring
+ *
+ * @return Newer ring or @c NULL if the ring is the last one.
+ */
+static inline lgr_thread_rb *
+thread_rb_newer(lgr_thread_rb *ring)
+{
+    lgr_thread_rb *newer = __atomic_load_n(&ring->newer, __ATOMIC_ACQUIRE);
+
+    return newer == LGR_THREAD_RB_ORPHAN ||
+           newer == LGR_THREAD_RB_DETACHED ? NULL : newer;
+}
+
+/**
+ * Check whether there are no messages in the ring.
+ *
+ * @param ring      Per-thread ring
+ *
+ * @return @c TRUE if the ring is empty.
+ */
+static inline te_bool
+thread_rb_empty(lgr_thread_rb *ring)
+{
+    return __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->head;
+}
+
+/**
+ * Switch to newer rings of the thread while the current one is empty.
+ * It must be called with the log lock held.
+ *
+ * @param slot      Location of the ring in the list of rings
+ *
+ * @return The ring in the list.
+ */
+static lgr_thread_rb *
+thread_rb_advance(lgr_thread_rb **slot)
+{
+    lgr_thread_rb *ring = *slot;
+    lgr_thread_rb *newer;
+
+    /* The owner never touches the ring after it sets the link */
+    while ((newer = thread_rb_newer(ring)) != NULL && thread_rb_empty(ring))
+    {
+        thread_rb_account_dropped(ring);
+        newer->next = ring->next;
+        *slot = newer;
+        thread_rb_free(ring);
+        ring = newer;
+    }
+
+    return ring;
+}
+
+/**
+ * Release rings of exited threads which have no messages.
+ * It must be called with the log lock held.
+ */
+static void
+thread_rb_collect(void)
+{
+    lgr_thread_rb **prev = &thread_rbs;
+    lgr_thread_rb  *ring;
+
+    while (*prev != NULL)
+    {
+        ring = thread_rb_advance(prev);
+        if (__atomic_load_n(&ring->newer, __ATOMIC_ACQUIRE) ==
+                LGR_THREAD_RB_ORPHAN &&
+            __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->head)
+        {
+            thread_rb_account_dropped(ring);
+            *prev = ring->next;
+            thread_rb_free(ring);
+        }
+        else
+        {
+            prev = &ring->next;
+        }
+    }
+}
+
+/**
+ * Find the ring with the oldest message at its head.
+ * It must be called with the log lock held.
+ *
+ * @return Ring location or @c NULL if there are no messages.
+ */
+static lgr_thread_rb *
+thread_rb_oldest(void)
+{
+    lgr_thread_rb      *oldest = NULL;
+    lgr_mess_header    *oldest_msg = NULL;
+    lgr_mess_header    *msg;
+    lgr_thread_rb     **slot;
+    lgr_thread_rb      *ring;
+
+    for (slot = &thread_rbs; *slot != NULL; slot = &ring->next)
+    {
+        ring = thread_rb_advance(slot);
+        thread_rb_account_dropped(ring);
+
+        if (thread_rb_empty(ring))
+            continue;
+
+        msg = LGR_THREAD_RB_MESSAGE(ring, ring->head);
+        if (oldest == NULL || msg->sec < oldest_msg->sec ||
+            (msg->sec == oldest_msg->sec && msg->usec < oldest_msg->usec))
+        {
+            oldest = ring;
+            oldest_msg = msg;
+        }
+    }
+
+    return oldest;
+}
+
+/**
+ * Get the oldest message from per-thread rings. Messages of different
+ * threads are merged in timestamp order, sequence numbers are assigned
+ * here. On success the processed message is removed from its ring.
+ * It must be called with the log lock held.
+ *
+ * @return  Length of processed message.
+ */
+static uint32_t
+log_get_message(uint32_t length, uint8_t *buffer)
+{
+    lgr_thread_rb  *ring = thread_rb_oldest();
+    lgr_mess_header header;
+    uint32_t        mess_length;
+
+    if (ring == NULL)
+        return 0;
+
+    header = *LGR_THREAD_RB_MESSAGE(ring, ring->head);
+    mess_length = log_serialize_message(&header, log_sequence + 1,
+                                        ring->rb,
+                                        ring->size * LGR_RB_ELEMENT_LEN,
+                                        length, buffer);
+    if (mess_length == 0)
+        return 0;
+
+    log_sequence++;
+    __atomic_store_n(&ring->head, ring->head + header.elements,
+                     __ATOMIC_RELEASE);
+
+    return mess_length;
+}
+
+#else /* !TA_LOG_THREAD_RB */
+
+/**
+ * Get message from log buffer.
+ * On success the processed message will be removed from log buffer.
+ *
+ * @return  Length of processed message.
+ */
+static uint32_t
+log_get_message(uint32_t length, uint8_t *buffer)
+{
+    uint32_t            mess_length;
+    ta_log_lock_key     key;
+    lgr_mess_header     header;
+
+    if (length < LGR_RB_ELEMENT_LEN)
+        return 0;
+
+    if (ta_log_lock(&key) != 0)
+        return 0;
+
+    if (LGR_RB_UNUSED(&log_buffer) == LGR_TOTAL_RB_EL)
+    {
+        (void)ta_log_unlock(&key);
+        return 0;
+    }
+
+    LGR_SET_MARK_FIELD(&log_buffer, log_buffer.head, 1);
+    if (ta_log_unlock(&key) != 0)
+    {
+        LGR_SET_MARK_FIELD(&log_buffer, log_buffer.head, 0);
+        return 0;
+    }
+
+    lgr_rb_get_elements(&log_buffer, LGR_RB_HEAD(&log_buffer),
+                        1, (uint8_t *)&header);
+
+    mess_length = log_serialize_message(&header, header.sequence,
+                                        log_buffer.rb, LGR_TOTAL_RB_BYTES,
+                                        length, buffer);
+    if (mess_length == 0)
+    {
+        LGR_SET_MARK_FIELD(&log_buffer, log_buffer.head, 0);
+        return 0;
+    }
+
     if (ta_log_lock(&key) != 0)
     {
         /* TODO: Is it safe to do it without lock? */
@@ -677,15 +1206,80 @@ log_get_message(uint32_t length, uint8_t *buffer)
     return mess_length;
 }
 
+#endif /* !TA_LOG_THREAD_RB */
+
 /**
  * Function to be called in fork-child.
  */
 static void
 log_atfork_child(void)
 {
+    ta_log_stream_atfork_child();
     te_log_init(NULL, logfork_log_message);
 }
 
+/**
+ * Get size of the local log buffer from the environment.
+ *
+ * @param name      Environment variable name
+ * @param size      Location for the size (left untouched if the
+ *                  variable is not set)
+ *
+ * @return Status code.
+ */
+static te_errno
+log_buffer_size_from_env(const char *name, size_t *size)
+{
+    const char *value = getenv(name);
+    te_errno    rc;
+
+    if (value == NULL || *value == '\0')
+        return 0;
+
+    rc = te_strtou_size(value, 0, size, sizeof(*size));
+    if (rc != 0)
+    {
+        fprintf(stderr, "%s(): invalid %s value '%s'\n",
+                __FUNCTION__, name, value);
+    }
+
+    return rc;
+}
+
+/**
+ * Choose the size of the local log buffer.
+ *
+ * @return Status code.
+ */
+static te_errno
+log_buffer_configure(void)
+{
+    size_t      size = (size_t)ta_log_rb_el * LGR_RB_ELEMENT_LEN;
+    te_errno    rc;
+
+    rc = log_buffer_size_from_env(TA_LOG_BUFFER_SIZE_ENV, &size);
+    if (rc != 0)
+        return rc;
+
+    size = MAX(size, LGR_MIN_RB_BYTES);
+    size = MIN(size, (size_t)UINT32_MAX);
+
+#if TA_LOG_THREAD_RB
+    rc = log_buffer_size_from_env(TA_LOG_BUFFER_MAX_ENV, &thread_rb_max);
+    if (rc != 0)
+        return rc;
+
+    /* Per-thread rings are indexed by masking of the element counter */
+    for (ta_log_rb_el = 1;
+         (size_t)ta_log_rb_el * 2 * LGR_RB_ELEMENT_LEN <= size;
+         ta_log_rb_el *= 2);
+#else
+    ta_log_rb_el = size / LGR_RB_ELEMENT_LEN;
+#endif
+
+    return 0;
+}
+
 /* See the description in logger_ta.h */
 te_errno
 ta_log_init(const char *lgr_entity)
@@ -698,8 +1292,13 @@ ta_log_init(const char *lgr_entity)
     if (ta_log_lock_init() != 0)
         return -1;
 
+    if (log_buffer_configure() != 0)
+        return -1;
+
+#if !TA_LOG_THREAD_RB
     if (lgr_rb_init(&log_buffer) != 0)
         return -1;
+#endif
 
     te_log_init(lgr_entity, ta_log_message);
 
@@ -719,35 +1318,92 @@ ta_log_init(const char *lgr_entity)
 te_errno
 ta_log_shutdown(void)
 {
+#if TA_LOG_THREAD_RB
+    lgr_thread_rb *ring;
+    lgr_thread_rb *newer;
+#endif
+
+    ta_log_stream_stop();
+
+#if TA_LOG_THREAD_RB
+    __atomic_store_n(&thread_rb_shutdown, TRUE, __ATOMIC_RELEASE);
+
+    /* Rings of the calling thread are not used any more */
+    if (ta_log_thread_rb != NULL)
+    {
+        (void)pthread_setspecific(thread_rb_key, NULL);
+        thread_rb_orphan(ta_log_thread_rb);
+    }
+#endif
+
     (void)ta_log_lock_destroy();
 
+#if TA_LOG_THREAD_RB
+    /*
+     * Other threads may still register messages in their last rings:
+     * these rings are detached and released when the threads exit.
+     */
+    while (thread_rbs != NULL)
+    {
+        ring = thread_rbs;
+        thread_rbs = ring->next;
+        while (ring != NULL)
+        {
+            newer = __atomic_load_n(&ring->newer, __ATOMIC_ACQUIRE);
+            if (newer == NULL &&
+                __atomic_compare_exchange_n(&ring->newer, &newer,
+                                            LGR_THREAD_RB_DETACHED, FALSE,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE))
+                break;
+
+            thread_rb_free(ring);
+            ring = (newer == LGR_THREAD_RB_ORPHAN ? NULL : newer);
+        }
+    }
+
+    return 0;
+#else
     return lgr_rb_destroy(&log_buffer);
+#endif
 }
 
 
-/**
- * Request the log messages accumulated in the Test Agent local log
- * buffer. Passed messages are deleted from local log.
- *
- * @param  buf_length   Length of the transfer buffer.
- * @param  transfer_buf Pointer to the transfer buffer.
- *
- * @retval  Length of the filled part of the transfer buffer in bytes
- */
+/** Serializes retrieval of messages by RCF and by the streaming thread */
+static pthread_mutex_t log_get_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* See the description in logger_ta_internal.h */
 uint32_t
-ta_log_get(uint32_t buf_length, uint8_t *transfer_buf)
+ta_log_get_messages(uint32_t buf_length, uint8_t *transfer_buf)
 {
     uint32_t log_length = 0;
     uint32_t mess_length, rest_length;
     uint8_t *tmp_buf = transfer_buf;
+#if TA_LOG_THREAD_RB
+    ta_log_lock_key key;
+#endif
 
 
     if ((buf_length <= 0) || (transfer_buf == NULL))
-        goto ret;
+        return 0;
+
+    pthread_mutex_lock(&log_get_mutex);
+
+#if TA_LOG_THREAD_RB
+    /* Producers take the lock only to add a ring to the list */
+    if (ta_log_lock(&key) != 0)
+    {
+        pthread_mutex_unlock(&log_get_mutex);
+        return 0;
+    }
+    thread_rb_collect();
+#endif
 
     do {
+#if !TA_LOG_THREAD_RB
         if (LGR_RB_UNUSED(&log_buffer) == LGR_TOTAL_RB_EL)
             goto ret;
+#endif
 
         rest_length = buf_length - log_length;
         if (rest_length == 0)
@@ -763,5 +1419,228 @@ ta_log_get(uint32_t buf_length, uint8_t *transfer_buf)
     } while (1);
 
 ret:
+#if TA_LOG_THREAD_RB
+    (void)ta_log_unlock(&key);
+#endif
+    pthread_mutex_unlock(&log_get_mutex);
     return log_length;
 }
+
+#if TA_LOG_THREAD_RB
+
+/* See the description in logger_ta_internal.h */
+te_bool
+ta_log_empty(void)
+{
+    ta_log_lock_key key;
+    lgr_thread_rb  *ring;
+    lgr_thread_rb  *seg;
+    te_bool         empty = TRUE;
+
+    if (ta_log_lock(&key) != 0)
+        return TRUE;
+
+    for (ring = thread_rbs; ring != NULL && empty; ring = ring->next)
+    {
+        for (seg = ring; seg != NULL && empty; seg = thread_rb_newer(seg))
+            empty = thread_rb_empty(seg);
+    }
+
+    (void)ta_log_unlock(&key);
+
+    return empty;
+}
+
+/* See the description in logger_ta_internal.h */
+void
+ta_log_flush_mark(void)
+{
+    ta_log_lock_key key;
+    lgr_thread_rb  *ring;
+    lgr_thread_rb  *seg;
+
+    if (ta_log_lock(&key) != 0)
+        return;
+
+    for (ring = thread_rbs; ring != NULL; ring = ring->next)
+    {
+        for (seg = ring; seg != NULL; seg = thread_rb_newer(seg))
+            seg->flush_tail = __atomic_load_n(&seg->tail, __ATOMIC_ACQUIRE);
+    }
+
+    (void)ta_log_unlock(&key);
+}
+
+/* See the description in logger_ta_internal.h */
+te_bool
+ta_log_flush_done(void)
+{
+    ta_log_lock_key key;
+    lgr_thread_rb  *ring;
+    lgr_thread_rb  *seg;
+    te_bool         done = TRUE;
+
+    if (ta_log_lock(&key) != 0)
+        return TRUE;
+
+    /* Rings created after the mark have zero flush_tail */
+    for (ring = thread_rbs; ring != NULL && done; ring = ring->next)
+    {
+        for (seg = ring; seg != NULL && done; seg = thread_rb_newer(seg))
+            done = (int32_t)(seg->head - seg->flush_tail) >= 0;
+    }
+
+    (void)ta_log_unlock(&key);
+
+    return done;
+}
+
+/* See the description in logger_ta_internal.h */
+void
+ta_log_drop_oldest(void)
+{
+    ta_log_lock_key key;
+    lgr_thread_rb  *ring;
+
+    if (ta_log_lock(&key) != 0)
+        return;
+
+    ring = thread_rb_oldest();
+    if (ring != NULL)
+    {
+        /* The sequence number is skipped to report the loss */
+        log_sequence++;
+        __atomic_add_fetch(&ta_log_dropped, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&ring->head,
+                         ring->head +
+                         LGR_THREAD_RB_MESSAGE(ring, ring->head)->elements,
+                         __ATOMIC_RELEASE);
+    }
+
+    (void)ta_log_unlock(&key);
+}
+
+#else /* !TA_LOG_THREAD_RB */
+
+/** Sequence number of the last message to be flushed */
+static uint32_t log_flush_seq;
+
+/* See the description in logger_ta_internal.h */
+te_bool
+ta_log_empty(void)
+{
+    ta_log_lock_key key;
+    te_bool         empty;
+
+    if (ta_log_lock(&key) != 0)
+        return TRUE;
+
+    empty = LGR_RB_UNUSED(&log_buffer) == LGR_TOTAL_RB_EL;
+
+    (void)ta_log_unlock(&key);
+
+    return empty;
+}
+
+/* See the description in logger_ta_internal.h */
+void
+ta_log_flush_mark(void)
+{
+    ta_log_lock_key key;
+
+    if (ta_log_lock(&key) != 0)
+        return;
+
+    log_flush_seq = log_sequence;
+
+    (void)ta_log_unlock(&key);
+}
+
+/* See the description in logger_ta_internal.h */
+te_bool
+ta_log_flush_done(void)
+{
+    ta_log_lock_key key;
+    te_bool         done;
+
+    if (ta_log_lock(&key) != 0)
+        return TRUE;
+
+    done = LGR_RB_UNUSED(&log_buffer) == LGR_TOTAL_RB_EL ||
+           (int32_t)(LGR_GET_SEQUENCE_FIELD(&log_buffer,
+                                            LGR_RB_HEAD(&log_buffer)) -
+                     log_flush_seq) > 0;
+
+    (void)ta_log_unlock(&key);
+
+    return done;
+}
+
+/* See the description in logger_ta_internal.h */
+void
+ta_log_drop_oldest(void)
+{
+    ta_log_lock_key key;
+
+    if (ta_log_lock(&key) != 0)
+        return;
+
+    if (LGR_RB_UNUSED(&log_buffer) != LGR_TOTAL_RB_EL &&
+        LGR_GET_MARK_FIELD(&log_buffer, LGR_RB_HEAD(&log_buffer)) == 0)
+    {
+        lgr_rb_remove_oldest(&log_buffer);
+        ta_log_dropped++;
+    }
+
+    (void)ta_log_unlock(&key);
+}
+
+#endif /* !TA_LOG_THREAD_RB */
+
+/**
+ * Request the log messages accumulated in the Test Agent local log
+ * buffer. Passed messages are deleted from local log.
+ *
+ * Nothing is returned while the messages are pushed to Logger by
+ * the streaming thread.
+ *
+ * @param  buf_length   Length of the transfer buffer.
+ * @param  transfer_buf Pointer to the transfer buffer.
+ *
+ * @retval  Length of the filled part of the transfer buffer in bytes
+ */
+uint32_t
+ta_log_get(uint32_t buf_length, uint8_t *transfer_buf)
+{
+    if (ta_log_stream_active())
+        return 0;
+
+    return ta_log_get_messages(buf_length, transfer_buf);
+}
+
+/* See the description in logger_ta.h */
+void
+ta_log_buffer_get_stats(ta_log_buffer_stats *stats)
+{
+#if TA_LOG_THREAD_RB
+    stats->size = __atomic_load_n(&thread_rb_bytes, __ATOMIC_RELAXED);
+    stats->max = __atomic_load_n(&thread_rb_max, __ATOMIC_RELAXED);
+#else
+    stats->size = LGR_TOTAL_RB_BYTES;
+    stats->max = LGR_TOTAL_RB_BYTES;
+#endif
+    stats->dropped = __atomic_load_n(&ta_log_dropped, __ATOMIC_RELAXED);
+}
+
+/* See the description in logger_ta.h */
+te_errno
+ta_log_buffer_set_max(size_t max)
+{
+#if TA_LOG_THREAD_RB
+    __atomic_store_n(&thread_rb_max, max, __ATOMIC_RELAXED);
+    return 0;
+#else
+    UNUSED(max);
+    return TE_RC(TE_TA, TE_EOPNOTSUPP);
+#endif
+}
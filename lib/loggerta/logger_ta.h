@@ -24,6 +24,10 @@
 #ifndef __TE_LOGGER_TA_H__
 #define __TE_LOGGER_TA_H__
 
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
 #include "te_stdint.h"
 #include "te_errno.h"
 
@@ -32,6 +36,28 @@
 extern "C" {
 #endif
 
+/**
+ * Environment variable with the size of the local log buffer in bytes.
+ * If per-thread rings are used, it is the size of a ring allocated for
+ * each thread.
+ */
+#define TA_LOG_BUFFER_SIZE_ENV  "TE_TA_LOG_BUFFER_SIZE"
+
+/**
+ * Environment variable with the limit of memory in bytes which may be
+ * used by per-thread rings. A thread which fills its ring gets one
+ * more ring of the same size if the limit is not reached.
+ */
+#define TA_LOG_BUFFER_MAX_ENV   "TE_TA_LOG_BUFFER_MAX"
+
+/** Local log buffer statistics */
+typedef struct ta_log_buffer_stats {
+    size_t      size;       /**< Memory allocated for messages in bytes */
+    size_t      max;        /**< Limit of @a size */
+    uint64_t    dropped;    /**< Number of messages dropped because
+                                 the buffer was full */
+} ta_log_buffer_stats;
+
 /** Logging backend for processed forked from Test Agents */
 extern te_log_message_f logfork_log_message;
 
@@ -83,6 +109,53 @@ extern void ta_log_dynamic_user_ts(te_log_ts_sec sec, te_log_ts_usec usec,
  */
 extern uint32_t ta_log_get(uint32_t buf_length, uint8_t *transfer_buf);
 
+/**
+ * Get local log buffer statistics.
+ *
+ * @param stats     Location for statistics
+ */
+extern void ta_log_buffer_get_stats(ta_log_buffer_stats *stats);
+
+/**
+ * Change the limit of memory used by the local log buffer. It affects
+ * only growth of the buffer: memory which is already allocated is
+ * released when messages are taken out.
+ *
+ * @param max       New limit in bytes
+ *
+ * @return Status code (see te_errno.h)
+ * @retval TE_EOPNOTSUPP    The buffer has fixed size.
+ */
+extern te_errno ta_log_buffer_set_max(size_t max);
+
+/**
+ * Start pushing log messages to Logger over a dedicated connection
+ * (see te_log_stream.h). The connection is established by a separate
+ * thread, the function does not block. If the connection cannot be
+ * established or is broken, the messages are kept in the local log
+ * buffer until they are requested by ta_log_get().
+ *
+ * If streaming is already started, the old connection is closed.
+ * If the agent failed to connect to Logger on the same host during
+ * the last minute, the error is returned at once, so Logger may fall
+ * back to polling (e.g. the agent is reachable via SSH port forwarding
+ * only).
+ *
+ * @param addr      Address Logger listens on
+ * @param addrlen   Length of @p addr
+ * @param cookie    Cookie to identify the connection to Logger
+ *
+ * @return Status code (see te_errno.h)
+ */
+extern te_errno ta_log_stream_start(const struct sockaddr *addr,
+                                    socklen_t addrlen, uint32_t cookie);
+
+/**
+ * Stop pushing log messages to Logger. Messages which can be sent
+ * without waiting are pushed before the connection is closed.
+ */
+extern void ta_log_stream_stop(void);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -183,13 +183,25 @@ ta_log_message_fast(unsigned int level, const char *user, const char *fmt,
                     int argl12, ta_log_arg arg12,
                     int argl13)
 {
-    ta_log_lock_key     key;
     uint32_t            position;
+#if TA_LOG_THREAD_RB
+    lgr_thread_rb      *ring = lgr_thread_rb_get();
+#else
+    ta_log_lock_key     key;
     int                 res;
+    struct lgr_rb       lgr_rb_old;
+#endif
 
     struct lgr_mess_header *msg;
-    struct lgr_rb lgr_rb_old;
 
+#if TA_LOG_THREAD_RB
+    if (ring == NULL || !lgr_thread_rb_reserve(&ring, 1, &position))
+        return;
+
+    msg = LGR_THREAD_RB_MESSAGE(ring, position);
+    msg->elements = 1;
+    msg->mark = 0;
+#else
     if (ta_log_lock(&key) != 0)
         return;
 
@@ -198,6 +210,7 @@ ta_log_message_fast(unsigned int level, const char *user, const char *fmt,
     res = lgr_rb_allocate_head(&log_buffer, TA_LOG_FORCE_NEW, &position);
     if (res == 0)
     {
+        ta_log_dropped++;
         log_buffer = lgr_rb_old;
         (void)ta_log_unlock(&key);
         return;
@@ -205,6 +218,7 @@ ta_log_message_fast(unsigned int level, const char *user, const char *fmt,
 
     msg = (struct lgr_mess_header *)LGR_GET_MESSAGE_ARRAY(&log_buffer,
                                                           position);
+#endif
 
     ta_log_timestamp(&msg->sec, &msg->usec);
     msg->level  = level;
@@ -264,7 +278,13 @@ ta_log_message_fast(unsigned int level, const char *user, const char *fmt,
         }
     }
 
+#if TA_LOG_THREAD_RB
+    lgr_thread_rb_commit(ring, 1);
+    ta_log_stream_notify();
+#else
+    ta_log_stream_notify();
     (void)ta_log_unlock(&key);
+#endif
 }
 
 #ifdef __cplusplus
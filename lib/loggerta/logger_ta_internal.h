@@ -26,6 +26,9 @@
 #if HAVE_ASSERT_H
 #include <assert.h>
 #endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include "te_defs.h"
 #include "te_stdint.h"
@@ -55,6 +58,20 @@ extern "C" {
 #define TA_LOG_FORCE_NEW    0
 #endif
 
+#ifndef TA_LOG_THREAD_RB
+/*
+ * Where messages are registered:
+ * 0 - in the single ring buffer protected by the log lock,
+ * !0 - in per-thread single-producer rings without taking any lock.
+ * Per-thread rings require thread-local storage and atomic builtins.
+ */
+#if HAVE_PTHREAD_H && defined(__GNUC__)
+#define TA_LOG_THREAD_RB    1
+#else
+#define TA_LOG_THREAD_RB    0
+#endif
+#endif
+
 
 /*
  * Following macros provide the means for ring buffer processing.
@@ -73,10 +90,15 @@ extern "C" {
 #define LGR_MAX_BIG_MESSAGES    4000
 #endif
 
-/* Total of the ring buffer elements */
-#define LGR_TOTAL_RB_EL \
-    (uint32_t)((LGR_RB_BIG_MESSAGE_LEN * \
-                LGR_MAX_BIG_MESSAGES) / LGR_RB_ELEMENT_LEN)
+/* Default size of the ring buffer in bytes */
+#define LGR_DEFAULT_RB_BYTES \
+    (uint32_t)(LGR_RB_BIG_MESSAGE_LEN * LGR_MAX_BIG_MESSAGES)
+
+/* Minimum size of the ring buffer in bytes */
+#define LGR_MIN_RB_BYTES    (uint32_t)(4 * LGR_RB_BIG_MESSAGE_LEN)
+
+/* Total of the ring buffer elements (it is chosen at start-up) */
+#define LGR_TOTAL_RB_EL     ta_log_rb_el
 
 /* Total of the ring buffer bytes */
 #define LGR_TOTAL_RB_BYTES (uint32_t)(LGR_TOTAL_RB_EL * LGR_RB_ELEMENT_LEN)
@@ -197,6 +219,230 @@ struct lgr_rb {
 extern struct lgr_rb log_buffer;
 extern uint32_t      log_sequence;
 
+/** Number of elements in the ring buffer (or in a per-thread ring) */
+extern uint32_t      ta_log_rb_el;
+/** Number of messages dropped since there was no space for them */
+extern uint64_t      ta_log_dropped;
+
+#if TA_LOG_THREAD_RB
+
+/** Default number of elements in a per-thread ring (power of 2) */
+#define LGR_THREAD_RB_EL    (1U << 14)
+
+/**
+ * Default limit of memory used by all per-thread rings in bytes:
+ * a thread gets one more ring when its ring is full and the limit
+ * is not reached yet.
+ */
+#define LGR_THREAD_RB_MAX_BYTES \
+    ((size_t)LGR_DEFAULT_RB_BYTES * 4)
+
+/**
+ * Ring buffer of a single thread. Elements have the same layout as
+ * in the main ring buffer, but only the owner thread registers
+ * messages in it and only the log reader takes them out, so both
+ * sides work without locks. @a head and @a tail are free-running
+ * element counters.
+ *
+ * When the ring is full, the owner thread may continue in a new
+ * ring linked by @a newer. The reader switches to it as soon as
+ * the old ring is empty.
+ *
+ * @a newer of the last ring of a thread is also used to agree who
+ * releases the ring: it is set to @c LGR_THREAD_RB_ORPHAN when the
+ * owner thread exits and to @c LGR_THREAD_RB_DETACHED when the log
+ * is shut down. The side which finds the other mark releases the ring.
+ */
+typedef struct lgr_thread_rb {
+    struct lgr_thread_rb *next; /**< Next ring in the list of rings
+                                     (protected by the log lock) */
+    struct lgr_thread_rb *newer; /**< Ring used by the owner thread
+                                      after this one is full or one
+                                      of the last ring marks */
+    uint8_t    *rb;             /**< Ring buffer location */
+    uint32_t    size;           /**< Number of elements */
+    uint32_t    tail;           /**< Elements ever registered (written
+                                     by the owner thread only) */
+    uint32_t    head;           /**< Elements ever taken out (written
+                                     by the log reader only) */
+    uint32_t    dropped;        /**< Messages dropped since the ring
+                                     was full (written by the owner) */
+    uint32_t    dropped_seen;   /**< Dropped messages accounted in
+                                     sequence numbers by the reader */
+    uint32_t    flush_tail;     /**< Value of @a tail when flush was
+                                     requested */
+} lgr_thread_rb;
+
+/** Mark of the last ring of an exited thread */
+#define LGR_THREAD_RB_ORPHAN    ((struct lgr_thread_rb *)1)
+/** Mark of the last ring of a thread which is not read any more */
+#define LGR_THREAD_RB_DETACHED  ((struct lgr_thread_rb *)2)
+
+/** Ring of the current thread or @c NULL if it is not created yet */
+extern __thread lgr_thread_rb *ta_log_thread_rb;
+
+/**
+ * Create the ring of the current thread.
+ *
+ * @return Ring location or @c NULL on memory allocation failure.
+ */
+extern lgr_thread_rb *ta_log_thread_rb_create(void);
+
+/**
+ * Handle lack of space in the ring of the current thread: continue in
+ * a new ring if the memory limit allows or account the dropped message.
+ *
+ * @param ring      Ring of the current thread
+ * @param nmbr      Number of elements required for the message
+ *
+ * @return New ring or @c NULL if the message is dropped.
+ */
+extern lgr_thread_rb *ta_log_thread_rb_full(lgr_thread_rb *ring,
+                                            uint32_t nmbr);
+
+/** Get ring element address */
+#define LGR_THREAD_RB_MESSAGE(_ring, _pos) \
+    ((struct lgr_mess_header *)((_ring)->rb) + \
+     ((_pos) & ((_ring)->size - 1)))
+
+/**
+ * Get the ring of the current thread creating it on demand.
+ *
+ * @return Ring location or @c NULL.
+ */
+static inline lgr_thread_rb *
+lgr_thread_rb_get(void)
+{
+    lgr_thread_rb *ring = ta_log_thread_rb;
+
+    if (ring == NULL)
+        ring = ta_log_thread_rb_create();
+
+    return ring;
+}
+
+/**
+ * Reserve ring elements for a message. Nothing is visible to the
+ * log reader until lgr_thread_rb_commit() is called.
+ *
+ * @param ring      Location of the ring of the current thread
+ *                  (updated if the thread continues in a new ring)
+ * @param nmbr      Number of elements
+ * @param position  Location for the first element counter
+ *
+ * @return @c TRUE on success, @c FALSE if the message is dropped.
+ */
+static inline te_bool
+lgr_thread_rb_reserve(lgr_thread_rb **ring, uint32_t nmbr,
+                      uint32_t *position)
+{
+    uint32_t head = __atomic_load_n(&(*ring)->head, __ATOMIC_ACQUIRE);
+
+    if ((*ring)->size - ((*ring)->tail - head) < nmbr)
+    {
+        lgr_thread_rb *newer = ta_log_thread_rb_full(*ring, nmbr);
+
+        if (newer == NULL)
+            return FALSE;
+        *ring = newer;
+    }
+
+    *position = (*ring)->tail;
+    return TRUE;
+}
+
+/**
+ * Make reserved elements available to the log reader.
+ *
+ * @param ring      Ring of the current thread
+ * @param nmbr      Number of elements passed to lgr_thread_rb_reserve()
+ */
+static inline void
+lgr_thread_rb_commit(lgr_thread_rb *ring, uint32_t nmbr)
+{
+    __atomic_store_n(&ring->tail, ring->tail + nmbr, __ATOMIC_RELEASE);
+}
+
+#endif /* TA_LOG_THREAD_RB */
+
+/** Write end of the pipe used to wake up the log streaming thread */
+extern int     ta_log_stream_wake_fd;
+/** Log streaming thread waits for new messages */
+extern te_bool ta_log_stream_sleeping;
+
+/**
+ * Wake up the log streaming thread if it waits for new messages.
+ * It must be called after a message is registered. The log lock
+ * is not required: the streaming thread raises the flag before it
+ * checks the log buffer for the last time.
+ */
+static inline void
+ta_log_stream_notify(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ta_log_stream_sleeping, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&ta_log_stream_sleeping, FALSE,
+                            __ATOMIC_SEQ_CST))
+    {
+        const uint8_t c = 0;
+
+        if (write(ta_log_stream_wake_fd, &c, sizeof(c)) < 0)
+        {
+            /* Streaming thread wakes up by timeout anyway */
+        }
+    }
+}
+
+/**
+ * Check whether there are no messages in the local log.
+ *
+ * @return @c TRUE if the local log is empty.
+ */
+extern te_bool ta_log_empty(void);
+
+/**
+ * Remember messages registered in the local log so far to check
+ * later by ta_log_flush_done() whether they are taken out.
+ */
+extern void ta_log_flush_mark(void);
+
+/**
+ * Check whether all messages remembered by ta_log_flush_mark() are
+ * taken out of the local log.
+ *
+ * @return @c TRUE if flush is complete.
+ */
+extern te_bool ta_log_flush_done(void);
+
+/**
+ * Drop the oldest message from the local log. It is used when the
+ * message does not fit in any transfer buffer.
+ */
+extern void ta_log_drop_oldest(void);
+
+/**
+ * Get messages from the local log buffer. Unlike ta_log_get() it does
+ * not take log streaming into account.
+ *
+ * @param buf_length    Length of the transfer buffer.
+ * @param transfer_buf  Pointer to the transfer buffer.
+ *
+ * @return Length of the filled part of the transfer buffer in bytes.
+ */
+extern uint32_t ta_log_get_messages(uint32_t buf_length,
+                                    uint8_t *transfer_buf);
+
+/**
+ * Check whether log messages are pushed to Logger by the streaming
+ * thread.
+ *
+ * @return @c TRUE if log streaming is active.
+ */
+extern te_bool ta_log_stream_active(void);
+
+/** Release log streaming resources inherited by a fork-child. */
+extern void ta_log_stream_atfork_child(void);
+
 
 /**
  * Initialize ring buffer.
@@ -335,7 +581,10 @@ lgr_rb_allocate_head(struct lgr_rb *ring_buffer,
     }
 
     if (ring_buffer->unused == 0)
+    {
         lgr_rb_remove_oldest(ring_buffer);
+        ta_log_dropped++;
+    }
 
     lgr_rb_allocate_space(ring_buffer, 1, position);
 
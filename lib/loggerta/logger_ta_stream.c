@@ -0,0 +1,661 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Logger subsystem API - TA side
+ *
+ * Pushing of TA local log messages to Logger over a dedicated
+ * connection (see te_log_stream.h for the protocol description).
+ *
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "Log Stream"
+
+#include "te_config.h"
+
+#if HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#if HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "logger_api.h"
+#include "te_log_stream.h"
+#include "logger_ta_internal.h"
+#include "logger_ta.h"
+
+/**
+ * Time (in milliseconds) the streaming thread sleeps if nothing
+ * happens: it is a safety net for lost wake ups.
+ */
+#define TA_LOG_STREAM_IDLE_TIMEOUT  1000
+
+/**
+ * Time (in milliseconds) to wait for Logger to accept data before
+ * the connection is considered broken.
+ */
+#define TA_LOG_STREAM_SEND_TIMEOUT  5000
+
+/**
+ * Time (in seconds) a failure to connect to Logger is remembered:
+ * requests to stream to the same host are rejected at once during it.
+ */
+#define TA_LOG_STREAM_FAILURE_TTL   60
+
+/**
+ * Parameters of a streaming thread.
+ *
+ * A new thread is started without waiting for the previous one to exit,
+ * since the start is requested from RCF command handler which must not
+ * be blocked. The new thread joins the previous one itself.
+ */
+typedef struct ta_log_stream_start_arg {
+    te_bool                 join_prev;  /**< Previous thread exists */
+    pthread_t               prev;       /**< Previous thread */
+    unsigned int            gen;        /**< Generation of the thread */
+
+    struct sockaddr_storage addr;       /**< Logger address */
+    socklen_t               addrlen;    /**< Logger address length */
+    uint32_t                cookie;     /**< Connection cookie */
+} ta_log_stream_start_arg;
+
+/** Log streaming context */
+typedef struct ta_log_stream {
+    pthread_mutex_t         lock;       /**< Protects start/stop and
+                                             connection failure data */
+    te_bool                 running;    /**< Streaming thread exists */
+    pthread_t               thread;     /**< The latest streaming thread */
+    unsigned int            gen;        /**< Generation of the thread
+                                             which should run, other
+                                             threads exit */
+    te_bool                 active;     /**< Connection is established */
+
+    struct sockaddr_storage failed_addr; /**< Logger address the agent
+                                              failed to connect to */
+    te_errno                failed_rc;  /**< Connection failure status or
+                                             @c 0 */
+    time_t                  failed_ts;  /**< Time of the connection
+                                             failure */
+
+    int                     sock;       /**< Connection to Logger */
+    int                     wake[2];    /**< Wake up pipe */
+
+    uint32_t                credit;     /**< Bytes allowed to be sent */
+    te_bool                 flush;      /**< Flush is requested */
+
+    te_log_stream_hdr       ctl;        /**< Incoming frame */
+    size_t                  ctl_len;    /**< Received part of @a ctl */
+
+    uint8_t                 buf[TE_LOG_STREAM_DATA_MAX]; /**< Data frame
+                                                              payload */
+} ta_log_stream;
+
+static ta_log_stream stream = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .sock = -1,
+    .wake = { -1, -1 },
+};
+
+/* See the description in logger_ta_internal.h */
+int     ta_log_stream_wake_fd = -1;
+/* See the description in logger_ta_internal.h */
+te_bool ta_log_stream_sleeping = FALSE;
+
+
+/* See the description in logger_ta_internal.h */
+te_bool
+ta_log_stream_active(void)
+{
+    return __atomic_load_n(&stream.active, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Send a frame to Logger.
+ *
+ * @param op        Frame type
+ * @param data      Payload or @c NULL
+ * @param len       Payload length or frame argument
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_send(te_log_stream_op op, const void *data, uint32_t len)
+{
+    te_log_stream_hdr   hdr = { .op = htonl(op), .len = htonl(len) };
+    struct iovec        iov[2];
+    struct msghdr       msg;
+    size_t              total = sizeof(hdr) + (data != NULL ? len : 0);
+    ssize_t             rc;
+
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = (data != NULL ? len : 0);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = TE_ARRAY_LEN(iov);
+
+    while (total > 0)
+    {
+        rc = sendmsg(stream.sock, &msg, MSG_NOSIGNAL);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return TE_OS_RC(TE_TA, errno);
+        }
+
+        total -= rc;
+        while (msg.msg_iovlen > 0 && (size_t)rc >= msg.msg_iov->iov_len)
+        {
+            rc -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0)
+        {
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + rc;
+            msg.msg_iov->iov_len -= rc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Process frames received from Logger without blocking.
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_recv(void)
+{
+    ssize_t rc;
+
+    while (TRUE)
+    {
+        rc = recv(stream.sock, (uint8_t *)&stream.ctl + stream.ctl_len,
+                  sizeof(stream.ctl) - stream.ctl_len, MSG_DONTWAIT);
+        if (rc == 0)
+            return TE_RC(TE_TA, TE_ECONNRESET);
+        if (rc < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            if (errno == EINTR)
+                continue;
+            return TE_OS_RC(TE_TA, errno);
+        }
+
+        stream.ctl_len += rc;
+        if (stream.ctl_len < sizeof(stream.ctl))
+            continue;
+        stream.ctl_len = 0;
+
+        switch (ntohl(stream.ctl.op))
+        {
+            case TE_LOG_STREAM_CREDIT:
+                stream.credit += ntohl(stream.ctl.len);
+                break;
+
+            case TE_LOG_STREAM_FLUSH:
+                ta_log_flush_mark();
+                stream.flush = TRUE;
+                break;
+
+            default:
+                return TE_RC(TE_TA, TE_EPROTO);
+        }
+    }
+}
+
+/**
+ * Wait until Logger sends something or, if @p want_messages is @c TRUE,
+ * a new message is registered.
+ *
+ * @param want_messages     Wake up on new messages
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_wait(te_bool want_messages)
+{
+    struct pollfd   pfd[2];
+    uint8_t         junk[64];
+
+    if (want_messages)
+    {
+        /* Pairs with the fence in ta_log_stream_notify() */
+        __atomic_store_n(&ta_log_stream_sleeping, TRUE, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        if (!ta_log_empty())
+        {
+            __atomic_store_n(&ta_log_stream_sleeping, FALSE,
+                             __ATOMIC_SEQ_CST);
+            return 0;
+        }
+    }
+
+    pfd[0].fd = stream.sock;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = stream.wake[0];
+    pfd[1].events = POLLIN;
+
+    if (poll(pfd, TE_ARRAY_LEN(pfd), TA_LOG_STREAM_IDLE_TIMEOUT) < 0 &&
+        errno != EINTR)
+        return TE_OS_RC(TE_TA, errno);
+
+    if (pfd[1].revents & POLLIN)
+    {
+        while (read(stream.wake[0], junk, sizeof(junk)) == sizeof(junk))
+            ;
+    }
+
+    if (want_messages)
+        __atomic_store_n(&ta_log_stream_sleeping, FALSE, __ATOMIC_SEQ_CST);
+
+    return 0;
+}
+
+/**
+ * Check whether two socket addresses refer to the same host.
+ *
+ * @param a         The first address
+ * @param b         The second address
+ *
+ * @return @c TRUE if addresses are equal except for the port.
+ */
+static te_bool
+stream_same_host(const struct sockaddr_storage *a,
+                 const struct sockaddr_storage *b)
+{
+    if (a->ss_family != b->ss_family)
+        return FALSE;
+
+    switch (a->ss_family)
+    {
+        case AF_INET:
+            return memcmp(&((const struct sockaddr_in *)a)->sin_addr,
+                          &((const struct sockaddr_in *)b)->sin_addr,
+                          sizeof(struct in_addr)) == 0;
+
+        case AF_INET6:
+            return memcmp(&((const struct sockaddr_in6 *)a)->sin6_addr,
+                          &((const struct sockaddr_in6 *)b)->sin6_addr,
+                          sizeof(struct in6_addr)) == 0;
+
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * Connect to Logger and exchange cookies.
+ *
+ * @param arg       Thread parameters
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_connect(const ta_log_stream_start_arg *arg)
+{
+    struct pollfd       pfd;
+    te_log_stream_hdr   hello;
+    size_t              got = 0;
+    int                 err = 0;
+    socklen_t           errlen = sizeof(err);
+    struct timeval      send_timeout = {
+        .tv_sec = TE_MS2SEC(TA_LOG_STREAM_SEND_TIMEOUT),
+    };
+    int                 flags;
+    ssize_t             rc;
+    te_errno            te_rc;
+
+    stream.sock = socket(arg->addr.ss_family, SOCK_STREAM, 0);
+    if (stream.sock < 0)
+        return TE_OS_RC(TE_TA, errno);
+
+    flags = fcntl(stream.sock, F_GETFL);
+    if (flags < 0 || fcntl(stream.sock, F_SETFL, flags | O_NONBLOCK) < 0)
+        return TE_OS_RC(TE_TA, errno);
+
+    if (connect(stream.sock, (const struct sockaddr *)&arg->addr,
+                arg->addrlen) < 0)
+    {
+        if (errno != EINPROGRESS)
+            return TE_OS_RC(TE_TA, errno);
+
+        pfd.fd = stream.sock;
+        pfd.events = POLLOUT;
+        rc = poll(&pfd, 1, TE_LOG_STREAM_CONNECT_TIMEOUT);
+        if (rc < 0)
+            return TE_OS_RC(TE_TA, errno);
+        if (rc == 0)
+            return TE_RC(TE_TA, TE_ETIMEDOUT);
+
+        if (getsockopt(stream.sock, SOL_SOCKET, SO_ERROR,
+                       &err, &errlen) < 0)
+            return TE_OS_RC(TE_TA, errno);
+        if (err != 0)
+            return TE_OS_RC(TE_TA, err);
+    }
+
+    if (fcntl(stream.sock, F_SETFL, flags) < 0)
+        return TE_OS_RC(TE_TA, errno);
+
+    /* Logger which stopped reading must not block the agent forever */
+    if (setsockopt(stream.sock, SOL_SOCKET, SO_SNDTIMEO,
+                   &send_timeout, sizeof(send_timeout)) < 0)
+        return TE_OS_RC(TE_TA, errno);
+
+    te_rc = stream_send(TE_LOG_STREAM_HELLO, NULL, arg->cookie);
+    if (te_rc != 0)
+        return te_rc;
+
+    while (got < sizeof(hello))
+    {
+        pfd.fd = stream.sock;
+        pfd.events = POLLIN;
+        rc = poll(&pfd, 1, TE_LOG_STREAM_CONNECT_TIMEOUT);
+        if (rc < 0)
+            return TE_OS_RC(TE_TA, errno);
+        if (rc == 0)
+            return TE_RC(TE_TA, TE_ETIMEDOUT);
+
+        rc = recv(stream.sock, (uint8_t *)&hello + got,
+                  sizeof(hello) - got, 0);
+        if (rc <= 0)
+            return TE_RC(TE_TA, TE_ECONNRESET);
+        got += rc;
+    }
+
+    if (ntohl(hello.op) != TE_LOG_STREAM_HELLO ||
+        ntohl(hello.len) != arg->cookie)
+        return TE_RC(TE_TA, TE_EPROTO);
+
+    return 0;
+}
+
+/**
+ * Push as many messages as allowed by credit and Logger requests.
+ *
+ * @param gen       Generation of the calling thread
+ * @param final     Do not wait for messages or credit
+ *
+ * @return Status code.
+ */
+static te_errno
+stream_push(unsigned int gen, te_bool final)
+{
+    uint32_t    len;
+    te_errno    rc;
+
+    while (TRUE)
+    {
+        rc = stream_recv();
+        if (rc != 0)
+            return rc;
+
+        if (stream.credit > 0 && !ta_log_empty())
+        {
+            uint32_t max = MIN(stream.credit, sizeof(stream.buf));
+
+            len = ta_log_get_messages(max, stream.buf);
+            if (len > 0)
+            {
+                rc = stream_send(TE_LOG_STREAM_DATA, stream.buf, len);
+                if (rc != 0)
+                    return rc;
+                stream.credit -= len;
+                continue;
+            }
+            if (max == sizeof(stream.buf))
+            {
+                /* The oldest message never fits in a data frame */
+                ta_log_drop_oldest();
+                continue;
+            }
+        }
+
+        if (stream.flush && (ta_log_flush_done() || final))
+        {
+            rc = stream_send(TE_LOG_STREAM_FLUSHED, NULL, 0);
+            if (rc != 0)
+                return rc;
+            stream.flush = FALSE;
+            continue;
+        }
+
+        if (final)
+            return 0;
+
+        rc = stream_wait(stream.credit > 0);
+        if (rc != 0)
+            return rc;
+
+        if (__atomic_load_n(&stream.gen, __ATOMIC_ACQUIRE) != gen)
+            return 0;
+    }
+}
+
+/**
+ * Entry point of the log streaming thread.
+ *
+ * @param opaque    Thread parameters, owned by the thread
+ *
+ * @return @c NULL
+ */
+static void *
+stream_thread(void *opaque)
+{
+    ta_log_stream_start_arg *arg = opaque;
+    te_errno                 rc;
+
+    if (arg->join_prev)
+        pthread_join(arg->prev, NULL);
+
+    /* Stop or another start is requested while the thread is joined */
+    if (__atomic_load_n(&stream.gen, __ATOMIC_ACQUIRE) != arg->gen)
+        goto exit;
+
+    stream.credit = 0;
+    stream.flush = FALSE;
+    stream.ctl_len = 0;
+
+    rc = stream_connect(arg);
+    if (rc != 0)
+    {
+        /*
+         * The agent may be reachable by RCF via a port forwarding only
+         * (e.g. SSH proxy): further requests to connect to the same
+         * host are rejected at once for a while, so Logger keeps
+         * polling.
+         */
+        pthread_mutex_lock(&stream.lock);
+        stream.failed_addr = arg->addr;
+        stream.failed_rc = rc;
+        stream.failed_ts = time(NULL);
+        pthread_mutex_unlock(&stream.lock);
+
+        WARN("Failed to connect to Logger, log is kept for polling: %r",
+             rc);
+        goto exit;
+    }
+
+    __atomic_store_n(&stream.active, TRUE, __ATOMIC_RELEASE);
+
+    rc = stream_push(arg->gen, FALSE);
+    if (rc == 0)
+        rc = stream_push(arg->gen, TRUE);
+
+    __atomic_store_n(&stream.active, FALSE, __ATOMIC_RELEASE);
+
+    if (rc != 0)
+        WARN("Log streaming is stopped, log is kept for polling: %r", rc);
+
+exit:
+    if (stream.sock >= 0)
+    {
+        close(stream.sock);
+        stream.sock = -1;
+    }
+    free(arg);
+    return NULL;
+}
+
+/**
+ * Request the running streaming thread to exit. It must be called with
+ * @a stream.lock held.
+ */
+static void
+stream_supersede_locked(void)
+{
+    const uint8_t c = 0;
+
+    __atomic_add_fetch(&stream.gen, 1, __ATOMIC_RELEASE);
+    if (stream.running && write(stream.wake[1], &c, sizeof(c)) < 0)
+    {
+        /* The thread notices the request by timeout */
+    }
+}
+
+/**
+ * Stop the streaming thread. It must be called with @a stream.lock held.
+ */
+static void
+stream_stop_locked(void)
+{
+    stream_supersede_locked();
+    if (!stream.running)
+        return;
+
+    /* The latest thread joins previous ones */
+    pthread_join(stream.thread, NULL);
+    stream.running = FALSE;
+}
+
+/* See the description in logger_ta.h */
+te_errno
+ta_log_stream_start(const struct sockaddr *addr, socklen_t addrlen,
+                    uint32_t cookie)
+{
+    ta_log_stream_start_arg    *arg;
+    ta_log_lock_key             key;
+    pthread_t                   thread;
+    int                         rc;
+
+    if (addr == NULL || addrlen > sizeof(arg->addr))
+        return TE_RC(TE_TA, TE_EINVAL);
+
+    arg = calloc(1, sizeof(*arg));
+    if (arg == NULL)
+        return TE_RC(TE_TA, TE_ENOMEM);
+
+    memcpy(&arg->addr, addr, addrlen);
+    arg->addrlen = addrlen;
+    arg->cookie = cookie;
+
+    pthread_mutex_lock(&stream.lock);
+
+    /* The failure may be temporary (e.g. Logger host is overloaded) */
+    if (stream.failed_rc != 0 &&
+        (unsigned long)(time(NULL) - stream.failed_ts) >=
+            TA_LOG_STREAM_FAILURE_TTL)
+        stream.failed_rc = 0;
+
+    if (stream.failed_rc != 0 &&
+        stream_same_host(&stream.failed_addr, &arg->addr))
+    {
+        rc = stream.failed_rc;
+        pthread_mutex_unlock(&stream.lock);
+        free(arg);
+        return rc;
+    }
+
+    if (stream.wake[0] < 0)
+    {
+        if (pipe(stream.wake) != 0)
+        {
+            rc = TE_OS_RC(TE_TA, errno);
+            pthread_mutex_unlock(&stream.lock);
+            free(arg);
+            return rc;
+        }
+        (void)fcntl(stream.wake[0], F_SETFL, O_NONBLOCK);
+        (void)fcntl(stream.wake[1], F_SETFL, O_NONBLOCK);
+
+        if (ta_log_lock(&key) == 0)
+        {
+            ta_log_stream_wake_fd = stream.wake[1];
+            (void)ta_log_unlock(&key);
+        }
+    }
+
+    stream_supersede_locked();
+
+    arg->join_prev = stream.running;
+    arg->prev = stream.thread;
+    arg->gen = stream.gen;
+
+    rc = pthread_create(&thread, NULL, stream_thread, arg);
+    if (rc != 0)
+    {
+        /* The previous thread, if any, is joined by the stop */
+        pthread_mutex_unlock(&stream.lock);
+        free(arg);
+        return TE_OS_RC(TE_TA, rc);
+    }
+    stream.thread = thread;
+    stream.running = TRUE;
+
+    pthread_mutex_unlock(&stream.lock);
+    return 0;
+}
+
+/* See the description in logger_ta.h */
+void
+ta_log_stream_stop(void)
+{
+    pthread_mutex_lock(&stream.lock);
+    stream_stop_locked();
+    pthread_mutex_unlock(&stream.lock);
+}
+
+/* See the description in logger_ta_internal.h */
+void
+ta_log_stream_atfork_child(void)
+{
+    /* The streaming thread does not exist in the child */
+    if (stream.sock >= 0)
+        close(stream.sock);
+    stream.sock = -1;
+    stream.running = FALSE;
+    stream.active = FALSE;
+    ta_log_stream_sleeping = FALSE;
+}
@@ -0,0 +1,786 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Cache of network configuration in netconf library
+ *
+ * Network devices, IPv4/IPv6 addresses and neighbour table entries are
+ * dumped once and then kept up to date by netlink events received on
+ * a socket subscribed to the corresponding rtnetlink multicast groups.
+ *
+ * Events are applied lazily: pending events are read from the socket
+ * when cached data is requested. The kernel sends notifications before
+ * it acknowledges a request, so changes made via the netconf session
+ * are always seen by the following requests.
+ *
+ * Events queued while the cache is filled by a dump may be older than
+ * the dump. They are applied in order anyway, so an entry touched by
+ * them ends up in the state reported by the latest event, and the rest
+ * of entries are up to date since the dump.
+ *
+ * Copyright (C) 2024 OKTET Labs Ltd. All rights reserved.
+ */
+
+#include "netconf.h"
+#include "netconf_internal.h"
+
+/** Receive buffer of the events socket in bytes */
+#define NETCONF_CACHE_RCVBUF (1024 * 1024)
+
+/** Multicast groups the events socket is subscribed to */
+#define NETCONF_CACHE_GROUPS \
+    (RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_NEIGH)
+
+/** Kinds of cached entities */
+typedef enum netconf_cache_kind {
+    NETCONF_CACHE_LINK,         /**< Network devices */
+    NETCONF_CACHE_NET_ADDR,     /**< Network addresses */
+    NETCONF_CACHE_NEIGH,        /**< Neighbour table entries */
+
+    NETCONF_CACHE_KINDS         /**< Number of kinds */
+} netconf_cache_kind;
+
+/** Description of a kind of cached entities */
+typedef struct netconf_cache_kind_info {
+    netconf_node_type   type;       /**< Type of nodes */
+    uint16_t            dump_type;  /**< Type of dump request */
+    netconf_recv_cb_t  *recv_cb;    /**< Decoder of a message */
+} netconf_cache_kind_info;
+
+/** Kinds of cached entities indexed by netconf_cache_kind */
+static const netconf_cache_kind_info cache_kinds[NETCONF_CACHE_KINDS] = {
+    { NETCONF_NODE_LINK, RTM_GETLINK, link_list_cb },
+    { NETCONF_NODE_NET_ADDR, RTM_GETADDR, net_addr_list_cb },
+    { NETCONF_NODE_NEIGH, RTM_GETNEIGH, neigh_list_cb },
+};
+
+/** Cached list of entities of one kind */
+typedef struct netconf_cache_entry {
+    bool            valid;      /**< List is filled and up to date */
+    netconf_list    list;       /**< Cached nodes */
+} netconf_cache_entry;
+
+/** Cache of network configuration */
+struct netconf_cache {
+    int                 socket;     /**< Socket receiving events */
+    netconf_cache_entry entries[NETCONF_CACHE_KINDS];  /**< Cached
+                                                            entities */
+    netconf_cache_event_cb *event_cb;   /**< Callback to report events
+                                             or @c NULL */
+    void               *event_data;     /**< Data passed to the
+                                             callback */
+};
+
+/**
+ * Get length of a network address.
+ *
+ * @param family        Address family
+ *
+ * @return Length of address, or @c 0 if family is not supported.
+ */
+static size_t
+cache_addr_len(unsigned char family)
+{
+    switch (family)
+    {
+        case AF_INET:
+            return sizeof(struct in_addr);
+
+        case AF_INET6:
+            return sizeof(struct in6_addr);
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Compare binary fields of nodes.
+ *
+ * @param a             The first field (may be @c NULL)
+ * @param b             The second field (may be @c NULL)
+ * @param len           Length of fields
+ *
+ * @return @c true if fields are equal.
+ */
+static bool
+cache_field_eq(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    return memcmp(a, b, len) == 0;
+}
+
+/**
+ * Check whether nodes describe the same entity, i.e. whether one
+ * replaces the other.
+ *
+ * @param a             The first node
+ * @param b             The second node of the same type
+ *
+ * @return @c true if nodes describe the same entity.
+ */
+static bool
+cache_node_same(const netconf_node *a, const netconf_node *b)
+{
+    switch (a->type)
+    {
+        case NETCONF_NODE_LINK:
+            return a->data.link.ifindex == b->data.link.ifindex;
+
+        case NETCONF_NODE_NET_ADDR:
+        {
+            const netconf_net_addr *x = &a->data.net_addr;
+            const netconf_net_addr *y = &b->data.net_addr;
+
+            return x->family == y->family && x->ifindex == y->ifindex &&
+                   x->prefix == y->prefix &&
+                   cache_field_eq(x->address, y->address,
+                                  cache_addr_len(x->family));
+        }
+
+        case NETCONF_NODE_NEIGH:
+        {
+            const netconf_neigh *x = &a->data.neigh;
+            const netconf_neigh *y = &b->data.neigh;
+
+            return x->family == y->family && x->ifindex == y->ifindex &&
+                   cache_field_eq(x->dst, y->dst,
+                                  cache_addr_len(x->family));
+        }
+
+        default:
+            NETCONF_ASSERT(0);
+            return false;
+    }
+}
+
+/**
+ * Filter removing nodes describing the same entity as the given one.
+ *
+ * @param node          Node of list
+ * @param user_data     Node to compare with
+ *
+ * @return @c false if the node should be removed.
+ */
+static bool
+cache_filter_other(netconf_node *node, void *user_data)
+{
+    return !cache_node_same(node, user_data);
+}
+
+/**
+ * Filter removing nodes related to an interface.
+ *
+ * @param node          Node of list
+ * @param user_data     Address of interface index
+ *
+ * @return @c false if the node should be removed.
+ */
+static bool
+cache_filter_other_iface(netconf_node *node, void *user_data)
+{
+    int ifindex = *(int *)user_data;
+
+    if (node->type == NETCONF_NODE_NET_ADDR)
+        return node->data.net_addr.ifindex != ifindex;
+    else
+        return node->data.neigh.ifindex != ifindex;
+}
+
+/**
+ * Remove cached addresses and neighbours of an interface.
+ *
+ * @param cache         Cache
+ * @param ifindex       Interface index
+ */
+static void
+cache_purge_iface(netconf_cache *cache, int ifindex)
+{
+    netconf_list_filter(&cache->entries[NETCONF_CACHE_NET_ADDR].list,
+                        cache_filter_other_iface, &ifindex);
+    netconf_list_filter(&cache->entries[NETCONF_CACHE_NEIGH].list,
+                        cache_filter_other_iface, &ifindex);
+}
+
+/**
+ * Filter removing nodes which are not supported by the cache,
+ * i.e. addresses and neighbours of families other than IPv4/IPv6.
+ *
+ * @param node          Node of list
+ * @param user_data     Unused
+ *
+ * @return @c false if the node should be removed.
+ */
+static bool
+cache_filter_supported(netconf_node *node, void *user_data)
+{
+    UNUSED(user_data);
+
+    switch (node->type)
+    {
+        case NETCONF_NODE_NET_ADDR:
+            return cache_addr_len(node->data.net_addr.family) != 0;
+
+        case NETCONF_NODE_NEIGH:
+            return cache_addr_len(node->data.neigh.family) != 0;
+
+        default:
+            return true;
+    }
+}
+
+/**
+ * Filter removing all nodes.
+ *
+ * @param node          Node of list
+ * @param user_data     Unused
+ *
+ * @return Always @c false.
+ */
+static bool
+cache_filter_none(netconf_node *node, void *user_data)
+{
+    UNUSED(node);
+    UNUSED(user_data);
+
+    return false;
+}
+
+/**
+ * Drop cached entities of one kind, so that they are dumped again
+ * on the next request.
+ *
+ * @param entry         Cache entry
+ */
+static void
+cache_invalidate(netconf_cache_entry *entry)
+{
+    netconf_list_filter(&entry->list, cache_filter_none, NULL);
+    entry->valid = false;
+}
+
+/**
+ * Apply a netlink event to the cache.
+ *
+ * @param cache         Cache
+ * @param h             Event message
+ */
+static void
+cache_apply_event(netconf_cache *cache, struct nlmsghdr *h)
+{
+    netconf_cache_kind      kind;
+    netconf_cache_entry    *entry;
+    netconf_list            event;
+    netconf_node           *node;
+    bool                    del = false;
+
+    switch (h->nlmsg_type)
+    {
+        case RTM_DELLINK:
+            del = true;
+        /*@fallthrough@*/
+
+        case RTM_NEWLINK:
+        {
+            struct ifinfomsg *ifi = NLMSG_DATA(h);
+
+            /* Skip bridge port information and the like */
+            if (ifi->ifi_family != AF_UNSPEC)
+                return;
+
+            if (del)
+            {
+                /*
+                 * The kernel does not report removal of all addresses
+                 * and neighbours of a removed interface.
+                 */
+                cache_purge_iface(cache, ifi->ifi_index);
+            }
+            kind = NETCONF_CACHE_LINK;
+            break;
+        }
+
+        case RTM_DELADDR:
+            del = true;
+        /*@fallthrough@*/
+
+        case RTM_NEWADDR:
+            if (cache_addr_len(
+                    ((struct ifaddrmsg *)NLMSG_DATA(h))->ifa_family) == 0)
+                return;
+            kind = NETCONF_CACHE_NET_ADDR;
+            break;
+
+        case RTM_DELNEIGH:
+            del = true;
+        /*@fallthrough@*/
+
+        case RTM_NEWNEIGH:
+        {
+            struct ndmsg *ndm = NLMSG_DATA(h);
+
+            /* Proxy entries are not dumped */
+            if (cache_addr_len(ndm->ndm_family) == 0 ||
+                (ndm->ndm_flags & NTF_PROXY) != 0)
+                return;
+            kind = NETCONF_CACHE_NEIGH;
+            break;
+        }
+
+        default:
+            return;
+    }
+
+    entry = &cache->entries[kind];
+    if (!entry->valid && cache->event_cb == NULL)
+        return;
+
+    memset(&event, 0, sizeof(event));
+    if (cache_kinds[kind].recv_cb(h, &event, NULL) != 0 ||
+        event.head == NULL)
+    {
+        /* The event cannot be applied, refill the cache */
+        netconf_list_filter(&event, cache_filter_none, NULL);
+        cache_invalidate(entry);
+        if (cache->event_cb != NULL)
+            cache->event_cb(NULL, del, cache->event_data);
+        return;
+    }
+
+    node = event.head;
+    if (cache->event_cb != NULL)
+        cache->event_cb(node, del, cache->event_data);
+
+    if (!entry->valid)
+    {
+        netconf_list_filter(&event, cache_filter_none, NULL);
+        return;
+    }
+
+    netconf_list_filter(&entry->list, cache_filter_other, node);
+
+    if (del)
+    {
+        netconf_list_filter(&event, cache_filter_none, NULL);
+        return;
+    }
+
+    node->prev = entry->list.tail;
+    if (entry->list.tail == NULL)
+        entry->list.head = node;
+    else
+        entry->list.tail->next = node;
+    entry->list.tail = node;
+    entry->list.length++;
+}
+
+/**
+ * Read pending events and apply them to the cache.
+ *
+ * @param cache         Cache
+ */
+static void
+cache_update(netconf_cache *cache)
+{
+    char                buf[NETCONF_RCV_BUF_LEN];
+    struct nlmsghdr    *h;
+    ssize_t             rcvd;
+    unsigned int        kind;
+
+    while (true)
+    {
+        rcvd = recv(cache->socket, buf, sizeof(buf),
+                    MSG_DONTWAIT | MSG_TRUNC);
+        if (rcvd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+
+            /*
+             * Events are lost (ENOBUFS on receive buffer overflow)
+             * or cannot be read, so the cache is refilled.
+             */
+            int err = errno;
+
+            for (kind = 0; kind < NETCONF_CACHE_KINDS; kind++)
+                cache_invalidate(&cache->entries[kind]);
+            if (cache->event_cb != NULL)
+                cache->event_cb(NULL, false, cache->event_data);
+
+            if (err == ENOBUFS)
+                continue;
+            break;
+        }
+
+        if ((size_t)rcvd > sizeof(buf))
+        {
+            for (kind = 0; kind < NETCONF_CACHE_KINDS; kind++)
+                cache_invalidate(&cache->entries[kind]);
+            if (cache->event_cb != NULL)
+                cache->event_cb(NULL, false, cache->event_data);
+            continue;
+        }
+
+        for (h = (struct nlmsghdr *)buf;
+             NLMSG_OK(h, (unsigned int)rcvd);
+             h = NLMSG_NEXT(h, rcvd))
+        {
+            cache_apply_event(cache, h);
+        }
+    }
+}
+
+/**
+ * Fill cached entities of one kind with a dump.
+ *
+ * @param nh            Netconf handle
+ * @param kind          Kind of entities
+ *
+ * @return 0 on success, -1 on error (check errno for details).
+ */
+static int
+cache_fill(netconf_handle nh, netconf_cache_kind kind)
+{
+    netconf_cache_entry    *entry = &nh->cache->entries[kind];
+    netconf_list           *list;
+
+    list = netconf_dump_request(nh, cache_kinds[kind].dump_type, AF_UNSPEC,
+                                cache_kinds[kind].recv_cb, NULL);
+    if (list == NULL)
+        return -1;
+
+    netconf_list_filter(list, cache_filter_supported, NULL);
+
+    entry->list = *list;
+    entry->valid = true;
+    free(list);
+
+    return 0;
+}
+
+/**
+ * Duplicate a binary field of a node.
+ *
+ * @param src           Field (may be @c NULL)
+ * @param len           Length of the field
+ * @param dst           Where to save the copy
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int
+cache_field_dup(const void *src, size_t len, uint8_t **dst)
+{
+    if (src == NULL)
+        return 0;
+
+    *dst = malloc(len);
+    if (*dst == NULL)
+        return -1;
+
+    memcpy(*dst, src, len);
+    return 0;
+}
+
+/**
+ * Duplicate a string field of a node.
+ *
+ * @param src           Field (may be @c NULL)
+ * @param dst           Where to save the copy
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int
+cache_str_dup(const char *src, char **dst)
+{
+    if (src == NULL)
+        return 0;
+
+    *dst = strdup(src);
+    return (*dst == NULL) ? -1 : 0;
+}
+
+/**
+ * Append a copy of a cached node to a list.
+ *
+ * @param list          List
+ * @param src           Cached node
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int
+cache_node_copy(netconf_list *list, const netconf_node *src)
+{
+    netconf_node *dst;
+
+    if (netconf_list_extend(list, src->type) != 0)
+        return -1;
+
+    dst = list->tail;
+
+    switch (src->type)
+    {
+        case NETCONF_NODE_LINK:
+        {
+            const netconf_link *s = &src->data.link;
+            netconf_link       *d = &dst->data.link;
+
+            d->type = s->type;
+            d->ifindex = s->ifindex;
+            d->link = s->link;
+            d->flags = s->flags;
+            d->addrlen = s->addrlen;
+            d->mtu = s->mtu;
+
+            if (cache_field_dup(s->address, s->addrlen, &d->address) != 0 ||
+                cache_field_dup(s->broadcast, s->addrlen,
+                                &d->broadcast) != 0 ||
+                cache_str_dup(s->ifname, &d->ifname) != 0 ||
+                cache_str_dup(s->info_kind, &d->info_kind) != 0)
+                return -1;
+            break;
+        }
+
+        case NETCONF_NODE_NET_ADDR:
+        {
+            const netconf_net_addr *s = &src->data.net_addr;
+            netconf_net_addr       *d = &dst->data.net_addr;
+            size_t                  len = cache_addr_len(s->family);
+
+            d->family = s->family;
+            d->prefix = s->prefix;
+            d->flags = s->flags;
+            d->ifindex = s->ifindex;
+
+            if (cache_field_dup(s->address, len, &d->address) != 0 ||
+                cache_field_dup(s->broadcast, len, &d->broadcast) != 0)
+                return -1;
+            break;
+        }
+
+        case NETCONF_NODE_NEIGH:
+        {
+            const netconf_neigh *s = &src->data.neigh;
+            netconf_neigh       *d = &dst->data.neigh;
+
+            d->family = s->family;
+            d->ifindex = s->ifindex;
+            d->state = s->state;
+            d->flags = s->flags;
+            d->addrlen = s->addrlen;
+
+            if (cache_field_dup(s->dst, cache_addr_len(s->family),
+                                &d->dst) != 0 ||
+                cache_field_dup(s->lladdr, s->addrlen, &d->lladdr) != 0)
+                return -1;
+            break;
+        }
+
+        default:
+            NETCONF_ASSERT(0);
+            errno = EINVAL;
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Check whether a cached node matches address family.
+ *
+ * @param node          Cached node
+ * @param family        Address family or @c AF_UNSPEC
+ *
+ * @return @c true if the node matches.
+ */
+static bool
+cache_node_match_family(const netconf_node *node, unsigned char family)
+{
+    if (family == AF_UNSPEC)
+        return true;
+
+    switch (node->type)
+    {
+        case NETCONF_NODE_NET_ADDR:
+            return node->data.net_addr.family == family;
+
+        case NETCONF_NODE_NEIGH:
+            return node->data.neigh.family == family;
+
+        default:
+            return true;
+    }
+}
+
+/* See netconf_internal.h */
+netconf_list *
+netconf_cache_dump(netconf_handle nh, netconf_node_type type,
+                   unsigned char family)
+{
+    netconf_cache_kind      kind;
+    netconf_cache_entry    *entry;
+    const netconf_node     *node;
+    netconf_list           *list;
+
+    for (kind = 0; kind < NETCONF_CACHE_KINDS; kind++)
+    {
+        if (cache_kinds[kind].type == type)
+            break;
+    }
+    if (kind == NETCONF_CACHE_KINDS)
+    {
+        NETCONF_ASSERT(0);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    /* Families other than IPv4/IPv6 are not cached */
+    if (family != AF_UNSPEC && cache_addr_len(family) == 0)
+    {
+        return netconf_dump_request(nh, cache_kinds[kind].dump_type,
+                                    family, cache_kinds[kind].recv_cb,
+                                    NULL);
+    }
+
+    cache_update(nh->cache);
+
+    entry = &nh->cache->entries[kind];
+    if (!entry->valid && cache_fill(nh, kind) != 0)
+        return NULL;
+
+    list = calloc(1, sizeof(*list));
+    if (list == NULL)
+        return NULL;
+
+    for (node = entry->list.head; node != NULL; node = node->next)
+    {
+        if (!cache_node_match_family(node, family))
+            continue;
+
+        if (cache_node_copy(list, node) != 0)
+        {
+            int err = errno;
+
+            netconf_list_free(list);
+            errno = err;
+            return NULL;
+        }
+    }
+
+    return list;
+}
+
+/* See description in netconf.h */
+int
+netconf_cache_enable(netconf_handle nh)
+{
+    netconf_cache      *cache;
+    struct sockaddr_nl  local_addr;
+    int                 rcvbuf = NETCONF_CACHE_RCVBUF;
+    int                 sock;
+
+    if (nh == NULL || nh->socket < 0)
+    {
+        NETCONF_ASSERT(0);
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (nh->cache != NULL)
+        return 0;
+
+    sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (sock < 0)
+        return -1;
+
+    /* Forcing the size requires privileges, so fall back if not allowed */
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE,
+                   &rcvbuf, sizeof(rcvbuf)) < 0 &&
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+                   &rcvbuf, sizeof(rcvbuf)) < 0)
+    {
+        int err = errno;
+
+        close(sock);
+        errno = err;
+        return -1;
+    }
+
+    memset(&local_addr, 0, sizeof(local_addr));
+    local_addr.nl_family = AF_NETLINK;
+    local_addr.nl_groups = NETCONF_CACHE_GROUPS;
+    if (bind(sock, (struct sockaddr *)&local_addr,
+             sizeof(local_addr)) < 0)
+    {
+        int err = errno;
+
+        close(sock);
+        errno = err;
+        return -1;
+    }
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache == NULL)
+    {
+        int err = errno;
+
+        close(sock);
+        errno = err;
+        return -1;
+    }
+
+    cache->socket = sock;
+    nh->cache = cache;
+
+    return 0;
+}
+
+/* See description in netconf.h */
+int
+netconf_cache_set_event_cb(netconf_handle nh, netconf_cache_event_cb *cb,
+                           void *user_data)
+{
+    if (nh == NULL || nh->cache == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    nh->cache->event_cb = cb;
+    nh->cache->event_data = user_data;
+
+    return 0;
+}
+
+/* See description in netconf.h */
+int
+netconf_cache_update(netconf_handle nh)
+{
+    if (nh == NULL || nh->cache == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    cache_update(nh->cache);
+
+    return 0;
+}
+
+/* See netconf_internal.h */
+void
+netconf_cache_free(netconf_handle nh)
+{
+    unsigned int kind;
+
+    if (nh->cache == NULL)
+        return;
+
+    for (kind = 0; kind < NETCONF_CACHE_KINDS; kind++)
+        cache_invalidate(&nh->cache->entries[kind]);
+
+    close(nh->cache->socket);
+    free(nh->cache);
+    nh->cache = NULL;
+}
@@ -8,17 +8,8 @@
 #include "netconf.h"
 #include "netconf_internal.h"
 
-/**
- * Callback of network devices dump.
- *
- * @param h             Message header
- * @param list          List of info to store
- * @param cookie        Extra parameters (unused)
- *
- * @return 0 on success, -1 on error (check errno for details).
- */
-static netconf_recv_cb_t link_list_cb;
-static int
+/* See netconf_internal.h */
+int
 link_list_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
 {
     struct ifinfomsg   *ifla = NLMSG_DATA(h);
@@ -90,6 +81,9 @@ link_list_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
 netconf_list *
 netconf_link_dump(netconf_handle nh)
 {
+    if (nh != NULL && nh->cache != NULL)
+        return netconf_cache_dump(nh, NETCONF_NODE_LINK, AF_UNSPEC);
+
     return netconf_dump_request(nh, RTM_GETLINK, AF_UNSPEC,
                                 link_list_cb, NULL);
 }
@@ -134,3 +128,76 @@ netconf_link_set_ns(netconf_handle nh, const char *ifname,
 
     return 0;
 }
+
+/**
+ * Callback of network device statistics request.
+ *
+ * @param h             Message header
+ * @param list          Unused
+ * @param cookie        Location of netconf_link_stats
+ *
+ * @return 0 on success, -1 on error (check errno for details).
+ */
+static int
+link_stats_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
+{
+    netconf_link_stats         *stats = cookie;
+    struct rtattr              *rta;
+    int                         len;
+
+    UNUSED(list);
+
+    rta = (struct rtattr *)((char *)h +
+                            NLMSG_SPACE(sizeof(struct ifinfomsg)));
+    len = h->nlmsg_len - NLMSG_SPACE(sizeof(struct ifinfomsg));
+
+    for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        struct rtnl_link_stats64 stats64;
+
+        if (rta->rta_type != IFLA_STATS64)
+            continue;
+
+        memset(&stats64, 0, sizeof(stats64));
+        memcpy(&stats64, RTA_DATA(rta),
+               MIN(RTA_PAYLOAD(rta), sizeof(stats64)));
+
+        stats->rx_packets = stats64.rx_packets;
+        stats->tx_packets = stats64.tx_packets;
+        stats->rx_bytes = stats64.rx_bytes;
+        stats->tx_bytes = stats64.tx_bytes;
+        stats->rx_errors = stats64.rx_errors;
+        stats->tx_errors = stats64.tx_errors;
+        stats->rx_dropped = stats64.rx_dropped;
+        stats->tx_dropped = stats64.tx_dropped;
+
+        return 0;
+    }
+
+    errno = ENODATA;
+    return -1;
+}
+
+te_errno
+netconf_link_get_stats(netconf_handle nh, int ifindex,
+                       netconf_link_stats *stats)
+{
+    char                req[NETCONF_MAX_REQ_LEN];
+    struct nlmsghdr    *h;
+    struct ifinfomsg   *ifi;
+
+    memset(&req, 0, sizeof(req));
+    memset(stats, 0, sizeof(*stats));
+
+    netconf_init_nlmsghdr(req, nh, RTM_GETLINK, NLM_F_REQUEST, &h);
+
+    ifi = NLMSG_DATA(h);
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index = ifindex;
+
+    if (netconf_talk(nh, &req, sizeof(req), link_stats_cb, stats,
+                     NULL) < 0)
+        return TE_OS_RC(TE_TA_UNIX, errno);
+
+    return 0;
+}
@@ -88,17 +88,8 @@ neigh_flags_h2te(unsigned int flags)
     return result;
 }
 
-/**
- * Callback of neighbours dump.
- *
- * @param h             Message header
- * @param list          List of info to store
- * @param cookie        Extra parameters (unused)
- *
- * @return 0 on success, -1 on error (check errno for details).
- */
-static netconf_recv_cb_t neigh_list_cb;
-static int
+/* See netconf_internal.h */
+int
 neigh_list_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
 {
     struct ndmsg       *ndm = NLMSG_DATA(h);
@@ -145,6 +136,9 @@ neigh_list_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
 netconf_list *
 netconf_neigh_dump(netconf_handle nh, unsigned char family)
 {
+    if (nh != NULL && nh->cache != NULL)
+        return netconf_cache_dump(nh, NETCONF_NODE_NEIGH, family);
+
     return netconf_dump_request(nh, RTM_GETNEIGH, family, neigh_list_cb, NULL);
 }
 
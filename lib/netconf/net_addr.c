@@ -8,17 +8,8 @@
 #include "netconf.h"
 #include "netconf_internal.h"
 
-/**
- * Callback of network addresses dump.
- *
- * @param h             Message header
- * @param list          List of info to store
- * @param cookie        Extra parameters (unused)
- *
- * @return 0 on success, -1 on error (check errno for details).
- */
-static netconf_recv_cb_t net_addr_list_cb;
-static int
+/* See netconf_internal.h */
+int
 net_addr_list_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
 {
     struct ifaddrmsg   *ifa = NLMSG_DATA(h);
@@ -88,6 +79,9 @@ net_addr_list_cb(struct nlmsghdr *h, netconf_list *list, void *cookie)
 netconf_list *
 netconf_net_addr_dump(netconf_handle nh, unsigned char family)
 {
+    if (nh != NULL && nh->cache != NULL)
+        return netconf_cache_dump(nh, NETCONF_NODE_NET_ADDR, family);
+
     return netconf_dump_request(nh, RTM_GETADDR, family,
                                 net_addr_list_cb, NULL);
 }
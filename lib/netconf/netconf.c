@@ -112,6 +112,7 @@ netconf_close(netconf_handle nh)
 {
     if ((nh != NULL) && (nh->socket >= 0))
     {
+        netconf_cache_free(nh);
         close(nh->socket);
         nh->socket = -1;
         free(nh);
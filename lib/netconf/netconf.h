@@ -133,6 +133,18 @@ typedef struct netconf_link {
     uint32_t            mtu;            /**< MTU of the device */
 } netconf_link;
 
+/** Statistics of a network device (IFLA_STATS64) */
+typedef struct netconf_link_stats {
+    uint64_t    rx_packets;     /**< Received packets */
+    uint64_t    tx_packets;     /**< Transmitted packets */
+    uint64_t    rx_bytes;       /**< Received bytes */
+    uint64_t    tx_bytes;       /**< Transmitted bytes */
+    uint64_t    rx_errors;      /**< Receive errors */
+    uint64_t    tx_errors;      /**< Transmit errors */
+    uint64_t    rx_dropped;     /**< Packets dropped on receive */
+    uint64_t    tx_dropped;     /**< Packets dropped on transmit */
+} netconf_link_stats;
+
 /** Network address (IPv4 or IPv6) on a device */
 typedef struct netconf_net_addr {
     unsigned char       family;         /**< Address family */
@@ -493,6 +505,19 @@ netconf_list *netconf_link_dump(netconf_handle nh);
 extern te_errno netconf_link_set_ns(netconf_handle nh, const char *ifname,
                                     int32_t fd, pid_t pid);
 
+/**
+ * Get statistics of a network device. Only the device is requested,
+ * so it is much cheaper than a dump of all devices.
+ *
+ * @param nh        Netconf handle
+ * @param ifindex   Interface index
+ * @param stats     Where to save statistics
+ *
+ * @return Status code
+ */
+extern te_errno netconf_link_get_stats(netconf_handle nh, int ifindex,
+                                       netconf_link_stats *stats);
+
 /**
  * Set default values to fields in network address struct.
  *
@@ -691,6 +716,58 @@ void netconf_list_free(netconf_list *list);
  */
 void netconf_close(netconf_handle nh);
 
+/**
+ * Enable cache of network devices, network addresses and neighbour
+ * table entries in the netconf session. The cache is filled by a dump
+ * on the first request and then kept up to date by netlink events
+ * (RTM_NEWLINK, RTM_DELADDR, etc.) received on a socket subscribed
+ * to corresponding multicast groups, so that netconf_link_dump(),
+ * netconf_net_addr_dump(), netconf_neigh_dump() and functions based
+ * on them do not need a netlink dump on every call. If events are
+ * lost (receive buffer overflow), the cache is refilled.
+ *
+ * @param nh            Netconf session handle
+ *
+ * @return 0 on success, -1 on error (check errno for details).
+ */
+int netconf_cache_enable(netconf_handle nh);
+
+/**
+ * Callback reporting a netlink event received by the cache.
+ *
+ * @param node          Decoded event (link, network address or
+ *                      neighbour), or @c NULL if events are lost
+ *                      or cannot be decoded
+ * @param del           @c true if the entity is removed
+ * @param user_data     Data passed to netconf_cache_set_event_cb()
+ */
+typedef void (netconf_cache_event_cb)(const netconf_node *node, bool del,
+                                      void *user_data);
+
+/**
+ * Set a callback to be called for every event received by the cache,
+ * e.g. to track changes made by other processes. Events are received
+ * lazily, when cached data is requested or netconf_cache_update() is
+ * called.
+ *
+ * @param nh            Netconf session handle with enabled cache
+ * @param cb            Callback or @c NULL to remove it
+ * @param user_data     Data to pass to the callback
+ *
+ * @return 0 on success, -1 on error (check errno for details).
+ */
+int netconf_cache_set_event_cb(netconf_handle nh, netconf_cache_event_cb *cb,
+                               void *user_data);
+
+/**
+ * Read pending netlink events and apply them to the cache.
+ *
+ * @param nh            Netconf session handle with enabled cache
+ *
+ * @return 0 on success, -1 on error (check errno for details).
+ */
+int netconf_cache_update(netconf_handle nh);
+
 
 /* These functions get dump of some entity and filter it */
 
@@ -61,17 +61,38 @@ extern "C" {
 #define NETCONF_NLMSG_TAIL(_msg) \
     ((struct rtattr *) (((void *) (_msg)) + NLMSG_ALIGN((_msg)->nlmsg_len)))
 
+/** Cache of network configuration (see cache.c) */
+typedef struct netconf_cache netconf_cache;
+
 /** Netconf handle */
 struct netconf_handle_s {
     int                 socket;         /**< Session socket */
     struct sockaddr_nl  local_addr;     /**< Socket address */
     uint32_t            seq;            /**< Current sequence number */
+    netconf_cache      *cache;          /**< Cache of network devices,
+                                             addresses and neighbours
+                                             or @c NULL */
 };
 
 /** Callback in dump requests */
 typedef int (netconf_recv_cb_t)(struct nlmsghdr *h, netconf_list *list,
                                 void *cookie);
 
+/**
+ * Callback function to decode network device data.
+ */
+extern netconf_recv_cb_t link_list_cb;
+
+/**
+ * Callback function to decode network address data.
+ */
+extern netconf_recv_cb_t net_addr_list_cb;
+
+/**
+ * Callback function to decode neighbour table entry data.
+ */
+extern netconf_recv_cb_t neigh_list_cb;
+
 /**
  * Callback function to decode Geneve link data.
  */
@@ -83,6 +104,29 @@ extern netconf_recv_cb_t geneve_list_cb;
 extern netconf_recv_cb_t vxlan_list_cb;
 
 
+/**
+ * Get list of cached nodes of specified type. Pending netlink
+ * events are applied to the cache before.
+ *
+ * @param nh            Netconf handle with enabled cache
+ * @param type          Type of nodes (@c NETCONF_NODE_LINK,
+ *                      @c NETCONF_NODE_NET_ADDR or @c NETCONF_NODE_NEIGH)
+ * @param family        Address family to filter list
+ *                      (or AF_UNSPEC to get all)
+ *
+ * @return List of information nodes, or NULL in case of error.
+ */
+extern netconf_list *netconf_cache_dump(netconf_handle nh,
+                                        netconf_node_type type,
+                                        unsigned char family);
+
+/**
+ * Release the cache of a netconf handle.
+ *
+ * @param nh            Netconf handle
+ */
+extern void netconf_cache_free(netconf_handle nh);
+
 /**
  * Get nlmsghdr flags to set depending on command.
  *
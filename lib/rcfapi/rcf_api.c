@@ -13,6 +13,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <limits.h>
 
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
@@ -48,6 +49,8 @@
 #include "te_printf.h"
 #include "te_queue.h"
 #include "te_str.h"
+#include "te_string.h"
+#include "te_file.h"
 #include "logger_api.h"
 #include "logger_ten.h"
 #include "rcf_api.h"
@@ -1334,6 +1337,160 @@ rcf_ta_cfg_group(const char *ta_name, int session, te_bool is_start)
     return rc == 0 ? msg.error : rc;
 }
 
+/**
+ * Write items of configuration batch to the file in the format
+ * of the binary attachment of the command.
+ *
+ * @param fd            File descriptor
+ * @param items         Batch items
+ * @param n_items       Number of items
+ *
+ * @return error code
+ */
+static te_errno
+conf_batch_write(int fd, const rcf_cfg_batch_item *items,
+                 unsigned int n_items)
+{
+    te_string    buf = TE_STRING_INIT;
+    unsigned int i;
+    te_errno     rc = 0;
+
+    for (i = 0; i < n_items; i++)
+    {
+        const rcf_cfg_batch_item *item = &items[i];
+        const char               *val = item->val;
+        char                      op;
+
+        switch (item->op)
+        {
+            case RCF_CFG_BATCH_SET: op = TE_PROTO_CONFBATCH_SET; break;
+            case RCF_CFG_BATCH_ADD: op = TE_PROTO_CONFBATCH_ADD; break;
+            case RCF_CFG_BATCH_DEL: op = TE_PROTO_CONFBATCH_DEL; break;
+
+            default:
+                te_string_free(&buf);
+                return TE_RC(TE_RCF_API, TE_EINVAL);
+        }
+
+        if (val == NULL || item->op == RCF_CFG_BATCH_DEL)
+            val = "";
+
+        if (item->oid == NULL || strlen(item->oid) >= RCF_MAX_ID ||
+            strlen(val) >= RCF_MAX_VAL)
+        {
+            te_string_free(&buf);
+            return TE_RC(TE_RCF_API, TE_EINVAL);
+        }
+
+        te_string_append(&buf, "%c%s", op, item->oid);
+        te_string_append_buf(&buf, "", 1);
+        te_string_append(&buf, "%s", val);
+        te_string_append_buf(&buf, "", 1);
+    }
+
+    if (write(fd, buf.ptr, buf.len) != (ssize_t)buf.len)
+        rc = TE_OS_RC(TE_RCF_API, errno);
+
+    te_string_free(&buf);
+    return rc;
+}
+
+/* See description in rcf_api.h */
+te_errno
+rcf_ta_cfg_batch(const char *ta_name, int session,
+                 rcf_cfg_batch_item *items, unsigned int n_items)
+{
+    rcf_msg         msg;
+    size_t          anslen = sizeof(msg);
+    const char     *tmp_dir = getenv("TE_TMP");
+    char           *fname = NULL;
+    unsigned int    done;
+    unsigned int    i;
+    int             fd;
+    te_errno        rc;
+
+    RCF_API_INIT;
+
+    if (items == NULL || n_items == 0 || n_items > INT_MAX || BAD_TA)
+        return TE_RC(TE_RCF_API, TE_EINVAL);
+
+    for (i = 0; i < n_items; i++)
+        items[i].rc = TE_RC(TE_RCF_API, TE_ECANCELED);
+
+    fd = te_file_create_unique_fd(&fname, "%s/te_cfg_batch_", NULL,
+                                  tmp_dir == NULL ? "/tmp" : tmp_dir);
+    if (fd < 0)
+        return TE_OS_RC(TE_RCF_API, errno);
+
+    rc = conf_batch_write(fd, items, n_items);
+    close(fd);
+    if (rc == 0 && strlen(fname) >= sizeof(msg.file))
+        rc = TE_RC(TE_RCF_API, TE_ENAMETOOLONG);
+    if (rc != 0)
+    {
+        unlink(fname);
+        free(fname);
+        return rc;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    te_strlcpy(msg.ta, ta_name, sizeof(msg.ta));
+    te_strlcpy(msg.file, fname, sizeof(msg.file));
+    msg.flags |= BINARY_ATTACHMENT;
+    msg.opcode = RCFOP_CONFBATCH;
+    msg.sid = session;
+    msg.num = n_items;
+
+    rc = send_recv_rcf_ipc_message(ctx_handle, &msg, sizeof(msg),
+                                   &msg, &anslen, NULL);
+    unlink(fname);
+    free(fname);
+    if (rc != 0)
+        return rc;
+
+    if (msg.num < 0)
+    {
+        /* The Test Agent does not know the command */
+        return TE_RC(TE_RCF_API, TE_EOPNOTSUPP);
+    }
+
+    rc = msg.error;
+    /* Nothing is applied if RCF fails the request itself */
+    done = (TE_RC_GET_MODULE(rc) == TE_RCF) ? 0 :
+           MIN((unsigned int)msg.num, n_items);
+    for (i = 0; i < n_items; i++)
+    {
+        rcf_cfg_batch_item *item = &items[i];
+
+        if (i < done)
+            item->rc = 0;
+        else if (i == done)
+            item->rc = rc;
+        else
+            item->rc = TE_RC(TE_RCF_API, TE_ECANCELED);
+
+        if (i > done || !ctx_handle->log_cfg_changes)
+            continue;
+
+        if (item->op == RCF_CFG_BATCH_SET)
+            LOG_MSG(item->rc == 0 ? TE_LL_RING : TE_LL_ERROR,
+                    "Set %s to %s: %r", item->oid,
+                    item->val == NULL ? "" : item->val, item->rc);
+        else if (item->op == RCF_CFG_BATCH_DEL)
+            LOG_MSG(item->rc == 0 ? TE_LL_RING : TE_LL_ERROR,
+                    "Delete %s: %r", item->oid, item->rc);
+        else if (item->val == NULL || strlen(item->val) == 0)
+            LOG_MSG(item->rc == 0 ? TE_LL_RING : TE_LL_ERROR,
+                    "Add %s: %r", item->oid, item->rc);
+        else
+            LOG_MSG(item->rc == 0 ? TE_LL_RING : TE_LL_ERROR,
+                    "Add %s with value %s: %r", item->oid, item->val,
+                    item->rc);
+    }
+
+    return rc;
+}
+
 
 /* See description in rcf_api.h */
 te_errno
@@ -1454,6 +1611,32 @@ rcf_ta_get_log(const char *ta_name, char *log_file)
     return rc;
 }
 
+/* See description in rcf_api.h */
+te_errno
+rcf_ta_log_stream(const char *ta_name, uint16_t port, uint32_t cookie)
+{
+    rcf_msg     msg;
+    size_t      anslen = sizeof(msg);
+    te_errno    rc;
+
+    RCF_API_INIT;
+
+    if (BAD_TA)
+        return TE_RC(TE_RCF_API, TE_EINVAL);
+
+    memset(&msg, 0, sizeof(msg));
+    te_strlcpy(msg.ta, ta_name, sizeof(msg.ta));
+    msg.opcode = RCFOP_LOG_STREAM;
+    msg.sid = RCF_TA_GET_LOG_SID;
+    msg.intparm = port;
+    msg.num = (int)cookie;
+
+    rc = send_recv_rcf_ipc_message(ctx_handle, &msg, sizeof(msg),
+                                   &msg, &anslen, NULL);
+
+    return rc == 0 ? msg.error : rc;
+}
+
 /* See description in rcf_api.h */
 te_errno
 rcf_ta_get_var(const char *ta_name, int session, const char *var_name,
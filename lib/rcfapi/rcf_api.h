@@ -383,6 +383,51 @@ extern te_errno rcf_ta_cfg_del(const char *ta_name, int session,
 extern te_errno rcf_ta_cfg_group(const char *ta_name, int session,
                                  te_bool is_start);
 
+/** Operation of configuration batch item */
+typedef enum rcf_cfg_batch_op {
+    RCF_CFG_BATCH_SET,      /**< Change value of an instance */
+    RCF_CFG_BATCH_ADD,      /**< Add an instance */
+    RCF_CFG_BATCH_DEL,      /**< Delete an instance */
+} rcf_cfg_batch_op;
+
+/** Item of configuration batch */
+typedef struct rcf_cfg_batch_item {
+    rcf_cfg_batch_op    op;     /**< Operation */
+    const char         *oid;    /**< Object instance identifier */
+    const char         *val;    /**< Value (ignored for delete, @c NULL
+                                     means an instance without value) */
+    te_errno            rc;     /**< Status of the item on return */
+} rcf_cfg_batch_item;
+
+/**
+ * Apply a batch of configuration changes by one command in one group
+ * of configuration commands. Items are applied on the Test Agent in
+ * the specified order until the first failure.
+ * The function may be called by Configurator only.
+ *
+ * @param ta_name       Test Agent name
+ * @param session       TA session or 0
+ * @param items         Batch items; status of each item is returned
+ *                      in its @a rc field (@c TE_ECANCELED for items
+ *                      which are not applied due to the earlier failure
+ *                      or failure to send the command)
+ * @param n_items       Number of items
+ *
+ * @return error code
+ *
+ * @retval 0            all items are applied and committed
+ * @retval TE_EIPC      cannot interact with RCF
+ * @retval TE_EOPNOTSUPP the Test Agent does not support batches
+ *                      (no item is applied)
+ * @retval TE_ETADEAD   the Test Agent is dead (no item is applied, as
+ *                      for other errors of RCF itself, e.g. timeout)
+ * @retval other        error returned by the Test Agent for the failed
+ *                      item or for commit of the group
+ */
+extern te_errno rcf_ta_cfg_batch(const char *ta_name, int session,
+                                 rcf_cfg_batch_item *items,
+                                 unsigned int n_items);
+
 /**
  * This function is used to pull out capture logs from the sniffer. The only
  * user of this calls is Logger.
@@ -458,6 +503,27 @@ extern te_errno rcf_ta_get_sniffers(const char *ta_name,
  */
 extern te_errno rcf_ta_get_log(const char *ta_name, char *log_file);
 
+/**
+ * Ask the Test Agent to push its log to Logger over a dedicated
+ * connection (see te_log_stream.h). The agent connects to the address
+ * of the RCF host and the given port asynchronously.
+ * The function may be called by Logger only.
+ *
+ * @param ta_name       Test Agent name
+ * @param port          Port Logger listens on (in host byte order)
+ * @param cookie        Cookie to be presented by the agent
+ *
+ * @return error code
+ *
+ * @retval 0                success
+ * @retval TE_EINVAL        name of non-running TN Test Agent
+ * @retval TE_EIPC          cannot interact with RCF
+ * @retval TE_ETAREBOOTED   Test Agent is rebooted
+ * @retval other            error returned by command handler on the TA
+ */
+extern te_errno rcf_ta_log_stream(const char *ta_name, uint16_t port,
+                                  uint32_t cookie);
+
 /**
  * This function is used to obtain value of the variable from the Test Agent
  * or NUT served by it.
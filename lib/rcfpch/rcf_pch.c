@@ -33,7 +33,7 @@
 #ifdef HAVE_SYS_TIME_H
 #include <sys/time.h>
 #endif
-#if defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD_ATFORK)
+#ifdef HAVE_PTHREAD_H
 #include <pthread.h>
 #endif
 
@@ -44,6 +44,9 @@
 #include "te_defs.h"
 #include "te_stdint.h"
 #include "te_str.h"
+#include "te_alloc.h"
+#include "te_queue.h"
+#include "te_sockaddr.h"
 #include "rcf_common.h"
 #include "rcf_internal.h"
 #include "comm_agent.h"
@@ -58,6 +61,7 @@
 #define RCF_NEED_TYPES
 #include "te_proto.h"
 #undef RCF_NEED_TYPES
+#include "rcf_comm_frame.h"
 
 
 extern te_errno rcf_ch_get_sniffers(struct rcf_comm_connection *handle,
@@ -133,12 +137,72 @@ write_str_in_quotes(char *dst, const char *src, size_t len)
     *p = '\0';
 }
 
+/* See description in rcf_pch_internal.h */
+int
+rcf_pch_answer_str(struct rcf_comm_connection *conn, char *cbuf,
+                   size_t buflen, size_t answer_plen, const char *value)
+{
+    char   *buf = cbuf;
+    size_t  len = answer_plen;
+    size_t  val_len;
+    int     rc;
+
+    if (!rcf_comm_agent_framed(conn))
+    {
+        char val[RCF_MAX_VAL * 2 + 2];
+
+        write_str_in_quotes(val, value, RCF_MAX_VAL);
+        len += snprintf(cbuf + answer_plen, buflen - answer_plen,
+                        "0 %s", val) + 1;
+        if (len > buflen)
+        {
+            ERROR("Answer is truncated");
+            cbuf[buflen - 1] = '\0';
+            len = buflen;
+        }
+    }
+    else
+    {
+        len += snprintf(cbuf + answer_plen, buflen - answer_plen,
+                        "0 " RCF_COMM_FRAME_ARG_REF " args 1") + 1;
+        val_len = strlen(value) + 1;
+        if (len + val_len > buflen)
+        {
+            buf = malloc(len + val_len);
+            if (buf == NULL)
+                return TE_RC(TE_RCF_PCH, TE_ENOMEM);
+            memcpy(buf, cbuf, len);
+        }
+        memcpy(buf + len, value, val_len);
+        len += val_len;
+    }
+
+    RCF_CH_LOCK;
+    rc = rcf_comm_agent_reply(conn, buf, len);
+    RCF_CH_UNLOCK;
+
+    if (buf != cbuf)
+        free(buf);
+
+    return rc;
+}
+
+/** Unquoted arguments of a command received with binary framing */
+typedef struct rcf_pch_args {
+    char       *next;   /**< Next argument to be taken */
+    const char *end;    /**< End of the arguments */
+} rcf_pch_args;
+
 /**
  * Parse the string stripping off quoting and escape symbols.
  * Parsed string is placed instead of old one. Pointer to next token
  * in the command line (or to end symbol). Pointer to the start
  * of parsed string is put to s.
  *
+ * If the command refers to an argument received in a separate element
+ * (binary framing), the argument is returned as is.
+ *
+ * @param args  unquoted arguments of the command or @c NULL
  * @param ptr   location of command pointer
  * @param str   location for parsed string beginning pointer
  *
@@ -146,14 +210,29 @@ write_str_in_quotes(char *dst, const char *src, size_t len)
  * @retval 1    no matching '\"' has been found
  */
 static int
-transform_str(char **ptr, char **str)
+transform_str(rcf_pch_args *args, char **ptr, char **str)
 {
     char   *p = *ptr;
     char   *s;
+    size_t  ref_len = strlen(RCF_COMM_FRAME_ARG_REF);
 
     te_bool quotes = FALSE;
 
     SKIP_SPACES(p);
+
+    if (args != NULL && args->next < args->end &&
+        strncmp(p, RCF_COMM_FRAME_ARG_REF, ref_len) == 0 &&
+        (p[ref_len] == ' ' || p[ref_len] == '\0'))
+    {
+        *str = args->next;
+        args->next += strlen(args->next) + 1;
+
+        p += ref_len;
+        SKIP_SPACES(p);
+        *ptr = p;
+        return 0;
+    }
+
     s = p;
     *str = s;
 
@@ -203,7 +282,7 @@ get_type(char **ptr)
      char *tmp;
      int   i;
 
-     if (transform_str(ptr, &tmp) != 0)
+     if (transform_str(NULL, ptr, &tmp) != 0)
          return RCF_TYPE_TOTAL;
 
      if (*ptr == 0)
@@ -221,6 +300,7 @@ get_type(char **ptr)
  * This routine parses routine parameters provided in the Test Protocol
  * commands start and execute.
  *
+ * @param args          unquoted arguments of the command or @c NULL
  * @param params        parameters string
  * @param is_argv       passing parameters mode location
  * @param argc          argc location
@@ -236,7 +316,8 @@ get_type(char **ptr)
  * and most significant second for little-endian architecture.
  */
 static int
-parse_parameters(char *params, te_bool *is_argv, int *argc, void **param)
+parse_parameters(rcf_pch_args *args, char *params, te_bool *is_argv,
+                 int *argc, void **param)
 {
     char *ptr = params;
     int   n = 0;
@@ -253,7 +334,7 @@ parse_parameters(char *params, te_bool *is_argv, int *argc, void **param)
         SKIP_SPACES(ptr);
         while (*ptr != 0)
         {
-            if (transform_str(&ptr, (char **)(param + n)) != 0)
+            if (transform_str(args, &ptr, (char **)(param + n)) != 0)
                 return TE_EINVAL;
             n++;
         }
@@ -279,7 +360,7 @@ parse_parameters(char *params, te_bool *is_argv, int *argc, void **param)
 
             if (type == RCF_STRING)
             {
-                if (transform_str(&ptr, (char **)(param + n)) != 0)
+                if (transform_str(args, &ptr, (char **)(param + n)) != 0)
                     return TE_EINVAL;
                 VERB("%s(): got string '%s'", __FUNCTION__, param[n]);
                 n++;
@@ -350,7 +431,9 @@ get_opcode(char **ptr, rcf_op_t *opcode)
     TRY_CMD(CONFDEL);
     TRY_CMD(CONFGRP_START);
     TRY_CMD(CONFGRP_END);
+    TRY_CMD(CONFBATCH);
     TRY_CMD(GET_LOG);
+    TRY_CMD(LOG_STREAM);
     TRY_CMD(VREAD);
     TRY_CMD(VWRITE);
     TRY_CMD(FPUT);
@@ -449,26 +532,69 @@ rcf_pch_attach_vfork(void)
 }
 
 
+/** Number of threads executing commands which may run in parallel */
+#define RCF_PCH_PARALLEL_WORKERS    4
+
+/** Command received from the Test Engine */
+typedef struct rcf_pch_job {
+    TAILQ_ENTRY(rcf_pch_job)    links;  /**< Links in the queue */
+
+    struct rcf_comm_connection *conn;   /**< Connection to reply to */
+
+    char       *cmd;            /**< Command buffer (used for answer too) */
+    size_t      buf_len;        /**< Size of the command buffer */
+    size_t      len;            /**< Length of the received command
+                                     including attachment */
+    void       *ba;             /**< Binary attachment pointer */
+
+    int         sid;            /**< Session identifier */
+    size_t      answer_plen;    /**< Length of "SID n " prefix copied
+                                     to the answer */
+    rcf_op_t    opcode;         /**< Operation code */
+    char       *ptr;            /**< Command arguments or @c NULL if
+                                     the command header is malformed */
+    rcf_pch_args args;          /**< Unquoted arguments (binary framing
+                                     only) */
+} rcf_pch_job;
+
 /**
- * Start Portable Command Handler.
- *
- * @param confstr   configuration string for communication library
- * @param info      if not NULL, the string to be send to the engine
- *                  after initialisation
+ * Queue of commands with threads executing them.
  *
- * @return Status code
+ * Commands which access shared state of the agent (configuration tree,
+ * CSAPs, variables, log buffer) are executed by the single thread in
+ * the order of reception. Commands which are self-contained (RPC calls
+ * and file transfers) are executed by a pool of threads, so a long
+ * transfer does not delay configuration requests and vice versa.
+ * The receiving thread only reads commands from the connection, so
+ * RCF may pass the next command before the previous one is answered.
  */
-int
-rcf_pch_run(const char *confstr, const char *info)
-{
-    char *cmd = NULL;
-    int   rc = 0;
-    int   sid = 0;
-    int   cmd_buf_len = RCF_MAX_LEN;
-
-    size_t   answer_plen = 0;
-    rcf_op_t opcode = 0;
-    te_errno rc2;
+typedef struct rcf_pch_workers {
+    pthread_mutex_t             lock;       /**< Queue lock */
+    pthread_cond_t              cond;       /**< Signalled when a command
+                                                 is queued or the threads
+                                                 should stop */
+    TAILQ_HEAD(, rcf_pch_job)   jobs;       /**< Queued commands */
+    te_bool                     stop;       /**< Stop when the queue
+                                                 is empty */
+    te_errno                    rc;         /**< The first communication
+                                                 error */
+    unsigned int                n_threads;  /**< Number of started
+                                                 threads */
+    pthread_t                   threads[RCF_PCH_PARALLEL_WORKERS];
+                                            /**< Started threads */
+} rcf_pch_workers;
+
+/** Executor of commands which must be serialized */
+static rcf_pch_workers serial_workers = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/** Executors of commands which may run in parallel */
+static rcf_pch_workers parallel_workers = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
 
 /**
  * Read any integer parameter from the command.
@@ -509,820 +635,1164 @@ rcf_pch_run(const char *confstr, const char *info)
             goto communication_problem;                             \
     } while (FALSE)
 
-    rcf_pch_init_id(confstr);
+/** Release the command */
+static void
+rcf_pch_job_free(rcf_pch_job *job)
+{
+    if (job == NULL)
+        return;
 
-    VERB("Starting Portable Commands Handler");
+    free(job->cmd);
+    free(job);
+}
 
-    if (rcf_ch_init() != 0)
+/**
+ * Parse session identifier and operation code of the command.
+ *
+ * @param job       Received command
+ *
+ * @return @c 0 on success or @c -1 if the command is malformed.
+ */
+static int
+rcf_pch_job_parse(rcf_pch_job *job)
+{
+    char *ptr = job->cmd;
+
+    job->answer_plen = 0;
+    job->ptr = NULL;
+
+    if (strncmp(ptr, "SID ", strlen("SID ")) == 0)
     {
-        VERB("Initialization of CH library failed");
-        goto exit;
+        ptr += strlen("SID ");
+
+        READ_INT(job->sid);
+
+        job->answer_plen = ptr - job->cmd;
     }
-    rcf_pch_cfg_init();
 
-    rc = rcf_ch_tad_init();
-    if (TE_RC_GET_ERROR(rc) == TE_ENOSYS)
+    if (get_opcode(&ptr, &job->opcode) != 0)
+        goto bad_protocol;
+
+    SKIP_SPACES(ptr);
+    job->ptr = ptr;
+    return 0;
+
+bad_protocol:
+    return -1;
+}
+
+/**
+ * Receive a command from the Test Engine.
+ *
+ * @param handle    Connection handle
+ * @param job       Location for the received command
+ *
+ * @return Status code.
+ */
+static te_errno
+rcf_pch_job_receive(struct rcf_comm_connection *handle, rcf_pch_job **job)
+{
+    rcf_pch_job *j = TE_ALLOC(sizeof(*j));
+    te_errno     rc;
+
+    if (j == NULL)
+        return TE_RC(TE_RCF_PCH, TE_ENOMEM);
+
+    j->conn = handle;
+    j->buf_len = RCF_MAX_LEN;
+    j->cmd = TE_ALLOC(j->buf_len);
+    if (j->cmd == NULL)
     {
-        WARN("Traffic Application Domain operations are not supported");
+        free(j);
+        return TE_RC(TE_RCF_PCH, TE_ENOMEM);
     }
-    else if (rc != 0)
+    j->len = j->buf_len;
+
+    rc = rcf_comm_agent_wait(handle, j->cmd, &j->len, &j->ba);
+    while (TE_RC_GET_ERROR(rc) == TE_ENOBUFS)
     {
-        ERROR("Traffic Application Domain initialization failed: %r", rc);
-        /* Continue, but TAD operation will fail */
-    }
+        /* Command with arguments is longer than the buffer */
+        size_t  buf_len = MAX(j->len, j->buf_len * 2);
+        char   *cmd = realloc(j->cmd, buf_len);
 
-    if ((cmd = (char *)malloc(RCF_MAX_LEN)) == NULL)
-        return TE_RC(TE_RCF_PCH, TE_ENOMEM);
+        if (cmd == NULL)
+        {
+            LOG_PRINT("Failed to allocate %zu bytes for command",
+                      buf_len);
+            rcf_pch_job_free(j);
+            return TE_RC(TE_RCF_PCH, TE_ENOMEM);
+        }
+        j->cmd = cmd;
+        j->buf_len = j->len = buf_len;
 
-    if ((rc = rcf_comm_agent_init(confstr, &conn)) != 0 ||
-        (info != NULL &&
-         (rc = rcf_comm_agent_reply(conn, info, strlen(info) + 1)) != 0))
+        rc = rcf_comm_agent_wait(handle, j->cmd, &j->len, &j->ba);
+    }
+    if (TE_RC_GET_ERROR(rc) == TE_EPENDING)
     {
-        goto communication_problem;
+        size_t  received = j->buf_len;
+        size_t  ba_offset = (j->ba == NULL) ? 0 :
+                                ((uint8_t *)j->ba - (uint8_t *)j->cmd);
+        size_t  tmp;
+        char   *cmd;
+
+        if ((cmd = realloc(j->cmd, j->len)) == NULL)
+        {
+            j->cmd[128] = '\0';
+            LOG_PRINT("Failed to allocate enough memory for command <%s>",
+                      j->cmd);
+            rcf_pch_job_free(j);
+            return TE_RC(TE_RCF_PCH, TE_ENOMEM);
+        }
+        j->cmd = cmd;
+        j->buf_len = j->len;
+        tmp = j->len - received;
+        if (ba_offset > 0)
+            j->ba = (uint8_t *)j->cmd + ba_offset;
+
+        rc = rcf_comm_agent_wait(handle, j->cmd + received, &tmp, NULL);
+        if (rc != 0)
+        {
+            LOG_PRINT("Failed to read binary attachment for command <%s>",
+                      j->cmd);
+        }
     }
 
-#if defined(HAVE_PTHREAD_ATFORK)
-    pthread_atfork(NULL, NULL, rcf_pch_detach);
-#endif
-    register_vfork_hook(rcf_pch_detach_vfork, rcf_pch_attach_vfork,
-                        rcf_pch_detach);
+    if (rc != 0)
+    {
+        rcf_pch_job_free(j);
+        return rc;
+    }
 
-    while (TRUE)
+    if (rcf_comm_agent_framed(handle))
     {
-        size_t   len = cmd_buf_len;
-        char    *ptr;
-        void    *ba;         /* Binary attachment pointer */
+        j->args.next = j->cmd + strlen(j->cmd) + 1;
+        j->args.end = (j->ba != NULL) ? (char *)j->ba : j->cmd + j->len;
+    }
 
-        answer_plen = 0;
+    *job = j;
+    return 0;
+}
 
-        if ((rc = rcf_comm_agent_wait(conn, cmd, &len, &ba)) != 0 &&
-            TE_RC_GET_ERROR(rc) != TE_EPENDING)
-            goto communication_problem;
+/**
+ * Execute the command received from the Test Engine.
+ *
+ * @param job       Received command
+ *
+ * @return @c 0 or error returned by communication library
+ */
+static te_errno
+rcf_pch_job_exec(rcf_pch_job *job)
+{
+    struct rcf_comm_connection *conn = job->conn;
+
+    char       *cmd = job->cmd;
+    size_t      cmd_buf_len = job->buf_len;
+    size_t      answer_plen = job->answer_plen;
+    size_t      len = job->len;
+    void       *ba = job->ba;
+    char       *ptr = job->ptr;
+    int         sid = job->sid;
+    /* Unquoted arguments are used only with binary framing */
+    rcf_pch_args *args = rcf_comm_agent_framed(conn) ? &job->args : NULL;
+    rcf_op_t    opcode = job->opcode;
+    int         rc = 0;
+
+    VERB("Command <%s> is executed", cmd);
+
+    if (ptr == NULL)
+        goto bad_protocol;
+
+    switch (opcode)
+    {
+        case RCFOP_SHUTDOWN:
+            /* Well-formed shutdown is handled by the receiver */
+            goto bad_protocol;
 
-        if (TE_RC_GET_ERROR(rc) == TE_EPENDING)
+        case RCFOP_REBOOT:
         {
-            size_t tmp;
-
-            int received = cmd_buf_len;
-            int ba_offset = (ba == NULL) ? 0 :
-                                ((uint8_t *)ba - (uint8_t *)cmd);
+            char *params = NULL;
 
-            char *old_cmd = cmd;
+            if (*ptr != 0 && transform_str(args, &ptr, &params) != 0)
+                goto bad_protocol;
 
-            if ((cmd = realloc(cmd, len)) == NULL)
+            if (rcf_ch_reboot(conn, cmd, cmd_buf_len, answer_plen,
+                              ba, len, params) < 0)
             {
-                old_cmd[128] = 0;
+                ERROR("Reboot is NOT supported by CH");
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            }
+            break;
+        }
+
+        case RCFOP_CONFGRP_START:
+        case RCFOP_CONFGRP_END:
+        {
+            int op = (opcode == RCFOP_CONFGRP_START) ?
+                         RCF_CH_CFG_GRP_START : RCF_CH_CFG_GRP_END;
 
-                LOG_PRINT("Failed to allocate enough memory for command <%s>",
-                      old_cmd);
+            if (*ptr != 0)
+                goto bad_protocol;
 
-                free(old_cmd);
-                return -1;
-            }
-            cmd_buf_len = len;
-            tmp = len - received;
-            if (ba_offset > 0)
-                ba = (uint8_t *)cmd + ba_offset;
+            rc = rcf_ch_configure(conn, cmd, cmd_buf_len, answer_plen,
+                                  ba, len, op, NULL, NULL);
 
-            if ((rc = rcf_comm_agent_wait(conn, cmd + received,
-                                          &tmp, NULL)) != 0)
-            {
-                LOG_PRINT("Failed to read binary attachment for command <%s>",
-                      cmd);
+            if (rc < 0)
+                rc = rcf_pch_configure(conn, cmd, cmd_buf_len,
+                                       answer_plen, ba, len,
+                                       op, NULL, NULL);
+
+            if (rc != 0)
                 goto communication_problem;
-            }
+            break;
         }
-        VERB("Command <%s> is received", cmd);
 
-        ptr = cmd;
-        /* Skipping SID */
-        if (strncmp(ptr, "SID ", strlen("SID ")) == 0)
+        case RCFOP_CONFBATCH:
         {
-            ptr += strlen("SID ");
+            int n_items;
 
-            READ_INT(sid);
+            if (*ptr == 0 || ba == NULL)
+                goto bad_protocol;
 
-            answer_plen = ptr - cmd;
-        }
+            READ_INT(n_items);
+            if (*ptr != 0 || n_items <= 0)
+                goto bad_protocol;
 
-        if (get_opcode(&ptr, &opcode) != 0)
-            goto bad_protocol;
+            rc = rcf_pch_configure_batch(conn, cmd, cmd_buf_len,
+                                         answer_plen, ba, len, n_items);
+            if (rc != 0)
+                goto communication_problem;
+            break;
+        }
 
-        SKIP_SPACES(ptr);
-        switch (opcode)
+        case RCFOP_CONFGET:
+        case RCFOP_CONFSET:
+        case RCFOP_CONFADD:
+        case RCFOP_CONFDEL:
         {
-            case RCFOP_SHUTDOWN:
-                if (*ptr != 0 || ba != NULL)
-                    goto bad_protocol;
+            int op = opcode == RCFOP_CONFGET ? RCF_CH_CFG_GET :
+                     opcode == RCFOP_CONFSET ? RCF_CH_CFG_SET :
+                     opcode == RCFOP_CONFADD ? RCF_CH_CFG_ADD :
+                     RCF_CH_CFG_DEL;
+            char *oid,
+                 *val = NULL;
 
-                goto exit;
-                break;
+            if (*ptr == 0 || transform_str(args, &ptr, &oid) != 0)
+                goto bad_protocol;
 
-            case RCFOP_REBOOT:
+            if (opcode == RCFOP_CONFGET || opcode == RCFOP_CONFDEL)
             {
-                char *params = NULL;
-
-                if (*ptr != 0 && transform_str(&ptr, &params) != 0)
+                if (*ptr != 0)
                     goto bad_protocol;
-
-                if (rcf_ch_reboot(conn, cmd, cmd_buf_len, answer_plen,
-                                  ba, len, params) < 0)
-                {
-                    ERROR("Reboot is NOT supported by CH");
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
-                }
-                break;
             }
-
-            case RCFOP_CONFGRP_START:
-            case RCFOP_CONFGRP_END:
+            else if (*ptr == 0 && ba == NULL)
             {
-                int op = (opcode == RCFOP_CONFGRP_START) ?
-                             RCF_CH_CFG_GRP_START : RCF_CH_CFG_GRP_END;
-
-                if (*ptr != 0)
+                if (opcode != RCFOP_CONFADD)
                     goto bad_protocol;
 
-                rc = rcf_ch_configure(conn, cmd, cmd_buf_len, answer_plen,
-                                      ba, len, op, NULL, NULL);
-
-                if (rc < 0)
-                    rc = rcf_pch_configure(conn, cmd, cmd_buf_len,
-                                           answer_plen, ba, len,
-                                           op, NULL, NULL);
-
-                if (rc != 0)
-                    goto communication_problem;
-                break;
+                val = "";
             }
-
-            case RCFOP_CONFGET:
-            case RCFOP_CONFSET:
-            case RCFOP_CONFADD:
-            case RCFOP_CONFDEL:
+            else
             {
-                int op = opcode == RCFOP_CONFGET ? RCF_CH_CFG_GET :
-                         opcode == RCFOP_CONFSET ? RCF_CH_CFG_SET :
-                         opcode == RCFOP_CONFADD ? RCF_CH_CFG_ADD :
-                         RCF_CH_CFG_DEL;
-                char *oid,
-                     *val = NULL;
-
-                if (*ptr == 0 || transform_str(&ptr, &oid) != 0)
+                if (ba == NULL &&
+                    (transform_str(args, &ptr, &val) != 0 || *ptr != 0))
                     goto bad_protocol;
+            }
 
-                if (opcode == RCFOP_CONFGET || opcode == RCFOP_CONFDEL)
-                {
-                    if (*ptr != 0)
-                        goto bad_protocol;
-                }
-                else if (*ptr == 0 && ba == NULL)
-                {
-                    if (opcode != RCFOP_CONFADD)
-                        goto bad_protocol;
+            rc = rcf_ch_configure(conn, cmd, cmd_buf_len, answer_plen,
+                                  ba, len, op, oid, val);
 
-                    val = "";
-                }
-                else
-                {
-                    if (ba == NULL &&
-                        (transform_str(&ptr, &val) != 0 || *ptr != 0))
-                        goto bad_protocol;
-                }
+            if (rc < 0)
+                rc = rcf_pch_configure(conn, cmd, cmd_buf_len,
+                                       answer_plen, ba, len,
+                                       op, oid, val);
 
-                rc = rcf_ch_configure(conn, cmd, cmd_buf_len, answer_plen,
-                                      ba, len, op, oid, val);
+            if (rc != 0)
+                goto communication_problem;
+            break;
+        }
 
-                if (rc < 0)
-                    rc = rcf_pch_configure(conn, cmd, cmd_buf_len,
-                                           answer_plen, ba, len,
-                                           op, oid, val);
+        case RCFOP_GET_SNIF_DUMP:
+         {
+#ifndef WITH_SNIFFERS
+            SEND_ANSWER("%d sniffers off",
+                        TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT));
+            break;
+#endif
+            char       *var;
+            int         rc;
 
-                if (rc != 0)
-                    goto communication_problem;
-                break;
-            }
+            if (*ptr == 0 || ba != NULL ||
+                transform_str(args, &ptr, &var) != 0)
+                goto bad_protocol;
 
-            case RCFOP_GET_SNIF_DUMP:
-             {
-#ifndef WITH_SNIFFERS
+            rc = rcf_ch_get_snif_dump(conn, cmd, cmd_buf_len,
+                                      answer_plen, var);
+            if (rc == TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT))
+            {
                 SEND_ANSWER("%d sniffers off",
                             TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT));
-                break;
-#endif
-                char       *var;
-                int         rc;
+            }
+            break;
+        }
 
-                if (*ptr == 0 || ba != NULL ||
-                    transform_str(&ptr, &var) != 0)
-                    goto bad_protocol;
+        case RCFOP_GET_SNIFFERS:
+        {
+#ifndef WITH_SNIFFERS
+            SEND_ANSWER("%d sniffers off",
+                        TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT));
+            break;
+#endif
+            char       *var;
+            int         rc;
 
-                rc = rcf_ch_get_snif_dump(conn, cmd, cmd_buf_len,
-                                          answer_plen, var);
-                if (rc == TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT))
-                {
-                    SEND_ANSWER("%d sniffers off",
-                                TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT));
-                }
-                break;
-            }
+            if (*ptr == 0 || ba != NULL ||
+                transform_str(args, &ptr, &var) != 0)
+                goto bad_protocol;
 
-            case RCFOP_GET_SNIFFERS:
+            rc = rcf_ch_get_sniffers(conn, cmd, cmd_buf_len,
+                                     answer_plen, var);
+            if (rc == TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT))
             {
-#ifndef WITH_SNIFFERS
                 SEND_ANSWER("%d sniffers off",
                             TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT));
-                break;
-#endif
-                char       *var;
-                int         rc;
+            }
+            break;
+        }
 
-                if (*ptr == 0 || ba != NULL ||
-                    transform_str(&ptr, &var) != 0)
-                    goto bad_protocol;
+        case RCFOP_GET_LOG:
+            if (*ptr != 0 || ba != NULL)
+                goto bad_protocol;
 
-                rc = rcf_ch_get_sniffers(conn, cmd, cmd_buf_len,
-                                         answer_plen, var);
-                if (rc == TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT))
-                {
-                    SEND_ANSWER("%d sniffers off",
-                                TE_RC(TE_RCF_PCH, TE_ENOPROTOOPT));
-                }
-                break;
+            rc = transmit_log(conn, cmd, cmd_buf_len, answer_plen);
+            if (rc != 0)
+                goto communication_problem;
+
+            break;
+
+        case RCFOP_LOG_STREAM:
+        {
+            struct sockaddr_storage addr;
+            socklen_t               addrlen = sizeof(addr);
+            int                     port;
+            unsigned int            cookie;
+
+            if (*ptr == 0 || ba != NULL)
+                goto bad_protocol;
+
+            READ_INT(port);
+            READ_INT(cookie);
+            if (*ptr != 0 || port <= 0 || port > UINT16_MAX)
+                goto bad_protocol;
+
+            /* Logger runs on the same host as RCF */
+            rc = rcf_comm_agent_peer_addr(conn, SA(&addr), &addrlen);
+            if (rc == 0)
+            {
+                te_sockaddr_set_port(SA(&addr), htons(port));
+                rc = ta_log_stream_start(SA(&addr), addrlen, cookie);
             }
 
-            case RCFOP_GET_LOG:
-                if (*ptr != 0 || ba != NULL)
-                    goto bad_protocol;
+            SEND_ANSWER("%d", rc);
+            break;
+        }
 
-                rc = transmit_log(conn, cmd, cmd_buf_len, answer_plen);
-                if (rc != 0)
-                    goto communication_problem;
+        case RCFOP_VREAD:
+        case RCFOP_VWRITE:
+        {
+            char *var;
+            int   type;
 
-                break;
+            if (*ptr == 0 || ba != NULL ||
+                transform_str(args, &ptr, &var) != 0)
+                goto bad_protocol;
 
-            case RCFOP_VREAD:
-            case RCFOP_VWRITE:
+            if (*ptr == 0)
+                type = RCF_STRING;
+            else
             {
-                char *var;
-                int   type;
-
-                if (*ptr == 0 || ba != NULL ||
-                    transform_str(&ptr, &var) != 0)
-                    goto bad_protocol;
+                char *ptr0 = ptr;
 
-                if (*ptr == 0)
+                if ((type = get_type(&ptr0)) == RCF_TYPE_TOTAL)
                     type = RCF_STRING;
                 else
-                {
-                    char *ptr0 = ptr;
+                    ptr = ptr0;
+            }
 
-                    if ((type = get_type(&ptr0)) == RCF_TYPE_TOTAL)
-                        type = RCF_STRING;
-                    else
-                        ptr = ptr0;
-                }
+            if (opcode == RCFOP_VWRITE)
+            {
+                char       *val_string = NULL;
+                uint64_t    val_int = 0;
 
-                if (opcode == RCFOP_VWRITE)
+                if (type == RCF_STRING)
                 {
-                    char       *val_string = NULL;
-                    uint64_t    val_int = 0;
-
-                    if (type == RCF_STRING)
-                    {
-                        if (transform_str(&ptr, &val_string) != 0)
-                            goto bad_protocol;
-                    }
-                    else
-                    {
-                        char *tmp;
-
-                        val_int = strtoll(ptr, &tmp, 10);
-                        if (tmp == ptr || (*tmp != ' ' && *tmp != 0))
-                            goto bad_protocol;
-                        ptr = tmp;
-                        SKIP_SPACES(ptr);
-                    }
-                    if (*ptr != 0)
+                    if (transform_str(args, &ptr, &val_string) != 0)
                         goto bad_protocol;
-
-                    if (type == RCF_STRING)
-                    {
-                        rc = rcf_ch_vwrite(conn, cmd, cmd_buf_len,
-                                           answer_plen, type, var,
-                                           val_string);
-                        if (rc < 0)
-                            rc = rcf_pch_vwrite(conn, cmd, cmd_buf_len,
-                                                answer_plen, type, var,
-                                                val_string);
-                    }
-                    else
-                    {
-                        rc = rcf_ch_vwrite(conn, cmd, cmd_buf_len,
-                                           answer_plen, type, var,
-                                           val_int);
-                        if (rc < 0)
-                            rc = rcf_pch_vwrite(conn, cmd, cmd_buf_len,
-                                                answer_plen, type, var,
-                                                val_int);
-                    }
-                    if (rc != 0)
-                        goto communication_problem;
                 }
                 else
                 {
-                    if (*ptr != 0)
+                    char *tmp;
+
+                    val_int = strtoll(ptr, &tmp, 10);
+                    if (tmp == ptr || (*tmp != ' ' && *tmp != 0))
                         goto bad_protocol;
+                    ptr = tmp;
+                    SKIP_SPACES(ptr);
+                }
+                if (*ptr != 0)
+                    goto bad_protocol;
 
-                    rc = rcf_ch_vread(conn, cmd, cmd_buf_len,
-                                      answer_plen, type, var);
+                if (type == RCF_STRING)
+                {
+                    rc = rcf_ch_vwrite(conn, cmd, cmd_buf_len,
+                                       answer_plen, type, var,
+                                       val_string);
                     if (rc < 0)
-                        rc = rcf_pch_vread(conn, cmd, cmd_buf_len,
-                                           answer_plen, type, var);
-                    if (rc != 0)
-                        goto communication_problem;
+                        rc = rcf_pch_vwrite(conn, cmd, cmd_buf_len,
+                                            answer_plen, type, var,
+                                            val_string);
                 }
-                break;
-            }
-
-            case RCFOP_FPUT:
-            case RCFOP_FGET:
-            case RCFOP_FDEL:
+                else
+                {
+                    rc = rcf_ch_vwrite(conn, cmd, cmd_buf_len,
+                                       answer_plen, type, var,
+                                       val_int);
+                    if (rc < 0)
+                        rc = rcf_pch_vwrite(conn, cmd, cmd_buf_len,
+                                            answer_plen, type, var,
+                                            val_int);
+                }
+                if (rc != 0)
+                    goto communication_problem;
+            }
+            else
             {
-                char *filename;
-                int   put = opcode == RCFOP_FPUT;
-
-                if (*ptr == '\0' ||
-                    transform_str(&ptr, &filename) != 0 ||
-                    *ptr != '\0' ||
-                    (put != (ba != NULL)))
+                if (*ptr != 0)
                     goto bad_protocol;
 
-                rc = rcf_ch_file(conn, cmd, cmd_buf_len, answer_plen,
-                                 ba, len, opcode, filename);
+                rc = rcf_ch_vread(conn, cmd, cmd_buf_len,
+                                  answer_plen, type, var);
                 if (rc < 0)
-                    rc = rcf_pch_file(conn, cmd, cmd_buf_len, answer_plen,
-                                      ba, len, opcode, filename);
-
+                    rc = rcf_pch_vread(conn, cmd, cmd_buf_len,
+                                       answer_plen, type, var);
                 if (rc != 0)
                     goto communication_problem;
-
-                break;
             }
+            break;
+        }
 
-            case RCFOP_CSAP_CREATE:
-            {
-                char *params = NULL;
-                char *stack;
+        case RCFOP_FPUT:
+        case RCFOP_FGET:
+        case RCFOP_FDEL:
+        {
+            char *filename;
+            int   put = opcode == RCFOP_FPUT;
+
+            if (*ptr == '\0' ||
+                transform_str(args, &ptr, &filename) != 0 ||
+                *ptr != '\0' ||
+                (put != (ba != NULL)))
+                goto bad_protocol;
+
+            rc = rcf_ch_file(conn, cmd, cmd_buf_len, answer_plen,
+                             ba, len, opcode, filename);
+            if (rc < 0)
+                rc = rcf_pch_file(conn, cmd, cmd_buf_len, answer_plen,
+                                  ba, len, opcode, filename);
+
+            if (rc != 0)
+                goto communication_problem;
 
-                if (*ptr == 0 || transform_str(&ptr, &stack) != 0)
-                    goto bad_protocol;
+            break;
+        }
 
-                if (ba == NULL)
-                {
-                    if (*ptr == 0 || transform_str(&ptr, &params) != 0 ||
-                        *ptr != 0)
-                        goto bad_protocol;
-                }
-                else
-                {
-                    if (*ptr != 0)
-                        goto bad_protocol;
-                }
+        case RCFOP_CSAP_CREATE:
+        {
+            char *params = NULL;
+            char *stack;
 
-                if (rcf_ch_csap_create(conn, cmd, cmd_buf_len, answer_plen,
-                                       ba, len, stack, params) < 0)
-                {
-                    ERROR("CSAP stack %s (%s) is NOT supported", stack,
-                          params);
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
-                }
-                break;
+            if (*ptr == 0 || transform_str(args, &ptr, &stack) != 0)
+                goto bad_protocol;
+
+            if (ba == NULL)
+            {
+                if (*ptr == 0 || transform_str(args, &ptr, &params) != 0 ||
+                    *ptr != 0)
+                    goto bad_protocol;
+            }
+            else
+            {
+                if (*ptr != 0)
+                    goto bad_protocol;
             }
 
-            case RCFOP_CSAP_PARAM:
+            if (rcf_ch_csap_create(conn, cmd, cmd_buf_len, answer_plen,
+                                   ba, len, stack, params) < 0)
             {
-                int handle;
-                char *var;
+                ERROR("CSAP stack %s (%s) is NOT supported", stack,
+                      params);
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            }
+            break;
+        }
 
-                if (*ptr == 0 || ba != NULL)
-                    goto bad_protocol;
+        case RCFOP_CSAP_PARAM:
+        {
+            int handle;
+            char *var;
 
-                READ_INT(handle);
+            if (*ptr == 0 || ba != NULL)
+                goto bad_protocol;
 
-                if (*ptr == 0 || transform_str(&ptr, &var) != 0 ||
-                    *ptr != 0)
-                    goto bad_protocol;
+            READ_INT(handle);
 
-                if (rcf_ch_csap_param(conn, cmd, cmd_buf_len,
-                                      answer_plen, handle, var) < 0)
-                {
-                    ERROR("CSAP parameter '%s' is NOT supported",
-                                      var);
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
-                }
+            if (*ptr == 0 || transform_str(args, &ptr, &var) != 0 ||
+                *ptr != 0)
+                goto bad_protocol;
 
-                break;
+            if (rcf_ch_csap_param(conn, cmd, cmd_buf_len,
+                                  answer_plen, handle, var) < 0)
+            {
+                ERROR("CSAP parameter '%s' is NOT supported",
+                                  var);
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
             }
 
-            case RCFOP_CSAP_DESTROY:
-            case RCFOP_TRSEND_STOP:
-            case RCFOP_TRRECV_STOP:
-            case RCFOP_TRRECV_WAIT:
-            case RCFOP_TRRECV_GET:
+            break;
+        }
+
+        case RCFOP_CSAP_DESTROY:
+        case RCFOP_TRSEND_STOP:
+        case RCFOP_TRRECV_STOP:
+        case RCFOP_TRRECV_WAIT:
+        case RCFOP_TRRECV_GET:
+        {
+            int (*rtn)(struct rcf_comm_connection *, char *,
+                       size_t, size_t, csap_handle_t) = NULL;
+            int   handle;
+
+            if (*ptr == 0 || ba != NULL)
+                goto bad_protocol;
+
+            READ_INT(handle);
+            if (*ptr != 0)
+                goto bad_protocol;
+
+            switch (opcode)
             {
-                int (*rtn)(struct rcf_comm_connection *, char *,
-                           size_t, size_t, csap_handle_t) = NULL;
-                int   handle;
+                case RCFOP_CSAP_DESTROY:
+                    rtn = rcf_ch_csap_destroy;
+                    break;
 
-                if (*ptr == 0 || ba != NULL)
-                    goto bad_protocol;
+                case RCFOP_TRSEND_STOP:
+                    rtn = rcf_ch_trsend_stop;
+                    break;
 
-                READ_INT(handle);
-                if (*ptr != 0)
-                    goto bad_protocol;
+                case RCFOP_TRRECV_STOP:
+                    rtn = rcf_ch_trrecv_stop;
+                    break;
 
-                switch (opcode)
-                {
-                    case RCFOP_CSAP_DESTROY:
-                        rtn = rcf_ch_csap_destroy;
-                        break;
+                case RCFOP_TRRECV_GET:
+                    rtn = rcf_ch_trrecv_get;
+                    break;
 
-                    case RCFOP_TRSEND_STOP:
-                        rtn = rcf_ch_trsend_stop;
-                        break;
+                case RCFOP_TRRECV_WAIT:
+                    rtn = rcf_ch_trrecv_wait;
+                    break;
 
-                    case RCFOP_TRRECV_STOP:
-                        rtn = rcf_ch_trrecv_stop;
-                        break;
+                default:
+                    assert(FALSE);
+             }
 
-                    case RCFOP_TRRECV_GET:
-                        rtn = rcf_ch_trrecv_get;
-                        break;
+            if (rtn(conn, cmd, cmd_buf_len, answer_plen, handle) < 0)
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
 
-                    case RCFOP_TRRECV_WAIT:
-                        rtn = rcf_ch_trrecv_wait;
-                        break;
+            break;
+        }
 
-                    default:
-                        assert(FALSE);
-                 }
+        case RCFOP_TRPOLL:
+        case RCFOP_TRPOLL_CANCEL:
+        {
+            int (*rtn)(struct rcf_comm_connection *, char *,
+                       size_t, size_t, csap_handle_t, unsigned int);
 
-                if (rtn(conn, cmd, cmd_buf_len, answer_plen, handle) < 0)
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            int   handle;
+            int   intparam;
 
-                break;
-            }
+            if (*ptr == 0 || ba != NULL)
+                goto bad_protocol;
 
-            case RCFOP_TRPOLL:
-            case RCFOP_TRPOLL_CANCEL:
-            {
-                int (*rtn)(struct rcf_comm_connection *, char *,
-                           size_t, size_t, csap_handle_t, unsigned int);
+            READ_INT(handle);
+            READ_INT(intparam);
+            if (*ptr != 0)
+                goto bad_protocol;
 
-                int   handle;
-                int   intparam;
+            switch (opcode)
+            {
+                case RCFOP_TRPOLL:
+                    rtn = rcf_ch_trpoll;
+                    break;
 
-                if (*ptr == 0 || ba != NULL)
-                    goto bad_protocol;
+                case RCFOP_TRPOLL_CANCEL:
+                    rtn = rcf_ch_trpoll_cancel;
+                    break;
 
-                READ_INT(handle);
-                READ_INT(intparam);
-                if (*ptr != 0)
-                    goto bad_protocol;
+                default:
+                    assert(FALSE);
+                    rtn = NULL;
+             }
 
-                switch (opcode)
-                {
-                    case RCFOP_TRPOLL:
-                        rtn = rcf_ch_trpoll;
-                        break;
+            if (rtn(conn, cmd, cmd_buf_len, answer_plen,
+                    handle, intparam) < 0)
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
 
-                    case RCFOP_TRPOLL_CANCEL:
-                        rtn = rcf_ch_trpoll_cancel;
-                        break;
+            break;
+        }
 
-                    default:
-                        assert(FALSE);
-                        rtn = NULL;
-                 }
+        case RCFOP_TRSEND_START:
+        {
+            int handle;
+            int postponed = 0;
 
-                if (rtn(conn, cmd, cmd_buf_len, answer_plen,
-                        handle, intparam) < 0)
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            if (*ptr == 0 || ba == NULL)
+                goto bad_protocol;
 
-                break;
+            READ_INT(handle);
+            if (strcmp_start("postponed", ptr) == 0)
+            {
+                postponed = 1;
+                ptr += strlen("postponed");
+                SKIP_SPACES(ptr);
             }
+            if (*ptr != 0)
+                goto bad_protocol;
 
-            case RCFOP_TRSEND_START:
+            if (rcf_ch_trsend_start(conn, cmd, cmd_buf_len,
+                                    answer_plen, ba, len, handle,
+                                    postponed) < 0)
             {
-                int handle;
-                int postponed = 0;
+                ERROR("rcf_ch_trsend_start() returns - "
+                                  "no support");
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            }
 
-                if (*ptr == 0 || ba == NULL)
-                    goto bad_protocol;
+            break;
+        }
 
-                READ_INT(handle);
-                if (strcmp_start("postponed", ptr) == 0)
-                {
-                    postponed = 1;
-                    ptr += strlen("postponed");
-                    SKIP_SPACES(ptr);
-                }
-                if (*ptr != 0)
-                    goto bad_protocol;
+        case RCFOP_TRRECV_START:
+        {
+            int          handle;
+            int          num = 1;
+            unsigned int timeout = TAD_TIMEOUT_INF;
+            unsigned int mode = 0;
+
+            if (*ptr == 0 || ba == NULL)
+                goto bad_protocol;
+
+            READ_INT(handle);
+            READ_INT(num);
+            READ_INT(timeout);
 
-                if (rcf_ch_trsend_start(conn, cmd, cmd_buf_len,
-                                        answer_plen, ba, len, handle,
-                                        postponed) < 0)
+            if (strncmp(ptr, "results", strlen("results")) == 0)
+            {
+                mode |= RCF_CH_TRRECV_PACKETS;
+                ptr += strlen("results");
+                SKIP_SPACES(ptr);
+                if (strncmp(ptr, "no-payload",
+                            strlen("no-payload")) == 0)
                 {
-                    ERROR("rcf_ch_trsend_start() returns - "
-                                      "no support");
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+                    mode |= RCF_CH_TRRECV_PACKETS_NO_PAYLOAD;
+                    ptr += strlen("no-payload");
+                    SKIP_SPACES(ptr);
                 }
-
-                break;
             }
 
-            case RCFOP_TRRECV_START:
+            if (strncmp(ptr, "seq-match", strlen("seq-match")) == 0)
             {
-                int          handle;
-                int          num = 1;
-                unsigned int timeout = TAD_TIMEOUT_INF;
-                unsigned int mode = 0;
+                mode |= RCF_CH_TRRECV_PACKETS_SEQ_MATCH;
+                ptr += strlen("seq-match");
+                SKIP_SPACES(ptr);
+            }
 
-                if (*ptr == 0 || ba == NULL)
-                    goto bad_protocol;
+            if (strncmp(ptr, "mismatch", strlen("mismatch")) == 0)
+            {
+                mode |= RCF_CH_TRRECV_MISMATCH;
+                ptr += strlen("mismatch");
+                SKIP_SPACES(ptr);
+            }
 
-                READ_INT(handle);
-                READ_INT(num);
-                READ_INT(timeout);
+            if (*ptr != 0)
+                goto bad_protocol;
 
-                if (strncmp(ptr, "results", strlen("results")) == 0)
-                {
-                    mode |= RCF_CH_TRRECV_PACKETS;
-                    ptr += strlen("results");
-                    SKIP_SPACES(ptr);
-                    if (strncmp(ptr, "no-payload",
-                                strlen("no-payload")) == 0)
-                    {
-                        mode |= RCF_CH_TRRECV_PACKETS_NO_PAYLOAD;
-                        ptr += strlen("no-payload");
-                        SKIP_SPACES(ptr);
-                    }
-                }
+            if (rcf_ch_trrecv_start(conn, cmd, cmd_buf_len,
+                                    answer_plen, ba, len, handle,
+                                    num, timeout, mode) < 0)
+            {
+                ERROR("rcf_ch_trrecv_start() returns - no support");
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            }
 
-                if (strncmp(ptr, "seq-match", strlen("seq-match")) == 0)
-                {
-                    mode |= RCF_CH_TRRECV_PACKETS_SEQ_MATCH;
-                    ptr += strlen("seq-match");
-                    SKIP_SPACES(ptr);
-                }
+            break;
+        }
 
-                if (strncmp(ptr, "mismatch", strlen("mismatch")) == 0)
-                {
-                    mode |= RCF_CH_TRRECV_MISMATCH;
-                    ptr += strlen("mismatch");
-                    SKIP_SPACES(ptr);
-                }
+        case RCFOP_TRSEND_RECV:
+        {
+            int             handle;
+            int             timeout;
+            unsigned int    mode = 0;
 
-                if (*ptr != 0)
-                    goto bad_protocol;
+            if (*ptr == 0 || ba == NULL)
+                goto bad_protocol;
 
-                if (rcf_ch_trrecv_start(conn, cmd, cmd_buf_len,
-                                        answer_plen, ba, len, handle,
-                                        num, timeout, mode) < 0)
-                {
-                    ERROR("rcf_ch_trrecv_start() returns - no support");
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
-                }
+            READ_INT(handle);
+            READ_INT(timeout);
 
-                break;
+            if (strcmp_start("results", ptr) == 0)
+            {
+                mode |= RCF_CH_TRRECV_PACKETS;
+                ptr += strlen("results");
+                SKIP_SPACES(ptr);
             }
 
-            case RCFOP_TRSEND_RECV:
+            if (*ptr != 0)
+                goto bad_protocol;
+
+            if (rcf_ch_trsend_recv(conn, cmd, cmd_buf_len,
+                                   answer_plen, ba, len, handle,
+                                   timeout, mode) < 0)
             {
-                int             handle;
-                int             timeout;
-                unsigned int    mode = 0;
+                ERROR("rcf_ch_trsend_recv() returns - no support");
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+            }
 
-                if (*ptr == 0 || ba == NULL)
-                    goto bad_protocol;
+            break;
+        }
 
-                READ_INT(handle);
-                READ_INT(timeout);
+        case RCFOP_EXECUTE:
+        {
+            void    *param[RCF_MAX_PARAMS];
+            char    *rtn;
+            int      argc;
+            te_bool  is_argv;
+            int      priority = -1;
 
-                if (strcmp_start("results", ptr) == 0)
-                {
-                    mode |= RCF_CH_TRRECV_PACKETS;
-                    ptr += strlen("results");
-                    SKIP_SPACES(ptr);
-                }
+            rcf_execute_mode mode;
 
-                if (*ptr != 0)
-                    goto bad_protocol;
+            if (strcmp_start(TE_PROTO_FUNC " ", ptr) == 0)
+            {
+                mode = RCF_FUNC;
+                ptr += strlen(TE_PROTO_FUNC);
+            }
+            else if(strcmp_start(TE_PROTO_THREAD " ", ptr) == 0)
+            {
+                mode = RCF_THREAD;
+                ptr += strlen(TE_PROTO_THREAD);
+            }
+            else if(strcmp_start(TE_PROTO_PROCESS " ", ptr) == 0)
+            {
+                mode = RCF_PROCESS;
+                ptr += strlen(TE_PROTO_PROCESS);
+            }
+            else
+            {
+                goto bad_protocol;
+            }
+            SKIP_SPACES(ptr);
 
-                if (rcf_ch_trsend_recv(conn, cmd, cmd_buf_len,
-                                       answer_plen, ba, len, handle,
-                                       timeout, mode) < 0)
-                {
-                    ERROR("rcf_ch_trsend_recv() returns - no support");
-                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
-                }
+            if (*ptr == 0 || ba != NULL ||
+                transform_str(args, &ptr, &rtn) != 0)
+            {
+                goto bad_protocol;
+            }
 
-                break;
+            if (isdigit(*ptr))
+                READ_INT(priority);
+
+            if (parse_parameters(args, ptr, &is_argv, &argc, param) != 0)
+            {
+                goto bad_protocol;
             }
 
-            case RCFOP_EXECUTE:
+            switch(mode)
             {
-                void    *param[RCF_MAX_PARAMS];
-                char    *rtn;
-                int      argc;
-                te_bool  is_argv;
-                int      priority = -1;
+                case RCF_FUNC:
+                {
+                    rc = rcf_ch_call(conn, cmd, cmd_buf_len,
+                                     answer_plen,
+                                     rtn, is_argv, argc, param);
+                    if (rc < 0)
+                        rc = rcf_pch_call(conn, cmd, cmd_buf_len,
+                                          answer_plen,
+                                          rtn, is_argv, argc, param);
 
-                rcf_execute_mode mode;
+                    if (rc != 0)
+                        goto communication_problem;
 
-                if (strcmp_start(TE_PROTO_FUNC " ", ptr) == 0)
-                {
-                    mode = RCF_FUNC;
-                    ptr += strlen(TE_PROTO_FUNC);
-                }
-                else if(strcmp_start(TE_PROTO_THREAD " ", ptr) == 0)
-                {
-                    mode = RCF_THREAD;
-                    ptr += strlen(TE_PROTO_THREAD);
+                    break;
                 }
-                else if(strcmp_start(TE_PROTO_PROCESS " ", ptr) == 0)
-                {
-                    mode = RCF_PROCESS;
-                    ptr += strlen(TE_PROTO_PROCESS);
-                }
-                else
-                {
-                    goto bad_protocol;
-                }
-                SKIP_SPACES(ptr);
 
-                if (*ptr == 0 || ba != NULL ||
-                    transform_str(&ptr, &rtn) != 0)
+                case RCF_PROCESS:
                 {
-                    goto bad_protocol;
-                }
+                    pid_t pid;
 
-                if (isdigit(*ptr))
-                    READ_INT(priority);
+                    if ((rc = rcf_ch_start_process(&pid, priority,
+                                                   rtn, is_argv,
+                                                   argc, param)) != 0)
+                    {
+                        SEND_ANSWER("%d", rc);
+                    }
+                    else
+                    {
+                        SEND_ANSWER("0 %ld", (long)pid);
+                    }
 
-                if (parse_parameters(ptr, &is_argv, &argc, param) != 0)
-                {
-                    goto bad_protocol;
+                    break;
                 }
 
-                switch(mode)
+                case RCF_THREAD:
                 {
-                    case RCF_FUNC:
-                    {
-                        rc = rcf_ch_call(conn, cmd, cmd_buf_len,
-                                         answer_plen,
-                                         rtn, is_argv, argc, param);
-                        if (rc < 0)
-                            rc = rcf_pch_call(conn, cmd, cmd_buf_len,
-                                              answer_plen,
-                                              rtn, is_argv, argc, param);
-
-                        if (rc != 0)
-                            goto communication_problem;
-
-                        break;
-                    }
+                    int tid;
 
-                    case RCF_PROCESS:
+                    if ((rc = rcf_ch_start_thread(&tid, priority,
+                                                  rtn, is_argv,
+                                                  argc, param)) != 0)
                     {
-                        pid_t pid;
-
-                        if ((rc = rcf_ch_start_process(&pid, priority,
-                                                       rtn, is_argv,
-                                                       argc, param)) != 0)
-                        {
-                            SEND_ANSWER("%d", rc);
-                        }
-                        else
-                        {
-                            SEND_ANSWER("0 %ld", (long)pid);
-                        }
-
-                        break;
+                        SEND_ANSWER("%d", rc);
                     }
-
-                    case RCF_THREAD:
+                    else
                     {
-                        int tid;
-
-                        if ((rc = rcf_ch_start_thread(&tid, priority,
-                                                      rtn, is_argv,
-                                                      argc, param)) != 0)
-                        {
-                            SEND_ANSWER("%d", rc);
-                        }
-                        else
-                        {
-                            SEND_ANSWER("0 %d", tid);
-                        }
-
-                        break;
+                        SEND_ANSWER("0 %d", tid);
                     }
 
-                    default:
-                        SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
+                    break;
                 }
-                break;
+
+                default:
+                    SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EOPNOTSUPP));
             }
+            break;
+        }
 
-            case RCFOP_RPC:
+        case RCFOP_RPC:
+        {
+            char    *server;
+            uint32_t timeout;
+
+            if (*ptr == 0 || transform_str(args, &ptr, &server) != 0)
+                goto bad_protocol;
+
+            READ_INT(timeout);
+
+            if (ba != NULL)
             {
-                char    *server;
-                uint32_t timeout;
+                len -= ((uint8_t *)ba - (uint8_t *)cmd);
+                ptr = (char *)ba;
+            }
+            else
+            {
+                /* XML */
+                char *tmp;
 
-                if (*ptr == 0 || transform_str(&ptr, &server) != 0)
+                if (transform_str(args, &ptr, &tmp) != 0)
                     goto bad_protocol;
+                ptr = tmp;
+                len = strlen(ptr);
+            }
 
-                READ_INT(timeout);
+            rc = rcf_pch_rpc(conn, sid, ptr, len, server, timeout);
 
-                if (ba != NULL)
-                {
-                    len -= ((uint8_t *)ba - (uint8_t *)cmd);
-                    ptr = (char *)ba;
-                }
-                else
-                {
-                    /* XML */
-                    char *tmp;
+            if (rc != 0)
+                 goto communication_problem;
 
-                    if (transform_str(&ptr, &tmp) != 0)
-                        goto bad_protocol;
-                    ptr = tmp;
-                    len = strlen(ptr);
-                }
+            break;
+        }
 
-                rc = rcf_pch_rpc(conn, sid, ptr, len, server, timeout);
+        case RCFOP_KILL:
+        {
+            unsigned int pid;
 
-                if (rc != 0)
-                     goto communication_problem;
+            rcf_execute_mode mode;
 
-                break;
-            }
+            if (*ptr == 0 || ba != NULL)
+                goto bad_protocol;
 
-            case RCFOP_KILL:
+            if(strcmp_start(TE_PROTO_THREAD " ", ptr) == 0)
             {
-                unsigned int pid;
+                mode = RCF_THREAD;
+                ptr += strlen(TE_PROTO_THREAD);
+            }
+            else if(strcmp_start(TE_PROTO_PROCESS " ", ptr) == 0)
+            {
+                mode = RCF_PROCESS;
+                ptr += strlen(TE_PROTO_PROCESS);
+            }
+            else
+            {
+                goto bad_protocol;
+            }
+            SKIP_SPACES(ptr);
 
-                rcf_execute_mode mode;
+            READ_INT(pid);
+            if (*ptr != 0)
+                goto bad_protocol;
 
-                if (*ptr == 0 || ba != NULL)
-                    goto bad_protocol;
+            if (mode == RCF_PROCESS)
+                SEND_ANSWER("%d", rcf_ch_kill_process(pid));
+            else
+                SEND_ANSWER("%d", rcf_ch_kill_thread(pid));
 
-                if(strcmp_start(TE_PROTO_THREAD " ", ptr) == 0)
-                {
-                    mode = RCF_THREAD;
-                    ptr += strlen(TE_PROTO_THREAD);
-                }
-                else if(strcmp_start(TE_PROTO_PROCESS " ", ptr) == 0)
-                {
-                    mode = RCF_PROCESS;
-                    ptr += strlen(TE_PROTO_PROCESS);
-                }
-                else
-                {
-                    goto bad_protocol;
-                }
-                SKIP_SPACES(ptr);
+            break;
+        }
 
-                READ_INT(pid);
-                if (*ptr != 0)
-                    goto bad_protocol;
+        default:
+            assert(FALSE);
+    }
 
-                if (mode == RCF_PROCESS)
-                    SEND_ANSWER("%d", rcf_ch_kill_process(pid));
-                else
-                    SEND_ANSWER("%d", rcf_ch_kill_thread(pid));
+    return 0;
+
+bad_protocol:
+    ERROR("Bad protocol command <%s> is received", cmd);
+    SEND_ANSWER("%d bad command", TE_RC(TE_RCF_PCH, TE_EFMT));
+    return 0;
+
+communication_problem:
+    ERROR("Fatal communication error %r", rc);
+    return rc;
+}
+
+#undef READ_INT
+#undef SEND_ANSWER
+
+/**
+ * Thread executing queued commands.
+ *
+ * @param arg       Queue of commands
+ *
+ * @return @c NULL
+ */
+static void *
+rcf_pch_worker(void *arg)
+{
+    rcf_pch_workers *workers = arg;
+    rcf_pch_job     *job;
+    te_errno         rc;
+
+    pthread_mutex_lock(&workers->lock);
+    while (TRUE)
+    {
+        while ((job = TAILQ_FIRST(&workers->jobs)) == NULL &&
+               !workers->stop)
+            pthread_cond_wait(&workers->cond, &workers->lock);
+
+        if (job == NULL)
+            break;
+
+        TAILQ_REMOVE(&workers->jobs, job, links);
+        pthread_mutex_unlock(&workers->lock);
+
+        rc = rcf_pch_job_exec(job);
+        rcf_pch_job_free(job);
+
+        pthread_mutex_lock(&workers->lock);
+        if (rc != 0 && workers->rc == 0)
+            workers->rc = rc;
+    }
+    pthread_mutex_unlock(&workers->lock);
+
+    return NULL;
+}
+
+/**
+ * Start threads executing commands from the queue.
+ *
+ * @param workers       Queue of commands
+ * @param n_threads     Number of threads
+ *
+ * @return Status code.
+ */
+static te_errno
+rcf_pch_workers_start(rcf_pch_workers *workers, unsigned int n_threads)
+{
+    int rc;
+
+    assert(n_threads <= TE_ARRAY_LEN(workers->threads));
+
+    TAILQ_INIT(&workers->jobs);
+    workers->stop = FALSE;
+    workers->rc = 0;
+
+    for (workers->n_threads = 0; workers->n_threads < n_threads;
+         workers->n_threads++)
+    {
+        rc = pthread_create(&workers->threads[workers->n_threads], NULL,
+                            rcf_pch_worker, workers);
+        if (rc != 0)
+        {
+            ERROR("Failed to create command execution thread: %r",
+                  TE_OS_RC(TE_RCF_PCH, rc));
+            return TE_OS_RC(TE_RCF_PCH, rc);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Wait until all queued commands are executed and stop the threads.
+ *
+ * @param workers       Queue of commands
+ *
+ * @return The first communication error encountered by the threads.
+ */
+static te_errno
+rcf_pch_workers_stop(rcf_pch_workers *workers)
+{
+    unsigned int i;
+
+    pthread_mutex_lock(&workers->lock);
+    workers->stop = TRUE;
+    pthread_cond_broadcast(&workers->cond);
+    pthread_mutex_unlock(&workers->lock);
+
+    for (i = 0; i < workers->n_threads; i++)
+        pthread_join(workers->threads[i], NULL);
+    workers->n_threads = 0;
+
+    return workers->rc;
+}
+
+/**
+ * Pass the command to the threads executing it.
+ *
+ * @param job       Received command
+ *
+ * @return The first communication error encountered by the threads
+ *         executing commands of the same class.
+ */
+static te_errno
+rcf_pch_job_queue(rcf_pch_job *job)
+{
+    rcf_pch_workers *workers = &serial_workers;
+    te_errno         rc;
 
+    if (job->ptr != NULL)
+    {
+        switch (job->opcode)
+        {
+            case RCFOP_RPC:
+            case RCFOP_FPUT:
+            case RCFOP_FGET:
+            case RCFOP_FDEL:
+                workers = &parallel_workers;
                 break;
-            }
 
             default:
-                assert(FALSE);
+                break;
+        }
+    }
+
+    pthread_mutex_lock(&workers->lock);
+    TAILQ_INSERT_TAIL(&workers->jobs, job, links);
+    pthread_cond_signal(&workers->cond);
+    rc = workers->rc;
+    pthread_mutex_unlock(&workers->lock);
+
+    return rc;
+}
+
+/**
+ * Start Portable Command Handler.
+ *
+ * @param confstr   configuration string for communication library
+ * @param info      if not NULL, the string to be send to the engine
+ *                  after initialisation
+ *
+ * @return Status code
+ */
+int
+rcf_pch_run(const char *confstr, const char *info)
+{
+    struct rcf_comm_connection *handle;
+
+    rcf_pch_job *job = NULL;
+    te_bool      shutdown_req = FALSE;
+    int          rc = 0;
+    te_errno     rc2;
+
+    rcf_pch_init_id(confstr);
+
+    VERB("Starting Portable Commands Handler");
+
+    if (rcf_ch_init() != 0)
+    {
+        VERB("Initialization of CH library failed");
+        goto exit;
+    }
+    rcf_pch_cfg_init();
+
+    rc = rcf_ch_tad_init();
+    if (TE_RC_GET_ERROR(rc) == TE_ENOSYS)
+    {
+        WARN("Traffic Application Domain operations are not supported");
+    }
+    else if (rc != 0)
+    {
+        ERROR("Traffic Application Domain initialization failed: %r", rc);
+        /* Continue, but TAD operation will fail */
+    }
+
+    if ((rc = rcf_comm_agent_init(confstr, &conn)) != 0 ||
+        (info != NULL &&
+         (rc = rcf_comm_agent_reply(conn, info, strlen(info) + 1)) != 0))
+    {
+        goto communication_problem;
+    }
+    /*
+     * The global handle is hidden around vfork() done by commands
+     * executed in other threads, so the receiver uses its own copy.
+     */
+    handle = conn;
+
+#if defined(HAVE_PTHREAD_ATFORK)
+    pthread_atfork(NULL, NULL, rcf_pch_detach);
+#endif
+    register_vfork_hook(rcf_pch_detach_vfork, rcf_pch_attach_vfork,
+                        rcf_pch_detach);
+
+    if ((rc = rcf_pch_workers_start(&serial_workers, 1)) != 0 ||
+        (rc = rcf_pch_workers_start(&parallel_workers,
+                                    RCF_PCH_PARALLEL_WORKERS)) != 0)
+        goto exit;
+
+    while (TRUE)
+    {
+        if ((rc = rcf_pch_job_receive(handle, &job)) != 0)
+            goto communication_problem;
+
+        VERB("Command <%s> is received", job->cmd);
+
+        if (rcf_pch_job_parse(job) == 0 && job->opcode == RCFOP_SHUTDOWN &&
+            *job->ptr == '\0' && job->ba == NULL)
+        {
+            shutdown_req = TRUE;
+            break;
         }
-        continue;
 
-    bad_protocol:
-        ERROR("Bad protocol command <%s> is received", cmd);
-        SEND_ANSWER("%d bad command", TE_RC(TE_RCF_PCH, TE_EFMT));
+        rc = rcf_pch_job_queue(job);
+        job = NULL;
+        if (rc != 0)
+            goto communication_problem;
     }
+    goto exit;
 
 communication_problem:
     ERROR("Fatal communication error %r", rc);
     LOG_PRINT("Fatal communication error %s", te_rc_err2str(rc));
 
 exit:
+    /* Answers to the commands in progress are sent before shutdown */
+    rcf_pch_workers_stop(&serial_workers);
+    rcf_pch_workers_stop(&parallel_workers);
+
     rc2 = rcf_ch_tad_shutdown();
     if (rc2 != 0)
     {
@@ -1334,20 +1804,25 @@ exit:
     rcf_ch_conf_fini();
     ta_obj_cleanup();
     rcf_pch_rpc_shutdown();
-    if (opcode == RCFOP_SHUTDOWN &&
-        rcf_ch_shutdown(conn, cmd, cmd_buf_len, answer_plen) < 0)
+    if (shutdown_req &&
+        rcf_ch_shutdown(conn, job->cmd, job->buf_len, job->answer_plen) < 0)
     {
-        SEND_ANSWER("0");
+        te_snprintf(job->cmd + job->answer_plen,
+                    job->buf_len - job->answer_plen, "0");
+        RCF_CH_LOCK;
+        rc2 = rcf_comm_agent_reply(conn, job->cmd, strlen(job->cmd) + 1);
+        RCF_CH_UNLOCK;
+        if (rc2 != 0)
+        {
+            ERROR("Failed to answer shutdown command: %r", rc2);
+            TE_RC_UPDATE(rc, rc2);
+        }
     }
     rcf_comm_agent_close(&conn);
-    free(cmd);
+    rcf_pch_job_free(job);
 
     VERB("Exiting");
     LOG_PRINT("Exiting: %d", rc);
 
     return rc;
-
-#undef READ_INT
-#undef SEND_ANSWER
 }
-
@@ -135,6 +135,32 @@ extern int rcf_pch_configure(struct rcf_comm_connection *conn,
                              rcf_ch_cfg_op_t op,
                              const char *oid, const char *val);
 
+/**
+ * Default handler of configuration batch command. Items of the batch
+ * are set, added or deleted in the specified order until the first
+ * failure in one group of configuration commands (unless the group is
+ * already started). The answer contains status and number of applied
+ * items.
+ *
+ * @param conn          connection handle
+ * @param cbuf          command buffer
+ * @param buflen        length of the command buffer
+ * @param answer_plen   number of bytes in the command buffer to be
+ *                      copied to the answer
+ * @param ba            pointer to location of binary attachment with
+ *                      batch items in the command buffer
+ * @param cmdlen        full length of the command including binary
+ *                      attachment
+ * @param n_items       number of items in the batch
+ *
+ * @return 0 or error returned by communication library
+ */
+extern int rcf_pch_configure_batch(struct rcf_comm_connection *conn,
+                                   char *cbuf, size_t buflen,
+                                   size_t answer_plen,
+                                   const uint8_t *ba, size_t cmdlen,
+                                   unsigned int n_items);
+
 /**
  * Default implementation of agent list accessor.
  * This function complies with rcf_ch_cfg_list prototype.
@@ -306,6 +332,34 @@ extern te_errno rcf_pch_find_node(const char *oid_str,
 extern te_errno rcf_pch_add_node(const char *father,
                                  rcf_pch_cfg_object *node);
 
+/**
+ * Record change of configuration in the journal used by Configurator
+ * for incremental synchronization. Changes made by configure commands
+ * are recorded automatically; this function should be called by
+ * agent code which changes configuration in another way.
+ *
+ * @param oid           Identifier of the changed object instance or
+ *                      @c NULL if it is not known what is changed
+ *                      (Configurator will synchronize the whole agent)
+ */
+extern void rcf_pch_conf_changed(const char *oid);
+
+/**
+ * Function which records configuration changes noticed by agent code
+ * but not reported yet with rcf_pch_conf_changed().
+ */
+typedef void (rcf_pch_conf_flush_changes_cb)(void);
+
+/**
+ * Set the function to be called before configuration changes are
+ * reported to Configurator, e.g. to process pending notifications
+ * about changes made by other processes.
+ *
+ * @param flush         Function or @c NULL
+ */
+extern void rcf_pch_conf_set_flush_changes(
+                            rcf_pch_conf_flush_changes_cb *flush);
+
 /**
  * Delete subtree into the configuration tree.
  *
@@ -458,6 +512,14 @@ extern te_errno rcf_pch_rsrc_check_locks(const char *rsrc_ptrn);
  */
 extern void rcf_pch_rsrc_init(void);
 
+/**
+ * Link configuration tree of the local log buffer
+ * (@c /agent/log_buffer).
+ *
+ * @return Status code.
+ */
+extern te_errno rcf_pch_log_buffer_init(void);
+
 /** Directory for locks creation */
 extern const char *te_lockdir;
 
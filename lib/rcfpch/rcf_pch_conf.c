@@ -11,6 +11,11 @@
 #include "te_config.h"
 
 #include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
 #ifdef STDC_HEADERS
 #include <stdlib.h>
 #include <string.h>
@@ -49,6 +54,7 @@
 #include "comm_agent.h"
 #include "conf_oid.h"
 #include "rcf_common.h"
+#include "te_proto.h"
 #include "rcf_pch.h"
 #include "rcf_ch_api.h"
 #include "te_str.h"
@@ -545,6 +551,51 @@ convert_to_answer(olist *list, char **answer)
     return 0;
 }
 
+/**
+ * Send the answer with the list attached and free the list.
+ *
+ * @param conn            connection handle
+ * @param cbuf            command buffer
+ * @param buflen          length of the command buffer
+ * @param answer_plen     number of bytes in the command buffer
+ *                        to be copied to the answer
+ * @param tmp             list to be attached (memory is allocated
+ *                        using malloc())
+ *
+ * @return 0 or error returned by communication library
+ */
+static te_errno
+send_list_answer(struct rcf_comm_connection *conn, char *cbuf,
+                 size_t buflen, size_t answer_plen, char *tmp)
+{
+    te_errno rc;
+
+    if ((size_t)snprintf(cbuf + answer_plen, buflen - answer_plen,
+                         "0 attach %u",
+                         (unsigned int)(strlen(tmp) + 1)) >=
+            (buflen - answer_plen))
+    {
+        free(tmp);
+        ERROR("Command buffer too small for reply");
+        SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_E2BIG));
+    }
+
+    RCF_CH_LOCK;
+    rc = rcf_comm_agent_reply(conn, cbuf, strlen(cbuf) + 1);
+    VERB("Sent answer to wildcard request '%s' len=%u rc=%d",
+         cbuf,  strlen(cbuf) + 1, rc);
+    if (rc == 0)
+    {
+        rc = rcf_comm_agent_reply(conn, tmp, strlen(tmp) + 1);
+        VERB("Sent binary attachment len=%u rc=%d", strlen(tmp) + 1, rc);
+    }
+    RCF_CH_UNLOCK;
+
+    free(tmp);
+
+    return rc;
+}
+
 /**
  * Process wildcard configure get request.
  *
@@ -591,33 +642,11 @@ process_wildcard(struct rcf_comm_connection *conn, char *cbuf,
     if ((rc != 0 )|| ((rc = convert_to_answer(list, &tmp)) != 0))
         SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, rc));
 
-    if ((size_t)snprintf(cbuf + answer_plen, buflen - answer_plen,
-                         "0 attach %u",
-                         (unsigned int)(strlen(tmp) + 1)) >=
-            (buflen - answer_plen))
-    {
-        free(tmp);
-        ERROR("Command buffer too small for reply");
-        SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_E2BIG));
-    }
-
-    RCF_CH_LOCK;
-    rc = rcf_comm_agent_reply(conn, cbuf, strlen(cbuf) + 1);
-    VERB("Sent answer to wildcard request '%s' len=%u rc=%d",
-         cbuf,  strlen(cbuf) + 1, rc);
-    if (rc == 0)
-    {
-        rc = rcf_comm_agent_reply(conn, tmp, strlen(tmp) + 1);
-        VERB("Sent binary attachment len=%u rc=%d", strlen(tmp) + 1, rc);
-    }
-    RCF_CH_UNLOCK;
-
-    free(tmp);
-
-    return rc;
+    return send_list_answer(conn, cbuf, buflen, answer_plen, tmp);
 }
 
 
+
 /**
  * Find postponed commit operation with specified parameters.
  *
@@ -720,6 +749,192 @@ commit_all_postponed(void)
 }
 
 
+/** Size of the journal of configuration changes */
+#define RCF_PCH_CONF_JOURNAL_SIZE   256
+
+/** Entry of the journal of configuration changes */
+typedef struct rcf_pch_conf_change {
+    uint64_t    gen;    /**< Generation of the change */
+    char       *oid;    /**< Changed instance identifier */
+} rcf_pch_conf_change;
+
+/** Journal of configuration changes indexed by generation */
+static rcf_pch_conf_change conf_journal[RCF_PCH_CONF_JOURNAL_SIZE];
+/** Generation of the last configuration change */
+static uint64_t conf_gen;
+/** All changes after this generation are in the journal */
+static uint64_t conf_journal_start;
+/** Lock protecting the journal */
+static pthread_mutex_t conf_journal_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Function recording pending changes before they are reported */
+static rcf_pch_conf_flush_changes_cb *conf_flush_changes = NULL;
+
+/**
+ * Initialize the journal of configuration changes.
+ *
+ * Generations are started from the current time, so that generations
+ * known by Configurator before the agent restart are not mixed up with
+ * ones of the restarted agent.
+ */
+static void
+conf_journal_init(void)
+{
+    pthread_mutex_lock(&conf_journal_lock);
+    conf_gen = (uint64_t)time(NULL) << 20;
+    conf_journal_start = conf_gen;
+    pthread_mutex_unlock(&conf_journal_lock);
+}
+
+/* See description in rcf_pch.h */
+void
+rcf_pch_conf_changed(const char *oid)
+{
+    rcf_pch_conf_change *change;
+
+    pthread_mutex_lock(&conf_journal_lock);
+
+    conf_gen++;
+    change = &conf_journal[conf_gen % RCF_PCH_CONF_JOURNAL_SIZE];
+    if (change->oid != NULL)
+    {
+        conf_journal_start = change->gen;
+        free(change->oid);
+    }
+
+    change->gen = conf_gen;
+    change->oid = (oid == NULL) ? NULL : strdup(oid);
+    if (change->oid == NULL)
+    {
+        /* The change is lost, so the history is not known anymore */
+        conf_journal_start = conf_gen;
+    }
+
+    pthread_mutex_unlock(&conf_journal_lock);
+}
+
+/* See description in rcf_pch.h */
+void
+rcf_pch_conf_set_flush_changes(rcf_pch_conf_flush_changes_cb *flush)
+{
+    conf_flush_changes = flush;
+}
+
+/**
+ * Get the value of the generation of the last configuration change.
+ *
+ * @param gid       group identifier (unused)
+ * @param oid       full object instance identifier (unused)
+ * @param value     location for the value
+ *
+ * @return Status code
+ */
+static te_errno
+conf_gen_get(unsigned int gid, const char *oid, char *value)
+{
+    UNUSED(gid);
+    UNUSED(oid);
+
+    if (conf_flush_changes != NULL)
+        conf_flush_changes();
+
+    pthread_mutex_lock(&conf_journal_lock);
+    te_snprintf(value, RCF_MAX_VAL, "%" PRIu64, conf_gen);
+    pthread_mutex_unlock(&conf_journal_lock);
+
+    return 0;
+}
+
+/** Generation of the last configuration change node */
+RCF_PCH_CFG_NODE_RO(node_conf_gen, CS_CONF_GEN_SUBID, NULL, NULL,
+                    conf_gen_get);
+
+/**
+ * Check whether the request is a request of configuration changes,
+ * i.e. "/agent:<name>/conf_gen:<generation>/...".
+ *
+ * @param oid       requested identifier
+ * @param since     location for the generation
+ *
+ * @return @c TRUE if it is a request of changes.
+ */
+static te_bool
+is_changes_request(const char *oid, uint64_t *since)
+{
+    const char         *agent = rcf_ch_conf_agent();
+    size_t              len = strlen(agent);
+    char               *end;
+    unsigned long long  val;
+
+    if (strcmp_start("/agent:", oid) != 0)
+        return FALSE;
+    oid += strlen("/agent:");
+
+    if (strncmp(oid, agent, len) != 0)
+        return FALSE;
+    oid += len;
+
+    if (strcmp_start("/" CS_CONF_GEN_SUBID ":", oid) != 0)
+        return FALSE;
+    oid += strlen("/" CS_CONF_GEN_SUBID ":");
+
+    if (!isdigit(*oid))
+        return FALSE;
+
+    errno = 0;
+    val = strtoull(oid, &end, 10);
+    if (errno != 0 || strcmp(end, OID_ETC) != 0)
+        return FALSE;
+
+    *since = val;
+    return TRUE;
+}
+
+/**
+ * Get list of instances changed since the specified generation.
+ *
+ * @param since     generation known by the requester
+ * @param answer    location for the answer string address: the current
+ *                  generation followed by changed instances identifiers
+ *                  (memory is allocated using malloc())
+ *
+ * @return Status code
+ * @retval TE_ENODATA   changes since @p since are not known
+ */
+static te_errno
+conf_journal_get(uint64_t since, char **answer)
+{
+    te_string   str = TE_STRING_INIT;
+    uint64_t    gen;
+    te_errno    rc = 0;
+
+    if (conf_flush_changes != NULL)
+        conf_flush_changes();
+
+    pthread_mutex_lock(&conf_journal_lock);
+
+    if (since < conf_journal_start || since > conf_gen)
+    {
+        rc = TE_ENODATA;
+    }
+    else
+    {
+        te_string_append(&str, "%" PRIu64, conf_gen);
+        for (gen = since + 1; gen <= conf_gen; gen++)
+        {
+            te_string_append(&str, " %s",
+                conf_journal[gen % RCF_PCH_CONF_JOURNAL_SIZE].oid);
+        }
+    }
+
+    pthread_mutex_unlock(&conf_journal_lock);
+
+    if (rc != 0)
+        return rc;
+
+    te_string_move(answer, &str);
+    return 0;
+}
+
 /**
  * Initialize configuration subtree using specified depth for its root.
  *
@@ -750,6 +965,9 @@ rcf_pch_cfg_init(void)
     }
     else if (rcf_pch_conf_root() != NULL)
     {
+        conf_journal_init();
+        rcf_pch_add_node("/agent", &node_conf_gen);
+
         /*
          * Agent root OID has length equal to 2, because of root OID
          * existence with empty subid and name.
@@ -967,6 +1185,155 @@ out:
     return rc;
 }
 
+/** All instance names */
+#define ALL_INST_NAMES \
+    inst_names[0], inst_names[1], inst_names[2], inst_names[3], \
+    inst_names[4], inst_names[5], inst_names[6], inst_names[7], \
+    inst_names[8], inst_names[9]
+
+/**
+ * Find the configuration tree object of the instance.
+ *
+ * @param oid           Object instance identifier without wildcards
+ * @param p_oid         Location for parsed OID (it should be freed
+ *                      by the caller on success)
+ * @param obj           Location for the object
+ * @param inst_names    Array of RCF_MAX_PARAMS instance names to fill in
+ *
+ * @return Status code.
+ */
+static te_errno
+conf_find_obj(const char *oid, cfg_oid **p_oid, rcf_pch_cfg_object **obj,
+              char **inst_names)
+{
+    cfg_inst_subid     *p_ids;
+    rcf_pch_cfg_object *next;
+    unsigned int        i;
+
+    *p_oid = cfg_convert_oid_str(oid);
+    if (*p_oid == NULL)
+    {
+        /* It may be memory allocation failure, but it's unlikely */
+        ERROR("Failed to convert OID string '%s' to structured "
+              "representation", oid);
+        return TE_EFMT;
+    }
+    VERB("Parsed %s ID with %u parts ptr=0x%x",
+         ((*p_oid)->inst) ? "instance" : "object",
+         (*p_oid)->len, (*p_oid)->ids);
+    if (!(*p_oid)->inst)
+    {
+        cfg_free_oid(*p_oid);
+        ERROR("Instance identifier expected");
+        return TE_EINVAL;
+    }
+    if ((*p_oid)->len == 0)
+    {
+        cfg_free_oid(*p_oid);
+        ERROR("Zero length OID");
+        return TE_EINVAL;
+    }
+
+    memset(inst_names, 0, sizeof(*inst_names) * RCF_MAX_PARAMS);
+    p_ids = (cfg_inst_subid *)((*p_oid)->ids);
+
+    for (i = 1, *obj = NULL, next = rcf_pch_conf_root();
+         (i < (*p_oid)->len) && (next != NULL);
+        )
+    {
+        *obj = next;
+        if (strcmp((*obj)->sub_id, p_ids[i].subid) == 0)
+        {
+            if (i == 1)
+            {
+                if (strcmp(p_ids[i].name, rcf_ch_conf_agent()) != 0)
+                {
+                    break;
+                }
+            }
+            else if ((i - 2) < RCF_MAX_PARAMS)
+            {
+                inst_names[i - 2] = p_ids[i].name;
+            }
+            /* Go to the next subid */
+            ++i;
+            next = (*obj)->son;
+        }
+        else
+        {
+            next = (*obj)->brother;
+        }
+    }
+    if (i < (*p_oid)->len)
+    {
+        cfg_free_oid(*p_oid);
+        VERB("Requested OID not found");
+        return TE_ENOENT;
+    }
+
+    return 0;
+}
+
+/**
+ * Set, add or delete the instance and commit the change (or postpone
+ * the commit if a group is started).
+ *
+ * @param op            RCF_CH_CFG_SET, RCF_CH_CFG_ADD or RCF_CH_CFG_DEL
+ * @param oid           Object instance identifier
+ * @param val           Object instance value (unused for delete)
+ * @param p_oid         Parsed OID (it is freed by the function)
+ * @param obj           Configuration tree object of the instance
+ * @param inst_names    Instance names
+ *
+ * @return Status code.
+ */
+static te_errno
+conf_modify(rcf_ch_cfg_op_t op, const char *oid, const char *val,
+            cfg_oid *p_oid, rcf_pch_cfg_object *obj, char **inst_names)
+{
+    rcf_pch_cfg_object *commit_obj;
+    te_errno            rc;
+
+    if (obj == NULL)
+    {
+        cfg_free_oid(p_oid);
+        return TE_ENOENT;
+    }
+
+    commit_obj = (obj->commit_parent != NULL) ? obj->commit_parent : obj;
+
+    switch (op)
+    {
+        case RCF_CH_CFG_SET:
+            rc = (obj->set == NULL) ? TE_EOPNOTSUPP :
+                     (obj->set)(gid, oid, val, ALL_INST_NAMES);
+            break;
+
+        case RCF_CH_CFG_ADD:
+            rc = (obj->add == NULL) ? TE_EOPNOTSUPP :
+                     (obj->add)(gid, oid, val, ALL_INST_NAMES);
+            break;
+
+        case RCF_CH_CFG_DEL:
+            rc = (obj->del == NULL) ? TE_EOPNOTSUPP :
+                     (obj->del)(gid, oid, ALL_INST_NAMES);
+            break;
+
+        default:
+            rc = TE_EINVAL;
+    }
+
+    if ((rc == 0) && (commit_obj->commit != NULL))
+    {
+        rc = commit(commit_obj, &p_oid);
+    }
+    if (rc == 0)
+        rcf_pch_conf_changed(oid);
+    cfg_free_oid(p_oid);
+
+    return rc;
+}
+
 /* See description in rcf_pch.h */
 int
 rcf_pch_configure(struct rcf_comm_connection *conn,
@@ -974,21 +1341,12 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
                   const uint8_t *ba, size_t cmdlen,
                   rcf_ch_cfg_op_t op, const char *oid, const char *val)
 {
-/** All instance names */
-#define ALL_INST_NAMES \
-    inst_names[0], inst_names[1], inst_names[2], inst_names[3], \
-    inst_names[4], inst_names[5], inst_names[6], inst_names[7], \
-    inst_names[8], inst_names[9]
-
     /* Array of instance names */
     char *inst_names[RCF_MAX_PARAMS]; /* 10 */
 
     cfg_oid            *p_oid = NULL;
     cfg_inst_subid     *p_ids;
     rcf_pch_cfg_object *obj = NULL;
-    rcf_pch_cfg_object *next;
-    rcf_pch_cfg_object *commit_obj = NULL;
-    unsigned int        i;
     int                 rc;
 
     UNUSED(ba);
@@ -1000,6 +1358,21 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
 
     if (oid != 0)
     {
+        uint64_t since;
+
+        if (op == RCF_CH_CFG_GET && is_changes_request(oid, &since))
+        {
+            char *changes;
+
+            rc = conf_journal_get(since, &changes);
+            if (rc != 0)
+                SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, rc));
+
+            rc = send_list_answer(conn, cbuf, buflen, answer_plen, changes);
+            EXIT("%r", rc);
+            return rc;
+        }
+
         /* Now parse the oid and look for the object */
         if ((strchr(oid, '*') != NULL) || (strstr(oid, OID_ETC) != NULL))
         {
@@ -1016,73 +1389,10 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
             return rc;
         }
 
-        p_oid = cfg_convert_oid_str(oid);
-        VERB("Parsed %s ID with %u parts ptr=0x%x",
-             (p_oid->inst) ? "instance" : "object",
-             p_oid->len, p_oid->ids);
-        if (p_oid == NULL)
-        {
-            /* It may be memory allocation failure, but it's unlikely */
-            ERROR("Failed to convert OID string '%s' to structured "
-                  "representation", oid);
-            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EFMT));
-        }
-        if (!p_oid->inst)
-        {
-            cfg_free_oid(p_oid);
-            ERROR("Instance identifier expected");
-            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EINVAL));
-        }
-        if (p_oid->len == 0)
-        {
-            cfg_free_oid(p_oid);
-            ERROR("Zero length OID");
-            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_EINVAL));
-        }
-
-        memset(inst_names, 0, sizeof(inst_names));
+        rc = conf_find_obj(oid, &p_oid, &obj, inst_names);
+        if (rc != 0)
+            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, rc));
         p_ids = (cfg_inst_subid *)(p_oid->ids);
-
-        for (i = 1, obj = 0, next = rcf_pch_conf_root();
-             (i < p_oid->len) && (next != NULL);
-            )
-        {
-            obj = next;
-            if (strcmp(obj->sub_id, p_ids[i].subid) == 0)
-            {
-                if (i == 1)
-                {
-                    if (strcmp(p_ids[i].name, rcf_ch_conf_agent()) != 0)
-                    {
-                        break;
-                    }
-                }
-                else if ((i - 2) < (sizeof(inst_names) /
-                                    sizeof(inst_names[0])))
-                {
-                    inst_names[i - 2] = p_ids[i].name;
-                }
-                /* Go to the next subid */
-                ++i;
-                next = obj->son;
-            }
-            else
-            {
-                next = obj->brother;
-            }
-        }
-        if (i < p_oid->len)
-        {
-            cfg_free_oid(p_oid);
-            VERB("Requested OID not found");
-            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, TE_ENOENT));
-        }
-    }
-
-    if (obj != NULL)
-    {
-        commit_obj = (obj->commit_parent != NULL) ?
-                         obj->commit_parent : obj;
     }
 
     if (!is_group)
@@ -1105,7 +1415,6 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
         case RCF_CH_CFG_GET:
         {
             char value[RCF_MAX_VAL] = "";
-            char ret_val[RCF_MAX_VAL * 2 + 2];
 
             if (obj->get == NULL)
             {
@@ -1122,7 +1431,8 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
 
             if (obj->subst != NULL)
             {
-                rc = do_substitutions(obj, value, inst_names[i - 3], p_ids);
+                rc = do_substitutions(obj, value,
+                                      inst_names[p_oid->len - 3], p_ids);
                 if (rc != 0)
                 {
                     ERROR("Failed to replace value in %s rc=%r", value, rc);
@@ -1132,41 +1442,14 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
             }
 
             cfg_free_oid(p_oid);
-            write_str_in_quotes(ret_val, value, RCF_MAX_VAL);
-            SEND_ANSWER("0 %s", ret_val);
+            SEND_ANSWER_STR(value);
             break;
         }
 
         case RCF_CH_CFG_SET:
-            rc = (obj->set == NULL) ? TE_EOPNOTSUPP :
-                     (obj->set)(gid, oid, val, ALL_INST_NAMES);
-            if ((rc == 0) && (commit_obj->commit != NULL))
-            {
-                rc = commit(commit_obj, &p_oid);
-            }
-            cfg_free_oid(p_oid);
-            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, rc));
-            break;
-
         case RCF_CH_CFG_ADD:
-            rc = (obj->add == NULL) ? TE_EOPNOTSUPP :
-                     (obj->add)(gid, oid, val, ALL_INST_NAMES);
-            if ((rc == 0) && (commit_obj->commit != NULL))
-            {
-                rc = commit(commit_obj, &p_oid);
-            }
-            cfg_free_oid(p_oid);
-            SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, rc));
-            break;
-
         case RCF_CH_CFG_DEL:
-            rc = (obj->del == NULL) ? TE_EOPNOTSUPP :
-                     (obj->del)(gid, oid, ALL_INST_NAMES);
-            if ((rc == 0) && (commit_obj->commit != NULL))
-            {
-                rc = commit(commit_obj, &p_oid);
-            }
-            cfg_free_oid(p_oid);
+            rc = conf_modify(op, oid, val, p_oid, obj, inst_names);
             SEND_ANSWER("%d", TE_RC(TE_RCF_PCH, rc));
             break;
 
@@ -1179,8 +1462,104 @@ rcf_pch_configure(struct rcf_comm_connection *conn,
     /* Unreachable */
     assert(FALSE);
     return 0;
+}
 
-#undef ALL_INST_NAMES
+/* See description in rcf_pch.h */
+int
+rcf_pch_configure_batch(struct rcf_comm_connection *conn,
+                        char *cbuf, size_t buflen, size_t answer_plen,
+                        const uint8_t *ba, size_t cmdlen,
+                        unsigned int n_items)
+{
+    char               *inst_names[RCF_MAX_PARAMS];
+    const char         *ptr = (const char *)ba;
+    const char         *end = cbuf + cmdlen;
+    te_bool             own_group = !is_group;
+    unsigned int        done;
+    te_errno            rc = 0;
+    te_errno            rc_commit;
+
+    ENTRY("n_items=%u", n_items);
+
+    if (own_group)
+    {
+        ++gid;
+        is_group = TRUE;
+        VERB("Configuration group %u start", gid);
+    }
+
+    for (done = 0; done < n_items; done++)
+    {
+        rcf_ch_cfg_op_t     op;
+        const char         *oid;
+        const char         *oid_end;
+        const char         *val;
+        const char         *val_end;
+        cfg_oid            *p_oid;
+        rcf_pch_cfg_object *obj;
+
+        oid_end = (end - ptr < 3) ? NULL :
+                      memchr(ptr + 1, '\0', end - ptr - 1);
+        val_end = (oid_end == NULL) ? NULL :
+                      memchr(oid_end + 1, '\0', end - oid_end - 1);
+        if (val_end == NULL)
+        {
+            ERROR("Truncated configuration batch item %u", done);
+            rc = TE_EFMT;
+            break;
+        }
+
+        switch (*ptr)
+        {
+            case TE_PROTO_CONFBATCH_SET: op = RCF_CH_CFG_SET; break;
+            case TE_PROTO_CONFBATCH_ADD: op = RCF_CH_CFG_ADD; break;
+            case TE_PROTO_CONFBATCH_DEL: op = RCF_CH_CFG_DEL; break;
+
+            default:
+                ERROR("Unknown operation '%c' in configuration batch",
+                      *ptr);
+                rc = TE_EFMT;
+                break;
+        }
+        if (rc != 0)
+            break;
+
+        oid = ptr + 1;
+        val = oid_end + 1;
+        ptr = val_end + 1;
+
+        VERB("Batch item %u: op=%d id='%s' val='%s'", done, op, oid, val);
+
+        if (strchr(oid, '*') != NULL || strstr(oid, OID_ETC) != NULL)
+        {
+            ERROR("Wildcards allowed in get requests only");
+            rc = TE_EINVAL;
+            break;
+        }
+
+        rc = conf_find_obj(oid, &p_oid, &obj, inst_names);
+        if (rc != 0)
+            break;
+
+        rc = conf_modify(op, oid, val, p_oid, obj, inst_names);
+        if (rc != 0)
+            break;
+    }
+
+    if (own_group)
+    {
+        VERB("Configuration group %u end", gid);
+        is_group = FALSE;
+        rc_commit = commit_all_postponed();
+        if (rc == 0)
+            rc = rc_commit;
+    }
+
+    SEND_ANSWER("%d %u", TE_RC(TE_RCF_PCH, rc), done);
+
+    /* Unreachable */
+    assert(FALSE);
+    return 0;
 }
 
 /* See description in rcf_pch.h */
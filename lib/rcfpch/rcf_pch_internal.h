@@ -88,6 +88,41 @@ extern "C" {
  */
 extern void write_str_in_quotes(char *dst, const char *src, size_t len);
 
+/**
+ * Send successful answer with a string value to the TEN. The value is
+ * quoted in text mode and passed as is in a separate element with
+ * binary framing.
+ *
+ * @param conn          connection handle
+ * @param cbuf          command buffer
+ * @param buflen        length of the command buffer
+ * @param answer_plen   number of bytes in the command buffer to be
+ *                      copied to the answer
+ * @param value         string value (up to @c RCF_MAX_VAL symbols
+ *                      are sent in text mode)
+ *
+ * @return Status code returned by rcf_comm_agent_reply().
+ */
+extern int rcf_pch_answer_str(struct rcf_comm_connection *conn,
+                              char *cbuf, size_t buflen,
+                              size_t answer_plen, const char *value);
+
+/**
+ * Send successful answer with a string value to the TEN and return
+ * (see SEND_ANSWER()).
+ *
+ * @param _value    string value
+ */
+#define SEND_ANSWER_STR(_value) \
+    do {                                                        \
+        int _rc;                                                \
+                                                                \
+        _rc = rcf_pch_answer_str(conn, cbuf, buflen,            \
+                                 answer_plen, (_value));        \
+        EXIT("%d", _rc);                                        \
+        return _rc;                                             \
+    } while (FALSE)
+
 /*
  * When ANSI C compiler mode is enabled, the following functions are
  * missing in standard headers 'string.h' and 'stdlib.h'.
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief RCF Portable Command Handler
+ *
+ * Configuration nodes of the Test Agent local log buffer.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "RCF PCH"
+
+#include "te_config.h"
+
+#include <stdio.h>
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#endif
+
+#include "te_errno.h"
+#include "te_defs.h"
+#include "te_stdint.h"
+#include "te_str.h"
+#include "logger_api.h"
+#include "logger_ta.h"
+#include "rcf_common.h"
+#include "rcf_pch.h"
+#include "rcf_ch_api.h"
+
+/**
+ * Get the size of memory allocated for the local log buffer.
+ *
+ * @param gid       Group identifier (unused)
+ * @param oid       Full object instance identifier (unused)
+ * @param value     Location for the value
+ *
+ * @return Status code.
+ */
+static te_errno
+log_buffer_size_get(unsigned int gid, const char *oid, char *value)
+{
+    ta_log_buffer_stats stats;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    ta_log_buffer_get_stats(&stats);
+    te_snprintf(value, RCF_MAX_VAL, "%zu", stats.size);
+
+    return 0;
+}
+
+/**
+ * Get the limit of memory used by the local log buffer.
+ *
+ * @param gid       Group identifier (unused)
+ * @param oid       Full object instance identifier (unused)
+ * @param value     Location for the value
+ *
+ * @return Status code.
+ */
+static te_errno
+log_buffer_max_get(unsigned int gid, const char *oid, char *value)
+{
+    ta_log_buffer_stats stats;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    ta_log_buffer_get_stats(&stats);
+    te_snprintf(value, RCF_MAX_VAL, "%zu", stats.max);
+
+    return 0;
+}
+
+/**
+ * Change the limit of memory used by the local log buffer.
+ *
+ * @param gid       Group identifier (unused)
+ * @param oid       Full object instance identifier (unused)
+ * @param value     New value
+ *
+ * @return Status code.
+ */
+static te_errno
+log_buffer_max_set(unsigned int gid, const char *oid, const char *value)
+{
+    size_t      max;
+    te_errno    rc;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    rc = te_strtou_size(value, 0, &max, sizeof(max));
+    if (rc != 0)
+        return TE_RC(TE_RCF_PCH, rc);
+
+    rc = ta_log_buffer_set_max(max);
+    return rc == 0 ? 0 : TE_RC(TE_RCF_PCH, TE_RC_GET_ERROR(rc));
+}
+
+/**
+ * Get the number of messages dropped because the local log buffer
+ * was full.
+ *
+ * @param gid       Group identifier (unused)
+ * @param oid       Full object instance identifier (unused)
+ * @param value     Location for the value
+ *
+ * @return Status code.
+ */
+static te_errno
+log_buffer_dropped_get(unsigned int gid, const char *oid, char *value)
+{
+    ta_log_buffer_stats stats;
+
+    UNUSED(gid);
+    UNUSED(oid);
+
+    ta_log_buffer_get_stats(&stats);
+    te_snprintf(value, RCF_MAX_VAL, "%" PRIu64, stats.dropped);
+
+    return 0;
+}
+
+RCF_PCH_CFG_NODE_RO(node_log_buffer_dropped, "dropped", NULL, NULL,
+                    log_buffer_dropped_get);
+
+RCF_PCH_CFG_NODE_RW(node_log_buffer_max, "max", NULL,
+                    &node_log_buffer_dropped,
+                    log_buffer_max_get, log_buffer_max_set);
+
+RCF_PCH_CFG_NODE_RO(node_log_buffer_size, "size", NULL,
+                    &node_log_buffer_max, log_buffer_size_get);
+
+RCF_PCH_CFG_NODE_NA(node_log_buffer, "log_buffer",
+                    &node_log_buffer_size, NULL);
+
+/* See description in rcf_pch.h */
+te_errno
+rcf_pch_log_buffer_init(void)
+{
+    return rcf_pch_add_node("/agent", &node_log_buffer);
+}
@@ -82,10 +82,7 @@ rcf_pch_vread(struct rcf_comm_connection *conn,
             {
                 if (strlen(env_val) < RCF_MAX_VAL)
                 {
-                    char  val[RCF_MAX_VAL * 2 + 2];
-
-                    write_str_in_quotes(val, env_val, RCF_MAX_VAL);
-                    SEND_ANSWER("0 %s", val);
+                    SEND_ANSWER_STR(env_val);
                 }
                 else
                 {
@@ -170,10 +167,7 @@ rcf_pch_vread(struct rcf_comm_connection *conn,
         case RCF_STRING:
             if (strlen(*(char **)addr) < RCF_MAX_VAL)
             {
-                char val[RCF_MAX_VAL * 2 + 2];
-
-                write_str_in_quotes(val, *(char **)addr, RCF_MAX_VAL);
-                SEND_ANSWER("0 %s", val);
+                SEND_ANSWER_STR(*(char **)addr);
             }
             else
             {
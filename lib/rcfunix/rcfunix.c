@@ -29,6 +29,9 @@
  * [:@attr_name{copy_timeout}=@attr_val{<timeout>}]
  * [:@attr_name{copy_tries}=@attr_val{<number_of_tries>}]
  * [:@attr_name{kill_timeout}=@attr_val{<timeout>}]
+ * [:@attr_name{framing}=@attr_val{binary|text}]
+ * [:@attr_name{log_buffer_size}=@attr_val{<bytes>}]
+ * [:@attr_name{log_buffer_max}=@attr_val{<bytes>}]
  * [:@attr_val{sudo}][:@attr_val{<shell>}][:@attr_val{<parameters>}]
  * </pre>
  *
@@ -61,6 +64,16 @@
  *   start-up procedure fails;
  * - @attr_name{kill_timeout} - specifies the maximum time duration
  *   (in seconds) that is allowed for Test Agent termination procedure;
+ * - @attr_name{framing} - @c binary (default) to use binary framing of
+ *   RCF protocol if the Test Agent supports it or @c text to always use
+ *   text protocol; with binary framing RCF also passes commands to the
+ *   agent without waiting for answers to the previous ones and passes
+ *   string arguments unquoted in separate elements;
+ * - @attr_name{log_buffer_size} - initial size (in bytes) of the Test
+ *   Agent local log buffer;
+ * - @attr_name{log_buffer_max} - maximum size (in bytes) the Test Agent
+ *   local log buffer may grow to when Logger lags behind, @c 0 disables
+ *   growth;
  * - @attr_val{sudo} - specify this option when we need to run agent under
  *   @prog{sudo} (with root privileges). This can be necessary if Test Agent
  *   access resources that require privileged permissions (for example
@@ -277,6 +290,8 @@ typedef struct unix_ta {
                                     is created in another network
                                     namespace to which RCF cannot
                                     connect. */
+    te_bool text_proto; /**< Do not try to negotiate binary framing
+                             of RCF protocol */
 
     te_string   ssh_opts;     /**< SSH options common for ssh and sftp */
 
@@ -952,6 +967,19 @@ rcfunix_start(const char *ta_name, const char *ta_type,
         ta->ext_rcf_listener = TRUE;
     }
 
+    if (!te_str_is_null_or_empty(val = te_kvpairs_get(conf, "framing")))
+    {
+        if (strcmp(val, "text") == 0)
+        {
+            ta->text_proto = TRUE;
+        }
+        else if (strcmp(val, "binary") != 0)
+        {
+            ERROR("Unknown framing '%s'", val);
+            goto bad_conf;
+        }
+    }
+
     shell = te_kvpairs_get(conf, "shell");
 
     /*
@@ -1186,6 +1214,17 @@ rcfunix_start(const char *ta_name, const char *ta_type,
     if (rc == 0 && !te_str_is_null_or_empty(ld_preload))
         rc = te_string_append(&cmd, "LD_PRELOAD=%s ", ld_preload);
 
+    /*
+     * Size and growth limit of the local log buffer
+     * (see TA_LOG_BUFFER_SIZE_ENV and TA_LOG_BUFFER_MAX_ENV)
+     */
+    val = te_kvpairs_get(conf, "log_buffer_size");
+    if (rc == 0 && !te_str_is_null_or_empty(val))
+        rc = te_string_append(&cmd, "TE_TA_LOG_BUFFER_SIZE=%s ", val);
+    val = te_kvpairs_get(conf, "log_buffer_max");
+    if (rc == 0 && !te_str_is_null_or_empty(val))
+        rc = te_string_append(&cmd, "TE_TA_LOG_BUFFER_MAX=%s ", val);
+
     if (rc == 0 && ta->ext_rcf_listener)
     {
         rc = te_string_append(&cmd, "%s/ta_rcf_listener %s ", ta->run_dir,
@@ -1386,16 +1425,13 @@ done:
  * Close all interactions with TA.
  *
  * @param handle        TA handle
- * @param select_set    FD_SET to be updated with the TA connection file
- *                      descriptor (for Test Agents supporting listening
- *                      mode) (IN/OUT)
  *
  * @return Error code.
  */
 static te_errno
-rcfunix_close(rcf_talib_handle handle, fd_set *select_set)
+rcfunix_close(rcf_talib_handle handle)
 {
-    return rcf_net_engine_close(&(((unix_ta *)handle)->conn), select_set);
+    return rcf_net_engine_close(&(((unix_ta *)handle)->conn));
 }
 
 /**
@@ -1404,20 +1440,12 @@ rcfunix_close(rcf_talib_handle handle, fd_set *select_set)
  * the NUT, which it serves.
  *
  * @param handle        TA handle
- * @param select_set    FD_SET to be updated with the TA connection file
- *                      descriptor (for Test Agents supporting listening
- *                      mode) (IN/OUT)
- *
- * @param select_tm     Timeout value for the select to be updated with
- *                      TA polling interval (for Test Agents supporting
- *                      polling mode only)
- *                      (IN/OUT)
+ * @param fd            Location for the TA connection file descriptor
  *
  * @return Error code.
  */
 static te_errno
-rcfunix_connect(rcf_talib_handle handle, fd_set *select_set,
-                struct timeval *select_tm)
+rcfunix_connect(rcf_talib_handle handle, int *fd)
 {
     unix_ta    *ta = (unix_ta *)handle;
     te_errno    rc;
@@ -1434,8 +1462,6 @@ rcfunix_connect(rcf_talib_handle handle, fd_set *select_set,
     char                *ta_list_fn;
     FILE                *ta_list_f = NULL;
 
-    (void)select_tm;
-
 #define TA_LIST_F_ERROR \
     do {                                          \
         if (ta_list_f != NULL)                    \
@@ -1470,14 +1496,14 @@ rcfunix_connect(rcf_talib_handle handle, fd_set *select_set,
     VERB("Connecting to TA '%s'", ta->ta_name);
 
     do {
-        rc = rcf_net_engine_connect(host, ta->port, &ta->conn, select_set);
+        rc = rcf_net_engine_connect(host, ta->port, &ta->conn);
         if (rc == 0)
         {
             rc = rcf_net_engine_receive(ta->conn, buf, &len, &tmp);
             if (rc == 0)
                 break;
 
-            (void)rcf_net_engine_close(&ta->conn, select_set);
+            (void)rcf_net_engine_close(&ta->conn);
             if (rc != TE_OS_RC(TE_COMM, EPIPE))
             {
                 ERROR("Cannot read TA PID from the TA %s (error %r)",
@@ -1512,6 +1538,29 @@ rcfunix_connect(rcf_talib_handle handle, fd_set *select_set,
     }
 
     INFO("PID of TA %s is %d", ta->ta_name, ta->pid);
+
+    *(ta->flags) &= ~(TA_PIPELINE | TA_FRAMED);
+    if (!ta->text_proto)
+    {
+        rc = rcf_net_engine_set_framing(ta->conn);
+        if (rc == 0)
+        {
+            INFO("Binary framing is used with TA %s", ta->ta_name);
+            *(ta->flags) |= TA_PIPELINE | TA_FRAMED;
+        }
+        else if (rc == TE_RC(TE_COMM, TE_EOPNOTSUPP))
+        {
+            RING("TA %s does not support binary framing, "
+                 "text protocol is used", ta->ta_name);
+        }
+        else
+        {
+            ERROR("Failed to negotiate framing with TA %s: %r",
+                  ta->ta_name, rc);
+            TA_LIST_F_ERROR;
+            return rc;
+        }
+    }
     if (ta_list_f != NULL)
     {
         fprintf(ta_list_f, "\t\t%lu\n", (long unsigned int)ta->pid);
@@ -1519,6 +1568,8 @@ rcfunix_connect(rcf_talib_handle handle, fd_set *select_set,
         ta_list_f = NULL;
     }
 
+    *fd = rcf_net_engine_get_fd(ta->conn);
+
     return 0;
 }
 
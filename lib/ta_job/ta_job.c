@@ -20,6 +20,7 @@
 #include "te_sleep.h"
 #include "te_vector.h"
 #include "te_file.h"
+#include "te_reactor.h"
 #include "agentlib.h"
 #include "te_rpc_signal.h"
 #include "logfork.h"
@@ -36,6 +37,8 @@
 #if HAVE_SIGNAL_H
 #include <signal.h>
 #endif
+#include <inttypes.h>
+#include <time.h>
 
 /* The maximum size of log user entry (in bytes) for filter logging. */
 #define MAX_LOG_USER_SIZE 128
@@ -55,6 +58,10 @@
 
 #define MAX_QUEUE_SIZE (16 * 1024 * 1024)
 #define MAX_MESSAGE_DATA_SIZE 8192
+/* The maximum number of free message headers cached by a queue */
+#define MAX_QUEUE_FREE_MESSAGES 256
+/* The maximum amount of data drained at once from a channel without filters */
+#define MAX_SPLICE_SIZE (64 * 1024)
 
 #define CTRL_PIPE_INITIALIZER {-1, -1}
 #define CTRL_MESSAGE ("c\n")
@@ -83,6 +90,13 @@ typedef struct message_queue_t {
     message_list messages;
     size_t dropped;
     size_t size;
+
+    /*
+     * Headers of released messages which are reused for new ones,
+     * so that a message costs a single allocation for its data
+     */
+    message_list free_messages;
+    unsigned int n_free_messages;
 } message_queue_t;
 
 typedef enum queue_action_t {
@@ -129,10 +143,16 @@ typedef struct channel_t {
 
     unsigned int id;
 
+    struct ta_job_manager_t *manager;
     struct ta_job_t *job;
     te_bool closed;
     int fd;
 
+    /* Watch of the descriptor in the service thread event loop */
+    te_reactor_fd *watch;
+    /* Descriptor which is watched */
+    int watch_fd;
+
     te_bool is_input_channel;
 
     union {
@@ -183,12 +203,22 @@ typedef struct ta_job_t {
     LIST_HEAD(wrapper_list, wrapper_t) wrappers;
 
     te_sched_param *sched_params;
+
+    /* Amount of output data handled by the service thread */
+    uint64_t out_bytes;
+    /* CPU time spent by the service thread on the output, nanoseconds */
+    uint64_t out_cpu_ns;
 } ta_job_t;
 
 struct ta_job_manager_t {
     job_list all_jobs;
     channel_list all_channels;
     filter_list all_filters;
+    /*
+     * Deallocated channels which descriptors are still watched by
+     * the service thread, it closes and frees them
+     */
+    channel_list dead_channels;
     /* Channels and filters exist in the same handler namespace */
     unsigned int channel_last_id;
 
@@ -201,6 +231,10 @@ struct ta_job_manager_t {
 
     te_bool thread_is_running;
     pthread_t service_thread;
+    /* Event loop of the service thread */
+    te_reactor *reactor;
+    /* /dev/null opened for writing to drain channels without filters */
+    int devnull_fd;
 };
 
 /** Default initializer for ta_job_manager_t structure */
@@ -208,10 +242,13 @@ static const ta_job_manager_t ta_job_manager_initializer = {
     .all_jobs = LIST_HEAD_INITIALIZER(all_jobs),
     .all_channels = LIST_HEAD_INITIALIZER(all_channels),
     .all_filters = LIST_HEAD_INITIALIZER(all_filters),
+    .dead_channels = LIST_HEAD_INITIALIZER(dead_channels),
     .channels_lock = PTHREAD_MUTEX_INITIALIZER,
     .data_cond = PTHREAD_COND_INITIALIZER,
     .ctrl_pipe = CTRL_PIPE_INITIALIZER,
     .thread_is_running = FALSE,
+    .reactor = NULL,
+    .devnull_fd = -1,
 };
 
 /** Whether currently used PCRE version supports parial matching */
@@ -490,10 +527,41 @@ init_message_queue(message_queue_t *queue)
     queue->size = 0;
     queue->dropped = 0;
     TAILQ_INIT(&queue->messages);
+    TAILQ_INIT(&queue->free_messages);
+    queue->n_free_messages = 0;
 
     return 0;
 }
 
+static message_t *
+queue_message_alloc(message_queue_t *queue)
+{
+    message_t *msg = TAILQ_FIRST(&queue->free_messages);
+
+    if (msg == NULL)
+        return calloc(1, sizeof(*msg));
+
+    TAILQ_REMOVE(&queue->free_messages, msg, entry);
+    queue->n_free_messages--;
+    memset(msg, 0, sizeof(*msg));
+
+    return msg;
+}
+
+/* Release message header, message data is not released */
+static void
+queue_message_release(message_queue_t *queue, message_t *msg)
+{
+    if (queue->n_free_messages >= MAX_QUEUE_FREE_MESSAGES)
+    {
+        free(msg);
+        return;
+    }
+
+    TAILQ_INSERT_HEAD(&queue->free_messages, msg, entry);
+    queue->n_free_messages++;
+}
+
 static te_bool
 queue_drop_oldest(message_queue_t *queue)
 {
@@ -505,7 +573,7 @@ queue_drop_oldest(message_queue_t *queue)
 
         queue->size -= (msg->size + sizeof(*msg));
         free(msg->data);
-        free(msg);
+        queue_message_release(queue, msg);
 
         return TRUE;
     }
@@ -534,7 +602,7 @@ queue_put(const char *buf, size_t size, te_bool eos, unsigned int channel_id,
         queue->dropped++;
     }
 
-    msg = calloc(1, sizeof(*msg));
+    msg = queue_message_alloc(queue);
 
     if (msg == NULL)
     {
@@ -544,11 +612,12 @@ queue_put(const char *buf, size_t size, te_bool eos, unsigned int channel_id,
 
     if (size != 0)
     {
-        msg_str = calloc(1, size);
+        /* The buffer is filled in completely below */
+        msg_str = malloc(size);
         if (msg_str == NULL)
         {
             ERROR("Message databuf allocation failed");
-            free(msg);
+            queue_message_release(queue, msg);
             return TE_ENOMEM;
         }
     }
@@ -623,6 +692,7 @@ channel_add(ta_job_manager_t *manager, channel_t *channel)
     created_channel_id = manager->channel_last_id;
 
     channel->id = created_channel_id;
+    channel->manager = manager;
 
     LIST_INSERT_HEAD(&manager->all_channels, channel, next);
     manager->channel_last_id++;
@@ -679,6 +749,8 @@ channel_alloc(ta_job_t *job, channel_t **channel, te_bool is_input_channel)
     result->n_filters = 0;
     result->job = job;
     result->fd = -1;
+    result->watch = NULL;
+    result->watch_fd = -1;
     result->closed = FALSE;
     result->is_input_channel = is_input_channel;
     result->input_ready = FALSE;
@@ -735,8 +807,17 @@ filter_alloc(const char *filter_name, te_bool readable, te_log_level log_level,
 static void
 queue_destroy(message_queue_t *queue)
 {
+    message_t *msg;
+
     while (queue_drop_oldest(queue))
         ; /* Do nothing */
+
+    while ((msg = TAILQ_FIRST(&queue->free_messages)) != NULL)
+    {
+        TAILQ_REMOVE(&queue->free_messages, msg, entry);
+        free(msg);
+    }
+    queue->n_free_messages = 0;
 }
 
 static void
@@ -755,8 +836,9 @@ filter_destroy(filter_t *filter)
     free(filter);
 }
 
+/* Remove the channel from the list of channels and detach its filters */
 static void
-channel_destroy(channel_t *channel)
+channel_detach(channel_t *channel)
 {
     unsigned int i;
 
@@ -764,6 +846,13 @@ channel_destroy(channel_t *channel)
 
     for (i = 0; i < channel->n_filters; i++)
         filter_destroy(channel->filters[i]);
+    channel->n_filters = 0;
+}
+
+static void
+channel_destroy(channel_t *channel)
+{
+    channel_detach(channel);
 
     free(channel);
 }
@@ -1042,7 +1131,7 @@ match_callback(ta_job_manager_t *manager, filter_t *filter,
 #else
         te_string message = TE_STRING_INIT;
 
-        rc = te_string_append(&message, "%.*s", log_size, buf);
+        rc = te_string_append_buf(&message, buf, log_size);
         if (rc != 0)
             return rc;
 
@@ -1278,187 +1367,248 @@ filter_exec(ta_job_manager_t *manager, filter_t *filter,
     return match_callback(manager, filter, channel_id, pid, size, buf, eos);
 }
 
+static uint64_t
+thread_cpu_time_ns(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+
+    return TE_SEC2NS((uint64_t)ts.tv_sec) + ts.tv_nsec;
+}
+
 static te_errno
 channel_read(ta_job_manager_t *manager, channel_t *channel)
 {
-    char buf[MAX_MESSAGE_DATA_SIZE] = {0};
-    ssize_t read_c;
+    char buf[MAX_MESSAGE_DATA_SIZE];
+    ssize_t read_c = -1;
+    uint64_t cpu_start = thread_cpu_time_ns();
     size_t i;
-    te_errno rc;
+    te_errno rc = 0;
 
-    read_c = read(channel->fd, buf, sizeof(buf));
-    if (read_c < 0)
-        return te_rc_os2te(errno);
+#ifdef SPLICE_F_NONBLOCK
+    /*
+     * Nobody is interested in data of a channel without filters,
+     * so it is drained without copying to userspace.
+     */
+    if (channel->n_filters == 0 && manager->devnull_fd > -1)
+    {
+        read_c = splice(channel->fd, NULL, manager->devnull_fd, NULL,
+                        MAX_SPLICE_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        /* The descriptor is not a pipe */
+        if (read_c < 0 && errno != EINVAL)
+            return te_rc_os2te(errno);
+    }
+#endif
 
-    for (i = 0; i < channel->n_filters; i++)
+    if (read_c < 0)
     {
-        if ((rc = filter_exec(manager, channel->filters[i], channel->id,
-                              channel->job->pid, read_c, buf)) != 0)
-            return rc;
+        read_c = read(channel->fd, buf, sizeof(buf));
+        if (read_c < 0)
+            return te_rc_os2te(errno);
+
+        for (i = 0; i < channel->n_filters; i++)
+        {
+            if ((rc = filter_exec(manager, channel->filters[i], channel->id,
+                                  channel->job->pid, read_c, buf)) != 0)
+                break;
+        }
     }
 
     if (read_c == 0)
         channel->closed = TRUE;
 
-    return 0;
-}
-
-static void
-thread_destroy_unused_channels(channel_list *channels)
-{
-    channel_t *channel;
-    channel_t *channel_tmp;
-
-    LIST_FOREACH_SAFE(channel, channels, next, channel_tmp)
+    if (channel->job != NULL)
     {
-        if (channel->job == NULL)
-        {
-            if (channel->fd > -1)
-                close(channel->fd);
-            channel_destroy(channel);
-        }
+        channel->job->out_bytes += read_c;
+        channel->job->out_cpu_ns += thread_cpu_time_ns() - cpu_start;
     }
+
+    return rc;
 }
 
+static void thread_channel_ready(int fd, void *opaque);
+
 static void
-thread_read_selected(ta_job_manager_t *manager, fd_set *rfds,
-                     channel_list *channels)
+thread_channel_watch(ta_job_manager_t *manager, channel_t *channel)
 {
-    channel_t *active_channel = NULL;
-    channel_t *channel;
     te_errno rc;
 
-    LIST_FOREACH(channel, channels, next)
+    if (channel->is_input_channel)
     {
-        if (FD_ISSET(channel->fd, rfds))
-        {
-            active_channel = channel;
-            break;
-        }
+        rc = te_reactor_add_fd_out(manager->reactor, channel->fd,
+                                   thread_channel_ready, channel,
+                                   &channel->watch);
+    }
+    else
+    {
+        rc = te_reactor_add_fd(manager->reactor, channel->fd,
+                               thread_channel_ready, channel,
+                               &channel->watch);
     }
 
-    if (active_channel == NULL)
+    if (rc != 0)
     {
-        INFO("Drop data on destroyed channel\n");
+        WARN("Failed to watch channel %u: %r", channel->id, rc);
+        channel->watch = NULL;
         return;
     }
 
-    if ((rc = channel_read(manager, active_channel)) != 0)
+    channel->watch_fd = channel->fd;
+}
+
+static void
+thread_channel_unwatch(ta_job_manager_t *manager, channel_t *channel)
+{
+    te_reactor_del_fd(manager->reactor, channel->watch);
+    channel->watch = NULL;
+    channel->watch_fd = -1;
+}
+
+/*
+ * Start watching descriptors of channels which are bound to started jobs
+ * or wait for input and stop watching closed or replaced ones.
+ */
+static void
+thread_sync_watches(ta_job_manager_t *manager)
+{
+    channel_t *channel;
+
+    LIST_FOREACH(channel, &manager->all_channels, next)
     {
-        WARN("Channel read failure '%r', continuing", rc);
+        te_bool needed = !channel->closed && channel->fd > -1 &&
+                         !(channel->is_input_channel && channel->input_ready);
+
+        if (channel->watch != NULL &&
+            (!needed || channel->watch_fd != channel->fd))
+            thread_channel_unwatch(manager, channel);
+
+        if (needed && channel->watch == NULL)
+            thread_channel_watch(manager, channel);
     }
 }
 
 static void
-thread_mark_selected_ready(ta_job_manager_t *manager, fd_set *wfds,
-                           channel_list *channels)
+thread_destroy_unused_channels(ta_job_manager_t *manager)
 {
     channel_t *channel;
+    channel_t *channel_tmp;
 
-    LIST_FOREACH(channel, channels, next)
+    LIST_FOREACH_SAFE(channel, &manager->all_channels, next, channel_tmp)
     {
-        if (FD_ISSET(channel->fd, wfds))
+        if (channel->job == NULL)
         {
-            channel->input_ready = TRUE;
-            if (channel->signal_on_data)
-                pthread_cond_signal(&manager->data_cond);
+            thread_channel_unwatch(manager, channel);
+            if (channel->fd > -1)
+                close(channel->fd);
+            channel_destroy(channel);
         }
     }
+
+    while ((channel = LIST_FIRST(&manager->dead_channels)) != NULL)
+    {
+        LIST_REMOVE(channel, next);
+        thread_channel_unwatch(manager, channel);
+        if (channel->fd > -1)
+            close(channel->fd);
+        free(channel);
+    }
 }
 
-static void *
-thread_work_loop(void *arg)
+static void
+thread_channel_ready(int fd, void *opaque)
 {
-    ta_job_manager_t *manager = arg;
-
-    fd_set rfds;
-    fd_set wfds;
-    int select_rc;
+    channel_t *channel = opaque;
+    ta_job_manager_t *manager = channel->manager;
+    te_errno rc;
 
-    UNUSED(arg);
+    pthread_mutex_lock(&manager->channels_lock);
 
-    logfork_register_user("JOB CONTROL");
-    logfork_set_id_logging(FALSE);
+    /*
+     * The descriptor has been replaced or the job has been destroyed,
+     * the watch is removed when the service thread is woken up.
+     */
+    if (fd != channel->fd || channel->job == NULL)
+    {
+        pthread_mutex_unlock(&manager->channels_lock);
+        return;
+    }
 
-    while (1)
+    if (channel->is_input_channel)
     {
-        int ctrl_fd = ctrl_pipe_get_read_fd(manager);
-        int max_fd = ctrl_fd;
-        channel_t *channel;
+        channel->input_ready = TRUE;
+        if (channel->signal_on_data)
+            pthread_cond_signal(&manager->data_cond);
 
-        FD_ZERO(&rfds);
-        FD_ZERO(&wfds);
-        FD_SET(ctrl_fd, &rfds);
+        /*
+         * Writability is level-triggered, the descriptor is watched
+         * again after the next write to it.
+         */
+        thread_channel_unwatch(manager, channel);
+    }
+    else
+    {
+        if ((rc = channel_read(manager, channel)) != 0)
+            WARN("Channel read failure '%r', continuing", rc);
 
-        pthread_mutex_lock(&manager->channels_lock);
+        if (channel->closed)
+            thread_channel_unwatch(manager, channel);
+    }
 
-        LIST_FOREACH(channel, &manager->all_channels, next)
-        {
-            if (!channel->closed && channel->fd > -1)
-            {
-                if (channel->is_input_channel)
-                {
-                    if (!channel->input_ready)
-                        FD_SET(channel->fd, &wfds);
-                }
-                else
-                {
-                    FD_SET(channel->fd, &rfds);
-                }
+    pthread_mutex_unlock(&manager->channels_lock);
+}
 
-                if (channel->fd > max_fd)
-                    max_fd = channel->fd;
-            }
-        }
+static void
+thread_ctrl_ready(int fd, void *opaque)
+{
+    ta_job_manager_t *manager = opaque;
+    char buf[sizeof(CTRL_MESSAGE)] = {0};
+    ssize_t read_c = read(fd, buf, sizeof(buf));
 
-        pthread_mutex_unlock(&manager->channels_lock);
+    if (read_c <= 0)
+        WARN("Control pipe read failed, continuing");
 
-        select_rc = select(max_fd + 1, &rfds, &wfds, NULL, NULL);
+    pthread_mutex_lock(&manager->channels_lock);
 
-        if (select_rc < 0)
-        {
-            switch (errno)
-            {
-                case EINTR:
-                    /* A failure due to signal is ignored */
-                    break;
-                default:
-                    ERROR("select() failed, %s", strerror(errno));
-                    break;
-            }
-        }
-        else if (select_rc)
-        {
-            te_bool channel_process_needed = TRUE;
+    thread_destroy_unused_channels(manager);
+    /* Watches of abandoned descriptors must be removed before closing */
+    thread_sync_watches(manager);
+    abandoned_descriptors_close(manager);
 
-            pthread_mutex_lock(&manager->channels_lock);
+    pthread_mutex_unlock(&manager->channels_lock);
+}
 
-            if (FD_ISSET(ctrl_fd, &rfds))
-            {
-                char buf[sizeof(CTRL_MESSAGE)] = {0};
-                ssize_t read_c = read(ctrl_fd, buf, sizeof(buf));
+static void *
+thread_work_loop(void *arg)
+{
+    ta_job_manager_t *manager = arg;
+    te_errno rc;
 
-                if (read_c <= 0)
-                    WARN("Control pipe read failed, continuing");
+    logfork_register_user("JOB CONTROL");
+    logfork_set_id_logging(FALSE);
 
-                channel_process_needed = FALSE;
-            }
+    while (1)
+    {
+        rc = te_reactor_run(manager->reactor, -1);
+        if (rc != 0)
+            ERROR("Event loop failed: %r", rc);
+    }
 
-            thread_destroy_unused_channels(&manager->all_channels);
-            abandoned_descriptors_close(manager);
+    return NULL;
+}
 
-            if (channel_process_needed)
-            {
-                thread_read_selected(manager, &rfds, &manager->all_channels);
-                thread_mark_selected_ready(manager, &wfds,
-                                           &manager->all_channels);
-            }
+static void
+thread_resources_destroy(ta_job_manager_t *manager)
+{
+    te_reactor_destroy(manager->reactor);
+    manager->reactor = NULL;
 
-            pthread_mutex_unlock(&manager->channels_lock);
-        }
-    }
+    if (manager->devnull_fd > -1)
+        close(manager->devnull_fd);
+    manager->devnull_fd = -1;
 
-    return NULL;
+    ctrl_pipe_destroy(manager);
 }
 
 static te_errno
@@ -1469,19 +1619,31 @@ thread_start(ta_job_manager_t *manager)
     if ((rc = ctrl_pipe_create(manager)) != 0)
         return rc;
 
-    /* Check read end of the pipe for descriptor limit */
-    if (ctrl_pipe_get_read_fd(manager) >= FD_SETSIZE)
+    if ((rc = te_reactor_create(&manager->reactor)) != 0)
     {
-        ERROR("Failed to create control pipe, file descriptor limit exceeded");
-        ctrl_pipe_destroy(manager);
-        return TE_EMFILE;
+        ERROR("Failed to create event loop: %r", rc);
+        thread_resources_destroy(manager);
+        return rc;
+    }
+
+    rc = te_reactor_add_fd(manager->reactor, ctrl_pipe_get_read_fd(manager),
+                           thread_ctrl_ready, manager, NULL);
+    if (rc != 0)
+    {
+        thread_resources_destroy(manager);
+        return rc;
     }
 
+    manager->devnull_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (manager->devnull_fd < 0)
+        WARN("Failed to open /dev/null, output of channels without filters "
+             "is read to userspace");
+
     if (pthread_create(&manager->service_thread, NULL,
                        thread_work_loop, manager) != 0)
     {
         ERROR("Thread create failure");
-        ctrl_pipe_destroy(manager);
+        thread_resources_destroy(manager);
         return te_rc_os2te(errno);
     }
 
@@ -1614,17 +1776,6 @@ ta_job_start(ta_job_manager_t *manager, unsigned int id)
         return te_rc_os2te(errno);
     }
 
-    if (stdout_fd >= FD_SETSIZE || stderr_fd >= FD_SETSIZE ||
-        stdin_fd >= FD_SETSIZE)
-    {
-        ERROR("Failed to start a job, file descriptor limit exceeded");
-        close_valid(stdout_fd);
-        close_valid(stderr_fd);
-        close_valid(stdin_fd);
-        proc_kill(pid, SIGTERM, -1);
-        return TE_EMFILE;
-    }
-
     pthread_mutex_lock(&manager->channels_lock);
 
     if ((rc = ctrl_pipe_send(manager)) != 0)
@@ -1812,6 +1963,8 @@ ta_job_deallocate_channels(ta_job_manager_t *manager, unsigned int n_channels,
     channel_t *channel;
     unsigned int i;
 
+    te_bool wake_thread = FALSE;
+
     pthread_mutex_lock(&manager->channels_lock);
 
     for (i = 0; i < n_channels; i++)
@@ -1820,17 +1973,35 @@ ta_job_deallocate_channels(ta_job_manager_t *manager, unsigned int n_channels,
         if (channel == NULL)
             continue;
 
-        if (channel->fd > -1)
-            close(channel->fd);
-
         /*
          * We do not rely on thread_destroy_unused_channels() to do the job
          * because we need the channel to be removed from the list right now.
          * Otherwise, it may still be accessible for some time from TA job API.
          */
-        channel_destroy(channel);
+        if (channel->watch != NULL)
+        {
+            /*
+             * The descriptor may be closed only after the service thread
+             * stops watching it, so the thread closes it and frees
+             * the channel.
+             */
+            channel_detach(channel);
+            channel->job = NULL;
+            LIST_INSERT_HEAD(&manager->dead_channels, channel, next);
+            wake_thread = TRUE;
+        }
+        else
+        {
+            if (channel->fd > -1)
+                close(channel->fd);
+
+            channel_destroy(channel);
+        }
     }
 
+    if (wake_thread && ctrl_pipe_send(manager) != 0)
+        WARN("Failed to wake up the service thread to free channels");
+
     pthread_mutex_unlock(&manager->channels_lock);
 }
 
@@ -2122,7 +2293,7 @@ filter_receive_common(ta_job_manager_t *manager, unsigned int filter_id,
         }
 
         if (action == EXTRACT_FIRST)
-            free(msg);
+            queue_message_release(&filter->queue, msg);
     }
     else
     {
@@ -2615,11 +2786,22 @@ ta_job_destroy(ta_job_manager_t *manager, unsigned int job_id,
 
     pthread_mutex_lock(&manager->channels_lock);
 
+    if (job->out_bytes != 0)
+    {
+        RING("Job %u (%s): %" PRIu64 " bytes of output were handled "
+             "in %.3f ms of CPU time", job->id, job->tool, job->out_bytes,
+             job->out_cpu_ns / 1000000.0);
+    }
+
     for (i = 0; i < job->n_out_channels; i++)
         job->out_channels[i]->job = NULL;
     for (i = 0; i < job->n_in_channels; i++)
         job->in_channels[i]->job = NULL;
 
+    /* Wake up the service thread to free the channels */
+    if (manager->thread_is_running && ctrl_pipe_send(manager) != 0)
+        WARN("Failed to wake up the service thread to free channels");
+
     pthread_mutex_unlock(&manager->channels_lock);
 
     while ((wrapper = LIST_FIRST(&job->wrappers)) != NULL)
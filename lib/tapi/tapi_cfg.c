@@ -444,201 +444,189 @@ route_parse_inst_name(const char *inst_name, tapi_rt_entry_t *rt)
     return 0;
 }
 
+/**
+ * Fill in a routing entry field by the route attribute instance.
+ *
+ * @param rt        Routing entry (IN/OUT)
+ * @param attr      Route attribute instance
+ * @param name      Attribute name (sub-identifier)
+ *
+ * @return Status code
+ */
+static te_errno
+route_set_attr(tapi_rt_entry_t *rt, const cfg_subtree_entry *attr,
+               const char *name)
+{
+    cfg_val_type    type = CVT_INT32;
+    uint32_t       *val_p = NULL;
+
+    if (strcmp(name, "dev") == 0 || strcmp(name, "type") == 0)
+        type = CVT_STRING;
+    else if (strcmp(name, "src") == 0)
+        type = CVT_ADDRESS;
+    else if (strcmp(name, "mtu") == 0)
+        val_p = &rt->mtu;
+    else if (strcmp(name, "win") == 0)
+        val_p = &rt->win;
+    else if (strcmp(name, "irtt") == 0)
+        val_p = &rt->irtt;
+    else if (strcmp(name, "hoplimit") == 0)
+        val_p = &rt->hoplimit;
+    else
+    {
+        ERROR("%s(): Unknown route attribute found %s",
+              __FUNCTION__, name);
+        return TE_RC(TE_TAPI, TE_EINVAL);
+    }
+
+    if (attr->type != type)
+    {
+        ERROR("%s(): Unexpected type of %s route attribute",
+              __FUNCTION__, name);
+        return TE_RC(TE_TAPI, TE_EINVAL);
+    }
+
+    if (val_p != NULL)
+    {
+        *val_p = attr->val.val_int32;
+    }
+    else if (strcmp(name, "src") == 0)
+    {
+        rt->flags |= TAPI_RT_SRC;
+        memcpy(&rt->src, attr->val.val_addr,
+               te_sockaddr_get_size(attr->val.val_addr));
+    }
+    else if (strcmp(name, "dev") == 0)
+    {
+        te_strlcpy(rt->dev, attr->val.val_str, sizeof(rt->dev));
+    }
+    else
+    {
+        te_strlcpy(rt->type, attr->val.val_str, sizeof(rt->type));
+    }
+
+    return 0;
+}
+
 /* See the description in tapi_cfg.h */
 int
 tapi_cfg_get_route_table(const char *ta, int addr_family,
                          tapi_rt_entry_t **rt_tbl, unsigned int *n)
 {
-    int                 rc;
-    cfg_handle          handle1;
-    cfg_handle          handle2;
-    cfg_handle         *handles;
+    int                 rc = 0;
+    cfg_subtree_entry  *entries;
     tapi_rt_entry_t    *tbl;
-    char               *rt_name = NULL;
+    tapi_rt_entry_t    *rt = NULL;
+    size_t              prefix_len;
     unsigned int        num, rt_num = 0;
+    unsigned int        n_attrs = 0;
     unsigned int        i, j;
-    struct sockaddr    *addr;
 
     if (ta == NULL || rt_tbl == NULL || n == NULL)
         return TE_RC(TE_TAPI, TE_EINVAL);
 
-    rc = cfg_find_pattern_fmt(&num, &handles, "/agent:%s/route:*", ta);
+    /*
+     * Routes are read together with their attributes at once,
+     * attributes of a route follow the route itself.
+     */
+    rc = cfg_get_subtree_fmt(TRUE, &num, &entries, "/agent:%s/route:*", ta);
     if (rc != 0)
         return rc;
 
-    for (i = 0; i < num; i++)
-    {
-        if ((rc = cfg_get_instance(handles[i], NULL, &addr)) != 0)
-        {
-            ERROR("%s: Cannot obtain route instance value", __FUNCTION__);
-            free(handles);
-            return rc;
-        }
+    /* Length of "/agent:<ta>/route:" preceding route instance names */
+    prefix_len = strlen("/agent:") + strlen(ta) + strlen("/route:");
 
-        if (addr->sa_family == addr_family)
+    for (j = 0; j < num; j++)
+    {
+        if (strchr(entries[j].oid + prefix_len, '/') == NULL &&
+            entries[j].type == CVT_ADDRESS &&
+            entries[j].val.val_addr->sa_family == addr_family)
             rt_num++;
-
-        free(addr);
     }
 
     if (rt_num == 0)
     {
         *rt_tbl = NULL;
         *n = 0;
-        free(handles);
+        free(entries);
         return 0;
     }
 
     if ((tbl = (tapi_rt_entry_t *)calloc(rt_num, sizeof(*tbl))) == NULL)
     {
-        free(handles);
+        free(entries);
         return TE_RC(TE_TAPI, TE_ENOMEM);
     }
 
     i = 0;
-    for (j = 0; j < num; j++)
+    for (j = 0; j <= num; j++)
     {
-        if ((rc = cfg_get_instance(handles[j], NULL, &addr)) != 0)
-        {
-            ERROR("%s: Cannot obtain route instance value", __FUNCTION__);
-            break;
-        }
-
-        if (addr->sa_family != addr_family)
-        {
-            free(addr);
-            continue;
-        }
-
-        if ((addr->sa_family == AF_INET &&
-             SIN(addr)->sin_addr.s_addr != htonl(INADDR_ANY)) ||
-            (addr->sa_family == AF_INET6 &&
-             !IN6_IS_ADDR_UNSPECIFIED(&SIN6(addr)->sin6_addr)))
-        {
-            tbl[i].flags |= TAPI_RT_GW;
-            memcpy(&tbl[i].gw, addr, te_sockaddr_get_size(addr));
-        }
-
-        free(addr);
-
-        if ((rc = cfg_get_inst_name(handles[j], &rt_name)) != 0)
-        {
-            ERROR("%s: Route handle cannot be processed", __FUNCTION__);
-            break;
-        }
-
-        rc = route_parse_inst_name(rt_name, &tbl[i]);
-
-        free(rt_name);
-
-        assert(rc == 0);
+        const cfg_subtree_entry *e = &entries[j];
+        const struct sockaddr   *addr;
+        const char              *tail;
+        char                     name[CFG_SUBID_MAX];
 
-        /* Get route attributes */
-        if ((rc = cfg_get_son(handles[j], &handle2)) != 0 ||
-            handle2 == CFG_HANDLE_INVALID)
+        tail = j < num ? strchr(e->oid + prefix_len, '/') : NULL;
+        if (tail == NULL)
         {
-            ERROR("%s: Cannot find any attribute of the route %r",
-                  __FUNCTION__, rc);
-            break;
-        }
-
-        do {
-            cfg_val_type    type;
-            char           *name;
-            char           *dev_name;
-            cfg_oid        *oid;
-            void           *val_p;
-            char           *type_val;
-
-            handle1 = handle2;
-
-            if ((rc = cfg_get_oid(handle1, &oid)) != 0)
+            /* The previous route is over */
+            if (rt != NULL && n_attrs == 0)
             {
-                ERROR("%s: Cannot get route attribute name %r",
-                      __FUNCTION__, rc);
+                ERROR("%s: Cannot find any attribute of the route",
+                      __FUNCTION__);
+                rc = TE_RC(TE_TAPI, TE_ENOENT);
                 break;
             }
-            name = ((cfg_inst_subid *)
-                            (oid->ids))[oid->len - 1].subid;
+            rt = NULL;
 
-            type = CVT_INT32;
-            if (strcmp(name, "dev") == 0)
-            {
-                val_p = &dev_name;
-                type = CVT_STRING;
-            }
-            else if (strcmp(name, "mtu") == 0)
-                val_p = &tbl[i].mtu;
-            else if (strcmp(name, "win") == 0)
-                val_p = &tbl[i].win;
-            else if (strcmp(name, "irtt") == 0)
-                val_p = &tbl[i].irtt;
-            else if (strcmp(name, "hoplimit") == 0)
-                val_p = &tbl[i].hoplimit;
-            else if (strcmp(name, "type") == 0)
-            {
-                val_p = &type_val;
-                type = CVT_STRING;
-            }
-            else if (strcmp(name, "src") == 0)
-            {
-                type = CVT_ADDRESS;
-                tbl[i].flags |= TAPI_RT_SRC;
-                val_p = &addr;
-            }
-            else
-            {
-                ERROR("%s(): Unknown route attribute found %s",
-                      __FUNCTION__, name);
-                free(oid);
-                rc = TE_RC(TE_TAPI, TE_EINVAL);
+            if (j == num)
                 break;
-            }
 
-            if ((rc = cfg_get_instance(handle1, &type, val_p)) != 0)
+            if (e->type != CVT_ADDRESS)
             {
-                ERROR("%s(): Cannot get value of %s route attribute %r",
-                      __FUNCTION__, name, rc);
-                free(oid);
+                ERROR("%s: Unexpected type of route instance value",
+                      __FUNCTION__);
+                rc = TE_RC(TE_TAPI, TE_EINVAL);
                 break;
             }
 
-            if (strcmp(name, "src") == 0)
-            {
-                memcpy(&tbl[i].src, addr, te_sockaddr_get_size(addr));
-                free(addr);
-            }
-            else if (strcmp(name, "dev") == 0)
-            {
-                te_strlcpy(tbl[i].dev, dev_name, sizeof(tbl[i].dev));
-                free(dev_name);
-            }
-            else if (strcmp(name, "type") == 0)
-            {
-                te_strlcpy(tbl[i].type, type_val, sizeof(tbl[i].type));
-                free(type_val);
-            }
+            addr = e->val.val_addr;
+            if (addr->sa_family != addr_family)
+                continue;
 
-            free(oid);
+            rt = &tbl[i++];
+            n_attrs = 0;
 
-            rc = cfg_get_brother(handle1, &handle2);
-            if (rc != 0)
+            if ((addr->sa_family == AF_INET &&
+                 CONST_SIN(addr)->sin_addr.s_addr != htonl(INADDR_ANY)) ||
+                (addr->sa_family == AF_INET6 &&
+                 !IN6_IS_ADDR_UNSPECIFIED(&CONST_SIN6(addr)->sin6_addr)))
             {
-                ERROR("%s(): Cannot get brother of route attribute %r",
-                      __FUNCTION__, rc);
-                break;
+                rt->flags |= TAPI_RT_GW;
+                memcpy(&rt->gw, addr, te_sockaddr_get_size(addr));
             }
-        } while (handle2 != CFG_HANDLE_INVALID);
 
-        if (rc != 0)
-            break;
+            rc = route_parse_inst_name(e->oid + prefix_len, rt);
+
+            assert(rc == 0);
 
-        assert(handle2 == CFG_HANDLE_INVALID);
+            rt->hndl = e->handle;
+            continue;
+        }
+
+        /* Only direct sons of matching routes are attributes */
+        if (rt == NULL || strchr(tail + 1, '/') != NULL)
+            continue;
+
+        te_strlcpy(name, tail + 1, sizeof(name));
+        if (strchr(name, ':') != NULL)
+            *strchr(name, ':') = '\0';
 
-        tbl[i].hndl = handles[j];
-        i++;
+        if ((rc = route_set_attr(rt, e, name)) != 0)
+            break;
+        n_attrs++;
     }
-    free(handles);
+    free(entries);
 
     if (rc != 0)
     {
@@ -85,33 +85,24 @@ typedef struct changed_region {
 } changed_region;
 
 static te_errno
-get_region(cfg_handle handle, void *data)
+get_region(const cfg_subtree_entry *entry, te_vec *regions)
 {
-    te_vec *regions = data;
     te_errno rc;
-    cfg_val_type type = CVT_STRING;
-    char *strval = NULL;
     uintmax_t intval;
     changed_region region;
 
-    region.h = handle;
+    region.h = entry->handle;
 
-    rc = cfg_get_instance(handle, &type, &strval);
-    if (rc != 0)
-        return rc;
+    if (entry->type != CVT_STRING)
+        return TE_RC(TE_TAPI, TE_EINVAL);
 
-    rc = te_strtoumax(strval, 10, &intval);
-    free(strval);
+    rc = te_strtoumax(entry->val.val_str, 10, &intval);
     if (rc != 0)
         return rc;
     region.len = intval;
 
-    rc = cfg_get_inst_name(handle, &strval);
-    if (rc != 0)
-        return rc;
-
-    rc = te_strtoumax(strval, 10, &intval);
-    free(strval);
+    /* Instance name follows the last colon of the region OID */
+    rc = te_strtoumax(strrchr(entry->oid, ':') + 1, 10, &intval);
     if (rc != 0)
         return rc;
     region.start = intval;
@@ -137,13 +128,26 @@ static te_errno
 get_regions(const char *tag, te_vec *regions)
 {
     changed_region *r;
-    te_errno rc = cfg_find_pattern_iter_fmt(get_region, regions,
-                                            CFG_CHANGED_OID_PFX "%s/region:*",
-                                            tag);
+    cfg_subtree_entry *entries;
+    unsigned int n_entries;
+    unsigned int i;
+    te_errno rc = cfg_get_subtree_fmt(FALSE, &n_entries, &entries,
+                                      CFG_CHANGED_OID_PFX "%s/region:*",
+                                      tag);
 
     if (rc != 0)
         return rc;
 
+    for (i = 0; i < n_entries; i++)
+    {
+        rc = get_region(&entries[i], regions);
+        if (rc != 0)
+            break;
+    }
+    free(entries);
+    if (rc != 0)
+        return rc;
+
     te_vec_sort(regions, compare_region);
 
     /* Fix unsigned overflows for too large lengths */
@@ -88,11 +88,14 @@ tapi_cfg_net_get_node_rsrc_type(cfg_net_node_t *node)
 te_errno
 tapi_cfg_net_get_net(cfg_handle net_handle, cfg_net_t *net)
 {
-    te_errno        rc;
-    char           *net_oid;
-    cfg_handle     *node_handles;
-    unsigned int    n_nodes;
-    unsigned int    i;
+    te_errno            rc;
+    char               *net_oid;
+    size_t              net_oid_len;
+    cfg_subtree_entry  *entries;
+    unsigned int        n_entries;
+    unsigned int        n_nodes;
+    unsigned int        n_types;
+    unsigned int        i;
 
 
     if (net_handle == CFG_HANDLE_INVALID || net == NULL)
@@ -118,18 +121,28 @@ tapi_cfg_net_get_net(cfg_handle net_handle, cfg_net_t *net)
         return TE_RC(TE_TAPI, TE_EFAULT);
     }
 
-    /* Find all nodes in this net */
-    rc = cfg_find_pattern_fmt(&n_nodes, &node_handles,
-                              "%s/node:*", net_oid);
+    /*
+     * Read all nodes of this net together with their types at once,
+     * sons of a node follow the node itself.
+     */
+    net_oid_len = strlen(net_oid);
+    rc = cfg_get_subtree_fmt(TRUE, &n_entries, &entries,
+                             "%s/node:*", net_oid);
     free(net_oid);
     if (rc != 0)
     {
-        ERROR("cfg_find_pattern() failed %r", rc);
+        ERROR("cfg_get_subtree() failed %r", rc);
         free(net->name);
         net->name = NULL;
         return rc;
     }
 
+    for (i = 0, n_nodes = 0; i < n_entries; ++i)
+    {
+        if (strchr(entries[i].oid + net_oid_len + 1, '/') == NULL)
+            n_nodes++;
+    }
+
     net->n_nodes = n_nodes;
     if (n_nodes == 0)
     {
@@ -142,38 +155,42 @@ tapi_cfg_net_get_net(cfg_handle net_handle, cfg_net_t *net)
         if (net->nodes == NULL)
         {
             ERROR("Memory allocation failure");
+            free(entries);
             free(net->name);
             net->name = NULL;
-            return rc;
+            return TE_RC(TE_TAPI, TE_ENOMEM);
         }
     }
 
-    for (i = 0; i < net->n_nodes; ++i)
+    for (i = 0, n_nodes = 0, n_types = 0; i < n_entries; ++i)
     {
-        char *node_oid;
-        int   val;
-
-        /* Save cfg handle of the net node */
-        net->nodes[i].handle = node_handles[i];
+        const char *tail = strchr(entries[i].oid + net_oid_len + 1, '/');
 
-        /* Get net node OID as string */
-        rc = cfg_get_oid_str(node_handles[i], &node_oid);
-        if (rc != 0)
+        if (tail == NULL)
         {
-            ERROR("cfg_get_oid_str() failed %r", rc);
-            break;
+            /* Save cfg handle of the net node */
+            net->nodes[n_nodes++].handle = entries[i].handle;
         }
-        /* Get node type */
-        rc = cfg_get_instance_int_fmt(&val, "%s/type:", node_oid);
-        free(node_oid);
-        if (rc != 0)
+        else if (n_nodes > 0 && strcmp(tail, "/type:") == 0)
         {
-            ERROR("cfg_get_instance_fmt() failed %r", rc);
-            break;
+            if (entries[i].type != CVT_INT32)
+            {
+                ERROR("Unexpected type of %s value", entries[i].oid);
+                rc = TE_RC(TE_TAPI, TE_EINVAL);
+                break;
+            }
+            net->nodes[n_nodes - 1].type = entries[i].val.val_int32;
+            n_types++;
         }
-        net->nodes[i].type = val;
     }
-    free(node_handles);
+    free(entries);
+
+    if (rc == 0 && n_types != n_nodes)
+    {
+        ERROR("Type is not specified for some nodes of the net '%s'",
+              net->name);
+        rc = TE_RC(TE_TAPI, TE_ENOENT);
+    }
 
     if (rc != 0)
         tapi_cfg_net_free_net(net);
@@ -386,71 +403,42 @@ tapi_cfg_net_get_pairs(enum net_node_type first,
 int
 tapi_cfg_net_find_net_by_node(const char *oid, char *net)
 {
-    te_errno        rc;
-    unsigned int    net_num;
-    cfg_handle     *net_handles = NULL;
-    unsigned int    i;
+    te_errno            rc;
+    unsigned int        node_num;
+    cfg_subtree_entry  *nodes = NULL;
+    unsigned int        i;
 
 
-    /* Get handles of all nodes in all networks */
-    rc = cfg_find_pattern("/net:*", &net_num, &net_handles);
+    /* Get values of all nodes in all networks */
+    rc = cfg_get_subtree("/net:*/node:*", FALSE, FALSE, &node_num, &nodes);
     if (rc != 0)
     {
         ERROR("Failed(%x) to find all nodes", rc);
         return rc;
     }
 
-    for (i = 0, rc = TE_ESRCH; i < net_num; ++i, rc = TE_ESRCH)
+    for (i = 0, rc = TE_ESRCH; i < node_num; ++i)
     {
-        char           *net_name;
-        unsigned int    node_num;
-        cfg_handle     *node_handles = NULL;
-        unsigned int    j;
+        char *net_name;
 
-        rc = cfg_get_inst_name(net_handles[i], &net_name);
-        if (rc != 0)
-        {
-            ERROR("Failed(%x) to get cfg OID instance name by handle", rc);
-            break;
-        }
+        if (nodes[i].type != CVT_STRING ||
+            strcmp(oid, nodes[i].val.val_str) != 0)
+            continue;
 
-        rc = cfg_find_pattern_fmt(&node_num, &node_handles,
-                                  "/net:%s/node:*", net_name);
-        if (rc != 0)
+        net_name = cfg_oid_str_get_inst_name(nodes[i].oid, -2);
+        if (net_name == NULL)
         {
-            ERROR("Failed(%x) to find nodes in the net '%s'", net_name);
+            ERROR("Failed to get net name from OID '%s'", nodes[i].oid);
+            rc = TE_EFAULT;
             break;
         }
 
-        for (j = 0, rc = ESRCH; j < node_num; ++j, rc = ESRCH)
-        {
-            cfg_val_type  type;
-            char         *val;
-            int           res;
-
-            type = CVT_STRING;
-            rc = cfg_get_instance(node_handles[j], &type, &val);
-            if (rc != 0)
-            {
-                ERROR("Failed(%x) to get value by cfg handle", rc);
-                break;
-            }
-
-            res = strcmp(oid, val);
-            free(val);
-            if (res == 0)
-            {
-                strcpy(net, net_name);
-                free(net_name);
-                free(node_handles);
-                free(net_handles);
-                return 0;
-            }
-        }
-        free(node_handles);
+        strcpy(net, net_name);
         free(net_name);
+        rc = 0;
+        break;
     }
-    free(net_handles);
+    free(nodes);
 
     return rc;
 
@@ -16,9 +16,13 @@
 #include <stdlib.h>
 #include <string.h>
 #endif
+#include <stdio.h>
+#include <inttypes.h>
 
 #include "te_defs.h"
+#include "te_str.h"
 #include "logger_api.h"
+#include "tapi_file.h"
 #include "tapi_cfg_base.h"
 #include "tapi_cfg_stats.h"
 
@@ -397,3 +401,368 @@ tapi_cfg_stats_net_stats_print(const char          *ta,
 
     return 0;
 }
+
+
+/* See description in tapi_cfg_stats.h */
+te_errno
+tapi_cfg_stats_if_sampler_start(const char *ta, const char *ifname,
+                                unsigned int rate, unsigned int size)
+{
+    te_errno rc;
+
+    if (rate != 0)
+    {
+        rc = cfg_set_instance_fmt(CFG_VAL(UINT32, rate),
+                                  "/agent:%s/interface:%s/sampler:/rate:",
+                                  ta, ifname);
+        if (rc != 0)
+        {
+            ERROR("Failed to set sampling rate of %s on %s: %r",
+                  ifname, ta, rc);
+            return rc;
+        }
+    }
+
+    if (size != 0)
+    {
+        rc = cfg_set_instance_fmt(CFG_VAL(UINT32, size),
+                                  "/agent:%s/interface:%s/sampler:/size:",
+                                  ta, ifname);
+        if (rc != 0)
+        {
+            ERROR("Failed to set sampler size of %s on %s: %r",
+                  ifname, ta, rc);
+            return rc;
+        }
+    }
+
+    rc = cfg_set_instance_fmt(CFG_VAL(INT32, 1),
+                              "/agent:%s/interface:%s/sampler:/enable:",
+                              ta, ifname);
+    if (rc != 0)
+        ERROR("Failed to start sampler of %s on %s: %r", ifname, ta, rc);
+
+    return rc;
+}
+
+/**
+ * Parse samples written by the agent sampler.
+ *
+ * @param buf           File contents
+ * @param samples       Location for the array of samples
+ * @param n_samples     Location for the number of samples
+ *
+ * @return Status code
+ */
+static te_errno
+if_samples_parse(const char *buf, tapi_cfg_if_sample **samples,
+                 unsigned int *n_samples)
+{
+    tapi_cfg_if_sample *result;
+    unsigned int        max = 0;
+    unsigned int        n = 0;
+    const char         *p;
+
+    for (p = buf; *p != '\0'; p++)
+    {
+        if (*p == '\n')
+            max++;
+    }
+
+    result = calloc(MAX(max, 1), sizeof(*result));
+    if (result == NULL)
+        return TE_RC(TE_TAPI, TE_ENOMEM);
+
+    for (p = buf; *p != '\0'; p = strchr(p, '\n') + 1)
+    {
+        tapi_cfg_if_sample *s = &result[n];
+
+        if (strchr(p, '\n') == NULL)
+            break;
+        if (*p == '#')
+            continue;
+
+        if (sscanf(p, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+                   " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+                   " %" SCNu64, &s->ts_ns,
+                   &s->rx_packets, &s->tx_packets,
+                   &s->rx_bytes, &s->tx_bytes,
+                   &s->rx_errors, &s->tx_errors,
+                   &s->rx_dropped, &s->tx_dropped) != 9)
+        {
+            ERROR("Malformed sample line %u", n + 1);
+            free(result);
+            return TE_RC(TE_TAPI, TE_EINVAL);
+        }
+        n++;
+    }
+
+    *samples = result;
+    *n_samples = n;
+
+    return 0;
+}
+
+/* See description in tapi_cfg_stats.h */
+te_errno
+tapi_cfg_stats_if_sampler_stop(const char *ta, const char *ifname,
+                               tapi_cfg_if_sample **samples,
+                               unsigned int *n_samples)
+{
+    char       *path = NULL;
+    char       *buf = NULL;
+    te_errno    rc;
+
+    rc = cfg_set_instance_fmt(CFG_VAL(INT32, 0),
+                              "/agent:%s/interface:%s/sampler:/enable:",
+                              ta, ifname);
+    if (rc != 0)
+    {
+        ERROR("Failed to stop sampler of %s on %s: %r", ifname, ta, rc);
+        return rc;
+    }
+
+    rc = cfg_synchronize_fmt(TRUE, "/agent:%s/interface:%s/sampler:",
+                             ta, ifname);
+    if (rc != 0)
+        return rc;
+
+    rc = cfg_get_instance_string_fmt(&path,
+                                     "/agent:%s/interface:%s/sampler:/dump:",
+                                     ta, ifname);
+    if (rc != 0)
+        return rc;
+
+    if (*path == '\0')
+    {
+        ERROR("Sampler of %s on %s has not produced samples", ifname, ta);
+        free(path);
+        return TE_RC(TE_TAPI, TE_ENODATA);
+    }
+
+    rc = tapi_file_read_ta(ta, path, &buf);
+    free(path);
+    if (rc != 0)
+        return rc;
+
+    rc = if_samples_parse(buf, samples, n_samples);
+    free(buf);
+
+    return rc;
+}
+
+/** Summary of values over sampling intervals */
+typedef struct if_samples_summary {
+    double  mean;   /**< Mean */
+    double  min;    /**< Minimum */
+    double  max;    /**< Maximum */
+    double  median; /**< Median */
+    double  p90;    /**< 90th percentile */
+    double  p99;    /**< 99th percentile */
+    double  p999;   /**< 99.9th percentile */
+} if_samples_summary;
+
+/** Compare doubles for qsort() */
+static int
+double_cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/** Nearest-rank percentile of sorted values */
+static double
+sorted_percentile(const double *values, unsigned int n, double pct)
+{
+    unsigned int rank = (unsigned int)(pct / 100.0 * n + 0.999999);
+
+    if (rank == 0)
+        rank = 1;
+
+    return values[MIN(rank, n) - 1];
+}
+
+/** Calculate summary of values (they are sorted in place) */
+static void
+if_samples_summarize(double *values, unsigned int n,
+                     if_samples_summary *summary)
+{
+    double          sum = 0;
+    unsigned int    i;
+
+    for (i = 0; i < n; i++)
+        sum += values[i];
+
+    qsort(values, n, sizeof(*values), double_cmp);
+
+    summary->mean = sum / n;
+    summary->min = values[0];
+    summary->max = values[n - 1];
+    summary->median = (n % 2 == 0) ?
+                      (values[n / 2 - 1] + values[n / 2]) / 2 :
+                      values[n / 2];
+    summary->p90 = sorted_percentile(values, n, 90);
+    summary->p99 = sorted_percentile(values, n, 99);
+    summary->p999 = sorted_percentile(values, n, 99.9);
+}
+
+/** Add measurements of a summary to MI logger */
+static void
+if_samples_summary_log(te_mi_logger *logger, te_mi_meas_type type,
+                       const char *name, const if_samples_summary *summary)
+{
+    char buf[64];
+
+#define IF_SAMPLES_MEAS_ADD(_name, _aggr, _val) \
+    te_mi_logger_add_meas(logger, NULL, type, _name, _aggr, _val,   \
+                          TE_MI_MEAS_MULTIPLIER_PLAIN)
+
+    IF_SAMPLES_MEAS_ADD(name, TE_MI_MEAS_AGGR_MEAN, summary->mean);
+    IF_SAMPLES_MEAS_ADD(name, TE_MI_MEAS_AGGR_MIN, summary->min);
+    IF_SAMPLES_MEAS_ADD(name, TE_MI_MEAS_AGGR_MAX, summary->max);
+    IF_SAMPLES_MEAS_ADD(name, TE_MI_MEAS_AGGR_MEDIAN, summary->median);
+
+    TE_SPRINTF(buf, "%s (90)", name);
+    IF_SAMPLES_MEAS_ADD(buf, TE_MI_MEAS_AGGR_PERCENTILE, summary->p90);
+    TE_SPRINTF(buf, "%s (99)", name);
+    IF_SAMPLES_MEAS_ADD(buf, TE_MI_MEAS_AGGR_PERCENTILE, summary->p99);
+    TE_SPRINTF(buf, "%s (99.9)", name);
+    IF_SAMPLES_MEAS_ADD(buf, TE_MI_MEAS_AGGR_PERCENTILE, summary->p999);
+
+#undef IF_SAMPLES_MEAS_ADD
+}
+
+/** Rate of a counter between two samples, per second */
+#define IF_SAMPLES_RATE(_s1, _s2, _field) \
+    ((double)((_s2)->_field - (_s1)->_field) * 1000000000.0 /   \
+     (double)((_s2)->ts_ns - (_s1)->ts_ns))
+
+/** Number of rates calculated between samples */
+#define IF_SAMPLES_RATES_NUM 4
+
+/**
+ * Calculate rx/tx packet rates and rx/tx throughput between samples.
+ *
+ * @param s1            Earlier sample
+ * @param s2            Later sample
+ * @param rates         Where to save the rates
+ */
+static void
+if_samples_rates(const tapi_cfg_if_sample *s1,
+                 const tapi_cfg_if_sample *s2,
+                 double rates[IF_SAMPLES_RATES_NUM])
+{
+    rates[0] = IF_SAMPLES_RATE(s1, s2, rx_packets);
+    rates[1] = IF_SAMPLES_RATE(s1, s2, tx_packets);
+    rates[2] = IF_SAMPLES_RATE(s1, s2, rx_bytes) * 8;
+    rates[3] = IF_SAMPLES_RATE(s1, s2, tx_bytes) * 8;
+}
+
+/* See description in tapi_cfg_stats.h */
+te_errno
+tapi_cfg_stats_if_samples_log(te_mi_logger *logger,
+                              const tapi_cfg_if_sample *samples,
+                              unsigned int n_samples,
+                              unsigned int max_points)
+{
+    unsigned int    n = n_samples - 1;
+    double         *values[IF_SAMPLES_RATES_NUM];
+    double          rates[IF_SAMPLES_RATES_NUM];
+    const char     *names[IF_SAMPLES_RATES_NUM] = {
+        "rx", "tx", "rx", "tx"
+    };
+    te_mi_meas_type types[IF_SAMPLES_RATES_NUM] = {
+        TE_MI_MEAS_PPS, TE_MI_MEAS_PPS,
+        TE_MI_MEAS_THROUGHPUT, TE_MI_MEAS_THROUGHPUT
+    };
+    unsigned int    step;
+    unsigned int    i;
+    unsigned int    j;
+
+    if (n_samples < 2)
+    {
+        ERROR("%s(): at least two samples are required", __FUNCTION__);
+        return TE_RC(TE_TAPI, TE_ENODATA);
+    }
+
+    for (j = 0; j < TE_ARRAY_LEN(values); j++)
+    {
+        values[j] = calloc(n, sizeof(double));
+        if (values[j] == NULL)
+        {
+            while (j-- > 0)
+                free(values[j]);
+            return TE_RC(TE_TAPI, TE_ENOMEM);
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if_samples_rates(&samples[i], &samples[i + 1], rates);
+        for (j = 0; j < TE_ARRAY_LEN(rates); j++)
+            values[j][i] = rates[j];
+    }
+
+    for (j = 0; j < TE_ARRAY_LEN(values); j++)
+    {
+        if_samples_summary summary;
+
+        if_samples_summarize(values[j], n, &summary);
+        if_samples_summary_log(logger, types[j], names[j], &summary);
+        free(values[j]);
+    }
+
+    te_mi_logger_add_meas_key(logger, NULL, "Sampling interval",
+                              "%.0f ns",
+                              (double)(samples[n].ts_ns - samples[0].ts_ns) /
+                              n);
+
+    if (max_points == 0)
+        return 0;
+
+    /* Time series: merge adjacent intervals to fit into max_points */
+    step = (n + max_points - 1) / max_points;
+    for (i = 0; i < n; i += step)
+    {
+        if_samples_rates(&samples[i], &samples[MIN(i + step, n)], rates);
+
+        for (j = 0; j < TE_ARRAY_LEN(rates); j++)
+        {
+            te_mi_logger_add_meas(logger, NULL, types[j],
+                                  j % 2 == 0 ? "rx series" : "tx series",
+                                  TE_MI_MEAS_AGGR_SINGLE, rates[j],
+                                  TE_MI_MEAS_MULTIPLIER_PLAIN);
+        }
+    }
+
+    te_mi_logger_add_meas_key(logger, NULL, "Series interval", "%.0f ns",
+                              (double)(samples[n].ts_ns -
+                                       samples[0].ts_ns) * step / n);
+
+    te_mi_logger_add_meas_view(logger, NULL, TE_MI_MEAS_VIEW_LINE_GRAPH,
+                               "pps", "Packet rate");
+    te_mi_logger_add_meas_view(logger, NULL, TE_MI_MEAS_VIEW_LINE_GRAPH,
+                               "throughput", "Throughput");
+    te_mi_logger_meas_graph_axis_add_name(logger, NULL,
+                                          TE_MI_MEAS_VIEW_LINE_GRAPH,
+                                          "pps", TE_MI_GRAPH_AXIS_X,
+                                          TE_MI_GRAPH_AUTO_SEQNO);
+    te_mi_logger_meas_graph_axis_add_name(logger, NULL,
+                                          TE_MI_MEAS_VIEW_LINE_GRAPH,
+                                          "throughput", TE_MI_GRAPH_AXIS_X,
+                                          TE_MI_GRAPH_AUTO_SEQNO);
+
+    for (j = 0; j < TE_ARRAY_LEN(types); j++)
+    {
+        te_mi_logger_meas_graph_axis_add(logger, NULL,
+                                         TE_MI_MEAS_VIEW_LINE_GRAPH,
+                                         j < 2 ? "pps" : "throughput",
+                                         TE_MI_GRAPH_AXIS_Y, types[j],
+                                         j % 2 == 0 ? "rx series" :
+                                                      "tx series");
+    }
+
+    return 0;
+}
@@ -19,6 +19,7 @@
 #endif
 
 #include "te_errno.h"
+#include "te_mi_log.h"
 #include "conf_api.h"
 
 
@@ -157,6 +158,75 @@ extern te_errno
 tapi_cfg_stats_net_stats_print(const char           *ta,
                                tapi_cfg_net_stats   *stats);
 
+/** Sample of interface counters collected by the agent sampler */
+typedef struct tapi_cfg_if_sample {
+    uint64_t      ts_ns;        /**< Monotonic timestamp, nanoseconds */
+    uint64_t      rx_packets;   /**< Received packets */
+    uint64_t      tx_packets;   /**< Transmitted packets */
+    uint64_t      rx_bytes;     /**< Received bytes */
+    uint64_t      tx_bytes;     /**< Transmitted bytes */
+    uint64_t      rx_errors;    /**< Receive errors */
+    uint64_t      tx_errors;    /**< Transmit errors */
+    uint64_t      rx_dropped;   /**< Packets dropped on receive */
+    uint64_t      tx_dropped;   /**< Packets dropped on transmit */
+} tapi_cfg_if_sample;
+
+/**
+ * Start high-frequency sampling of interface counters on the agent.
+ * Counters are read by the agent itself, so the rate is not limited
+ * by Configurator round trips.
+ *
+ * @param ta            Test Agent
+ * @param ifname        Network interface
+ * @param rate          Sampling rate, Hz (@c 0 - agent default)
+ * @param size          Capacity of the agent ring buffer; the oldest
+ *                      samples are overwritten when it is full
+ *                      (@c 0 - agent default)
+ *
+ * @return Status code
+ */
+extern te_errno tapi_cfg_stats_if_sampler_start(const char *ta,
+                                                const char *ifname,
+                                                unsigned int rate,
+                                                unsigned int size);
+
+/**
+ * Stop sampling of interface counters on the agent and fetch
+ * collected samples in bulk.
+ *
+ * @param ta            Test Agent
+ * @param ifname        Network interface
+ * @param samples       Location for the array of samples in the order
+ *                      of sampling (should be released with free())
+ * @param n_samples     Location for the number of samples
+ *
+ * @return Status code
+ */
+extern te_errno tapi_cfg_stats_if_sampler_stop(const char *ta,
+                                               const char *ifname,
+                                               tapi_cfg_if_sample **samples,
+                                               unsigned int *n_samples);
+
+/**
+ * Add MI measurements calculated from samples of interface counters:
+ * mean, minimum, maximum, median and 90/99/99.9 percentiles of rx/tx
+ * packet rates and throughput over sampling intervals, and time series
+ * of the rates with line graph views.
+ *
+ * @param logger        MI logger
+ * @param samples       Samples
+ * @param n_samples     Number of samples (at least 2)
+ * @param max_points    Maximum number of points in time series
+ *                      (intervals are merged if there are more of them,
+ *                      @c 0 - do not add time series)
+ *
+ * @return Status code
+ */
+extern te_errno tapi_cfg_stats_if_samples_log(te_mi_logger *logger,
+                                    const tapi_cfg_if_sample *samples,
+                                    unsigned int n_samples,
+                                    unsigned int max_points);
+
 /**@} <!-- END tapi_conf_stats --> */
 
 #ifdef __cplusplus
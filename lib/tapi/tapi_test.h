@@ -196,6 +196,14 @@ extern "C" {
     (void)signal(SIGUSR1, te_test_sig_handler);                     \
     (void)signal(SIGUSR2, te_test_sig_handler);                     \
                                                                     \
+    /*                                                              \
+     * If the test is started as a test server, the function        \
+     * returns in a forked process with arguments of the iteration. \
+     * Initialization above does not depend on arguments and does   \
+     * not connect to TE subsystems, so it is shared by iterations. \
+     */                                                             \
+    te_test_zygote_serve(&argc, &argv);                             \
+                                                                    \
     /*                                                              \
      * Get te_test_id parameter which is required to associate      \
      * further logs with the test (including steps and jump point   \
@@ -1668,6 +1676,23 @@ test_octet_strings2list(const char *str, unsigned int str_len,
  */
 extern void te_test_sig_handler(int signum);
 
+/**
+ * Serve requests of Tester to run test iterations if the test
+ * executable is started as a test server (zygote). The server forks
+ * a process per request and never returns itself. Forked processes
+ * return with arguments received from Tester.
+ *
+ * The function returns immediately if the test is started as usual.
+ * It must be called before any connection to TE subsystems is made
+ * (including logging), since they are bound to the process.
+ *
+ * @param argc      Location of the number of arguments (without
+ *                  the program name)
+ * @param argv      Location of the vector of arguments (the program
+ *                  name is expected just before the first argument)
+ */
+extern void te_test_zygote_serve(int *argc, char ***argv);
+
 /* Scalable sleep primitives */
 
 /** Maximum allowed sleep scale */
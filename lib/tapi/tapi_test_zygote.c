@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Test API
+ *
+ * Test server (zygote) mode of test executables.
+ *
+ * When Tester starts a test executable with the control socket
+ * descriptor in the environment, the executable stays resident and
+ * forks a process per iteration requested by Tester. Test processes
+ * return from te_test_zygote_serve() and continue as if they were
+ * started by Tester with the received arguments.
+ *
+ * TE logger, Configurator and RCF API clients are bound to the process
+ * which creates them, so the server does not use them and reports
+ * errors to standard error output.
+ *
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "TAPI Zygote"
+
+#include "te_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "te_defs.h"
+#include "te_str.h"
+#include "tester_msg.h"
+
+#include "tapi_test.h"
+
+/** Report an error of the test server and terminate it */
+static void
+zygote_fatal(const char *what)
+{
+    fprintf(stderr, "Test server %u: %s failed: %s\n",
+            (unsigned int)getpid(), what, strerror(errno));
+    exit(TE_EXIT_ERROR);
+}
+
+/** Send a message to Tester */
+static void
+zygote_send(int sock, te_test_zygote_msg_type type, int value)
+{
+    tester_zygote_msg msg = { .type = type, .value = value };
+
+    if (send(sock, &msg, sizeof(msg), MSG_NOSIGNAL) != sizeof(msg))
+        zygote_fatal("send()");
+}
+
+/**
+ * Receive a request from Tester.
+ *
+ * @param sock          Control socket
+ * @param p_buf         Location for the request packet
+ *
+ * @return Length of the request or @c 0 if Tester closed the socket.
+ */
+static size_t
+zygote_recv(int sock, char **p_buf)
+{
+    ssize_t     len;
+    char       *buf;
+
+    do {
+        len = recv(sock, NULL, 0, MSG_PEEK | MSG_TRUNC);
+    } while (len < 0 && errno == EINTR);
+    if (len < 0)
+        zygote_fatal("recv()");
+    if (len == 0)
+        return 0;
+
+    /* Terminate the last argument even if Tester does not */
+    buf = calloc(1, len + 1);
+    if (buf == NULL)
+        zygote_fatal("calloc()");
+
+    do {
+        len = recv(sock, buf, len, 0);
+    } while (len < 0 && errno == EINTR);
+    if (len <= 0)
+        zygote_fatal("recv()");
+
+    *p_buf = buf;
+
+    return len;
+}
+
+/**
+ * Make the vector of arguments from the request packet.
+ *
+ * @param prog          Program name to be put before the arguments
+ * @param buf           Request packet
+ * @param len           Length of the request
+ * @param p_argc        Location for the number of arguments
+ *
+ * @return Vector of arguments referring to the packet (the program name
+ *         is just before it as test_get_filename_param() expects).
+ */
+static char **
+zygote_args(char *prog, char *buf, size_t len, int *p_argc)
+{
+    char      **argv;
+    char       *p;
+    int         argc = 1;
+
+    for (p = buf; p < buf + len; p += strlen(p) + 1)
+        argc++;
+
+    argv = calloc(argc + 1, sizeof(*argv));
+    if (argv == NULL)
+        zygote_fatal("calloc()");
+
+    argv[0] = prog;
+    argc = 1;
+    for (p = buf; p < buf + len; p += strlen(p) + 1)
+        argv[argc++] = p;
+
+    *p_argc = argc - 1;
+
+    return argv + 1;
+}
+
+/** Signals ignored by the test server and handled by test processes */
+static const int zygote_signals[] = { SIGINT, SIGUSR1, SIGUSR2 };
+
+/* See description in tapi_test.h */
+void
+te_test_zygote_serve(int *argc, char ***argv)
+{
+    const char     *sock_str = getenv(TESTER_ZYGOTE_FD_ENV);
+    void          (*handlers[TE_ARRAY_LEN(zygote_signals)])(int);
+    int             sock;
+    char           *buf = NULL;
+    size_t          len;
+    pid_t           pid;
+    int             status;
+    unsigned int    i;
+
+    if (sock_str == NULL)
+        return;
+
+    if (te_strtoi(sock_str, 0, &sock) != 0 || sock < 0)
+    {
+        fprintf(stderr, "Invalid value of %s: '%s'\n",
+                TESTER_ZYGOTE_FD_ENV, sock_str);
+        exit(TE_EXIT_ERROR);
+    }
+    /* Test processes and programs they run must not see it */
+    unsetenv(TESTER_ZYGOTE_FD_ENV);
+
+    /*
+     * Interruption is handled by test processes, the server exits
+     * when Tester closes the control socket.
+     */
+    for (i = 0; i < TE_ARRAY_LEN(zygote_signals); i++)
+        handlers[i] = signal(zygote_signals[i], SIG_IGN);
+
+    zygote_send(sock, TE_TEST_ZYGOTE_READY, 0);
+
+    while ((len = zygote_recv(sock, &buf)) > 0)
+    {
+        pid = fork();
+        if (pid < 0)
+            zygote_fatal("fork()");
+
+        if (pid == 0)
+        {
+            close(sock);
+            for (i = 0; i < TE_ARRAY_LEN(zygote_signals); i++)
+                (void)signal(zygote_signals[i], handlers[i]);
+            /* Tester signals the whole process group of the test */
+            setpgid(0, 0);
+            *argv = zygote_args((*argv)[-1], buf, len, argc);
+            return;
+        }
+
+        /* Avoid race with the child to signal the group by Tester */
+        setpgid(pid, pid);
+        free(buf);
+        buf = NULL;
+        zygote_send(sock, TE_TEST_ZYGOTE_STARTED, pid);
+
+        while (waitpid(pid, &status, 0) < 0)
+        {
+            if (errno != EINTR)
+                zygote_fatal("waitpid()");
+        }
+        zygote_send(sock, TE_TEST_ZYGOTE_DONE, status);
+    }
+
+    exit(EXIT_SUCCESS);
+}
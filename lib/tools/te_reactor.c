@@ -0,0 +1,434 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Event loop
+ *
+ * Implementation of the event loop based on epoll and a hashed timing
+ * wheel.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER     "Reactor"
+
+#include "te_config.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "te_alloc.h"
+#include "te_reactor.h"
+#include "logger_api.h"
+
+/** Maximum number of events dispatched by one epoll_wait() call */
+#define TE_REACTOR_MAX_EVENTS   64
+
+/** Watched file descriptor */
+struct te_reactor_fd {
+    LIST_ENTRY(te_reactor_fd)   links;      /**< Links in the list of
+                                                 active or deleted
+                                                 descriptors */
+    int                         fd;         /**< File descriptor */
+    te_reactor_fd_cb           *cb;         /**< Readiness callback */
+    void                       *opaque;     /**< Callback data */
+    te_bool                     deleted;    /**< Watch is deleted, but
+                                                 may still be referred
+                                                 by pending events */
+};
+
+/** List of timers */
+LIST_HEAD(te_reactor_timers, te_reactor_timer);
+
+/** Event loop */
+struct te_reactor {
+    int                             epfd;   /**< epoll descriptor */
+
+    LIST_HEAD(, te_reactor_fd)      fds;    /**< Watched descriptors */
+    LIST_HEAD(, te_reactor_fd)      garbage; /**< Deleted descriptors
+                                                  to be freed after
+                                                  events dispatching */
+
+    struct te_reactor_timers        wheel[TE_REACTOR_WHEEL_SIZE];
+                                            /**< Timing wheel */
+    uint64_t                        tick;   /**< The first tick which
+                                                 wheel slot is not
+                                                 visited yet */
+};
+
+/**
+ * Get monotonic time.
+ *
+ * @return Time in milliseconds.
+ */
+static uint64_t
+reactor_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+#if HAVE_SYS_EPOLL_H
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_create(te_reactor **reactor)
+{
+    te_reactor  *r;
+    unsigned int i;
+
+    r = TE_ALLOC(sizeof(*r));
+    if (r == NULL)
+        return TE_RC(TE_MODULE_NONE, TE_ENOMEM);
+
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (r->epfd < 0)
+    {
+        te_errno rc = TE_OS_RC(TE_MODULE_NONE, errno);
+
+        ERROR("Failed to create epoll descriptor: %r", rc);
+        free(r);
+        return rc;
+    }
+
+    LIST_INIT(&r->fds);
+    LIST_INIT(&r->garbage);
+    for (i = 0; i < TE_ARRAY_LEN(r->wheel); i++)
+        LIST_INIT(&r->wheel[i]);
+    r->tick = reactor_now() / TE_REACTOR_TICK;
+
+    *reactor = r;
+    return 0;
+}
+
+/**
+ * Start watching a file descriptor for given events.
+ *
+ * @param reactor       Event loop
+ * @param fd            File descriptor
+ * @param events        epoll events
+ * @param cb            Callback
+ * @param opaque        Opaque data passed to the callback
+ * @param watch         Location for the watch handle (may be @c NULL)
+ *
+ * @return Status code.
+ */
+static te_errno
+reactor_add(te_reactor *reactor, int fd, uint32_t events,
+            te_reactor_fd_cb *cb, void *opaque, te_reactor_fd **watch)
+{
+    struct epoll_event  ev = { .events = events };
+    te_reactor_fd      *w;
+
+    w = TE_ALLOC(sizeof(*w));
+    if (w == NULL)
+        return TE_RC(TE_MODULE_NONE, TE_ENOMEM);
+
+    w->fd = fd;
+    w->cb = cb;
+    w->opaque = opaque;
+
+    ev.data.ptr = w;
+    if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        te_errno rc = TE_OS_RC(TE_MODULE_NONE, errno);
+
+        ERROR("Failed to watch descriptor %d: %r", fd, rc);
+        free(w);
+        return rc;
+    }
+
+    LIST_INSERT_HEAD(&reactor->fds, w, links);
+    if (watch != NULL)
+        *watch = w;
+
+    return 0;
+}
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_add_fd(te_reactor *reactor, int fd, te_reactor_fd_cb *cb,
+                  void *opaque, te_reactor_fd **watch)
+{
+    return reactor_add(reactor, fd, EPOLLIN, cb, opaque, watch);
+}
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_add_fd_out(te_reactor *reactor, int fd, te_reactor_fd_cb *cb,
+                      void *opaque, te_reactor_fd **watch)
+{
+    return reactor_add(reactor, fd, EPOLLOUT, cb, opaque, watch);
+}
+
+/* See description in te_reactor.h */
+void
+te_reactor_del_fd(te_reactor *reactor, te_reactor_fd *watch)
+{
+    if (watch == NULL || watch->deleted)
+        return;
+
+    if (epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, watch->fd, NULL) != 0)
+    {
+        WARN("Failed to stop watching descriptor %d: %r", watch->fd,
+             TE_OS_RC(TE_MODULE_NONE, errno));
+    }
+
+    watch->deleted = TRUE;
+    LIST_REMOVE(watch, links);
+    LIST_INSERT_HEAD(&reactor->garbage, watch, links);
+}
+
+/**
+ * Wait for descriptors readiness and dispatch it.
+ *
+ * @param reactor       Event loop
+ * @param timeout       Timeout in milliseconds
+ *
+ * @return Status code.
+ */
+static te_errno
+reactor_poll(te_reactor *reactor, int timeout)
+{
+    struct epoll_event  events[TE_REACTOR_MAX_EVENTS];
+    te_reactor_fd      *w;
+    int                 n;
+    int                 i;
+
+    n = epoll_wait(reactor->epfd, events, TE_ARRAY_LEN(events), timeout);
+    if (n < 0)
+        return errno == EINTR ? 0 : TE_OS_RC(TE_MODULE_NONE, errno);
+
+    for (i = 0; i < n; i++)
+    {
+        w = events[i].data.ptr;
+        if (!w->deleted)
+            w->cb(w->fd, w->opaque);
+    }
+
+    while ((w = LIST_FIRST(&reactor->garbage)) != NULL)
+    {
+        LIST_REMOVE(w, links);
+        free(w);
+    }
+
+    return 0;
+}
+
+#else /* !HAVE_SYS_EPOLL_H */
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_create(te_reactor **reactor)
+{
+    UNUSED(reactor);
+    return TE_RC(TE_MODULE_NONE, TE_ENOSYS);
+}
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_add_fd(te_reactor *reactor, int fd, te_reactor_fd_cb *cb,
+                  void *opaque, te_reactor_fd **watch)
+{
+    UNUSED(reactor);
+    UNUSED(fd);
+    UNUSED(cb);
+    UNUSED(opaque);
+    UNUSED(watch);
+    return TE_RC(TE_MODULE_NONE, TE_ENOSYS);
+}
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_add_fd_out(te_reactor *reactor, int fd, te_reactor_fd_cb *cb,
+                      void *opaque, te_reactor_fd **watch)
+{
+    UNUSED(reactor);
+    UNUSED(fd);
+    UNUSED(cb);
+    UNUSED(opaque);
+    UNUSED(watch);
+    return TE_RC(TE_MODULE_NONE, TE_ENOSYS);
+}
+
+/* See description in te_reactor.h */
+void
+te_reactor_del_fd(te_reactor *reactor, te_reactor_fd *watch)
+{
+    UNUSED(reactor);
+    UNUSED(watch);
+}
+
+static te_errno
+reactor_poll(te_reactor *reactor, int timeout)
+{
+    UNUSED(reactor);
+    UNUSED(timeout);
+    return TE_RC(TE_MODULE_NONE, TE_ENOSYS);
+}
+
+#endif /* !HAVE_SYS_EPOLL_H */
+
+/* See description in te_reactor.h */
+void
+te_reactor_destroy(te_reactor *reactor)
+{
+    te_reactor_fd *w;
+
+    if (reactor == NULL)
+        return;
+
+    while ((w = LIST_FIRST(&reactor->fds)) != NULL)
+    {
+        LIST_REMOVE(w, links);
+        free(w);
+    }
+    while ((w = LIST_FIRST(&reactor->garbage)) != NULL)
+    {
+        LIST_REMOVE(w, links);
+        free(w);
+    }
+
+    close(reactor->epfd);
+    free(reactor);
+}
+
+/* See description in te_reactor.h */
+void
+te_reactor_timer_init(te_reactor_timer *timer, te_reactor_timer_cb *cb,
+                      void *opaque)
+{
+    timer->armed = FALSE;
+    timer->cb = cb;
+    timer->opaque = opaque;
+}
+
+/* See description in te_reactor.h */
+void
+te_reactor_timer_start(te_reactor *reactor, te_reactor_timer *timer,
+                       unsigned int timeout)
+{
+    te_reactor_timer_stop(timer);
+
+    /*
+     * The timer is fired when its tick is over, so it is never fired
+     * earlier than requested and at most one tick later.
+     */
+    timer->expire = (reactor_now() + timeout) / TE_REACTOR_TICK;
+    timer->armed = TRUE;
+    LIST_INSERT_HEAD(&reactor->wheel[timer->expire % TE_REACTOR_WHEEL_SIZE],
+                     timer, links);
+}
+
+/* See description in te_reactor.h */
+void
+te_reactor_timer_stop(te_reactor_timer *timer)
+{
+    if (timer->armed)
+    {
+        LIST_REMOVE(timer, links);
+        timer->armed = FALSE;
+    }
+}
+
+/**
+ * Check whether there are running timers.
+ *
+ * @param reactor       Event loop
+ *
+ * @return @c TRUE if there are running timers.
+ */
+static te_bool
+reactor_has_timers(const te_reactor *reactor)
+{
+    unsigned int i;
+
+    for (i = 0; i < TE_ARRAY_LEN(reactor->wheel); i++)
+    {
+        if (!LIST_EMPTY(&reactor->wheel[i]))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Visit wheel slots of all ticks which are over and fire expired timers.
+ *
+ * @param reactor       Event loop
+ */
+static void
+reactor_expire(te_reactor *reactor)
+{
+    struct te_reactor_timers    expired;
+    te_reactor_timer           *timer;
+    te_reactor_timer           *next;
+    uint64_t                    now = reactor_now() / TE_REACTOR_TICK;
+
+    /* Each slot is visited at most once however long the loop slept */
+    if (now - reactor->tick > TE_REACTOR_WHEEL_SIZE)
+        reactor->tick = now - TE_REACTOR_WHEEL_SIZE;
+
+    LIST_INIT(&expired);
+    for (; reactor->tick < now; reactor->tick++)
+    {
+        struct te_reactor_timers *slot;
+
+        slot = &reactor->wheel[reactor->tick % TE_REACTOR_WHEEL_SIZE];
+        LIST_FOREACH_SAFE(timer, slot, links, next)
+        {
+            if (timer->expire <= reactor->tick)
+            {
+                LIST_REMOVE(timer, links);
+                LIST_INSERT_HEAD(&expired, timer, links);
+            }
+        }
+    }
+
+    /*
+     * Callbacks may stop other expired timers, so the list is
+     * re-read after each callback.
+     */
+    while ((timer = LIST_FIRST(&expired)) != NULL)
+    {
+        te_reactor_timer_stop(timer);
+        if (timer->cb != NULL)
+            timer->cb(timer, timer->opaque);
+    }
+}
+
+/* See description in te_reactor.h */
+te_errno
+te_reactor_run(te_reactor *reactor, int timeout)
+{
+    te_errno rc;
+
+    if (reactor_has_timers(reactor))
+    {
+        uint64_t now = reactor_now();
+        uint64_t tick_end = (reactor->tick + 1) * TE_REACTOR_TICK;
+        int      to_tick = tick_end > now ? (int)(tick_end - now) : 0;
+
+        if (timeout < 0 || to_tick < timeout)
+            timeout = to_tick;
+    }
+    else
+    {
+        /* Nothing to expire, idle ticks are skipped at once */
+        reactor->tick = reactor_now() / TE_REACTOR_TICK;
+    }
+
+    rc = reactor_poll(reactor, timeout);
+    reactor_expire(reactor);
+
+    return rc;
+}
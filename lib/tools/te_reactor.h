@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Event loop
+ *
+ * @defgroup te_tools_te_reactor Event loop
+ * @ingroup te_tools
+ * @{
+ *
+ * Single-threaded event loop which dispatches readiness of file
+ * descriptors and expiration of timers to callbacks.
+ *
+ * Descriptors are watched with epoll, so the cost of waiting does not
+ * depend on the number of watched descriptors and there is no limit
+ * of @c FD_SETSIZE. Timers are kept in a hashed timing wheel with
+ * @ref TE_REACTOR_TICK granularity: starting and stopping a timer
+ * is O(1) and each tick only visits timers of one wheel slot, so
+ * thousands of request timeouts cost nothing until they expire.
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ *
+ *
+ * @section te_tools_te_reactor_example Example of usage
+ *
+ * @code
+ * static void
+ * sock_ready(int fd, void *opaque)
+ * {
+ *     ... read from fd ...
+ * }
+ *
+ * static void
+ * req_timeout(te_reactor_timer *timer, void *opaque)
+ * {
+ *     ... fail the request ...
+ * }
+ *
+ * te_reactor      *reactor;
+ * te_reactor_fd   *watch;
+ * te_reactor_timer timer;
+ *
+ * CHECK_RC(te_reactor_create(&reactor));
+ * CHECK_RC(te_reactor_add_fd(reactor, sock, sock_ready, NULL, &watch));
+ * te_reactor_timer_init(&timer, req_timeout, NULL);
+ * te_reactor_timer_start(reactor, &timer, 5000);
+ * while (!done)
+ *     CHECK_RC(te_reactor_run(reactor, 1000));
+ * te_reactor_del_fd(reactor, watch);
+ * te_reactor_destroy(reactor);
+ * @endcode
+ */
+
+#ifndef __TE_REACTOR_H__
+#define __TE_REACTOR_H__
+
+#include "te_defs.h"
+#include "te_errno.h"
+#include "te_stdint.h"
+#include "te_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Timer granularity in milliseconds */
+#define TE_REACTOR_TICK         100
+
+/** Number of slots in the timing wheel */
+#define TE_REACTOR_WHEEL_SIZE   256
+
+/** Event loop */
+typedef struct te_reactor te_reactor;
+
+/** Watched file descriptor */
+typedef struct te_reactor_fd te_reactor_fd;
+
+/**
+ * Callback invoked when a watched file descriptor is readable
+ * (or writable if it is watched for writability), or has an error
+ * or hang-up condition pending.
+ *
+ * The callback may add and delete watched descriptors (including
+ * its own one) and start and stop timers.
+ *
+ * @param fd        File descriptor
+ * @param opaque    Opaque data passed to te_reactor_add_fd()
+ */
+typedef void (te_reactor_fd_cb)(int fd, void *opaque);
+
+/** Timer */
+typedef struct te_reactor_timer te_reactor_timer;
+
+/**
+ * Callback invoked when a timer expires.
+ *
+ * The timer is stopped before the callback is invoked, so the callback
+ * may start it again. It may also stop any other timers.
+ *
+ * @param timer     Expired timer
+ * @param opaque    Opaque data passed to te_reactor_timer_init()
+ */
+typedef void (te_reactor_timer_cb)(te_reactor_timer *timer, void *opaque);
+
+/**
+ * Timer. It is embedded into the user structure, so that arming
+ * it does not allocate memory. Zeroed timer is a valid stopped timer
+ * without a callback.
+ */
+struct te_reactor_timer {
+    LIST_ENTRY(te_reactor_timer)    links;  /**< Links in wheel slot */
+    te_bool                         armed;  /**< Timer is running */
+    uint64_t                        expire; /**< Tick of expiration */
+    te_reactor_timer_cb            *cb;     /**< Expiration callback */
+    void                           *opaque; /**< Callback data */
+};
+
+/**
+ * Create an event loop.
+ *
+ * @param reactor       Location for the event loop
+ *
+ * @return Status code.
+ * @retval TE_ENOSYS    epoll is not supported on the platform.
+ */
+extern te_errno te_reactor_create(te_reactor **reactor);
+
+/**
+ * Destroy an event loop. Watched descriptors are not closed,
+ * running timers are just forgotten.
+ *
+ * @param reactor       Event loop (may be @c NULL)
+ */
+extern void te_reactor_destroy(te_reactor *reactor);
+
+/**
+ * Start watching a file descriptor for readability.
+ *
+ * @param reactor       Event loop
+ * @param fd            File descriptor
+ * @param cb            Callback
+ * @param opaque        Opaque data passed to the callback
+ * @param watch         Location for the watch handle (may be @c NULL
+ *                      if the descriptor is never deleted explicitly)
+ *
+ * @return Status code.
+ */
+extern te_errno te_reactor_add_fd(te_reactor *reactor, int fd,
+                                  te_reactor_fd_cb *cb, void *opaque,
+                                  te_reactor_fd **watch);
+
+/**
+ * Start watching a file descriptor for writability. Readiness is
+ * level-triggered, so the watch should be deleted when the callback
+ * has nothing to write.
+ *
+ * @param reactor       Event loop
+ * @param fd            File descriptor
+ * @param cb            Callback
+ * @param opaque        Opaque data passed to the callback
+ * @param watch         Location for the watch handle (may be @c NULL
+ *                      if the descriptor is never deleted explicitly)
+ *
+ * @return Status code.
+ */
+extern te_errno te_reactor_add_fd_out(te_reactor *reactor, int fd,
+                                      te_reactor_fd_cb *cb, void *opaque,
+                                      te_reactor_fd **watch);
+
+/**
+ * Stop watching a file descriptor. It must be called before the
+ * descriptor is closed, since descriptors inherited by child processes
+ * keep epoll registration alive.
+ *
+ * @param reactor       Event loop
+ * @param watch         Watch handle returned by te_reactor_add_fd()
+ *                      (may be @c NULL)
+ */
+extern void te_reactor_del_fd(te_reactor *reactor, te_reactor_fd *watch);
+
+/**
+ * Wait for events and dispatch them. The function returns after
+ * ready descriptors are processed and expired timers are fired or
+ * when the timeout expires.
+ *
+ * @param reactor       Event loop
+ * @param timeout       Maximum time to wait in milliseconds
+ *                      (negative to wait for an event infinitely)
+ *
+ * @return Status code (interruption by a signal is not an error).
+ */
+extern te_errno te_reactor_run(te_reactor *reactor, int timeout);
+
+/**
+ * Initialize a timer.
+ *
+ * @param timer         Timer
+ * @param cb            Expiration callback
+ * @param opaque        Opaque data passed to the callback
+ */
+extern void te_reactor_timer_init(te_reactor_timer *timer,
+                                  te_reactor_timer_cb *cb, void *opaque);
+
+/**
+ * Start (or restart) a timer.
+ *
+ * @param reactor       Event loop
+ * @param timer         Initialized timer
+ * @param timeout       Timeout in milliseconds (rounded up
+ *                      to @ref TE_REACTOR_TICK)
+ */
+extern void te_reactor_timer_start(te_reactor *reactor,
+                                   te_reactor_timer *timer,
+                                   unsigned int timeout);
+
+/**
+ * Stop a timer. It is safe to stop a timer which is not running.
+ *
+ * @param timer         Timer
+ */
+extern void te_reactor_timer_stop(te_reactor_timer *timer);
+
+/**
+ * Check whether a timer is running.
+ *
+ * @param timer         Timer
+ *
+ * @return @c TRUE if the timer is running.
+ */
+static inline te_bool
+te_reactor_timer_is_armed(const te_reactor_timer *timer)
+{
+    return timer->armed;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+#endif /* !__TE_REACTOR_H__ */
+/**@} <!-- END te_tools_te_reactor --> */
@@ -267,6 +267,7 @@ trc_free_test_iters(trc_test_iters *iters)
 {
     trc_test_iter  *p;
 
+    trc_db_test_iters_index_free(iters);
     while ((p = TAILQ_FIRST(&iters->head)) != NULL)
     {
         TAILQ_REMOVE(&iters->head, p, links);
@@ -283,12 +284,62 @@ trc_free_trc_test(trc_test *test)
         return;
 
     free(test->name);
+    free(test->path);
     free(test->notes);
     free(test->objective);
     free(test->filename);
     trc_free_test_iters(&test->iters);
 }
 
+/**
+ * Check whether users data is attached to iterations of the test or
+ * to tests below.
+ *
+ * @param test      Test
+ *
+ * @return @c TRUE if some users data is found.
+ */
+static te_bool
+trc_db_test_iters_have_users_data(const trc_test *test)
+{
+    const trc_test_iter    *iter;
+    const trc_test         *child;
+
+    TAILQ_FOREACH(iter, &test->iters.head, links)
+    {
+        if (!LIST_EMPTY(&iter->users))
+            return TRUE;
+
+        TAILQ_FOREACH(child, &iter->tests.head, links)
+        {
+            if (!LIST_EMPTY(&child->users) ||
+                trc_db_test_iters_have_users_data(child))
+                return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* See description in trc_db.h */
+void
+trc_db_test_unload(te_trc_db *db, trc_test *test)
+{
+    if (!db->lazy || test->not_loaded)
+        return;
+
+    /* Only tests created from the database may be loaded again */
+    if (db->cache != NULL ? test->cache_off == 0 :
+                            db->xml_doc == NULL || test->node == NULL)
+        return;
+
+    if (trc_db_test_iters_have_users_data(test))
+        return;
+
+    trc_free_test_iters(&test->iters);
+    test->not_loaded = TRUE;
+}
+
 /* See description in trc_db.h */
 void
 trc_free_trc_tests(trc_tests *tests)
@@ -377,6 +428,7 @@ trc_db_close(te_trc_db *db)
     xmlFreeDoc(db->xml_doc);
     free(db->version);
     trc_free_trc_tests(&db->tests);
+    trc_db_cache_close(db);
     free(db);
 }
 
@@ -514,6 +566,7 @@ trc_db_test_delete_wilds(trc_test *test)
     trc_test_iter_arg   *arg;
     trc_test_iter       *tvar;
 
+    trc_db_test_iters_index_free(&test->iters);
     TAILQ_FOREACH_SAFE(p, &test->iters.head, links, tvar)
     {
         TAILQ_FOREACH(arg, &p->args.head, links)
@@ -554,10 +607,22 @@ trc_db_new_test_iter(trc_test *test, unsigned int n_args,
             return NULL;
         }
 
+        /*
+         * Positions of iterations in the index are valid for appended
+         * iterations only. The index is rebuilt on demand if it cannot
+         * be updated.
+         */
         if (insert_before == NULL)
+        {
             TAILQ_INSERT_TAIL(&test->iters.head, p, links);
+            if (trc_db_test_iters_index_add(&test->iters, p) != 0)
+                trc_db_test_iters_index_free(&test->iters);
+        }
         else
+        {
             TAILQ_INSERT_BEFORE(insert_before, p, links);
+            trc_db_test_iters_index_free(&test->iters);
+        }
     }
 
     return p;
@@ -950,7 +1015,7 @@ trc_db_get_test_by_path(te_trc_db *db, char *path)
                             if (strcmp(test->name, path_item) == 0)
                                 break;
 
-                    if (test == NULL)
+                    if (test == NULL || trc_db_test_load(db, test) != 0)
                         return NULL;
                     else
                         iters = &test->iters;
@@ -961,7 +1026,7 @@ trc_db_get_test_by_path(te_trc_db *db, char *path)
                         if (strcmp(test->name, path_item) == 0)
                             break;
 
-                    if (test == NULL)
+                    if (test == NULL || trc_db_test_load(db, test) != 0)
                         return NULL;
                     else
                     {
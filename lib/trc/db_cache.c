@@ -0,0 +1,1463 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/** @file
+ * @brief Testing Results Comparator
+ *
+ * Compiled (binary) representation of TRC database.
+ *
+ * Parsing of XML files of a large TRC database takes a lot of time
+ * and memory. Once parsed, the database is saved in the compiled form
+ * to the cache directory. On the next opening the compiled database is
+ * mapped to memory if none of its source files has been changed, and
+ * iterations of tests are created from it on demand, when a TRC
+ * database walker enters the test.
+ *
+ * The database is not compiled if any of its source files is modified
+ * after parsing is started, so the digest of the files always matches
+ * the parsed contents.
+ *
+ * The file consists of a header, records and NUL-terminated strings.
+ * Records refer to each other and to strings by 32-bit offsets from
+ * the beginning of the file. Offset @c 0 stands for a missing string.
+ * Numbers are in host byte order, files written on a host with other
+ * byte order are considered out of date.
+ *
+ *
+ * Copyright (C) 2023 OKTET Labs Ltd. All rights reserved.
+ */
+
+#define TE_LGR_USER "TRC DB cache"
+
+#include "te_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <openssl/md5.h>
+
+#include <libxml/tree.h>
+
+#include "te_errno.h"
+#include "te_alloc.h"
+#include "te_dbuf.h"
+#include "te_printf.h"
+#include "te_vector.h"
+#include "logger_api.h"
+#include "logic_expr.h"
+
+#include "te_trc.h"
+#include "trc_db.h"
+
+/** Magic of compiled TRC database file */
+#define TRC_DB_CACHE_MAGIC          "TETRCDB"
+
+/** Version of the format, to be incremented on incompatible changes */
+#define TRC_DB_CACHE_FORMAT         1
+
+/** Value to detect byte order of the file */
+#define TRC_DB_CACHE_BYTE_ORDER     0x01020304
+
+/** Suffix of names of compiled TRC database files */
+#define TRC_DB_CACHE_SUFFIX         ".trcdb"
+
+/** Size of chunks in which source files are read to get their digest */
+#define TRC_DB_CACHE_READ_CHUNK     65536
+
+/**
+ * Header of compiled TRC database.
+ *
+ * A list is a number of items followed by items (offsets of records
+ * or strings). Lists of arguments and globals consist of pairs of
+ * name and value.
+ */
+typedef struct trc_db_cache_hdr {
+    char        magic[8];       /**< TRC_DB_CACHE_MAGIC */
+    uint32_t    format;         /**< TRC_DB_CACHE_FORMAT */
+    uint32_t    byte_order;     /**< TRC_DB_CACHE_BYTE_ORDER */
+    uint32_t    size;           /**< Size of the file */
+    uint8_t     digest[MD5_DIGEST_LENGTH];  /**< Digest of source
+                                                 files */
+    uint32_t    location;       /**< Real path of the database */
+    uint32_t    files;          /**< List of source files */
+    uint32_t    version;        /**< Database version */
+    uint32_t    last_match;     /**< Choose the last match expectation */
+    uint32_t    globals;        /**< List of globals */
+    uint32_t    tests;          /**< List of top level tests */
+} trc_db_cache_hdr;
+
+/** Test record */
+typedef struct trc_db_cache_test {
+    uint32_t    name;           /**< Test name */
+    uint32_t    type;           /**< Type of the test */
+    uint32_t    aux;            /**< Is test auxiliary? */
+    uint32_t    objective;      /**< Test objective */
+    uint32_t    notes;          /**< Notes */
+    uint32_t    filename;       /**< File in which the test is described */
+    int32_t     file_pos;       /**< Position of the test in the file */
+    uint32_t    iters;          /**< List of iterations */
+} trc_db_cache_test;
+
+/** Test iteration record */
+typedef struct trc_db_cache_iter {
+    uint32_t    args;           /**< List of arguments */
+    uint32_t    notes;          /**< Notes */
+    uint32_t    exp_default;    /**< Status of the default result plus
+                                     one or @c 0 */
+    uint32_t    exp_results;    /**< List of expected results */
+    uint32_t    tests;          /**< List of children tests */
+    uint32_t    filename;       /**< File in which the iteration is
+                                     described */
+    int32_t     file_pos;       /**< Position of the iteration in
+                                     the file */
+} trc_db_cache_iter;
+
+/** Expected result record */
+typedef struct trc_db_cache_result {
+    uint32_t    tags;           /**< Tags logical expression */
+    uint32_t    key;            /**< BugID-like information */
+    uint32_t    notes;          /**< Notes */
+    uint32_t    entries;        /**< List of result entries */
+} trc_db_cache_result;
+
+/** Expected result entry record */
+typedef struct trc_db_cache_entry {
+    uint32_t    status;         /**< Test status */
+    uint32_t    key;            /**< BugID-like information */
+    uint32_t    notes;          /**< Notes */
+    uint32_t    verdicts;       /**< List of verdicts */
+} trc_db_cache_entry;
+
+/** Compiled TRC database mapped to memory */
+struct trc_db_cache {
+    const uint8_t  *base;       /**< Start of the mapping */
+    size_t          size;       /**< Size of the mapping */
+};
+
+/**
+ * Get the directory of compiled TRC databases.
+ *
+ * @return Allocated path or @c NULL if the cache is disabled.
+ */
+static char *
+cache_dir(void)
+{
+    const char *dir = getenv(TRC_DB_CACHE_DIR_ENV);
+
+    if (dir != NULL)
+        return dir[0] == '\0' ? NULL : strdup(dir);
+
+    dir = getenv("XDG_CACHE_HOME");
+    if (dir != NULL && dir[0] != '\0')
+        return te_sprintf("%s/te/trc", dir);
+
+    dir = getenv("HOME");
+    if (dir != NULL && dir[0] != '\0')
+        return te_sprintf("%s/.cache/te/trc", dir);
+
+    return NULL;
+}
+
+/**
+ * Get the location of the compiled TRC database.
+ *
+ * @param location      Location of the database XML file
+ * @param dir           Directory of compiled databases
+ * @param real_location Location for the real path of the database
+ *
+ * @return Allocated path or @c NULL.
+ */
+static char *
+cache_path(const char *location, const char *dir, char **real_location)
+{
+    unsigned char   digest[MD5_DIGEST_LENGTH];
+    char            name[MD5_DIGEST_LENGTH * 2 + 1];
+    char           *path;
+    unsigned int    i;
+
+    *real_location = realpath(location, NULL);
+    if (*real_location == NULL)
+        return NULL;
+
+    MD5((const unsigned char *)*real_location, strlen(*real_location),
+        digest);
+    for (i = 0; i < MD5_DIGEST_LENGTH; i++)
+        sprintf(name + i * 2, "%02x", digest[i]);
+
+    path = te_sprintf("%s/%s" TRC_DB_CACHE_SUFFIX, dir, name);
+    if (path == NULL)
+    {
+        free(*real_location);
+        *real_location = NULL;
+    }
+
+    return path;
+}
+
+/**
+ * Calculate digest of names and contents of source files.
+ *
+ * Modification time of a file is checked after reading it: if it is
+ * older than the start of parsing, the contents are the parsed ones.
+ * Modification time may be truncated to seconds by the file system,
+ * so files modified in the second parsing is started are considered
+ * changed as well.
+ *
+ * @param files         Vector of file names
+ * @param parse_time    Time when parsing of the files was started or
+ *                      @c 0 to not check modification time
+ * @param digest        Location for the digest
+ *
+ * @return Status code.
+ * @retval TE_EAGAIN    A file is modified after @p parse_time.
+ */
+static te_errno
+cache_files_digest(te_vec *files, time_t parse_time, uint8_t *digest)
+{
+    MD5_CTX         md5;
+    char           *buf;
+    const char    **file;
+    struct stat     st;
+    ssize_t         len;
+    int             fd;
+    te_errno        rc = 0;
+
+    buf = malloc(TRC_DB_CACHE_READ_CHUNK);
+    if (buf == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    MD5_Init(&md5);
+    TE_VEC_FOREACH(files, file)
+    {
+        MD5_Update(&md5, *file, strlen(*file) + 1);
+
+        fd = open(*file, O_RDONLY);
+        if (fd < 0)
+        {
+            rc = TE_OS_RC(TE_TRC, errno);
+            VERB("Cannot open TRC database file '%s': %r", *file, rc);
+            break;
+        }
+        while ((len = read(fd, buf, TRC_DB_CACHE_READ_CHUNK)) > 0)
+            MD5_Update(&md5, buf, len);
+        if (len < 0)
+            rc = TE_OS_RC(TE_TRC, errno);
+        else if (parse_time != 0 && fstat(fd, &st) != 0)
+            rc = TE_OS_RC(TE_TRC, errno);
+        else if (parse_time != 0 && st.st_mtime >= parse_time)
+            rc = TE_RC(TE_TRC, TE_EAGAIN);
+        close(fd);
+        if (rc != 0)
+            break;
+    }
+    MD5_Final(digest, &md5);
+    free(buf);
+
+    return rc;
+}
+
+
+/*
+ * Loading of the compiled TRC database.
+ */
+
+/**
+ * Get a record of the compiled database checking its bounds.
+ *
+ * @param cache         Compiled database
+ * @param off           Offset of the record
+ * @param size          Size of the record
+ *
+ * @return Record or @c NULL if the offset is invalid.
+ */
+static const void *
+cache_rec(const trc_db_cache *cache, uint32_t off, size_t size)
+{
+    if (off == 0 || off % sizeof(uint32_t) != 0 || off > cache->size ||
+        cache->size - off < size)
+        return NULL;
+
+    return cache->base + off;
+}
+
+/**
+ * Get a string of the compiled database.
+ *
+ * @param cache         Compiled database
+ * @param off           Offset of the string
+ * @param str           Location for the string (@c NULL for @c 0 offset)
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_str(const trc_db_cache *cache, uint32_t off, const char **str)
+{
+    if (off == 0)
+    {
+        *str = NULL;
+        return 0;
+    }
+
+    if (off >= cache->size ||
+        memchr(cache->base + off, '\0', cache->size - off) == NULL)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    *str = (const char *)cache->base + off;
+
+    return 0;
+}
+
+/**
+ * Get a copy of a string of the compiled database.
+ *
+ * @param cache         Compiled database
+ * @param off           Offset of the string
+ * @param str           Location for the allocated string
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_strdup(const trc_db_cache *cache, uint32_t off, char **str)
+{
+    const char *s;
+    te_errno    rc;
+
+    rc = cache_str(cache, off, &s);
+    if (rc != 0)
+        return rc;
+
+    *str = NULL;
+    if (s != NULL && (*str = strdup(s)) == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    return 0;
+}
+
+/**
+ * Get a list of the compiled database.
+ *
+ * @param cache         Compiled database
+ * @param off           Offset of the list
+ * @param width         Number of offsets in an item
+ * @param items         Location for the first offset of the first item
+ * @param n_items       Location for the number of items
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_list(const trc_db_cache *cache, uint32_t off, unsigned int width,
+           const uint32_t **items, uint32_t *n_items)
+{
+    const uint32_t *list = cache_rec(cache, off, sizeof(*list));
+
+    if (list == NULL ||
+        (cache->size - off) / sizeof(*list) - 1 <
+            (uint64_t)list[0] * width)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    *n_items = list[0];
+    *items = list + 1;
+
+    return 0;
+}
+
+/**
+ * Create a test which iterations are loaded on demand.
+ *
+ * @param db            TRC database
+ * @param tests         List of tests to add the test to
+ * @param parent        Parent iteration
+ * @param off           Offset of the test record
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_load_test_stub(te_trc_db *db, trc_tests *tests, trc_test_iter *parent,
+                     uint32_t off)
+{
+    const trc_db_cache_test    *rec;
+    const char                 *name;
+    trc_test                   *test;
+    te_errno                    rc;
+
+    rec = cache_rec(db->cache, off, sizeof(*rec));
+    if (rec == NULL)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    rc = cache_str(db->cache, rec->name, &name);
+    if (rc != 0)
+        return rc;
+    if (name == NULL || rec->type > TRC_TEST_PACKAGE)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    test = trc_db_new_test(tests, parent, name);
+    if (test == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    test->type = rec->type;
+    test->aux = (rec->aux != 0);
+    test->file_pos = rec->file_pos;
+    test->cache_off = off;
+    test->not_loaded = TRUE;
+
+    if ((rc = cache_strdup(db->cache, rec->objective,
+                           &test->objective)) != 0 ||
+        (rc = cache_strdup(db->cache, rec->notes, &test->notes)) != 0 ||
+        (rc = cache_strdup(db->cache, rec->filename, &test->filename)) != 0)
+        return rc;
+
+    return 0;
+}
+
+/**
+ * Create tests of the list which iterations are loaded on demand.
+ *
+ * @param db            TRC database
+ * @param tests         List of tests to add tests to
+ * @param parent        Parent iteration
+ * @param off           Offset of the list of test records
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_load_test_stubs(te_trc_db *db, trc_tests *tests,
+                      trc_test_iter *parent, uint32_t off)
+{
+    const uint32_t *items;
+    uint32_t        n_items;
+    uint32_t        i;
+    te_errno        rc;
+
+    rc = cache_list(db->cache, off, 1, &items, &n_items);
+    for (i = 0; rc == 0 && i < n_items; i++)
+        rc = cache_load_test_stub(db, tests, parent, items[i]);
+
+    return rc;
+}
+
+/**
+ * Load an entry of the expected result.
+ *
+ * @param cache         Compiled database
+ * @param off           Offset of the entry record
+ * @param result        Expected result to add the entry to
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_load_entry(const trc_db_cache *cache, uint32_t off,
+                 trc_exp_result *result)
+{
+    const trc_db_cache_entry   *rec;
+    trc_exp_result_entry       *entry;
+    te_test_verdict            *verdict;
+    const uint32_t             *items;
+    uint32_t                    n_items;
+    uint32_t                    i;
+    te_errno                    rc;
+
+    rec = cache_rec(cache, off, sizeof(*rec));
+    if (rec == NULL || rec->status >= TE_TEST_STATUS_MAX)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    entry = TE_ALLOC(sizeof(*entry));
+    if (entry == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+    te_test_result_init(&entry->result);
+    entry->result.status = rec->status;
+    TAILQ_INSERT_TAIL(&result->results, entry, links);
+
+    if ((rc = cache_strdup(cache, rec->key, &entry->key)) != 0 ||
+        (rc = cache_strdup(cache, rec->notes, &entry->notes)) != 0 ||
+        (rc = cache_list(cache, rec->verdicts, 1, &items, &n_items)) != 0)
+        return rc;
+
+    for (i = 0; i < n_items; i++)
+    {
+        verdict = TE_ALLOC(sizeof(*verdict));
+        if (verdict == NULL)
+            return TE_RC(TE_TRC, TE_ENOMEM);
+        TAILQ_INSERT_TAIL(&entry->result.verdicts, verdict, links);
+
+        rc = cache_strdup(cache, items[i], &verdict->str);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Load an expected result.
+ *
+ * @param cache         Compiled database
+ * @param off           Offset of the result record
+ * @param results       List of expected results to add the result to
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_load_result(const trc_db_cache *cache, uint32_t off,
+                  trc_exp_results *results)
+{
+    const trc_db_cache_result  *rec;
+    trc_exp_result             *result;
+    const uint32_t             *items;
+    uint32_t                    n_items;
+    uint32_t                    i;
+    te_errno                    rc;
+
+    rec = cache_rec(cache, off, sizeof(*rec));
+    if (rec == NULL)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    result = TE_ALLOC(sizeof(*result));
+    if (result == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+    TAILQ_INIT(&result->results);
+    STAILQ_INSERT_TAIL(results, result, links);
+
+    if ((rc = cache_strdup(cache, rec->tags, &result->tags_str)) != 0 ||
+        (rc = cache_strdup(cache, rec->key, &result->key)) != 0 ||
+        (rc = cache_strdup(cache, rec->notes, &result->notes)) != 0)
+        return rc;
+
+    /* Expressions are checked when the database is parsed */
+    if (result->tags_str != NULL && result->tags_str[0] != '\0' &&
+        logic_expr_parse(result->tags_str, &result->tags_expr) != 0)
+        result->tags_expr = NULL;
+
+    rc = cache_list(cache, rec->entries, 1, &items, &n_items);
+    for (i = 0; rc == 0 && i < n_items; i++)
+        rc = cache_load_entry(cache, items[i], result);
+
+    return rc;
+}
+
+/**
+ * Load a test iteration.
+ *
+ * @param db            TRC database
+ * @param test          Test to add the iteration to
+ * @param off           Offset of the iteration record
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_load_iter(te_trc_db *db, trc_test *test, uint32_t off)
+{
+    const trc_db_cache         *cache = db->cache;
+    const trc_db_cache_iter    *rec;
+    trc_report_argument        *args;
+    trc_test_iter              *iter;
+    const uint32_t             *items;
+    uint32_t                    n_items;
+    uint32_t                    i;
+    te_errno                    rc;
+
+    rec = cache_rec(cache, off, sizeof(*rec));
+    if (rec == NULL || rec->exp_default > TE_TEST_STATUS_MAX)
+        return TE_RC(TE_TRC, TE_EFMT);
+
+    rc = cache_list(cache, rec->args, 2, &items, &n_items);
+    if (rc != 0)
+        return rc;
+
+    args = TE_ALLOC((n_items + 1) * sizeof(*args));
+    if (args == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    for (i = 0; i < n_items; i++)
+    {
+        if ((rc = cache_str(cache, items[2 * i],
+                            (const char **)&args[i].name)) != 0 ||
+            (rc = cache_str(cache, items[2 * i + 1],
+                            (const char **)&args[i].value)) != 0)
+            break;
+
+        if (args[i].name == NULL || args[i].value == NULL)
+        {
+            rc = TE_RC(TE_TRC, TE_EFMT);
+            break;
+        }
+    }
+
+    iter = NULL;
+    if (rc == 0)
+    {
+        iter = trc_db_new_test_iter(test, n_items, args, NULL);
+        if (iter == NULL)
+            rc = TE_RC(TE_TRC, TE_ENOMEM);
+    }
+    free(args);
+    if (rc != 0)
+        return rc;
+
+    iter->file_pos = rec->file_pos;
+    if (rec->exp_default != 0)
+    {
+        iter->exp_default = exp_defaults_get(rec->exp_default - 1);
+        if (iter->exp_default == NULL)
+            return TE_RC(TE_TRC, TE_ENOMEM);
+    }
+
+    if ((rc = cache_strdup(cache, rec->notes, &iter->notes)) != 0 ||
+        (rc = cache_strdup(cache, rec->filename, &iter->filename)) != 0 ||
+        (rc = cache_list(cache, rec->exp_results, 1,
+                         &items, &n_items)) != 0)
+        return rc;
+
+    for (i = 0; rc == 0 && i < n_items; i++)
+        rc = cache_load_result(cache, items[i], &iter->exp_results);
+    if (rc != 0)
+        return rc;
+
+    return cache_load_test_stubs(db, &iter->tests, iter, rec->tests);
+}
+
+/* See the description in trc_db.h */
+te_errno
+trc_db_cache_test_load(te_trc_db *db, trc_test *test)
+{
+    const trc_db_cache_test    *rec;
+    const uint32_t             *items;
+    uint32_t                    n_items;
+    uint32_t                    i;
+    te_errno                    rc;
+
+    assert(db->cache != NULL);
+    rec = cache_rec(db->cache, test->cache_off, sizeof(*rec));
+    if (rec == NULL)
+        rc = TE_RC(TE_TRC, TE_EFMT);
+    else
+        rc = cache_list(db->cache, rec->iters, 1, &items, &n_items);
+
+    for (i = 0; rc == 0 && i < n_items; i++)
+        rc = cache_load_iter(db, test, items[i]);
+
+    if (rc == 0)
+        rc = trc_db_test_iters_index_build(&test->iters);
+
+    if (rc != 0)
+    {
+        ERROR("Failed to load test '%s' from compiled TRC database: %r",
+              test->path, rc);
+    }
+
+    return rc;
+}
+
+/**
+ * Check that the compiled database is up to date.
+ *
+ * @param cache         Compiled database
+ * @param location      Real path of the database
+ *
+ * @return @c TRUE if the database may be used.
+ */
+static te_bool
+cache_is_valid(const trc_db_cache *cache, const char *location)
+{
+    const trc_db_cache_hdr *hdr = (const trc_db_cache_hdr *)cache->base;
+    te_vec                  files = TE_VEC_INIT(const char *);
+    uint8_t                 digest[MD5_DIGEST_LENGTH];
+    const char             *str;
+    const uint32_t         *items;
+    uint32_t                n_items;
+    uint32_t                i;
+    te_bool                 valid = FALSE;
+
+    if (cache->size < sizeof(*hdr) ||
+        memcmp(hdr->magic, TRC_DB_CACHE_MAGIC,
+               sizeof(TRC_DB_CACHE_MAGIC)) != 0 ||
+        hdr->format != TRC_DB_CACHE_FORMAT ||
+        hdr->byte_order != TRC_DB_CACHE_BYTE_ORDER ||
+        hdr->size != cache->size)
+        return FALSE;
+
+    if (cache_str(cache, hdr->location, &str) != 0 || str == NULL ||
+        strcmp(str, location) != 0)
+        return FALSE;
+
+    if (cache_list(cache, hdr->files, 1, &items, &n_items) != 0)
+        return FALSE;
+
+    for (i = 0; i < n_items; i++)
+    {
+        if (cache_str(cache, items[i], &str) != 0 || str == NULL ||
+            TE_VEC_APPEND(&files, str) != 0)
+            goto out;
+    }
+
+    if (cache_files_digest(&files, 0, digest) == 0 &&
+        memcmp(digest, hdr->digest, sizeof(digest)) == 0)
+        valid = TRUE;
+
+out:
+    te_vec_free(&files);
+
+    return valid;
+}
+
+/**
+ * Free globals of TRC database.
+ *
+ * @param db            TRC database
+ */
+static void
+cache_free_globals(te_trc_db *db)
+{
+    trc_global *g;
+
+    while ((g = TAILQ_FIRST(&db->globals.head)) != NULL)
+    {
+        TAILQ_REMOVE(&db->globals.head, g, links);
+        free(g->name);
+        free(g->value);
+        free(g);
+    }
+}
+
+/**
+ * Load globals and top level tests of TRC database.
+ *
+ * @param db            TRC database
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_load_db(te_trc_db *db)
+{
+    const trc_db_cache_hdr *hdr = (const trc_db_cache_hdr *)db->cache->base;
+    trc_global             *g;
+    const uint32_t         *items;
+    uint32_t                n_items;
+    uint32_t                i;
+    te_errno                rc;
+
+    db->last_match = (hdr->last_match != 0);
+
+    if ((rc = cache_strdup(db->cache, hdr->version, &db->version)) != 0 ||
+        (rc = cache_list(db->cache, hdr->globals, 2,
+                         &items, &n_items)) != 0)
+        return rc;
+
+    for (i = 0; i < n_items; i++)
+    {
+        g = TE_ALLOC(sizeof(*g));
+        if (g == NULL)
+            return TE_RC(TE_TRC, TE_ENOMEM);
+        TAILQ_INSERT_TAIL(&db->globals.head, g, links);
+
+        if ((rc = cache_strdup(db->cache, items[2 * i], &g->name)) != 0 ||
+            (rc = cache_strdup(db->cache, items[2 * i + 1],
+                               &g->value)) != 0)
+            return rc;
+    }
+
+    return cache_load_test_stubs(db, &db->tests, NULL, hdr->tests);
+}
+
+/* See the description in trc_db.h */
+te_errno
+trc_db_cache_open(te_trc_db *db)
+{
+    trc_db_cache   *cache = NULL;
+    char           *dir;
+    char           *path;
+    char           *location = NULL;
+    struct stat     st;
+    void           *base;
+    int             fd;
+    te_errno        rc = TE_RC(TE_TRC, TE_ENOENT);
+
+    dir = cache_dir();
+    if (dir == NULL)
+        return rc;
+
+    path = cache_path(db->filename, dir, &location);
+    free(dir);
+    if (path == NULL)
+        return rc;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        VERB("No compiled TRC database '%s'", path);
+        goto out;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(trc_db_cache_hdr) ||
+        st.st_size > UINT32_MAX)
+    {
+        close(fd);
+        goto out;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        WARN("Failed to map compiled TRC database '%s': %s", path,
+             strerror(errno));
+        goto out;
+    }
+
+    cache = TE_ALLOC(sizeof(*cache));
+    if (cache == NULL)
+    {
+        munmap(base, st.st_size);
+        rc = TE_RC(TE_TRC, TE_ENOMEM);
+        goto out;
+    }
+    cache->base = base;
+    cache->size = st.st_size;
+
+    if (!cache_is_valid(cache, location))
+    {
+        INFO("Compiled TRC database '%s' is out of date", path);
+        goto out;
+    }
+
+    db->cache = cache;
+    rc = cache_load_db(db);
+    if (rc != 0)
+    {
+        WARN("Failed to load compiled TRC database '%s': %r", path, rc);
+        trc_free_trc_tests(&db->tests);
+        cache_free_globals(db);
+        free(db->version);
+        db->version = NULL;
+        db->last_match = FALSE;
+        db->cache = NULL;
+        rc = TE_RC(TE_TRC, TE_ENOENT);
+        goto out;
+    }
+    cache = NULL;
+
+    INFO("TRC database '%s' is loaded from '%s'", db->filename, path);
+
+out:
+    if (cache != NULL)
+    {
+        munmap((void *)cache->base, cache->size);
+        free(cache);
+    }
+    free(location);
+    free(path);
+
+    return rc;
+}
+
+/* See the description in trc_db.h */
+void
+trc_db_cache_close(te_trc_db *db)
+{
+    if (db->cache == NULL)
+        return;
+
+    munmap((void *)db->cache->base, db->cache->size);
+    free(db->cache);
+    db->cache = NULL;
+}
+
+
+/*
+ * Compilation of TRC database.
+ */
+
+/**
+ * Append a record or a list to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param data          Data to append
+ * @param len           Length of the data
+ * @param off           Location for the offset of the data
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put(te_dbuf *buf, const void *data, size_t len, uint32_t *off)
+{
+    static const uint8_t    pad[sizeof(uint32_t)];
+    size_t                  n_pad;
+    te_errno                rc;
+
+    n_pad = (sizeof(uint32_t) - buf->len % sizeof(uint32_t)) %
+            sizeof(uint32_t);
+    if (n_pad != 0 && (rc = te_dbuf_append(buf, pad, n_pad)) != 0)
+        return rc;
+
+    if (buf->len + len > UINT32_MAX)
+        return TE_RC(TE_TRC, TE_E2BIG);
+
+    *off = buf->len;
+
+    return te_dbuf_append(buf, data, len);
+}
+
+/**
+ * Append a string to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param str           String or @c NULL
+ * @param off           Location for the offset of the string
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_str(te_dbuf *buf, const char *str, uint32_t *off)
+{
+    size_t len;
+
+    if (str == NULL)
+    {
+        *off = 0;
+        return 0;
+    }
+
+    len = strlen(str) + 1;
+    if (buf->len + len > UINT32_MAX)
+        return TE_RC(TE_TRC, TE_E2BIG);
+
+    *off = buf->len;
+
+    return te_dbuf_append(buf, str, len);
+}
+
+/**
+ * Append a list to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param items         Vector of offsets
+ * @param width         Number of offsets in an item
+ * @param off           Location for the offset of the list
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_list(te_dbuf *buf, const te_vec *items, unsigned int width,
+               uint32_t *off)
+{
+    uint32_t    n_items = te_vec_size(items) / width;
+    te_errno    rc;
+
+    rc = cache_put(buf, &n_items, sizeof(n_items), off);
+    if (rc == 0 && te_vec_size(items) != 0)
+    {
+        rc = te_dbuf_append(buf, items->data.ptr,
+                            te_vec_size(items) * sizeof(uint32_t));
+    }
+
+    return rc;
+}
+
+/**
+ * Append a string to the compiled database and its offset to
+ * the vector.
+ *
+ * @param buf           Compiled database
+ * @param str           String or @c NULL
+ * @param items         Vector of offsets
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_str_item(te_dbuf *buf, const char *str, te_vec *items)
+{
+    uint32_t    off;
+    te_errno    rc;
+
+    rc = cache_put_str(buf, str, &off);
+    if (rc == 0)
+        rc = TE_VEC_APPEND(items, off);
+
+    return rc;
+}
+
+/**
+ * Append an expected result to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param result        Expected result
+ * @param off           Location for the offset of the result record
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_result(te_dbuf *buf, const trc_exp_result *result, uint32_t *off)
+{
+    trc_db_cache_result         rec;
+    trc_db_cache_entry          entry_rec;
+    const trc_exp_result_entry *entry;
+    const te_test_verdict      *verdict;
+    te_vec                      entries = TE_VEC_INIT(uint32_t);
+    te_vec                      verdicts = TE_VEC_INIT(uint32_t);
+    uint32_t                    entry_off;
+    te_errno                    rc = 0;
+
+    memset(&rec, 0, sizeof(rec));
+
+    TAILQ_FOREACH(entry, &result->results, links)
+    {
+        memset(&entry_rec, 0, sizeof(entry_rec));
+        entry_rec.status = entry->result.status;
+        te_vec_reset(&verdicts);
+
+        TAILQ_FOREACH(verdict, &entry->result.verdicts, links)
+        {
+            rc = cache_put_str_item(buf, verdict->str, &verdicts);
+            if (rc != 0)
+                goto out;
+        }
+
+        if ((rc = cache_put_list(buf, &verdicts, 1,
+                                 &entry_rec.verdicts)) != 0 ||
+            (rc = cache_put_str(buf, entry->key, &entry_rec.key)) != 0 ||
+            (rc = cache_put_str(buf, entry->notes, &entry_rec.notes)) != 0 ||
+            (rc = cache_put(buf, &entry_rec, sizeof(entry_rec),
+                            &entry_off)) != 0 ||
+            (rc = TE_VEC_APPEND(&entries, entry_off)) != 0)
+            goto out;
+    }
+
+    if ((rc = cache_put_list(buf, &entries, 1, &rec.entries)) != 0 ||
+        (rc = cache_put_str(buf, result->tags_str, &rec.tags)) != 0 ||
+        (rc = cache_put_str(buf, result->key, &rec.key)) != 0 ||
+        (rc = cache_put_str(buf, result->notes, &rec.notes)) != 0)
+        goto out;
+
+    rc = cache_put(buf, &rec, sizeof(rec), off);
+
+out:
+    te_vec_free(&entries);
+    te_vec_free(&verdicts);
+
+    return rc;
+}
+
+static te_errno cache_put_tests(te_dbuf *buf, const trc_tests *tests,
+                                uint32_t *off);
+
+/**
+ * Append a test iteration to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param iter          Test iteration
+ * @param off           Location for the offset of the iteration record
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_iter(te_dbuf *buf, const trc_test_iter *iter, uint32_t *off)
+{
+    trc_db_cache_iter           rec;
+    const trc_test_iter_arg    *arg;
+    const trc_exp_result       *result;
+    te_vec                      items = TE_VEC_INIT(uint32_t);
+    uint32_t                    item_off;
+    te_errno                    rc = 0;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.file_pos = iter->file_pos;
+    if (iter->exp_default != NULL)
+    {
+        rec.exp_default =
+            TAILQ_FIRST(&iter->exp_default->results)->result.status + 1;
+    }
+
+    TAILQ_FOREACH(arg, &iter->args.head, links)
+    {
+        if ((rc = cache_put_str_item(buf, arg->name, &items)) != 0 ||
+            (rc = cache_put_str_item(buf, arg->value, &items)) != 0)
+            goto out;
+    }
+    rc = cache_put_list(buf, &items, 2, &rec.args);
+    if (rc != 0)
+        goto out;
+
+    te_vec_reset(&items);
+    STAILQ_FOREACH(result, &iter->exp_results, links)
+    {
+        if ((rc = cache_put_result(buf, result, &item_off)) != 0 ||
+            (rc = TE_VEC_APPEND(&items, item_off)) != 0)
+            goto out;
+    }
+
+    if ((rc = cache_put_list(buf, &items, 1, &rec.exp_results)) != 0 ||
+        (rc = cache_put_tests(buf, &iter->tests, &rec.tests)) != 0 ||
+        (rc = cache_put_str(buf, iter->notes, &rec.notes)) != 0 ||
+        (rc = cache_put_str(buf, iter->filename, &rec.filename)) != 0)
+        goto out;
+
+    rc = cache_put(buf, &rec, sizeof(rec), off);
+
+out:
+    te_vec_free(&items);
+
+    return rc;
+}
+
+/**
+ * Append a test to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param test          Test
+ * @param off           Location for the offset of the test record
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_test(te_dbuf *buf, const trc_test *test, uint32_t *off)
+{
+    trc_db_cache_test       rec;
+    const trc_test_iter    *iter;
+    te_vec                  iters = TE_VEC_INIT(uint32_t);
+    uint32_t                iter_off;
+    te_errno                rc = 0;
+
+    /* Only completely loaded database may be compiled */
+    assert(!test->not_loaded);
+
+    memset(&rec, 0, sizeof(rec));
+    rec.type = test->type;
+    rec.aux = test->aux;
+    rec.file_pos = test->file_pos;
+
+    TAILQ_FOREACH(iter, &test->iters.head, links)
+    {
+        if ((rc = cache_put_iter(buf, iter, &iter_off)) != 0 ||
+            (rc = TE_VEC_APPEND(&iters, iter_off)) != 0)
+            goto out;
+    }
+
+    if ((rc = cache_put_list(buf, &iters, 1, &rec.iters)) != 0 ||
+        (rc = cache_put_str(buf, test->name, &rec.name)) != 0 ||
+        (rc = cache_put_str(buf, test->objective, &rec.objective)) != 0 ||
+        (rc = cache_put_str(buf, test->notes, &rec.notes)) != 0 ||
+        (rc = cache_put_str(buf, test->filename, &rec.filename)) != 0)
+        goto out;
+
+    rc = cache_put(buf, &rec, sizeof(rec), off);
+
+out:
+    te_vec_free(&iters);
+
+    return rc;
+}
+
+/**
+ * Append a list of tests to the compiled database.
+ *
+ * @param buf           Compiled database
+ * @param tests         List of tests
+ * @param off           Location for the offset of the list
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_put_tests(te_dbuf *buf, const trc_tests *tests, uint32_t *off)
+{
+    const trc_test *test;
+    te_vec          items = TE_VEC_INIT(uint32_t);
+    uint32_t        test_off;
+    te_errno        rc = 0;
+
+    TAILQ_FOREACH(test, &tests->head, links)
+    {
+        if ((rc = cache_put_test(buf, test, &test_off)) != 0 ||
+            (rc = TE_VEC_APPEND(&items, test_off)) != 0)
+            break;
+    }
+
+    if (rc == 0)
+        rc = cache_put_list(buf, &items, 1, off);
+
+    te_vec_free(&items);
+
+    return rc;
+}
+
+/**
+ * Collect real paths of files included into the XML document.
+ *
+ * XInclude processing sets @c xml:base attribute of top level elements
+ * of included files. Start nodes of nested inclusions cannot be used
+ * since they have no attributes.
+ *
+ * @param doc           XML document with processed XInclude
+ * @param parent        Node which children are processed
+ * @param files         Vector to add file names to
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_collect_includes(xmlDocPtr doc, xmlNodePtr parent, te_vec *files)
+{
+    xmlNodePtr  node;
+    xmlChar    *base;
+    char       *path;
+    char      **file;
+    te_bool     found;
+    te_errno    rc;
+
+    for (node = parent->children; node != NULL; node = node->next)
+    {
+        if (node->type != XML_ELEMENT_NODE)
+            continue;
+
+        if (xmlHasNsProp(node, BAD_CAST "base", XML_XML_NAMESPACE) != NULL)
+        {
+            base = xmlNodeGetBase(doc, node);
+            if (base == NULL)
+                return TE_RC(TE_TRC, TE_ENOMEM);
+
+            path = realpath((const char *)base, NULL);
+            xmlFree(base);
+            if (path == NULL)
+                return TE_OS_RC(TE_TRC, errno);
+
+            found = FALSE;
+            TE_VEC_FOREACH(files, file)
+            {
+                if (strcmp(*file, path) == 0)
+                {
+                    found = TRUE;
+                    break;
+                }
+            }
+
+            if (found)
+            {
+                free(path);
+            }
+            else if ((rc = TE_VEC_APPEND(files, path)) != 0)
+            {
+                free(path);
+                return rc;
+            }
+        }
+
+        rc = cache_collect_includes(doc, node, files);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Create the directory and its parents if they do not exist.
+ *
+ * @param dir           Directory path
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_mkdir(const char *dir)
+{
+    char       *path = strdup(dir);
+    char       *p;
+    te_bool     last = FALSE;
+    te_errno    rc = 0;
+
+    if (path == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    for (p = path + 1; !last; p++)
+    {
+        if (*p != '/' && *p != '\0')
+            continue;
+
+        last = (*p == '\0');
+        *p = '\0';
+        if (mkdir(path, 0755) != 0 && errno != EEXIST)
+        {
+            rc = TE_OS_RC(TE_TRC, errno);
+            break;
+        }
+        if (!last)
+            *p = '/';
+    }
+    free(path);
+
+    return rc;
+}
+
+/**
+ * Write the compiled database to the file. The file is replaced
+ * atomically, so concurrent readers see either the old or the new one.
+ *
+ * @param buf           Compiled database
+ * @param dir           Directory of compiled databases
+ * @param path          Path to the file
+ *
+ * @return Status code.
+ */
+static te_errno
+cache_write(const te_dbuf *buf, const char *dir, const char *path)
+{
+    char       *tmp;
+    size_t      done;
+    ssize_t     len;
+    int         fd;
+    te_errno    rc;
+
+    rc = cache_mkdir(dir);
+    if (rc != 0)
+        return rc;
+
+    tmp = te_sprintf("%s.XXXXXX", path);
+    if (tmp == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    fd = mkstemp(tmp);
+    if (fd < 0)
+    {
+        rc = TE_OS_RC(TE_TRC, errno);
+        free(tmp);
+        return rc;
+    }
+
+    for (done = 0; done < buf->len; done += len)
+    {
+        len = write(fd, buf->ptr + done, buf->len - done);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                len = 0;
+                continue;
+            }
+            rc = TE_OS_RC(TE_TRC, errno);
+            break;
+        }
+    }
+
+    if (close(fd) != 0 && rc == 0)
+        rc = TE_OS_RC(TE_TRC, errno);
+    if (rc == 0 && rename(tmp, path) != 0)
+        rc = TE_OS_RC(TE_TRC, errno);
+    if (rc != 0)
+        unlink(tmp);
+    free(tmp);
+
+    return rc;
+}
+
+/* See the description in trc_db.h */
+te_errno
+trc_db_cache_save(te_trc_db *db)
+{
+    te_dbuf             buf = TE_DBUF_INIT(50);
+    te_vec              files = TE_VEC_INIT(char *);
+    te_vec              items = TE_VEC_INIT(uint32_t);
+    trc_db_cache_hdr    hdr;
+    const trc_global   *g;
+    char              **file;
+    char               *dir;
+    char               *path;
+    char               *location = NULL;
+    xmlNodePtr          root;
+    te_errno            rc;
+
+    dir = cache_dir();
+    if (dir == NULL)
+        return 0;
+
+    path = cache_path(db->filename, dir, &location);
+    if (path == NULL)
+    {
+        free(dir);
+        return TE_RC(TE_TRC, TE_ENOMEM);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TRC_DB_CACHE_MAGIC, sizeof(TRC_DB_CACHE_MAGIC));
+    hdr.format = TRC_DB_CACHE_FORMAT;
+    hdr.byte_order = TRC_DB_CACHE_BYTE_ORDER;
+    hdr.last_match = db->last_match;
+
+    /* The header is filled in the end */
+    rc = te_dbuf_append(&buf, &hdr, sizeof(hdr));
+    if (rc != 0)
+        goto out;
+
+    rc = TE_VEC_APPEND(&files, location);
+    if (rc != 0)
+        goto out;
+    location = NULL;
+
+    root = xmlDocGetRootElement(db->xml_doc);
+    if (root != NULL)
+    {
+        rc = cache_collect_includes(db->xml_doc, root, &files);
+        if (rc != 0)
+        {
+            WARN("Failed to get files included into TRC database: %r", rc);
+            goto out;
+        }
+    }
+
+    rc = cache_files_digest(&files, db->parse_time, hdr.digest);
+    if (TE_RC_GET_ERROR(rc) == TE_EAGAIN)
+    {
+        INFO("TRC database '%s' is not compiled since its files are "
+             "modified after parsing", db->filename);
+        rc = 0;
+        goto out;
+    }
+    if (rc != 0)
+        goto out;
+
+    TE_VEC_FOREACH(&files, file)
+    {
+        rc = cache_put_str_item(&buf, *file, &items);
+        if (rc != 0)
+            goto out;
+    }
+    if ((rc = cache_put_list(&buf, &items, 1, &hdr.files)) != 0)
+        goto out;
+
+    te_vec_reset(&items);
+    TAILQ_FOREACH(g, &db->globals.head, links)
+    {
+        if ((rc = cache_put_str_item(&buf, g->name, &items)) != 0 ||
+            (rc = cache_put_str_item(&buf, g->value, &items)) != 0)
+            goto out;
+    }
+
+    if ((rc = cache_put_list(&buf, &items, 2, &hdr.globals)) != 0 ||
+        (rc = cache_put_str(&buf, TE_VEC_GET(char *, &files, 0),
+                            &hdr.location)) != 0 ||
+        (rc = cache_put_str(&buf, db->version, &hdr.version)) != 0 ||
+        (rc = cache_put_tests(&buf, &db->tests, &hdr.tests)) != 0)
+        goto out;
+
+    hdr.size = buf.len;
+    memcpy(buf.ptr, &hdr, sizeof(hdr));
+
+    rc = cache_write(&buf, dir, path);
+    if (rc == 0)
+        INFO("TRC database '%s' is compiled to '%s'", db->filename, path);
+
+out:
+    if (rc != 0)
+    {
+        WARN("Failed to save compiled TRC database '%s': %r", path, rc);
+    }
+    te_vec_deep_free(&files);
+    te_vec_free(&items);
+    te_dbuf_free(&buf);
+    free(location);
+    free(path);
+    free(dir);
+
+    return rc;
+}
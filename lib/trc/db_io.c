@@ -811,6 +811,28 @@ alloc_and_get_test_iter(xmlNodePtr node, trc_test *test)
     return 0;
 }
 
+/**
+ * Check whether the same global is already in the current database.
+ *
+ * @param global        Global
+ *
+ * @return @c TRUE if the global is found.
+ */
+static te_bool
+get_global_dup(const trc_global *global)
+{
+    const trc_global *g;
+
+    TAILQ_FOREACH(g, &current_db->globals.head, links)
+    {
+        if (strcmp(g->name, global->name) == 0 &&
+            strcmp(g->value, global->value) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 /*
  * Update globals list with globals from specific test (mostly
  * test package).
@@ -856,6 +878,15 @@ get_globals(xmlNodePtr node, trc_test *parent)
                 return TE_RC(TE_TRC, TE_EFMT);
             }
 
+            /* The same globals are met when a test is loaded again */
+            if (current_db->lazy && get_global_dup(g))
+            {
+                free(g->name);
+                free(g->value);
+                free(g);
+                continue;
+            }
+
             TAILQ_INSERT_HEAD(&current_db->globals.head, g, links);
         }
         else
@@ -906,6 +937,9 @@ get_test_iters(xmlNodePtr *node, trc_test *parent)
         }
     }
 
+    if (rc == 0)
+        rc = trc_db_test_iters_index_build(&parent->iters);
+
     return rc;
 }
 
@@ -1048,6 +1082,20 @@ alloc_and_get_test(xmlNodePtr node, trc_tests *tests,
         node = xmlNodeNext(node);
     }
 
+    if (current_db->lazy)
+    {
+        /*
+         * Iterations are parsed by trc_db_test_load() on demand.
+         * Included files are tracked to keep names of files of
+         * the next tests.
+         */
+        for (; node != NULL; node = xmlNodeNext(node))
+            update_files(node);
+
+        p->not_loaded = TRUE;
+        return 0;
+    }
+
     rc = get_test_iters(&node, p);
     if (rc != 0)
     {
@@ -1132,6 +1180,103 @@ trc_files_free(trc_files *files)
     }
 }
 
+/**
+ * Get iterations of the test which parsing is postponed
+ * (see alloc_and_get_test()).
+ *
+ * @param test          Test
+ *
+ * @return Status code.
+ */
+static te_errno
+get_test_iters_postponed(trc_test *test)
+{
+    xmlNodePtr  node = xmlNodeChildren(test->node);
+    trc_file   *file;
+    te_errno    rc;
+
+    if (inc_files == NULL)
+    {
+        inc_files = TE_ALLOC(sizeof(*inc_files));
+        if (inc_files == NULL)
+            return TE_RC(TE_TRC, TE_ENOMEM);
+        TAILQ_INIT(inc_files);
+    }
+
+    if (test->filename != NULL)
+    {
+        file = TE_ALLOC(sizeof(*file));
+        if (file == NULL)
+            return TE_RC(TE_TRC, TE_ENOMEM);
+
+        file->filename = strdup(test->filename);
+        if (file->filename == NULL)
+        {
+            free(file);
+            return TE_RC(TE_TRC, TE_ENOMEM);
+        }
+        TAILQ_INSERT_TAIL(inc_files, file, links);
+    }
+
+    /* Skip elements which are parsed together with the test */
+    if (node != NULL &&
+        xmlStrcmp(node->name, CONST_CHAR2XML("objective")) == 0)
+        node = xmlNodeNext(node);
+    if (node != NULL &&
+        xmlStrcmp(node->name, CONST_CHAR2XML("notes")) == 0)
+        node = xmlNodeNext(node);
+    if (node != NULL &&
+        (xmlStrcmp(node->name, CONST_CHAR2XML("include")) == 0 ||
+         xmlStrcmp(node->name, CONST_CHAR2XML("xinclude_start")) == 0 ||
+         xmlStrcmp(node->name, CONST_CHAR2XML("xinclude_end")) == 0))
+    {
+        update_files(node);
+        node = xmlNodeNext(node);
+    }
+    if (node != NULL &&
+        xmlStrcmp(node->name, CONST_CHAR2XML("globals")) == 0)
+        node = xmlNodeNext(node);
+
+    rc = get_test_iters(&node, test);
+    if (rc == 0 && node != NULL)
+    {
+        ERROR("Unexpected element '%s' in test entry", node->name);
+        rc = TE_RC(TE_TRC, TE_EFMT);
+    }
+
+    trc_files_free(inc_files);
+
+    return rc;
+}
+
+/* See the description in trc_db.h */
+te_errno
+trc_db_test_load(te_trc_db *db, trc_test *test)
+{
+    te_errno rc;
+
+    if (!test->not_loaded)
+        return 0;
+
+    /* Do not try again whatever happens */
+    test->not_loaded = FALSE;
+
+    if (db->cache != NULL)
+        return trc_db_cache_test_load(db, test);
+
+    /* Tests of the iterations are added to this database */
+    current_db = db;
+
+    rc = get_test_iters_postponed(test);
+    if (rc != 0)
+    {
+        ERROR("Failed to get iterations of the test '%s': %r",
+              test->path, rc);
+    }
+
+    return rc;
+}
+
 /**
  * Read and parse XML document from a given location.
  *
@@ -1391,6 +1536,15 @@ trc_db_open_ext(const char *location, te_trc_db **db, int flags)
     if ((*db)->filename == NULL)
         return TE_ENOMEM;
 
+    (*db)->lazy = (flags & TRC_OPEN_LAZY) != 0;
+
+    if ((flags & TRC_OPEN_CACHE) && trc_db_cache_open(*db) == 0)
+    {
+        current_db = (*db);
+        return 0;
+    }
+
+    (*db)->parse_time = time(NULL);
     rc = trc_read_doc((*db)->filename, &(*db)->xml_doc);
     if (rc != 0)
         return rc;
@@ -1479,8 +1633,14 @@ trc_db_open_ext(const char *location, te_trc_db **db, int flags)
         }
 
         TAILQ_INSERT_TAIL(inc_files, file, links);
+
+        /* Only completely parsed database may be compiled */
+        if (flags & TRC_OPEN_CACHE)
+            (*db)->lazy = FALSE;
+
         rc = get_tests(&node, &(*db)->tests, NULL);
         trc_files_free(inc_files);
+        (*db)->lazy = (flags & TRC_OPEN_LAZY) != 0;
 
         if (rc != 0)
         {
@@ -1491,6 +1651,10 @@ trc_db_open_ext(const char *location, te_trc_db **db, int flags)
         {
             INFO("DB with expected testing results in file '%s' "
                  "parsed successfully", (*db)->filename);
+
+            /* Failure to compile the database is not fatal */
+            if (flags & TRC_OPEN_CACHE)
+                (void)trc_db_cache_save(*db);
         }
     }
 
@@ -2186,6 +2350,13 @@ trc_db_save(te_trc_db *db, const char *filename, int flags,
     te_errno             rc;
     trc_test            *test;
 
+    if (db->cache != NULL || db->lazy)
+    {
+        ERROR("TRC database loaded from the compiled database or "
+              "on demand cannot be saved");
+        return TE_RC(TE_TRC, TE_EOPNOTSUPP);
+    }
+
     if (flags & TRC_SAVE_REMOVE_OLD)
     {
         xmlFreeDoc(db->xml_doc);
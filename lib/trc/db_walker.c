@@ -18,6 +18,7 @@
 
 #include "te_errno.h"
 #include "te_alloc.h"
+#include "te_vector.h"
 #include "logger_api.h"
 
 #include "te_trc.h"
@@ -54,6 +55,7 @@ trc_db_walker_copy(const te_trc_db_walker *walker)
         return NULL;
 
     memcpy(new_walker, walker, sizeof(*walker));
+    new_walker->db->n_walkers++;
 
     return new_walker;
 }
@@ -98,6 +100,8 @@ trc_db_walker_parent_users_data(const te_trc_db_walker *walker)
 void
 trc_db_free_walker(te_trc_db_walker *walker)
 {
+    if (walker != NULL)
+        walker->db->n_walkers--;
     free(walker);
 }
 
@@ -112,6 +116,7 @@ trc_db_new_walker(te_trc_db *trc_db)
         return NULL;
 
     walker->db = trc_db;
+    trc_db->n_walkers++;
     walker->is_iter = TRUE;
     walker->test = NULL;
     walker->iter = NULL;
@@ -188,12 +193,14 @@ trc_db_test_params_hash(unsigned int n_args, trc_report_argument *args)
     int   k;
     unsigned char digest[MD5_DIGEST_LENGTH];
     char *hash_str = calloc(1, MD5_DIGEST_LENGTH * 2 + 1);
-    int  *sorted = calloc(n_args, sizeof(int));
-    char  buf[8192] = {0, };
-    int   len = 0;
+    int  *sorted = calloc(n_args + 1, sizeof(int));
 
-    if (sorted == NULL)
+    if (hash_str == NULL || sorted == NULL)
+    {
+        free(hash_str);
+        free(sorted);
         return NULL;
+    }
     for (k = 0; k < (int)n_args; k++)
         sorted[k] = k;
 
@@ -219,11 +226,13 @@ trc_db_test_params_hash(unsigned int n_args, trc_report_argument *args)
         char *value = trc_db_test_params_normalise(args[sorted[i]].value);
 
         if (value == NULL)
+        {
+            free(sorted);
+            free(hash_str);
             return NULL;
+        }
 
         VERB("%s %s", name, value);
-        len += snprintf(buf + len, sizeof(buf) - len,
-                        "%s%s %s", (i != 0) ? " " : "", name, value);
 
         if (i != 0)
             MD5_Update(&md5, " ", (unsigned long) 1);
@@ -235,6 +244,7 @@ trc_db_test_params_hash(unsigned int n_args, trc_report_argument *args)
     }
 
     MD5_Final(digest, &md5);
+    free(sorted);
 
     for (i = 0; i < MD5_DIGEST_LENGTH; i++)
     {
@@ -242,11 +252,311 @@ trc_db_test_params_hash(unsigned int n_args, trc_report_argument *args)
     }
 
     VERB("\nHash: %s\n", hash_str);
-    VERB("%s->%s", buf, hash_str);
 
     return hash_str;
 }
 
+/** Minimum number of buckets in the index of test iterations */
+#define TRC_ITERS_INDEX_MIN_BUCKETS 16
+
+/** Entry of the index of test iterations */
+typedef struct trc_test_iters_index_entry {
+    SLIST_ENTRY(trc_test_iters_index_entry) links;  /**< List links */
+
+    char           *hash;   /**< Hash of normalised arguments */
+    trc_test_iter  *iter;   /**< Test iteration */
+    unsigned int    pos;    /**< Position of the iteration in the list */
+} trc_test_iters_index_entry;
+
+/** List of entries of the index of test iterations */
+typedef SLIST_HEAD(trc_test_iters_index_list, trc_test_iters_index_entry)
+    trc_test_iters_index_list;
+
+/** Index of test iterations by hash of their arguments */
+struct trc_test_iters_index {
+    unsigned int                n_buckets;  /**< Number of buckets */
+    unsigned int                n_entries;  /**< Number of hashed
+                                                 iterations */
+    unsigned int                next_pos;   /**< Position of the next
+                                                 added iteration */
+    trc_test_iters_index_list  *buckets;    /**< Hashed iterations */
+    trc_test_iters_index_list   wilds;      /**< Wildcard iterations */
+};
+
+/** Result of matching a test iteration */
+typedef struct trc_db_iter_match {
+    trc_test_iter  *iter;   /**< Test iteration */
+    int             result; /**< ITER_EXACT_MATCH or ITER_WILD_MATCH */
+    unsigned int    pos;    /**< Position of the iteration in the list */
+} trc_db_iter_match;
+
+/** Get bucket of the index by hash */
+static trc_test_iters_index_list *
+trc_db_iters_index_bucket(struct trc_test_iters_index *index,
+                          const char *hash)
+{
+    unsigned long   h = 0;
+    unsigned int    i;
+
+    /* Hash is a hex string of MD5 digest, its prefix is good enough */
+    for (i = 0; i < sizeof(h) * 2 && hash[i] != '\0'; i++)
+        h = (h << 4) | (isdigit(hash[i]) ? hash[i] - '0' :
+                                           tolower(hash[i]) - 'a' + 10);
+
+    return &index->buckets[h % index->n_buckets];
+}
+
+/**
+ * Calculate hash of arguments of a test iteration from TRC database.
+ *
+ * @param args          Iteration arguments
+ * @param hash          Location for allocated hash or @c NULL if
+ *                      the iteration is a wildcard
+ *
+ * @return Status code.
+ */
+static te_errno
+trc_db_iter_args_hash(const trc_test_iter_args *args, char **hash)
+{
+    const trc_test_iter_arg    *arg;
+    unsigned int                n_args = 0;
+
+    TAILQ_FOREACH(arg, &args->head, links)
+    {
+        if (*arg->value == '\0')
+        {
+            *hash = NULL;
+            return 0;
+        }
+        n_args++;
+    }
+
+    {
+        trc_report_argument rargs[n_args + 1];
+
+        n_args = 0;
+        TAILQ_FOREACH(arg, &args->head, links)
+        {
+            rargs[n_args].name = arg->name;
+            rargs[n_args].value = arg->value;
+            rargs[n_args].variable = FALSE;
+            n_args++;
+        }
+
+        *hash = trc_db_test_params_hash(n_args, rargs);
+    }
+
+    return *hash == NULL ? TE_RC(TE_TRC, TE_ENOMEM) : 0;
+}
+
+/**
+ * Calculate hash of arguments of a test iteration to look it up
+ * in the index. Variables are skipped as they are not matched.
+ *
+ * @param n_args        Number of arguments
+ * @param args          Arguments
+ * @param hash          Location for allocated hash or @c NULL if
+ *                      the index cannot be used for these arguments
+ *
+ * @return Status code.
+ */
+static te_errno
+trc_db_report_args_hash(unsigned int n_args,
+                        const trc_report_argument *args, char **hash)
+{
+    trc_report_argument rargs[n_args + 1];
+    unsigned int        n = 0;
+    unsigned int        i;
+
+    *hash = NULL;
+    for (i = 0; i < n_args; i++)
+    {
+        if (args[i].variable)
+            continue;
+
+        /*
+         * Values referring to TRC globals may match either the
+         * name or the value of the global, match them as usual.
+         */
+        if (strncmp(args[i].value, TEST_ARG_VAR_PREFIX,
+                    strlen(TEST_ARG_VAR_PREFIX)) == 0)
+            return 0;
+
+        rargs[n++] = args[i];
+    }
+
+    *hash = trc_db_test_params_hash(n, rargs);
+
+    return *hash == NULL ? TE_RC(TE_TRC, TE_ENOMEM) : 0;
+}
+
+/**
+ * Rebuild buckets of the index of test iterations with the new
+ * number of buckets.
+ *
+ * @param index         Index
+ * @param n_buckets     Number of buckets
+ *
+ * @return Status code.
+ */
+static te_errno
+trc_db_iters_index_resize(struct trc_test_iters_index *index,
+                          unsigned int n_buckets)
+{
+    trc_test_iters_index_list  *old_buckets = index->buckets;
+    unsigned int                old_n_buckets = index->n_buckets;
+    trc_test_iters_index_entry *entry;
+    unsigned int                i;
+
+    index->buckets = TE_ALLOC(n_buckets * sizeof(*index->buckets));
+    if (index->buckets == NULL)
+    {
+        index->buckets = old_buckets;
+        return TE_RC(TE_TRC, TE_ENOMEM);
+    }
+    index->n_buckets = n_buckets;
+
+    /* Reverse order of entries in buckets does not matter */
+    for (i = 0; i < old_n_buckets; i++)
+    {
+        while ((entry = SLIST_FIRST(&old_buckets[i])) != NULL)
+        {
+            SLIST_REMOVE_HEAD(&old_buckets[i], links);
+            SLIST_INSERT_HEAD(trc_db_iters_index_bucket(index, entry->hash),
+                              entry, links);
+        }
+    }
+    free(old_buckets);
+
+    return 0;
+}
+
+/* See the description in trc_db.h */
+te_errno
+trc_db_test_iters_index_add(trc_test_iters *iters, trc_test_iter *iter)
+{
+    struct trc_test_iters_index    *index = iters->index;
+    trc_test_iters_index_entry     *entry;
+    te_errno                        rc;
+
+    if (index == NULL)
+        return 0;
+
+    entry = TE_ALLOC(sizeof(*entry));
+    if (entry == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+    entry->iter = iter;
+    entry->pos = index->next_pos++;
+
+    rc = trc_db_iter_args_hash(&iter->args, &entry->hash);
+    if (rc != 0)
+    {
+        free(entry);
+        return rc;
+    }
+
+    if (entry->hash == NULL)
+    {
+        SLIST_INSERT_HEAD(&index->wilds, entry, links);
+        return 0;
+    }
+
+    if (index->n_entries >= index->n_buckets * 2)
+    {
+        rc = trc_db_iters_index_resize(index, index->n_buckets * 2);
+        if (rc != 0)
+        {
+            free(entry->hash);
+            free(entry);
+            return rc;
+        }
+    }
+
+    SLIST_INSERT_HEAD(trc_db_iters_index_bucket(index, entry->hash),
+                      entry, links);
+    index->n_entries++;
+
+    return 0;
+}
+
+/** Free entries of the index list */
+static void
+trc_db_iters_index_list_free(trc_test_iters_index_list *list)
+{
+    trc_test_iters_index_entry *entry;
+
+    while ((entry = SLIST_FIRST(list)) != NULL)
+    {
+        SLIST_REMOVE_HEAD(list, links);
+        free(entry->hash);
+        free(entry);
+    }
+}
+
+/* See the description in trc_db.h */
+void
+trc_db_test_iters_index_free(trc_test_iters *iters)
+{
+    struct trc_test_iters_index *index = iters->index;
+    unsigned int                 i;
+
+    if (index == NULL)
+        return;
+
+    for (i = 0; i < index->n_buckets; i++)
+        trc_db_iters_index_list_free(&index->buckets[i]);
+    trc_db_iters_index_list_free(&index->wilds);
+    free(index->buckets);
+    free(index);
+    iters->index = NULL;
+}
+
+/* See the description in trc_db.h */
+te_errno
+trc_db_test_iters_index_build(trc_test_iters *iters)
+{
+    struct trc_test_iters_index    *index;
+    trc_test_iter                  *iter;
+    unsigned int                    n_iters = 0;
+    unsigned int                    n_buckets;
+    te_errno                        rc;
+
+    trc_db_test_iters_index_free(iters);
+
+    TAILQ_FOREACH(iter, &iters->head, links)
+        n_iters++;
+
+    for (n_buckets = TRC_ITERS_INDEX_MIN_BUCKETS; n_buckets < n_iters;
+         n_buckets *= 2)
+        ;
+
+    index = TE_ALLOC(sizeof(*index));
+    if (index == NULL)
+        return TE_RC(TE_TRC, TE_ENOMEM);
+
+    index->buckets = TE_ALLOC(n_buckets * sizeof(*index->buckets));
+    if (index->buckets == NULL)
+    {
+        free(index);
+        return TE_RC(TE_TRC, TE_ENOMEM);
+    }
+    index->n_buckets = n_buckets;
+    SLIST_INIT(&index->wilds);
+    iters->index = index;
+
+    TAILQ_FOREACH(iter, &iters->head, links)
+    {
+        rc = trc_db_test_iters_index_add(iters, iter);
+        if (rc != 0)
+        {
+            trc_db_test_iters_index_free(iters);
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
 /* See the description in trc_db.h */
 void
 trc_db_walker_go_to_test(te_trc_db_walker *walker, trc_test *test)
@@ -565,6 +875,119 @@ trc_report_argument_compare (const void *arg1, const void *arg2)
                   ((trc_report_argument *)arg2)->name);
 }
 
+/**
+ * Match arguments against the list of index entries and append matching
+ * iterations to the vector.
+ *
+ * @param list          List of index entries
+ * @param hash          Hash of arguments or @c NULL to match all entries
+ * @param n_args        Number of arguments
+ * @param args          Arguments sorted by name
+ * @param matches       Vector of trc_db_iter_match
+ *
+ * @return Status code.
+ */
+static te_errno
+trc_db_iters_index_list_match(const trc_test_iters_index_list *list,
+                              const char *hash, unsigned int n_args,
+                              trc_report_argument *args, te_vec *matches)
+{
+    const trc_test_iters_index_entry   *entry;
+    trc_db_iter_match                   match;
+
+    SLIST_FOREACH(entry, list, links)
+    {
+        if (hash != NULL && strcmp(entry->hash, hash) != 0)
+            continue;
+
+        match.iter = entry->iter;
+        match.pos = entry->pos;
+        match.result = test_iter_args_match(&entry->iter->args,
+                                            n_args, args, TRUE);
+        if (match.result != ITER_NO_MATCH &&
+            TE_VEC_APPEND(matches, match) != 0)
+            return TE_RC(TE_TRC, TE_ENOMEM);
+    }
+
+    return 0;
+}
+
+/** Compare matching iterations by their positions in the list */
+static int
+trc_db_iter_match_cmp(const void *arg1, const void *arg2)
+{
+    const trc_db_iter_match *match1 = arg1;
+    const trc_db_iter_match *match2 = arg2;
+
+    if (match1->pos < match2->pos)
+        return -1;
+
+    return match1->pos > match2->pos ? 1 : 0;
+}
+
+/**
+ * Find iterations matching arguments using the index of test iterations.
+ * Only iterations with the same hash of arguments and wildcard
+ * iterations are matched.
+ *
+ * @param iters         List of test iterations
+ * @param n_args        Number of arguments
+ * @param args          Arguments sorted by name
+ * @param matches       Vector of trc_db_iter_match to append matching
+ *                      iterations in order of the list
+ * @param used          Location for the flag whether the index is
+ *                      applicable
+ *
+ * @return Status code.
+ */
+static te_errno
+trc_db_iters_index_match(trc_test_iters *iters, unsigned int n_args,
+                         trc_report_argument *args, te_vec *matches,
+                         te_bool *used)
+{
+    char       *hash;
+    te_errno    rc;
+
+    *used = FALSE;
+
+    /* Hash is calculated for values with normalised spaces only */
+    if (trc_db_compare_values != trc_db_strcmp_normspace)
+        return 0;
+
+    rc = trc_db_report_args_hash(n_args, args, &hash);
+    if (rc != 0 || hash == NULL)
+        return rc;
+
+    if (iters->index == NULL)
+    {
+        rc = trc_db_test_iters_index_build(iters);
+        if (rc != 0)
+        {
+            free(hash);
+            return rc;
+        }
+    }
+
+    *used = TRUE;
+    rc = trc_db_iters_index_list_match(
+             trc_db_iters_index_bucket(iters->index, hash),
+             hash, n_args, args, matches);
+    free(hash);
+    if (rc == 0)
+    {
+        rc = trc_db_iters_index_list_match(&iters->index->wilds, NULL,
+                                           n_args, args, matches);
+    }
+    /* Order matching iterations as they are listed in the test */
+    if (rc == 0 && te_vec_size(matches) > 1)
+    {
+        qsort(te_vec_get(matches, 0), te_vec_size(matches),
+              sizeof(trc_db_iter_match), trc_db_iter_match_cmp);
+    }
+
+    return rc;
+}
+
 
 /* See the description in te_trc.h */
 te_bool
@@ -599,6 +1022,11 @@ trc_db_walker_step_iter(te_trc_db_walker *walker, unsigned int n_args,
         const char *arg_names[n_args];
         unsigned int i;
 
+        te_vec             matches = TE_VEC_INIT(trc_db_iter_match);
+        trc_db_iter_match *p_match;
+        te_bool            index_used = FALSE;
+        te_errno           rc;
+
         /*
          * Memorize initial order of arguments before sorting them
          * for TRC matching.
@@ -607,8 +1035,18 @@ trc_db_walker_step_iter(te_trc_db_walker *walker, unsigned int n_args,
             arg_names[i] = args[i].name;
 
         qsort(args, n_args, sizeof(*args), trc_report_argument_compare);
+
+        /* Iterations of the compiled database are loaded on demand */
+        rc = trc_db_test_load(walker->db, walker->test);
+        if (rc == 0 && func_args_match == NULL)
+        {
+            rc = trc_db_iters_index_match(&walker->test->iters,
+                                          n_args, args, &matches,
+                                          &index_used);
+        }
+
         for (walker->iter = TAILQ_FIRST(&walker->test->iters.head);
-             walker->iter != NULL;
+             rc == 0 && !index_used && walker->iter != NULL;
              walker->iter = TAILQ_NEXT(walker->iter, links))
         {
             if (func_args_match == NULL || walker->iter->log_found)
@@ -625,41 +1063,61 @@ trc_db_walker_step_iter(te_trc_db_walker *walker, unsigned int n_args,
 
             if (match_result != ITER_NO_MATCH)
             {
-                iter = walker->iter;
-                found++;
+                trc_db_iter_match match = { walker->iter, match_result, 0 };
 
-                if (match_result == ITER_WILD_MATCH)
-                {
-                    /*
-                     * TRC Update tool does not create
-                     * wildcards iterations to be matched
-                     * during log processing - so no need
-                     * in new_ or old_ prefix.
-                     */
-                    if (wild_iter != NULL ||
-                        old_exact_iter != NULL)
-                        dup_detected = TRUE;
-                    wild_iter = walker->iter;
-                }
-                else if (iter->log_found)
-                {
-                    if (new_exact_iter != NULL)
-                    {
-                        dup_detected = TRUE;
-                        ERROR("TRC Update generates duplicates!");
-                    }
-                    new_exact_iter = walker->iter;
-                }
-                else
+                rc = TE_VEC_APPEND(&matches, match);
+            }
+        }
+
+        if (rc != 0)
+        {
+            ERROR("Failed to match test '%s' iteration: %r",
+                  walker->test->name, rc);
+            te_vec_free(&matches);
+            walker->iter = NULL;
+            walker->unknown++;
+            walker->is_iter = TRUE;
+            return FALSE;
+        }
+
+        TE_VEC_FOREACH(&matches, p_match)
+        {
+            iter = p_match->iter;
+            found++;
+
+            if (p_match->result == ITER_WILD_MATCH)
+            {
+                /*
+                 * TRC Update tool does not create
+                 * wildcards iterations to be matched
+                 * during log processing - so no need
+                 * in new_ or old_ prefix.
+                 */
+                if (wild_iter != NULL ||
+                    old_exact_iter != NULL)
+                    dup_detected = TRUE;
+                wild_iter = iter;
+            }
+            else if (iter->log_found)
+            {
+                if (new_exact_iter != NULL)
                 {
-                    if (old_exact_iter != NULL ||
-                        wild_iter != NULL)
-                        dup_detected = TRUE;
-                    old_exact_iter = walker->iter;
+                    dup_detected = TRUE;
+                    ERROR("TRC Update generates duplicates!");
                 }
+                new_exact_iter = iter;
+            }
+            else
+            {
+                if (old_exact_iter != NULL ||
+                    wild_iter != NULL)
+                    dup_detected = TRUE;
+                old_exact_iter = iter;
             }
         }
+        te_vec_free(&matches);
 
+        walker->iter = NULL;
         if ((flags & STEP_ITER_MATCH_FLAGS) == 0)
             walker->iter = iter;
         if (walker->iter == NULL &&
@@ -808,6 +1266,10 @@ trc_db_walker_step_back(te_trc_db_walker *walker)
         walker->iter = walker->test->parent;
         walker->is_iter = TRUE;
         VERB("Step back from test");
+
+        /* Other walkers may still be inside the test */
+        if (walker->db->n_walkers == 1)
+            trc_db_test_unload(walker->db, walker->test);
     }
 }
 
@@ -844,7 +1306,10 @@ trc_db_walker_move(te_trc_db_walker *walker)
             }
             else
             {
-                walker->iter = TAILQ_FIRST(&walker->test->iters.head);
+                if (trc_db_test_load(walker->db, walker->test) != 0)
+                    walker->iter = NULL;
+                else
+                    walker->iter = TAILQ_FIRST(&walker->test->iters.head);
                 if (walker->iter != NULL)
                 {
                     walker->is_iter = TRUE;
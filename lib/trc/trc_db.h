@@ -11,6 +11,7 @@
 #ifndef __TE_TRC_DB_H__
 #define __TE_TRC_DB_H__
 
+#include <time.h>
 #include <libxml/tree.h>
 
 #include "te_defs.h"
@@ -102,6 +103,9 @@ typedef struct trc_test_iter {
                                          Update Tool or not */
 } trc_test_iter;
 
+/* Forward */
+struct trc_test_iters_index;
+
 /** Head of the list with test iterations */
 typedef struct trc_test_iters {
 
@@ -109,6 +113,9 @@ typedef struct trc_test_iters {
 
     TAILQ_HEAD(, trc_test_iter) head;   /**< Head of the list */
 
+    struct trc_test_iters_index *index; /**< Index of iterations by
+                                             arguments or @c NULL */
+
 } trc_test_iters;
 
 
@@ -147,6 +154,11 @@ typedef struct trc_test {
     int                 file_pos;   /**< Number of the test in
                                          the list of all its siblings
                                          belonging to the same file */
+
+    unsigned int        cache_off;  /**< Offset of the test in compiled
+                                         TRC database or @c 0 */
+    te_bool             not_loaded; /**< Iterations are not loaded yet
+                                         (see trc_db_test_load()) */
 } trc_test;
 
 typedef struct trc_global {
@@ -158,6 +170,17 @@ typedef struct trc_global {
     char *value;
 } trc_global;
 
+/** Compiled TRC database (see db_cache.c) */
+typedef struct trc_db_cache trc_db_cache;
+
+/**
+ * Name of the environment variable with the directory of compiled TRC
+ * databases. If it is set to an empty string, compiled databases are
+ * not used. By default @c $XDG_CACHE_HOME/te/trc or @c ~/.cache/te/trc
+ * is used.
+ */
+#define TRC_DB_CACHE_DIR_ENV "TE_TRC_CACHE_DIR"
+
 /** Testing results comparison database */
 struct te_trc_db {
     char           *filename;   /**< Location of the database file */
@@ -167,6 +190,13 @@ struct te_trc_db {
     unsigned int    user_id;    /**< ID of the next user */
     trc_globals     globals;
     te_bool         last_match; /**< Choose the last match expectation */
+    trc_db_cache   *cache;      /**< Compiled database the tests are
+                                     loaded from or @c NULL */
+    time_t          parse_time; /**< Time when parsing of XML files
+                                     was started */
+    te_bool         lazy;       /**< Tests are loaded on demand and
+                                     unloaded when they are left */
+    unsigned int    n_walkers;  /**< Number of walkers of the database */
 };
 
 /** Kinds of matching of iteration TRC with iteration from XML log */
@@ -213,6 +243,41 @@ extern trc_test_iter *trc_db_new_test_iter(trc_test      *test,
                                            trc_report_argument *args,
                                            trc_test_iter *insert_before);
 
+/**
+ * Build the index of test iterations by hash of their normalised
+ * arguments. Wildcard iterations are kept in a separate list.
+ * The index is used by trc_db_walker_step_iter() to avoid matching
+ * of all iterations of the test.
+ *
+ * Iterations appended by trc_db_new_test_iter() are added to the
+ * existing index. Other modifications of the list of iterations must
+ * be followed by trc_db_test_iters_index_free().
+ *
+ * @param iters         List of test iterations
+ *
+ * @return Status code.
+ */
+extern te_errno trc_db_test_iters_index_build(trc_test_iters *iters);
+
+/**
+ * Add the iteration to the index of test iterations if the index
+ * is built. The iteration must be the last one in the list.
+ *
+ * @param iters         List of test iterations
+ * @param iter          Iteration with arguments
+ *
+ * @return Status code.
+ */
+extern te_errno trc_db_test_iters_index_add(trc_test_iters *iters,
+                                            trc_test_iter *iter);
+
+/**
+ * Free the index of test iterations. It is rebuilt on demand.
+ *
+ * @param iters         List of test iterations
+ */
+extern void trc_db_test_iters_index_free(trc_test_iters *iters);
+
 extern void *trc_db_get_test_by_path(te_trc_db *db,
                                      char *path);
 
@@ -294,6 +359,21 @@ typedef enum {
                                          xmlXIncludeProcess(). See
                                          trc_xinclude_process()
                                          description for more details. */
+    TRC_OPEN_CACHE        = 0x2,    /**< Load the compiled database if
+                                         it is up to date, otherwise
+                                         parse XML and save the compiled
+                                         database. Iterations of tests
+                                         loaded from the compiled
+                                         database are created on demand,
+                                         and such database cannot be
+                                         saved by trc_db_save(). */
+    TRC_OPEN_LAZY         = 0x4,    /**< Parse iterations of a test when
+                                         they are accessed for the first
+                                         time and free them when the
+                                         only walker of the database
+                                         steps back from the test. Such
+                                         database cannot be saved by
+                                         trc_db_save(). */
 } trc_open_flags;
 
 /** TRC DB saving options */
@@ -469,6 +549,70 @@ extern te_errno trc_db_save(te_trc_db *db, const char *filename,
 
 extern void trc_db_free(te_trc_db *db);
 
+/**
+ * Load TRC database from the compiled database if it exists and
+ * none of its source files is changed. Only globals and top level
+ * tests are created, iterations are loaded by trc_db_test_load().
+ *
+ * @param db            TRC database with location of XML file set
+ *
+ * @return Status code.
+ * @retval TE_ENOENT    There is no up to date compiled database.
+ */
+extern te_errno trc_db_cache_open(te_trc_db *db);
+
+/**
+ * Save the compiled TRC database. The database must be parsed from XML.
+ * It is not saved if any of its files is modified after
+ * @a parse_time, since the files may differ from the parsed ones.
+ *
+ * @param db            TRC database
+ *
+ * @return Status code.
+ */
+extern te_errno trc_db_cache_save(te_trc_db *db);
+
+/**
+ * Unmap the compiled TRC database.
+ *
+ * @param db            TRC database
+ */
+extern void trc_db_cache_close(te_trc_db *db);
+
+/**
+ * Load iterations of the test from the compiled TRC database.
+ * Children tests are created, but their iterations are not loaded.
+ *
+ * @param db            TRC database
+ * @param test          Test
+ *
+ * @return Status code.
+ */
+extern te_errno trc_db_cache_test_load(te_trc_db *db, trc_test *test);
+
+/**
+ * Load iterations of the test if they are not loaded yet (see
+ * TRC_OPEN_CACHE and TRC_OPEN_LAZY). Children tests are created,
+ * but their iterations are not loaded.
+ *
+ * @param db            TRC database
+ * @param test          Test
+ *
+ * @return Status code.
+ */
+extern te_errno trc_db_test_load(te_trc_db *db, trc_test *test);
+
+/**
+ * Free iterations of the test loaded on demand, so that they are
+ * loaded again by trc_db_test_load() when necessary. Nothing is done
+ * if the database is not opened with TRC_OPEN_LAZY or users data is
+ * attached to iterations of the test or to tests below.
+ *
+ * @param db            TRC database
+ * @param test          Test
+ */
+extern void trc_db_test_unload(te_trc_db *db, trc_test *test);
+
 /**
  * Remove all expected results from TRC DB,
  * unlink and free related XML nodes.
@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Testing Configurator API cache
+ *
+ * Testing per-process cache of Configurator API
+ */
+
+/** @page cs-api_cache Testing Configurator API cache
+ *
+ * @objective Check that cached instance values are used while
+ *            the Configurator database is not changed and are
+ *            never used for volatile instances
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "cs/api_cache"
+
+#include "te_config.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "te_str.h"
+#include "conf_api.h"
+#include "tapi_test.h"
+
+/** Name of the local instance used by the test */
+#define API_CACHE_NAME "te_cs_api_cache"
+
+/** Value set by the test process */
+#define API_CACHE_VAL_PARENT "parent"
+/** Value set by the child process */
+#define API_CACHE_VAL_CHILD "child"
+
+/**
+ * Get a string value and check it against the expected one.
+ *
+ * @param oid           Instance OID
+ * @param expected      Expected value
+ * @param what          What is checked (for verdicts)
+ */
+static void
+check_value(const char *oid, const char *expected, const char *what)
+{
+    char *value = NULL;
+
+    CHECK_RC(cfg_get_instance_string_fmt(&value, "%s", oid));
+    if (strcmp(value, expected) != 0)
+    {
+        TEST_VERDICT("%s: got '%s' instead of '%s'", what, value,
+                     expected);
+    }
+
+    free(value);
+}
+
+/**
+ * Change an instance value from another process.
+ *
+ * @param oid           Instance OID
+ * @param value         New value
+ */
+static void
+set_from_child(const char *oid, const char *value)
+{
+    pid_t pid;
+    int   status;
+
+    pid = fork();
+    if (pid < 0)
+        TEST_FAIL("fork() failed: %s", strerror(errno));
+
+    if (pid == 0)
+    {
+        te_errno rc;
+
+        cfg_api_cleanup();
+        rc = cfg_set_instance_fmt(CFG_VAL(STRING, value), "%s", oid);
+        cfg_api_cleanup();
+        _exit(rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (waitpid(pid, &status, 0) < 0)
+        TEST_FAIL("waitpid() failed: %s", strerror(errno));
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        TEST_VERDICT("Child process failed to change the instance");
+}
+
+int
+main(int argc, char **argv)
+{
+    char    *local_oid = NULL;
+    char    *vol_oid = NULL;
+    te_bool  local_added = FALSE;
+    te_bool  vol_added = FALSE;
+    uint64_t hits;
+
+    TEST_START;
+
+    local_oid = te_string_fmt("/local:/env:%s", API_CACHE_NAME);
+    vol_oid = te_string_fmt("/volatile:/cache:/foo:%s/baz:", API_CACHE_NAME);
+
+    TEST_STEP("Enable the cache as TE_CONF_API_CACHE does");
+    cfg_api_cache_enable(TRUE);
+
+    TEST_STEP("Add a local instance and a volatile instance");
+    CHECK_RC(cfg_add_instance_fmt(NULL,
+                                  CFG_VAL(STRING, API_CACHE_VAL_PARENT),
+                                  "%s", local_oid));
+    local_added = TRUE;
+    CHECK_RC(cfg_add_instance_fmt(NULL, CFG_VAL(NONE, NULL),
+                                  "/volatile:/cache:/foo:%s",
+                                  API_CACHE_NAME));
+    vol_added = TRUE;
+    CHECK_RC(cfg_add_instance_fmt(NULL,
+                                  CFG_VAL(STRING, API_CACHE_VAL_PARENT),
+                                  "%s", vol_oid));
+
+    TEST_STEP("Check that a repeated read is served from the cache");
+    check_value(local_oid, API_CACHE_VAL_PARENT, "First read");
+    hits = cfg_api_cache_hits();
+    check_value(local_oid, API_CACHE_VAL_PARENT, "Repeated read");
+    if (cfg_api_cache_hits() == hits)
+        TEST_VERDICT("Repeated read is not served from the cache");
+
+    TEST_STEP("Change the instance from another process and check that "
+              "the cached value is not used");
+    set_from_child(local_oid, API_CACHE_VAL_CHILD);
+    hits = cfg_api_cache_hits();
+    check_value(local_oid, API_CACHE_VAL_CHILD,
+                "Read after change by another process");
+    if (cfg_api_cache_hits() != hits)
+        TEST_VERDICT("Read after change is served from the cache");
+
+    TEST_STEP("Check that the changed value is cached again");
+    hits = cfg_api_cache_hits();
+    check_value(local_oid, API_CACHE_VAL_CHILD, "Repeated read after change");
+    if (cfg_api_cache_hits() == hits)
+        TEST_VERDICT("Repeated read after change is not served from "
+                     "the cache");
+
+    TEST_STEP("Check that volatile instances are never cached");
+    hits = cfg_api_cache_hits();
+    check_value(vol_oid, API_CACHE_VAL_PARENT,
+                "First read of volatile instance");
+    check_value(vol_oid, API_CACHE_VAL_PARENT,
+                "Repeated read of volatile instance");
+    if (cfg_api_cache_hits() != hits)
+        TEST_VERDICT("Volatile instance is served from the cache");
+
+    TEST_SUCCESS;
+
+cleanup:
+    if (vol_added)
+    {
+        CLEANUP_CHECK_RC(cfg_del_instance_fmt(TRUE, "/volatile:/cache:/foo:%s",
+                                              API_CACHE_NAME));
+    }
+    if (local_added)
+    {
+        CLEANUP_CHECK_RC(cfg_del_instance_fmt(FALSE, "%s", local_oid));
+    }
+    cfg_api_cache_enable(FALSE);
+    free(local_oid);
+    free(vol_oid);
+
+    TEST_END;
+}
@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Testing incremental synchronization
+ *
+ * Testing that incremental synchronization notices changes made
+ * bypassing Configurator
+ */
+
+/** @page cs-delta_sync Testing incremental synchronization
+ *
+ * @objective Check that a network address added and removed by an RPC
+ *            server is noticed when the agent is synchronized
+ *
+ * @param env       Testing environment
+ *
+ * The test makes sense when Configurator synchronizes only changed
+ * subtrees (dispatcher option @c --cs-delta-sync), otherwise the whole
+ * agent is fetched on synchronization.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "cs/delta_sync"
+
+#ifndef TEST_START_VARS
+#define TEST_START_VARS TEST_START_ENV_VARS
+#endif
+
+#ifndef TEST_START_SPECIFIC
+#define TEST_START_SPECIFIC TEST_START_ENV
+#endif
+
+#ifndef TEST_END_SPECIFIC
+#define TEST_END_SPECIFIC TEST_END_ENV
+#endif
+
+#include "te_config.h"
+
+#include <net/if.h>
+
+#include "conf_api.h"
+#include "tapi_rpc_stdio.h"
+#include "tapi_test.h"
+#include "tapi_env.h"
+
+/** Address added by the RPC server (TEST-NET-1, RFC 5737) */
+#define DELTA_SYNC_ADDR "192.0.2.77"
+
+/**
+ * Run "ip addr" command via the RPC server.
+ *
+ * @param rpcs          RPC server
+ * @param cmd           Command ("add" or "del")
+ * @param ifname        Interface name
+ *
+ * @return @c TRUE if the command succeeded.
+ */
+static te_bool
+ip_addr_cmd(rcf_rpc_server *rpcs, const char *cmd, const char *ifname)
+{
+    rpc_wait_status st;
+
+    RPC_AWAIT_IUT_ERROR(rpcs);
+    st = rpc_system_ex(rpcs, "ip addr %s " DELTA_SYNC_ADDR "/32 dev %s",
+                       cmd, ifname);
+
+    return st.flag == RPC_WAIT_STATUS_EXITED && st.value == 0;
+}
+
+/**
+ * Synchronize the whole agent and check whether the address is known
+ * to Configurator.
+ *
+ * @param ta            Agent name
+ * @param ifname        Interface name
+ *
+ * @return @c TRUE if the address is found.
+ */
+static te_bool
+sync_and_find_addr(const char *ta, const char *ifname)
+{
+    cfg_handle  handle;
+    te_errno    rc;
+
+    CHECK_RC(cfg_synchronize_fmt(TRUE, "/agent:%s", ta));
+
+    rc = cfg_find_fmt(&handle, "/agent:%s/interface:%s/net_addr:%s",
+                      ta, ifname, DELTA_SYNC_ADDR);
+    if (rc != 0 && TE_RC_GET_ERROR(rc) != TE_ENOENT)
+        TEST_FAIL("cfg_find_fmt() failed unexpectedly: %r", rc);
+
+    return rc == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    rcf_rpc_server             *pco_iut = NULL;
+    const struct if_nameindex  *iut_if = NULL;
+    te_bool                     added = FALSE;
+
+    TEST_START;
+
+    TEST_GET_PCO(pco_iut);
+    TEST_GET_IF(iut_if);
+
+    TEST_STEP("Synchronize the agent, so that the next synchronization "
+              "may fetch only changes");
+    if (sync_and_find_addr(pco_iut->ta, iut_if->if_name))
+        TEST_FAIL("Address " DELTA_SYNC_ADDR " is already assigned");
+
+    TEST_STEP("Add an address to the interface via the RPC server");
+    if (!ip_addr_cmd(pco_iut, "add", iut_if->if_name))
+        TEST_FAIL("Failed to add address via RPC server");
+    added = TRUE;
+
+    TEST_STEP("Synchronize the agent and check that the address is "
+              "noticed");
+    if (!sync_and_find_addr(pco_iut->ta, iut_if->if_name))
+        TEST_VERDICT("Address added via RPC server is not synchronized");
+
+    TEST_STEP("Remove the address via the RPC server");
+    if (!ip_addr_cmd(pco_iut, "del", iut_if->if_name))
+        TEST_FAIL("Failed to remove address via RPC server");
+    added = FALSE;
+
+    TEST_STEP("Synchronize the agent and check that removal of the "
+              "address is noticed");
+    if (sync_and_find_addr(pco_iut->ta, iut_if->if_name))
+        TEST_VERDICT("Address removed via RPC server is not synchronized");
+
+    TEST_SUCCESS;
+
+cleanup:
+    if (added)
+    {
+        if (!ip_addr_cmd(pco_iut, "del", iut_if->if_name))
+            ERROR("Failed to remove address via RPC server");
+        CLEANUP_CHECK_RC(cfg_synchronize_fmt(TRUE, "/agent:%s",
+                                             pco_iut->ta));
+    }
+
+    TEST_END;
+}
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Test for bulk reading of configuration subtree
+ *
+ * Testing cfg_get_subtree() correctness
+ */
+
+/** @page cs-subtree Test for bulk reading of configuration subtree
+ *
+ * @objective Check that instances read by a single request are the same
+ *            as ones read one by one
+ *
+ * @par Test sequence:
+ */
+
+#define TE_TEST_NAME    "cs/subtree"
+
+#include "te_config.h"
+
+#include <string.h>
+
+#include "tapi_test.h"
+#include "conf_api.h"
+
+/** Root of the subtree created by the test */
+#define SUBTREE_ROOT    "/local:/changed:subtree"
+
+/** Number of instances created in the subtree */
+#define N_REGIONS       100
+
+int
+main(int argc, char **argv)
+{
+    cfg_subtree_entry  *entries = NULL;
+    unsigned int        n_entries;
+    cfg_handle         *handles = NULL;
+    unsigned int        n_handles;
+    unsigned int        i;
+
+    TEST_START;
+
+    TEST_STEP("Create a subtree with many instances.");
+    CHECK_RC(cfg_add_instance_fmt(NULL, CFG_VAL(NONE, NULL), SUBTREE_ROOT));
+    for (i = 0; i < N_REGIONS; i++)
+    {
+        char val[16];
+
+        TE_SPRINTF(val, "%u", i * 10);
+        CHECK_RC(cfg_add_instance_fmt(NULL, CFG_VAL(STRING, val),
+                                      SUBTREE_ROOT "/region:%u", i));
+    }
+
+    TEST_STEP("Read the whole subtree and check that the root precedes "
+              "all its sons.");
+    CHECK_RC(cfg_get_subtree_fmt(TRUE, &n_entries, &entries,
+                                 "%s", SUBTREE_ROOT));
+    if (n_entries != N_REGIONS + 1)
+        TEST_VERDICT("Unexpected number of instances in the subtree");
+    if (strcmp(entries[0].oid, SUBTREE_ROOT) != 0 ||
+        entries[0].type != CVT_NONE)
+        TEST_VERDICT("The subtree root is not the first instance");
+    free(entries);
+    entries = NULL;
+
+    TEST_STEP("Read instances matching a pattern and compare them with "
+              "ones read one by one.");
+    CHECK_RC(cfg_get_subtree_fmt(FALSE, &n_entries, &entries,
+                                 "%s/region:*", SUBTREE_ROOT));
+    CHECK_RC(cfg_find_pattern_fmt(&n_handles, &handles,
+                                  "%s/region:*", SUBTREE_ROOT));
+    if (n_entries != n_handles)
+        TEST_VERDICT("Numbers of instances read in bulk and found by "
+                     "pattern differ");
+
+    for (i = 0; i < n_entries; i++)
+    {
+        cfg_val_type    type = CVT_STRING;
+        char           *oid;
+        char           *val;
+
+        if (entries[i].handle != handles[i])
+            TEST_VERDICT("Handles of instances differ");
+
+        CHECK_RC(cfg_get_oid_str(handles[i], &oid));
+        CHECK_RC(cfg_get_instance(handles[i], &type, &val));
+        if (strcmp(entries[i].oid, oid) != 0 ||
+            entries[i].type != CVT_STRING ||
+            strcmp(entries[i].val.val_str, val) != 0)
+        {
+            ERROR("Bulk read %s = '%s', single read %s = '%s'",
+                  entries[i].oid, entries[i].val.val_str, oid, val);
+            TEST_VERDICT("Instances read in bulk and one by one differ");
+        }
+        free(oid);
+        free(val);
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+    free(entries);
+    free(handles);
+    CLEANUP_CHECK_RC(cfg_del_instance_fmt(TRUE, SUBTREE_ROOT));
+
+    TEST_END;
+}
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Logger message rate benchmark
+ *
+ * Measure how fast Logger accepts messages from a test.
+ */
+
+/** @page perf_log_rate Logger message rate
+ *
+ * @objective Measure the rate at which Logger accepts log messages
+ *
+ * @param n_messages    Number of messages to log
+ * @param msg_len       Length of the message text
+ *
+ * Messages are sent to Logger over IPC synchronously, so once
+ * the socket buffer is full the test is throttled by Logger and
+ * the measured rate is the rate at which Logger processes messages
+ * and stores them in the raw log.
+ *
+ * @par Test sequence:
+ */
+
+/** Logging subsystem entity name */
+#define TE_TEST_NAME    "perf/log_rate"
+
+#include "te_config.h"
+
+#include "tapi_test.h"
+#include "te_mi_log.h"
+#include "te_stopwatch.h"
+#include "tapi_mem.h"
+
+int
+main(int argc, char **argv)
+{
+    unsigned int    n_messages;
+    unsigned int    msg_len;
+    char           *text = NULL;
+    te_stopwatch_t  stopwatch = TE_STOPWATCH_INIT;
+    struct timeval  lap;
+    double          duration;
+    te_mi_logger   *logger;
+    unsigned int    i;
+
+    TEST_START;
+    TEST_GET_UINT_PARAM(n_messages);
+    TEST_GET_UINT_PARAM(msg_len);
+
+    TEST_STEP("Prepare the message text.");
+    text = tapi_calloc(msg_len + 1, 1);
+    memset(text, 'x', msg_len);
+
+    TEST_STEP("Log @p n_messages messages and measure the time.");
+    CHECK_RC(te_stopwatch_start(&stopwatch));
+    for (i = 0; i < n_messages; i++)
+        RING("%u: %s", i, text);
+    CHECK_RC(te_stopwatch_stop(&stopwatch, &lap));
+
+    duration = lap.tv_sec + lap.tv_usec / 1000000.0;
+    if (duration <= 0)
+        TEST_FAIL("Logging took no time, the measurement is meaningless");
+
+    TEST_STEP("Report the message rate as MI measurements.");
+    CHECK_RC(te_mi_logger_meas_create("logger", &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "msg_len", "%u", msg_len);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_FREQ, "message rate",
+                          TE_MI_MEAS_AGGR_MEAN, n_messages / duration,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY,
+                          "time per message", TE_MI_MEAS_AGGR_MEAN,
+                          TE_SEC2US(duration) / n_messages,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_destroy(logger);
+
+    TEST_SUCCESS;
+
+cleanup:
+    free(text);
+
+    TEST_END;
+}
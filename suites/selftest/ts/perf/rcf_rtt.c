@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief RCF round-trip benchmark
+ *
+ * Measure latency and throughput of RCF commands sent to a Test Agent.
+ */
+
+/** @page perf_rcf_rtt RCF round-trip latency and throughput
+ *
+ * @objective Measure how fast configurator and RPC requests are passed
+ *            to a Test Agent and back
+ *
+ * @param ta            Test Agent name
+ * @param n_calls       Number of calls of each kind
+ * @param rpc_payload   Number of bytes passed in each RPC call
+ *
+ * The framing of RCF protocol (text or binary) is selected for each
+ * agent in RCF configuration, so running the test for agents with
+ * different framing compares them. In selftest configuration both
+ * agents use binary framing by default, @c TE_IUT_RCF_FRAMING or
+ * @c TE_TST1_RCF_FRAMING set to @c text switches an agent to text
+ * protocol.
+ *
+ * @par Test sequence:
+ */
+
+/** Logging subsystem entity name */
+#define TE_TEST_NAME    "perf/rcf_rtt"
+
+#include "te_config.h"
+
+#include "tapi_test.h"
+#include "te_mi_log.h"
+#include "te_stopwatch.h"
+#include "tapi_mem.h"
+#include "tapi_rpc_unistd.h"
+#include "tapi_rpc_misc.h"
+#include "conf_api.h"
+
+/**
+ * Report measurements of a series of calls.
+ *
+ * @param ta            Test Agent name
+ * @param what          Kind of calls
+ * @param n_calls       Number of calls
+ * @param bytes         Number of payload bytes per call
+ * @param lap           Time spent on the calls
+ */
+static void
+report(const char *ta, const char *what, unsigned int n_calls,
+       size_t bytes, const struct timeval *lap)
+{
+    double          duration = lap->tv_sec + lap->tv_usec / 1000000.0;
+    te_mi_logger   *logger;
+
+    if (duration <= 0)
+        TEST_FAIL("%s calls took no time, the measurement is meaningless",
+                  what);
+
+    CHECK_RC(te_mi_logger_meas_create("rcf", &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "ta", "%s", ta);
+    te_mi_logger_add_meas_key(logger, NULL, "call", "%s", what);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_RPS, "call rate",
+                          TE_MI_MEAS_AGGR_MEAN, n_calls / duration,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_RTT, "round-trip time",
+                          TE_MI_MEAS_AGGR_MEAN,
+                          TE_SEC2US(duration) / n_calls,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    if (bytes > 0)
+    {
+        te_mi_logger_add_meas_key(logger, NULL, "payload", "%zu", bytes);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_THROUGHPUT,
+                              "payload throughput", TE_MI_MEAS_AGGR_MEAN,
+                              8.0 * bytes * n_calls / duration / 1000000.0,
+                              TE_MI_MEAS_MULTIPLIER_MEGA);
+    }
+    te_mi_logger_destroy(logger);
+}
+
+int
+main(int argc, char **argv)
+{
+    const char     *ta;
+    unsigned int    n_calls;
+    unsigned int    rpc_payload;
+    rcf_rpc_server *pco = NULL;
+    rpc_ptr         rbuf = RPC_NULL;
+    uint8_t        *data = NULL;
+    uint64_t        value;
+    te_stopwatch_t  stopwatch = TE_STOPWATCH_INIT;
+    struct timeval  lap;
+    unsigned int    i;
+
+    TEST_START;
+    TEST_GET_STRING_PARAM(ta);
+    TEST_GET_UINT_PARAM(n_calls);
+    TEST_GET_UINT_PARAM(rpc_payload);
+
+    TEST_STEP("Get configuration value synchronized with @p ta "
+              "@p n_calls times and measure the time.");
+    CHECK_RC(te_stopwatch_start(&stopwatch));
+    for (i = 0; i < n_calls; i++)
+    {
+        CHECK_RC(cfg_get_instance_uint64_sync_fmt(&value,
+                                                  "/agent:%s/log_buffer:"
+                                                  "/max:", ta));
+    }
+    CHECK_RC(te_stopwatch_stop(&stopwatch, &lap));
+    report(ta, "configure get", n_calls, 0, &lap);
+
+    TEST_STEP("Set the same configuration value @p n_calls times "
+              "and measure the time.");
+    CHECK_RC(te_stopwatch_start(&stopwatch));
+    for (i = 0; i < n_calls; i++)
+    {
+        CHECK_RC(cfg_set_instance_fmt(CFG_VAL(UINT64, value),
+                                      "/agent:%s/log_buffer:/max:", ta));
+    }
+    CHECK_RC(te_stopwatch_stop(&stopwatch, &lap));
+    report(ta, "configure set", n_calls, 0, &lap);
+
+    TEST_STEP("Create RPC server on @p ta and allocate a buffer of "
+              "@p rpc_payload bytes in it.");
+    CHECK_RC(rcf_rpc_server_create(ta, "pco_perf", &pco));
+    data = tapi_calloc(rpc_payload, 1);
+    rbuf = rpc_malloc(pco, rpc_payload);
+
+    TEST_STEP("Copy @p rpc_payload bytes to the RPC server @p n_calls "
+              "times and measure the time.");
+    CHECK_RC(te_stopwatch_start(&stopwatch));
+    for (i = 0; i < n_calls; i++)
+        rpc_set_buf(pco, data, rpc_payload, rbuf);
+    CHECK_RC(te_stopwatch_stop(&stopwatch, &lap));
+    report(ta, "rpc", n_calls, rpc_payload, &lap);
+
+    TEST_SUCCESS;
+
+cleanup:
+    if (rbuf != RPC_NULL)
+        rpc_free(pco, rbuf);
+    if (pco != NULL)
+        CLEANUP_CHECK_RC(rcf_rpc_server_destroy(pco));
+    free(data);
+
+    TEST_END;
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Test start overhead benchmark
+ *
+ * Empty test to measure the overhead of running a test iteration.
+ */
+
+/** @page perf_start_overhead Test start overhead
+ *
+ * @objective Measure the time spent by the Tester to run an iteration
+ *            of a test which does nothing
+ *
+ * The test is run many times as usual and by a test server (zygote).
+ * Run the package with @c --tester-zygote and compare the average times
+ * logged by the Tester at the end of testing: per script executed one
+ * by one and per iteration run by test servers. The former includes
+ * the prologue and other tests of the package, so run only this test
+ * to get exact numbers, e.g. with
+ * @c --tester-run=selftest/perf/start_exec and
+ * @c --tester-run=selftest/perf/start_zygote.
+ *
+ * @par Test sequence:
+ */
+
+/** Logging subsystem entity name */
+#define TE_TEST_NAME    "perf/start_overhead"
+
+#include "te_config.h"
+
+#include "tapi_test.h"
+
+int
+main(int argc, char **argv)
+{
+    TEST_START;
+
+    TEST_STEP("Do nothing.");
+
+    TEST_SUCCESS;
+
+cleanup:
+
+    TEST_END;
+}
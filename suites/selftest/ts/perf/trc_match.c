@@ -0,0 +1,239 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief TRC iteration matching benchmark
+ *
+ * Measure how fast test iterations are found in a large TRC database.
+ */
+
+/** @page perf_trc_match TRC iteration matching
+ *
+ * @objective Measure time of matching a test iteration to a large
+ *            synthetic TRC database
+ *
+ * @param n_iters       Number of iterations of the test in TRC database
+ * @param n_lookups     Number of iterations to look up
+ * @param wild_every    Every @p wild_every iteration is a wildcard
+ *                      (@c 0 - no wildcards)
+ *
+ * Iterations are looked up using the index of TRC database and by
+ * matching all iterations of the test (as done when a user matching
+ * function is specified). Both ways must find the same iterations.
+ *
+ * @par Test sequence:
+ */
+
+/** Logging subsystem entity name */
+#define TE_TEST_NAME    "perf/trc_match"
+
+#include "te_config.h"
+
+#include "tapi_test.h"
+#include "te_mi_log.h"
+#include "te_stopwatch.h"
+#include "te_str.h"
+#include "tapi_mem.h"
+#include "te_trc.h"
+#include "trc_db.h"
+
+/** Number of arguments of the synthetic test */
+#define TRC_MATCH_N_ARGS 4
+
+/** Names of arguments of the synthetic test */
+static const char *arg_names[TRC_MATCH_N_ARGS] = {
+    "env", "mtu", "size", "mode"
+};
+
+/** Maximum length of an argument value */
+#define TRC_MATCH_VALUE_LEN 32
+
+/**
+ * Make arguments of the synthetic iteration. Only the @c size argument
+ * is unique, other values repeat as they do in real test suites, and
+ * some values differ from TRC database ones by spaces only.
+ *
+ * @param n             Iteration number
+ * @param in_db         Whether the values are for TRC database
+ * @param values        Location for argument values
+ * @param args          Location for arguments
+ */
+static void
+make_args(unsigned int n, te_bool in_db,
+          char values[TRC_MATCH_N_ARGS][TRC_MATCH_VALUE_LEN],
+          trc_report_argument *args)
+{
+    unsigned int i;
+
+    TE_SPRINTF(values[0], "Env%u", n % 50);
+    TE_SPRINTF(values[1], "%u", 1000 + n % 17);
+    TE_SPRINTF(values[2], "%u", n);
+    TE_SPRINTF(values[3], in_db ? "  mode %u " : "mode %u", n % 7);
+
+    for (i = 0; i < TRC_MATCH_N_ARGS; i++)
+    {
+        args[i].name = (char *)arg_names[i];
+        args[i].value = values[i];
+        args[i].variable = FALSE;
+    }
+}
+
+/** Match iterations as trc_db_walker_step_iter() does without index */
+static int
+match_all(const void *iter, unsigned int n_args, trc_report_argument *args,
+          te_bool filter_mode)
+{
+    UNUSED(filter_mode);
+
+    return test_iter_args_match(&((const trc_test_iter *)iter)->args,
+                                n_args, args, TRUE);
+}
+
+/**
+ * Look up iterations and measure the time.
+ *
+ * @param walker        TRC database walker
+ * @param n_lookups     Number of lookups
+ * @param n_iters       Number of iterations in TRC database
+ * @param match_func    Matching function or @c NULL to use the index
+ * @param found         Location for found iterations
+ * @param lap           Location for the time spent
+ */
+static void
+lookup(te_trc_db_walker *walker, unsigned int n_lookups,
+       unsigned int n_iters, func_args_match_ptr match_func,
+       trc_test_iter **found, struct timeval *lap)
+{
+    te_stopwatch_t      stopwatch = TE_STOPWATCH_INIT;
+    char                values[TRC_MATCH_N_ARGS][TRC_MATCH_VALUE_LEN];
+    trc_report_argument args[TRC_MATCH_N_ARGS];
+    unsigned int        i;
+
+    CHECK_RC(te_stopwatch_start(&stopwatch));
+    for (i = 0; i < n_lookups; i++)
+    {
+        /* Some of iterations are not in the database */
+        make_args((i * 7919) % (n_iters + n_iters / 10 + 1), FALSE,
+                  values, args);
+
+        if (!trc_db_walker_step_test(walker, "test", FALSE))
+            TEST_FAIL("Failed to find the test in TRC database");
+
+        trc_db_walker_step_iter(walker, TRC_MATCH_N_ARGS, args, 0, 0,
+                                match_func);
+        found[i] = trc_db_walker_get_iter(walker);
+
+        trc_db_walker_step_back(walker);
+        trc_db_walker_step_back(walker);
+    }
+    CHECK_RC(te_stopwatch_stop(&stopwatch, lap));
+}
+
+/**
+ * Report measurements of lookups.
+ *
+ * @param what          Way of lookup
+ * @param n_iters       Number of iterations in TRC database
+ * @param n_lookups     Number of lookups
+ * @param lap           Time spent on lookups
+ */
+static void
+report(const char *what, unsigned int n_iters, unsigned int n_lookups,
+       const struct timeval *lap)
+{
+    double          duration = lap->tv_sec + lap->tv_usec / 1000000.0;
+    te_mi_logger   *logger;
+
+    CHECK_RC(te_mi_logger_meas_create("trc", &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "lookup", "%s", what);
+    te_mi_logger_add_meas_key(logger, NULL, "n_iters", "%u", n_iters);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY,
+                          "time per lookup", TE_MI_MEAS_AGGR_MEAN,
+                          TE_SEC2US(duration) / n_lookups,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_destroy(logger);
+}
+
+int
+main(int argc, char **argv)
+{
+    unsigned int        n_iters;
+    unsigned int        n_lookups;
+    unsigned int        wild_every;
+    te_trc_db          *db = NULL;
+    te_trc_db_walker   *walker = NULL;
+    trc_test           *test;
+    trc_test_iter      *iter;
+    trc_test_iter     **found_index = NULL;
+    trc_test_iter     **found_all = NULL;
+    char                values[TRC_MATCH_N_ARGS][TRC_MATCH_VALUE_LEN];
+    trc_report_argument args[TRC_MATCH_N_ARGS];
+    struct timeval      lap_index;
+    struct timeval      lap_all;
+    unsigned int        n_found = 0;
+    unsigned int        i;
+
+    TEST_START;
+    TEST_GET_UINT_PARAM(n_iters);
+    TEST_GET_UINT_PARAM(n_lookups);
+    TEST_GET_UINT_PARAM(wild_every);
+
+    TEST_STEP("Create TRC database with a test having @p n_iters "
+              "iterations.");
+    CHECK_RC(trc_db_init(&db));
+    test = trc_db_new_test(&db->tests, NULL, "test");
+    if (test == NULL)
+        TEST_FAIL("Failed to create a test in TRC database");
+
+    for (i = 0; i < n_iters; i++)
+    {
+        make_args(i, TRUE, values, args);
+        /* Wildcard over all values of 'size' */
+        if (wild_every != 0 && i % wild_every == wild_every - 1)
+            values[2][0] = '\0';
+
+        iter = trc_db_new_test_iter(test, TRC_MATCH_N_ARGS, args, NULL);
+        if (iter == NULL)
+            TEST_FAIL("Failed to create a test iteration");
+        iter->exp_default = exp_defaults_get(TE_TEST_PASSED);
+    }
+    CHECK_RC(trc_db_test_iters_index_build(&test->iters));
+
+    walker = trc_db_new_walker(db);
+    if (walker == NULL)
+        TEST_FAIL("Failed to create TRC database walker");
+
+    found_index = tapi_calloc(n_lookups, sizeof(*found_index));
+    found_all = tapi_calloc(n_lookups, sizeof(*found_all));
+
+    TEST_STEP("Look up @p n_lookups iterations using the index.");
+    lookup(walker, n_lookups, n_iters, NULL, found_index, &lap_index);
+
+    TEST_STEP("Look up the same iterations matching all iterations "
+              "of the test.");
+    lookup(walker, n_lookups, n_iters, match_all, found_all, &lap_all);
+
+    TEST_STEP("Check that the same iterations are found.");
+    for (i = 0; i < n_lookups; i++)
+    {
+        if (found_index[i] != found_all[i])
+            TEST_VERDICT("Different iterations are found using the index");
+        if (found_index[i] != NULL)
+            n_found++;
+    }
+    RING("%u of %u iterations are found in TRC database",
+         n_found, n_lookups);
+
+    TEST_STEP("Report the time of lookups as MI measurements.");
+    report("index", n_iters, n_lookups, &lap_index);
+    report("all", n_iters, n_lookups, &lap_all);
+
+    TEST_SUCCESS;
+
+cleanup:
+    free(found_index);
+    free(found_all);
+    trc_db_free_walker(walker);
+    trc_db_close(db);
+
+    TEST_END;
+}
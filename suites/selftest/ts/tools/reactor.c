@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Test for te_reactor.h functions
+ *
+ * Testing event loop
+ */
+
+/** @page tools_reactor te_reactor.h test
+ *
+ * @objective Testing event loop
+ *
+ * Check that the event loop dispatches readiness of descriptors
+ * for reading and writing and expiration of timers.
+ *
+ * @par Test sequence:
+ */
+
+/** Logging subsystem entity name */
+#define TE_TEST_NAME    "tools/reactor"
+
+#include "te_config.h"
+
+#include <unistd.h>
+
+#include "tapi_test.h"
+#include "te_reactor.h"
+#include "te_stopwatch.h"
+
+/** Timeout of the first timer in milliseconds */
+#define FIRST_TIMEOUT   300
+/** Timeout of the second timer in milliseconds */
+#define SECOND_TIMEOUT  600
+
+/** Number of readiness callback invocations */
+static unsigned int n_read = 0;
+
+/** Readiness callback which deletes its watch */
+static void
+read_once(int fd, void *opaque)
+{
+    te_reactor **reactor = opaque;
+    char         c;
+
+    if (read(fd, &c, 1) != 1)
+        TEST_FAIL("Failed to read from a ready pipe");
+    n_read++;
+
+    te_reactor_del_fd(reactor[0], (te_reactor_fd *)reactor[1]);
+}
+
+/** Number of writability callback invocations */
+static unsigned int n_write = 0;
+
+/** Writability callback which deletes its watch */
+static void
+write_once(int fd, void *opaque)
+{
+    te_reactor **reactor = opaque;
+
+    UNUSED(fd);
+
+    n_write++;
+
+    te_reactor_del_fd(reactor[0], (te_reactor_fd *)reactor[1]);
+}
+
+/** Timer callback which stops the other timer */
+static void
+timer_fired(te_reactor_timer *timer, void *opaque)
+{
+    te_reactor_timer *other = opaque;
+
+    UNUSED(timer);
+
+    if (other != NULL)
+        te_reactor_timer_stop(other);
+}
+
+int
+main(int argc, char **argv)
+{
+    te_reactor         *reactor = NULL;
+    te_reactor_fd      *watch = NULL;
+    void               *ctx[2];
+    int                 fds[2] = { -1, -1 };
+    te_reactor_timer    first;
+    te_reactor_timer    second;
+    te_reactor_timer    third;
+    te_stopwatch_t      stopwatch = TE_STOPWATCH_INIT;
+    struct timeval      lap;
+    unsigned int        elapsed;
+
+    TEST_START;
+
+    TEST_STEP("Create an event loop and watch a pipe.");
+    CHECK_RC(te_reactor_create(&reactor));
+    if (pipe(fds) != 0)
+        TEST_FAIL("pipe() failed: %r", TE_OS_RC(TE_TAPI, errno));
+    ctx[0] = reactor;
+    CHECK_RC(te_reactor_add_fd(reactor, fds[0], read_once, ctx, &watch));
+    ctx[1] = watch;
+
+    TEST_STEP("Write two bytes to the pipe and check that the callback "
+              "deleting its watch is invoked only once.");
+    if (write(fds[1], "ab", 2) != 2)
+        TEST_FAIL("write() failed: %r", TE_OS_RC(TE_TAPI, errno));
+    CHECK_RC(te_reactor_run(reactor, 1000));
+    CHECK_RC(te_reactor_run(reactor, 100));
+    if (n_read != 1)
+        TEST_VERDICT("Readiness callback is invoked %u times", n_read);
+
+    TEST_STEP("Watch the write end of the pipe for writability and check "
+              "that the callback deleting its watch is invoked only once.");
+    CHECK_RC(te_reactor_add_fd_out(reactor, fds[1], write_once, ctx, &watch));
+    ctx[1] = watch;
+    CHECK_RC(te_reactor_run(reactor, 1000));
+    CHECK_RC(te_reactor_run(reactor, 100));
+    if (n_write != 1)
+        TEST_VERDICT("Writability callback is invoked %u times", n_write);
+
+    TEST_STEP("Start two timers, the first one stops the second one "
+              "when it expires, start the third timer and stop it "
+              "at once.");
+    te_reactor_timer_init(&second, timer_fired, NULL);
+    te_reactor_timer_init(&first, timer_fired, &second);
+    te_reactor_timer_init(&third, timer_fired, NULL);
+    CHECK_RC(te_stopwatch_start(&stopwatch));
+    te_reactor_timer_start(reactor, &first, FIRST_TIMEOUT);
+    te_reactor_timer_start(reactor, &second, SECOND_TIMEOUT);
+    te_reactor_timer_start(reactor, &third, FIRST_TIMEOUT / 2);
+    te_reactor_timer_stop(&third);
+
+    TEST_STEP("Run the event loop until the first timer expires and "
+              "check that it is not fired too early or too late.");
+    while (te_reactor_timer_is_armed(&first))
+        CHECK_RC(te_reactor_run(reactor, -1));
+    CHECK_RC(te_stopwatch_stop(&stopwatch, &lap));
+    elapsed = TE_SEC2MS(lap.tv_sec) + lap.tv_usec / 1000;
+    RING("The first timer is fired in %u ms", elapsed);
+    if (elapsed < FIRST_TIMEOUT)
+        TEST_VERDICT("Timer is fired earlier than requested");
+    if (elapsed > FIRST_TIMEOUT + 2 * TE_REACTOR_TICK)
+        TEST_VERDICT("Timer is fired too late");
+
+    TEST_STEP("Check that other timers are stopped.");
+    if (te_reactor_timer_is_armed(&second))
+        TEST_VERDICT("Timer stopped by a callback is still running");
+    if (te_reactor_timer_is_armed(&third))
+        TEST_VERDICT("Stopped timer is still running");
+
+    TEST_SUCCESS;
+
+cleanup:
+    te_reactor_destroy(reactor);
+    if (fds[0] >= 0)
+        close(fds[0]);
+    if (fds[1] >= 0)
+        close(fds[1]);
+
+    TEST_END;
+}
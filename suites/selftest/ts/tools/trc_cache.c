@@ -0,0 +1,381 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* Copyright (C) 2023 OKTET Labs Ltd. All rights reserved. */
+/** @file
+ * @brief Test for the compiled TRC database
+ *
+ * Testing that TRC database loaded from the cache is the same as parsed
+ * from XML files.
+ */
+
+/** @page tools_trc_cache Compiled TRC database test
+ *
+ * @objective Check that TRC database loaded from the compiled database
+ *            is the same as parsed from XML files and that changes of
+ *            included files are not missed.
+ *
+ * @par Test sequence:
+ */
+
+/** Logging subsystem entity name */
+#define TE_TEST_NAME    "tools/trc_cache"
+
+#include "te_config.h"
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "tapi_test.h"
+#include "te_str.h"
+#include "te_string.h"
+#include "te_file.h"
+#include "te_trc.h"
+#include "trc_db.h"
+
+/** Top level file of TRC database */
+static const char *trc_db_xml =
+    "<?xml version=\"1.0\"?>\n"
+    "<trc_db version=\"1.0\">\n"
+    "  <test name=\"pkg\" type=\"package\">\n"
+    "    <objective>Package</objective>\n"
+    "    <notes/>\n"
+    "    <iter result=\"PASSED\">\n"
+    "      <notes/>\n"
+    "      <xi:include xmlns:xi=\"http://www.w3.org/2003/XInclude\"\n"
+    "                  href=\"pkg/test.trc.xml\" parse=\"xml\"/>\n"
+    "      <xi:include xmlns:xi=\"http://www.w3.org/2003/XInclude\"\n"
+    "                  href=\"pkg/session.trc.xml\" parse=\"xml\"/>\n"
+    "    </iter>\n"
+    "  </test>\n"
+    "</trc_db>\n";
+
+/** File of a session including another file */
+static const char *trc_session_xml =
+    "<?xml version=\"1.0\"?>\n"
+    "<test name=\"session\" type=\"session\">\n"
+    "  <objective>Session</objective>\n"
+    "  <notes/>\n"
+    "  <iter result=\"PASSED\">\n"
+    "    <notes/>\n"
+    "    <xi:include xmlns:xi=\"http://www.w3.org/2003/XInclude\"\n"
+    "                href=\"test.trc.xml\" parse=\"xml\"/>\n"
+    "  </iter>\n"
+    "</test>\n";
+
+/**
+ * File of a test, it is included twice. The result of the first
+ * iteration is substituted.
+ */
+static const char *trc_test_xml_fmt =
+    "<?xml version=\"1.0\"?>\n"
+    "<test name=\"test\" type=\"script\">\n"
+    "  <objective>Test</objective>\n"
+    "  <notes>Test notes</notes>\n"
+    "  <iter result=\"%s\">\n"
+    "    <arg name=\"a\">1</arg>\n"
+    "    <arg name=\"b\">x</arg>\n"
+    "    <notes>First</notes>\n"
+    "    <results tags=\"linux\" key=\"BUG1\" notes=\"Known\">\n"
+    "      <result value=\"FAILED\">\n"
+    "        <verdict>Verdict 1</verdict>\n"
+    "        <verdict>Verdict 2</verdict>\n"
+    "      </result>\n"
+    "      <result key=\"BUG2\" notes=\"Also\" value=\"SKIPPED\"/>\n"
+    "    </results>\n"
+    "  </iter>\n"
+    "  <iter result=\"FAILED\">\n"
+    "    <arg name=\"a\"/>\n"
+    "    <arg name=\"b\">y</arg>\n"
+    "    <notes/>\n"
+    "  </iter>\n"
+    "</test>\n";
+
+/**
+ * Write a file of TRC database. Its modification time is moved to
+ * the past, since the database is not compiled if its files may be
+ * modified after parsing is started.
+ *
+ * @param dir           Directory of TRC database
+ * @param name          File name
+ * @param contents      File contents
+ */
+static void
+write_file(const char *dir, const char *name, const char *contents)
+{
+    struct timeval  times[2];
+    char           *path;
+    FILE           *f;
+
+    path = te_string_fmt("%s/%s", dir, name);
+    f = fopen(path, "w");
+    if (f == NULL)
+        TEST_FAIL("Cannot create '%s': %s", path, strerror(errno));
+    if (fputs(contents, f) == EOF)
+        TEST_FAIL("Cannot write '%s'", path);
+    if (fclose(f) != 0)
+        TEST_FAIL("Cannot close '%s': %s", path, strerror(errno));
+
+    CHECK_RC(gettimeofday(&times[0], NULL));
+    times[0].tv_sec -= 60;
+    times[1] = times[0];
+    CHECK_RC(utimes(path, times));
+
+    free(path);
+}
+
+/**
+ * Write the file of the test.
+ *
+ * @param dir           Directory of TRC database
+ * @param result        Expected result of the first iteration
+ */
+static void
+write_test_file(const char *dir, const char *result)
+{
+    char *contents = te_string_fmt(trc_test_xml_fmt, result);
+
+    write_file(dir, "pkg/test.trc.xml", contents);
+    free(contents);
+}
+
+/**
+ * Append the expected result to the dump.
+ *
+ * @param result        Expected result
+ * @param dump          Dump of TRC database
+ */
+static void
+dump_exp_result(const trc_exp_result *result, te_string *dump)
+{
+    const trc_exp_result_entry *entry;
+    const te_test_verdict      *verdict;
+
+    te_string_append(dump, "results tags=%s key=%s notes=%s\n",
+                     te_str_empty_if_null(result->tags_str),
+                     te_str_empty_if_null(result->key),
+                     te_str_empty_if_null(result->notes));
+
+    TAILQ_FOREACH(entry, &result->results, links)
+    {
+        te_string_append(dump, "result %s key=%s notes=%s\n",
+                         te_test_status_to_str(entry->result.status),
+                         te_str_empty_if_null(entry->key),
+                         te_str_empty_if_null(entry->notes));
+        TAILQ_FOREACH(verdict, &entry->result.verdicts, links)
+            te_string_append(dump, "verdict %s\n", verdict->str);
+    }
+}
+
+/**
+ * Walk TRC database and dump tests, iterations and results expected
+ * with given tags.
+ *
+ * @param db            TRC database
+ * @param tags          Tags to get expected results
+ * @param dump          Location for the dump
+ */
+static void
+dump_db(te_trc_db *db, const tqh_strings *tags, te_string *dump)
+{
+    te_trc_db_walker       *walker;
+    trc_db_walker_motion    mv;
+    const trc_test         *test;
+    const trc_test_iter    *iter;
+    const trc_test_iter_arg *arg;
+    const trc_exp_result   *result;
+
+    walker = trc_db_new_walker(db);
+    if (walker == NULL)
+        TEST_FAIL("Failed to create TRC database walker");
+
+    while ((mv = trc_db_walker_move(walker)) != TRC_DB_WALKER_ROOT)
+    {
+        if (mv == TRC_DB_WALKER_FATHER)
+        {
+            te_string_append(dump, "end\n");
+            continue;
+        }
+
+        if (!trc_db_walker_is_iter(walker))
+        {
+            test = trc_db_walker_get_test(walker);
+            te_string_append(dump, "test %s type=%d aux=%d file=%s:%d\n"
+                             "objective %s\nnotes %s\n",
+                             test->name, test->type, test->aux,
+                             te_str_empty_if_null(test->filename),
+                             test->file_pos,
+                             te_str_empty_if_null(test->objective),
+                             te_str_empty_if_null(test->notes));
+            continue;
+        }
+
+        iter = trc_db_walker_get_iter(walker);
+        te_string_append(dump, "iter file=%s:%d notes %s\n",
+                         te_str_empty_if_null(iter->filename),
+                         iter->file_pos,
+                         te_str_empty_if_null(iter->notes));
+        TAILQ_FOREACH(arg, &iter->args.head, links)
+            te_string_append(dump, "arg %s=%s\n", arg->name, arg->value);
+
+        if (iter->exp_default != NULL)
+        {
+            te_string_append(dump, "default ");
+            dump_exp_result(iter->exp_default, dump);
+        }
+        STAILQ_FOREACH(result, &iter->exp_results, links)
+            dump_exp_result(result, dump);
+
+        result = trc_db_walker_get_exp_result(walker, tags);
+        if (result != NULL)
+        {
+            te_string_append(dump, "expected ");
+            dump_exp_result(result, dump);
+        }
+    }
+
+    trc_db_free_walker(walker);
+}
+
+/**
+ * Open TRC database and dump it.
+ *
+ * @param location      Location of TRC database
+ * @param flags         Flags of opening
+ * @param tags          Tags to get expected results
+ * @param dump          Location for the dump
+ *
+ * @return @c TRUE if the database is loaded from the compiled one.
+ */
+static te_bool
+open_and_dump(const char *location, int flags, const tqh_strings *tags,
+              te_string *dump)
+{
+    te_trc_db  *db = NULL;
+    te_bool     cached;
+
+    CHECK_RC(trc_db_open_ext(location, &db, flags));
+    cached = (db->cache != NULL);
+
+    te_string_reset(dump);
+    dump_db(db, tags, dump);
+    trc_db_close(db);
+
+    return cached;
+}
+
+/** Remove a file found in the directory */
+static te_errno
+remove_file(const char *pattern, const char *pathname, void *data)
+{
+    UNUSED(pattern);
+    UNUSED(data);
+
+    if (unlink(pathname) == 0)
+        return 0;
+
+    return TE_OS_RC(TE_MODULE_NONE, errno);
+}
+
+/**
+ * Check that dumps of TRC database are the same.
+ *
+ * @param xml           Dump of the database parsed from XML
+ * @param cached        Dump of the database loaded from the cache
+ */
+static void
+check_dumps(const te_string *xml, const te_string *cached)
+{
+    if (strcmp(xml->ptr, cached->ptr) != 0)
+    {
+        ERROR("TRC database parsed from XML:\n%s", xml->ptr);
+        ERROR("TRC database loaded from the cache:\n%s", cached->ptr);
+        TEST_VERDICT("Compiled TRC database differs from XML one");
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    char            tmpdir[] = "/tmp/te_trc_cache_XXXXXX";
+    char           *pkg_dir = NULL;
+    char           *cache_dir = NULL;
+    char           *location = NULL;
+    tqh_strings     tags;
+    te_string       xml = TE_STRING_INIT;
+    te_string       cached = TE_STRING_INIT;
+
+    TAILQ_INIT(&tags);
+
+    TEST_START;
+
+    TEST_STEP("Create TRC database with nested XInclude of files "
+              "and use a temporary cache directory.");
+    CHECK_NOT_NULL(mkdtemp(tmpdir));
+    location = te_string_fmt("%s/db.xml", tmpdir);
+    pkg_dir = te_string_fmt("%s/pkg", tmpdir);
+    cache_dir = te_string_fmt("%s/cache", tmpdir);
+    CHECK_RC(mkdir(pkg_dir, 0755));
+    write_file(tmpdir, "db.xml", trc_db_xml);
+    write_file(tmpdir, "pkg/session.trc.xml", trc_session_xml);
+    write_test_file(tmpdir, "PASSED");
+
+    CHECK_RC(setenv(TRC_DB_CACHE_DIR_ENV, cache_dir, 1));
+    CHECK_RC(trc_add_tag(&tags, "linux"));
+
+    TEST_STEP("Parse TRC database from XML without the cache.");
+    if (open_and_dump(location, 0, &tags, &xml))
+        TEST_VERDICT("TRC database is loaded from the cache without "
+                     "request");
+
+    TEST_STEP("Parse TRC database from XML and compile it.");
+    if (open_and_dump(location, TRC_OPEN_CACHE, &tags, &cached))
+        TEST_VERDICT("TRC database is loaded from the empty cache");
+    check_dumps(&xml, &cached);
+
+    TEST_STEP("Load TRC database from the cache and check that it is "
+              "the same as parsed from XML.");
+    if (!open_and_dump(location, TRC_OPEN_CACHE, &tags, &cached))
+        TEST_VERDICT("TRC database is not loaded from the cache");
+    check_dumps(&xml, &cached);
+
+    TEST_STEP("Change the included file and check that the compiled "
+              "database is out of date.");
+    write_test_file(tmpdir, "FAKED");
+    open_and_dump(location, 0, &tags, &xml);
+    if (strstr(xml.ptr, "result FAKED") == NULL)
+        TEST_FAIL("Changed result is not found in TRC database");
+
+    if (open_and_dump(location, TRC_OPEN_CACHE, &tags, &cached))
+        TEST_VERDICT("Out of date TRC database is loaded from the cache");
+    check_dumps(&xml, &cached);
+
+    TEST_STEP("Check that the changed database is compiled again.");
+    if (!open_and_dump(location, TRC_OPEN_CACHE, &tags, &cached))
+        TEST_VERDICT("Changed TRC database is not loaded from the cache");
+    check_dumps(&xml, &cached);
+
+    TEST_SUCCESS;
+
+cleanup:
+    if (location != NULL)
+    {
+        if (access(cache_dir, F_OK) == 0)
+        {
+            CLEANUP_CHECK_RC(te_file_scandir(cache_dir, remove_file,
+                                             NULL, NULL));
+            CLEANUP_CHECK_RC(rmdir(cache_dir));
+        }
+        CLEANUP_CHECK_RC(te_file_scandir(pkg_dir, remove_file, NULL, NULL));
+        CLEANUP_CHECK_RC(rmdir(pkg_dir));
+        CLEANUP_CHECK_RC(te_file_scandir(tmpdir, remove_file, NULL, NULL));
+        CLEANUP_CHECK_RC(rmdir(tmpdir));
+    }
+    tq_strings_free(&tags, free);
+    te_string_free(&xml);
+    te_string_free(&cached);
+    free(location);
+    free(pkg_dir);
+    free(cache_dir);
+
+    TEST_END;
+}
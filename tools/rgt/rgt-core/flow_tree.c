@@ -162,6 +162,10 @@ typedef struct node_t {
                                 more branches. It is set to false just
                                 after first close event for any children
                                 node arrives. */
+    int parallel;          /**< Children of the node may be run in
+                                parallel at any time, so the node may
+                                append more branches while all existing
+                                ones are active */
     branch_info *branches; /**< Array of branches */
 
     void *user_data;  /**< User-specific data associated with a node */
@@ -180,6 +184,7 @@ static uint32_t max_timestamp[2]  = {UINT32_MAX, UINT32_MAX};
         (node_ptr)->n_active_branches = 0;          \
         (node_ptr)->n_branches = 0;                 \
         (node_ptr)->more_branches = TRUE;           \
+        (node_ptr)->parallel = FALSE;               \
         (node_ptr)->branches = NULL;                \
     } while (0)
 
@@ -375,6 +380,8 @@ flow_tree_destroy(void)
  * @param  new_node_type  Type of the node to be created
  * @param  node_name      Name of the node
  * @param  timestamp      Timestamp
+ * @param  parallel       Whether children of the node may be run in
+ *                        parallel at any time
  * @param  user_data      User-specific data
  * @param  err_code       If an error occures in the function, it sets
  *                        *err_code into the code of the error.
@@ -389,11 +396,12 @@ void *
 flow_tree_add_node(node_id_t parent_id, node_id_t node_id,
                    node_type_t new_node_type,
                    char *node_name, uint32_t *timestamp,
-                   void *user_data, int *err_code)
+                   int parallel, void *user_data, int *err_code)
 {
     node_t **p_par_node;
     node_t  *par_node;
     node_t  *cur_node;
+    int      i = 0;
 
     /* Find parent node */
     if ((p_par_node = (node_t **)
@@ -422,6 +430,7 @@ flow_tree_add_node(node_id_t parent_id, node_id_t node_id,
     cur_node->fmode = par_node->fmode;
 
     FILL_BRANCH_INFO(cur_node);
+    cur_node->parallel = parallel;
 
     /* Form node name */
     if (node_name == NULL)
@@ -459,7 +468,22 @@ flow_tree_add_node(node_id_t parent_id, node_id_t node_id,
     cur_node->self = cur_node;
     cur_node->next = NULL;
 
-    if (par_node->more_branches == TRUE)
+    if (par_node->more_branches == FALSE && par_node->parallel)
+    {
+        /*
+         * Continue a branch which has no running node. If all branches
+         * are busy, the node is run in parallel with them (e.g. the
+         * Tester runs some iterations simultaneously), so a new branch
+         * is added.
+         */
+        for (i = 0; i < par_node->n_branches; i++)
+        {
+            if (par_node->branches[i].status == BSTATUS_IDLE)
+                break;
+        }
+    }
+
+    if (par_node->more_branches == TRUE || i == par_node->n_branches)
     {
         branch_info *old_ptr = par_node->branches;
 
@@ -500,21 +524,21 @@ flow_tree_add_node(node_id_t parent_id, node_id_t node_id,
         g_hash_table_remove(close_set, &par_node->id);
         g_hash_table_insert(close_set, &cur_node->id, &cur_node->self);
     }
-    else if (par_node->n_branches == 1)
+    else if (par_node->parallel || par_node->n_branches == 1)
     {
 #ifdef FLOW_TREE_LIBRARY_DEBUG
-        assert(par_node->n_active_branches == 0);
+        assert(par_node->parallel || par_node->n_active_branches == 0);
 #endif
 
         par_node->n_active_branches++;
-        cur_node->prev = par_node->branches[0].last_el;
+        cur_node->prev = par_node->branches[i].last_el;
 
         cur_node->prev->next = cur_node;
 
         /* Common part */
-        par_node->branches[0].last_el = cur_node;
-        par_node->branches[0].status = BSTATUS_ACTIVE;
-        par_node->branches[par_node->n_branches - 1].end_ts = max_timestamp;
+        par_node->branches[i].last_el = cur_node;
+        par_node->branches[i].status = BSTATUS_ACTIVE;
+        par_node->branches[i].end_ts = max_timestamp;
         if (new_node_type != NT_TEST)
         {
             g_hash_table_insert(new_set, &cur_node->id, &cur_node->self);
@@ -524,9 +548,10 @@ flow_tree_add_node(node_id_t parent_id, node_id_t node_id,
 
         /*
          * more_branches equals to false, so we have to remove
-         * session from new set.
+         * session from new set unless its children are run in parallel.
          */
-        g_hash_table_remove(new_set, &par_node->id);
+        if (!par_node->parallel)
+            g_hash_table_remove(new_set, &par_node->id);
     }
     else
     {
@@ -603,14 +628,17 @@ flow_tree_close_node(node_id_t parent_id, node_id_t node_id,
 
     /*
      * This operation actually deletes node only once, a first child
-     * is going to be closed
+     * is going to be closed. A node with children run in parallel
+     * still accepts new children: they continue idle branches or are
+     * run in parallel with active ones.
      */
-    g_hash_table_remove(new_set, &par_node->id);
+    if (!par_node->parallel)
+        g_hash_table_remove(new_set, &par_node->id);
 
     if (par_node->n_active_branches == 0)
     {
         g_hash_table_insert(close_set, &par_node->id, &par_node->self);
-        if (par_node->n_branches == 1)
+        if (par_node->n_branches == 1 && !par_node->parallel)
         {
             g_hash_table_insert(new_set, &par_node->id, &par_node->self);
         }
@@ -57,7 +57,8 @@ extern void flow_tree_destroy(void);
 extern void *flow_tree_add_node(node_id_t parent_id, node_id_t node_id,
                                 node_type_t new_node_type,
                                 char *node_name, uint32_t *timestamp,
-                                void *user_data, int *err_code);
+                                int parallel, void *user_data,
+                                int *err_code);
 
 /**
  * Try to close the node in execution flow tree.
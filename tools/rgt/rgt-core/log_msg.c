@@ -194,7 +194,8 @@ rgt_process_tester_control_message_json(log_msg *msg)
 
         if (flow_tree_add_node(node->parent_id, node->node_id, node->type,
                                node->descr.name, node->start_ts,
-                               node, &err_code) == NULL)
+                               node->descr.parallel, node,
+                               &err_code) == NULL)
         {
             free_node_info(node);
             free_log_msg(msg);
@@ -378,7 +379,7 @@ rgt_process_tester_control_message_text(log_msg *msg)
 
         if (flow_tree_add_node(parent_id, node_id, node_type,
                                node->descr.name, node->start_ts,
-                               node, &err_code) == NULL)
+                               FALSE, node, &err_code) == NULL)
         {
             free_node_info(node);
             free_log_msg(msg);
@@ -732,6 +733,7 @@ create_node_by_msg_json(json_t *msg, uint32_t *ts)
     json_t     *hash_opt = NULL;
     json_t     *tin_opt = NULL;
     json_t     *ignored = NULL;
+    int         parallel = FALSE;
     const char *type = NULL;
     const char *name = NULL;
     const char *objective = NULL;
@@ -757,7 +759,8 @@ create_node_by_msg_json(json_t *msg, uint32_t *ts)
      * values and type-checked manually.
      */
     ret = json_unpack_ex(msg, &err, JSON_STRICT,
-                         "{s:i, s:i, s:s, s?o, s?o, s?o, s?o, s?o, s?o, s?o, s?o}",
+                         "{s:i, s:i, s:s, s?o, s?o, s?o, s?o, s?o, s?o, s?o, s?o, "
+                         "s?b}",
                          "id", &node->node_id,
                          "parent", &node->parent_id,
                          "node_type", &type,
@@ -768,7 +771,8 @@ create_node_by_msg_json(json_t *msg, uint32_t *ts)
                          "tin", &tin_opt,
                          "authors", &authors,
                          "params", &params,
-                         "plan_id", &ignored);
+                         "plan_id", &ignored,
+                         "parallel", &parallel);
     if (ret != 0)
     {
         FMT_TRACE("Error unpacking JSON log message: %s (line %d, column %d)",
@@ -852,6 +856,7 @@ create_node_by_msg_json(json_t *msg, uint32_t *ts)
             node_info_obstack_copy0(objective, strlen(objective));
 
     node->descr.tin = tin;
+    node->descr.parallel = parallel;
 
     if (page != NULL)
         node->descr.page = node_info_obstack_copy0(page, strlen(page));
@@ -158,6 +158,8 @@ typedef struct node_descr {
     char           *authors;    /**< Entry authors */
     char           *hash;       /**< Parameters hash */
     int             n_branches; /**< Number of branches in the entry */
+    int             parallel;   /**< Children of the entry may be run
+                                     in parallel */
 } node_descr_t;
 
 typedef struct node_info {
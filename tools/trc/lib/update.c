@@ -2323,6 +2323,7 @@ simplify_log_exprs(trc_exp_results *results,
 
                 trc_db_set_user_data(iter, TRUE, 0, iter_data);
                 TAILQ_INSERT_TAIL(&test->iters.head, iter, links);
+                trc_db_test_iters_index_free(&test->iters);
             }
 
             logic_expr_free(array[i]);
@@ -4542,6 +4543,7 @@ trc_update_generate_test_wilds(unsigned int db_uid,
     }
 
     /* Delete original iterations - they will be replaced by wildcards */
+    trc_db_test_iters_index_free(&test->iters);
     iter = TAILQ_FIRST(&test->iters.head);
 
     if (iter != NULL && save_wildcards == NULL)
@@ -5103,6 +5105,7 @@ trc_update_gen_test_wilds_fss(unsigned int db_uid,
     }
 
     /* Delete original iterations - they will be replaced by wildcards */
+    trc_db_test_iters_index_free(&test_entry->test->iters);
     iter = TAILQ_FIRST(&test_entry->test->iters.head);
     if (iter != NULL && wildcards == NULL)
     {
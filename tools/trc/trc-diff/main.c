@@ -708,7 +708,7 @@ main(int argc, char *argv[])
     }
 
     /* Parse expected testing results database */
-    if (trc_db_open(trc_diff_db_fn, &ctx->db) != 0)
+    if (trc_db_open_ext(trc_diff_db_fn, &ctx->db, TRC_OPEN_CACHE) != 0)
     {
         ERROR("Failed to load expected testing results database");
         goto exit;